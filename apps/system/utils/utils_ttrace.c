@@ -43,6 +43,7 @@ static const struct tag_list ttrace_tags[] = {
 	{"lock",    "Lock",          TTRACE_TAG_LOCK},
 	{"task",    "TASK",          TTRACE_TAG_TASK},
 	{"ipc",     "IPC",           TTRACE_TAG_IPC},
+	{"irq",     "IRQ",           TTRACE_TAG_IRQ},
 };
 
 int param = 0;
@@ -52,6 +53,7 @@ int is_overwritable = 0;
 static void show_help(void);
 void wait_ttrace_dump(void);
 
+#ifndef CONFIG_TTRACE_BINARY
 static int print_uid_packet(struct trace_packet *packet)
 {
 	int8_t uid = packet->codelen & ~TTRACE_CODE_UNIQUE;
@@ -101,6 +103,82 @@ static int print_packet(struct trace_packet *packet)
 		return print_message_packet(packet);
 	}
 }
+#else
+static void print_bin_record(struct ttrace_binrec_s *rec)
+{
+	struct ttrace_binsched_s *sched = (struct ttrace_binsched_s *)(rec + 1);
+	char *name = (char *)(rec + 1);
+
+	printf("[%06u:%06u] %03d: ", rec->ts / USEC_PER_SEC, rec->ts % USEC_PER_SEC, rec->pid);
+	switch (rec->type) {
+	case TTRACE_BIN_BEGIN:
+		printf("b|%s\r\n", name);
+		break;
+	case TTRACE_BIN_BEGIN_UID:
+		printf("b|%u\r\n", rec->arg);
+		break;
+	case TTRACE_BIN_END:
+		printf("e|%u\r\n", rec->arg);
+		break;
+	case TTRACE_BIN_SCHED:
+		printf("s|prev_pid=%u prev_prio=%u prev_state=%u ==> next_pid=%u next_prio=%u\r\n",
+			   rec->arg >> 16, sched->prev_prio, sched->prev_state,
+			   rec->arg & 0xffff, sched->next_prio);
+		break;
+	case TTRACE_BIN_COUNTER:
+		printf("C|%s=%d\r\n", name, (int32_t)rec->arg);
+		break;
+	case TTRACE_BIN_ASYNC_BEGIN:
+		printf("S|%s:%u\r\n", name, rec->arg);
+		break;
+	case TTRACE_BIN_ASYNC_END:
+		printf("F|%s:%u\r\n", name, rec->arg);
+		break;
+	case TTRACE_BIN_IRQ_ENTER:
+		printf("b|irq %u\r\n", rec->arg);
+		break;
+	case TTRACE_BIN_IRQ_EXIT:
+		printf("e|irq %u\r\n", rec->arg);
+		break;
+	case TTRACE_BIN_TASKNAME:
+		printf("n|%s\r\n", name);
+		break;
+	}
+}
+
+/* Prints the valid records of a ring, see os/drivers/ttrace/ttrace_binary.c */
+
+static void print_bin_ring(struct ttrace_binring_s *ring)
+{
+	struct ttrace_binrec_s *rec;
+	uint32_t pos = 0;
+
+	if (ring->magic != TTRACE_BIN_MAGIC) {
+		return;
+	}
+
+	if (ring->pos > ring->nslots) {
+		pos = ring->pos - ring->nslots;
+	}
+
+	while (pos < ring->pos) {
+		rec = (struct ttrace_binrec_s *)&ring->slots[pos % ring->nslots];
+		if (rec->pos != pos || rec->type >= TTRACE_BIN_NTYPES || rec->nslots == 0 || rec->nslots > TTRACE_BIN_MAXSLOTS) {
+			pos++;
+			continue;
+		}
+
+		if (rec->type != TTRACE_BIN_PAD) {
+			print_bin_record(rec);
+		}
+		pos += rec->nslots;
+	}
+
+	if (ring->dropped > 0) {
+		printf("CPU %u: %u records dropped\r\n", ring->cpu, ring->dropped);
+	}
+}
+#endif
 
 static void show_help()
 {
@@ -247,9 +325,16 @@ static int read_tracebuffer(FILE *file, int bufsize)
 		return TTRACE_INVALID;
 	}
 
+#ifdef CONFIG_TTRACE_BINARY
+	while (offset + (int)sizeof(struct ttrace_binring_s) <= read_len) {
+		print_bin_ring((struct ttrace_binring_s *)(buffer + offset));
+		offset += sizeof(struct ttrace_binring_s);
+	}
+#else
 	while (offset < read_len) {
 		offset += print_packet((struct trace_packet *)(buffer + offset));
 	}
+#endif
 
 	free_tracebuffer(buffer);
 	return TTRACE_VALID;
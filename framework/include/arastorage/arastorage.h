@@ -374,6 +374,22 @@ cursor_row_t cursor_get_row(db_cursor_t *cursor);
 */
 cursor_row_t cursor_get_count(db_cursor_t *cursor);
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/**
+* @brief read the rows of cursor from current row at once
+*
+* @details @b #include <arastorage/arastorage.h>\n
+* Up to nrows rows from current row are read from storage into memory of cursor.
+* While moving through these rows, values are returned without reading storage.
+* Values are read automatically in the same way for a row which is not in memory.
+* @param[in] cursor a pointer to cursor
+* @param[in] nrows the number of rows to read
+* @return On success, the number of rows read is returned. On failure, INVALID_CURSOR_VALUE is returned.
+* @since TizenRT v3.1
+*/
+cursor_row_t cursor_fetch_rows(db_cursor_t *cursor, cursor_row_t nrows);
+#endif
+
 /**
 * @brief get type of attribute with specific index in cursor
 *
@@ -25,6 +25,7 @@
 #ifndef __UI_ASSET_H__
 #define __UI_ASSET_H__
 
+#include <tinyara/config.h>
 #include <stdint.h>
 #include <sys/types.h>
 #include <araui/ui_commons.h>
@@ -39,6 +40,21 @@
  */
 typedef long ui_asset_t;
 
+#if defined(CONFIG_UI_GLYPH_CACHE)
+/**
+ * @brief Statistics of the glyph cache, which is shared by all font assets.
+ * @see ui_font_asset_get_glyph_cache_info()
+ */
+typedef struct {
+	uint32_t hit;		//!< Number of glyphs found in the cache
+	uint32_t miss;		//!< Number of glyphs rasterized from the font
+	uint32_t eviction;	//!< Number of glyphs evicted to make room for others
+	uint32_t glyph_num;	//!< Number of glyphs in the cache
+	size_t used;		//!< Memory used by the glyphs in the cache (in bytes)
+	size_t size;		//!< Memory the cache can use (in bytes)
+} ui_glyph_cache_info_t;
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -130,6 +146,17 @@ ui_asset_t ui_font_asset_create_from_buffer(const uint8_t *buf);
  */
 ui_error_t ui_font_asset_destroy(ui_asset_t font);
 
+#if defined(CONFIG_UI_GLYPH_CACHE)
+/**
+ * @brief Get the statistics of the glyph cache.
+ * The hit rate is hit / (hit + miss).
+ * @param[out] info Pointer of the structure to fill
+ * @return On success, UI_OK is returned. On failure, the defined error type is returned.
+ * @see ui_glyph_cache_info_t
+ */
+ui_error_t ui_font_asset_get_glyph_cache_info(ui_glyph_cache_info_t *info);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -104,6 +104,14 @@ public:
 	 * @since TizenRT v2.0
 	 */
 	ssize_t read(unsigned char *buf, size_t size) override;
+	/**
+	 * @brief Move the position where the file is read next
+	 * @details @b #include <media/FileInputDataSource.h>
+	 * @param[in] offset Position in bytes from the start of the file
+	 * @return true on success, false on failure
+	 * @since TizenRT v3.1 PRE
+	 */
+	bool seek(off_t offset) override;
 
 private:
 	std::string mDataPath;
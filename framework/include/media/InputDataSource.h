@@ -30,6 +30,7 @@
 #define __MEDIA_INPUTDATASOURCE_H
 
 #include <memory>
+#include <sys/types.h>
 #include <media/DataSource.h>
 
 namespace media {
@@ -76,6 +77,17 @@ public:
 	 * @since TizenRT v2.0
 	 */
 	virtual ssize_t read(unsigned char *buf, size_t size) = 0;
+
+	/**
+	 * @brief Move the position where the stream data is read next
+	 * @details @b #include <media/InputDataSource.h>
+	 * Data sources which can't change the position (e.g. live streams)
+	 * don't need to override it.
+	 * @param[in] offset Position in bytes from the start of the stream
+	 * @return true on success, false if it's not supported or failed
+	 * @since TizenRT v3.1 PRE
+	 */
+	virtual bool seek(off_t offset);
 };
 
 } // namespace stream
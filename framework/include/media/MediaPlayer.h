@@ -228,6 +228,20 @@ public:
 	 * @since TizenRT v2.1 PRE
 	 */
 	bool isPlaying();
+
+	/**
+	 * @brief Move the playback position to the given time
+	 * @details @b #include <media/MediaPlayer.h>
+	 * This function is a synchronous API
+	 * It's available in ready, playing and paused state, and the state doesn't change.
+	 * Only MPEG-2 TS streams from a seekable data source (e.g. file) are supported.
+	 * Playback restarts from the indexed position nearest before the time,
+	 * or from the position estimated by the stream bitrate.
+	 * @param[in] msec The play time in milliseconds from the start of the stream
+	 * @return The result of the seekTo operation
+	 * @since TizenRT v3.1 PRE
+	 */
+	player_result_t seekTo(unsigned int msec);
 private:
 	std::shared_ptr<MediaPlayerImpl> mPMpImpl;
 	uint64_t mId;
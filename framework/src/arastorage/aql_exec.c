@@ -115,6 +115,16 @@ db_result_t aql_deinit_handle(db_handle_t **handle)
 		free((*handle)->attr_map);
 		(*handle)->attr_map = NULL;
 	}
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	if ((*handle)->rows != NULL) {
+		free((*handle)->rows);
+		(*handle)->rows = NULL;
+	}
+	if ((*handle)->columns != NULL) {
+		free((*handle)->columns);
+		(*handle)->columns = NULL;
+	}
+#endif
 	free(*handle);
 	*handle = NULL;
 	DB_LOG_D("deinit handle!\n");
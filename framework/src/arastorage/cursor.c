@@ -29,6 +29,27 @@
 #include "storage.h"
 #include "relation.h"
 
+/****************************************************************************
+* Private Functions
+****************************************************************************/
+
+/* Search the first set tuple id from tuple_id on, skipping whole words of
+   tuples which are not in the cursor. Returns total_rows if there is none. */
+static tuple_id_t cursor_next_tuple(db_cursor_t *cursor, tuple_id_t tuple_id)
+{
+	while (tuple_id < cursor->total_rows) {
+		if (GET_POS(tuple_id) == 0 && cursor->row_arr[GET_INDEX(tuple_id)] == 0) {
+			tuple_id += sizeof(uint32_t) * 8;
+			continue;
+		}
+		if (BIT_CHECK(cursor->row_arr[GET_INDEX(tuple_id)], GET_POS(tuple_id))) {
+			return tuple_id;
+		}
+		tuple_id++;
+	}
+	return cursor->total_rows;
+}
+
 /****************************************************************************
 * Public Functions
 ****************************************************************************/
@@ -86,10 +107,30 @@ db_result_t cursor_move_last(db_cursor_t *cursor)
 /* Search next set tuple id and update storage id corresponding it. */
 db_result_t cursor_move_next(db_cursor_t *cursor)
 {
+	tuple_id_t tuple_id;
+
 	if (!cursor) {
 		return DB_CURSOR_ERROR;
 	}
 
+	/* Continue the search from the current row rather than the first one,
+	   so that walking through a cursor doesn't take quadratic time. */
+	if (!IS_INVALID_CURSOR_ROW(cursor) && !IS_INVALID_STORAGE_ROW(cursor)) {
+		if (cursor->current_cursor_row + 1 >= cursor->cursor_rows) {
+			DB_LOG_E("invalid row id\n");
+			return DB_CURSOR_ERROR;
+		}
+
+		tuple_id = cursor_next_tuple(cursor, cursor->current_storage_row + 1);
+		if (tuple_id >= cursor->total_rows) {
+			return DB_CURSOR_ERROR;
+		}
+
+		cursor->current_cursor_row++;
+		cursor->current_storage_row = tuple_id;
+		return DB_OK;
+	}
+
 	return cursor_move_to(cursor, cursor->current_cursor_row + 1);
 }
 
@@ -246,9 +287,88 @@ attribute_id_t cursor_get_attr_index(db_cursor_t *cursor, const char *attr_name)
 	return INVALID_CURSOR_VALUE;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/* Read up to nrows rows of the cursor from the current row on into the row
+   cache. Consecutive tuples are read at once, with the storage opened once. */
+cursor_row_t cursor_fetch_rows(db_cursor_t *cursor, cursor_row_t nrows)
+{
+	int fd;
+	ssize_t r;
+	cursor_row_t n;
+	cursor_row_t run;
+	tuple_id_t tuple_id;
+	tuple_id_t next;
+	size_t length;
+	unsigned char *rows;
+
+	if (IS_INVALID_CURSOR_ROW(cursor) || IS_INVALID_STORAGE_ROW(cursor) || nrows == 0) {
+		DB_LOG_E("invalid cursor row id\n");
+		return INVALID_CURSOR_VALUE;
+	}
+
+	if (nrows > cursor->cursor_rows - cursor->current_cursor_row) {
+		nrows = cursor->cursor_rows - cursor->current_cursor_row;
+	}
+
+	length = cursor->storage_row_length;
+	if (nrows > cursor->cache_size) {
+		rows = (unsigned char *)malloc(nrows * length);
+		if (rows == NULL) {
+			DB_LOG_E("failed to allocate row cache\n");
+			return INVALID_CURSOR_VALUE;
+		}
+		if (cursor->rows != NULL) {
+			free(cursor->rows);
+		}
+		cursor->rows = rows;
+		cursor->cache_size = nrows;
+	}
+	cursor->cache_rows = 0;
+
+	fd = storage_open(cursor->name, O_RDONLY);
+	if (fd < 0) {
+		DB_LOG_E("failed to open storage %s\n", cursor->name);
+		return INVALID_CURSOR_VALUE;
+	}
+
+	tuple_id = cursor->current_storage_row;
+	for (n = 0; n < nrows; n += run) {
+		run = 1;
+		next = cursor_next_tuple(cursor, tuple_id + 1);
+		while (n + run < nrows && next == tuple_id + run) {
+			run++;
+			next = cursor_next_tuple(cursor, next + 1);
+		}
+
+		if (storage_seek(fd, tuple_id * length, SEEK_SET) == (off_t)-1) {
+			storage_close(fd);
+			return INVALID_CURSOR_VALUE;
+		}
+		r = storage_read(fd, cursor->rows + n * length, run * length);
+		if (r < 0 || r < run * length) {
+			DB_LOG_E("failed to read %d rows from %s\n", run, cursor->name);
+			storage_close(fd);
+			return INVALID_CURSOR_VALUE;
+		}
+
+		tuple_id = next;
+	}
+	storage_close(fd);
+
+	cursor->cache_first = cursor->current_cursor_row;
+	cursor->cache_rows = nrows;
+
+	DB_LOG_D("fetched %d rows from cursor row %d\n", nrows, cursor->cache_first);
+
+	return nrows;
+}
+#endif
+
 db_result_t cursor_get_value_storage(attribute_value_t *value, db_cursor_t *cursor, unsigned col)
 {
+#ifndef CONFIG_ARASTORAGE_BATCH_SELECT
 	int fd, offset;
+#endif
 	attribute_t attr;
 	unsigned char *buf;
 
@@ -273,6 +393,16 @@ db_result_t cursor_get_value_storage(attribute_value_t *value, db_cursor_t *curs
 		 Because aggregate result is already calculated and stored in buffer. */
 		buf += cursor->attr_map[col].offset;
 	} else {
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+		/* Otherwise, Read tuple value from the row cache, which is filled
+		   with the next rows from storage when the current row isn't in it. */
+		if (cursor->current_cursor_row < cursor->cache_first || cursor->current_cursor_row >= cursor->cache_first + cursor->cache_rows) {
+			if (cursor_fetch_rows(cursor, DB_BATCH_ROWS) == INVALID_CURSOR_VALUE) {
+				return DB_CURSOR_ERROR;
+			}
+		}
+		buf = cursor->rows + (cursor->current_cursor_row - cursor->cache_first) * cursor->storage_row_length + cursor->attr_map[col].offset;
+#else
 		/* Otherwise, Read tuple value from storage. */
 		offset = cursor->current_storage_row * cursor->storage_row_length + cursor->attr_map[col].offset;
 		fd = storage_open(cursor->name, O_RDONLY);
@@ -282,6 +412,7 @@ db_result_t cursor_get_value_storage(attribute_value_t *value, db_cursor_t *curs
 		}
 		storage_read_from(fd, buf, offset, attr.element_size);
 		storage_close(fd);
+#endif
 	}
 
 	return db_phy_to_value(value, &attr, buf);
@@ -411,6 +542,15 @@ void cursor_clean_data(db_cursor_t *cursor)
 		free(cursor->row_arr);
 	}
 	cursor->row_arr = NULL;
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	if (cursor->rows != NULL) {
+		free(cursor->rows);
+	}
+	cursor->rows = NULL;
+	cursor->cache_first = 0;
+	cursor->cache_rows = 0;
+	cursor->cache_size = 0;
+#endif
 }
 
 db_result_t cursor_init(db_cursor_t **cursor, relation_t *rel)
@@ -450,6 +590,12 @@ db_result_t cursor_deinit(db_cursor_t *cursor)
 		free(cursor->row_arr);
 		cursor->row_arr = NULL;
 	}
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	if (cursor->rows) {
+		free(cursor->rows);
+		cursor->rows = NULL;
+	}
+#endif
 	free(cursor);
 	return DB_OK;
 }
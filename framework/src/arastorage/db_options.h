@@ -178,6 +178,16 @@
 #define DB_CURSOR_RESULT_ENTRY          ((DB_CURSOR_LIMIT) * (sizeof(uint32_t)*8))
 #endif							/* DB_CURSOR_RESULT_ENTRY */
 
+/* The number of tuples read from storage at once when processing
+   a selection, and cached by a cursor when reading the result. */
+#ifndef DB_BATCH_ROWS
+#ifdef CONFIG_ARASTORAGE_BATCH_ROWS
+#define DB_BATCH_ROWS                   CONFIG_ARASTORAGE_BATCH_ROWS
+#else
+#define DB_BATCH_ROWS                   32
+#endif
+#endif							/* DB_BATCH_ROWS */
+
 /* The name of the intermediate "result" relation file, which is used
    for presenting the result of a query to a user. */
 #ifndef RESULT_RELATION
@@ -205,6 +215,10 @@
 
 #define BUCKET_FILE_LENGTH 15
 
+#define WAL_FILE_NAME "wal"
+
+#define WAL_FILE_LENGTH 15
+
 #define TEMP_FILE_SUFFIX ".tmp"
 
 #define TEMP_FILE_SUFFIX_LENGTH 4
@@ -254,4 +268,11 @@
 #define LVM_USE_FLOATS                  DB_FEATURE_FLOATS
 #endif							/* LVM_USE_FLOATS */
 
+/* The number of rows for which a predicate is evaluated at once by
+   lvm_execute_batch(). Temporary vectors of this size are on the stack
+   for each level of the predicate. */
+#ifndef LVM_VECTOR_SIZE
+#define LVM_VECTOR_SIZE                 16
+#endif							/* LVM_VECTOR_SIZE */
+
 #endif							/* !DB_OPTIONS_H */
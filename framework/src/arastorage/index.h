@@ -111,6 +111,13 @@ struct index_iterator_s {
 };
 typedef struct index_iterator_s index_iterator_t;
 
+/* A key and the tuple holding it, handed to bulk_load sorted by key */
+struct index_pair_s {
+	long key;
+	tuple_id_t tuple_id;
+};
+typedef struct index_pair_s index_pair_t;
+
 struct index_api_s {
 	index_type_t type;
 	uint8_t flags;
@@ -121,6 +128,7 @@ struct index_api_s {
 	db_result_t(*insert)(index_t *, attribute_value_t *, tuple_id_t);
 	db_result_t(*delete)(index_t *, attribute_value_t *);
 	tuple_id_t(*get_next)(index_iterator_t *, uint8_t);
+	db_result_t(*bulk_load)(index_t *, index_pair_t *, tuple_id_t);
 };
 
 typedef struct index_api_s index_api_t;
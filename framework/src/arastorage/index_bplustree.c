@@ -49,6 +49,7 @@
  * Included Files
  ****************************************************************************/
 #include <limits.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,15 +72,45 @@
 #define DB_TUPLES_LIMIT CONFIG_DB_TUPLES_LIMIT
 #define PG_SIZE        1*sizeof(struct key_value_pair)
 #define BUCKET_SIZE      48
-#define NODE_DEPTH      2
-#define LEAF_NODES      pow(BRANCH_FACTOR, NODE_DEPTH)
 #define EMPTY_NODE(node)        (node)->val[BRANCH_FACTOR-1] == 0
 #define KEY_MAX INT_MAX
 #define ROW_XOR 0xf6U
 #define NODE_STATE_VALID 1
 #define NODE_STATE_LOCK 2
 #define NODE_STATE_DIRTY 4
-#define ROOT_NODE_PARENT 255
+#define ROOT_NODE_PARENT -1
+
+/* Number of pairs in a bucket and of children of a node built by bulk_load.
+ * Room is left so that the following insertions don't split them at once.
+ */
+#define BULK_BUCKET_FILL (BUCKET_SIZE * 3 / 4)
+#define BULK_NODE_FILL  (BRANCH_FACTOR > 3 ? BRANCH_FACTOR - 1 : BRANCH_FACTOR)
+
+/* Number of buckets or nodes written to storage at once by bulk_load */
+#define BULK_WRITE_COUNT 8
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+#define WAL_MAGIC        0x4c415741
+#define WAL_BUFFER_SIZE  CONFIG_ARASTORAGE_INDEX_WAL_BUFFER
+#define WAL_CHECKPOINT_SIZE CONFIG_ARASTORAGE_INDEX_WAL_SIZE
+
+/* Operations of the log records. The logical ones are replayed when the
+ * last checkpoint didn't complete. The images are written by a checkpoint
+ * and applied only when followed by the commit record.
+ */
+#define WAL_OP_BEGIN     0
+#define WAL_OP_INSERT    1
+#define WAL_OP_DELETE    2
+#define WAL_OP_REMOVE    3
+#define WAL_OP_NODE      4
+#define WAL_OP_BUCKET    5
+#define WAL_OP_TREE      6
+#define WAL_OP_COMMIT    7
+#endif
+
+/* Header of the tree file, "TREE" */
+#define TREE_MAGIC       0x45455254
+#define TREE_VERSION     1
 
 /* The total number of states possible of a node */
 #define NODE_STATES 255
@@ -129,7 +160,7 @@
  ****************************************************************************/
 struct key_value_pair_s {
 	int key;
-	uint16_t value;
+	tuple_id_t value;
 };
 typedef struct key_value_pair_s pair_t;
 
@@ -150,7 +181,7 @@ typedef struct bucket_s bucket_t;
 struct qnode_s {
 	struct qnode_s *next;
 	struct qnode_s *prev;
-	uint8_t id;
+	uint16_t id;
 	uint8_t pos;
 	uint8_t node_state;
 };
@@ -230,15 +261,69 @@ typedef enum bsplit_status_e bsplit_status_t;
 typedef enum cache_result_e cache_result_t;
 typedef enum tree_result_e tree_result_t;
 
+/* Buckets or nodes of consecutive ids written at once by bulk_load */
+struct bulk_writer_s {
+	db_storage_id_t storage;
+	unsigned long base;			/* Offset of the item of id 0 */
+	unsigned size;				/* Size of an item */
+	int first;					/* Id of the first item in the buffer */
+	int count;					/* Number of items in the buffer */
+	uint8_t *buffer;
+};
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+/* A record of the write-ahead log. Images of nodes, buckets and of the tree
+ * metadata follow their record, whose key is the id and value the size.
+ */
+struct wal_record_s {
+	uint16_t epoch;				/* Checkpoint the record belongs to */
+	uint8_t op;
+	uint8_t reserved;
+	int32_t key;
+	uint32_t value;
+	uint32_t check;				/* Checksum of the fields above */
+};
+typedef struct wal_record_s wal_record_t;
+
+/* The tree metadata logged by a checkpoint */
+struct wal_tree_s {
+	uint16_t off_nodes;
+	uint16_t off_buckets;
+	uint16_t root;
+	uint16_t levels;
+	uint32_t inserted;
+	uint32_t deleted;
+};
+#endif
+
+/* Header of the tree file, followed by the name of the bucket file and the
+ * nodes. Only the metadata is saved, so that the file doesn't depend on the
+ * layout of tree_t in RAM. The sizes of nodes and buckets depend on the
+ * configuration and must match on load.
+ */
+struct tree_header_s {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t root;
+	uint16_t off_nodes;
+	uint16_t off_buckets;
+	uint32_t node_size;
+	uint32_t bucket_size;
+	uint32_t inserted;
+	uint32_t deleted;
+	uint8_t levels;
+	uint8_t reserved[3];
+};
+
 /* Tree Metadata maintained in RAM */
 struct tree_s {
 	db_storage_id_t tree_storage;	/* The fd to tree storage file */
 	db_storage_id_t bucket_storage;	/* The fd to bucket storage file */
-	uint8_t off_nodes, off_buckets;	/*  Maintaining number of nodes and buckets used by the index structure */
-	uint8_t root;				/*   The node id of the root of the bplus-tree */
-	uint8_t lock_buckets[CONFIG_BUCKETS_LIMIT];	/* The structure to prevent to tasks to simultaneously edit same buckets  */
-	uint16_t inserted;			/*  Count of total number of tuples inserted  */
-	uint16_t deleted;			/*    Count of total number of tuples deleted  */
+	uint16_t off_nodes, off_buckets;	/*  Maintaining number of nodes and buckets used by the index structure */
+	uint16_t root;				/*   The node id of the root of the bplus-tree */
+	uint8_t *lock_buckets;		/* The structure to prevent to tasks to simultaneously edit same buckets  */
+	uint32_t inserted;			/*  Count of total number of tuples inserted  */
+	uint32_t deleted;			/*    Count of total number of tuples deleted  */
 	uint8_t levels;				/*  The depth of the bplus-tree including the buckets  */
 	tree_cache_t *node_cache;	/*  Structure to maintain node cache  */
 	bucket_cache_t *buck_cache;	/*   Structure to maintain bucket cache  */
@@ -246,6 +331,14 @@ struct tree_s {
 	pthread_mutex_t buck_cache_lock;	/*  Maintains concurrency control over Bucket Cache  */
 	pthread_mutex_t bucket_lock;	/*  Maintains serialisability over in RAM Tree Structure  */
 	struct rw_lock_s tree_lock;	/*  A Reader Writer Lock used to maintain consistency in tree structure */
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	db_storage_id_t wal_storage;	/* The fd to the write-ahead log */
+	unsigned long wal_offset;	/*  Offset of the next record in the log  */
+	uint16_t wal_epoch;			/*  Epoch of the records since the last checkpoint  */
+	uint8_t wal_count;			/*  Number of records in the buffer  */
+	uint8_t wal_replay;			/*  Set while the log is replayed, which is not logged again  */
+	wal_record_t wal_buffer[WAL_BUFFER_SIZE];	/* Records not written to the log yet */
+#endif
 };
 typedef struct tree_s tree_t;
 
@@ -282,6 +375,15 @@ static db_result_t release(index_t *);
 static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
 static db_result_t delete(index_t *, attribute_value_t *);
 static tuple_id_t get_next(index_iterator_t *, uint8_t);
+static db_result_t bulk_load(index_t *, index_pair_t *, tuple_id_t);
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+static db_result_t wal_open(tree_t *, index_t *);
+static void wal_append(tree_t *, uint8_t, int, tuple_id_t);
+static db_result_t wal_checkpoint(tree_t *);
+static void wal_update(tree_t *);
+static db_result_t wal_recover(tree_t *, index_t *);
+#endif
 
 #ifdef DB_WIP
 static db_result_t vacuum(tree_t *, relation_t *);
@@ -302,7 +404,8 @@ index_api_t index_bplustree = {
 	release,
 	insert,
 	delete,
-	get_next
+	get_next,
+	bulk_load
 };
 
 /****************************************************************************
@@ -328,6 +431,75 @@ void* bptree_malloc(size_t size)
 	return p;
 }
 
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+/****************************************************************************
+ * Name: wal_filename
+ *
+ * Description: The log of an index is named after its tree file, with the
+ *              same random suffix
+ *
+ ****************************************************************************/
+static void wal_filename(char *filename, index_t *index)
+{
+	char *suffix = strchr(index->descriptor_file, '.');
+
+	snprintf(filename, WAL_FILE_LENGTH, "%s%s", WAL_FILE_NAME, suffix ? suffix : "");
+}
+#endif
+
+/****************************************************************************
+ * Name: tree_write_header
+ *
+ * Description: Saves the tree metadata at the start of the tree file
+ *
+ ****************************************************************************/
+static db_result_t tree_write_header(tree_t *tree)
+{
+	struct tree_header_s header;
+
+	memset(&header, 0, sizeof(header));
+	header.magic = TREE_MAGIC;
+	header.version = TREE_VERSION;
+	header.root = tree->root;
+	header.off_nodes = tree->off_nodes;
+	header.off_buckets = tree->off_buckets;
+	header.node_size = sizeof(tree_node_t);
+	header.bucket_size = sizeof(bucket_t);
+	header.inserted = tree->inserted;
+	header.deleted = tree->deleted;
+	header.levels = tree->levels;
+	return storage_write_to(tree->tree_storage, &header, 0, sizeof(header));
+}
+
+/****************************************************************************
+ * Name: tree_read_header
+ *
+ * Description: Loads the tree metadata from the tree file. Files of older
+ *              versions, which saved tree_t itself, or with nodes and
+ *              buckets of other sizes are rejected, and the index must be
+ *              created again.
+ *
+ ****************************************************************************/
+static db_result_t tree_read_header(tree_t *tree, db_storage_id_t fd)
+{
+	struct tree_header_s header;
+
+	if (DB_ERROR(storage_read_from(fd, &header, 0, sizeof(header)))) {
+		return DB_STORAGE_ERROR;
+	}
+	if (header.magic != TREE_MAGIC || header.version != TREE_VERSION || header.node_size != sizeof(tree_node_t) || header.bucket_size != sizeof(bucket_t)) {
+		DB_LOG_E("DB: Index file of another version or configuration, the index must be created again\n");
+		return DB_INDEX_ERROR;
+	}
+	tree->root = header.root;
+	tree->off_nodes = header.off_nodes;
+	tree->off_buckets = header.off_buckets;
+	tree->inserted = header.inserted;
+	tree->deleted = header.deleted;
+	tree->levels = header.levels;
+	return DB_OK;
+}
+
 /****************************************************************************
  * Name: create
  *
@@ -344,10 +516,8 @@ static db_result_t create(index_t *index)
 	/* Files storing tree and bucket data */
 	char tree_filename[DB_MAX_FILENAME_LENGTH];
 	char bucket_filename[DB_MAX_FILENAME_LENGTH];
-	tree_node_t *tree_node;
-	size_t tree_node_size = 0;
-	bucket_t *buck;
-	size_t buck_size = 0;
+	tree_node_t tree_node;
+	bucket_t buck;
 	int offset = 0;
 	db_result_t result;
 	uint8_t success = 0;
@@ -362,6 +532,15 @@ static db_result_t create(index_t *index)
 		return result;
 
 	}
+	tree->lock_buckets = bptree_malloc(CONFIG_BUCKETS_LIMIT);
+	if (tree->lock_buckets == NULL) {
+		DB_LOG_E("DB: Failed to allocate a tree\n");
+		free(tree);
+		return DB_ALLOCATION_ERROR;
+	}
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	tree->wal_storage = -1;
+#endif
 
 	/* Generating the file to store the tree structure */
 	snprintf(tree_filename, HEAP_FILE_LENGTH, "%s.%x\0", HEAP_FILE_NAME, (unsigned)(random_rand() & 0xffff));
@@ -369,13 +548,13 @@ static db_result_t create(index_t *index)
 	result = storage_generate_file(tree_filename);
 	if (result == DB_INDEX_ERROR) {
 		DB_LOG_E("DB: Failed to generate a tree file\n");
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 	}
 
 	memcpy(index->descriptor_file, tree_filename, sizeof(index->descriptor_file));
-	tree_node_size = CONFIG_NODE_LIMIT * sizeof(tree_node_t);
-	DB_LOG_D("DB: Generated the tree file \"%s\" using %u bytes of space\n", index->descriptor_file, tree_node_size);
+	DB_LOG_D("DB: Generated the tree file \"%s\" using %u bytes of space\n", index->descriptor_file, (unsigned)(CONFIG_NODE_LIMIT * sizeof(tree_node_t)));
 
 	/* Generating bucket file to store <key, tuple_id> pair */
 	snprintf(bucket_filename, BUCKET_FILE_LENGTH, "%s.%x\0", BUCKET_FILE_NAME, (unsigned)(random_rand() & 0xffff));
@@ -384,11 +563,11 @@ static db_result_t create(index_t *index)
 	if (result == DB_INDEX_ERROR) {
 		DB_LOG_E("DB: Failed to generate a bucket file\n");
 		storage_remove(tree_filename);
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 	}
-	buck_size = CONFIG_BUCKETS_LIMIT * sizeof(bucket_t);
-	DB_LOG_D("DB: Generated the bucket file \"%s\" using %u bytes of space\n", bucket_filename, buck_size);
+	DB_LOG_D("DB: Generated the bucket file \"%s\" using %u bytes of space\n", bucket_filename, (unsigned)(CONFIG_BUCKETS_LIMIT * sizeof(bucket_t)));
 
 	/* Initialising both tree and bucket storage files */
 	tree->tree_storage = storage_open(tree_filename, O_RDWR);
@@ -396,6 +575,7 @@ static db_result_t create(index_t *index)
 		result = DB_STORAGE_ERROR;
 		storage_remove(tree_filename);
 		storage_remove(bucket_filename);
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 	}
@@ -405,37 +585,34 @@ static db_result_t create(index_t *index)
 		storage_close(tree->tree_storage);
 		storage_remove(tree_filename);
 		storage_remove(bucket_filename);
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 
 	}
-	storage_write_to(tree->tree_storage, tree, offset, sizeof(tree_t));
-	offset += sizeof(tree_t);
+	tree_write_header(tree);
+	offset += sizeof(struct tree_header_s);
 	storage_write_to(tree->tree_storage, bucket_filename, offset, sizeof(bucket_filename));
 	offset += sizeof(bucket_filename);
 	base_offset = offset;
-	tree_node = bptree_malloc(tree_node_size);
-	if (tree_node) {
-		storage_write_to(tree->tree_storage, tree_node, offset, tree_node_size);
-		free(tree_node);
-	}
 
-	buck = bptree_malloc(buck_size);
-	if (buck) {
-		buck[0].next_free_slot = 0;
-		buck[0].info[0] = CONFIG_BUCKETS_LIMIT - 1;
-		buck[0].info[1] = KEY_MAX;
-		buck[0].info[2] = 0;
-		storage_write_to(tree->bucket_storage, buck, 0, buck_size);
-		free(buck);
-	}
-	
+	/* Only the first node and bucket are written, the files grow as more
+	 * of them are written back from the caches.
+	 */
+	memset(&tree_node, 0, sizeof(tree_node));
+	storage_write_to(tree->tree_storage, &tree_node, offset, sizeof(tree_node));
+
+	memset(&buck, 0, sizeof(buck));
+	buck.next_free_slot = 0;
+	buck.info[0] = CONFIG_BUCKETS_LIMIT - 1;
+	buck.info[1] = KEY_MAX;
+	buck.info[2] = 0;
+	storage_write_to(tree->bucket_storage, &buck, 0, sizeof(buck));
+
 	/* One is the root node and one is the bucket layer */
 	tree->levels = 2;
 
 	index->opaque_data = tree;
-	/* Initialize the tree metadata. */
-	memset(&tree->lock_buckets, 0, sizeof(tree->lock_buckets));
 
 	/* Allocating node cache and initialising it */
 	tree->node_cache = bptree_malloc(sizeof(tree_cache_t));
@@ -468,6 +645,7 @@ static db_result_t create(index_t *index)
 			}
 			free(tree->node_cache);
 		}
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 	}
@@ -507,6 +685,7 @@ static db_result_t create(index_t *index)
 			}
 			free(tree->buck_cache);
 		}
+		free(tree->lock_buckets);
 		free(tree);
 		return result;
 	}
@@ -528,6 +707,12 @@ static db_result_t create(index_t *index)
 		return result;
 	}
 
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	if (DB_ERROR(wal_open(tree, index))) {
+		return DB_STORAGE_ERROR;
+	}
+#endif
+
 	DB_LOG_D("DB: Created a bplus-tree index\n");
 	result = DB_OK;
 	return result;
@@ -545,7 +730,7 @@ static db_result_t destroy(index_t *index)
 	if (fd < 0) {
 		return DB_STORAGE_ERROR;
 	}
-	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_t), sizeof(bucket_file)))) {
+	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(struct tree_header_s), sizeof(bucket_file)))) {
 		storage_close(fd);
 		return DB_STORAGE_ERROR;
 	}
@@ -554,6 +739,11 @@ static db_result_t destroy(index_t *index)
 	if (DB_ERROR(r)) {
 		return DB_STORAGE_ERROR;
 	}
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	char wal_file[DB_MAX_FILENAME_LENGTH];
+	wal_filename(wal_file, index);
+	storage_remove(wal_file);
+#endif
 	return DB_OK;
 }
 
@@ -578,19 +768,24 @@ static db_result_t load(index_t *index)
 		free(tree);
 		return DB_STORAGE_ERROR;
 	}
-	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_t), sizeof(bucket_file)))) {
+	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(struct tree_header_s), sizeof(bucket_file)))) {
 		DB_LOG_E("Failed reading bucket file\n");
 		storage_close(fd);
 		free(tree);
 		return DB_STORAGE_ERROR;
 	}
-	if (DB_ERROR(storage_read_from(fd, tree, 0, sizeof(tree_t)))) {
+	result = tree_read_header(tree, fd);
+	if (DB_ERROR(result)) {
 		DB_LOG_E("Failed  reading tree structure from descriptor file\n");
 		storage_close(fd);
 		free(tree);
-		return DB_STORAGE_ERROR;
+		return result;
 	}
 	storage_close(fd);
+	tree->lock_buckets = NULL;
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	tree->wal_storage = -1;
+#endif
 
 	tree->node_cache = bptree_malloc(sizeof(tree_cache_t));
 	if (tree->node_cache != NULL) {
@@ -661,10 +856,30 @@ static db_result_t load(index_t *index)
 		return result;
 	}
 
-	base_offset = sizeof(tree_t) + sizeof(bucket_file);
+	base_offset = sizeof(struct tree_header_s) + sizeof(bucket_file);
 	tree->tree_storage = storage_open(index->descriptor_file, O_RDWR);
 	tree->bucket_storage = storage_open(bucket_file, O_RDWR);
 
+	/* Locks and lock states are not saved with the tree metadata */
+	tree->lock_buckets = bptree_malloc(CONFIG_BUCKETS_LIMIT);
+	if (tree->lock_buckets == NULL) {
+		DB_LOG_E("DB: Failed to allocate a tree while loading\n");
+		release(index);
+		return DB_ALLOCATION_ERROR;
+	}
+	pthread_mutex_init(&(tree->node_cache_lock), NULL);
+	pthread_mutex_init(&(tree->bucket_lock), NULL);
+	pthread_mutex_init(&(tree->buck_cache_lock), NULL);
+	rw_init(&(tree->tree_lock));
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	if (DB_ERROR(wal_open(tree, index)) || DB_ERROR(wal_recover(tree, index))) {
+		DB_LOG_E("DB: Failed to recover btree index from the log\n");
+		release(index);
+		return DB_STORAGE_ERROR;
+	}
+#endif
+
 	DB_LOG_D("DB: Loaded btree index from file %s and bucket file %s\n", index->descriptor_file, bucket_file);
 
 	return DB_OK;
@@ -689,7 +904,14 @@ static db_result_t release(index_t *index)
 	if ((tree->buck_cache->in_cache.tail == NULL) || (tree->buck_cache->in_cache.head == NULL)) {
 		return DB_ALLOCATION_ERROR;
 	}
-	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	/* Nothing is left dirty in the caches after the checkpoint */
+	if (tree->wal_storage >= 0) {
+		wal_checkpoint(tree);
+		storage_close(tree->wal_storage);
+	}
+#endif
+	tree_write_header(tree);
 	/* Bucket Cache being flushed */
 	tmp_node = tree->buck_cache->in_cache.head->next;
 	free(tmp_node->prev);
@@ -720,6 +942,7 @@ static db_result_t release(index_t *index)
 
 	free(tree->node_cache);
 	free(tree->buck_cache);
+	free(tree->lock_buckets);
 	free(tree);
 	return DB_OK;
 }
@@ -751,6 +974,14 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 		return DB_INDEX_ERROR;
 	}
 
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	/* The insertion is logged and the nodes it changed stay in the caches
+	 * until a checkpoint writes them back.
+	 */
+	wal_append(tree, WAL_OP_INSERT, (int)long_key, value);
+	wal_update(tree);
+#endif
+
 	/***************************************************************************************
 	 *	The following code is to implement write through caching structure.
 	 *	The write back cache gives better performance as compared to write through cache
@@ -758,7 +989,7 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 	 ***************************************************************************************/
 #ifdef DB_WIP
 	qnode_t *tmp_node;
-	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
+	tree_write_header(tree);
 
 	/* Bucket Cache being flushed */
 
@@ -785,11 +1016,22 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 static db_result_t delete(index_t *index, attribute_value_t *value)
 {
 	int i_key;
+	db_result_t result;
 
 	i_key = db_value_to_long(value);
 	DB_LOG_D("delete index for value %d\n", i_key);
 
-	return delete_item_btree(index, i_key);
+	/* delete_item_btree releases the tree lock */
+	rw_lock_write(&(((tree_t *)index->opaque_data)->tree_lock));
+	result = delete_item_btree(index, i_key);
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	if (result == DB_OK) {
+		wal_append(index->opaque_data, WAL_OP_DELETE, i_key, 0);
+		wal_update(index->opaque_data);
+	}
+#endif
+	return result;
 }
 
 /****************************************************************************
@@ -869,6 +1111,9 @@ static tuple_id_t get_next(index_iterator_t *iterator, uint8_t matched_condition
 			/* matched condition is FALSE when the query is for remove tuples */
 			if (matched_condition == FALSE) {
 				tuple_id_t tmp = cache.bucket->pairs[i].value;
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+				int key = cache.bucket->pairs[i].key;
+#endif
 				if (cache.end > (i + 1)) {
 					cache.bucket->pairs[i] = cache.bucket->pairs[cache.end - 1];
 
@@ -889,6 +1134,9 @@ static tuple_id_t get_next(index_iterator_t *iterator, uint8_t matched_condition
 				tree->deleted++;
 				cache.end--;
 				cache.start = i;
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+				wal_append(tree, WAL_OP_REMOVE, key, tmp);
+#endif
 				return tmp;
 			} else {
 				cache.start = i + 1;
@@ -919,6 +1167,11 @@ static tuple_id_t get_next(index_iterator_t *iterator, uint8_t matched_condition
 			iterator->next_item_no = 1;
 		}
 		pthread_mutex_unlock(&(tree->bucket_lock));
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+		if (matched_condition == FALSE) {
+			wal_update(tree);
+		}
+#endif
 		rw_unlock_write(&(tree->tree_lock));
 		return INVALID_TUPLE;
 	}
@@ -940,6 +1193,11 @@ static tuple_id_t get_next(index_iterator_t *iterator, uint8_t matched_condition
 			iterator->next_item_no = 1;
 		}
 		pthread_mutex_unlock(&(tree->bucket_lock));
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+		if (matched_condition == FALSE) {
+			wal_update(tree);
+		}
+#endif
 		rw_unlock_write(&(tree->tree_lock));
 		return INVALID_TUPLE;
 
@@ -1095,6 +1353,36 @@ static cache_result_t modify_cache(tree_t *tree, int id, cache_type_t cache, op_
 	return CACHE_OK;
 }
 
+/****************************************************************************
+ * Name: cache_victim
+ *
+ * Description: Finds the least recently used entry which is not locked,
+ *              to be evicted from a cache. Returns the tail of the queue
+ *              when all entries are locked.
+ *              With the write-ahead log, dirty entries are written back by
+ *              checkpoints only, so that the files stay as of the last one.
+ *              A clean entry is preferred, and a dirty one is written back
+ *              early only when the whole cache is dirty.
+ *
+ ****************************************************************************/
+static qnode_t *cache_victim(queue_t *in_cache)
+{
+	qnode_t *iter;
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+	for (iter = in_cache->head->next; iter != in_cache->tail; iter = iter->next) {
+		if (!(iter->node_state & NODE_STATE_LOCK) && (!(iter->node_state & NODE_STATE_DIRTY) || !(iter->node_state & NODE_STATE_VALID))) {
+			return iter;
+		}
+	}
+#endif
+	iter = in_cache->head->next;
+	while ((iter->node_state & NODE_STATE_LOCK) && iter != in_cache->tail) {
+		iter = iter->next;
+	}
+	return iter;
+}
+
 /****************************************************************************
  * Name: cache_write_node
  *
@@ -1117,10 +1405,7 @@ static cache_result_t cache_write_node(tree_t *tree, int id, tree_node_t *node)
 		new_node->pos = tree->node_cache->num++;
 	} else {
 		qnode_t *iter_node;
-		iter_node = tree->node_cache->in_cache.head->next;
-		while ((iter_node->node_state & NODE_STATE_LOCK) && iter_node != tree->node_cache->in_cache.tail) {
-			iter_node = iter_node->next;
-		}
+		iter_node = cache_victim(&(tree->node_cache->in_cache));
 		if (iter_node == tree->node_cache->in_cache.tail) {
 			free(new_node);
 			DB_LOG_E("NO SLOT AVAIABLE IN CACHE\n");
@@ -1204,10 +1489,7 @@ static cache_result_t cache_write_bucket(tree_t *tree, int id, bucket_t *bucket)
 		new_node->pos = tree->buck_cache->num++;
 	} else {
 		qnode_t *iter_node;
-		iter_node = tree->buck_cache->in_cache.head->next;
-		while ((iter_node->node_state & NODE_STATE_LOCK) && (iter_node != tree->buck_cache->in_cache.tail)) {
-			iter_node = iter_node->next;
-		}
+		iter_node = cache_victim(&(tree->buck_cache->in_cache));
 		if (iter_node == tree->buck_cache->in_cache.tail) {
 			free(new_node);
 			DB_LOG_E("NO SLOT AVAILABLE IN CACHE bucket\n");
@@ -1289,10 +1571,7 @@ static tree_node_t *tree_read(tree_t *tree, int bucket_id)
 			new_node->pos = tree->node_cache->num++;
 		} else {
 			/* Case when the least recently used node needs to be evicted to make place for new node */
-			qnode_t *replace_node = tree->node_cache->in_cache.head->next;
-			while ((replace_node->node_state & NODE_STATE_LOCK) && replace_node != tree->node_cache->in_cache.tail) {
-				replace_node = replace_node->next;
-			}
+			qnode_t *replace_node = cache_victim(&(tree->node_cache->in_cache));
 			if (replace_node == tree->node_cache->in_cache.tail) {
 				free(new_node);
 				pthread_mutex_unlock(&(tree->node_cache_lock));
@@ -1308,7 +1587,8 @@ static tree_node_t *tree_read(tree_t *tree, int bucket_id)
 		/* Adjusting the pointers */
 		PLACE_AT_TAIL(new_node, tree->node_cache);
 		new_node->id = bucket_id;
-		SET_NODE_STATE(new_node, NODE_STATE_LOCK | NODE_STATE_VALID | NODE_STATE_DIRTY);
+		SET_NODE_STATE(new_node, NODE_STATE_LOCK | NODE_STATE_VALID);
+		UNSET_NODE_STATE(new_node, NODE_STATE_DIRTY);
 
 		/* Reading from flash */
 		if (DB_ERROR(storage_read_from(tree->tree_storage, &(tree->node_cache->cache_t[new_node->pos].node), base_offset + (unsigned long)bucket_id * sizeof(tree_node_t), sizeof(tree_node_t)))) {
@@ -1399,7 +1679,7 @@ static tree_result_t tree_insert(tree_t *tree, int max)
 static pair_t *tree_find(tree_t *tree, int key)
 {
 	int hashed_key;
-	uint8_t id;
+	uint16_t id;
 	tree_node_t *node;
 	int index;
 	hashed_key = transform_key(key);
@@ -1563,10 +1843,7 @@ static bucket_t *bucket_read(tree_t *tree, int bucket_id)
 			new_node->pos = tree->buck_cache->num++;
 		} else {
 			/* Cache doesn't have enough space and the least recently used bucket needs to be evicted */
-			qnode_t *replace_node = tree->buck_cache->in_cache.head->next;
-			while ((replace_node->node_state & NODE_STATE_LOCK) && (replace_node != tree->buck_cache->in_cache.tail)) {
-				replace_node = replace_node->next;
-			}
+			qnode_t *replace_node = cache_victim(&(tree->buck_cache->in_cache));
 			if (replace_node == tree->buck_cache->in_cache.tail) {
 				free(new_node);
 				pthread_mutex_unlock(&(tree->buck_cache_lock));
@@ -1657,8 +1934,8 @@ static tsplit_status_t tree_split(tree_t *tree, int key, int id, pair_t *path, i
 	int i, j;
 	if (path[level].key == ROOT_NODE_PARENT) {
 		/* Case when root has split and new root node requires to be created */
-		uint8_t root = tree->root;
-		uint8_t new_root = tree->off_nodes++;
+		uint16_t root = tree->root;
+		uint16_t new_root = tree->off_nodes++;
 		if (tree->off_nodes > CONFIG_NODE_LIMIT) {
 			tree->off_nodes--;
 			return TSPLIT_FAIL;
@@ -1778,6 +2055,7 @@ static bsplit_status_t bucket_split(tree_t *tree, int key, int value, pair_t *pa
 	int median;
 	bucket_t *bucket;
 	uint16_t bucket_id = path[tree->levels].key;
+	int split;
 	int i;
 	if (tree->off_buckets == CONFIG_BUCKETS_LIMIT - 1) {
 		DB_LOG_E("TREE FULL !");
@@ -1800,7 +2078,23 @@ static bsplit_status_t bucket_split(tree_t *tree, int key, int value, pair_t *pa
 
 	qsort(bucket_tuples, BUCKET_SIZE + 1, sizeof(pair_t), compare);
 
-	median = bucket_tuples[(BUCKET_SIZE + 1) / 2].key;
+	/* Equal keys are kept in one bucket when they fit, as searches go to
+	 * the bucket holding the keys from the median on.
+	 */
+	split = (BUCKET_SIZE + 1) / 2;
+	while (split > 0 && bucket_tuples[split - 1].key == bucket_tuples[split].key) {
+		split--;
+	}
+	if (split == 0) {
+		split = (BUCKET_SIZE + 1) / 2;
+		while (split < BUCKET_SIZE + 1 && bucket_tuples[split - 1].key == bucket_tuples[split].key) {
+			split++;
+		}
+		if (split == BUCKET_SIZE + 1) {
+			split = (BUCKET_SIZE + 1) / 2;
+		}
+	}
+	median = bucket_tuples[split].key;
 	/* Call tree_split before creating a new bucket and dividing the entries */
 	int b_id = tree->off_buckets++;
 	int res = tree_split(tree, median, b_id, path, tree->levels - 1);
@@ -1811,7 +2105,7 @@ static bsplit_status_t bucket_split(tree_t *tree, int key, int value, pair_t *pa
 		int ind = 0;
 		int off;
 		for (;; ind++) {
-			if (ind == (BUCKET_SIZE + 1) / 2) {
+			if (ind == split) {
 				break;
 			}
 			b1.pairs[ind] = bucket_tuples[ind];
@@ -2115,6 +2409,7 @@ static void tree_node_update_keys(tree_t *tree, pair_t *path, int rm_val, int le
 		if (n->val[i] == rm_val) {
 			n->val[i] = range_min;
 			bFound = true;
+			modify_cache(tree, node_id, NODE, DIRTY);
 			DB_LOG_D("Found keys, value %d , node_id %d\n", rm_val, node_id);
 			break;
 		}
@@ -2150,6 +2445,7 @@ static void bucket_update_keys(tree_t *tree, pair_t *path, int bucket_id, int rm
 			first_bucket = bucket_read(tree, bucket_id);
 			n->val[i] = first_bucket->info[1];
 			modify_cache(tree, bucket_id, BUCKET, UNLOCK);
+			modify_cache(tree, node_id, NODE, DIRTY);
 			bLeaf = true;
 			DB_LOG_D("bucket_update_keys, value %d , node_id %d\n", rm_val, node_id);
 			break;
@@ -2204,6 +2500,8 @@ static int bucket_request_sibling(tree_t *tree, pair_t *path, bucket_t *bucket)
 
 				n->val[index - 1] = share_key;
 
+				modify_cache(tree, node_id, NODE, DIRTY);
+				modify_cache(tree, n->id[index - 1], BUCKET, DIRTY);
 				modify_cache(tree, node_id, NODE, UNLOCK);
 				modify_cache(tree, n->id[index - 1], BUCKET, UNLOCK);
 				return 0;
@@ -2230,6 +2528,8 @@ static int bucket_request_sibling(tree_t *tree, pair_t *path, bucket_t *bucket)
 
 				n->val[index] = right_bucket->info[1];
 
+				modify_cache(tree, node_id, NODE, DIRTY);
+				modify_cache(tree, n->id[index + 1], BUCKET, DIRTY);
 				modify_cache(tree, node_id, NODE, UNLOCK);
 				modify_cache(tree, n->id[index + 1], BUCKET, UNLOCK);
 				return 0;
@@ -2250,6 +2550,7 @@ static void bucket_update_next(tree_t *tree, int bucket_id, int next_id)
 	bucket = bucket_read(tree, bucket_id);
 	if (bucket) {
 		bucket->info[0] = next_id;
+		modify_cache(tree, bucket_id, BUCKET, DIRTY);
 		DB_LOG_D("set bucket %d next id %d\n", bucket_id, next_id);
 	}
 	modify_cache(tree, bucket_id, BUCKET, UNLOCK);
@@ -2300,6 +2601,7 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 	int sb_key_num;
 	bool bmerge_left = false;
 	bool bmerge_right = false;
+	bool rebuild_parent = false;
 	tree_node_t *n;
 	tree_node_t *pn;
 	tree_node_t *lsbn = NULL;
@@ -2334,6 +2636,9 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 			pn->val[index - 1] = lsbn->val[sb_key_num - 1];			
 			lsbn->val[BRANCH_FACTOR - 1] = sb_key_num - 1;
 
+			modify_cache(tree, node_id, NODE, DIRTY);
+			modify_cache(tree, pnode_id, NODE, DIRTY);
+			modify_cache(tree, lsb_id, NODE, DIRTY);
 			modify_cache(tree, node_id, NODE, UNLOCK);
 			modify_cache(tree, pnode_id, NODE, UNLOCK);
 			modify_cache(tree, lsb_id, NODE, UNLOCK);
@@ -2364,6 +2669,9 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 			}
 			rsbn->val[BRANCH_FACTOR - 1] = sb_key_num - 1;
 
+			modify_cache(tree, node_id, NODE, DIRTY);
+			modify_cache(tree, pnode_id, NODE, DIRTY);
+			modify_cache(tree, rsb_id, NODE, DIRTY);
 			modify_cache(tree, node_id, NODE, UNLOCK);
 			modify_cache(tree, pnode_id, NODE, UNLOCK);
 			modify_cache(tree, rsb_id, NODE, UNLOCK);
@@ -2404,16 +2712,18 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 			rsbn->val[BRANCH_FACTOR - 1] = sb_key_num + key_num;
 		}
 
-		//release current node
+		modify_cache(tree, bmerge_left ? lsb_id : rsb_id, NODE, DIRTY);
+		modify_cache(tree, pnode_id, NODE, DIRTY);
+
+		//release current node. Its id is not reused, as ids are given in
+		//sequence and the last one given may still be in use.
 		modify_cache(tree, node_id, NODE, INVALIDATE);
-		tree->off_nodes--;
 
 		//update parent node
 		if (pn->val[BRANCH_FACTOR - 1] == 1) {  //parent node MUST be root
 			tree->root = bmerge_left ? lsb_id : rsb_id;
 			DB_LOG_D("[tree->root]tree root change to %d\n", tree->root);
 			tree->levels--;
-			tree->off_nodes--;
 			modify_cache(tree, pnode_id, NODE, INVALIDATE);
 		} else {
 			if (bmerge_left) {
@@ -2425,9 +2735,7 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 			}
 			pn->val[BRANCH_FACTOR - 1] = pn->val[BRANCH_FACTOR - 1] - 1;
 
-			if ((pnode_id != tree->root) && pn->val[BRANCH_FACTOR - 1] < BRANCH_FACTOR / 2) {
-				tree_rebuild_node(tree, path, level-1);
-			}
+			rebuild_parent = (pnode_id != tree->root) && pn->val[BRANCH_FACTOR - 1] < BRANCH_FACTOR / 2;
 		}
 	}
 
@@ -2441,6 +2749,11 @@ static int tree_rebuild_node(tree_t *tree, pair_t *path, int level)
 	modify_cache(tree, node_id, NODE, UNLOCK);
 	modify_cache(tree, pnode_id, NODE, UNLOCK);
 
+	//the parent is rebuilt once unlocked, to be read again
+	if (rebuild_parent) {
+		tree_rebuild_node(tree, path, level - 1);
+	}
+
 	return 0;
 }
 
@@ -2478,6 +2791,7 @@ static int bucket_merge_sibling(tree_t *tree, pair_t *path, bucket_t *bucket, in
 			
 			//update bucket list
 			modify_cache(tree, path[tree->levels].key, BUCKET, INVALIDATE);
+			modify_cache(tree, sibling_id, BUCKET, DIRTY);
 			modify_cache(tree, sibling_id, BUCKET, UNLOCK);
 
 			//update parent tree node
@@ -2488,6 +2802,7 @@ static int bucket_merge_sibling(tree_t *tree, pair_t *path, bucket_t *bucket, in
 				n->id[i] = n->id[i + 1];
 			}
 			n->val[BRANCH_FACTOR - 1] = (--key_num);
+			modify_cache(tree, node_id, NODE, DIRTY);
 			modify_cache(tree, node_id, NODE, UNLOCK);
 
 			bucket_update_keys(tree, path, sibling_id, rm_val);
@@ -2513,6 +2828,7 @@ static int bucket_merge_sibling(tree_t *tree, pair_t *path, bucket_t *bucket, in
 			}
 			//update bucket list
 			modify_cache(tree, path[tree->levels].key, BUCKET, INVALIDATE);
+			modify_cache(tree, sibling_id, BUCKET, DIRTY);
 			modify_cache(tree, sibling_id, BUCKET, UNLOCK);
 
 			//update parent tree node
@@ -2522,6 +2838,7 @@ static int bucket_merge_sibling(tree_t *tree, pair_t *path, bucket_t *bucket, in
 				n->id[i] = n->id[i + 1];
 			}
 			n->val[BRANCH_FACTOR - 1] = (--key_num);
+			modify_cache(tree, node_id, NODE, DIRTY);
 			modify_cache(tree, node_id, NODE, UNLOCK);
 
 			bucket_update_keys(tree, path, sibling_id, rm_val);
@@ -2556,6 +2873,7 @@ static db_result_t delete_item_btree(index_t *index, int value)
 	tree = (tree_t*)index->opaque_data;
 	path = tree_find(tree, value);
 	if (path == NULL) {
+		rw_unlock_write(&(tree->tree_lock));
 		return DB_INDEX_ERROR;
 	}
 
@@ -2563,6 +2881,7 @@ static db_result_t delete_item_btree(index_t *index, int value)
 	tmp_bucket = bucket_read(tree, bucket_id);
 	bucket_remove_pair(tmp_bucket, value, &rm_value, 0);
 	free(rm_value);
+	modify_cache(tree, bucket_id, BUCKET, DIRTY);
 	modify_cache(tree, bucket_id, BUCKET, UNLOCK);
 	tree->inserted--;
 
@@ -2594,3 +2913,705 @@ static db_result_t delete_item_btree(index_t *index, int value)
 	free(path);
 	return ret;
 }
+
+/****************************************************************************
+ * Name: cache_drop
+ *
+ * Description: Invalidates all entries of a cache without writing them back
+ *
+ ****************************************************************************/
+static void cache_drop(queue_t *in_cache)
+{
+	qnode_t *iter;
+
+	for (iter = in_cache->head->next; iter != in_cache->tail; iter = iter->next) {
+		UNSET_NODE_STATE(iter, NODE_STATE_VALID | NODE_STATE_DIRTY | NODE_STATE_LOCK);
+	}
+}
+
+/****************************************************************************
+ * Name: bulk_flush
+ *
+ * Description: Writes the buffered items of a bulk writer at once
+ *
+ ****************************************************************************/
+static db_result_t bulk_flush(struct bulk_writer_s *writer)
+{
+	if (writer->count > 0) {
+		if (DB_ERROR(storage_write_to(writer->storage, writer->buffer, writer->base + (unsigned long)writer->first * writer->size, writer->count * writer->size))) {
+			DB_LOG_E("DB: Bulk write failed at id %d\n", writer->first);
+			return DB_STORAGE_ERROR;
+		}
+	}
+	writer->first += writer->count;
+	writer->count = 0;
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: bulk_next
+ *
+ * Description: Returns a zeroed item to fill, of the id following the
+ *              previous one
+ *
+ ****************************************************************************/
+static void *bulk_next(struct bulk_writer_s *writer)
+{
+	void *item;
+
+	if (writer->count == BULK_WRITE_COUNT && DB_ERROR(bulk_flush(writer))) {
+		return NULL;
+	}
+	item = writer->buffer + writer->count++ * writer->size;
+	memset(item, 0, writer->size);
+	return item;
+}
+
+/****************************************************************************
+ * Name: bulk_load
+ *
+ * Description: Builds the tree bottom-up from pairs sorted by key, which
+ *              is much faster than inserting them one by one when indexing
+ *              an existing relation: buckets and nodes are filled in order
+ *              and written sequentially, bypassing the caches, and nothing
+ *              is ever split.
+ *              Buckets and nodes are left partly empty for the following
+ *              insertions. A run of equal keys is kept in one bucket when
+ *              it fits, so that a search from its first key finds all.
+ *              Only an empty tree can be loaded.
+ *
+ ****************************************************************************/
+static db_result_t bulk_load(index_t *index, index_pair_t *pairs, tuple_id_t npairs)
+{
+	tree_t *tree;
+	struct bulk_writer_s writer;
+	uint16_t *children;
+	int *keys;
+	bucket_t *bucket;
+	tree_node_t *node;
+	uint16_t is_leaf;
+	tuple_id_t start;
+	tuple_id_t end;
+	tuple_id_t j;
+	int nchildren;
+	int nnodes;
+	int first;
+	int count;
+	int i;
+	int k;
+	db_result_t result = DB_INDEX_ERROR;
+
+	tree = (tree_t *)index->opaque_data;
+	if (tree->inserted != 0 || tree->off_buckets != 1 || npairs == 0) {
+		DB_LOG_E("DB: Bulk load is for an empty bplus-tree index only\n");
+		return DB_INDEX_ERROR;
+	}
+
+	/* The children of the level being built and the keys between them */
+	children = bptree_malloc(CONFIG_BUCKETS_LIMIT * sizeof(uint16_t));
+	keys = bptree_malloc(CONFIG_BUCKETS_LIMIT * sizeof(int));
+	writer.buffer = bptree_malloc(BULK_WRITE_COUNT * max(sizeof(bucket_t), sizeof(tree_node_t)));
+	if (children == NULL || keys == NULL || writer.buffer == NULL) {
+		free(children);
+		free(keys);
+		free(writer.buffer);
+		return DB_ALLOCATION_ERROR;
+	}
+
+	rw_lock_write(&(tree->tree_lock));
+
+	/* The root and the bucket of the new tree are replaced */
+	pthread_mutex_lock(&(tree->node_cache_lock));
+	cache_drop(&(tree->node_cache->in_cache));
+	pthread_mutex_unlock(&(tree->node_cache_lock));
+	pthread_mutex_lock(&(tree->buck_cache_lock));
+	cache_drop(&(tree->buck_cache->in_cache));
+	pthread_mutex_unlock(&(tree->buck_cache_lock));
+	tree->off_nodes = 0;
+	tree->off_buckets = 0;
+
+	writer.storage = tree->bucket_storage;
+	writer.base = 0;
+	writer.size = sizeof(bucket_t);
+	writer.first = 0;
+	writer.count = 0;
+
+	nchildren = 0;
+	for (start = 0; start < npairs; start = end) {
+		end = min(start + BULK_BUCKET_FILL, npairs);
+		while (end < npairs && end - start < BUCKET_SIZE && pairs[end].key == pairs[end - 1].key) {
+			end++;
+		}
+		if (end < npairs && pairs[end].key == pairs[end - 1].key) {
+			/* The run doesn't fit, start the next bucket with it */
+			for (j = end - 1; j > start && pairs[j - 1].key == pairs[j].key; j--) ;
+			if (j > start) {
+				end = j;
+			}
+		}
+
+		/* The last id is the end of the bucket chain */
+		if (tree->off_buckets >= CONFIG_BUCKETS_LIMIT - 1) {
+			DB_LOG_E("TREE FULL !");
+			goto errout;
+		}
+		bucket = bulk_next(&writer);
+		if (bucket == NULL) {
+			goto errout;
+		}
+		bucket->next_free_slot = end - start;
+		for (j = start; j < end; j++) {
+			bucket->pairs[j - start].key = (int)pairs[j].key;
+			bucket->pairs[j - start].value = pairs[j].tuple_id;
+		}
+		bucket->info[0] = end < npairs ? tree->off_buckets + 1 : CONFIG_BUCKETS_LIMIT - 1;
+		bucket->info[1] = (int)pairs[start].key;
+		bucket->info[2] = (int)pairs[end - 1].key;
+
+		if (nchildren > 0) {
+			keys[nchildren - 1] = (int)pairs[start].key;
+		}
+		children[nchildren++] = tree->off_buckets++;
+	}
+	if (DB_ERROR(bulk_flush(&writer))) {
+		goto errout;
+	}
+
+	/* As with insertions, keys from KEY_MAX lead to no bucket */
+	keys[nchildren - 1] = KEY_MAX;
+	children[nchildren++] = CONFIG_BUCKETS_LIMIT - 1;
+
+	/* Build the levels of nodes up to a single root. The children are
+	 * shared evenly between the nodes of a level, so none of them is
+	 * left with a single child.
+	 */
+	writer.storage = tree->tree_storage;
+	writer.base = base_offset;
+	writer.size = sizeof(tree_node_t);
+	writer.first = 0;
+	writer.count = 0;
+
+	is_leaf = 1;
+	tree->levels = 1;
+	do {
+		nnodes = (nchildren + BULK_NODE_FILL - 1) / BULK_NODE_FILL;
+		if (tree->off_nodes + nnodes > CONFIG_NODE_LIMIT) {
+			DB_LOG_E("TREE FULL !");
+			goto errout;
+		}
+		first = tree->off_nodes;
+		for (k = 0, i = 0; k < nnodes; k++) {
+			count = nchildren / nnodes + (k < nchildren % nnodes);
+			node = bulk_next(&writer);
+			if (node == NULL) {
+				goto errout;
+			}
+			node->is_leaf = is_leaf;
+			node->val[BRANCH_FACTOR - 1] = count - 1;
+			memcpy(node->id, &children[i], count * sizeof(uint16_t));
+			memcpy(node->val, &keys[i], (count - 1) * sizeof(int));
+
+			/* The key before the node moves up to the parent level, and
+			 * the level is rewritten in place as it is read ahead of that.
+			 */
+			if (k > 0) {
+				keys[k - 1] = keys[i - 1];
+			}
+			children[k] = first + k;
+			i += count;
+			tree->off_nodes++;
+		}
+		if (DB_ERROR(bulk_flush(&writer))) {
+			goto errout;
+		}
+		nchildren = nnodes;
+		is_leaf = 0;
+		tree->levels++;
+	} while (nchildren > 1);
+
+	tree->root = children[0];
+	tree->inserted = npairs;
+	tree->deleted = 0;
+	if (DB_ERROR(tree_write_header(tree))) {
+		goto errout;
+	}
+
+	DB_LOG_D("DB: Bulk loaded %lu keys in %d buckets and %d nodes, %d levels\n", (unsigned long)npairs, tree->off_buckets, tree->off_nodes, tree->levels);
+	result = DB_OK;
+
+errout:
+	rw_unlock_write(&(tree->tree_lock));
+	free(children);
+	free(keys);
+	free(writer.buffer);
+	return result;
+}
+
+#ifdef CONFIG_ARASTORAGE_INDEX_WAL
+/****************************************************************************
+ * Name: wal_sum
+ *
+ * Description: FNV-1a checksum of the records and images of the log
+ *
+ ****************************************************************************/
+static uint32_t wal_sum(uint32_t sum, const void *data, size_t size)
+{
+	const uint8_t *ptr = data;
+
+	while (size-- > 0) {
+		sum = (sum ^ *ptr++) * 16777619U;
+	}
+	return sum;
+}
+
+static void wal_seal(tree_t *tree, wal_record_t *record, uint8_t op, int key, uint32_t value)
+{
+	record->epoch = tree->wal_epoch;
+	record->op = op;
+	record->reserved = 0;
+	record->key = key;
+	record->value = value;
+	record->check = wal_sum(WAL_MAGIC, record, offsetof(wal_record_t, check));
+}
+
+/****************************************************************************
+ * Name: wal_read
+ *
+ * Description: Reads a record of the log. The log ends at the first record
+ *              which is torn or left from before the last checkpoint.
+ *
+ ****************************************************************************/
+static bool wal_read(tree_t *tree, wal_record_t *record, unsigned long offset)
+{
+	memset(record, 0, sizeof(wal_record_t));
+	if (DB_ERROR(storage_read_from(tree->wal_storage, record, offset, sizeof(wal_record_t)))) {
+		return false;
+	}
+	return record->epoch == tree->wal_epoch && record->check == wal_sum(WAL_MAGIC, record, offsetof(wal_record_t, check));
+}
+
+/****************************************************************************
+ * Name: wal_begin
+ *
+ * Description: Starts an empty log for the current epoch. The records of
+ *              the previous epochs which follow are not part of the log.
+ *
+ ****************************************************************************/
+static db_result_t wal_begin(tree_t *tree)
+{
+	wal_record_t record;
+
+	wal_seal(tree, &record, WAL_OP_BEGIN, WAL_MAGIC, 0);
+	tree->wal_count = 0;
+	tree->wal_offset = sizeof(record);
+	if (DB_ERROR(storage_write_to(tree->wal_storage, &record, 0, sizeof(record))) || DB_ERROR(storage_fsync(tree->wal_storage))) {
+		DB_LOG_E("DB: Failed to reset the index log\n");
+		return DB_STORAGE_ERROR;
+	}
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: wal_sync_files
+ *
+ * Description: Syncs the tree and bucket files, which must be on storage
+ *              before the log which can write them back again is reset.
+ *
+ ****************************************************************************/
+static db_result_t wal_sync_files(tree_t *tree)
+{
+	if (DB_ERROR(storage_fsync(tree->tree_storage)) || DB_ERROR(storage_fsync(tree->bucket_storage))) {
+		DB_LOG_E("DB: Failed to sync the index files\n");
+		return DB_STORAGE_ERROR;
+	}
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: wal_open
+ *
+ * Description: Opens the log of the index, or creates it for a new index
+ *
+ ****************************************************************************/
+static db_result_t wal_open(tree_t *tree, index_t *index)
+{
+	char filename[DB_MAX_FILENAME_LENGTH];
+	wal_record_t record;
+
+	wal_filename(filename, index);
+	tree->wal_count = 0;
+	tree->wal_replay = 0;
+	tree->wal_epoch = 0;
+	tree->wal_storage = storage_open(filename, O_RDWR);
+	if (tree->wal_storage < 0) {
+		/* The files of an index without log are as of its last release */
+		if (DB_ERROR(storage_generate_file(filename))) {
+			return DB_STORAGE_ERROR;
+		}
+		tree->wal_storage = storage_open(filename, O_RDWR);
+		if (tree->wal_storage < 0) {
+			return DB_STORAGE_ERROR;
+		}
+		return wal_begin(tree);
+	}
+
+	memset(&record, 0, sizeof(record));
+	storage_read_from(tree->wal_storage, &record, 0, sizeof(record));
+	tree->wal_epoch = record.epoch;
+	if (!wal_read(tree, &record, 0) || record.op != WAL_OP_BEGIN) {
+		/* Torn while starting a new log, after the write back completed.
+		 * The new epoch must differ from the one of the records left.
+		 */
+		storage_read_from(tree->wal_storage, &record, sizeof(record), sizeof(record));
+		tree->wal_epoch = record.epoch + 1;
+		return wal_begin(tree);
+	}
+	tree->wal_offset = sizeof(record);
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: wal_flush
+ *
+ * Description: Appends the buffered records to the log and syncs it
+ *
+ ****************************************************************************/
+static db_result_t wal_flush(tree_t *tree)
+{
+	unsigned size = tree->wal_count * sizeof(wal_record_t);
+
+	if (size == 0) {
+		return DB_OK;
+	}
+	tree->wal_count = 0;
+	if (DB_ERROR(storage_write_to(tree->wal_storage, tree->wal_buffer, tree->wal_offset, size)) || DB_ERROR(storage_fsync(tree->wal_storage))) {
+		DB_LOG_E("DB: Failed to write the index log\n");
+		return DB_STORAGE_ERROR;
+	}
+	tree->wal_offset += size;
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: wal_append
+ *
+ * Description: Logs an operation on the index. Records are buffered, those
+ *              not written yet are lost on a crash like the tuples in the
+ *              insert buffer, but the index stays consistent.
+ *
+ ****************************************************************************/
+static void wal_append(tree_t *tree, uint8_t op, int key, tuple_id_t value)
+{
+	if (tree->wal_replay || tree->wal_storage < 0) {
+		return;
+	}
+	wal_seal(tree, &tree->wal_buffer[tree->wal_count++], op, key, value);
+	if (tree->wal_count == WAL_BUFFER_SIZE) {
+		wal_flush(tree);
+	}
+}
+
+static db_result_t wal_write_image(tree_t *tree, uint8_t op, int id, void *image, unsigned size, uint32_t *sum)
+{
+	wal_record_t record;
+
+	wal_seal(tree, &record, op, id, size);
+	if (DB_ERROR(storage_write_to(tree->wal_storage, &record, tree->wal_offset, sizeof(record)))) {
+		return DB_STORAGE_ERROR;
+	}
+	if (DB_ERROR(storage_write_to(tree->wal_storage, image, tree->wal_offset + sizeof(record), size))) {
+		return DB_STORAGE_ERROR;
+	}
+	tree->wal_offset += sizeof(record) + size;
+	*sum = wal_sum(*sum, image, size);
+	return DB_OK;
+}
+
+static int cache_dirty(queue_t *in_cache)
+{
+	qnode_t *iter;
+	int count = 0;
+
+	for (iter = in_cache->head->next; iter != in_cache->tail; iter = iter->next) {
+		if ((iter->node_state & NODE_STATE_DIRTY) && (iter->node_state & NODE_STATE_VALID)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+/****************************************************************************
+ * Name: wal_checkpoint
+ *
+ * Description: Writes back all dirty nodes and buckets of the caches, and
+ *              the tree metadata, then starts an empty log.
+ *              They are logged first, with a commit record at the end, so
+ *              that an interrupted write back is completed from the log at
+ *              the next load. Until the commit record is written, the files
+ *              are as of the previous checkpoint and the logged operations
+ *              are replayed instead.
+ *              The caller holds the tree lock or is the only user.
+ *
+ ****************************************************************************/
+static db_result_t wal_checkpoint(tree_t *tree)
+{
+	wal_record_t record;
+	struct wal_tree_s meta;
+	qnode_t *iter;
+	uint32_t sum = WAL_MAGIC;
+	int count = 0;
+	db_result_t result = DB_STORAGE_ERROR;
+
+	if (tree->wal_storage < 0) {
+		return DB_OK;
+	}
+
+	pthread_mutex_lock(&(tree->node_cache_lock));
+	pthread_mutex_lock(&(tree->buck_cache_lock));
+
+	if (tree->wal_count == 0 && tree->wal_offset == sizeof(wal_record_t) && cache_dirty(&(tree->node_cache->in_cache)) == 0 && cache_dirty(&(tree->buck_cache->in_cache)) == 0) {
+		result = DB_OK;
+		goto out;
+	}
+
+	/* Operations are written first, as they are replayed if this is interrupted */
+	if (DB_ERROR(wal_flush(tree))) {
+		goto out;
+	}
+
+	for (iter = tree->node_cache->in_cache.head->next; iter != tree->node_cache->in_cache.tail; iter = iter->next) {
+		if ((iter->node_state & NODE_STATE_DIRTY) && (iter->node_state & NODE_STATE_VALID)) {
+			if (DB_ERROR(wal_write_image(tree, WAL_OP_NODE, iter->id, &(tree->node_cache->cache_t[iter->pos].node), sizeof(tree_node_t), &sum))) {
+				goto out;
+			}
+			count++;
+		}
+	}
+	for (iter = tree->buck_cache->in_cache.head->next; iter != tree->buck_cache->in_cache.tail; iter = iter->next) {
+		if ((iter->node_state & NODE_STATE_DIRTY) && (iter->node_state & NODE_STATE_VALID)) {
+			if (DB_ERROR(wal_write_image(tree, WAL_OP_BUCKET, iter->id, &(tree->buck_cache->cache_t[iter->pos].bucket), sizeof(bucket_t), &sum))) {
+				goto out;
+			}
+			count++;
+		}
+	}
+	memset(&meta, 0, sizeof(meta));
+	meta.off_nodes = tree->off_nodes;
+	meta.off_buckets = tree->off_buckets;
+	meta.root = tree->root;
+	meta.levels = tree->levels;
+	meta.inserted = tree->inserted;
+	meta.deleted = tree->deleted;
+	if (DB_ERROR(wal_write_image(tree, WAL_OP_TREE, 0, &meta, sizeof(meta), &sum))) {
+		goto out;
+	}
+	count++;
+
+	/* The images are checked against the commit record, one sync covers both */
+	wal_seal(tree, &record, WAL_OP_COMMIT, count, sum);
+	if (DB_ERROR(storage_write_to(tree->wal_storage, &record, tree->wal_offset, sizeof(record))) || DB_ERROR(storage_fsync(tree->wal_storage))) {
+		goto out;
+	}
+	tree->wal_offset += sizeof(record);
+
+	/* Write back, which is done again from the log if interrupted */
+	for (iter = tree->node_cache->in_cache.head->next; iter != tree->node_cache->in_cache.tail; iter = iter->next) {
+		if ((iter->node_state & NODE_STATE_DIRTY) && (iter->node_state & NODE_STATE_VALID)) {
+			tree_write(tree, iter->id, &(tree->node_cache->cache_t[iter->pos].node));
+			UNSET_NODE_STATE(iter, NODE_STATE_DIRTY);
+		}
+	}
+	for (iter = tree->buck_cache->in_cache.head->next; iter != tree->buck_cache->in_cache.tail; iter = iter->next) {
+		if ((iter->node_state & NODE_STATE_DIRTY) && (iter->node_state & NODE_STATE_VALID)) {
+			bucket_write(tree, iter->id, &(tree->buck_cache->cache_t[iter->pos].bucket));
+			UNSET_NODE_STATE(iter, NODE_STATE_DIRTY);
+		}
+	}
+	tree_write_header(tree);
+	if (DB_ERROR(wal_sync_files(tree))) {
+		goto out;
+	}
+
+	tree->wal_epoch++;
+	result = wal_begin(tree);
+
+out:
+	pthread_mutex_unlock(&(tree->buck_cache_lock));
+	pthread_mutex_unlock(&(tree->node_cache_lock));
+	return result;
+}
+
+/****************************************************************************
+ * Name: wal_update
+ *
+ * Description: Called after each operation, makes a checkpoint when the
+ *              log is long enough, or when the caches are so dirty that
+ *              the next operation could not find a clean entry to evict.
+ *              A split dirties up to two nodes per level and two buckets.
+ *
+ ****************************************************************************/
+static void wal_update(tree_t *tree)
+{
+	int nodes;
+	int buckets;
+
+	if (tree->wal_storage < 0 || tree->wal_replay) {
+		return;
+	}
+
+	pthread_mutex_lock(&(tree->node_cache_lock));
+	nodes = cache_dirty(&(tree->node_cache->in_cache));
+	pthread_mutex_unlock(&(tree->node_cache_lock));
+	pthread_mutex_lock(&(tree->buck_cache_lock));
+	buckets = cache_dirty(&(tree->buck_cache->in_cache));
+	pthread_mutex_unlock(&(tree->buck_cache_lock));
+
+	if (tree->wal_offset + tree->wal_count * sizeof(wal_record_t) >= WAL_CHECKPOINT_SIZE || (nodes > 0 && nodes + 2 * tree->levels > DB_TREE_CACHE_LIMIT) || (buckets > 0 && buckets + 3 > DB_HEAP_CACHE_LIMIT)) {
+		wal_checkpoint(tree);
+	}
+}
+
+/****************************************************************************
+ * Name: remove_item_btree
+ *
+ * Description: Removes the pair of a key and tuple, as done by get_next for
+ *              remove queries. Used to replay the log.
+ *
+ ****************************************************************************/
+static void remove_item_btree(tree_t *tree, int key, tuple_id_t value)
+{
+	pair_t *path;
+	bucket_t *bucket;
+	uint16_t bucket_id;
+	uint16_t next_id;
+	int i;
+
+	path = tree_find(tree, key);
+	if (path == NULL) {
+		return;
+	}
+	bucket_id = path[tree->levels].key;
+	tree->lock_buckets[bucket_id] = 0;
+	free(path);
+
+	/* Equal keys may continue in the following buckets */
+	while (bucket_id != (uint16_t)-1) {
+		bucket = bucket_read(tree, bucket_id);
+		if (bucket == NULL) {
+			return;
+		}
+		for (i = 0; i < bucket->next_free_slot; i++) {
+			if (bucket->pairs[i].key == key && bucket->pairs[i].value == value) {
+				bucket->pairs[i] = bucket->pairs[--bucket->next_free_slot];
+				tree->deleted++;
+				modify_cache(tree, bucket_id, BUCKET, DIRTY);
+				modify_cache(tree, bucket_id, BUCKET, UNLOCK);
+				return;
+			}
+		}
+		next_id = next_bucket(tree, bucket);
+		modify_cache(tree, bucket_id, BUCKET, UNLOCK);
+		if (bucket->info[2] > key) {
+			return;
+		}
+		bucket_id = next_id;
+	}
+}
+
+/****************************************************************************
+ * Name: wal_recover
+ *
+ * Description: Brings the index back to its state before a crash. If the
+ *              last checkpoint committed, its images are written back again.
+ *              Otherwise the files are as of the previous checkpoint, and
+ *              the logged operations are replayed then checkpointed.
+ *
+ ****************************************************************************/
+static db_result_t wal_recover(tree_t *tree, index_t *index)
+{
+	union {
+		tree_node_t node;
+		bucket_t bucket;
+		struct wal_tree_s meta;
+	} image;
+	wal_record_t record;
+	unsigned long offset;
+	unsigned long end = 0;
+	uint32_t sum = WAL_MAGIC;
+	int count = 0;
+	bool committed = false;
+
+	/* Find the end of the operations and whether the images committed */
+	for (offset = sizeof(record); wal_read(tree, &record, offset); offset += sizeof(record)) {
+		if (record.op == WAL_OP_COMMIT) {
+			committed = (record.key == count && record.value == sum);
+			break;
+		} else if (record.op >= WAL_OP_NODE && record.op <= WAL_OP_TREE) {
+			if (count == 0) {
+				end = offset;
+			}
+			if (record.value > sizeof(image) || DB_ERROR(storage_read_from(tree->wal_storage, &image, offset + sizeof(record), record.value))) {
+				break;
+			}
+			sum = wal_sum(sum, &image, record.value);
+			count++;
+			offset += record.value;
+		}
+	}
+	if (count == 0) {
+		end = offset;
+	}
+
+	if (end == sizeof(record) && !committed) {
+		return DB_OK;
+	}
+
+	if (committed) {
+		DB_LOG_D("DB: Writing back %d images of the index log\n", count);
+		for (offset = end; wal_read(tree, &record, offset) && record.op != WAL_OP_COMMIT; offset += sizeof(record) + record.value) {
+			if (DB_ERROR(storage_read_from(tree->wal_storage, &image, offset + sizeof(record), record.value))) {
+				return DB_STORAGE_ERROR;
+			}
+			if (record.op == WAL_OP_NODE) {
+				tree_write(tree, record.key, &image.node);
+			} else if (record.op == WAL_OP_BUCKET) {
+				bucket_write(tree, record.key, &image.bucket);
+			} else {
+				tree->off_nodes = image.meta.off_nodes;
+				tree->off_buckets = image.meta.off_buckets;
+				tree->root = image.meta.root;
+				tree->levels = image.meta.levels;
+				tree->inserted = image.meta.inserted;
+				tree->deleted = image.meta.deleted;
+			}
+		}
+		tree_write_header(tree);
+		if (DB_ERROR(wal_sync_files(tree))) {
+			return DB_STORAGE_ERROR;
+		}
+		tree->wal_epoch++;
+		return wal_begin(tree);
+	}
+
+	DB_LOG_D("DB: Replaying %lu operations of the index log\n", (end - sizeof(record)) / sizeof(record));
+	tree->wal_replay = 1;
+	for (offset = sizeof(record); offset < end; offset += sizeof(record)) {
+		wal_read(tree, &record, offset);
+		if (record.op == WAL_OP_INSERT) {
+			if (insert_item_btree(tree, record.key, record.value) != TREE_OK) {
+				DB_LOG_E("DB: Failed to replay the insertion of key %d\n", record.key);
+			}
+		} else if (record.op == WAL_OP_DELETE) {
+			rw_lock_write(&(tree->tree_lock));
+			delete_item_btree(index, record.key);
+		} else if (record.op == WAL_OP_REMOVE) {
+			remove_item_btree(tree, record.key, record.value);
+		}
+	}
+	tree->wal_replay = 0;
+
+	/* Images of an uncommitted checkpoint are overwritten */
+	tree->wal_offset = end;
+	return wal_checkpoint(tree);
+}
+#endif
@@ -56,6 +56,7 @@
  * Included Files
  ****************************************************************************/
 #include <sys/types.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <pthread.h>
@@ -82,6 +83,9 @@ pthread_attr_t g_attr;
  ****************************************************************************/
 static index_api_t *find_index_api(index_type_t index_type);
 db_result_t db_indexing(relation_t*);
+#ifdef CONFIG_ARASTORAGE_INDEX_BULK_LOAD
+static db_result_t db_indexing_sorted(index_t *, relation_t *, int, tuple_id_t);
+#endif
 LIST(indices);
 
 /****************************************************************************
@@ -427,6 +431,81 @@ static index_t *get_next_index_to_load(void)
 	return NULL;
 }
 
+#ifdef CONFIG_ARASTORAGE_INDEX_BULK_LOAD
+static int index_pair_compare(const void *a, const void *b)
+{
+	const index_pair_t *first = a;
+	const index_pair_t *second = b;
+
+	if (first->key != second->key) {
+		return first->key < second->key ? -1 : 1;
+	}
+	return first->tuple_id < second->tuple_id ? -1 : first->tuple_id > second->tuple_id;
+}
+
+/* Read the keys of all rows with their tuple ids, sort them and hand them
+   to the bulk load of the index. */
+static db_result_t db_indexing_sorted(index_t *index, relation_t *rel, int offset, tuple_id_t cardinality)
+{
+	index_pair_t *pairs;
+	storage_row_t rows;
+	attribute_value_t value;
+	tuple_id_t tuple_id;
+	tuple_id_t count;
+	tuple_id_t i;
+	db_result_t result;
+
+	pairs = (index_pair_t *)malloc(sizeof(index_pair_t) * cardinality);
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	rows = (storage_row_t)malloc(rel->row_length * DB_BATCH_ROWS);
+#else
+	rows = (storage_row_t)malloc(rel->row_length + 1);
+#endif
+	if (pairs == NULL || rows == NULL) {
+		free(pairs);
+		free(rows);
+		return DB_ALLOCATION_ERROR;
+	}
+
+	for (tuple_id = 0; tuple_id < cardinality; tuple_id += count) {
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+		count = DB_BATCH_ROWS;
+		result = storage_get_rows(rel, tuple_id, &count, rows);
+		if (result == DB_FINISHED) {
+			break;
+		}
+#else
+		count = 1;
+		result = storage_get_row(rel, &tuple_id, rows);
+#endif
+		if (DB_ERROR(result)) {
+			DB_LOG_E("DB: Failed to get a row in relation %s!\n", rel->name);
+			goto errout;
+		}
+
+		for (i = 0; i < count; i++) {
+			result = db_phy_to_value(&value, index->attr, rows + i * rel->row_length + offset);
+			if (DB_ERROR(result)) {
+				DB_LOG_E("DB: Failed to get value from row\n");
+				goto errout;
+			}
+			pairs[tuple_id + i].key = db_value_to_long(&value);
+			pairs[tuple_id + i].tuple_id = tuple_id + i;
+		}
+	}
+	free(rows);
+	rows = NULL;
+
+	qsort(pairs, tuple_id, sizeof(index_pair_t), index_pair_compare);
+	result = index->api->bulk_load(index, pairs, tuple_id);
+
+errout:
+	free(pairs);
+	free(rows);
+	return result;
+}
+#endif
+
 db_result_t db_indexing(relation_t *rel)
 {
 	index_t *index;
@@ -477,6 +556,24 @@ db_result_t db_indexing(relation_t *rel)
 
 	cardinality = relation_cardinality(rel);
 
+#ifdef CONFIG_ARASTORAGE_INDEX_BULK_LOAD
+	/* Building the index from all keys sorted is much faster than inserting
+	   them one by one. Without the memory for that, fall back to insertions. */
+	if (index->api->bulk_load != NULL) {
+		result = db_indexing_sorted(index, rel, offset, cardinality);
+		if (result != DB_ALLOCATION_ERROR) {
+			free(row);
+			if (DB_ERROR(result)) {
+				DB_LOG_E("DB: Failed to bulk load the index of %s\n", rel->name);
+				return DB_INDEX_ERROR;
+			}
+			DB_LOG_D("DB: Bulk loaded %lu rows into the index\n", cardinality);
+			return DB_OK;
+		}
+		DB_LOG_D("DB: No memory to sort the keys, inserting them one by one\n");
+	}
+#endif
+
 	for (tuple_id = 0; tuple_id < cardinality; tuple_id++) {
 		memset(row, 0, sizeof(char) * rel->row_length + 1);
 		DB_LOG_V("DB: Indexing Tuple id %d\n", tuple_id);
@@ -197,6 +197,192 @@ static lvm_status_t eval_expr(lvm_instance_t *p, operator_t op, operand_t *resul
 	return LVM_TRUE;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/*
+ * The vector versions below walk the same bytecode as eval_expr() and
+ * eval_logic(), but each node is evaluated for up to LVM_VECTOR_SIZE rows
+ * at once.  Variables bound to a column with lvm_set_variable_column()
+ * take one value per row, other operands are the same for all rows.
+ * An arithmetic error only fails the rows in which it occurs, which are
+ * marked in the fault vector.
+ */
+static lvm_status_t eval_vector_expr(lvm_instance_t *p, operator_t op, long *result, uint8_t *fault, unsigned offset, unsigned nrows);
+
+static lvm_status_t eval_vector_operand(lvm_instance_t *p, long *value, uint8_t *fault, unsigned offset, unsigned nrows)
+{
+	unsigned i;
+	long l;
+	node_type_t type;
+	operator_t *operator;
+	operand_t operand;
+
+	type = get_type(p);
+	switch (type) {
+	case LVM_ARITH_OP:
+		operator = get_operator(p);
+		return eval_vector_expr(p, *operator, value, fault, offset, nrows);
+	case LVM_OPERAND:
+		get_operand(p, &operand);
+		if (operand.type == LVM_VARIABLE && p->columns[operand.value.id] != NULL) {
+			memcpy(value, p->columns[operand.value.id] + offset, nrows * sizeof(long));
+		} else {
+			l = operand_to_long(p, &operand);
+			for (i = 0; i < nrows; i++) {
+				value[i] = l;
+			}
+		}
+		return LVM_TRUE;
+	default:
+		return SEMANTIC_ERROR;
+	}
+}
+
+static lvm_status_t eval_vector_expr(lvm_instance_t *p, operator_t op, long *result, uint8_t *fault, unsigned offset, unsigned nrows)
+{
+	unsigned i;
+	long value[LVM_VECTOR_SIZE];
+	lvm_status_t r;
+
+	r = eval_vector_operand(p, result, fault, offset, nrows);
+	if (LVM_ERROR(r)) {
+		return r;
+	}
+	r = eval_vector_operand(p, value, fault, offset, nrows);
+	if (LVM_ERROR(r)) {
+		return r;
+	}
+
+	switch (op) {
+	case LVM_ADD:
+		for (i = 0; i < nrows; i++) {
+			result[i] += value[i];
+		}
+		break;
+	case LVM_SUB:
+		for (i = 0; i < nrows; i++) {
+			result[i] -= value[i];
+		}
+		break;
+	case LVM_MUL:
+		for (i = 0; i < nrows; i++) {
+			result[i] *= value[i];
+		}
+		break;
+	case LVM_DIV:
+		for (i = 0; i < nrows; i++) {
+			if (value[i] == 0) {
+				fault[i] = 1;
+				result[i] = 0;
+			} else {
+				result[i] /= value[i];
+			}
+		}
+		break;
+	default:
+		return EXECUTION_ERROR;
+	}
+
+	return LVM_TRUE;
+}
+
+static lvm_status_t eval_vector_logic(lvm_instance_t *p, operator_t *op, uint8_t *result, uint8_t *fault, unsigned offset, unsigned nrows)
+{
+	unsigned i;
+	node_type_t type;
+	operator_t *operator;
+	lvm_status_t r;
+	uint8_t logic[LVM_VECTOR_SIZE];
+	long l1[LVM_VECTOR_SIZE];
+	long l2[LVM_VECTOR_SIZE];
+
+	if (IS_CONNECTIVE(*op)) {
+		type = get_type(p);
+		if (type != LVM_CMP_OP) {
+			return SEMANTIC_ERROR;
+		}
+		operator = get_operator(p);
+		r = eval_vector_logic(p, operator, result, fault, offset, nrows);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+
+		if (*op == LVM_NOT) {
+			for (i = 0; i < nrows; i++) {
+				result[i] = !result[i];
+			}
+			return LVM_TRUE;
+		}
+
+		type = get_type(p);
+		if (type != LVM_CMP_OP) {
+			return SEMANTIC_ERROR;
+		}
+		operator = get_operator(p);
+		r = eval_vector_logic(p, operator, logic, fault, offset, nrows);
+		if (LVM_ERROR(r)) {
+			return r;
+		}
+
+		if (*op == LVM_AND) {
+			for (i = 0; i < nrows; i++) {
+				result[i] &= logic[i];
+			}
+		} else {
+			for (i = 0; i < nrows; i++) {
+				result[i] |= logic[i];
+			}
+		}
+		return LVM_TRUE;
+	}
+
+	r = eval_vector_operand(p, l1, fault, offset, nrows);
+	if (LVM_ERROR(r)) {
+		return r;
+	}
+	r = eval_vector_operand(p, l2, fault, offset, nrows);
+	if (LVM_ERROR(r)) {
+		return r;
+	}
+
+	switch (*op) {
+	case LVM_EQ:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] == l2[i];
+		}
+		break;
+	case LVM_NEQ:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] != l2[i];
+		}
+		break;
+	case LVM_GE:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] > l2[i];
+		}
+		break;
+	case LVM_GEQ:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] >= l2[i];
+		}
+		break;
+	case LVM_LE:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] < l2[i];
+		}
+		break;
+	case LVM_LEQ:
+		for (i = 0; i < nrows; i++) {
+			result[i] = l1[i] <= l2[i];
+		}
+		break;
+	default:
+		return EXECUTION_ERROR;
+	}
+
+	return LVM_TRUE;
+}
+#endif							/* CONFIG_ARASTORAGE_BATCH_SELECT */
+
 static int eval_logic(lvm_instance_t *p, operator_t *op)
 {
 	int i;
@@ -283,6 +469,9 @@ void lvm_reset(lvm_instance_t *p)
 	memset(p->code, 0, sizeof(p->code));
 	memset(p->variables, 0, sizeof(p->variables));
 	memset(p->derivations, 0, sizeof(p->derivations));
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	memset(p->columns, 0, sizeof(p->columns));
+#endif
 }
 
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p)
@@ -378,6 +567,51 @@ lvm_status_t lvm_execute(lvm_instance_t *p)
 	return status;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/*
+ * Evaluate the predicate for nrows rows.  match[i] is set to 1 for the
+ * rows for which the predicate is true, and to 0 for the others, including
+ * the rows in which the evaluation failed.
+ */
+lvm_status_t lvm_execute_batch(lvm_instance_t *p, uint8_t *match, unsigned nrows)
+{
+	unsigned i;
+	unsigned offset;
+	unsigned n;
+	node_type_t type;
+	operator_t *operator;
+	lvm_status_t status;
+	uint8_t fault[LVM_VECTOR_SIZE];
+
+	for (offset = 0; offset < nrows; offset += n) {
+		n = nrows - offset < LVM_VECTOR_SIZE ? nrows - offset : LVM_VECTOR_SIZE;
+		memset(fault, 0, n);
+
+		p->ip = 0;
+		type = get_type(p);
+		if (type != LVM_CMP_OP) {
+			DB_LOG_E("Error: The code must start with a relational operator\n");
+			return EXECUTION_ERROR;
+		}
+
+		operator = get_operator(p);
+		status = eval_vector_logic(p, operator, match + offset, fault, offset, n);
+		if (LVM_ERROR(status)) {
+			DB_LOG_E("Execution error: %d\n", (int)status);
+			return status;
+		}
+
+		for (i = 0; i < n; i++) {
+			if (fault[i]) {
+				match[offset + i] = 0;
+			}
+		}
+	}
+
+	return LVM_TRUE;
+}
+#endif							/* CONFIG_ARASTORAGE_BATCH_SELECT */
+
 lvm_status_t lvm_set_op(lvm_instance_t *p, operator_t op)
 {
 	lvm_status_t result;
@@ -485,6 +719,24 @@ lvm_status_t lvm_set_variable_value(lvm_instance_t *p, char *name, operand_value
 	return LVM_TRUE;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/*
+ * Bind the variable to a vector of values, one for each row evaluated by
+ * lvm_execute_batch().  A NULL column unbinds the variable.
+ */
+lvm_status_t lvm_set_variable_column(lvm_instance_t *p, char *name, long *column)
+{
+	variable_id_t id;
+
+	id = lookup(p, name);
+	if (id == LVM_MAX_VARIABLE_ID) {
+		return INVALID_IDENTIFIER;
+	}
+	p->columns[id] = column;
+	return LVM_TRUE;
+}
+#endif							/* CONFIG_ARASTORAGE_BATCH_SELECT */
+
 lvm_status_t lvm_set_variable(lvm_instance_t *p, char *name)
 {
 	operand_t op;
@@ -156,6 +156,9 @@ struct lvm_instance_s {
 	unsigned char code[DB_VM_BYTECODE_SIZE];
 	variable_t variables[LVM_MAX_VARIABLE_ID];
 	derivation_t derivations[LVM_MAX_VARIABLE_ID];
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	long *columns[LVM_MAX_VARIABLE_ID];
+#endif
 	lvm_ip_t end;
 	lvm_ip_t ip;
 	unsigned error;
@@ -171,6 +174,10 @@ lvm_status_t lvm_derive(lvm_instance_t *p);
 lvm_status_t lvm_get_derived_range(lvm_instance_t *p, char *name, operand_value_t *min, operand_value_t *max);
 void lvm_print_derivations(lvm_instance_t *p);
 lvm_status_t lvm_execute(lvm_instance_t *p);
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+lvm_status_t lvm_execute_batch(lvm_instance_t *p, uint8_t *match, unsigned nrows);
+lvm_status_t lvm_set_variable_column(lvm_instance_t *p, char *name, long *column);
+#endif
 lvm_status_t lvm_register_variable(lvm_instance_t *p, char *name, operand_type_t type);
 void lvm_print_code(lvm_instance_t *p);
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p);
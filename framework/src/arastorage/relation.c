@@ -842,6 +842,95 @@ int db_processing_status(db_handle_t *handle)
 	return handle->flags & DB_HANDLE_FLAG_PROCESSING;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/* Process the next block of tuples of a selection without an index and
+   aggregators. The tuples are read with a single storage access, the
+   values used by the predicate are gathered into a column for each
+   attribute, and the predicate is evaluated over the columns at once. */
+static db_result_t relation_process_select_batch(db_handle_t *handle, db_cursor_t *cursor)
+{
+	db_result_t result;
+	unsigned attribute_count;
+	unsigned i;
+	unsigned k;
+	tuple_id_t start;
+	tuple_id_t count;
+	source_dest_map_t *attr_map_ptr;
+	unsigned char *from_ptr;
+	long *column;
+	uint8_t match[DB_BATCH_ROWS];
+
+	attribute_count = handle->result_rel->attribute_count;
+
+	if (handle->rows == NULL) {
+		handle->rows = (storage_row_t)malloc(handle->rel->row_length * DB_BATCH_ROWS);
+		handle->columns = (long *)malloc(sizeof(long) * attribute_count * DB_BATCH_ROWS);
+		if (handle->rows == NULL || handle->columns == NULL) {
+			/* Nothing is kept, so that the next call allocates both again */
+			DB_LOG_E("DB: Failed to allocate rows\n");
+			free(handle->rows);
+			free(handle->columns);
+			handle->rows = NULL;
+			handle->columns = NULL;
+			return DB_ALLOCATION_ERROR;
+		}
+
+		if (handle->lvm_instance != NULL) {
+			for (k = 0; k < attribute_count; k++) {
+				lvm_set_variable_column(handle->lvm_instance, handle->attr_map[k].from_attr->name, handle->columns + k * DB_BATCH_ROWS);
+			}
+		}
+	}
+
+	start = handle->tuple_id + 1;
+	count = DB_BATCH_ROWS;
+	result = storage_get_rows(handle->rel, start, &count, handle->rows);
+	if (DB_ERROR(result)) {
+		DB_LOG_E("DB: Failed to get rows in relation %s!\n", handle->rel->name);
+		return result;
+	} else if (result == DB_FINISHED) {
+		return DB_FINISHED;
+	}
+
+	if (handle->lvm_instance == NULL) {
+		memset(match, 1, count);
+	} else {
+		for (k = 0, attr_map_ptr = handle->attr_map; k < attribute_count; k++, attr_map_ptr++) {
+			column = handle->columns + k * DB_BATCH_ROWS;
+			from_ptr = handle->rows + attr_map_ptr->from_offset;
+
+			if (attr_map_ptr->from_attr->domain == DOMAIN_INT) {
+				for (i = 0; i < count; i++, from_ptr += handle->rel->row_length) {
+					column[i] = from_ptr[0] << 8 | from_ptr[1];
+				}
+			} else if (attr_map_ptr->from_attr->domain == DOMAIN_LONG) {
+				for (i = 0; i < count; i++, from_ptr += handle->rel->row_length) {
+					column[i] = (uint32_t)from_ptr[0] << 24 | (uint32_t)from_ptr[1] << 16 | (uint32_t)from_ptr[2] << 8 | from_ptr[3];
+				}
+			}
+		}
+
+		if (lvm_execute_batch(handle->lvm_instance, match, count) != LVM_TRUE) {
+			memset(match, 0, count);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		if (match[i]) {
+			handle->current_row++;
+			result = cursor_data_add(cursor, start + i);
+			if (DB_ERROR(result)) {
+				return result;
+			}
+		}
+	}
+
+	handle->tuple_id = start + count - 1;
+
+	return DB_OK;
+}
+#endif
+
 db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 {
 	db_result_t result;
@@ -861,6 +950,12 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		return DB_ALLOCATION_ERROR;
 	}
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	if (!((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX) && !((*handle)->adt_flags & AQL_FLAG_AGGREGATE)) {
+		return relation_process_select_batch(*handle, cursor);
+	}
+#endif
+
 	result_row = (*handle)->tuple;
 	attribute_count = (*handle)->result_rel->attribute_count;
 	attr_map_end = (*handle)->attr_map + attribute_count;
@@ -909,7 +1004,7 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 		from_ptr = row + attr_map_ptr->from_offset;
 		from_attr = attr_map_ptr->from_attr;
 
-		if (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG) {
+		if ((*handle)->lvm_instance != NULL && (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG)) {
 			lvm_set_operand_value((*handle)->lvm_instance, from_attr, from_ptr);
 		}
 
@@ -1036,7 +1131,7 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 		from_ptr = row + attr_map_ptr->from_offset;
 		from_attr = attr_map_ptr->from_attr;
 
-		if (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG) {
+		if ((*handle)->lvm_instance != NULL && (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG)) {
 			lvm_set_operand_value((*handle)->lvm_instance, from_attr, from_ptr);
 		}
 
@@ -163,6 +163,12 @@ struct _db_cursor_s {
 	char name[TUPLE_NAME_LENGTH + 1];
 	char rel_name[RELATION_NAME_LENGTH + 1];
 	cursor_data_map_t attr_map[AQL_ATTRIBUTE_LIMIT];
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	unsigned char *rows;
+	tuple_id_t cache_first;
+	tuple_id_t cache_rows;
+	tuple_id_t cache_size;
+#endif
 };
 
 /****************************************************************************
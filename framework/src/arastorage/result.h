@@ -107,6 +107,10 @@ struct _db_handle_s {
 	uint8_t ncolumns;
 	void *lvm_instance;
 	source_dest_map_t *attr_map;
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+	storage_row_t rows;
+	long *columns;
+#endif
 };
 
 /****************************************************************************
@@ -115,6 +119,8 @@ struct _db_handle_s {
 db_result_t db_get_value(attribute_value_t *value, db_handle_t *handle, unsigned col);
 db_result_t db_phy_to_value(attribute_value_t *value, attribute_t *attr, unsigned char *ptr);
 db_result_t db_value_to_phy(unsigned char *ptr, attribute_t *attr, attribute_value_t *value);
+db_result_t cursor_data_set(db_cursor_t *cursor, source_dest_map_t *attr_map, attribute_id_t attribute_count);
+db_result_t cursor_get_value_storage(attribute_value_t *value, db_cursor_t *cursor, unsigned col);
 
 #endif              /* !RESULT_H */
 long db_value_to_long(attribute_value_t *value);
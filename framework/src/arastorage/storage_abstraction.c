@@ -122,6 +122,15 @@ ssize_t storage_write(db_storage_id_t fd, void *buffer, unsigned length)
 	return write(fd, buffer, length);
 }
 
+/* It mapped with fsync function in specific file system */
+db_result_t storage_fsync(db_storage_id_t fd)
+{
+	if (fsync(fd) != OK) {
+		return DB_STORAGE_ERROR;
+	}
+	return DB_OK;
+}
+
 #ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
 ssize_t storage_get_availbyte_size(void)
 {
@@ -532,6 +532,45 @@ db_result_t storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t
 	return DB_OK;
 }
 
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+/* Read up to *count rows from tuple_id on with a single read. *count is
+   updated to the number of rows read. */
+db_result_t storage_get_rows(relation_t *rel, tuple_id_t tuple_id, tuple_id_t *count, storage_row_t rows)
+{
+	ssize_t r;
+	tuple_id_t nrows;
+
+	if (DB_ERROR(storage_get_row_amount(rel, &nrows))) {
+		return DB_STORAGE_ERROR;
+	}
+
+	if (tuple_id >= nrows) {
+		DB_LOG_D("DB : tuple_id : %d nrows : %d\n", tuple_id, nrows);
+		return DB_FINISHED;
+	}
+
+	if (*count > nrows - tuple_id) {
+		*count = nrows - tuple_id;
+	}
+
+	if (storage_seek(rel->tuple_storage, tuple_id * rel->row_length, SEEK_SET) == (off_t)-1) {
+		return DB_STORAGE_ERROR;
+	}
+
+	r = storage_read(rel->tuple_storage, rows, *count * rel->row_length);
+	if (r < 0) {
+		DB_LOG_E("DB: Reading failed on fd %d\n", rel->tuple_storage);
+		return DB_STORAGE_ERROR;
+	} else if (r < *count * rel->row_length) {
+		DB_LOG_E("DB: Incomplete records: %d < %d\n", r, *count * rel->row_length);
+		return DB_STORAGE_ERROR;
+	}
+
+	DB_LOG_D("DB: Read %d rows from relation %s\n", *count, rel->name);
+	return DB_OK;
+}
+#endif
+
 db_result_t storage_put_row(relation_t *rel, storage_row_t row, uint8_t flag)
 {
 	db_result_t result;
@@ -27,6 +27,9 @@
 #include "ui_commons_internal.h"
 #include "ui_request_callback.h"
 #include "ui_debug.h"
+#if defined(CONFIG_UI_GLYPH_CACHE)
+#include "ui_glyph_cache.h"
+#endif
 
 #define STB_TRUETYPE_IMPLEMENTATION 
 #include <stb/stb_truetype.h>
@@ -175,6 +178,10 @@ static void _ui_font_asset_destroy_func(void *userdata)
 
 	body = (ui_font_asset_body_t *)userdata;
 
+#if defined(CONFIG_UI_GLYPH_CACHE)
+	ui_glyph_cache_remove_font(body);
+#endif
+
 	UI_FREE(body->ttf_buf);
 	UI_FREE(body);
 }
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ * Copyright 2019 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <stb/stb_truetype.h>
+#include <araui/ui_commons.h>
+#include <araui/ui_asset.h>
+#include "ui_debug.h"
+#include "ui_asset_internal.h"
+#include "ui_glyph_cache.h"
+
+#define UI_GLYPH_CACHE_BUCKETS (64)
+#define UI_GLYPH_CACHE_HASH(font, size, code) \
+	((((uint32_t)(code) * 2654435761u) ^ ((uint32_t)(size) << 8) ^ ((uint32_t)(uintptr_t)(font) >> 4)) & (UI_GLYPH_CACHE_BUCKETS - 1))
+
+typedef struct {
+	ui_glyph_t *buckets[UI_GLYPH_CACHE_BUCKETS];
+	ui_glyph_t *lru_head;	//!< Most recently used
+	ui_glyph_t *lru_tail;	//!< Least recently used, evicted first
+	ui_glyph_cache_info_t info;
+} ui_glyph_cache_t;
+
+static ui_glyph_cache_t g_glyph_cache = {
+	.info = {
+		.size = CONFIG_UI_GLYPH_CACHE_SIZE
+	}
+};
+
+static void _ui_glyph_cache_lru_unlink(ui_glyph_t *glyph)
+{
+	if (glyph->lru_prev) {
+		glyph->lru_prev->lru_next = glyph->lru_next;
+	} else {
+		g_glyph_cache.lru_head = glyph->lru_next;
+	}
+
+	if (glyph->lru_next) {
+		glyph->lru_next->lru_prev = glyph->lru_prev;
+	} else {
+		g_glyph_cache.lru_tail = glyph->lru_prev;
+	}
+}
+
+static void _ui_glyph_cache_lru_push(ui_glyph_t *glyph)
+{
+	glyph->lru_prev = UI_NULL;
+	glyph->lru_next = g_glyph_cache.lru_head;
+
+	if (g_glyph_cache.lru_head) {
+		g_glyph_cache.lru_head->lru_prev = glyph;
+	} else {
+		g_glyph_cache.lru_tail = glyph;
+	}
+	g_glyph_cache.lru_head = glyph;
+}
+
+static void _ui_glyph_cache_remove(ui_glyph_t *glyph)
+{
+	ui_glyph_t **link;
+
+	link = &g_glyph_cache.buckets[UI_GLYPH_CACHE_HASH(glyph->font, glyph->font_size, glyph->utf_code)];
+	while (*link != glyph) {
+		link = &(*link)->hash_next;
+	}
+	*link = glyph->hash_next;
+
+	_ui_glyph_cache_lru_unlink(glyph);
+
+	g_glyph_cache.info.used -= sizeof(ui_glyph_t) + (glyph->width * glyph->height);
+	g_glyph_cache.info.glyph_num--;
+
+	UI_FREE(glyph);
+}
+
+ui_glyph_t *ui_glyph_cache_get(ui_font_asset_body_t *font, size_t font_size, uint32_t utf_code)
+{
+	ui_glyph_t *glyph;
+	uint32_t hash;
+	size_t glyph_size;
+	float scale;
+	int c_x1;
+	int c_y1;
+	int c_x2;
+	int c_y2;
+
+	if (!font) {
+		return UI_NULL;
+	}
+
+	hash = UI_GLYPH_CACHE_HASH(font, font_size, utf_code);
+
+	for (glyph = g_glyph_cache.buckets[hash]; glyph; glyph = glyph->hash_next) {
+		if (glyph->font == font && glyph->font_size == font_size && glyph->utf_code == utf_code) {
+			if (glyph != g_glyph_cache.lru_head) {
+				_ui_glyph_cache_lru_unlink(glyph);
+				_ui_glyph_cache_lru_push(glyph);
+			}
+			g_glyph_cache.info.hit++;
+			return glyph;
+		}
+	}
+
+	g_glyph_cache.info.miss++;
+
+	scale = stbtt_ScaleForPixelHeight(&font->ttf_info, font_size);
+	stbtt_GetCodepointBitmapBox(&font->ttf_info, utf_code, scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
+
+	glyph_size = sizeof(ui_glyph_t) + ((c_x2 - c_x1) * (c_y2 - c_y1));
+	if (glyph_size > CONFIG_UI_GLYPH_CACHE_SIZE) {
+		return UI_NULL;
+	}
+
+	while (g_glyph_cache.lru_tail && g_glyph_cache.info.used + glyph_size > CONFIG_UI_GLYPH_CACHE_SIZE) {
+		_ui_glyph_cache_remove(g_glyph_cache.lru_tail);
+		g_glyph_cache.info.eviction++;
+	}
+
+	// The bitmap follows the glyph in the same allocation
+	glyph = (ui_glyph_t *)UI_ALLOC(glyph_size);
+	if (!glyph) {
+		UI_LOGE("error: out of memory!\n");
+		return UI_NULL;
+	}
+
+	glyph->font = font;
+	glyph->font_size = font_size;
+	glyph->utf_code = utf_code;
+	glyph->y_offset = c_y1;
+	glyph->width = c_x2 - c_x1;
+	glyph->height = c_y2 - c_y1;
+	glyph->bitmap = (uint8_t *)(glyph + 1);
+
+	if (glyph->width > 0 && glyph->height > 0) {
+		stbtt_MakeCodepointBitmap(&font->ttf_info, glyph->bitmap,
+			glyph->width, glyph->height, glyph->width,
+			scale, scale, utf_code);
+	}
+
+	glyph->hash_next = g_glyph_cache.buckets[hash];
+	g_glyph_cache.buckets[hash] = glyph;
+	_ui_glyph_cache_lru_push(glyph);
+
+	g_glyph_cache.info.used += glyph_size;
+	g_glyph_cache.info.glyph_num++;
+
+	return glyph;
+}
+
+void ui_glyph_cache_remove_font(ui_font_asset_body_t *font)
+{
+	ui_glyph_t *glyph;
+	ui_glyph_t *next;
+
+	for (glyph = g_glyph_cache.lru_head; glyph; glyph = next) {
+		next = glyph->lru_next;
+		if (glyph->font == font) {
+			_ui_glyph_cache_remove(glyph);
+		}
+	}
+}
+
+void ui_glyph_cache_clear(void)
+{
+	while (g_glyph_cache.lru_tail) {
+		_ui_glyph_cache_remove(g_glyph_cache.lru_tail);
+	}
+}
+
+ui_error_t ui_font_asset_get_glyph_cache_info(ui_glyph_cache_info_t *info)
+{
+	if (!info) {
+		return UI_INVALID_PARAM;
+	}
+
+	*info = g_glyph_cache.info;
+
+	return UI_OK;
+}
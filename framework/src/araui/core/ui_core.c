@@ -21,6 +21,7 @@
 #endif
 
 #include <tinyara/config.h>
+#include <tinyara/compiler.h>
 #include <sys/types.h>
 #include <pthread.h>
 #include <string.h>
@@ -46,6 +47,10 @@
 #include "utils/emoji.h"
 #endif
 
+#if defined(CONFIG_UI_GLYPH_CACHE)
+#include "ui_glyph_cache.h"
+#endif
+
 #define UI_CORE_THREAD_NAME "UI Core Service"
 #define CONFIG_UI_GLOBAL_X_THRESHOLD     20
 #define CONFIG_UI_GLOBAL_Y_THRESHOLD     20
@@ -181,6 +186,10 @@ ui_error_t ui_stop(void)
 		return UI_OPERATION_FAIL;
 	}
 
+#if defined(CONFIG_UI_GLYPH_CACHE)
+	ui_glyph_cache_clear();
+#endif
+
 	if (ui_request_callback_deinit() != UI_OK) {
 		UI_LOGE("ui_request_callback_deinit failed.\n");
 		return UI_OPERATION_FAIL;
@@ -292,10 +301,14 @@ static ui_error_t _ui_render_widget(ui_widget_body_t *widget, ui_rect_t draw_are
 		if (curr_widget->visible) {
 			if (curr_widget->render_cb) {
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
+				// Skip the widget outside of the tile, but not its children
+				// which may be placed anywhere.
 				new_vp = ui_rect_intersect(draw_area, curr_widget->global_rect);
-				ui_dal_set_viewport(new_vp.x, new_vp.y, new_vp.width, new_vp.height);
-				curr_widget->render_cb((ui_widget_t)curr_widget, dt);
-				ui_dal_set_viewport(draw_area.x, draw_area.y, draw_area.width, draw_area.height);
+				if (new_vp.width > 0 && new_vp.height > 0) {
+					ui_dal_set_viewport(new_vp.x, new_vp.y, new_vp.width, new_vp.height);
+					ui_renderer_set_clip_rect(new_vp);
+					curr_widget->render_cb((ui_widget_t)curr_widget, dt);
+				}
 #else
 				curr_widget->render_cb((ui_widget_t)curr_widget, dt);
 #endif
@@ -307,6 +320,11 @@ static ui_error_t _ui_render_widget(ui_widget_body_t *widget, ui_rect_t draw_are
 		}
 	}
 
+#if defined(CONFIG_UI_PARTIAL_UPDATE)
+	ui_dal_set_viewport(draw_area.x, draw_area.y, draw_area.width, draw_area.height);
+	ui_renderer_set_clip_rect(draw_area);
+#endif
+
 	return UI_OK;
 }
 
@@ -327,10 +345,23 @@ static void _ui_call_anim_finished_cb(void *userdata)
 	}
 }
 
+#if defined(CONFIG_UI_PARTIAL_UPDATE)
+/* Default for the DAL implementations which only provide ui_dal_redraw() */
+UI_DAL weak_function void ui_dal_redraw_rects(const ui_rect_t *rects, int num)
+{
+	int idx;
+
+	for (idx = 0; idx < num; idx++) {
+		ui_dal_redraw(rects[idx].x, rects[idx].y, rects[idx].width, rects[idx].height);
+	}
+}
+#endif
+
 static void _ui_redraw(uint32_t dt)
 {
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
-	ui_rect_t *redraw_rect;
+	ui_rect_t *redraw_list;
+	int redraw_num;
 	int iter;
 #else
 	ui_rect_t redraw_rect;
@@ -338,19 +369,26 @@ static void _ui_redraw(uint32_t dt)
 	ui_window_body_t *window;
 
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
-	vec_foreach(ui_window_get_redraw_list(), redraw_rect, iter) {
-		window = ui_window_get_current();
+	redraw_list = ui_window_get_redraw_list(&redraw_num);
+	if (redraw_num == 0) {
+		return;
+	}
+
+	window = ui_window_get_current();
+
+	// Compose every tile first, then flush all of them at once.
+	for (iter = 0; iter < redraw_num; iter++) {
 		if (window) {
-			_ui_render_widget(window->root, *redraw_rect, dt);
+			_ui_render_widget(window->root, redraw_list[iter], dt);
 		}
 
 		if (_ui_core_quick_panel_visible()) {
-			_ui_render_widget(g_quick_panel_info[g_core.visible_event_type], *redraw_rect, dt);
+			_ui_render_widget(g_quick_panel_info[g_core.visible_event_type], redraw_list[iter], dt);
 		}
+	}
 
-		if (window || _ui_core_quick_panel_visible()) {
-			ui_dal_redraw(redraw_rect->x, redraw_rect->y, redraw_rect->width, redraw_rect->height);
-		}
+	if (window || _ui_core_quick_panel_visible()) {
+		ui_dal_redraw_rects(redraw_list, redraw_num);
 	}
 
 	ui_window_redraw_list_clear();
@@ -17,6 +17,7 @@
  ****************************************************************************/
 
 #include <tinyara/config.h>
+#include <stdint.h>
 #include <string.h>
 #include <pthread.h>
 #include <araui/ui_widget.h>
@@ -31,16 +32,12 @@
 static vec_void_t g_window_list;
 static ui_window_body_t *g_current_window = UI_NULL;
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
-static vec_void_t g_window_redraw_list;
-static ui_rect_t g_rect_mempool[CONFIG_UI_UPDATE_MEMPOOL_SIZE];
-static int g_rect_mempool_idx = 0;
+static ui_rect_t g_window_redraw_list[CONFIG_UI_REDRAW_TILE_NUM];
+static int g_window_redraw_num = 0;
 #endif
 
 static void _ui_window_create_func(void *userdata);
 static void _ui_window_destroy_func(void *userdata);
-#if defined(CONFIG_UI_PARTIAL_UPDATE)
-static ui_rect_t *_ui_window_get_mempool_rect(void);
-#endif
 
 ui_error_t ui_window_list_init(void)
 {
@@ -65,14 +62,14 @@ ui_error_t ui_window_list_deinit(void)
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
 ui_error_t ui_window_redraw_list_init(void)
 {
-	vec_init(&g_window_redraw_list);
+	g_window_redraw_num = 0;
 
 	return UI_OK;
 }
 
 ui_error_t ui_window_redraw_list_deinit(void)
 {
-	vec_deinit(&g_window_redraw_list);
+	g_window_redraw_num = 0;
 
 	return UI_OK;
 }
@@ -249,18 +246,57 @@ ui_error_t ui_window_add_widget(ui_window_t window, ui_widget_t widget, int32_t
 }
 
 #if defined(CONFIG_UI_PARTIAL_UPDATE)
-vec_void_t *ui_window_get_redraw_list(void)
+static int32_t _ui_window_rect_area(ui_rect_t rect)
+{
+	return rect.width * rect.height;
+}
+
+/**
+ * @brief Check whether two rects overlap or share an edge,
+ * so that their union doesn't cover any pixel outside of them along that edge.
+ */
+static bool _ui_window_rect_touch(ui_rect_t r1, ui_rect_t r2)
+{
+	return (r1.x <= r2.x + r2.width) && (r2.x <= r1.x + r1.width) &&
+		(r1.y <= r2.y + r2.height) && (r2.y <= r1.y + r1.height);
+}
+
+static bool _ui_window_rect_contain(ui_rect_t outer, ui_rect_t inner)
+{
+	return (outer.x <= inner.x) && (outer.y <= inner.y) &&
+		(outer.x + outer.width >= inner.x + inner.width) &&
+		(outer.y + outer.height >= inner.y + inner.height);
+}
+
+static void _ui_window_redraw_list_remove(int idx)
 {
-	return &g_window_redraw_list;
+	g_window_redraw_num--;
+	g_window_redraw_list[idx] = g_window_redraw_list[g_window_redraw_num];
 }
 
+ui_rect_t *ui_window_get_redraw_list(int *num)
+{
+	*num = g_window_redraw_num;
+
+	return g_window_redraw_list;
+}
+
+/**
+ * @brief Add a dirty area to the redraw tiles.
+ *
+ * The area is clipped by the screen and merged with every tile it overlaps
+ * or touches, until it is disjoint from all the others. If all the tiles are
+ * in use, it is merged with the tile which grows the least by the merge.
+ * So the tiles never overlap and their number is bounded, no widget
+ * is rendered twice for the same pixel and only few flushes are made.
+ */
 ui_error_t ui_window_add_redraw_list(ui_rect_t redraw_rect)
 {
-	ui_rect_t *window;
-	ui_rect_t *new_area;
-	ui_rect_t previous;
-	ui_rect_t ret;
-	int iter;
+	ui_rect_t merged;
+	int32_t waste;
+	int32_t min_waste;
+	int min_idx;
+	int idx;
 
 	if (redraw_rect.x < 0) {
 		redraw_rect.width += redraw_rect.x;
@@ -276,75 +312,65 @@ ui_error_t ui_window_add_redraw_list(ui_rect_t redraw_rect)
 		return UI_OK;
 	}
 
-	if (redraw_rect.width <= 0 || redraw_rect.height <= 0) {
-		return UI_OK;
+	if (redraw_rect.x + redraw_rect.width >= CONFIG_UI_DISPLAY_WIDTH) {
+		redraw_rect.width = CONFIG_UI_DISPLAY_WIDTH - redraw_rect.x;
 	}
-
-	new_area = _ui_window_get_mempool_rect();
-
-	new_area->x = redraw_rect.x;
-	new_area->y = redraw_rect.y;
-	new_area->width = redraw_rect.width;
-	new_area->height = redraw_rect.height;
-
-	if (new_area->x + new_area->width >= CONFIG_UI_DISPLAY_WIDTH) {
-		new_area->width = CONFIG_UI_DISPLAY_WIDTH - new_area->x;
+	if (redraw_rect.y + redraw_rect.height >= CONFIG_UI_DISPLAY_HEIGHT) {
+		redraw_rect.height = CONFIG_UI_DISPLAY_HEIGHT - redraw_rect.y;
 	}
-	if (new_area->y + new_area->height >= CONFIG_UI_DISPLAY_HEIGHT) {
-		new_area->height = CONFIG_UI_DISPLAY_HEIGHT - new_area->y;
+
+	if (redraw_rect.width <= 0 || redraw_rect.height <= 0) {
+		return UI_OK;
 	}
 
-	vec_foreach(&g_window_redraw_list, window, iter) {
-		// window is whole screen case
-		if ((window->x == 0) && (window->y == 0) &&
-			(window->width == CONFIG_UI_DISPLAY_WIDTH) &&
-			(window->height == CONFIG_UI_DISPLAY_HEIGHT)) {
+	idx = 0;
+	while (idx < g_window_redraw_num) {
+		if (_ui_window_rect_contain(g_window_redraw_list[idx], redraw_rect)) {
 			return UI_OK;
 		}
 
-		previous.x = window->x;
-		previous.y = window->y;
-		previous.width = window->width;
-		previous.height = window->height;
-
-		ret = ui_rect_intersect(previous, *new_area);
-		if (ret.x == 0 && ret.y == 0 && ret.width == 0 && ret.height == 0) {
+		if (!_ui_window_rect_touch(g_window_redraw_list[idx], redraw_rect)) {
+			idx++;
 			continue;
 		}
 
-		ret = ui_get_contain_rect(previous, *new_area);
-		new_area->x = ret.x;
-		new_area->y = ret.y;
-		new_area->width = ret.width;
-		new_area->height = ret.height;
+		// The grown area may touch the tiles already checked, start over
+		redraw_rect = ui_get_contain_rect(g_window_redraw_list[idx], redraw_rect);
+		_ui_window_redraw_list_remove(idx);
+		idx = 0;
+	}
+
+	if (g_window_redraw_num == CONFIG_UI_REDRAW_TILE_NUM) {
+		min_idx = 0;
+		min_waste = INT32_MAX;
+
+		for (idx = 0; idx < g_window_redraw_num; idx++) {
+			merged = ui_get_contain_rect(g_window_redraw_list[idx], redraw_rect);
+			waste = _ui_window_rect_area(merged) - _ui_window_rect_area(g_window_redraw_list[idx]);
+			if (waste < min_waste) {
+				min_waste = waste;
+				min_idx = idx;
+			}
+		}
+
+		redraw_rect = ui_get_contain_rect(g_window_redraw_list[min_idx], redraw_rect);
+		_ui_window_redraw_list_remove(min_idx);
 
-		vec_remove(&g_window_redraw_list, window);
-		iter--;
+		// The merged tile may now overlap the others
+		return ui_window_add_redraw_list(redraw_rect);
 	}
 
-	vec_push(&g_window_redraw_list, new_area);
+	g_window_redraw_list[g_window_redraw_num++] = redraw_rect;
 
 	return UI_OK;
 }
 
 ui_error_t ui_window_redraw_list_clear(void)
 {
-	vec_clear(&g_window_redraw_list);
+	g_window_redraw_num = 0;
 
 	return UI_OK;
 }
-
-static ui_rect_t *_ui_window_get_mempool_rect(void)
-{
-	int alloc_idx = g_rect_mempool_idx;
-
-	g_rect_mempool_idx++;
-	if (g_rect_mempool_idx >= CONFIG_UI_UPDATE_MEMPOOL_SIZE) {
-		g_rect_mempool_idx = 0;
-	}
-
-	return &g_rect_mempool[alloc_idx];
-}
 #endif // CONFIG_UI_PARTIAL_UPDATE
 
 ui_window_body_t *ui_window_get_current(void)
@@ -63,6 +63,26 @@ UI_DAL ui_error_t ui_dal_deinit(void);
  */
 UI_DAL void ui_dal_redraw(int32_t x, int32_t y, int32_t width, int32_t height);
 
+#if defined(CONFIG_UI_PARTIAL_UPDATE)
+
+/**
+ * @brief ui_dal_redraw_rects()
+ *
+ * Redraw several rectangular regions of the screen at once.
+ * It is called once per frame with all the regions updated in that frame,
+ * so that the transfers to the display can be batched.
+ * The regions never overlap each other.
+ * Implementing it is optional, the default calls ui_dal_redraw() for each
+ * region.
+ *
+ * @param[in] rects Array of the rectangular regions to redraw
+ * @param[in] num Number of the rectangular regions
+ *
+ */
+UI_DAL void ui_dal_redraw_rects(const ui_rect_t *rects, int num);
+
+#endif // CONFIG_UI_PARTIAL_UPDATE
+
 /**
  * @brief ui_dal_clear()
  *
@@ -0,0 +1,76 @@
+/****************************************************************************
+ *
+ * Copyright 2019 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __UI_GLYPH_CACHE_H__
+#define __UI_GLYPH_CACHE_H__
+
+#include <tinyara/config.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <araui/ui_asset.h>
+#include "ui_asset_internal.h"
+
+/**
+ * @brief Rasterized glyph of a font at a size, as an A8 bitmap.
+ * y_offset is the offset of the top of the bitmap from the baseline.
+ */
+typedef struct ui_glyph_s ui_glyph_t;
+
+struct ui_glyph_s {
+	ui_font_asset_body_t *font;
+	size_t font_size;
+	uint32_t utf_code;
+
+	int32_t y_offset;
+	int32_t width;
+	int32_t height;
+	uint8_t *bitmap;
+
+	ui_glyph_t *hash_next;
+	ui_glyph_t *lru_prev;
+	ui_glyph_t *lru_next;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get the glyph of the code from the cache, rasterizing it on a miss.
+ * The least recently used glyphs are evicted to stay in CONFIG_UI_GLYPH_CACHE_SIZE.
+ * The glyph is valid until the next call.
+ *
+ * @return The glyph, or NULL if it can't be cached. Then the caller has to rasterize it.
+ */
+ui_glyph_t *ui_glyph_cache_get(ui_font_asset_body_t *font, size_t font_size, uint32_t utf_code);
+
+/**
+ * @brief Drop all glyphs of the font, before it is destroyed.
+ */
+void ui_glyph_cache_remove_font(ui_font_asset_body_t *font);
+
+/**
+ * @brief Drop all glyphs.
+ */
+void ui_glyph_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
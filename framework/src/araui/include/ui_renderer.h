@@ -75,6 +75,7 @@ void ui_renderer_rotate(ui_mat3_t *mat, int32_t deg);
 void ui_renderer_scale(ui_mat3_t *mat, float x, float y);
 void ui_renderer_set_texture(uint8_t *bitmap, int32_t width, int32_t height, ui_pixel_format_t pf);
 void ui_renderer_set_fill_color(ui_color_t color);
+void ui_renderer_set_clip_rect(ui_rect_t clip);
 
 /**
  * @brief Rendering geometry functions
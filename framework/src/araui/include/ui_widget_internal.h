@@ -125,6 +125,15 @@ typedef struct {
 	ui_uv_t uv[4]; // top-left, bottom-left, bottom-right, top-right
 } ui_image_widget_body_t;
 
+/**
+ * @brief Position of a glyph in the text widget, relative to the widget.
+ */
+typedef struct {
+	int32_t x;
+	int32_t y;
+	uint32_t utf_code;
+} ui_text_layout_t;
+
 typedef struct {
 	ui_widget_body_t base;
 	ui_font_asset_body_t *font;
@@ -136,6 +145,14 @@ typedef struct {
 	size_t line_num;
 	ui_align_t align;
 	bool word_wrap;
+
+	// Glyph positions kept between frames, rebuilt when the text or its size changes
+	ui_text_layout_t *layout;
+	size_t layout_num;
+	int32_t layout_ascent;
+	int32_t layout_width;
+	int32_t layout_height;
+	bool layout_dirty;
 } ui_text_widget_body_t;
 
 typedef struct {
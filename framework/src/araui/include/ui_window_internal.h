@@ -53,7 +53,7 @@ ui_error_t ui_window_list_deinit(void);
 ui_error_t ui_window_redraw_list_init(void);
 ui_error_t ui_window_redraw_list_deinit(void);
 
-vec_void_t *ui_window_get_redraw_list(void);
+ui_rect_t *ui_window_get_redraw_list(int *num);
 ui_error_t ui_window_add_redraw_list(ui_rect_t update);
 ui_error_t ui_window_redraw_list_clear(void);
 #endif
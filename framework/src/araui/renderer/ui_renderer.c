@@ -40,10 +40,18 @@
 
 #define CONFIG_UI_DEFAULT_FILL_COLOR 0x000000
 
+#define UI_FIXED_SHIFT (16)
+#define UI_FIXED_ONE (1 << UI_FIXED_SHIFT)
+
 /****************************************************************************
  * Private function declaration
  ****************************************************************************/
 static void ui_draw_triangle_segment(int32_t y1, int32_t y2);
+#if defined(CONFIG_UI_RENDERER_FAST_BLIT)
+static bool ui_render_quad_blit(ui_mat3_t *trans_mat,
+	ui_vec3_t v1, ui_vec3_t v2, ui_vec3_t v3, ui_vec3_t v4,
+	ui_uv_t uv1, ui_uv_t uv2, ui_uv_t uv3, ui_uv_t uv4);
+#endif
 
 /****************************************************************************
  * Private types
@@ -54,15 +62,28 @@ typedef struct {
 	int32_t           tex_height;
 	ui_pixel_format_t tex_pf;
 	ui_color_t        fill_color;
+	ui_rect_t         clip;
 } ui_render_context_t;
 
+/**
+ * @brief Pixels of a blit along one axis, with the texel of the first pixel
+ * and the texel step per pixel in 16.16 fixed-point.
+ */
+typedef struct {
+	int32_t start;
+	int32_t count;
+	int32_t tex;
+	int32_t step;
+} ui_blit_axis_t;
+
 //!< Render context (global instance)
 ui_render_context_t g_rc = {
 	.texture = NULL,
 	.tex_width = 0,
 	.tex_height = 0,
 	.tex_pf = UI_PIXEL_FORMAT_UNKNOWN,
-	.fill_color = CONFIG_UI_DEFAULT_FILL_COLOR
+	.fill_color = CONFIG_UI_DEFAULT_FILL_COLOR,
+	.clip = { 0, 0, CONFIG_UI_DISPLAY_WIDTH, CONFIG_UI_DISPLAY_HEIGHT }
 };
 
 float g_left_dxdy;
@@ -190,6 +211,11 @@ void ui_renderer_set_fill_color(ui_color_t color)
 	g_rc.fill_color = color;
 }
 
+void ui_renderer_set_clip_rect(ui_rect_t clip)
+{
+	g_rc.clip = clip;
+}
+
 void ui_render_triangle_uv(ui_mat3_t *trans_mat,
 	ui_vec3_t v1, ui_vec3_t v2, ui_vec3_t v3,
 	ui_uv_t uv1, ui_uv_t uv2, ui_uv_t uv3)
@@ -395,6 +421,12 @@ void ui_render_quad_uv(ui_mat3_t *trans_mat,
 	ui_vec3_t v1, ui_vec3_t v2, ui_vec3_t v3, ui_vec3_t v4,
 	ui_uv_t uv1, ui_uv_t uv2, ui_uv_t uv3, ui_uv_t uv4)
 {
+#if defined(CONFIG_UI_RENDERER_FAST_BLIT)
+	if (ui_render_quad_blit(trans_mat, v1, v2, v3, v4, uv1, uv2, uv3, uv4)) {
+		return;
+	}
+#endif
+
 	ui_render_triangle_uv(trans_mat, v1, v2, v3, uv1, uv2, uv3);
 	ui_render_triangle_uv(trans_mat, v1, v3, v4, uv1, uv3, uv4);
 }
@@ -402,6 +434,38 @@ void ui_render_quad_uv(ui_mat3_t *trans_mat,
 /****************************************************************************
  * Private function implementation
  ****************************************************************************/
+
+/**
+ * @brief Put the texel (iu, iv) of the current texture to the pixel (x, y).
+ * Fully transparent texels are skipped, and opaque ones are put without blending.
+ */
+static inline void ui_put_texel(int32_t x, int32_t y, int32_t iu, int32_t iv)
+{
+	uint8_t *texel;
+
+	if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGBA8888) {
+		texel = &g_rc.texture[((iv * g_rc.tex_width) + iu) * 4];
+		if (texel[3] == 0xff) {
+			ui_dal_put_pixel_rgb888(x, y, UI_COLOR_RGB888(texel[0], texel[1], texel[2]));
+		} else if (texel[3]) {
+			ui_dal_put_pixel_rgba8888(x, y, UI_COLOR_RGBA8888(texel[0], texel[1], texel[2], texel[3]));
+		}
+	} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGB888) {
+		texel = &g_rc.texture[((iv * g_rc.tex_width) + iu) * 3];
+		ui_dal_put_pixel_rgb888(x, y, UI_COLOR_RGB888(texel[0], texel[1], texel[2]));
+	} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_A8) {
+		texel = &g_rc.texture[(iv * g_rc.tex_width) + iu];
+		if (*texel) {
+			ui_dal_put_pixel_rgba8888(x, y, UI_COLOR_RGBA8888(
+				(g_rc.fill_color & 0xff0000) >> 16,
+				(g_rc.fill_color & 0x00ff00) >> 8,
+				(g_rc.fill_color & 0x0000ff) >> 0,
+				*texel
+			));
+		}
+	}
+}
+
 static void ui_draw_triangle_segment(int32_t y1, int32_t y2)
 {
 	float u;
@@ -421,9 +485,12 @@ static void ui_draw_triangle_segment(int32_t y1, int32_t y2)
 	int32_t x2;
 	int32_t y;
 	int32_t x;
-	int32_t iu;
-	int32_t iv;
-	int32_t uv_offset;
+	int64_t tex_w;
+	int64_t tex_h;
+
+	// U and V are in [0, 1] as 16.16, texels are rounded in fixed-point
+	tex_w = g_rc.tex_width - 1;
+	tex_h = g_rc.tex_height - 1;
 
 	for (y = y1; y < y2; y++) {
 
@@ -459,33 +526,9 @@ static void ui_draw_triangle_segment(int32_t y1, int32_t y2)
 			x = UI_SUB_DIVIDE_SIZE;
 
 			while (x--) {
-				iu = (int32_t)((U / 65536.0f) * (g_rc.tex_width - 1) + 0.5f);
-				iv = (int32_t)((V / 65536.0f) * (g_rc.tex_height - 1) + 0.5f);
-
-				if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGBA8888) {
-					uv_offset = ((iv * g_rc.tex_width) + iu) * 4;
-					ui_dal_put_pixel_rgba8888(x1++, y, UI_COLOR_RGBA8888(
-						g_rc.texture[uv_offset + 0],
-						g_rc.texture[uv_offset + 1],
-						g_rc.texture[uv_offset + 2],
-						g_rc.texture[uv_offset + 3]
-					));
-				} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGB888) {
-					uv_offset = ((iv * g_rc.tex_width) + iu) * 3;
-					ui_dal_put_pixel_rgb888(x1++, y, UI_COLOR_RGB888(
-						g_rc.texture[uv_offset + 0],
-						g_rc.texture[uv_offset + 1],
-						g_rc.texture[uv_offset + 2]
-					));
-				} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_A8) {
-					uv_offset = ((iv * g_rc.tex_width) + iu);
-					ui_dal_put_pixel_rgba8888(x1++, y, UI_COLOR_RGBA8888(
-						(g_rc.fill_color & 0xff0000) >> 16,
-						(g_rc.fill_color & 0x00ff00) >> 8,
-						(g_rc.fill_color & 0x0000ff) >> 0,
-						g_rc.texture[uv_offset]
-					));
-				}
+				ui_put_texel(x1++, y,
+					(int32_t)((U * tex_w + (UI_FIXED_ONE >> 1)) >> UI_FIXED_SHIFT),
+					(int32_t)((V * tex_h + (UI_FIXED_ONE >> 1)) >> UI_FIXED_SHIFT));
 
 				U += du;
 				V += dv;
@@ -513,33 +556,9 @@ static void ui_draw_triangle_segment(int32_t y1, int32_t y2)
 			V = V1;
 
 			while (width--) {
-				iu = (int32_t)((U / 65536.0f) * (g_rc.tex_width - 1) + 0.5f);
-				iv = (int32_t)((V / 65536.0f) * (g_rc.tex_height - 1) + 0.5f);
-
-				if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGBA8888) {
-					uv_offset = ((iv * g_rc.tex_width) + iu) * 4;
-					ui_dal_put_pixel_rgba8888(x1++, y, UI_COLOR_RGBA8888(
-						g_rc.texture[uv_offset + 0],
-						g_rc.texture[uv_offset + 1],
-						g_rc.texture[uv_offset + 2],
-						g_rc.texture[uv_offset + 3]
-					));
-				} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_RGB888) {
-					uv_offset = ((iv * g_rc.tex_width) + iu) * 3;
-					ui_dal_put_pixel_rgb888(x1++, y, UI_COLOR_RGB888(
-						g_rc.texture[uv_offset + 0],
-						g_rc.texture[uv_offset + 1],
-						g_rc.texture[uv_offset + 2]
-					));
-				} else if (g_rc.tex_pf == UI_PIXEL_FORMAT_A8) {
-					uv_offset = ((iv * g_rc.tex_width) + iu);
-					ui_dal_put_pixel_rgba8888(x1++, y, UI_COLOR_RGBA8888(
-						(g_rc.fill_color & 0xff0000) >> 16,
-						(g_rc.fill_color & 0x00ff00) >> 8,
-						(g_rc.fill_color & 0x0000ff) >> 0,
-						g_rc.texture[uv_offset]
-					));
-				}
+				ui_put_texel(x1++, y,
+					(int32_t)((U * tex_w + (UI_FIXED_ONE >> 1)) >> UI_FIXED_SHIFT),
+					(int32_t)((V * tex_h + (UI_FIXED_ONE >> 1)) >> UI_FIXED_SHIFT));
 
 				U += du;
 				V += dv;
@@ -554,3 +573,210 @@ static void ui_draw_triangle_segment(int32_t y1, int32_t y2)
 	}
 }
 
+#if defined(CONFIG_UI_RENDERER_FAST_BLIT)
+
+static int32_t ui_blit_clamp(int64_t tex, int32_t tex_size)
+{
+	if (tex < 0) {
+		return 0;
+	}
+	if (tex >= ((int64_t)tex_size << UI_FIXED_SHIFT)) {
+		return (tex_size << UI_FIXED_SHIFT) - 1;
+	}
+
+	return (int32_t)tex;
+}
+
+/**
+ * @brief Set up one axis of a blit from the edges p1 and p2 mapped to the
+ * texture coordinates t1 and t2, clipped by [clip_start, clip_end).
+ *
+ * The pixels covered are the same as the ones of the triangle rasterizer:
+ * pixel p is drawn for ceil(p1) <= p < ceil(p2).  It samples the texel at
+ * round(t * (tex_size - 1)), which can be one texel off from the one of the
+ * rasterizer, as the latter steps its coordinates in subdivided spans.
+ *
+ * @return false if no pixel is covered.
+ */
+static bool ui_blit_axis(float p1, float p2, float t1, float t2, int32_t tex_size,
+	int32_t clip_start, int32_t clip_end, ui_blit_axis_t *axis)
+{
+	float scale;
+	int32_t end;
+	int32_t last;
+
+	if (p1 > p2) {
+		UI_SWAP(p1, p2);
+		UI_SWAP(t1, t2);
+	}
+
+	axis->start = (int32_t)ceilf(p1);
+	end = (int32_t)ceilf(p2);
+	if (axis->start == end) {
+		return false;
+	}
+
+	scale = (t2 - t1) * (tex_size - 1) / (p2 - p1);
+
+	axis->start = UI_MAX(axis->start, clip_start);
+	end = UI_MIN(end, clip_end);
+	if (axis->start >= end) {
+		return false;
+	}
+
+	axis->count = end - axis->start;
+	axis->tex = (int32_t)((t1 * (tex_size - 1) + 0.5f + (axis->start - p1) * scale) * UI_FIXED_ONE);
+	axis->step = (int32_t)(scale * UI_FIXED_ONE);
+
+	// Keep the first and the last samples inside of the texture,
+	// the ones between them follow.
+	last = ui_blit_clamp((int64_t)axis->tex + (int64_t)(axis->count - 1) * axis->step, tex_size);
+	axis->tex = ui_blit_clamp(axis->tex, tex_size);
+	if (axis->count > 1) {
+		axis->step = (last - axis->tex) / (axis->count - 1);
+	}
+
+	return true;
+}
+
+static void ui_blit_rgba8888(ui_blit_axis_t *ax, ui_blit_axis_t *ay)
+{
+	uint8_t *row;
+	uint8_t *texel;
+	int32_t x;
+	int32_t y;
+	int32_t U;
+	int32_t V;
+	int32_t n;
+
+	for (y = ay->start, V = ay->tex; y < ay->start + ay->count; y++, V += ay->step) {
+		row = &g_rc.texture[(V >> UI_FIXED_SHIFT) * g_rc.tex_width * 4];
+		for (x = ax->start, U = ax->tex, n = ax->count; n > 0; n--, x++, U += ax->step) {
+			texel = &row[(U >> UI_FIXED_SHIFT) * 4];
+			if (texel[3] == 0xff) {
+				ui_dal_put_pixel_rgb888(x, y, UI_COLOR_RGB888(texel[0], texel[1], texel[2]));
+			} else if (texel[3]) {
+				ui_dal_put_pixel_rgba8888(x, y, UI_COLOR_RGBA8888(texel[0], texel[1], texel[2], texel[3]));
+			}
+		}
+	}
+}
+
+static void ui_blit_rgb888(ui_blit_axis_t *ax, ui_blit_axis_t *ay)
+{
+	uint8_t *row;
+	uint8_t *texel;
+	int32_t x;
+	int32_t y;
+	int32_t U;
+	int32_t V;
+	int32_t n;
+
+	for (y = ay->start, V = ay->tex; y < ay->start + ay->count; y++, V += ay->step) {
+		row = &g_rc.texture[(V >> UI_FIXED_SHIFT) * g_rc.tex_width * 3];
+		for (x = ax->start, U = ax->tex, n = ax->count; n > 0; n--, x++, U += ax->step) {
+			texel = &row[(U >> UI_FIXED_SHIFT) * 3];
+			ui_dal_put_pixel_rgb888(x, y, UI_COLOR_RGB888(texel[0], texel[1], texel[2]));
+		}
+	}
+}
+
+static void ui_blit_a8(ui_blit_axis_t *ax, ui_blit_axis_t *ay)
+{
+	uint8_t *row;
+	ui_color_t color;
+	int32_t x;
+	int32_t y;
+	int32_t U;
+	int32_t V;
+	int32_t n;
+	uint8_t a;
+
+	color = UI_COLOR_RGBA8888(
+		(g_rc.fill_color & 0xff0000) >> 16,
+		(g_rc.fill_color & 0x00ff00) >> 8,
+		(g_rc.fill_color & 0x0000ff) >> 0,
+		0);
+
+	for (y = ay->start, V = ay->tex; y < ay->start + ay->count; y++, V += ay->step) {
+		row = &g_rc.texture[(V >> UI_FIXED_SHIFT) * g_rc.tex_width];
+		for (x = ax->start, U = ax->tex, n = ax->count; n > 0; n--, x++, U += ax->step) {
+			a = row[U >> UI_FIXED_SHIFT];
+			if (a) {
+				ui_dal_put_pixel_rgba8888(x, y, color | ((ui_color_t)a << 24));
+			}
+		}
+	}
+}
+
+/**
+ * @brief Render an axis-aligned textured quad without the triangle setup.
+ *
+ * Images and glyphs are mostly drawn with a translation or a scale only.
+ * In that case the quad is a rectangle on the screen, and each row is a span
+ * of the same texels stepped in fixed-point, clipped by the clip rect.
+ *
+ * @return false if the quad is rotated, skewed or not textured,
+ * then it has to be rendered as triangles.
+ */
+static bool ui_render_quad_blit(ui_mat3_t *trans_mat,
+	ui_vec3_t v1, ui_vec3_t v2, ui_vec3_t v3, ui_vec3_t v4,
+	ui_uv_t uv1, ui_uv_t uv2, ui_uv_t uv3, ui_uv_t uv4)
+{
+	ui_blit_axis_t ax;
+	ui_blit_axis_t ay;
+
+	if (!g_rc.texture) {
+		return false;
+	}
+
+	// Translation and scale only
+	if (trans_mat->m[0][1] != 0.0f || trans_mat->m[1][0] != 0.0f ||
+		trans_mat->m[2][0] != 0.0f || trans_mat->m[2][1] != 0.0f || trans_mat->m[2][2] != 1.0f) {
+		return false;
+	}
+
+	// Rectangle of v1 (top-left), v2 (bottom-left), v3 (bottom-right), v4 (top-right),
+	// with the texture mapped along its edges.
+	if (v1.x != v2.x || v3.x != v4.x || v1.y != v4.y || v2.y != v3.y ||
+		uv1.u != uv2.u || uv3.u != uv4.u || uv1.v != uv4.v || uv2.v != uv3.v ||
+		v1.w != 1.0f || v2.w != 1.0f || v3.w != 1.0f || v4.w != 1.0f) {
+		return false;
+	}
+
+	if (g_rc.tex_pf != UI_PIXEL_FORMAT_RGBA8888 && g_rc.tex_pf != UI_PIXEL_FORMAT_RGB888 &&
+		g_rc.tex_pf != UI_PIXEL_FORMAT_A8) {
+		return false;
+	}
+
+	if (!ui_blit_axis(trans_mat->m[0][0] * v1.x + trans_mat->m[0][2], trans_mat->m[0][0] * v3.x + trans_mat->m[0][2],
+		uv1.u, uv3.u, g_rc.tex_width, g_rc.clip.x, g_rc.clip.x + g_rc.clip.width, &ax)) {
+		return true;
+	}
+
+	if (!ui_blit_axis(trans_mat->m[1][1] * v1.y + trans_mat->m[1][2], trans_mat->m[1][1] * v2.y + trans_mat->m[1][2],
+		uv1.v, uv2.v, g_rc.tex_height, g_rc.clip.y, g_rc.clip.y + g_rc.clip.height, &ay)) {
+		return true;
+	}
+
+	switch (g_rc.tex_pf) {
+	case UI_PIXEL_FORMAT_RGBA8888:
+		ui_blit_rgba8888(&ax, &ay);
+		break;
+
+	case UI_PIXEL_FORMAT_RGB888:
+		ui_blit_rgb888(&ax, &ay);
+		break;
+
+	case UI_PIXEL_FORMAT_A8:
+		ui_blit_a8(&ax, &ay);
+		break;
+
+	default:
+		break;
+	}
+
+	return true;
+}
+
+#endif // CONFIG_UI_RENDERER_FAST_BLIT
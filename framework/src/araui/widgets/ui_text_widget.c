@@ -37,6 +37,9 @@
 #if defined(CONFIG_UI_ENABLE_EMOJI)
 #include "utils/emoji.h"
 #endif
+#if defined(CONFIG_UI_GLYPH_CACHE)
+#include "ui_glyph_cache.h"
+#endif
 
 typedef struct {
 	ui_text_widget_body_t *body;
@@ -118,6 +121,7 @@ ui_widget_t ui_text_widget_create(int32_t width, int32_t height, ui_asset_t font
 	}
 
 	body->align = UI_ALIGN_DEFAULT;
+	body->layout_dirty = true;
 
 	// Fill the color variable by 0xff for white color
 	memset(&body->font_color, 0xff, sizeof(body->font_color));
@@ -322,6 +326,8 @@ static void _ui_text_widget_set_text_func(void *userdata)
 
 	UI_FREE(body->utf_code);
 	UI_FREE(body->width_array);
+	UI_FREE(body->layout);
+	body->layout = NULL;
 
 	if (_ui_text_widget_text2utf(body, text) != UI_OK) {
 		UI_LOGE("error: out of memory!\n");
@@ -330,6 +336,7 @@ static void _ui_text_widget_set_text_func(void *userdata)
 		return;
 	}
 
+	body->layout_dirty = true;
 	body->base.update_flag = true;
 
 	UI_FREE(info->text);
@@ -378,6 +385,7 @@ static void _ui_text_widget_set_align_func(void *userdata)
 	info = (ui_set_align_info_t *)userdata;
 
 	info->body->align = info->align;
+	info->body->layout_dirty = true;
 	info->body->base.update_flag = true;
 
 	UI_FREE(info);
@@ -426,61 +434,30 @@ static void _ui_text_widget_set_color(void *userdata)
 	UI_FREE(info);
 }
 
-static void _ui_text_widget_render_func(ui_widget_t widget, uint32_t dt)
+static ui_error_t _ui_text_widget_build_layout(ui_text_widget_body_t *body)
 {
-	ui_text_widget_body_t *body;
 	float scale;
 	int ascent;
 	int i;
-	int c_x1;
-	int c_y1;
-	int c_x2;
-	int c_y2;
-	int out_w;
-	int out_h;
-	int x;
-	int y;
+	int32_t x;
+	int32_t y;
 	int32_t text_width;
 	size_t utf_idx = 0;
 	size_t draw_idx = 0;
-#if defined(CONFIG_UI_DISPLAY_RGB888)
-	uint8_t r = 0;
-	uint8_t g = 0;
-	uint8_t b = 0;
-	uint8_t a = 0;
-#endif
-	ui_vec3_t v1;
-	ui_vec3_t v2;
-	ui_vec3_t v3;
-	ui_vec3_t v4;
-	ui_mat3_t text_mat;
 
-#if defined(CONFIG_UI_ENABLE_EMOJI)
-	ui_bitmap_data_t *emoji_bitmap;
-	ui_vec3_t emoji_v1;
-	ui_vec3_t emoji_v2;
-	ui_vec3_t emoji_v3;
-	ui_vec3_t emoji_v4;
-#endif
-
-	if (!widget) {
-		UI_LOGE("error: Invalid Parameter!\n");
-		return;
-	}
-
-	body = (ui_text_widget_body_t *)widget;
-
-	if (!body->text_length) {
-		UI_LOGD("Empty text widget!\n");
-		return;
+	if (!body->layout) {
+		body->layout = (ui_text_layout_t *)UI_ALLOC(body->text_length * sizeof(ui_text_layout_t));
+		if (!body->layout) {
+			return UI_NOT_ENOUGH_MEMORY;
+		}
 	}
 
-	memset(g_glyph_bitmap, 0, CONFIG_UI_GLYPH_BITMAP_WIDTH * CONFIG_UI_GLYPH_BITMAP_HEIGHT);
+	body->layout_num = 0;
 
 	scale = stbtt_ScaleForPixelHeight(&(body->font->ttf_info), body->font_size);
 
 	stbtt_GetFontVMetrics(&(body->font->ttf_info), &ascent, NULL, NULL);
-	ascent *= scale;
+	body->layout_ascent = ascent * scale;
 
 	x = 0;
 	y = 0;
@@ -525,95 +502,22 @@ static void _ui_text_widget_render_func(ui_widget_t widget, uint32_t dt)
 			x = (body->base.global_rect.width - text_width);
 		}
 
-#if defined(CONFIG_UI_DISPLAY_RGB888)
-		a = ((ui_color_argb8888_t *)&(body->font_color))->a;
-		r = ((ui_color_argb8888_t *)&(body->font_color))->r;
-		g = ((ui_color_argb8888_t *)&(body->font_color))->g;
-		b = ((ui_color_argb8888_t *)&(body->font_color))->b;
-#endif
-
 		while (draw_idx < utf_idx) {
 			if (body->utf_code[draw_idx] == '\n') {
 				draw_idx++;
 				continue;
 			}
 
+			body->layout[body->layout_num].x = x;
+			body->layout[body->layout_num].y = y;
+			body->layout[body->layout_num].utf_code = body->utf_code[draw_idx];
+			body->layout_num++;
+
 #if defined(CONFIG_UI_ENABLE_EMOJI)
-			// If the code is emoji
 			if (is_emoji(body->utf_code[draw_idx])) {
-				emoji_bitmap = emoji_get_bitmap(body->utf_code[draw_idx]);
-				if (emoji_bitmap) {
-					ui_renderer_set_texture(
-						((uint8_t *)emoji_bitmap) + sizeof(ui_bitmap_data_t),
-						emoji_bitmap->width,
-						emoji_bitmap->height,
-						emoji_bitmap->pf);
-
-						emoji_v1 = (ui_vec3_t){ .x = x - body->base.global_rect.x, .y = y - body->base.global_rect.y, .w = 1.0f };
-						emoji_v2 = (ui_vec3_t){ .x = x - body->base.global_rect.x, .y = y - body->base.global_rect.y + body->font_size, .w = 1.0f };
-						emoji_v3 = (ui_vec3_t){ .x = x - body->base.global_rect.x + body->font_size, .y = y - body->base.global_rect.y + body->font_size, .w = 1.0f };
-						emoji_v4 = (ui_vec3_t){ .x = x - body->base.global_rect.x + body->font_size, .y = y - body->base.global_rect.y, .w = 1.0f };
-
-						ui_render_quad_uv(&body->base.trans_mat, emoji_v1, emoji_v2, emoji_v3, emoji_v4,
-							(ui_uv_t){ 0.0f, 0.0f },
-							(ui_uv_t){ 0.0f, 1.0f },
-							(ui_uv_t){ 1.0f, 1.0f },
-							(ui_uv_t){ 1.0f, 0.0f });
-
-						ui_renderer_set_texture(NULL, 0, 0, UI_PIXEL_FORMAT_UNKNOWN);
-				}
 				x += body->font_size;
 			} else {
 #endif
-				/* get bounding box for character (may be offset to account for chars that dip above or below the line */
-				stbtt_GetCodepointBitmapBox(&(body->font->ttf_info), body->utf_code[draw_idx],
-					scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
-
-				out_w = c_x2 - c_x1;
-				out_h = c_y2 - c_y1;
-
-				/* render character (stride and offset is important here) */
-				stbtt_MakeCodepointBitmap(&(body->font->ttf_info), g_glyph_bitmap,
-					out_w, out_h,
-					out_w,
-					scale, scale,
-					body->utf_code[draw_idx]);
-
-				ui_renderer_translate(&body->base.trans_mat, &text_mat, (float)x, (float)(y + ascent + c_y1));
-				ui_renderer_set_texture(g_glyph_bitmap, out_w, out_h, UI_PIXEL_FORMAT_A8);
-				ui_renderer_set_fill_color(body->font_color);
-
-				v1 = (ui_vec3_t){
-					.x = 0.0f,
-					.y = 0.0f,
-					1.0f
-				};
-				v2 = (ui_vec3_t){
-					.x = 0.0f,
-					.y = out_h,
-					1.0f
-				};
-				v3 = (ui_vec3_t){
-					.x = out_w,
-					.y = out_h,
-					1.0f
-				};
-				v4 = (ui_vec3_t){
-					.x = out_w,
-					.y = 0.0f,
-					1.0f
-				};
-
-				ui_render_quad_uv(&text_mat, v1, v2, v3, v4,
-							(ui_uv_t){ 0.0f, 0.0f },
-							(ui_uv_t){ 0.0f, 1.0f },
-							(ui_uv_t){ 1.0f, 1.0f },
-							(ui_uv_t){ 1.0f, 0.0f });
-
-				ui_renderer_set_texture(NULL, 0, 0, UI_PIXEL_FORMAT_UNKNOWN);
-				ui_renderer_set_fill_color(CONFIG_UI_DEFAULT_FILL_COLOR);
-				memset(g_glyph_bitmap, 0, out_w * out_h);
-
 				x += body->width_array[draw_idx];
 #if defined(CONFIG_UI_ENABLE_EMOJI)
 			}
@@ -623,6 +527,153 @@ static void _ui_text_widget_render_func(ui_widget_t widget, uint32_t dt)
 
 		y += body->font_size;
 	}
+
+	body->layout_width = body->base.global_rect.width;
+	body->layout_height = body->base.global_rect.height;
+	body->layout_dirty = false;
+
+	return UI_OK;
+}
+
+static void _ui_text_widget_render_glyph(ui_text_widget_body_t *body, ui_text_layout_t *pos)
+{
+	float scale;
+	int c_x1;
+	int c_y1;
+	int c_x2;
+	int c_y2;
+	int out_w;
+	int out_h;
+	uint8_t *bitmap;
+	ui_mat3_t text_mat;
+#if defined(CONFIG_UI_GLYPH_CACHE)
+	ui_glyph_t *glyph;
+
+	glyph = ui_glyph_cache_get(body->font, body->font_size, pos->utf_code);
+	if (glyph) {
+		c_y1 = glyph->y_offset;
+		out_w = glyph->width;
+		out_h = glyph->height;
+		bitmap = glyph->bitmap;
+	} else {
+#endif
+		/* get bounding box for character (may be offset to account for chars that dip above or below the line */
+		scale = stbtt_ScaleForPixelHeight(&(body->font->ttf_info), body->font_size);
+		stbtt_GetCodepointBitmapBox(&(body->font->ttf_info), pos->utf_code,
+			scale, scale, &c_x1, &c_y1, &c_x2, &c_y2);
+
+		out_w = c_x2 - c_x1;
+		out_h = c_y2 - c_y1;
+
+		if (out_w > CONFIG_UI_GLYPH_BITMAP_WIDTH || out_h > CONFIG_UI_GLYPH_BITMAP_HEIGHT) {
+			UI_LOGE("error: glyph is too large!\n");
+			return;
+		}
+
+		/* render character (stride and offset is important here) */
+		memset(g_glyph_bitmap, 0, out_w * out_h);
+		stbtt_MakeCodepointBitmap(&(body->font->ttf_info), g_glyph_bitmap,
+			out_w, out_h,
+			out_w,
+			scale, scale,
+			pos->utf_code);
+		bitmap = g_glyph_bitmap;
+#if defined(CONFIG_UI_GLYPH_CACHE)
+	}
+#endif
+
+	if (out_w <= 0 || out_h <= 0) {
+		return;
+	}
+
+	ui_renderer_translate(&body->base.trans_mat, &text_mat, (float)pos->x, (float)(pos->y + body->layout_ascent + c_y1));
+	ui_renderer_set_texture(bitmap, out_w, out_h, UI_PIXEL_FORMAT_A8);
+
+	ui_render_quad_uv(&text_mat,
+		(ui_vec3_t){ 0.0f, 0.0f, 1.0f },
+		(ui_vec3_t){ 0.0f, out_h, 1.0f },
+		(ui_vec3_t){ out_w, out_h, 1.0f },
+		(ui_vec3_t){ out_w, 0.0f, 1.0f },
+		(ui_uv_t){ 0.0f, 0.0f },
+		(ui_uv_t){ 0.0f, 1.0f },
+		(ui_uv_t){ 1.0f, 1.0f },
+		(ui_uv_t){ 1.0f, 0.0f });
+
+	ui_renderer_set_texture(NULL, 0, 0, UI_PIXEL_FORMAT_UNKNOWN);
+}
+
+static void _ui_text_widget_render_func(ui_widget_t widget, uint32_t dt)
+{
+	ui_text_widget_body_t *body;
+	ui_text_layout_t *pos;
+	size_t idx;
+#if defined(CONFIG_UI_ENABLE_EMOJI)
+	ui_bitmap_data_t *emoji_bitmap;
+	ui_vec3_t emoji_v1;
+	ui_vec3_t emoji_v2;
+	ui_vec3_t emoji_v3;
+	ui_vec3_t emoji_v4;
+#endif
+
+	if (!widget) {
+		UI_LOGE("error: Invalid Parameter!\n");
+		return;
+	}
+
+	body = (ui_text_widget_body_t *)widget;
+
+	if (!body->text_length) {
+		UI_LOGD("Empty text widget!\n");
+		return;
+	}
+
+	// The layout only changes with the text, its attributes and the size of the widget
+	if (body->layout_dirty ||
+		body->layout_width != body->base.global_rect.width ||
+		body->layout_height != body->base.global_rect.height) {
+		if (_ui_text_widget_build_layout(body) != UI_OK) {
+			UI_LOGE("error: out of memory!\n");
+			return;
+		}
+	}
+
+	ui_renderer_set_fill_color(body->font_color);
+
+	for (idx = 0; idx < body->layout_num; idx++) {
+		pos = &body->layout[idx];
+
+#if defined(CONFIG_UI_ENABLE_EMOJI)
+		// If the code is emoji
+		if (is_emoji(pos->utf_code)) {
+			emoji_bitmap = emoji_get_bitmap(pos->utf_code);
+			if (emoji_bitmap) {
+				ui_renderer_set_texture(
+					((uint8_t *)emoji_bitmap) + sizeof(ui_bitmap_data_t),
+					emoji_bitmap->width,
+					emoji_bitmap->height,
+					emoji_bitmap->pf);
+
+				emoji_v1 = (ui_vec3_t){ .x = pos->x - body->base.global_rect.x, .y = pos->y - body->base.global_rect.y, .w = 1.0f };
+				emoji_v2 = (ui_vec3_t){ .x = pos->x - body->base.global_rect.x, .y = pos->y - body->base.global_rect.y + body->font_size, .w = 1.0f };
+				emoji_v3 = (ui_vec3_t){ .x = pos->x - body->base.global_rect.x + body->font_size, .y = pos->y - body->base.global_rect.y + body->font_size, .w = 1.0f };
+				emoji_v4 = (ui_vec3_t){ .x = pos->x - body->base.global_rect.x + body->font_size, .y = pos->y - body->base.global_rect.y, .w = 1.0f };
+
+				ui_render_quad_uv(&body->base.trans_mat, emoji_v1, emoji_v2, emoji_v3, emoji_v4,
+					(ui_uv_t){ 0.0f, 0.0f },
+					(ui_uv_t){ 0.0f, 1.0f },
+					(ui_uv_t){ 1.0f, 1.0f },
+					(ui_uv_t){ 1.0f, 0.0f });
+
+				ui_renderer_set_texture(NULL, 0, 0, UI_PIXEL_FORMAT_UNKNOWN);
+			}
+			continue;
+		}
+#endif
+
+		_ui_text_widget_render_glyph(body, pos);
+	}
+
+	ui_renderer_set_fill_color(CONFIG_UI_DEFAULT_FILL_COLOR);
 }
 
 static void _ui_text_widget_removed_func(ui_widget_t widget)
@@ -638,6 +689,7 @@ static void _ui_text_widget_removed_func(ui_widget_t widget)
 
 	UI_FREE(body->utf_code);
 	UI_FREE(body->width_array);
+	UI_FREE(body->layout);
 }
 
 ui_error_t ui_text_widget_set_word_wrap(ui_widget_t widget, bool word_wrap)
@@ -694,6 +746,7 @@ static void _ui_text_widget_set_word_wrap_func(void *userdata)
 	// According to the text wrap option, a line number of the text widget can be differ from the current one.
 	// Therefore, this value should be recalculated.
 	_ui_text_widget_calculate_line_num(body);
+	body->layout_dirty = true;
 	body->base.update_flag = true;
 
 	UI_FREE(info);
@@ -753,6 +806,7 @@ static void _ui_text_widget_set_font_size_func(void *userdata)
 	// According to the text wrap option, a line number of the text widget can be differ from the current one.
 	// Therefore, this value should be recalculated.
 	_ui_text_widget_calculate_line_num(body);
+	body->layout_dirty = true;
 	body->base.update_flag = true;
 
 	UI_FREE(info);
@@ -21,6 +21,7 @@
 
 #include <tinyara/config.h>
 #include <stdio.h>
+#include <sys/types.h>
 #include <memory>
 #include <media/MediaTypes.h>
 
@@ -31,6 +32,7 @@ typedef audio_type_t container_type_t;
 
 /* Demuxer Error Codes */
 enum demuxer_error_e : int {
+	DEMUXER_ERROR_NOT_SUPPORTED = -6,
 	DEMUXER_ERROR_OUT_OF_MEMORY = -5,
 	DEMUXER_ERROR_SYNC_FAILED = -4,
 	DEMUXER_ERROR_WANT_DATA = -3,
@@ -133,6 +135,21 @@ public:
 	 *         it's necessary to pull and parse elementary stream manually.
 	 */
 	virtual audio_type_t getAudioType(void *param = nullptr) = 0;
+	/**
+	 * @brief Get stream position to restart demuxing from, to play from the given time
+	 *        Derived class may implement it, seeking is not supported by default.
+	 * @param[in] msec: play time in milliseconds
+	 * @param[out] offset: position in bytes from the start of the stream
+	 * @return 0 on success, negative value (see demuxer_error_t) on failure.
+	 */
+	virtual int getSeekOffset(unsigned int msec, off_t *offset) { return DEMUXER_ERROR_NOT_SUPPORTED; }
+	/**
+	 * @brief Drop stream data and elementary stream data in demuxer.
+	 *        Stream data pushed next starts at the given position.
+	 *        Information got by prepare() is kept.
+	 * @param[in] offset: position in bytes from the start of the stream
+	 */
+	virtual void flush(off_t offset) {}
 
 private:
 	// container type
@@ -159,6 +159,21 @@ ssize_t FileInputDataSource::read(unsigned char *buf, size_t size)
 	return rlen;
 }
 
+bool FileInputDataSource::seek(off_t offset)
+{
+	if (!isPrepared()) {
+		meddbg("%s[line : %d] Fail : FileInputDataSource is not prepared\n", __func__, __LINE__);
+		return false;
+	}
+
+	if (fseek(mFp, offset, SEEK_SET) != OK) {
+		meddbg("fseek failed offset : %lld error : %d\n", (long long)offset, errno);
+		return false;
+	}
+
+	return true;
+}
+
 FileInputDataSource::~FileInputDataSource()
 {
 	if (isPrepared()) {
@@ -54,6 +54,12 @@ InputDataSource &InputDataSource::operator=(const InputDataSource &source)
 InputDataSource::~InputDataSource()
 {
 }
+
+bool InputDataSource::seek(off_t offset)
+{
+	meddbg("seek is not supported by the data source\n");
+	return false;
+}
 } // namespace stream
 } // namespace media
 
@@ -111,6 +111,45 @@ ssize_t InputHandler::read(unsigned char *buf, size_t size)
 	return (ssize_t)rlen;
 }
 
+bool InputHandler::seekTo(unsigned int msec)
+{
+	if (!mDemuxer) {
+		meddbg("seek is supported only for the demuxed stream\n");
+		return false;
+	}
+
+	off_t offset;
+	int ret = mDemuxer->getSeekOffset(msec, &offset);
+	if (ret < 0) {
+		meddbg("get seek offset failed! msec: %u error: %d\n", msec, ret);
+		return false;
+	}
+
+	// Worker pushes source data into demuxer, stop it before dropping the data.
+	stop();
+
+	if (!mInputDataSource->seek(offset)) {
+		meddbg("seek data source failed! offset: %lld\n", (long long)offset);
+		start();
+		return false;
+	}
+
+	// Pre-loaded data is from the start of the stream
+	mPreloadBuffer = nullptr;
+	mDemuxer->flush(offset);
+
+	// Decoder has data of the previous position, create new one.
+	mDecoder = nullptr;
+	auto source = getDataSource();
+	if (!registerCodec(mDemuxer->getAudioType(), source->getChannels(), source->getSampleRate())) {
+		meddbg("register codec failed!\n");
+		return false;
+	}
+
+	// PCM data in stream buffer is dropped when worker restarts.
+	return start();
+}
+
 void InputHandler::resetWorker()
 {
 	mState = BUFFER_STATE_EMPTY;
@@ -120,7 +159,18 @@ void InputHandler::resetWorker()
 bool InputHandler::processWorker()
 {
 	size_t size = getAvailSpace();
-	if (size > 0) {
+	if (size > 0 && !mDemuxer && !mDecoder) {
+		// PCM data: read from source into stream buffer directly.
+		unsigned char *buf = mBufferWriter->acquireWrite(size, false);
+		ssize_t readLen = buf ? readFromSource(buf, size) : 0;
+		if (readLen <= 0) {
+			// Error occurred, or inputting finished
+			mBufferWriter->setEndOfStream();
+			return false;
+		}
+
+		mBufferWriter->commitWrite((size_t)readLen);
+	} else if (size > 0) {
 		auto buf = new unsigned char[size];
 		if (!buf) {
 			meddbg("run out of memory! size: 0x%x\n", size);
@@ -160,8 +210,8 @@ void InputHandler::sleepWorker()
 
 void InputHandler::setBufferState(buffer_state_t state)
 {
-	if (mState != state) {
-		mState = state;
+	// Reader and writer may update the state at the same time in lock-free mode
+	if (mState.exchange(state) != state) {
 		if (state >= BUFFER_STATE_BUFFERED) {
 			// Notify buffering done
 			std::unique_lock<std::mutex> lock(mMutex);
@@ -255,6 +305,15 @@ ssize_t InputHandler::writeToStreamBuffer(unsigned char *buf, size_t size)
 		while (1) {
 			unsigned char *buffPCM = buf;
 			size_t sizePCM = used;
+			if (mDecoder) {
+				// Decode into stream buffer directly, no need to copy PCM data again.
+				sizePCM = mStreamBuffer->getBufferSize();
+				buffPCM = mBufferWriter->acquireWrite(sizePCM);
+				if (buffPCM == nullptr) {
+					meddbg("End of writting!\n");
+					return EOF;
+				}
+			}
 			ret = getPCM(buffES, sizeES, &usedES, &buffPCM, &sizePCM);
 			if (ret < 0) {
 				meddbg("getPCM failed! error: %d\n", ret);
@@ -265,6 +324,11 @@ ssize_t InputHandler::writeToStreamBuffer(unsigned char *buf, size_t size)
 				break;
 			}
 
+			if (mDecoder) {
+				mBufferWriter->commitWrite(sizePCM);
+				continue;
+			}
+
 			// write PCM data to stream buffer
 			size_t written = mBufferWriter->write(buffPCM, sizePCM);
 			if (written != sizePCM) {
@@ -19,6 +19,7 @@
 #define __MEDIA_INPUTHANDLER_H
 
 #include <memory>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <sys/types.h>
@@ -49,6 +50,10 @@ public:
 	bool open() override;
 	bool close() override;
 	ssize_t read(unsigned char *buf, size_t size);
+	/**
+	 * Restart streaming from the given play time. Supported only for demuxed streams.
+	 */
+	bool seekTo(unsigned int msec);
 
 	void setBufferState(buffer_state_t state);
 
@@ -85,7 +90,7 @@ private:
 	std::shared_ptr<Demuxer> mDemuxer;
 	std::weak_ptr<MediaPlayerImpl> mPlayer;
 
-	buffer_state_t mState;
+	std::atomic<buffer_state_t> mState;
 	size_t mTotalBytes;
 };
 } // namespace stream
@@ -102,6 +102,11 @@ bool MediaPlayer::isPlaying()
 	return mPMpImpl->isPlaying();
 }
 
+player_result_t MediaPlayer::seekTo(unsigned int msec)
+{
+	return mPMpImpl->seekTo(msec);
+}
+
 MediaPlayer::~MediaPlayer()
 {
 }
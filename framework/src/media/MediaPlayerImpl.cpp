@@ -23,6 +23,9 @@
 #include <debug.h>
 #include <errno.h>
 #include "audio/audio_manager.h"
+#ifdef CONFIG_AUDIO_MIXER
+#include "audio/audio_mixer.h"
+#endif
 
 namespace media {
 
@@ -35,6 +38,10 @@ MediaPlayerImpl::MediaPlayerImpl(MediaPlayer &player) : mPlayer(player)
 	mCurState = PLAYER_STATE_NONE;
 	mBuffer = nullptr;
 	mBufSize = 0;
+#ifdef CONFIG_AUDIO_MIXER
+	mMixerStream = -1;
+	get_max_audio_volume(&mVolume);
+#endif
 }
 
 player_result_t MediaPlayerImpl::create()
@@ -153,6 +160,17 @@ void MediaPlayerImpl::preparePlayer(player_result_t &ret)
 	}
 
 	auto source = mInputHandler.getDataSource();
+#ifdef CONFIG_AUDIO_MIXER
+	mMixerStream = audio_mixer_stream_open(source->getChannels(), source->getSampleRate(), source->getPcmFormat());
+	if (mMixerStream < 0) {
+		meddbg("MediaPlayer prepare fail : audio_mixer_stream_open fail\n");
+		ret = PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
+		return notifySync();
+	}
+	setMixerGain();
+
+	mBufSize = audio_mixer_stream_frames_to_byte(mMixerStream, audio_mixer_stream_get_avail(mMixerStream));
+#else
 	if (set_audio_stream_out(source->getChannels(), source->getSampleRate(),
 							 source->getPcmFormat()) != AUDIO_MANAGER_SUCCESS) {
 		meddbg("MediaPlayer prepare fail : set_audio_stream_out fail\n");
@@ -161,6 +179,7 @@ void MediaPlayerImpl::preparePlayer(player_result_t &ret)
 	}
 
 	mBufSize = get_user_output_frames_to_byte(get_output_frame_count());
+#endif
 	if (mBufSize < 0) {
 		meddbg("MediaPlayer prepare fail : get_output_frames_byte_size fail\n");
 		ret = PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
@@ -256,11 +275,21 @@ void MediaPlayerImpl::unpreparePlayer(player_result_t &ret)
 	}
 	mBufSize = 0;
 
+#ifdef CONFIG_AUDIO_MIXER
+	audio_manager_result_t result = audio_mixer_stream_close(mMixerStream);
+	mMixerStream = -1;
+	if (result != AUDIO_MANAGER_SUCCESS) {
+		meddbg("MediaPlayer unprepare fail : audio_mixer_stream_close fail\n");
+		ret = PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
+		return notifySync();
+	}
+#else
 	if (reset_audio_stream_out() != AUDIO_MANAGER_SUCCESS) {
 		meddbg("MediaPlayer unprepare fail : reset_audio_stream_out fail\n");
 		ret = PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
 		return notifySync();
 	}
+#endif
 
 	mInputHandler.close();
 
@@ -296,6 +325,15 @@ void MediaPlayerImpl::startPlayer()
 		return;
 	}
 
+#ifdef CONFIG_AUDIO_MIXER
+	// Other players keep playing, the mixer sums them up.
+	if (audio_mixer_stream_start(mMixerStream) != AUDIO_MANAGER_SUCCESS) {
+		meddbg("MediaPlayer startPlayer fail : audio_mixer_stream_start fail\n");
+		notifyObserver(PLAYER_OBSERVER_COMMAND_START_ERROR, PLAYER_ERROR_INTERNAL_OPERATION_FAILED);
+		return;
+	}
+	mpw.addPlayer(shared_from_this());
+#else
 	if (mCurState == PLAYER_STATE_PAUSED) {
 		auto source = mInputHandler.getDataSource();
 		if (set_audio_stream_out(source->getChannels(), source->getSampleRate(),
@@ -315,6 +353,7 @@ void MediaPlayerImpl::startPlayer()
 		}
 		mpw.setPlayer(curPlayer);
 	}
+#endif
 
 	mCurState = PLAYER_STATE_PLAYING;
 	notifyObserver(PLAYER_OBSERVER_COMMAND_STARTED);
@@ -357,6 +396,18 @@ player_result_t MediaPlayerImpl::stopPlayback()
 		return PLAYER_ERROR_INVALID_STATE;
 	}
 
+#ifdef CONFIG_AUDIO_MIXER
+	// Play out the queued frames unless the player has been paused, as stop_audio_stream_out() does.
+	bool drain = (mCurState == PLAYER_STATE_PLAYING);
+	mCurState = PLAYER_STATE_READY;
+	mpw.removePlayer(shared_from_this());
+
+	audio_manager_result_t result = audio_mixer_stream_stop(mMixerStream, drain);
+	if (result != AUDIO_MANAGER_SUCCESS) {
+		meddbg("audio_mixer_stream_stop failed ret : %d\n", result);
+		return PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
+	}
+#else
 	mCurState = PLAYER_STATE_READY;
 	mpw.setPlayer(nullptr);
 
@@ -365,6 +416,7 @@ player_result_t MediaPlayerImpl::stopPlayback()
 		meddbg("stop_audio_stream_out failed ret : %d\n", result);
 		return PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
 	}
+#endif
 
 	return PLAYER_OK;
 }
@@ -397,6 +449,16 @@ void MediaPlayerImpl::pausePlayer()
 		return;
 	}
 
+#ifdef CONFIG_AUDIO_MIXER
+	audio_manager_result_t result = audio_mixer_stream_pause(mMixerStream);
+	if (result != AUDIO_MANAGER_SUCCESS) {
+		meddbg("audio_mixer_stream_pause failed ret : %d\n", result);
+		notifyObserver(PLAYER_OBSERVER_COMMAND_PAUSE_ERROR, PLAYER_ERROR_INTERNAL_OPERATION_FAILED);
+		return;
+	}
+
+	mpw.removePlayer(shared_from_this());
+#else
 	audio_manager_result_t result = pause_audio_stream_out();
 	if (result != AUDIO_MANAGER_SUCCESS) {
 		meddbg("pause_audio_stream_in failed ret : %d\n", result);
@@ -409,6 +471,7 @@ void MediaPlayerImpl::pausePlayer()
 	if (prevPlayer == curPlayer) {
 		mpw.setPlayer(nullptr);
 	}
+#endif
 	mCurState = PLAYER_STATE_PAUSED;
 	notifyObserver(PLAYER_OBSERVER_COMMAND_PAUSED);
 }
@@ -441,10 +504,14 @@ player_result_t MediaPlayerImpl::getVolume(uint8_t *vol)
 void MediaPlayerImpl::getPlayerVolume(uint8_t *vol, player_result_t &ret)
 {
 	medvdbg("MediaPlayer Worker : getVolume\n");
+#ifdef CONFIG_AUDIO_MIXER
+	*vol = mVolume;
+#else
 	if (get_output_audio_volume(vol) != AUDIO_MANAGER_SUCCESS) {
 		meddbg("get_output_audio_volume() is failed, ret = %d\n", ret);
 		ret = PLAYER_ERROR_INTERNAL_OPERATION_FAILED;
 	}
+#endif
 
 	notifySync();
 }
@@ -508,7 +575,20 @@ void MediaPlayerImpl::setPlayerVolume(uint8_t vol, player_result_t &ret)
 {
 	medvdbg("MediaPlayer Worker : setVolume %d\n", vol);
 
+#ifdef CONFIG_AUDIO_MIXER
+	// Each player has its own gain in the mixer, the card volume is left as it is.
+	uint8_t max_vol;
+	get_max_audio_volume(&max_vol);
+	if (vol > max_vol) {
+		meddbg("volume is out of range, vol : %d\n", vol);
+		ret = PLAYER_ERROR_INVALID_PARAMETER;
+		return notifySync();
+	}
+	mVolume = vol;
+	audio_manager_result_t result = setMixerGain();
+#else
 	audio_manager_result_t result = set_output_audio_volume(vol);
+#endif
 	if (result != AUDIO_MANAGER_SUCCESS) {
 		meddbg("set_input_audio_volume failed vol : %d ret : %d\n", vol, result);
 		if (result == AUDIO_MANAGER_DEVICE_NOT_SUPPORT) {
@@ -524,6 +604,56 @@ void MediaPlayerImpl::setPlayerVolume(uint8_t vol, player_result_t &ret)
 	return notifySync();
 }
 
+player_result_t MediaPlayerImpl::seekTo(unsigned int msec)
+{
+	player_result_t ret = PLAYER_OK;
+
+	std::unique_lock<std::mutex> lock(mCmdMtx);
+	medvdbg("MediaPlayer seekTo %u\n", msec);
+
+	PlayerWorker &mpw = PlayerWorker::getWorker();
+	if (!mpw.isAlive()) {
+		meddbg("PlayerWorker is not alive\n");
+		return PLAYER_ERROR_NOT_ALIVE;
+	}
+
+	mpw.enQueue(&MediaPlayerImpl::seekPlayer, shared_from_this(), msec, std::ref(ret));
+	mSyncCv.wait(lock);
+
+	return ret;
+}
+
+void MediaPlayerImpl::seekPlayer(unsigned int msec, player_result_t &ret)
+{
+	medvdbg("MediaPlayer Worker : seekTo %u\n", msec);
+
+	if (mCurState != PLAYER_STATE_READY && mCurState != PLAYER_STATE_PLAYING && mCurState != PLAYER_STATE_PAUSED) {
+		meddbg("MediaPlayer seekTo fail : wrong state %d\n", (player_state_t)mCurState);
+		ret = PLAYER_ERROR_INVALID_STATE;
+		return notifySync();
+	}
+
+	if (!mInputHandler.seekTo(msec)) {
+		meddbg("MediaPlayer seekTo fail : InputHandler seekTo fail\n");
+		ret = PLAYER_ERROR_INVALID_OPERATION;
+		return notifySync();
+	}
+
+#ifdef CONFIG_AUDIO_MIXER
+	// Drop frames of the previous position queued in the mixer
+	if (mCurState != PLAYER_STATE_READY) {
+		audio_mixer_stream_stop(mMixerStream, false);
+		if (mCurState == PLAYER_STATE_PLAYING) {
+			audio_mixer_stream_start(mMixerStream);
+		}
+	}
+#endif
+
+	medvdbg("MediaPlayer seekTo success\n");
+	ret = PLAYER_OK;
+	return notifySync();
+}
+
 player_result_t MediaPlayerImpl::setDataSource(std::unique_ptr<stream::InputDataSource> source)
 {
 	player_result_t ret = PLAYER_OK;
@@ -671,7 +801,9 @@ void MediaPlayerImpl::notifyObserver(player_observer_command_t cmd, ...)
 			pow.enQueue(&MediaPlayerObserverInterface::onPlaybackBufferUnderrun, mPlayerObserver, mPlayer);
 			break;
 		case PLAYER_OBSERVER_COMMAND_BUFFER_UPDATED:
-			pow.enQueue(&MediaPlayerObserverInterface::onPlaybackBufferUpdated, mPlayerObserver, mPlayer, (size_t)va_arg(ap, size_t));
+			// Sent on every write of data. Don't wait while the queue is full, the next
+			// update carries the new total size, so dropping one loses nothing.
+			pow.tryEnQueue(&MediaPlayerObserverInterface::onPlaybackBufferUpdated, mPlayerObserver, mPlayer, (size_t)va_arg(ap, size_t));
 			break;
 		case PLAYER_OBSERVER_COMMAND_BUFFER_STATECHANGED:
 			pow.enQueue(&MediaPlayerObserverInterface::onPlaybackBufferStateChanged, mPlayerObserver, mPlayer, (buffer_state_t)va_arg(ap, int));
@@ -712,6 +844,16 @@ void MediaPlayerImpl::notifyAsync(player_event_t event)
 		// Input handler has been opened successfully by InputHandler::doStandBy().
 		// Now setup audio manager and notify player observer the result.
 		auto source = mInputHandler.getDataSource();
+#ifdef CONFIG_AUDIO_MIXER
+		mMixerStream = audio_mixer_stream_open(source->getChannels(), source->getSampleRate(), source->getPcmFormat());
+		if (mMixerStream < 0) {
+			meddbg("MediaPlayer prepare fail : audio_mixer_stream_open fail\n");
+			return notifyObserver(PLAYER_OBSERVER_COMMAND_ASYNC_PREPARED, PLAYER_ERROR_INTERNAL_OPERATION_FAILED);
+		}
+		setMixerGain();
+
+		mBufSize = audio_mixer_stream_frames_to_byte(mMixerStream, audio_mixer_stream_get_avail(mMixerStream));
+#else
 		if (set_audio_stream_out(source->getChannels(), source->getSampleRate(),
 								 source->getPcmFormat()) != AUDIO_MANAGER_SUCCESS) {
 			meddbg("MediaPlayer prepare fail : set_audio_stream_out fail\n");
@@ -719,6 +861,7 @@ void MediaPlayerImpl::notifyAsync(player_event_t event)
 		}
 
 		mBufSize = get_user_output_frames_to_byte(get_output_frame_count());
+#endif
 		if (mBufSize < 0) {
 			meddbg("MediaPlayer prepare fail : get_user_output_frames_to_byte fail\n");
 			return notifyObserver(PLAYER_OBSERVER_COMMAND_ASYNC_PREPARED, PLAYER_ERROR_INTERNAL_OPERATION_FAILED);
@@ -744,12 +887,67 @@ void MediaPlayerImpl::notifyAsync(player_event_t event)
 	}
 }
 
+#ifdef CONFIG_AUDIO_MIXER
+audio_manager_result_t MediaPlayerImpl::setMixerGain()
+{
+	uint8_t max_vol;
+
+	if (mMixerStream < 0) {
+		// Applied when the stream is opened.
+		return AUDIO_MANAGER_SUCCESS;
+	}
+
+	get_max_audio_volume(&max_vol);
+	return audio_mixer_stream_set_gain(mMixerStream, (uint16_t)((uint32_t)mVolume * AUDIO_MIXER_GAIN_UNITY / max_vol));
+}
+
+int MediaPlayerImpl::writeMixerStream(unsigned int frames)
+{
+	unsigned char *data = mBuffer;
+	int ret = 0;
+
+	// The stream may take less than getPlaybackSize() if its resampler is full, wait for the rest.
+	while (frames > 0) {
+		ret = audio_mixer_stream_write(mMixerStream, data, frames);
+		if (ret < 0) {
+			return ret;
+		}
+		frames -= ret;
+		data += audio_mixer_stream_frames_to_byte(mMixerStream, ret);
+		if (frames > 0) {
+			audio_mixer_wait_avail();
+		}
+	}
+
+	return ret;
+}
+
+int MediaPlayerImpl::getPlaybackSize()
+{
+	int size = (int)audio_mixer_stream_frames_to_byte(mMixerStream, audio_mixer_stream_get_avail(mMixerStream));
+	return (size < mBufSize) ? size : mBufSize;
+}
+#endif
+
 void MediaPlayerImpl::playback()
 {
+#ifdef CONFIG_AUDIO_MIXER
+	// Read only what the mixer stream takes now, so that the other players are not held up.
+	int size = getPlaybackSize();
+	if (size <= 0) {
+		return;
+	}
+	ssize_t num_read = mInputHandler.read(mBuffer, size);
+#else
 	ssize_t num_read = mInputHandler.read(mBuffer, (int)mBufSize);
+#endif
 	medvdbg("num_read : %d\n", num_read);
 	if (num_read > 0) {
+#ifdef CONFIG_AUDIO_MIXER
+		int ret = writeMixerStream(audio_mixer_stream_bytes_to_frame(mMixerStream, (unsigned int)num_read));
+#else
 		int ret = start_audio_stream_out(mBuffer, get_user_output_bytes_to_frame((unsigned int)num_read));
+#endif
 		if (ret < 0) {
 			notifyObserver(PLAYER_OBSERVER_COMMAND_PLAYBACK_ERROR, PLAYER_ERROR_INTERNAL_OPERATION_FAILED);
 			PlayerWorker &mpw = PlayerWorker::getWorker();
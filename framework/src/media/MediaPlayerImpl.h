@@ -19,6 +19,7 @@
 #ifndef __MEDIA_MEDIAPLAYERIMPL_H
 #define __MEDIA_MEDIAPLAYERIMPL_H
 
+#include <tinyara/config.h>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -29,6 +30,7 @@
 
 #include "PlayerObserverWorker.h"
 #include "InputHandler.h"
+#include "audio/audio_manager.h"
 
 namespace media {
 /**
@@ -103,6 +105,7 @@ public:
 	player_result_t getVolume(uint8_t *vol);
 	player_result_t getMaxVolume(uint8_t *vol);
 	player_result_t setVolume(uint8_t vol);
+	player_result_t seekTo(unsigned int msec);
 
 	player_result_t setDataSource(std::unique_ptr<stream::InputDataSource>);
 	player_result_t setObserver(std::shared_ptr<MediaPlayerObserverInterface>);
@@ -114,6 +117,9 @@ public:
 	void notifyObserver(player_observer_command_t cmd, ...);
 	void notifyAsync(player_event_t event);
 	void playback();
+#ifdef CONFIG_AUDIO_MIXER
+	int getPlaybackSize();
+#endif
 
 private:
 	void createPlayer(player_result_t &ret);
@@ -128,8 +134,13 @@ private:
 	void getPlayerVolume(uint8_t *vol, player_result_t &ret);
 	void getPlayerMaxVolume(uint8_t *vol, player_result_t &ret);
 	void setPlayerVolume(uint8_t vol, player_result_t &ret);
+	void seekPlayer(unsigned int msec, player_result_t &ret);
 	void setPlayerObserver(std::shared_ptr<MediaPlayerObserverInterface> observer);
 	void setPlayerDataSource(std::shared_ptr<stream::InputDataSource> dataSource, player_result_t &ret);
+#ifdef CONFIG_AUDIO_MIXER
+	audio_manager_result_t setMixerGain();
+	int writeMixerStream(unsigned int frames);
+#endif
 
 private:
 	MediaPlayer &mPlayer;
@@ -141,6 +152,10 @@ private:
 	std::shared_ptr<stream_info_t> mStreamInfo;
 	std::shared_ptr<MediaPlayerObserverInterface> mPlayerObserver;
 	stream::InputHandler mInputHandler;
+#ifdef CONFIG_AUDIO_MIXER
+	int mMixerStream;
+	uint8_t mVolume;
+#endif
 };
 } // namespace media
 #endif
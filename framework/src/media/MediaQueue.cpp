@@ -16,31 +16,156 @@
  *
  ******************************************************************/
 
+#include <tinyara/config.h>
+#include <time.h>
+#include <debug.h>
+
 #include "MediaQueue.h"
 
+#ifdef CONFIG_CLOCK_MONOTONIC
+#define MEDIA_QUEUE_CLOCK CLOCK_MONOTONIC
+#else
+#define MEDIA_QUEUE_CLOCK CLOCK_REALTIME
+#endif
+
 namespace media {
-MediaQueue::MediaQueue()
+
+static unsigned long getTimeUs()
+{
+	struct timespec ts;
+	clock_gettime(MEDIA_QUEUE_CLOCK, &ts);
+	return (unsigned long)ts.tv_sec * 1000000UL + (unsigned long)ts.tv_nsec / 1000UL;
+}
+
+MediaQueue::MediaQueue() :
+	mHead(0),
+	mCount(0),
+	mHasConsumer(false),
+	mStats(),
+	mTotalLatency(0)
 {
+	mRunning.ops = nullptr;
 }
+
 MediaQueue::~MediaQueue()
 {
+	std::unique_lock<std::mutex> lock(mQueueMtx);
+	while (mCount > 0) {
+		Slot &slot = mSlots[mHead];
+		slot.ops->destroy(&slot.storage);
+		mHead = (mHead + 1) % CONFIG_MEDIA_QUEUE_DEPTH;
+		mCount--;
+	}
+
+	if (mRunning.ops != nullptr) {
+		mRunning.ops->destroy(&mRunning.storage);
+	}
+}
+
+MediaQueue::Slot *MediaQueue::acquireSlot(std::unique_lock<std::mutex> &lock, bool wait)
+{
+	// Tasks in overflow queue were enqueued after those in the ring, keep them in order.
+	if (mCount == CONFIG_MEDIA_QUEUE_DEPTH || !mOverflow.empty()) {
+		if (!wait) {
+			return nullptr;
+		}
+
+		if (mHasConsumer && pthread_equal(mConsumer, pthread_self())) {
+			// Worker would wait for itself forever
+			medvdbg("MediaQueue is full, task from worker itself overflows\n");
+			return nullptr;
+		}
+
+		medvdbg("MediaQueue is full, wait...\n");
+		while (mCount == CONFIG_MEDIA_QUEUE_DEPTH || !mOverflow.empty()) {
+			mSpaceCv.wait(lock);
+		}
+	}
+
+	return &mSlots[(mHead + mCount) % CONFIG_MEDIA_QUEUE_DEPTH];
+}
+
+void MediaQueue::commitSlot()
+{
+	mSlots[(mHead + mCount) % CONFIG_MEDIA_QUEUE_DEPTH].stamp = getTimeUs();
+	mCount++;
+	mStats.enqueued++;
+	if (mCount > mStats.maxDepth) {
+		mStats.maxDepth = mCount;
+	}
+	mQueueCv.notify_one();
+}
+
+void MediaQueue::commitOverflow()
+{
+	mStats.enqueued++;
+	mStats.overflowed++;
+	mQueueCv.notify_one();
 }
 
 std::function<void()> MediaQueue::deQueue()
 {
 	std::unique_lock<std::mutex> lock(mQueueMtx);
-	if (mQueueData.empty()) {
+	mConsumer = pthread_self();
+	mHasConsumer = true;
+	while (mCount == 0 && mOverflow.empty()) {
 		mQueueCv.wait(lock);
 	}
 
-	auto data = std::move(mQueueData.front());
-	mQueueData.pop();
-	return data;
+	if (mCount == 0) {
+		std::function<void()> task = std::move(mOverflow.front());
+		mOverflow.pop();
+		if (mOverflow.empty()) {
+			mSpaceCv.notify_all();
+		}
+		return task;
+	}
+
+	// Move the task out of the ring, so the slot can be reused while the task is running.
+	Slot &slot = mSlots[mHead];
+	slot.ops->move(&mRunning.storage, &slot.storage);
+	mRunning.ops = slot.ops;
+	mHead = (mHead + 1) % CONFIG_MEDIA_QUEUE_DEPTH;
+	mCount--;
+	mSpaceCv.notify_one();
+
+	unsigned long latency = getTimeUs() - slot.stamp;
+	mStats.lastLatency = latency;
+	if (latency > mStats.maxLatency) {
+		mStats.maxLatency = latency;
+	}
+	mTotalLatency += latency;
+
+	// Captures only 'this', fits in the small buffer of std::function.
+	return [this]() {
+		runTask();
+	};
+}
+
+void MediaQueue::runTask()
+{
+	if (mRunning.ops == nullptr) {
+		return;
+	}
+
+	const Operations *ops = mRunning.ops;
+	mRunning.ops = nullptr;
+	ops->run(&mRunning.storage);
+	ops->destroy(&mRunning.storage);
 }
 
 bool MediaQueue::isEmpty()
 {
 	std::unique_lock<std::mutex> lock(mQueueMtx);
-	return mQueueData.empty();
+	return mCount == 0 && mOverflow.empty();
+}
+
+void MediaQueue::getStatistics(Statistics &stats)
+{
+	std::unique_lock<std::mutex> lock(mQueueMtx);
+	stats = mStats;
+	stats.depth = mCount + mOverflow.size();
+	size_t done = mStats.enqueued - stats.depth;
+	stats.avgLatency = done ? (unsigned long)(mTotalLatency / done) : 0;
 }
 } // namespace media
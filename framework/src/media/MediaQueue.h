@@ -19,34 +19,150 @@
 #ifndef __MEDIA_QUEUE_H
 #define __MEDIA_QUEUE_H
 
+#include <tinyara/config.h>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
 #include <atomic>
 #include <iostream>
 #include <functional>
+#include <type_traits>
+#include <new>
+#include <queue>
+#include <pthread.h>
+
+#ifndef CONFIG_MEDIA_QUEUE_DEPTH
+#define CONFIG_MEDIA_QUEUE_DEPTH 16
+#endif
+
+#ifndef CONFIG_MEDIA_QUEUE_TASK_SIZE
+#define CONFIG_MEDIA_QUEUE_TASK_SIZE 48
+#endif
 
 namespace media {
+/**
+ * Bounded task queue of media workers.
+ * Tasks are stored inline in a preallocated ring of slots, so enqueueing a task
+ * never allocates from heap. Producer is blocked while the queue is full, except
+ * the worker itself: its tasks go to an overflow queue on heap, so that they are
+ * never lost and the worker never waits for itself.
+ */
 class MediaQueue
 {
 public:
+	struct Statistics {
+		size_t depth;                  /* Tasks waiting in queue now */
+		size_t maxDepth;               /* High watermark of depth */
+		unsigned long enqueued;        /* Tasks enqueued in total */
+		unsigned long overflowed;      /* Tasks the worker enqueued into its own full queue */
+		unsigned long dropped;         /* Tasks dropped by tryEnQueue(), queue was full */
+		unsigned long lastLatency;     /* Enqueue to run latency of the last task, in usec */
+		unsigned long maxLatency;      /* Maximum enqueue to run latency, in usec */
+		unsigned long avgLatency;      /* Average enqueue to run latency, in usec */
+	};
+
 	MediaQueue();
 	~MediaQueue();
 	template <typename _Callable, typename... _Args>
 	void enQueue(_Callable &&__f, _Args &&... __args) {
+		typedef decltype(std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...)) _Task;
+		static_assert(sizeof(_Task) <= sizeof(TaskStorage), "Task is too large, increase CONFIG_MEDIA_QUEUE_TASK_SIZE");
+		static_assert(alignof(_Task) <= alignof(TaskStorage), "Task alignment is not supported");
+
 		std::unique_lock<std::mutex> lock(mQueueMtx);
-		std::function<void()> func = std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...);
-		mQueueData.push(func);
-		mQueueCv.notify_one();
+		Slot *slot = acquireSlot(lock, true);
+		if (slot == nullptr) {
+			mOverflow.push(std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...));
+			commitOverflow();
+			return;
+		}
+		new (&slot->storage) _Task(std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...));
+		slot->ops = &TaskOps<_Task>::ops;
+		commitSlot();
+	}
+	/**
+	 * Same as enQueue(), but the task is dropped instead of waiting while the queue is full.
+	 * For notifications whose later ones supersede the earlier ones.
+	 * Returns false if the task is dropped.
+	 */
+	template <typename _Callable, typename... _Args>
+	bool tryEnQueue(_Callable &&__f, _Args &&... __args) {
+		typedef decltype(std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...)) _Task;
+		static_assert(sizeof(_Task) <= sizeof(TaskStorage), "Task is too large, increase CONFIG_MEDIA_QUEUE_TASK_SIZE");
+		static_assert(alignof(_Task) <= alignof(TaskStorage), "Task alignment is not supported");
+
+		std::unique_lock<std::mutex> lock(mQueueMtx);
+		Slot *slot = acquireSlot(lock, false);
+		if (slot == nullptr) {
+			mStats.dropped++;
+			return false;
+		}
+		new (&slot->storage) _Task(std::bind(std::forward<_Callable>(__f), std::forward<_Args>(__args)...));
+		slot->ops = &TaskOps<_Task>::ops;
+		commitSlot();
+		return true;
 	}
 	std::function<void()> deQueue();
 	bool isEmpty();
+	void getStatistics(Statistics &stats);
 
 private:
-	std::queue<std::function<void()>> mQueueData;
+	typedef std::aligned_storage<CONFIG_MEDIA_QUEUE_TASK_SIZE>::type TaskStorage;
+
+	struct Operations {
+		void (*run)(void *task);
+		void (*move)(void *dst, void *src);
+		void (*destroy)(void *task);
+	};
+
+	template <typename _Task>
+	struct TaskOps {
+		static void run(void *task)
+		{
+			(*static_cast<_Task *>(task))();
+		}
+		static void move(void *dst, void *src)
+		{
+			new (dst) _Task(std::move(*static_cast<_Task *>(src)));
+			static_cast<_Task *>(src)->~_Task();
+		}
+		static void destroy(void *task)
+		{
+			static_cast<_Task *>(task)->~_Task();
+		}
+		static const Operations ops;
+	};
+
+	struct Slot {
+		TaskStorage storage;
+		const Operations *ops;
+		unsigned long stamp;
+	};
+
+	Slot *acquireSlot(std::unique_lock<std::mutex> &lock, bool wait);
+	void commitSlot();
+	void commitOverflow();
+	void runTask();
+
+	Slot mSlots[CONFIG_MEDIA_QUEUE_DEPTH];
+	Slot mRunning;
+	std::queue<std::function<void()>> mOverflow;
+	size_t mHead;
+	size_t mCount;
+	pthread_t mConsumer;
+	bool mHasConsumer;
+	Statistics mStats;
+	unsigned long long mTotalLatency;
 	std::condition_variable mQueueCv;
+	std::condition_variable mSpaceCv;
 	std::mutex mQueueMtx;
 };
+
+template <typename _Task>
+const MediaQueue::Operations MediaQueue::TaskOps<_Task>::ops = {
+	MediaQueue::TaskOps<_Task>::run,
+	MediaQueue::TaskOps<_Task>::move,
+	MediaQueue::TaskOps<_Task>::destroy,
+};
 } // namespace media
 
 #endif
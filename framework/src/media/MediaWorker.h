@@ -39,6 +39,10 @@ public:
 	void enQueue(_Callable &&__f, _Args &&... __args) {
 		mWorkerQueue.enQueue(__f, __args...);
 	}
+	template <typename _Callable, typename... _Args>
+	bool tryEnQueue(_Callable &&__f, _Args &&... __args) {
+		return mWorkerQueue.tryEnQueue(__f, __args...);
+	}
 	std::function<void()> deQueue();
 	bool isAlive();
 
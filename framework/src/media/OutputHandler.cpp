@@ -126,22 +126,26 @@ void OutputHandler::resetWorker()
 
 void OutputHandler::writeToSource(size_t size)
 {
-	auto buf = new unsigned char[size];
-	auto readed = mBufferReader->read(buf, size);
-	if (readed != size) {
-		meddbg("StreamBufferReader::read failed! size : %u, readed : %u\n", size, readed);
-		delete[] buf;
-		return;
-	}
+	while (size > 0) {
+		// Write to source directly from stream buffer, data may be split by the wrap-around.
+		size_t len = size;
+		auto buf = mBufferReader->peekRead(len, false);
+		if (buf == nullptr) {
+			meddbg("StreamBufferReader::peekRead failed! size : %u\n", size);
+			return;
+		}
 
-	auto written = mOutputDataSource->write(buf, size);
-	if (written <= 0) {
-		// Error occurred, stop outputting
-		meddbg("OutputDataSource::write returned <= 0! size : %u, written : %d\n", size, written);
-		mBufferWriter->setEndOfStream();
-	}
+		auto written = mOutputDataSource->write(buf, len);
+		mBufferReader->consumeRead(len);
+		if (written <= 0) {
+			// Error occurred, stop outputting
+			meddbg("OutputDataSource::write returned <= 0! size : %u, written : %d\n", len, written);
+			mBufferWriter->setEndOfStream();
+			return;
+		}
 
-	delete[] buf;
+		size -= len;
+	}
 }
 
 bool OutputHandler::processWorker()
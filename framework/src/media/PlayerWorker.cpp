@@ -21,6 +21,9 @@
 
 #include "PlayerWorker.h"
 #include "MediaPlayerImpl.h"
+#ifdef CONFIG_AUDIO_MIXER
+#include "audio/audio_mixer.h"
+#endif
 
 #ifndef CONFIG_MEDIA_PLAYER_STACKSIZE
 #define CONFIG_MEDIA_PLAYER_STACKSIZE 4096
@@ -47,12 +50,37 @@ PlayerWorker& PlayerWorker::getWorker()
 
 bool PlayerWorker::processLoop()
 {
+#ifdef CONFIG_AUDIO_MIXER
+	bool playing = false;
+	bool written = false;
+
+	// Feed every playing player as much as its mixer stream takes now.
+	// Iterate over a copy, playback() removes the player when it finishes.
+	auto players = mPlayers;
+	for (auto &player : players) {
+		if (player->getState() != PLAYER_STATE_PLAYING) {
+			continue;
+		}
+		playing = true;
+		if (player->getPlaybackSize() > 0) {
+			player->playback();
+			written = true;
+		}
+	}
+
+	if (playing && !written) {
+		audio_mixer_wait_avail();
+	}
+
+	return playing;
+#else
 	if (mCurPlayer && (mCurPlayer->getState() == PLAYER_STATE_PLAYING)) {
 		mCurPlayer->playback();
 		return true;
 	}
 
 	return false;
+#endif
 }
 
 void PlayerWorker::setPlayer(std::shared_ptr<MediaPlayerImpl> player)
@@ -65,4 +93,21 @@ std::shared_ptr<MediaPlayerImpl> PlayerWorker::getPlayer()
 	return mCurPlayer;
 }
 
+#ifdef CONFIG_AUDIO_MIXER
+void PlayerWorker::addPlayer(std::shared_ptr<MediaPlayerImpl> player)
+{
+	for (auto &p : mPlayers) {
+		if (p == player) {
+			return;
+		}
+	}
+	mPlayers.push_back(player);
+}
+
+void PlayerWorker::removePlayer(std::shared_ptr<MediaPlayerImpl> player)
+{
+	mPlayers.remove(player);
+}
+#endif
+
 } // namespace media
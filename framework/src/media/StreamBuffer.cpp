@@ -45,8 +45,8 @@
 namespace media {
 namespace stream {
 
-StreamBuffer::StreamBuffer(size_t bufferSize, size_t threshold)
-	: mObserver(nullptr), mEOS(false), mBufferSize(bufferSize), mThreshold(threshold)
+StreamBuffer::StreamBuffer(size_t bufferSize, size_t threshold, bool spsc)
+	: mDataWanted(0), mSpaceWanted(0), mObserver(nullptr), mEOS(false), mSPSC(spsc), mBufferSize(bufferSize), mThreshold(threshold)
 {
 	mRingBuf.buf = nullptr;
 	mRingBuf.depth = 0;
@@ -92,6 +92,26 @@ size_t StreamBuffer::write(unsigned char *buf, size_t size)
 	return rb_write(&mRingBuf, buf, size);
 }
 
+unsigned char *StreamBuffer::acquireWrite(size_t &size)
+{
+	return (unsigned char *)rb_acquire_write(&mRingBuf, &size);
+}
+
+size_t StreamBuffer::commitWrite(size_t size)
+{
+	return rb_commit_write(&mRingBuf, size);
+}
+
+unsigned char *StreamBuffer::peekRead(size_t &size, size_t offset)
+{
+	return (unsigned char *)rb_peek_read_ext(&mRingBuf, &size, offset);
+}
+
+size_t StreamBuffer::consumeRead(size_t size)
+{
+	return rb_consume_read(&mRingBuf, size);
+}
+
 size_t StreamBuffer::sizeOfSpace()
 {
 	return rb_avail(&mRingBuf);
@@ -105,6 +125,15 @@ size_t StreamBuffer::sizeOfData()
 void StreamBuffer::setEndOfStream()
 {
 	mEOS = true;
+
+	if (mSPSC) {
+		// EOS may be set by a thread other than reader and writer, wake up both of them.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if ((mDataWanted.exchange(0) | mSpaceWanted.exchange(0)) > 0) {
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCondv.notify_all();
+		}
+	}
 }
 
 bool StreamBuffer::isEndOfStream()
@@ -112,6 +141,58 @@ bool StreamBuffer::isEndOfStream()
 	return mEOS;
 }
 
+/*
+ * In SPSC mode, sleeper publishes what it wants and checks the buffer with mutex held,
+ * waker updates the index and then checks what is wanted. Both are sequentially consistent,
+ * so either the waker sees the demand and notifies under mutex, or the sleeper sees the update.
+ * Waker takes the demand away when notifying, so the sleeper is notified only once.
+ */
+void StreamBuffer::waitForData(size_t want)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mDataWanted = want;
+		if (sizeOfData() >= want || isEndOfStream()) {
+			break;
+		}
+		mCondv.wait(lock);
+	}
+	mDataWanted = 0;
+}
+
+void StreamBuffer::waitForSpace(size_t want)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mSpaceWanted = want;
+		if (sizeOfSpace() >= want || isEndOfStream()) {
+			break;
+		}
+		mCondv.wait(lock);
+	}
+	mSpaceWanted = 0;
+}
+
+void StreamBuffer::wakeReader()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	size_t want = mDataWanted.load();
+	if (want > 0 && sizeOfData() >= want && mDataWanted.compare_exchange_strong(want, 0)) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCondv.notify_all();
+	}
+}
+
+void StreamBuffer::wakeWriter()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	size_t want = mSpaceWanted.load();
+	if (want > 0 && sizeOfSpace() >= want && mSpaceWanted.compare_exchange_strong(want, 0)) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCondv.notify_all();
+	}
+}
+
 void StreamBuffer::setObserver(BufferObserverInterface *observer)
 {
 	mObserver = observer;
@@ -140,7 +221,7 @@ void StreamBuffer::notifyObserver(State st, ...)
 }
 
 StreamBuffer::Builder::Builder()
-	: mBufferSize(CONFIG_STREAM_BUFFER_SIZE_DEFAULT), mThreshold(CONFIG_STREAM_BUFFER_THRESHOLD_DEFAULT)
+	: mBufferSize(CONFIG_STREAM_BUFFER_SIZE_DEFAULT), mThreshold(CONFIG_STREAM_BUFFER_THRESHOLD_DEFAULT), mSPSC(false)
 {
 }
 
@@ -166,13 +247,19 @@ StreamBuffer::Builder &StreamBuffer::Builder::setThreshold(size_t threshold)
 	return *this;
 }
 
+StreamBuffer::Builder &StreamBuffer::Builder::setSingleProducerConsumer(bool spsc)
+{
+	mSPSC = spsc;
+	return *this;
+}
+
 std::shared_ptr<StreamBuffer> StreamBuffer::Builder::build()
 {
 	if (mThreshold > mBufferSize) {
 		mThreshold = mBufferSize;
 	}
 
-	auto instance = std::make_shared<StreamBuffer>(mBufferSize, mThreshold);
+	auto instance = std::make_shared<StreamBuffer>(mBufferSize, mThreshold, mSPSC);
 	if (instance->init(mBufferSize)) {
 		return instance;
 	}
@@ -21,6 +21,7 @@
 
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 #include "utils/rb.h"
 
@@ -38,14 +39,20 @@ public:
 		Builder();
 		Builder &setBufferSize(size_t bufferSize);
 		Builder &setThreshold(size_t threshold);
+		/**
+		 * Stream buffer is accessed by exactly one writer thread and one reader thread.
+		 * Data path is lock-free, mutex is taken only to sleep and wake the peer.
+		 */
+		Builder &setSingleProducerConsumer(bool spsc);
 		std::shared_ptr<StreamBuffer> build();
 
 	private:
 		size_t mBufferSize;
 		size_t mThreshold;
+		bool mSPSC;
 	};
 
-	StreamBuffer(size_t bufferSize, size_t threshold);
+	StreamBuffer(size_t bufferSize, size_t threshold, bool spsc = false);
 	virtual ~StreamBuffer();
 	/**
 	 * Initialize stream buffer with specific buffer size.
@@ -87,6 +94,27 @@ public:
 	 * Write(push) data into stream buffer.
 	 */
 	size_t write(unsigned char *buf, size_t size);
+	/**
+	 * Get contiguous free space to write into directly (zero-copy).
+	 * size is the requested length, and it's updated to the length actually reserved.
+	 * Returns nullptr if there's no space.
+	 */
+	unsigned char *acquireWrite(size_t &size);
+	/**
+	 * Publish data written into the space got by acquireWrite().
+	 */
+	size_t commitWrite(size_t size);
+	/**
+	 * Get contiguous data to read directly (zero-copy).
+	 * size is the requested length, and it's updated to the length actually available.
+	 * And we can give an offset where start to peek.
+	 * Returns nullptr if there's no data.
+	 */
+	unsigned char *peekRead(size_t &size, size_t offset = 0);
+	/**
+	 * Release data got by peekRead(), so writer can reuse the space.
+	 */
+	size_t consumeRead(size_t size);
 	/**
 	 * Get bytes of data available in stream buffer.
 	 */
@@ -105,13 +133,31 @@ public:
 	bool isEndOfStream();
 	size_t getBufferSize() { return mBufferSize; }
 	size_t getThreshold() { return mThreshold; }
+	bool isSingleProducerConsumer() { return mSPSC; }
+	/**
+	 * Sleep until there are at least 'want' bytes of data, or end of stream (SPSC mode).
+	 */
+	void waitForData(size_t want);
+	/**
+	 * Sleep until there are at least 'want' bytes of space, or end of stream (SPSC mode).
+	 */
+	void waitForSpace(size_t want);
+	/**
+	 * Wake reader/writer up if it's sleeping and what it wants is satisfied (SPSC mode).
+	 * Mutex is taken only if the peer really needs to be woken.
+	 */
+	void wakeReader();
+	void wakeWriter();
 
 private:
 	std::mutex mMutex;
 	std::condition_variable mCondv;
+	std::atomic<size_t> mDataWanted;
+	std::atomic<size_t> mSpaceWanted;
 	BufferObserverInterface *mObserver;
 	rb_t mRingBuf;
-	bool mEOS;
+	std::atomic<bool> mEOS;
+	bool mSPSC;
 	size_t mBufferSize;
 	size_t mThreshold;
 };
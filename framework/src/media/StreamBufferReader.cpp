@@ -17,6 +17,7 @@
  ******************************************************************/
 
 #include <iostream>
+#include <algorithm>
 #include <stdio.h>
 #include <assert.h>
 #include <debug.h>
@@ -36,6 +37,11 @@ StreamBufferReader::StreamBufferReader(std::shared_ptr<StreamBuffer> stream)
 size_t StreamBufferReader::copy(unsigned char *buf, size_t size, size_t offset)
 {
 	medvdbg("offset %lu, size %lu\n", offset, size);
+	if (mStream->isSingleProducerConsumer()) {
+		// Reader owns the read index, writer never touches the data we're copying.
+		return mStream->copy(buf, size, offset);
+	}
+
 	std::lock_guard<std::mutex> lock(mStream->getMutex());
 	size_t len = mStream->copy(buf, size, offset);
 	medvdbg("copied %lu\n", len);
@@ -45,6 +51,10 @@ size_t StreamBufferReader::copy(unsigned char *buf, size_t size, size_t offset)
 size_t StreamBufferReader::read(unsigned char *buf, size_t size, bool sync)
 {
 	medvdbg("size %lu sync %c\n", size, sync ? 'Y' : 'N');
+	if (mStream->isSingleProducerConsumer()) {
+		return readLockFree(buf, size, sync);
+	}
+
 	std::unique_lock<std::mutex> lock(mStream->getMutex());
 
 	size_t rlen = 0;
@@ -86,14 +96,117 @@ size_t StreamBufferReader::read(unsigned char *buf, size_t size, bool sync)
 	return rlen;
 }
 
+size_t StreamBufferReader::readLockFree(unsigned char *buf, size_t size, bool sync)
+{
+	size_t rlen = 0;
+
+	while (rlen < size) {
+		// Check EOS before reading, all data written before EOS was set is visible then.
+		bool eos = mStream->isEndOfStream();
+
+		// Read data from stream as much as possible
+		size_t temp = mStream->read(buf + rlen, size - rlen);
+		if (temp > 0) {
+			mStream->notifyObserver(StreamBuffer::State::UPDATED, -((ssize_t) temp));
+			// Writer may be waiting for more spaces
+			mStream->wakeWriter();
+			rlen += temp;
+		}
+
+		if (!sync || rlen == size) {
+			break;
+		}
+
+		if (eos) {
+			// End of stream, break reading
+			medvdbg("EOS break\n");
+			break;
+		}
+
+		medvdbg("read %lu/%lu\n", rlen, size);
+		// Notify observer, shouldn't be blocked.
+		mStream->notifyObserver(StreamBuffer::State::UNDERRUN);
+		// Then wait for writer, until the rest can be read or half of the buffer is filled.
+		size_t want = std::min(size - rlen, mStream->getBufferSize() / 2);
+		mStream->waitForData(std::max(want, (size_t)1));
+	}
+
+	medvdbg("read %lu\n", rlen);
+	return rlen;
+}
+
+unsigned char *StreamBufferReader::peekRead(size_t &size, bool sync, size_t offset)
+{
+	size_t want = size;
+	unsigned char *ptr;
+
+	if (mStream->isSingleProducerConsumer()) {
+		while (true) {
+			bool eos = mStream->isEndOfStream();
+			size = want;
+			ptr = mStream->peekRead(size, offset);
+			if (ptr || !sync || eos) {
+				break;
+			}
+			mStream->notifyObserver(StreamBuffer::State::UNDERRUN);
+			mStream->waitForData(offset + 1);
+		}
+	} else {
+		std::unique_lock<std::mutex> lock(mStream->getMutex());
+		while (true) {
+			size = want;
+			ptr = mStream->peekRead(size, offset);
+			if (ptr || !sync || mStream->isEndOfStream()) {
+				break;
+			}
+			mStream->notifyObserver(StreamBuffer::State::UNDERRUN);
+			mStream->getCondv().notify_one();
+			mStream->getCondv().wait(lock);
+		}
+	}
+
+	if (!ptr) {
+		size = 0;
+	}
+
+	medvdbg("peek %lu/%lu\n", size, want);
+	return ptr;
+}
+
+size_t StreamBufferReader::consumeRead(size_t size)
+{
+	size_t rlen;
+
+	if (mStream->isSingleProducerConsumer()) {
+		rlen = mStream->consumeRead(size);
+		mStream->notifyObserver(StreamBuffer::State::UPDATED, -((ssize_t) rlen));
+		mStream->wakeWriter();
+	} else {
+		std::lock_guard<std::mutex> lock(mStream->getMutex());
+		rlen = mStream->consumeRead(size);
+		mStream->notifyObserver(StreamBuffer::State::UPDATED, -((ssize_t) rlen));
+		mStream->getCondv().notify_one();
+	}
+
+	return rlen;
+}
+
 size_t StreamBufferReader::sizeOfData()
 {
+	if (mStream->isSingleProducerConsumer()) {
+		return mStream->sizeOfData();
+	}
+
 	std::lock_guard<std::mutex> lock(mStream->getMutex());
 	return mStream->sizeOfData();
 }
 
 bool StreamBufferReader::isEndOfStream()
 {
+	if (mStream->isSingleProducerConsumer()) {
+		return mStream->isEndOfStream();
+	}
+
 	std::lock_guard<std::mutex> lock(mStream->getMutex());
 	return mStream->isEndOfStream();
 }
@@ -34,11 +34,26 @@ public:
 	virtual size_t copy(unsigned char *buf, size_t size, size_t offset = 0);
 	virtual size_t read(unsigned char *buf, size_t size, bool sync = true);
 	virtual size_t sizeOfData();
+	/**
+	 * Get contiguous data to be processed in place (zero-copy).
+	 * size is the requested length, and it's updated to the length actually available,
+	 * which may be less than requested because of the ring buffer wrap-around.
+	 * Data before offset is skipped but stays in the buffer.
+	 * In sync mode, wait until there's any data after offset or end of stream.
+	 * Returns nullptr if there's no data.
+	 */
+	unsigned char *peekRead(size_t &size, bool sync = true, size_t offset = 0);
+	/**
+	 * Release data got by peekRead() after processing.
+	 */
+	size_t consumeRead(size_t size);
 
 public:
 	bool isEndOfStream();
 
 private:
+	size_t readLockFree(unsigned char *buf, size_t size, bool sync);
+
 	std::shared_ptr<StreamBuffer> mStream;
 };
 
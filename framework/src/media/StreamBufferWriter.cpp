@@ -17,6 +17,7 @@
  ******************************************************************/
 
 #include <iostream>
+#include <algorithm>
 #include <stdio.h>
 #include <assert.h>
 #include <debug.h>
@@ -36,6 +37,10 @@ StreamBufferWriter::StreamBufferWriter(std::shared_ptr<StreamBuffer> stream)
 size_t StreamBufferWriter::write(unsigned char *buf, size_t size, bool sync)
 {
 	medvdbg("size %lu sync %c\n", size, sync ? 'Y' : 'N');
+	if (mStream->isSingleProducerConsumer()) {
+		return writeLockFree(buf, size, sync);
+	}
+
 	std::unique_lock<std::mutex> lock(mStream->getMutex());
 
 	size_t wlen = 0;
@@ -76,14 +81,123 @@ size_t StreamBufferWriter::write(unsigned char *buf, size_t size, bool sync)
 	return wlen;
 }
 
+size_t StreamBufferWriter::getWakeUpSpace()
+{
+	// Sleeping writer is woken up when half of the buffer is free, rather than for every
+	// piece of data read. Reader never waits for more than half of the buffer neither,
+	// so they can not be waiting for each other.
+	return std::max(mStream->getBufferSize() / 2, (size_t)1);
+}
+
+size_t StreamBufferWriter::writeLockFree(unsigned char *buf, size_t size, bool sync)
+{
+	size_t wlen = 0;
+
+	while (wlen < size) {
+		// Streaming may be stopped (EOS was set)
+		if (sync && mStream->isEndOfStream()) {
+			// Don't need to write anymore
+			medvdbg("EOS break\n");
+			break;
+		}
+
+		// Write data into stream as much as possible
+		size_t temp = mStream->write(buf + wlen, size - wlen);
+		if (temp > 0) {
+			mStream->notifyObserver(StreamBuffer::State::UPDATED, (ssize_t) temp);
+			// Reader may be waiting for more data
+			mStream->wakeReader();
+			wlen += temp;
+		}
+
+		if (!sync || wlen == size) {
+			break;
+		}
+
+		medvdbg("written %lu/%lu\n", wlen, size);
+		// Notify observer, shouldn't be blocked.
+		mStream->notifyObserver(StreamBuffer::State::OVERRUN);
+		// Then wait for reader.
+		mStream->waitForSpace(getWakeUpSpace());
+	}
+
+	medvdbg("written %lu\n", wlen);
+	return wlen;
+}
+
+unsigned char *StreamBufferWriter::acquireWrite(size_t &size, bool sync)
+{
+	size_t want = size;
+	unsigned char *ptr = nullptr;
+
+	if (mStream->isSingleProducerConsumer()) {
+		while (!(sync && mStream->isEndOfStream())) {
+			size = want;
+			ptr = mStream->acquireWrite(size);
+			if (ptr || !sync) {
+				break;
+			}
+			mStream->notifyObserver(StreamBuffer::State::OVERRUN);
+			mStream->waitForSpace(getWakeUpSpace());
+		}
+	} else {
+		std::unique_lock<std::mutex> lock(mStream->getMutex());
+		while (!(sync && mStream->isEndOfStream())) {
+			size = want;
+			ptr = mStream->acquireWrite(size);
+			if (ptr || !sync) {
+				break;
+			}
+			mStream->notifyObserver(StreamBuffer::State::OVERRUN);
+			mStream->getCondv().notify_one();
+			mStream->getCondv().wait(lock);
+		}
+	}
+
+	if (!ptr) {
+		size = 0;
+	}
+
+	medvdbg("acquired %lu/%lu\n", size, want);
+	return ptr;
+}
+
+size_t StreamBufferWriter::commitWrite(size_t size)
+{
+	size_t wlen;
+
+	if (mStream->isSingleProducerConsumer()) {
+		wlen = mStream->commitWrite(size);
+		mStream->notifyObserver(StreamBuffer::State::UPDATED, (ssize_t) wlen);
+		mStream->wakeReader();
+	} else {
+		std::lock_guard<std::mutex> lock(mStream->getMutex());
+		wlen = mStream->commitWrite(size);
+		mStream->notifyObserver(StreamBuffer::State::UPDATED, (ssize_t) wlen);
+		mStream->getCondv().notify_one();
+	}
+
+	return wlen;
+}
+
 size_t StreamBufferWriter::sizeOfSpace()
 {
+	if (mStream->isSingleProducerConsumer()) {
+		return mStream->sizeOfSpace();
+	}
+
 	std::lock_guard<std::mutex> lock(mStream->getMutex());
 	return mStream->sizeOfSpace();
 }
 
 void StreamBufferWriter::setEndOfStream()
 {
+	if (mStream->isSingleProducerConsumer()) {
+		// Sleeping reader and writer are woken up by the stream buffer itself.
+		mStream->setEndOfStream();
+		return;
+	}
+
 	std::lock_guard<std::mutex> lock(mStream->getMutex());
 
 	// Set EOS flag in stream.
@@ -33,11 +33,26 @@ public:
 public:
 	virtual size_t write(unsigned char *buf, size_t size, bool sync = true);
 	virtual size_t sizeOfSpace();
+	/**
+	 * Get contiguous space to produce data in place (zero-copy).
+	 * size is the requested length, and it's updated to the length actually reserved,
+	 * which may be less than requested because of the ring buffer wrap-around.
+	 * In sync mode, wait until there's any space or end of stream.
+	 * Returns nullptr if there's no space.
+	 */
+	unsigned char *acquireWrite(size_t &size, bool sync = true);
+	/**
+	 * Publish data produced in the space got by acquireWrite().
+	 */
+	size_t commitWrite(size_t size);
 
 public:
 	void setEndOfStream();
 
 private:
+	size_t writeLockFree(unsigned char *buf, size_t size, bool sync);
+	size_t getWakeUpSpace();
+
 	std::shared_ptr<StreamBuffer> mStream;
 };
 
@@ -41,6 +41,9 @@ bool StreamHandler::open()
 		auto streamBuffer = StreamBuffer::Builder()
 								.setBufferSize(CONFIG_HANDLER_STREAM_BUFFER_SIZE)
 								.setThreshold(CONFIG_HANDLER_STREAM_BUFFER_THRESHOLD)
+#ifdef CONFIG_HANDLER_STREAM_BUFFER_SPSC
+								.setSingleProducerConsumer(true)
+#endif
 								.build();
 
 		if (!streamBuffer) {
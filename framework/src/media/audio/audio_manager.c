@@ -1268,6 +1268,24 @@ unsigned int get_output_frame_count(void)
 	return pcm_get_buffer_size(g_audio_out_cards[g_actual_audio_out_card_id].pcm);
 }
 
+unsigned int get_output_sample_rate(void)
+{
+	if ((g_actual_audio_out_card_id < 0) || (g_audio_out_cards[g_actual_audio_out_card_id].pcm == NULL)) {
+		return 0;
+	}
+
+	return pcm_get_rate(g_audio_out_cards[g_actual_audio_out_card_id].pcm);
+}
+
+unsigned int get_output_channels(void)
+{
+	if ((g_actual_audio_out_card_id < 0) || (g_audio_out_cards[g_actual_audio_out_card_id].pcm == NULL)) {
+		return 0;
+	}
+
+	return pcm_get_channels(g_audio_out_cards[g_actual_audio_out_card_id].pcm);
+}
+
 unsigned int get_card_output_frames_to_byte(unsigned int frames)
 {
 	if ((g_actual_audio_out_card_id < 0) || (frames == 0)) {
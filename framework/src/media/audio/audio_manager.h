@@ -323,6 +323,30 @@ unsigned int get_user_input_bytes_to_frame(unsigned int bytes);
  ****************************************************************************/
 unsigned int get_output_frame_count(void);
 
+/****************************************************************************
+ * Name: get_output_sample_rate
+ *
+ * Description:
+ *   Get the sample rate with which the pcm of the active output audio device
+ *   has been opened. It may differ from the rate given to set_audio_stream_out().
+ *
+ * Return Value:
+ *   On success, the sample rate of the output pcm. Otherwise, 0.
+ ****************************************************************************/
+unsigned int get_output_sample_rate(void);
+
+/****************************************************************************
+ * Name: get_output_channels
+ *
+ * Description:
+ *   Get the number of channels with which the pcm of the active output audio
+ *   device has been opened.
+ *
+ * Return Value:
+ *   On success, the number of channels of the output pcm. Otherwise, 0.
+ ****************************************************************************/
+unsigned int get_output_channels(void);
+
 /****************************************************************************
  * Name: get_card_output_frames_to_byte
  *
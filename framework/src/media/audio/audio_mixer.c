@@ -0,0 +1,701 @@
+/****************************************************************************
+ *
+ * Copyright 2018 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <pthread.h>
+#include <debug.h>
+#include <tinyalsa/tinyalsa.h>
+#include "audio_mixer.h"
+#include "resample/samplerate.h"
+#include "../utils/rb.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+#ifndef CONFIG_AUDIO_MIXER_MAX_STREAMS
+#define CONFIG_AUDIO_MIXER_MAX_STREAMS 4
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_SAMPLE_RATE
+#define CONFIG_AUDIO_MIXER_SAMPLE_RATE 48000
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_CHANNELS
+#define CONFIG_AUDIO_MIXER_CHANNELS 2
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_PERIOD_FRAMES
+#define CONFIG_AUDIO_MIXER_PERIOD_FRAMES 512
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_STREAM_PERIODS
+#define CONFIG_AUDIO_MIXER_STREAM_PERIODS 4
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_PRIORITY
+#define CONFIG_AUDIO_MIXER_PRIORITY 110
+#endif
+
+#ifndef CONFIG_AUDIO_MIXER_STACKSIZE
+#define CONFIG_AUDIO_MIXER_STACKSIZE 2048
+#endif
+
+#ifndef CONFIG_AUDIO_RESAMPLER_BUFSIZE
+#define CONFIG_AUDIO_RESAMPLER_BUFSIZE 4096
+#endif
+
+#define MIXER_SAMPLE_BYTES sizeof(int16_t)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+struct audio_mixer_stream_s {
+	bool used;
+	bool running;               // frames are taken by the mixer
+	bool draining;              // becomes idle once the queue is empty
+	uint16_t gain;              // Q15
+	unsigned int channels;
+	unsigned int sample_rate;
+	unsigned int frame_bytes;   // bytes per frame of the user format
+	src_handle_t src;           // NULL if the user format equals the card format
+	rb_t queue;                 // frames converted to the card format
+};
+
+struct audio_mixer_s {
+	pthread_t thread;
+	bool running;
+	bool card_running;          // frames have been written since the card was paused
+	int nstreams;
+	unsigned int channels;      // of the output card
+	unsigned int sample_rate;   // of the output card
+	unsigned int frame_bytes;   // of the output card
+	int32_t *accum;
+	int16_t *out;
+	struct audio_mixer_stream_s streams[CONFIG_AUDIO_MIXER_MAX_STREAMS];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+static struct audio_mixer_s g_mixer;
+
+/* g_mixer_ctrl serializes open/close which start and stop the mixer thread,
+ * g_mixer_lock protects the stream states against the mixer thread.
+ */
+static pthread_mutex_t g_mixer_ctrl = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_mixer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_mixer_data_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_mixer_space_cond = PTHREAD_COND_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+static struct audio_mixer_stream_s *get_stream(int id)
+{
+	if ((id < 0) || (id >= CONFIG_AUDIO_MIXER_MAX_STREAMS) || !g_mixer.streams[id].used) {
+		meddbg("Invalid mixer stream id : %d\n", id);
+		return NULL;
+	}
+
+	return &g_mixer.streams[id];
+}
+
+static void mixer_accumulate(int32_t *accum, const int16_t *in, unsigned int samples, uint16_t gain)
+{
+	unsigned int i;
+
+	if (gain == AUDIO_MIXER_GAIN_UNITY) {
+		for (i = 0; i < samples; i++) {
+			accum[i] += in[i];
+		}
+		return;
+	}
+
+	for (i = 0; i < samples; i++) {
+		accum[i] += ((int32_t)in[i] * gain) >> 15;
+	}
+}
+
+static void mixer_saturate(int16_t *out, const int32_t *accum, unsigned int samples)
+{
+	unsigned int i;
+	int32_t sample;
+
+	for (i = 0; i < samples; i++) {
+		sample = accum[i];
+		if (sample > INT16_MAX) {
+			sample = INT16_MAX;
+		} else if (sample < INT16_MIN) {
+			sample = INT16_MIN;
+		}
+		out[i] = (int16_t)sample;
+	}
+}
+
+/* Called with g_mixer_lock held.
+ * A period is mixed as soon as any running stream has a full period queued,
+ * streams which are behind contribute what they have. So a slow stream never
+ * delays the others, and a new stream is heard after at most one period.
+ */
+static bool mixer_is_ready(void)
+{
+	size_t period = CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.frame_bytes;
+	size_t used;
+	int i;
+
+	for (i = 0; i < CONFIG_AUDIO_MIXER_MAX_STREAMS; i++) {
+		struct audio_mixer_stream_s *s = &g_mixer.streams[i];
+		if (!s->used || !s->running) {
+			continue;
+		}
+		used = rb_used(&s->queue);
+		if ((used >= period) || (s->draining && used > 0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool mixer_has_running_stream(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_AUDIO_MIXER_MAX_STREAMS; i++) {
+		if (g_mixer.streams[i].used && g_mixer.streams[i].running) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Called with g_mixer_lock held. Returns the number of frames mixed into g_mixer.out */
+static unsigned int mixer_mix_period(void)
+{
+	size_t period = CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.frame_bytes;
+	size_t done;
+	size_t len;
+	size_t max_done = 0;
+	int16_t *span;
+	int i;
+
+	memset(g_mixer.accum, 0, CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.channels * sizeof(int32_t));
+
+	for (i = 0; i < CONFIG_AUDIO_MIXER_MAX_STREAMS; i++) {
+		struct audio_mixer_stream_s *s = &g_mixer.streams[i];
+		if (!s->used || !s->running) {
+			continue;
+		}
+
+		done = 0;
+		while (done < period) {
+			len = period - done;
+			span = (int16_t *)rb_peek_read(&s->queue, &len);
+			if (!span) {
+				break;
+			}
+			mixer_accumulate(g_mixer.accum + done / MIXER_SAMPLE_BYTES, span, len / MIXER_SAMPLE_BYTES, s->gain);
+			rb_consume_read(&s->queue, len);
+			done += len;
+		}
+
+		if (done > max_done) {
+			max_done = done;
+		}
+
+		if (s->draining && rb_used(&s->queue) == 0) {
+			medvdbg("mixer stream %d drained\n", i);
+			s->draining = false;
+			s->running = false;
+		}
+	}
+
+	mixer_saturate(g_mixer.out, g_mixer.accum, max_done / MIXER_SAMPLE_BYTES);
+
+	return max_done / g_mixer.frame_bytes;
+}
+
+static void *audio_mixer_thread(void *arg)
+{
+	unsigned int frames;
+	int ret;
+
+	pthread_mutex_lock(&g_mixer_lock);
+	while (g_mixer.running) {
+		if (!mixer_is_ready()) {
+			/* Pause the card while nothing is running so that it does not underrun */
+			if (g_mixer.card_running && !mixer_has_running_stream()) {
+				pause_audio_stream_out();
+				g_mixer.card_running = false;
+			}
+			pthread_cond_wait(&g_mixer_data_cond, &g_mixer_lock);
+			continue;
+		}
+
+		frames = mixer_mix_period();
+		pthread_cond_broadcast(&g_mixer_space_cond);
+		pthread_mutex_unlock(&g_mixer_lock);
+
+		if (frames > 0) {
+			ret = start_audio_stream_out(g_mixer.out, frames);
+			if (ret < 0) {
+				meddbg("mixer failed to write %u frames, ret : %d\n", frames, ret);
+			}
+		}
+
+		pthread_mutex_lock(&g_mixer_lock);
+		g_mixer.card_running = true;
+	}
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	return NULL;
+}
+
+/* Called with g_mixer_ctrl held */
+static audio_manager_result_t mixer_start(void)
+{
+	audio_manager_result_t ret;
+	unsigned int channels;
+	unsigned int sample_rate;
+	struct sched_param sparam;
+	pthread_attr_t attr;
+
+	ret = set_audio_stream_out(CONFIG_AUDIO_MIXER_CHANNELS, CONFIG_AUDIO_MIXER_SAMPLE_RATE, PCM_FORMAT_S16_LE);
+	if (ret != AUDIO_MANAGER_SUCCESS) {
+		meddbg("mixer failed to open the output card, ret : %d\n", ret);
+		return ret;
+	}
+
+	/* Open the card with its own format so that streams are converted only once */
+	channels = get_output_channels();
+	sample_rate = get_output_sample_rate();
+	if ((channels != CONFIG_AUDIO_MIXER_CHANNELS) || (sample_rate != CONFIG_AUDIO_MIXER_SAMPLE_RATE)) {
+		medvdbg("mixer reopens the card with %u channels, %u Hz\n", channels, sample_rate);
+		reset_audio_stream_out();
+		ret = set_audio_stream_out(channels, sample_rate, PCM_FORMAT_S16_LE);
+		if (ret != AUDIO_MANAGER_SUCCESS) {
+			meddbg("mixer failed to reopen the output card, ret : %d\n", ret);
+			return ret;
+		}
+	}
+
+	g_mixer.channels = channels;
+	g_mixer.sample_rate = sample_rate;
+	g_mixer.frame_bytes = channels * MIXER_SAMPLE_BYTES;
+	g_mixer.accum = (int32_t *)malloc(CONFIG_AUDIO_MIXER_PERIOD_FRAMES * channels * sizeof(int32_t));
+	g_mixer.out = (int16_t *)malloc(CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.frame_bytes);
+	if (!g_mixer.accum || !g_mixer.out) {
+		meddbg("mixer buffer allocation failed\n");
+		ret = AUDIO_MANAGER_OPERATION_FAIL;
+		goto errout;
+	}
+
+	g_mixer.running = true;
+	g_mixer.card_running = false;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, CONFIG_AUDIO_MIXER_STACKSIZE);
+	sparam.sched_priority = CONFIG_AUDIO_MIXER_PRIORITY;
+	pthread_attr_setschedparam(&attr, &sparam);
+	if (pthread_create(&g_mixer.thread, &attr, audio_mixer_thread, NULL) != OK) {
+		meddbg("mixer thread creation failed\n");
+		g_mixer.running = false;
+		ret = AUDIO_MANAGER_OPERATION_FAIL;
+		goto errout;
+	}
+	pthread_setname_np(g_mixer.thread, "AudioMixer");
+
+	return AUDIO_MANAGER_SUCCESS;
+
+errout:
+	free(g_mixer.accum);
+	free(g_mixer.out);
+	g_mixer.accum = NULL;
+	g_mixer.out = NULL;
+	reset_audio_stream_out();
+	return ret;
+}
+
+/* Called with g_mixer_ctrl held */
+static void mixer_stop(void)
+{
+	pthread_mutex_lock(&g_mixer_lock);
+	g_mixer.running = false;
+	pthread_cond_signal(&g_mixer_data_cond);
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	pthread_join(g_mixer.thread, NULL);
+
+	reset_audio_stream_out();
+
+	free(g_mixer.accum);
+	free(g_mixer.out);
+	g_mixer.accum = NULL;
+	g_mixer.out = NULL;
+}
+
+static void mixer_signal_data(void)
+{
+	pthread_mutex_lock(&g_mixer_lock);
+	pthread_cond_signal(&g_mixer_data_cond);
+	pthread_mutex_unlock(&g_mixer_lock);
+}
+
+static unsigned int stream_avail_frames(struct audio_mixer_stream_s *s)
+{
+	unsigned int frames = rb_avail(&s->queue) / g_mixer.frame_bytes;
+
+	if (s->sample_rate != g_mixer.sample_rate) {
+		frames = (unsigned int)(((uint64_t)frames * s->sample_rate) / g_mixer.sample_rate);
+	}
+
+	return frames;
+}
+
+/* Convert user frames straight into the free space of the queue.
+ * Only the writer of the stream touches the write side of the queue, no lock is needed.
+ */
+static int stream_convert(struct audio_mixer_stream_s *s, const void *data, unsigned int frames)
+{
+	src_data_t src_data = { 0, };
+	unsigned int used_frames = 0;
+	size_t len;
+	void *span;
+	int ret;
+
+	src_data.origin_channel_num = s->channels;
+	src_data.origin_sample_rate = s->sample_rate;
+	src_data.origin_sample_width = SAMPLE_WIDTH_16BITS;
+	src_data.desired_channel_num = g_mixer.channels;
+	src_data.desired_sample_rate = g_mixer.sample_rate;
+	src_data.desired_sample_width = SAMPLE_WIDTH_16BITS;
+
+	while (used_frames < frames) {
+		// The queue holds whole frames, so the span ends at a frame boundary
+		len = CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.frame_bytes;
+		span = rb_acquire_write(&s->queue, &len);
+		if (!span || len < g_mixer.frame_bytes) {
+			break;
+		}
+
+		src_data.data_in = (const void *)((const char *)data + used_frames * s->frame_bytes);
+		src_data.input_frames = frames - used_frames;
+		src_data.data_out = span;
+		src_data.out_buf_length = len;
+
+		ret = src_simple(s->src, &src_data);
+		if (ret < 0) {
+			meddbg("mixer failed to resample, error %d\n", ret);
+			return (used_frames > 0) ? (int)used_frames : AUDIO_MANAGER_RESAMPLE_FAIL;
+		}
+
+		used_frames += src_data.input_frames_used;
+		rb_commit_write(&s->queue, src_data.output_frames_gen * g_mixer.frame_bytes);
+		if ((src_data.input_frames_used == 0) && (src_data.output_frames_gen == 0)) {
+			break;
+		}
+	}
+
+	return (int)used_frames;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+int audio_mixer_stream_open(unsigned int channels, unsigned int sample_rate, int format)
+{
+	struct audio_mixer_stream_s *s = NULL;
+	audio_manager_result_t ret;
+	int id;
+
+	if ((channels == 0) || (sample_rate == 0) || (pcm_format_to_bits((enum pcm_format)format) != 16)) {
+		meddbg("mixer stream not supported, channels %u rate %u format %d\n", channels, sample_rate, format);
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&g_mixer_ctrl);
+
+	for (id = 0; id < CONFIG_AUDIO_MIXER_MAX_STREAMS; id++) {
+		if (!g_mixer.streams[id].used) {
+			s = &g_mixer.streams[id];
+			break;
+		}
+	}
+	if (!s) {
+		meddbg("No free mixer stream, max : %d\n", CONFIG_AUDIO_MIXER_MAX_STREAMS);
+		ret = AUDIO_MANAGER_DEVICE_ALREADY_IN_USE;
+		goto errout;
+	}
+
+	if (g_mixer.nstreams == 0) {
+		ret = mixer_start();
+		if (ret != AUDIO_MANAGER_SUCCESS) {
+			goto errout;
+		}
+	}
+
+	memset(s, 0, sizeof(struct audio_mixer_stream_s));
+	s->channels = channels;
+	s->sample_rate = sample_rate;
+	s->frame_bytes = channels * MIXER_SAMPLE_BYTES;
+	s->gain = AUDIO_MIXER_GAIN_UNITY;
+
+	if ((channels != g_mixer.channels) || (sample_rate != g_mixer.sample_rate)) {
+		if (!src_is_valid_ratio((float)sample_rate / (float)g_mixer.sample_rate)) {
+			meddbg("mixer can't resample %u Hz to %u Hz\n", sample_rate, g_mixer.sample_rate);
+			ret = AUDIO_MANAGER_RESAMPLE_FAIL;
+			goto errout_with_mixer;
+		}
+		s->src = src_init(CONFIG_AUDIO_RESAMPLER_BUFSIZE);
+		if (!s->src) {
+			meddbg("src_init failed\n");
+			ret = AUDIO_MANAGER_RESAMPLE_FAIL;
+			goto errout_with_mixer;
+		}
+	}
+
+	if (!rb_init(&s->queue, CONFIG_AUDIO_MIXER_STREAM_PERIODS * CONFIG_AUDIO_MIXER_PERIOD_FRAMES * g_mixer.frame_bytes)) {
+		meddbg("mixer stream queue allocation failed\n");
+		ret = AUDIO_MANAGER_OPERATION_FAIL;
+		goto errout_with_src;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	s->used = true;
+	pthread_mutex_unlock(&g_mixer_lock);
+	g_mixer.nstreams++;
+
+	pthread_mutex_unlock(&g_mixer_ctrl);
+	medvdbg("mixer stream %d opened, channels %u rate %u\n", id, channels, sample_rate);
+	return id;
+
+errout_with_src:
+	if (s->src) {
+		src_destroy(s->src);
+		s->src = NULL;
+	}
+errout_with_mixer:
+	if (g_mixer.nstreams == 0) {
+		mixer_stop();
+	}
+errout:
+	pthread_mutex_unlock(&g_mixer_ctrl);
+	return ret;
+}
+
+audio_manager_result_t audio_mixer_stream_close(int id)
+{
+	struct audio_mixer_stream_s *s;
+
+	pthread_mutex_lock(&g_mixer_ctrl);
+
+	s = get_stream(id);
+	if (!s) {
+		pthread_mutex_unlock(&g_mixer_ctrl);
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	s->used = false;
+	s->running = false;
+	s->draining = false;
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	rb_free(&s->queue);
+	if (s->src) {
+		src_destroy(s->src);
+		s->src = NULL;
+	}
+
+	if (--g_mixer.nstreams == 0) {
+		mixer_stop();
+	}
+
+	pthread_mutex_unlock(&g_mixer_ctrl);
+	medvdbg("mixer stream %d closed\n", id);
+	return AUDIO_MANAGER_SUCCESS;
+}
+
+audio_manager_result_t audio_mixer_stream_start(int id)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	s->running = true;
+	s->draining = false;
+	pthread_cond_signal(&g_mixer_data_cond);
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	return AUDIO_MANAGER_SUCCESS;
+}
+
+audio_manager_result_t audio_mixer_stream_pause(int id)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	s->running = false;
+	s->draining = false;
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	return AUDIO_MANAGER_SUCCESS;
+}
+
+audio_manager_result_t audio_mixer_stream_stop(int id, bool drain)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	if (drain && s->running && rb_used(&s->queue) > 0) {
+		s->draining = true;
+		pthread_cond_signal(&g_mixer_data_cond);
+	} else {
+		s->running = false;
+		s->draining = false;
+		rb_reset(&s->queue);
+	}
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	/* Frames kept inside the resampler belong to the stopped stream */
+	if (s->src) {
+		src_destroy(s->src);
+		s->src = src_init(CONFIG_AUDIO_RESAMPLER_BUFSIZE);
+		if (!s->src) {
+			meddbg("src_init failed\n");
+			return AUDIO_MANAGER_RESAMPLE_FAIL;
+		}
+	}
+
+	return AUDIO_MANAGER_SUCCESS;
+}
+
+int audio_mixer_stream_write(int id, const void *data, unsigned int frames)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	int written;
+	size_t len;
+
+	if (!s || !data) {
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	if ((s->channels != g_mixer.channels) || (s->sample_rate != g_mixer.sample_rate)) {
+		if (!s->src) {
+			return AUDIO_MANAGER_RESAMPLE_FAIL;
+		}
+		written = stream_convert(s, data, frames);
+	} else {
+		len = rb_avail(&s->queue);
+		if (len > frames * s->frame_bytes) {
+			len = frames * s->frame_bytes;
+		}
+		len -= len % s->frame_bytes;
+		written = (int)(rb_write(&s->queue, data, len) / s->frame_bytes);
+	}
+
+	if (written > 0) {
+		mixer_signal_data();
+	}
+
+	return written;
+}
+
+unsigned int audio_mixer_stream_get_avail(int id)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return 0;
+	}
+
+	return stream_avail_frames(s);
+}
+
+audio_manager_result_t audio_mixer_stream_set_gain(int id, uint16_t gain)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return AUDIO_MANAGER_INVALID_PARAM;
+	}
+
+	if (gain > AUDIO_MIXER_GAIN_UNITY) {
+		gain = AUDIO_MIXER_GAIN_UNITY;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	s->gain = gain;
+	pthread_mutex_unlock(&g_mixer_lock);
+
+	return AUDIO_MANAGER_SUCCESS;
+}
+
+unsigned int audio_mixer_stream_frames_to_byte(int id, unsigned int frames)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return 0;
+	}
+
+	return frames * s->frame_bytes;
+}
+
+unsigned int audio_mixer_stream_bytes_to_frame(int id, unsigned int bytes)
+{
+	struct audio_mixer_stream_s *s = get_stream(id);
+	if (!s) {
+		return 0;
+	}
+
+	return bytes / s->frame_bytes;
+}
+
+void audio_mixer_wait_avail(void)
+{
+	struct timespec abstime;
+	unsigned int rate = g_mixer.sample_rate ? g_mixer.sample_rate : CONFIG_AUDIO_MIXER_SAMPLE_RATE;
+
+	/* A missed wakeup costs at most one period */
+	clock_gettime(CLOCK_REALTIME, &abstime);
+	abstime.tv_nsec += (long)((uint64_t)CONFIG_AUDIO_MIXER_PERIOD_FRAMES * 1000000000 / rate);
+	while (abstime.tv_nsec >= 1000000000) {
+		abstime.tv_sec++;
+		abstime.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&g_mixer_lock);
+	pthread_cond_timedwait(&g_mixer_space_cond, &g_mixer_lock, &abstime);
+	pthread_mutex_unlock(&g_mixer_lock);
+}
@@ -0,0 +1,214 @@
+/****************************************************************************
+ *
+ * Copyright 2018 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/**
+ * @file audio_mixer.h
+ * @brief Software mixer which sums several output streams into the active output card.
+ */
+
+#ifndef __AUDIO_MIXER_H
+#define __AUDIO_MIXER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "audio_manager.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+/**
+ * @brief Unity gain of a mixer stream in Q15.
+ */
+#define AUDIO_MIXER_GAIN_UNITY 32768
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+/****************************************************************************
+ * Name: audio_mixer_stream_open
+ *
+ * Description:
+ *   Open a new stream on the mixer. The stream is converted from the given
+ *   format to the format of the output card while it is written. The output
+ *   card is opened with the first stream and kept running until the last
+ *   stream is closed. A new stream is paused and has unity gain.
+ *
+ * Input parameters:
+ *   channels: number of channels of the stream
+ *   sample_rate: sample rate of the stream
+ *   format: pcm format of the stream, only 16-bit samples are supported
+ *
+ * Return Value:
+ *   On success, id of the stream (>= 0). Otherwise, a negative value.
+ ****************************************************************************/
+int audio_mixer_stream_open(unsigned int channels, unsigned int sample_rate, int format);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_close
+ *
+ * Description:
+ *   Close the stream. The queued frames which are not mixed yet are dropped.
+ *
+ * Input parameters:
+ *   id: id of the stream returned by audio_mixer_stream_open()
+ *
+ * Return Value:
+ *   On success, AUDIO_MANAGER_SUCCESS. Otherwise, a negative value.
+ ****************************************************************************/
+audio_manager_result_t audio_mixer_stream_close(int id);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_start
+ *
+ * Description:
+ *   Let the mixer take frames from the stream.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *
+ * Return Value:
+ *   On success, AUDIO_MANAGER_SUCCESS. Otherwise, a negative value.
+ ****************************************************************************/
+audio_manager_result_t audio_mixer_stream_start(int id);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_pause
+ *
+ * Description:
+ *   Stop taking frames from the stream. The queued frames are kept and
+ *   mixed again after audio_mixer_stream_start(). Other streams keep playing.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *
+ * Return Value:
+ *   On success, AUDIO_MANAGER_SUCCESS. Otherwise, a negative value.
+ ****************************************************************************/
+audio_manager_result_t audio_mixer_stream_pause(int id);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_stop
+ *
+ * Description:
+ *   Stop the stream. If drain is set, the queued frames are still mixed and
+ *   the stream becomes idle when they are consumed. Otherwise, the queued
+ *   frames are dropped at once. This function does not block.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *   drain: whether the queued frames should be played out
+ *
+ * Return Value:
+ *   On success, AUDIO_MANAGER_SUCCESS. Otherwise, a negative value.
+ ****************************************************************************/
+audio_manager_result_t audio_mixer_stream_stop(int id, bool drain);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_write
+ *
+ * Description:
+ *   Queue frames to the stream without blocking. Only as many frames as fit
+ *   in the queue of the stream are taken, see audio_mixer_stream_get_avail().
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *   data: frames in the format given to audio_mixer_stream_open()
+ *   frames: number of frames in data
+ *
+ * Return Value:
+ *   On success, the number of frames taken. Otherwise, a negative value.
+ ****************************************************************************/
+int audio_mixer_stream_write(int id, const void *data, unsigned int frames);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_get_avail
+ *
+ * Description:
+ *   Get the number of frames which can be written to the stream right now.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *
+ * Return Value:
+ *   The number of frames in the format of the stream, 0 on failure.
+ ****************************************************************************/
+unsigned int audio_mixer_stream_get_avail(int id);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_set_gain
+ *
+ * Description:
+ *   Set the gain applied to the stream while mixing.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *   gain: gain in Q15, from 0 to AUDIO_MIXER_GAIN_UNITY
+ *
+ * Return Value:
+ *   On success, AUDIO_MANAGER_SUCCESS. Otherwise, a negative value.
+ ****************************************************************************/
+audio_manager_result_t audio_mixer_stream_set_gain(int id, uint16_t gain);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_frames_to_byte
+ *
+ * Description:
+ *   Get the byte size of the given frame value in the format of the stream.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *   frames: the target of which byte size is returned
+ *
+ * Return Value:
+ *   On success, the byte size of the frames. Otherwise, 0.
+ ****************************************************************************/
+unsigned int audio_mixer_stream_frames_to_byte(int id, unsigned int frames);
+
+/****************************************************************************
+ * Name: audio_mixer_stream_bytes_to_frame
+ *
+ * Description:
+ *   Get the number of frames for the given byte size in the format of the stream.
+ *
+ * Input parameters:
+ *   id: id of the stream
+ *   bytes: the target of which frame count is returned
+ *
+ * Return Value:
+ *   On success, the number of frames. Otherwise, 0.
+ ****************************************************************************/
+unsigned int audio_mixer_stream_bytes_to_frame(int id, unsigned int bytes);
+
+/****************************************************************************
+ * Name: audio_mixer_wait_avail
+ *
+ * Description:
+ *   Block until the mixer has consumed frames from any stream, but not longer
+ *   than one mixer period. Writers use it to wait for space in several
+ *   streams at once.
+ ****************************************************************************/
+void audio_mixer_wait_avail(void);
+
+#if defined(__cplusplus)
+}								/* extern "C" */
+#endif
+#endif
@@ -28,9 +28,9 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 #include "samplerate.h"
 #include "../../utils/remix.h"
+#include "../../utils/pcm_kernels.h"
 
 
 /****************************************************************************
@@ -44,10 +44,7 @@
 #define MINIMUM(a, b)   (((a) < (b)) ? (a) : (b))
 
 // Fraction part bits
-#define FRACBITS            (16)
-
-// Convert to 16.16 fixed point value
-#define TO_16_16_FIXED(x)   ((uint32_t)((float)(x) * (float)(1 << FRACBITS) + 0.5f))
+#define FRACBITS            PCM_FRACBITS
 
 // Int part value: 16.0 fixed point
 #define INTPART_VALUE(x)    ((x) >> FRACBITS)
@@ -55,24 +52,12 @@
 // Fraction part value: 0.16 fixed point
 #define FRACPART_VALUE(x)   ((x) & 0xffff)
 
-// Calculate new sample data
-#define CALC_NEW_SAMPLE(s1, s2, part) ((s1) + INTPART_VALUE(((s2) - (s1)) * (int32_t)(part)))
-
 // Convert sample width in bytes
 #define BYTES_PER_SAMPLE(bits_per_sample)   ((bits_per_sample) >> 3)
 
-// Round the given positive float number to the nearest integer
-#define LRINTPF(pf) ((long)((float)(pf) + 0.5f))
-
 // Max channel num supported for SRC
 #define SRC_MAX_CH  (2)
 
-// Down resample ratio for 44.1k->32k, 22.05k->16k and 11.025k->8k
-#define DOWN_RESAMPLE_441_320_RATIO ((float)441 / (float)320)
-
-#define FLOAT_ACCURACY      (0.000001f)
-#define FLOAT_EQUAL(a, b)   (fabsf((a)-(b)) < FLOAT_ACCURACY)
-
 #define NUM_COEFF_22KHZ (sizeof(filter_22khz_coeff) / sizeof(filter_22khz_coeff[0]))
 #define OVERLAP_22KHZ   (NUM_COEFF_22KHZ - 2)
 
@@ -108,109 +93,67 @@ struct src_context_s {
 	int in_buffer_frames;   // internal input buffer capability in frames
 	int left_frames;        // number of frames remained in internal input buffer
 	int used_frames;        // number of frames used in internal input buffer
+	int filtered_frames;    // number of frames already filtered at the head of internal buffer
 	int old_channel_num;    // memorize old channel number
 	int new_channel_num;    // memorize new channel number
 	int old_sample_rate;    // memorize old sample rate
 	int new_sample_rate;    // memorize new sample rate
 	int old_sample_width;   // memorize old sample width(format)
 	int new_sample_width;   // memorize new sample width(format)
-	const int *filter_coeff;// pointer to filter coefficient array
-	int overlap_frames;     // number of overlap frames reserved in internal buffer
-	float ratio;            // (float)new_sample_rate / (float)old_sample_rate
-	float inverse_ratio;    // (float)old_sample_rate / (float)new_sample_rate
+	const int16_t *filter_coeff;// pointer to Q14 filter coefficient array
+	int overlap_frames;     // number of overlap frames the filter reads after a frame
+	int reserved_frames;    // number of frames kept in internal buffer for next call
+	uint32_t step;          // 16.16 fixed point old_sample_rate / new_sample_rate
+	uint32_t decimation;    // old_sample_rate / new_sample_rate, used by downresample_int()
 	uint32_t fp_frac;       // fraction part value of last fixed point index
 	/**
 	 * @brief   Function pointer to resampling process function
 	 * @param   src_context_t *: pointer to resampler object.
 	 * @param   int32_t *: give number of frames available for converting
 	 *                     and retrieve number of frames used actually.
+	 * @param   int32_t: max number of frames to generate
 	 * @return  number of frames generated
 	 */
-	int32_t (*src_func)(struct src_context_s *, int32_t *);
+	int32_t (*src_func)(struct src_context_s *, int32_t *, int32_t);
 };
 
 typedef struct src_context_s src_context_t;
 
 /**
- * 16.16 fixed point FIR filter coefficients for conversion 44100 -> 22050.
+ * Q14 FIR filter coefficients for conversion 44100 -> 22050.
  * (Works equivalently for 22010 -> 11025 or any other halving, of course.)
+ * Integer part of the former 16.16 fixed point table, only the first
+ * OVERLAP_22KHZ taps are applied.
  */
-static const int32_t filter_22khz_coeff[] = {
-	2089257, 2898328, -5820678, -10484531,
-	19038724, 30542725, -50469415, -81505260,
-	152544464, 478517512, 478517512, 152544464,
-	-81505260, -50469415, 30542725, 19038724,
-	-10484531, -5820678, 2898328, 2089257,
+static const int16_t filter_22khz_coeff[] = {
+	31, 44, -89, -160,
+	290, 466, -771, -1244,
+	2327, 7301, 7301, 2327,
+	-1244, -771, 466, 290,
+	-160, -89, 44, 31,
 };
 
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
-/**
- * @brief   Do convolution calculation for sample data
- * @remarks FIR: Finite Impulse Response
- * @param   input: pointer to input samples buffer.
- * @param   coeff: pointer to coefficient array for convolution.
- * @param   num_samples: num of coefficients in array.
- * @param   channels_num: num of channels of input samples.
- * @return  value of convolution result.
- * @see
- */
-static int32_t fir_convolve(const int16_t *input, const int32_t *coeff, int32_t num_samples, int32_t channels_num)
-{
-	int32_t sum = 1 << 13;
-	int32_t i;
-	for (i = 0; i < num_samples; ++i) {
-		sum += input[i * channels_num] * (coeff[i] >> 16);
-	}
-	return sum >> 14;
-}
-
-/**
- * @brief   Clip an integer value (32 bits) to a signed short type value(16 bits)
- * @remarks int16_t value in range [INT16_MIN, INT16_MAX], which is defined in <stdint.h>
- * @param   x: input 32 bits integer value.
- * @return  output 16 bits signed short value.
- */
-static int16_t clip(int32_t x)
-{
-	if (x < INT16_MIN) {
-		return INT16_MIN;
-	} else if (x > INT16_MAX) {
-		return INT16_MAX;
-	}
-
-	return x;
-}
-
 /**
  * It handles sample rate up scaling in all ratio cases (i.e. inverse ratio 0.*)
  * and sample rate down scaling cases in inverse ratio 1.* and 2.* with fraction.
+ * Output frames are generated while the fixed point index stays in the given
+ * input frames, so the frame after the last input frame must be available,
+ * and filtered if a filter applies.
  */
-static int32_t resample_frac(src_context_t *src, int32_t *num_frames_in)
+static int32_t resample_frac(src_context_t *src, int32_t *num_frames_in, int32_t max_frames_out)
 {
-	int32_t num_frames_out = (int32_t)((float)*num_frames_in * src->ratio);
-	const int16_t *input = src->in_buffer;
-	int16_t *output = src->out_buffer;
-	int32_t channels_num = src->new_channel_num;
-	uint32_t step = TO_16_16_FIXED(src->inverse_ratio);
-	uint32_t fp_index = src->fp_frac;
-	uint32_t whole, frac;
-	int32_t i, j, s1, s2;
-
-	for (i = 0; i < num_frames_out; ++i, fp_index += step) {
-		whole = INTPART_VALUE(fp_index);
-		frac = FRACPART_VALUE(fp_index);
-		for (j = 0; j < channels_num; j++) {
-			s1 = input[whole * channels_num + j];
-			s2 = input[(whole + 1) * channels_num + j];
-			*output++ = clip(CALC_NEW_SAMPLE(s1, s2, frac));
-		}
-	}
+	uint32_t span = ((uint32_t)*num_frames_in << FRACBITS) - src->fp_frac;
+	int32_t num_frames_out = (int32_t)((span + src->step - 1) / src->step);
+	num_frames_out = MINIMUM(num_frames_out, max_frames_out);
+
+	uint32_t fp_index = pcm_interp_q15(src->in_buffer, src->out_buffer, num_frames_out, src->new_channel_num, src->fp_frac, src->step);
 
 	*num_frames_in = INTPART_VALUE(fp_index);
-	src->fp_frac = FRACPART_VALUE(fp_index);;
+	src->fp_frac = FRACPART_VALUE(fp_index);
 	return num_frames_out;
 }
 
@@ -220,24 +163,24 @@ static int32_t resample_frac(src_context_t *src, int32_t *num_frames_in)
  * but downresample_int() is more efficient in special inverse ratio 2.0 and 3.0 cases.
  * Optimization: The fraction value of fp_index is always 0, so remove unnecessary calculation.
  */
-static int32_t downresample_int(src_context_t *src, int32_t *num_frames_in)
+static int32_t downresample_int(src_context_t *src, int32_t *num_frames_in, int32_t max_frames_out)
 {
-	int32_t quotient = (int32_t)src->inverse_ratio;
-	*num_frames_in = *num_frames_in / quotient * quotient;
-	int32_t num_frames_out = *num_frames_in / quotient;
+	int32_t quotient = (int32_t)src->decimation;
+	int32_t num_frames_out = MINIMUM(*num_frames_in / quotient, max_frames_out);
+	*num_frames_in = num_frames_out * quotient;
 
 	const int16_t *input = src->in_buffer;
 	int16_t *output = src->out_buffer;
-	int32_t channels_num = src->new_channel_num;
-	uint32_t step = TO_16_16_FIXED(quotient);
-	uint32_t fp_index = 0;
-	uint32_t whole;
-	int32_t i, j;
-
-	for (i = 0; i < num_frames_out; ++i, fp_index += step) {
-		whole = INTPART_VALUE(fp_index);
-		for (j = 0; j < channels_num; j++) {
-			*output++ = input[whole * channels_num + j];
+	int32_t i;
+
+	if (src->new_channel_num == 2) {
+		for (i = 0; i < num_frames_out; ++i, input += 2 * quotient) {
+			*output++ = input[0];
+			*output++ = input[1];
+		}
+	} else {
+		for (i = 0; i < num_frames_out; ++i, input += quotient) {
+			*output++ = input[0];
 		}
 	}
 
@@ -246,26 +189,17 @@ static int32_t downresample_int(src_context_t *src, int32_t *num_frames_in)
 
 /**
  * @brief   Do filtering once new frames added to internal buffer.
+ * @remarks Frames are filtered up to the overlap frames at the tail, which are
+ *          filtered later when the frames following them are added.
  * @param   src: pointer to resampler object.
- * @param   num_frames_add: number of frames added
  */
-static void convolution_filtering(src_context_t *src, int32_t num_frames_add)
+static void convolution_filtering(src_context_t *src)
 {
-	if ((src->filter_coeff != NULL) && (src->left_frames > src->overlap_frames)) {
-		int16_t *input;
-		int32_t samples;
-		if (src->left_frames == num_frames_add) {
-			input = src->in_buffer;
-			samples = (num_frames_add - src->overlap_frames) * src->new_channel_num;
-		} else {
-			input = src->in_buffer + src->left_frames - num_frames_add - src->overlap_frames;
-			samples = num_frames_add * src->new_channel_num;
-		}
-
-		int32_t i;
-		for (i = 0; i < samples; ++i) {
-			input[i] = fir_convolve(input + i, src->filter_coeff, src->overlap_frames, src->new_channel_num);
-		}
+	int32_t frames = src->left_frames - src->overlap_frames - src->filtered_frames;
+	if ((src->filter_coeff != NULL) && (frames > 0)) {
+		int16_t *input = src->in_buffer + src->filtered_frames * src->new_channel_num;
+		pcm_fir_q14(input, frames * src->new_channel_num, src->filter_coeff, src->overlap_frames, src->new_channel_num);
+		src->filtered_frames += frames;
 	}
 }
 
@@ -325,14 +259,15 @@ static int init_src_context(src_context_t *src, src_data_t *src_data)
 	src->new_sample_width = src_data->desired_sample_width;
 	src->old_sample_rate = src_data->origin_sample_rate;
 	src->new_sample_rate = src_data->desired_sample_rate;
-	src->in_buffer_frames = src->in_buffer_bytes / OLD_FRAMES_TO_BYTES(src, 1);
+	src->in_buffer_frames = src->in_buffer_bytes / NEW_FRAMES_TO_BYTES(src, 1);
 	src->left_frames = 0;
 	src->used_frames = 0;
+	src->filtered_frames = 0;
 	src->fp_frac = 0;
 
-	// Calculate converting ratio for later use
-	src->ratio = (float)src->new_sample_rate / (float)src->old_sample_rate;
-	src->inverse_ratio = (float)src->old_sample_rate / (float)src->new_sample_rate;
+	// Calculate converting step for later use, rounded to nearest
+	src->step = (uint32_t)((((uint64_t)src->old_sample_rate << FRACBITS) + src->new_sample_rate / 2) / src->new_sample_rate);
+	src->decimation = src->old_sample_rate / src->new_sample_rate;
 
 	// Set overlap frame number and converting function as per converting ratio
 	if (src->old_sample_rate > src->new_sample_rate) {
@@ -341,22 +276,27 @@ static int init_src_context(src_context_t *src, src_data_t *src_data)
 			// inverse ratio 2.0/3.0 cases. e.g. 48K->16K, 48K->24K, 44.1K->22.05K, ...
 			src->filter_coeff = filter_22khz_coeff;
 			src->overlap_frames = OVERLAP_22KHZ;
+			src->reserved_frames = OVERLAP_22KHZ;
 			src->src_func = downresample_int;
-		} else if ((int)src->inverse_ratio >= 2) {
+		} else if (src->decimation >= 2) {
 			// inverse ratio 2.* cases. e.g. 48K->22.05K, 44.1K->16K, 24K->11.025K, ...
 			src->filter_coeff = filter_22khz_coeff;
 			src->overlap_frames = OVERLAP_22KHZ;
+			// resample_frac() reads the frame after the last one, which must be filtered
+			src->reserved_frames = OVERLAP_22KHZ + 1;
 			src->src_func = resample_frac;
 		} else {
 			// inverse ratio 1.* cases. e.g. 48K->44.1K, 44.1K->32K, 44.1K->24K, ...
 			src->filter_coeff = NULL;
 			src->overlap_frames = OVERLAP_DEFAULT;
+			src->reserved_frames = OVERLAP_DEFAULT;
 			src->src_func = resample_frac;
 		}
 	} else {
 		// up resampling
 		src->filter_coeff = NULL;
 		src->overlap_frames = OVERLAP_DEFAULT;
+		src->reserved_frames = OVERLAP_DEFAULT;
 		src->src_func = resample_frac;
 		// TODO: Noises appeared in ratio 2.* cases, consider fir-filtering after converting process
 	}
@@ -444,10 +384,12 @@ int src_simple(src_handle_t handle, src_data_t *src_data)
 	src->out_buffer = (int16_t *)src_data->data_out;
 
 	// Move remaining frames in internal buffer
-	if ((src->used_frames > 0) && (src->left_frames > 0)) {
-		memcpy((void *)src->in_buffer, \
-			(const void *)((int8_t *)src->in_buffer + NEW_FRAMES_TO_BYTES(src, src->used_frames)), \
-			NEW_FRAMES_TO_BYTES(src, src->left_frames));
+	if (src->used_frames > 0) {
+		if (src->left_frames > 0) {
+			memmove((void *)src->in_buffer, \
+				(const void *)((int8_t *)src->in_buffer + NEW_FRAMES_TO_BYTES(src, src->used_frames)), \
+				NEW_FRAMES_TO_BYTES(src, src->left_frames));
+		}
 		src->used_frames = 0;
 	}
 
@@ -460,22 +402,20 @@ int src_simple(src_handle_t handle, src_data_t *src_data)
 	src->left_frames += input_frames_used;
 
 	// Filtering on new appended frames
-	convolution_filtering(src, input_frames_used);
+	convolution_filtering(src);
 
 	// Calculate how many input frames needed if fill up out buffer
-	float input_frames_need = (float)out_buffer_frames / src->ratio;
-	if (input_frames_need - (int)input_frames_need > 0) {
-		input_frames_need = (int)input_frames_need + 1;
-	}
+	int input_frames_need = (int)(((uint64_t)out_buffer_frames * src->old_sample_rate + src->new_sample_rate - 1) / src->new_sample_rate);
 
 	int output_frames_gen = 0;
 	// Reserve overlap frames, then do converting process with available frames
-	frames = MINIMUM(src->left_frames - src->overlap_frames, (int)input_frames_need);
+	frames = MINIMUM(src->left_frames - src->reserved_frames, input_frames_need);
 	if (frames > 0) {
-		output_frames_gen = src->src_func(src, &frames);
+		output_frames_gen = src->src_func(src, &frames, out_buffer_frames);
 		if (output_frames_gen != 0) {
 			src->used_frames = frames;
 			src->left_frames -= frames;
+			src->filtered_frames = MAXIMUM(src->filtered_frames - frames, 0);
 		}
 	}
 
@@ -17,16 +17,19 @@
  ******************************************************************/
 
 #include <debug.h>
+#include <string.h>
 #include "PESPacket.h"
+#include "TSPacket.h"
 #include "Mpeg2TsTypes.h"
 
 #define PACKET_LENGTH(buffer)   ((buffer[4] << 8) | buffer[5])
 #define PES_PACKET_HEAD_BYTES   (6) // packet_start_code_prefix + stream_id + PES_packet_length
+#define CONTINUITY_COUNTER_MOD  (16) // Continuity counter's module value
 
-std::shared_ptr<PESPacket> PESPacket::create(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size)
+std::shared_ptr<PESPacket> PESPacket::create(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size, off_t position)
 {
 	auto instance = std::make_shared<PESPacket>();
-	if (instance && instance->initialize(pid, continuityCounter, pData, size)) {
+	if (instance && instance->initialize(pid, continuityCounter, pData, size, position)) {
 		return instance;
 	}
 
@@ -34,7 +37,140 @@ std::shared_ptr<PESPacket> PESPacket::create(ts_pid_t pid, uint8_t continuityCou
 	return nullptr;
 }
 
-uint16_t PESPacket::parseLengthField(uint8_t *pData, uint16_t size)
+PESPacket::PESPacket()
+	: mPid(INVALID_PID)
+	, mContinuityCounter(0)
+	, mData(nullptr)
+	, mPacketDataLen(0)
+	, mPresentDataLen(0)
+	, mPosition(0)
+	, mCursorIndex(0)
+	, mCursorOffset(0)
 {
-	return (PES_PACKET_HEAD_BYTES + PACKET_LENGTH(pData));
+}
+
+PESPacket::~PESPacket()
+{
+	if (mData) {
+		delete[] mData;
+		mData = nullptr;
+	}
+}
+
+bool PESPacket::initialize(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size, off_t position)
+{
+	if (size < PES_PACKET_HEAD_BYTES) {
+		meddbg("PES packet head is not in one ts packet, size %u\n", size);
+		return false;
+	}
+
+	mPacketDataLen = PES_PACKET_HEAD_BYTES + PACKET_LENGTH(pData);
+	if (mPacketDataLen < size) {
+		// abnormal case, anyway it would be abandoned if it's invalid packet.
+		size = mPacketDataLen;
+	}
+
+	// Each transport packet carries one fragment at most
+	mFragments.reserve(mPacketDataLen / (TSPacket::PACKET_SIZE - TSPacket::HEAD_BYTES) + 2);
+	mFragments.push_back({pData, size});
+	mPresentDataLen = size;
+
+	mPid = pid;
+	mContinuityCounter = continuityCounter;
+	mPosition = position;
+	medvdbg("initialize new PES packet, pid:0x%x, continuity:%u, data %u/%u\n", mPid, mContinuityCounter, mPresentDataLen, mPacketDataLen);
+	return true;
+}
+
+bool PESPacket::appendData(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size)
+{
+	if (mPid != pid) {
+		meddbg("pid(0x%x) do not match, current 0x%x\n", pid, mPid);
+		return false;
+	}
+
+	if (continuityCounter != ((mContinuityCounter + 1) % CONTINUITY_COUNTER_MOD)) {
+		meddbg("continuity counter(0x%x) do not match, current 0x%x\n", continuityCounter, mContinuityCounter);
+		return false;
+	}
+
+	mContinuityCounter = continuityCounter;
+
+	if (mPresentDataLen + size > mPacketDataLen) {
+		size = mPacketDataLen - mPresentDataLen;
+	}
+
+	if (mData) {
+		memcpy(mData + mPresentDataLen, pData, size);
+		mFragments[0].size += size;
+	} else if (size > 0) {
+		mFragments.push_back({pData, size});
+	}
+	mPresentDataLen += size;
+
+	medvdbg("append PES packet, pid:0x%x, continuity:%u, data %u(%u)/%u\n", mPid, mContinuityCounter, mPresentDataLen, size, mPacketDataLen);
+	return true;
+}
+
+bool PESPacket::detach(void)
+{
+	if (mData) {
+		return true;
+	}
+
+	mData = new uint8_t[mPacketDataLen];
+	if (!mData) {
+		meddbg("Run out of memory! Allocating %u bytes failed!\n", mPacketDataLen);
+		return false;
+	}
+
+	copyData(mData, mPresentDataLen, 0);
+	mFragments.clear();
+	mFragments.push_back({mData, mPresentDataLen});
+	mCursorIndex = 0;
+	mCursorOffset = 0;
+	medvdbg("PES packet detached, pid:0x%x, data %u/%u\n", mPid, mPresentDataLen, mPacketDataLen);
+	return true;
+}
+
+bool PESPacket::isCompleted(void)
+{
+	return ((mPacketDataLen != 0) && (mPacketDataLen == mPresentDataLen));
+}
+
+size_t PESPacket::copyData(uint8_t *buf, size_t size, size_t offset)
+{
+	if (offset >= mPresentDataLen) {
+		return 0;
+	}
+
+	if (size > mPresentDataLen - offset) {
+		size = mPresentDataLen - offset;
+	}
+
+	// Data is usually copied in order, so start from where last copy ended
+	if (offset < mCursorOffset) {
+		mCursorIndex = 0;
+		mCursorOffset = 0;
+	}
+
+	size_t copied = 0;
+	while (copied < size) {
+		const Fragment &fragment = mFragments[mCursorIndex];
+		size_t pos = offset + copied - mCursorOffset;
+		if (pos >= fragment.size) {
+			mCursorOffset += fragment.size;
+			mCursorIndex++;
+			continue;
+		}
+
+		size_t len = fragment.size - pos;
+		if (len > size - copied) {
+			len = size - copied;
+		}
+		memcpy(buf + copied, fragment.data + pos, len);
+		copied += len;
+	}
+
+	return copied;
 }
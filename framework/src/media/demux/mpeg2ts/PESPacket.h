@@ -19,23 +19,68 @@
 #ifndef __PES_PACKET_H
 #define __PES_PACKET_H
 
+#include <sys/types.h>
 #include <memory>
+#include <vector>
 #include "Mpeg2TsTypes.h"
-#include "Section.h"
 
-class PESPacket : public Section
+// PES packet is assembled as a list of fragments which point to the payloads
+// of transport packets in the demux buffer, payload data is not copied.
+// The referenced data must be kept until the packet is released or detached.
+class PESPacket
 {
 public:
+	struct Fragment {
+		const uint8_t *data;
+		uint32_t size;
+	};
+
 	// should always use this static method to create a new PESPacket instance
-	static std::shared_ptr<PESPacket> create(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size);
+	// position, stream position of the transport packet where the PES packet starts
+	static std::shared_ptr<PESPacket> create(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size, off_t position);
 	// constructor and destructor
-	PESPacket() {}
-	virtual ~PESPacket() {}
+	PESPacket();
+	virtual ~PESPacket();
+	// initialize packet with the first payload data
+	bool initialize(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size, off_t position);
+	// append payload data of the following transport packet
+	bool appendData(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size);
+	// copy the referenced data into a buffer of the packet, data appended later is copied too.
+	// after that, the packet doesn't reference the demux buffer any more.
+	bool detach(void);
+	// check if the packet has its own copy of data
+	bool isDetached(void) { return mData != nullptr; }
+	// check if PES packet is completed
+	bool isCompleted(void);
+	// copy packet data from the given offset, return number of bytes copied
+	size_t copyData(uint8_t *buf, size_t size, size_t offset);
+	// get total length in bytes of the PES packet
+	uint32_t getDataLen(void) { return mPacketDataLen; }
+	// get present length in bytes of the PES packet
+	uint32_t getPresentDataLen(void) { return mPresentDataLen; }
+	// get PID
+	ts_pid_t getPid(void) { return mPid; }
+	// get stream position of the transport packet where the PES packet starts
+	off_t getPosition(void) { return mPosition; }
 
-protected:
-	// parse length field from the given data
-	// return length value of the PES packet.
-	virtual uint16_t parseLengthField(uint8_t *pData, uint16_t size) override;
+private:
+	// PID of transport stream this packet from
+	ts_pid_t mPid;
+	// continuity counter of last ts packet accepted
+	uint8_t mContinuityCounter;
+	// data fragments in order
+	std::vector<Fragment> mFragments;
+	// packet data buffer allocated when detached
+	uint8_t *mData;
+	// total data length in bytes of a completed PES packet
+	uint32_t mPacketDataLen;
+	// present data length in fragments
+	uint32_t mPresentDataLen;
+	// stream position where the packet starts
+	off_t mPosition;
+	// fragment index and its offset in packet, where last copy ended
+	size_t mCursorIndex;
+	uint32_t mCursorOffset;
 };
 
 #endif /* __PES_PACKET_H */
@@ -17,6 +17,7 @@
  ******************************************************************/
 
 #include <debug.h>
+#include <string.h>
 #include "Mpeg2TsTypes.h"
 #include "PESParser.h"
 #include "PESPacket.h"
@@ -26,11 +27,17 @@
 #define PACKET_START_CODE_PREFIX(buffer)    ((buffer[0] << 16) | (buffer[1] << 8) | buffer[2])
 #define STREAM_ID(buffer)                   (buffer[3])
 #define PACKET_LENGTH(buffer)               ((buffer[4] << 8) | buffer[5])
+#define PES_PTS_BYTES                       (5) // 33 bits PTS with marker bits
+#define PTS_DTS_FLAG_PTS                    (0x2)
+#define PES_PARSE_HEAD_BYTES                (PES_PACKET_HEAD_BYTES + PES_STREAM_HEAD_BYTES + PES_PTS_BYTES)
 
 PESParser::PESParser()
 	: mPacketStartCodePrefix(0)
 	, mStreamId(0)
 	, mPacketLength(0)
+	, mPtsDtsFlags(0)
+	, mPESHeaderDataLength(0)
+	, mPTS(0)
 {
 }
 
@@ -48,7 +55,15 @@ bool PESParser::parse(std::shared_ptr<PESPacket> pPESPacket)
 
 	mPESPacket = pPESPacket;
 
-	uint8_t *pData = mPESPacket->getDataPtr();
+	// PES header may be split into fragments, copy the heading bytes we parse.
+	uint8_t pData[PES_PARSE_HEAD_BYTES];
+	size_t size = mPESPacket->copyData(pData, sizeof(pData), 0);
+	if (size < PES_PACKET_HEAD_BYTES + PES_STREAM_HEAD_BYTES) {
+		meddbg("PES packet is too short, size %u\n", size);
+		reset();
+		return false;
+	}
+
 	mPacketStartCodePrefix = PACKET_START_CODE_PREFIX(pData);
 	mStreamId = STREAM_ID(pData);
 	mPacketLength = PACKET_LENGTH(pData);
@@ -59,13 +74,24 @@ bool PESParser::parse(std::shared_ptr<PESPacket> pPESPacket)
 		return false;
 	}
 
-	if ((size_t)PES_PACKET_HEAD_BYTES + mPacketLength > mPESPacket->getDataLen()) {
+	if ((size_t)PES_PACKET_HEAD_BYTES + mPacketLength > mPESPacket->getPresentDataLen()) {
 		meddbg("Packet length overflow!\n");
 		reset();
 		return false;
 	}
 
-	return parseStream(&pData[PES_PACKET_HEAD_BYTES], mPacketLength);
+	if (!parseStream(&pData[PES_PACKET_HEAD_BYTES], mPacketLength)) {
+		return false;
+	}
+
+	if ((uint32_t)PES_STREAM_HEAD_BYTES + mPESHeaderDataLength > mPacketLength) {
+		meddbg("PES header length overflow!\n");
+		reset();
+		return false;
+	}
+
+	parseOptionalFields(&pData[PES_PACKET_HEAD_BYTES + PES_STREAM_HEAD_BYTES], size - PES_PACKET_HEAD_BYTES - PES_STREAM_HEAD_BYTES);
+	return true;
 }
 
 bool PESParser::parseStream(uint8_t *pData, uint32_t size)
@@ -94,14 +120,50 @@ bool PESParser::parseStream(uint8_t *pData, uint32_t size)
 	return false;
 }
 
-uint8_t *PESParser::getESData(void)
+/*
+PTS (presentation time stamp) is the first optional field if PTS_DTS_flags is '10' or '11'.
+    '001x'                                      | 4
+    PTS [32..30]                                | 3
+    marker_bit                                  | 1
+    PTS [29..15]                                | 15
+    marker_bit                                  | 1
+    PTS [14..0]                                 | 15
+    marker_bit                                  | 1
+*/
+void PESParser::parseOptionalFields(uint8_t *pData, uint32_t size)
+{
+	mPTS = 0;
+	if (!hasPTS() || size < PES_PTS_BYTES) {
+		return;
+	}
+
+	mPTS = ((uint64_t)((pData[0] >> 1) & 0x7) << 30) |
+		   ((uint32_t)pData[1] << 22) | ((uint32_t)(pData[2] >> 1) << 15) |
+		   ((uint32_t)pData[3] << 7) | (pData[4] >> 1);
+	medvdbg("PTS: %llu\n", mPTS);
+}
+
+bool PESParser::hasPTS(void)
+{
+	return (mPESPacket && (mPtsDtsFlags & PTS_DTS_FLAG_PTS) && (mPESHeaderDataLength >= PES_PTS_BYTES));
+}
+
+size_t PESParser::copyESData(uint8_t *buf, size_t size, size_t offset)
 {
 	if (!mPESPacket) {
 		// no PES packet, it's normal case.
-		return nullptr;
+		return 0;
+	}
+
+	if (offset >= getESDataLen()) {
+		return 0;
+	}
+
+	if (size > getESDataLen() - offset) {
+		size = getESDataLen() - offset;
 	}
 
-	return mPESPacket->getDataPtr() + PES_PACKET_HEAD_BYTES + PES_STREAM_HEAD_BYTES + mPESHeaderDataLength;
+	return mPESPacket->copyData(buf, size, PES_PACKET_HEAD_BYTES + PES_STREAM_HEAD_BYTES + mPESHeaderDataLength + offset);
 }
 
 uint16_t PESParser::getESDataLen(void)
@@ -121,4 +183,7 @@ void PESParser::reset(void)
 	mPacketStartCodePrefix = 0;
 	mStreamId = 0;
 	mPacketLength = 0;
+	mPtsDtsFlags = 0;
+	mPESHeaderDataLength = 0;
+	mPTS = 0;
 }
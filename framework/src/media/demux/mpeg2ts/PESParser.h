@@ -34,16 +34,24 @@ public:
 	virtual ~PESParser();
 	// parse PES packet, and the parser will add reference to the packet.
 	bool parse(std::shared_ptr<PESPacket> pPESPacket);
-	// get ES data in PES
-	uint8_t *getESData(void);
+	// get the PES packet parsed, nullptr if there's none.
+	std::shared_ptr<PESPacket> getPacket(void) { return mPESPacket; }
+	// copy ES data in PES from the given offset in ES data
+	size_t copyESData(uint8_t *buf, size_t size, size_t offset);
 	// get ES data length
 	uint16_t getESDataLen(void);
+	// check if PTS presents in PES header
+	bool hasPTS(void);
+	// get presentation time stamp in 90kHz units
+	uint64_t getPTS(void) { return mPTS; }
 	// reset PES parser, to remove reference of the PES packet
 	void reset(void);
 
 protected:
 	// parse stream data in PES
 	bool parseStream(uint8_t *pData, uint32_t size);
+	// parse optional fields in PES header
+	void parseOptionalFields(uint8_t *pData, uint32_t size);
 
 private:
 	// PES packet reference
@@ -72,6 +80,7 @@ private:
 	// following header length
 	uint8_t mPESHeaderDataLength;
 	//optional fields ...
+	uint64_t mPTS;
 	//} optional PES header
 };
 
@@ -28,7 +28,7 @@
 #define CONTINUITY_COUNTER_MOD  (16) // Continuity counter's module value
 
 
-std::shared_ptr<Section> Section::create(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size)
+std::shared_ptr<Section> Section::create(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size)
 {
 	auto instance = std::make_shared<Section>();
 	if (instance && instance->initialize(pid, continuityCounter, pData, size)) {
@@ -39,7 +39,7 @@ std::shared_ptr<Section> Section::create(ts_pid_t pid, uint8_t continuityCounter
 	return nullptr;
 }
 
-bool Section::initialize(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size)
+bool Section::initialize(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size)
 {
 	mSectionDataLen = parseLengthField(pData, size);
 	mSectionData = new uint8_t[mSectionDataLen];
@@ -79,7 +79,7 @@ Section::~Section()
 	}
 }
 
-bool Section::appendData(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size)
+bool Section::appendData(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size)
 {
 	if (mPid != pid) {
 		meddbg("pid(0x%x) do not match, current 0x%x\n", pid, mPid);
@@ -120,7 +120,7 @@ bool Section::isCompleted(void)
 	return ((mSectionDataLen != 0) && (mSectionDataLen == mPresentDataLen));
 }
 
-uint16_t Section::parseLengthField(uint8_t *pData, uint16_t size)
+uint16_t Section::parseLengthField(const uint8_t *pData, uint16_t size)
 {
 	return (SECTION_HEAD_BYTES + SECTION_LENGTH(pData));
 }
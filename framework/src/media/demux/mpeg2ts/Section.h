@@ -26,14 +26,14 @@ class Section
 {
 public:
 	// should always use this static method to create a new section instance
-	static std::shared_ptr<Section> create(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size);
+	static std::shared_ptr<Section> create(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size);
 	// constructor and destructor
 	Section();
 	virtual ~Section();
 	// initialize section member and allocate data buffer
-	bool initialize(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size);
+	bool initialize(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size);
 	// append new section data from ts packet payload
-	bool appendData(ts_pid_t pid, uint8_t continuityCounter, uint8_t *pData, uint16_t size);
+	bool appendData(ts_pid_t pid, uint8_t continuityCounter, const uint8_t *pData, uint16_t size);
 	// verify mpeg2 crc32
 	bool verifyCrc32(void);
 	// check if section is completed
@@ -49,7 +49,7 @@ protected:
 	// parse length field from the given data
 	// return length value of the object, in this class it's section_length
 	// derived class can override this method to get it's own length field.
-	virtual uint16_t parseLengthField(uint8_t *pData, uint16_t size);
+	virtual uint16_t parseLengthField(const uint8_t *pData, uint16_t size);
 	// calculates the MPEG2 32 bit CRC
 	uint32_t crc32(uint8_t *data, uint32_t length);
 
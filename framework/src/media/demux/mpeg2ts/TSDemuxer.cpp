@@ -29,6 +29,7 @@
 #include "PMTElementary.h"
 #include "PESPacket.h"
 #include "PESParser.h"
+#include "TSIndex.h"
 #include "TSDemuxer.h"
 
 #include "../../StreamBuffer.h"
@@ -40,12 +41,25 @@
 // threshold is not used, we don't have any buffer observer now.
 #define TS_DEMUX_BUFFER_THRESHOLD   (CONFIG_DEMUX_BUFFER_SIZE / 2)
 
+#ifndef CONFIG_CONTAINER_MPEG2TS_INDEX_ENTRIES
+#define CONFIG_CONTAINER_MPEG2TS_INDEX_ENTRIES 128
+#endif
+
+#ifndef CONFIG_CONTAINER_MPEG2TS_INDEX_INTERVAL
+#define CONFIG_CONTAINER_MPEG2TS_INDEX_INTERVAL 500
+#endif
+
 namespace media {
 
 TSDemuxer::TSDemuxer()
 	: Demuxer(AUDIO_TYPE_MP2T)
 	, mPESPid(INVALID_PID)
+	, mPCRPid(INVALID_PID)
 	, mPESDataUsed(0)
+	, mReadOffset(0)
+	, mStreamPosition(0)
+	, mPacketPosition(0)
+	, mResync(false)
 {
 }
 
@@ -102,6 +116,12 @@ bool TSDemuxer::initialize(void)
 		return false;
 	}
 
+	mIndex = std::make_shared<TSIndex>(CONFIG_CONTAINER_MPEG2TS_INDEX_ENTRIES, CONFIG_CONTAINER_MPEG2TS_INDEX_INTERVAL);
+	if (!mIndex) {
+		meddbg("mIndex is nullptr!\n");
+		return false;
+	}
+
 	return true;
 }
 
@@ -145,13 +165,14 @@ ssize_t TSDemuxer::pullData(uint8_t *buf, size_t size, void *param)
 	size_t need;
 	while (fill < size) {
 		need = size - fill;
-		if (mPESParser->getESData() != nullptr) {
+		if (mPESParser->getPacket() != nullptr) {
 			// get remaining payload in last PES packet
 			if (need > mPESParser->getESDataLen() - mPESDataUsed) {
 				need = mPESParser->getESDataLen() - mPESDataUsed;
 			}
 
-			memcpy(&buf[fill], mPESParser->getESData() + mPESDataUsed, need);
+			// copy from the fragments of PES packet, it's the only copy of ES data
+			mPESParser->copyESData(&buf[fill], need, mPESDataUsed);
 			mPESDataUsed += need;
 			fill += need;
 			medvdbg("Got ES data %u(%u)/%u\n", fill, need, size);
@@ -183,12 +204,18 @@ ssize_t TSDemuxer::pullData(uint8_t *buf, size_t size, void *param)
 		// parse PES packet
 		if (mPESParser->parse(pPESPacket)) {
 			mPESDataUsed = 0;
+			if (mPESParser->hasPTS()) {
+				mIndex->addPTS(mPESParser->getPTS(), pPESPacket->getPosition());
+			}
 		} else {
 			meddbg("PES parse failed!\n");
 			continue;
 		}
 	} // end while
 
+	// Let stream buffer get more data
+	releaseData();
+
 	if (fill == 0) {
 		medvdbg("Got nothing, please check error: %d\n", ret);
 		return (ssize_t)ret;
@@ -237,7 +264,7 @@ audio_type_t TSDemuxer::getAudioType(void *param)
 // return value
 // on success, [0, TSPacket::PACKET_SIZE)
 // on failure, demuxer_error_e
-int TSDemuxer::resync(uint8_t *pPacketData, size_t readOffset)
+int TSDemuxer::resync(const uint8_t *pPacketData, size_t readOffset)
 {
 	uint8_t buffer[TSPacket::PACKET_SIZE];
 	size_t szRead;
@@ -278,7 +305,7 @@ std::shared_ptr<Section> TSDemuxer::PSIUnpack(std::shared_ptr<TSPacket> pTSPacke
 {
 	std::shared_ptr<Section> pSection = nullptr;
 	uint8_t  lenPayload = 0;
-	uint8_t *ptrPayload = pTSPacket->getPayloadData(&lenPayload);
+	const uint8_t *ptrPayload = pTSPacket->getPayloadData(&lenPayload);
 
 	if (!ptrPayload) {
 		// no payload
@@ -337,7 +364,7 @@ std::shared_ptr<PESPacket> TSDemuxer::PESUnpack(std::shared_ptr<TSPacket> pTSPac
 {
 	std::shared_ptr<PESPacket> pPESPacket = nullptr;
 	uint8_t  lenPayload = 0;
-	uint8_t *ptrPayload = pTSPacket->getPayloadData(&lenPayload);
+	const uint8_t *ptrPayload = pTSPacket->getPayloadData(&lenPayload);
 
 	if (!ptrPayload) {
 		// no payload
@@ -347,16 +374,23 @@ std::shared_ptr<PESPacket> TSDemuxer::PESUnpack(std::shared_ptr<TSPacket> pTSPac
 	if (pTSPacket->payloadUnitStartIndicator()) {
 		// new PES packet start
 		medvdbg("new PES packet (PID:%u) start...\n", pTSPacket->getPid());
-		auto newPacket = PESPacket::create(pTSPacket->getPid(), pTSPacket->continuityCounter(), ptrPayload, lenPayload);
+		auto it = mPidPESPacketMap.find(pTSPacket->getPid());
+		if (it != mPidPESPacketMap.end()) {
+			// incomplete PES packet with same PID exist, remove it!
+			mPidPESPacketMap.erase(it);
+		}
+		auto newPacket = PESPacket::create(pTSPacket->getPid(), pTSPacket->continuityCounter(), ptrPayload, lenPayload, mPacketPosition);
+		if (!newPacket) {
+			return pPESPacket;
+		}
+		// payload in packet buffer would be overwritten by the next packet
+		if (pTSPacket->isBuffered() && !newPacket->detach()) {
+			return pPESPacket;
+		}
 		if (newPacket->isCompleted()) {
 			medvdbg("PES packet (PID:%u) complete\n", pTSPacket->getPid());
 			pPESPacket = newPacket;
 		} else {
-			auto it = mPidPESPacketMap.find(pTSPacket->getPid());
-			if (it != mPidPESPacketMap.end()) {
-				// incomplete PES packet with same PID exist, remove it!
-				mPidPESPacketMap.erase(it);
-			}
 			mPidPESPacketMap.insert(std::pair<uint16_t, std::shared_ptr<PESPacket>>(pTSPacket->getPid(), newPacket));
 		}
 	} else {
@@ -364,8 +398,11 @@ std::shared_ptr<PESPacket> TSDemuxer::PESUnpack(std::shared_ptr<TSPacket> pTSPac
 		auto it = mPidPESPacketMap.find(pTSPacket->getPid());
 		if (it != mPidPESPacketMap.end()) {
 			auto prePacket = it->second;
-			prePacket->appendData(pTSPacket->getPid(), pTSPacket->continuityCounter(), ptrPayload, lenPayload);
-			if (prePacket->isCompleted()) {
+			if ((pTSPacket->isBuffered() && !prePacket->detach()) ||
+				!prePacket->appendData(pTSPacket->getPid(), pTSPacket->continuityCounter(), ptrPayload, lenPayload)) {
+				meddbg("Drop incomplete PES packet (PID:%u)!\n", pTSPacket->getPid());
+				mPidPESPacketMap.erase(it);
+			} else if (prePacket->isCompleted()) {
 				medvdbg("PES packet (PID:%u) complete\n", pTSPacket->getPid());
 				pPESPacket = prePacket;
 				mPidPESPacketMap.erase(it);
@@ -391,52 +428,125 @@ bool TSDemuxer::isPESPid(uint16_t pid)
 	return (pid == mPESPid);
 }
 
-int TSDemuxer::loadTSPacket(std::shared_ptr<TSPacket> pTSPacket, bool sync, size_t *offset)
+const uint8_t *TSDemuxer::getPacketData(std::shared_ptr<TSPacket> pTSPacket, size_t offset)
 {
-	int syncOffset = 0;
+	// try to parse 188 bytes of packet data in stream buffer directly
+	size_t size = TSPacket::PACKET_SIZE;
+	const uint8_t *pData = mBufferReader->peekRead(size, false, offset);
+	if (pData && size == TSPacket::PACKET_SIZE) {
+		return pData;
+	}
+
+	// packet data wraps around the end of stream buffer, copy it to packet buffer
 	uint8_t buffLen; // TSPacket::PACKET_SIZE
 	uint8_t *pBuffer = pTSPacket->getPacketBuffer(&buffLen);
-	size_t readOffset = (offset == nullptr) ? 0 : *offset;
-
-	// try to copy 188 bytes of packet data from stream buffer
-	size_t size = mBufferReader->copy(pBuffer, buffLen, readOffset);
+	size = mBufferReader->copy(pBuffer, buffLen, offset);
 	if (size != buffLen) {
+		// data in buffer is not enough!
+		return nullptr;
+	}
+
+	return pBuffer;
+}
+
+int TSDemuxer::loadTSPacket(std::shared_ptr<TSPacket> pTSPacket, bool sync, size_t *offset)
+{
+	int syncOffset = 0;
+	size_t readOffset = (offset == nullptr) ? mReadOffset : *offset;
+
+	const uint8_t *pData = getPacketData(pTSPacket, readOffset);
+	if (!pData) {
 		// data in buffer is not enough!
 		return DEMUXER_ERROR_WANT_DATA;
 	}
 
 	// check if resync is required
-	if (sync || !pTSPacket->parse()) {
-		syncOffset = resync(pBuffer, readOffset);
+	if (sync || !pTSPacket->parse(pData)) {
+		syncOffset = resync(pData, readOffset);
 		if (syncOffset < 0) {
 			// sync failed, negative value means error code.
 			return syncOffset;
 		}
 		if (syncOffset != 0) {
-			mBufferReader->copy(pBuffer, buffLen, readOffset + (size_t)syncOffset);
+			// data is enough, resync has verified the following packets.
 			readOffset += syncOffset;
+			pData = getPacketData(pTSPacket, readOffset);
 		}
 		// parse packet again after resync
-		pTSPacket->parse();
+		pTSPacket->parse(pData);
 	}
 
-	// 188 bytes ts packet has been loaded to output buffer
-	readOffset += buffLen;
+	// 188 bytes ts packet has been loaded, it's consumed later in releaseData().
 	if (offset == nullptr) {
-		mBufferReader->read(NULL, readOffset, false);
+		mPacketPosition = mStreamPosition + (off_t)readOffset;
+		mReadOffset = readOffset + TSPacket::PACKET_SIZE;
 	} else {
-		*offset = readOffset;
+		*offset = readOffset + TSPacket::PACKET_SIZE;
 	}
 
 	return DEMUXER_ERROR_NONE;
 }
 
+void TSDemuxer::releaseData(void)
+{
+	// PES packets reference the data from where they start
+	std::shared_ptr<PESPacket> packets[] = { mPESParser->getPacket(), nullptr };
+	auto it = mPidPESPacketMap.find(mPESPid);
+	if (it != mPidPESPacketMap.end()) {
+		packets[1] = it->second;
+	}
+
+	off_t end = mStreamPosition + (off_t)mReadOffset;
+	for (auto &packet : packets) {
+		if (packet && !packet->isDetached() && packet->getPosition() < end) {
+			end = packet->getPosition();
+		}
+	}
+
+	size_t release = (size_t)(end - mStreamPosition);
+	if (release < mReadOffset && mBufferReader->sizeOfData() - mReadOffset < TSPacket::PACKET_SIZE &&
+		mBufferWriter->sizeOfSpace() + release < TSPacket::PACKET_SIZE) {
+		// Next TS packet can't be pushed, PES packet is too large for stream buffer.
+		// Copy it to free the buffer.
+		for (auto &packet : packets) {
+			if (packet && !packet->isDetached() && !packet->detach()) {
+				meddbg("Drop PES packet (PID:%u)!\n", packet->getPid());
+				if (packet == mPESParser->getPacket()) {
+					mPESParser->reset();
+					mPESDataUsed = 0;
+				} else {
+					mPidPESPacketMap.erase(packet->getPid());
+				}
+			}
+		}
+		release = mReadOffset;
+	}
+
+	if (release > 0) {
+		mBufferReader->consumeRead(release);
+		mReadOffset -= release;
+		mStreamPosition += (off_t)release;
+	}
+}
+
 // return demuxer_error_e
 int TSDemuxer::getPESPacket(std::shared_ptr<PESPacket> &pPESPacket)
 {
 	int ret;
 
-	while ((ret = loadTSPacket(mTSPacket)) == DEMUXER_ERROR_NONE) {
+	while ((ret = loadTSPacket(mTSPacket, mResync)) == DEMUXER_ERROR_NONE) {
+		mResync = false;
+
+		if (mTSPacket->hasAdaptationField() && mTSPacket->adaptationField().hasPCR()) {
+			// Take PCR of one PID only, as the program clock of the first program
+			if (mPCRPid == INVALID_PID) {
+				mPCRPid = mTSPacket->getPid();
+			}
+			if (mTSPacket->getPid() == mPCRPid) {
+				mIndex->addPCR(mTSPacket->adaptationField().getPCR(), mPacketPosition);
+			}
+		}
+
 		if (isPESPid(mTSPacket->getPid())) {
 			pPESPacket = PESUnpack(mTSPacket);
 			if (pPESPacket) {
@@ -493,4 +603,35 @@ int TSDemuxer::prepare(void)
 	return ret;
 }
 
+int TSDemuxer::getSeekOffset(unsigned int msec, off_t *offset)
+{
+	if (!isReady()) {
+		meddbg("TSDemuxer is not ready!\n");
+		return DEMUXER_ERROR_NOT_READY;
+	}
+
+	if (!mIndex->lookup(msec, offset)) {
+		return DEMUXER_ERROR_NOT_SUPPORTED;
+	}
+
+	medvdbg("seek to %u ms, offset %lld (indexed %u ms)\n", msec, (long long)*offset, mIndex->getIndexedTime());
+	return DEMUXER_ERROR_NONE;
+}
+
+void TSDemuxer::flush(off_t offset)
+{
+	// Release references to stream buffer before dropping the data
+	mPESParser->reset();
+	mPESDataUsed = 0;
+	mPidPESPacketMap.clear();
+	mPidSectionMap.clear();
+
+	mStreamBuffer->reset();
+	mReadOffset = 0;
+	mStreamPosition = offset;
+	mPacketPosition = offset;
+	// Stream may restart at any position
+	mResync = true;
+}
+
 } // namespace media
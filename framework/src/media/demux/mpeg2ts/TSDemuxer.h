@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <sys/types.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -34,6 +35,7 @@ class Section;
 class TSPacket;
 class PESParser;
 class PESPacket;
+class TSIndex;
 
 namespace media {
 namespace stream {
@@ -68,6 +70,10 @@ public:
 	// get audio type of elementary stream of the given program number
 	// param, pointer of program number of uint16, nullptr means first program as default
 	virtual audio_type_t getAudioType(void *param = nullptr) override;
+	// get stream position to restart demuxing from, to play from the given time
+	virtual int getSeekOffset(unsigned int msec, off_t *offset) override;
+	// drop stream data and PES packets, stream data from the given position is pushed next
+	virtual void flush(off_t offset) override;
 
 	// get programs list after pre parsing
 	bool getPrograms(std::vector<uint16_t> &progs);
@@ -88,12 +94,17 @@ private:
 	// on success, return 0
 	// on failure, return negative value (see demuxer_error_e)
 	int loadTSPacket(std::shared_ptr<TSPacket> pTSPacket, bool sync = false, size_t *offset = nullptr);
+	// get 188 bytes of packet data at the given offset in stream buffer
+	// data is copied to the packet buffer only if it wraps around the end of stream buffer
+	const uint8_t *getPacketData(std::shared_ptr<TSPacket> pTSPacket, size_t offset);
+	// consume stream data which is parsed and not referenced by PES packets
+	void releaseData(void);
 	// Unpack a TS packet and return a section if get a completed one
 	std::shared_ptr<Section> PSIUnpack(std::shared_ptr<TSPacket> pTSPacket);
 	// Unpack a TS packet and return a PES packet if get a completed one
 	std::shared_ptr<PESPacket> PESUnpack(std::shared_ptr<TSPacket> pTSPacket);
 	// resync TS packet by TSPacket::SYNC_BYTE
-	int resync(uint8_t *pPacketData, size_t offset);
+	int resync(const uint8_t *pPacketData, size_t offset);
 
 private:
 	// <pid, section_ptr> pairs in map to take incomplete sections
@@ -112,8 +123,20 @@ private:
 	std::shared_ptr<PESParser> mPESParser;
 	// TS packet
 	std::shared_ptr<TSPacket> mTSPacket;
+	// seek index
+	std::shared_ptr<TSIndex> mIndex;
 	uint16_t mPESPid;
+	// PID of packets carrying PCR
+	uint16_t mPCRPid;
 	size_t mPESDataUsed;
+	// bytes of data parsed from the read position of stream buffer
+	size_t mReadOffset;
+	// stream position of data at the read position of stream buffer
+	off_t mStreamPosition;
+	// stream position of the TS packet loaded last
+	off_t mPacketPosition;
+	// force resync with the next TS packet
+	bool mResync;
 };
 
 } // namespace media
@@ -0,0 +1,188 @@
+/******************************************************************
+ *
+ * Copyright 2019 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#include <debug.h>
+#include "TSPacket.h"
+#include "TSIndex.h"
+
+// PTS and PCR base take 33 bits, and wrap around about every 26.5 hours.
+#define CLOCK_BASE_MASK         ((1ULL << 33) - 1)
+// byte rate is not estimated from PCR until they are 100ms apart
+#define PCR_MIN_DURATION        (TSIndex::PCR_CLOCK_HZ / 10)
+#define MSEC_PER_SEC            (1000)
+
+TSIndex::TSIndex(size_t maxEntries, uint32_t interval)
+	: mMaxEntries(maxEntries < 2 ? 2 : maxEntries)
+	, mInterval(interval)
+{
+	mEntries.reserve(mMaxEntries);
+	reset();
+}
+
+TSIndex::~TSIndex()
+{
+}
+
+void TSIndex::reset(void)
+{
+	mEntries.clear();
+	mHasPTS = false;
+	mFirstPTS = 0;
+	mHasPCR = false;
+	mFirstPCR = 0;
+	mFirstPCRPosition = 0;
+	mLastPCR = 0;
+	mLastPCRPosition = 0;
+}
+
+void TSIndex::addPTS(uint64_t pts, off_t position)
+{
+	if (!mHasPTS) {
+		mHasPTS = true;
+		mFirstPTS = pts;
+	}
+
+	// PTS is taken relative to the first one, wrap around is handled by the mask.
+	uint64_t msec = ((pts - mFirstPTS) & CLOCK_BASE_MASK) * MSEC_PER_SEC / PTS_CLOCK_HZ;
+
+	if (!mEntries.empty()) {
+		const Entry &last = mEntries.back();
+		if (msec < (uint64_t)last.msec + mInterval || position <= last.position) {
+			// too close to the last entry, or demuxing again what was indexed
+			return;
+		}
+	}
+
+	if (mEntries.size() == mMaxEntries) {
+		thin();
+	}
+
+	mEntries.push_back({(uint32_t)msec, position});
+	medvdbg("index %u: %u ms at %lld\n", mEntries.size() - 1, (uint32_t)msec, (long long)position);
+}
+
+void TSIndex::addPCR(uint64_t pcr, off_t position)
+{
+	if (!mHasPCR || position <= mLastPCRPosition || pcr < mLastPCR) {
+		// first PCR, PCR after seeking back, or discontinuity: restart the estimation
+		mHasPCR = true;
+		mFirstPCR = pcr;
+		mFirstPCRPosition = position;
+	}
+
+	mLastPCR = pcr;
+	mLastPCRPosition = position;
+}
+
+uint32_t TSIndex::getByteRate(void)
+{
+	if (mHasPCR) {
+		// PCR never decreases between the first and the last one, see addPCR()
+		uint64_t duration = mLastPCR - mFirstPCR;
+		if (duration >= PCR_MIN_DURATION) {
+			return (uint32_t)((uint64_t)(mLastPCRPosition - mFirstPCRPosition) * PCR_CLOCK_HZ / duration);
+		}
+	}
+
+	// No PCR, estimate from the index
+	if (mEntries.size() >= 2 && mEntries.back().msec > mEntries.front().msec) {
+		const Entry &first = mEntries.front();
+		const Entry &last = mEntries.back();
+		return (uint32_t)((uint64_t)(last.position - first.position) * MSEC_PER_SEC / (last.msec - first.msec));
+	}
+
+	return 0;
+}
+
+off_t TSIndex::alignPosition(off_t position)
+{
+	// Stream may not start with a transport packet, align to the indexed ones.
+	off_t anchor = mEntries.empty() ? 0 : mEntries.front().position;
+	if (position < anchor) {
+		return anchor;
+	}
+
+	return position - (position - anchor) % TSPacket::PACKET_SIZE;
+}
+
+bool TSIndex::lookup(uint32_t msec, off_t *position)
+{
+	if (mEntries.empty() || msec < mEntries.front().msec) {
+		if (msec == 0) {
+			*position = 0;
+			return true;
+		}
+
+		uint32_t byteRate = getByteRate();
+		if (byteRate == 0) {
+			meddbg("no index and byte rate to seek to %u ms\n", msec);
+			return false;
+		}
+		*position = alignPosition((off_t)((uint64_t)msec * byteRate / MSEC_PER_SEC));
+		return true;
+	}
+
+	// Find the last entry at or before the given time
+	size_t low = 0;
+	size_t high = mEntries.size();
+	while (high - low > 1) {
+		size_t mid = (low + high) / 2;
+		if (mEntries[mid].msec <= msec) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	const Entry &entry = mEntries[low];
+	uint32_t delta = msec - entry.msec;
+	*position = entry.position;
+
+	if (low + 1 < mEntries.size()) {
+		const Entry &next = mEntries[low + 1];
+		if (next.msec - entry.msec > 2 * mInterval) {
+			// Gap left by seeking forward, interpolate between the entries
+			*position = alignPosition(entry.position + (off_t)((uint64_t)(next.position - entry.position) * delta / (next.msec - entry.msec)));
+		}
+	} else if (delta >= mInterval) {
+		// Beyond the index, estimate by byte rate
+		uint32_t byteRate = getByteRate();
+		if (byteRate > 0) {
+			*position = alignPosition(entry.position + (off_t)((uint64_t)delta * byteRate / MSEC_PER_SEC));
+		}
+	}
+
+	medvdbg("lookup %u ms: entry %u (%u ms), position %lld\n", msec, low, entry.msec, (long long)*position);
+	return true;
+}
+
+uint32_t TSIndex::getIndexedTime(void)
+{
+	return mEntries.empty() ? 0 : mEntries.back().msec;
+}
+
+void TSIndex::thin(void)
+{
+	size_t i;
+	for (i = 0; 2 * i < mEntries.size(); i++) {
+		mEntries[i] = mEntries[2 * i];
+	}
+	mEntries.resize(i);
+	mInterval *= 2;
+	medvdbg("index thinned to %u entries, interval %u ms\n", mEntries.size(), mInterval);
+}
@@ -0,0 +1,83 @@
+/******************************************************************
+ *
+ * Copyright 2019 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+#ifndef __TS_INDEX_H
+#define __TS_INDEX_H
+
+#include <sys/types.h>
+#include <vector>
+#include "Mpeg2TsTypes.h"
+
+// Seek index of a transport stream, built while demuxing.
+// Entries map play time to the stream position of an audio PES packet with PTS.
+// When the index is full, every other entry is dropped and the interval is doubled,
+// so the index always covers the whole stream demuxed so far with bounded memory.
+// Positions beyond the index are estimated from the byte rate given by PCR.
+class TSIndex
+{
+public:
+	enum {
+		PTS_CLOCK_HZ = 90000,       // PTS in 90kHz units
+		PCR_CLOCK_HZ = 27000000,    // PCR in 27MHz units
+	};
+
+	TSIndex(size_t maxEntries, uint32_t interval);
+	virtual ~TSIndex();
+	// forget all entries and clock references
+	void reset(void);
+	// add PTS of the audio PES packet which starts at the given stream position
+	void addPTS(uint64_t pts, off_t position);
+	// add PCR of the transport packet at the given stream position
+	void addPCR(uint64_t pcr, off_t position);
+	// get stream position where demuxing should restart to play from the given time
+	// return true on success, false if the position can't be known.
+	bool lookup(uint32_t msec, off_t *position);
+	// get play time in msec of the latest entry
+	uint32_t getIndexedTime(void);
+	// get number of entries
+	size_t getEntryCount(void) { return mEntries.size(); }
+
+private:
+	struct Entry {
+		uint32_t msec;
+		off_t position;
+	};
+
+	// get stream byte rate in bytes per second, 0 if unknown
+	uint32_t getByteRate(void);
+	// align position to the start of a transport packet
+	off_t alignPosition(off_t position);
+	// drop every other entry and double the interval
+	void thin(void);
+
+	std::vector<Entry> mEntries;
+	size_t mMaxEntries;
+	// minimum play time between entries
+	uint32_t mInterval;
+	// PTS at play time 0
+	bool mHasPTS;
+	uint64_t mFirstPTS;
+	// first and last PCR with their stream positions
+	bool mHasPCR;
+	uint64_t mFirstPCR;
+	off_t mFirstPCRPosition;
+	uint64_t mLastPCR;
+	off_t mLastPCRPosition;
+};
+
+#endif /* __TS_INDEX_H */
@@ -56,7 +56,9 @@ adaptation_field() {
         transport_private_data_flag             | 1
         adaptation_field_extension_flag         | 1
         if (PCR_flag) {
-            ...
+            program_clock_reference_base        | 33
+            reserved                            | 6
+            program_clock_reference_extension   | 9
         }
         if (OPCR_flag) {
             ...
@@ -73,9 +75,21 @@ adaptation_field() {
 #define BITS_MASK(bits)     ((1 << (bits)) - 1)
 #define PID_MASK            BITS_MASK(13)
 #define LENGTH_BYTES        (1) // adatation-field-length takes 1 byte
+#define FLAGS_BYTES         (1) // 8 flags take 1 byte
+#define PCR_BYTES           (6) // PCR base, reserved and extension fields
+#define PCR_EXT_MOD         (300)
 
 TSPacket::AdaptationField::AdaptationField()
-	: mAdaptationFieldLength(0)
+	: mPCR(0)
+	, mAdaptationFieldLength(0)
+	, mDiscontinuityIndicator(0)
+	, mRandomAccessIndicator(0)
+	, mElementaryStreamPriorityIndicator(0)
+	, mPCRFlag(0)
+	, mOPCRFlag(0)
+	, mSplicingPointFlag(0)
+	, mTransportPrivateDataFlag(0)
+	, mAdaptationFieldExtensionFlag(0)
 {
 }
 
@@ -95,14 +109,27 @@ bool TSPacket::AdaptationField::parse(const uint8_t *pData)
 		mSplicingPointFlag                 = (pData[1] >> 2) & BITS_MASK(1);
 		mTransportPrivateDataFlag          = (pData[1] >> 1) & BITS_MASK(1);
 		mAdaptationFieldExtensionFlag      = (pData[1]) & BITS_MASK(1);
+		if (mPCRFlag && mAdaptationFieldLength >= FLAGS_BYTES + PCR_BYTES) {
+			const uint8_t *pPCR = pData + LENGTH_BYTES + FLAGS_BYTES;
+			uint64_t base = ((uint64_t)pPCR[0] << 25) | ((uint32_t)pPCR[1] << 17) | ((uint32_t)pPCR[2] << 9) | ((uint32_t)pPCR[3] << 1) | (pPCR[4] >> 7);
+			uint16_t ext = ((pPCR[4] & BITS_MASK(1)) << 8) | pPCR[5];
+			mPCR = base * PCR_EXT_MOD + ext;
+		} else {
+			mPCRFlag = 0;
+		}
 		// parse more if necessary...
+	} else {
+		mDiscontinuityIndicator = 0;
+		mRandomAccessIndicator = 0;
+		mPCRFlag = 0;
 	}
 
 	return true;
 }
 
 TSPacket::TSPacket()
-	: mSyncByte(0)
+	: mPacket(mData)
+	, mSyncByte(0)
 	, mTransportErrorIndicator(0)
 	, mPayloadUnitStartIndicator(0)
 	, mTransportPriority(0)
@@ -119,8 +146,12 @@ TSPacket::~TSPacket()
 
 bool TSPacket::parse(void)
 {
-	const uint8_t *pData = mData;
+	return parse(mData);
+}
 
+bool TSPacket::parse(const uint8_t *pData)
+{
+	mPacket = pData;
 	mSyncByte = pData[0];
 	if (mSyncByte != SYNC_BYTE) {
 		return false;
@@ -150,10 +181,10 @@ uint8_t *TSPacket::getPacketBuffer(uint8_t *packetBuffLen)
 	return mData;
 }
 
-uint8_t *TSPacket::getPayloadData(uint8_t *payloadDataLen)
+const uint8_t *TSPacket::getPayloadData(uint8_t *payloadDataLen)
 {
 	uint8_t lenPayload = PACKET_SIZE - HEAD_BYTES;
-	uint8_t *ptrPayload = mData + HEAD_BYTES;
+	const uint8_t *ptrPayload = mPacket + HEAD_BYTES;
 
 	if (mSyncByte != SYNC_BYTE) {
 		meddbg("Invalid packet\n");
@@ -177,8 +208,12 @@ uint8_t *TSPacket::getPayloadData(uint8_t *payloadDataLen)
 
 	if (adaptationFieldControl() == CONTROL_ADAPTATION_PLAYLOAD) {
 		// 0~182 bytes adaption field + playload
+		if (adaptationField().adaptationFieldLength() >= PACKET_SIZE - HEAD_BYTES - LENGTH_BYTES) {
+			meddbg("Invalid adaptation field length %u\n", adaptationField().adaptationFieldLength());
+			return nullptr;
+		}
 		lenPayload = PACKET_SIZE - HEAD_BYTES - (LENGTH_BYTES + adaptationField().adaptationFieldLength());
-		ptrPayload = mData + (PACKET_SIZE - lenPayload);
+		ptrPayload = mPacket + (PACKET_SIZE - lenPayload);
 	}
 
 	if (payloadDataLen) {
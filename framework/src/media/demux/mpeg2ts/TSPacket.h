@@ -34,9 +34,15 @@ public:
 		bool parse(const uint8_t *data);
 		// getters
 		uint8_t adaptationFieldLength(void) { return mAdaptationFieldLength; }
+		bool discontinuityIndicator(void) { return static_cast<bool>(mDiscontinuityIndicator); }
+		bool hasPCR(void) { return static_cast<bool>(mPCRFlag); }
+		// program clock reference in 27MHz units, valid if hasPCR() is true
+		uint64_t getPCR(void) { return mPCR; }
 		// add more getters if necessary...
 
 	private:
+		// program clock reference (base * 300 + extension)
+		uint64_t mPCR;
 		// adaptation field length
 		uint8_t mAdaptationFieldLength;
 		uint8_t mDiscontinuityIndicator : 1;
@@ -69,24 +75,32 @@ public:
 	// parse transport packet stored in packet data buffer
 	// get packet buffer and put data in the buffer firstly
 	bool parse(void);
+	// parse transport packet in place, pData points to 188 bytes of packet data
+	// which must be kept unchanged while the packet is in use.
+	bool parse(const uint8_t *pData);
 
 	// getters
 	ts_pid_t getPid(void) { return mPid; }
 	bool transportErrorIndicator(void) { return static_cast<bool>(mTransportErrorIndicator); }
 	bool payloadUnitStartIndicator(void) { return static_cast<bool>(mPayloadUnitStartIndicator); }
 	uint8_t adaptationFieldControl(void) { return mAdaptationFieldControl; }
+	bool hasAdaptationField(void) { return (mAdaptationFieldControl == CONTROL_ADAPTATION_ONLY || mAdaptationFieldControl == CONTROL_ADAPTATION_PLAYLOAD); }
 	uint8_t continuityCounter(void) { return mContinuityCounter; }
 	AdaptationField &adaptationField(void) { return mAdaptationField; }
 	// get pointer to the packet data buffer (188 bytes)
 	uint8_t *getPacketBuffer(uint8_t *packetBuffLen);
+	// check if the packet was parsed from its own packet data buffer
+	bool isBuffered(void) { return mPacket == mData; }
 	// get pointer to the payload data start address
 	// return nullptr if there's no payload
-	uint8_t *getPayloadData(uint8_t *payloadDataLen);
+	const uint8_t *getPayloadData(uint8_t *payloadDataLen);
 	// add more getters if necessary...
 
 private:
 	// packet data array
 	uint8_t mData[PACKET_SIZE];
+	// packet data parsed, mData or data of the caller
+	const uint8_t *mPacket;
 	// sync byte
 	uint8_t mSyncByte;
 	// transport error indicator
@@ -0,0 +1,393 @@
+/******************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ******************************************************************/
+
+/*
+ * Integer kernels for 16-bit interleaved PCM, shared by the resampler and
+ * the channel remixer. Every kernel has a portable C version. With
+ * CONFIG_MEDIA_PCM_SIMD, a NEON (Cortex-A) or DSP extension (Cortex-M4/M7,
+ * ARMv7E-M) version is selected at build time from the compiler target.
+ * Except for pcm_fir_q14(), which saturates in all versions, the SIMD
+ * versions give bit-exact results of the C versions.
+ */
+
+#ifndef PCM_KERNELS_H
+#define PCM_KERNELS_H
+
+#include <tinyara/config.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(CONFIG_MEDIA_PCM_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define PCM_KERNEL_NEON
+#include <arm_neon.h>
+#elif defined(CONFIG_MEDIA_PCM_SIMD) && defined(__ARM_FEATURE_DSP)
+#define PCM_KERNEL_DSP
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+// Fraction bits of the fixed point frame index used by pcm_interp_q15()
+#define PCM_FRACBITS    (16)
+
+// 1.0 in Q15
+#define PCM_Q15_ONE     (1 << 15)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+static inline int16_t pcm_clip16(int32_t x)
+{
+	if (x < INT16_MIN) {
+		return INT16_MIN;
+	} else if (x > INT16_MAX) {
+		return INT16_MAX;
+	}
+
+	return (int16_t)x;
+}
+
+#ifdef PCM_KERNEL_DSP
+// Two samples at any 16-bit aligned address, unaligned word access is allowed on ARMv7E-M
+static inline uint32_t pcm_load_pair(const int16_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void pcm_store_pair(int16_t *p, uint32_t v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+// (hi[15:0] << 16) | lo[15:0]
+static inline uint32_t pcm_pkhbt(uint32_t lo, uint32_t hi)
+{
+	uint32_t r;
+	__asm__("pkhbt %0, %1, %2, lsl #16" : "=r"(r) : "r"(lo), "r"(hi));
+	return r;
+}
+
+// (hi[31:16] << 16) | lo[31:16]
+static inline uint32_t pcm_pkhtb(uint32_t hi, uint32_t lo)
+{
+	uint32_t r;
+	__asm__("pkhtb %0, %1, %2, asr #16" : "=r"(r) : "r"(hi), "r"(lo));
+	return r;
+}
+
+// a[15:0] * b[15:0] + a[31:16] * b[31:16]
+static inline int32_t pcm_smuad(uint32_t a, uint32_t b)
+{
+	int32_t r;
+	__asm__("smuad %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+}
+
+// acc + a[15:0] * b[15:0] + a[31:16] * b[31:16]
+static inline int32_t pcm_smlad(uint32_t a, uint32_t b, int32_t acc)
+{
+	int32_t r;
+	__asm__("smlad %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+	return r;
+}
+
+// Halving add of both halves, (a + b) >> 1
+static inline uint32_t pcm_shadd16(uint32_t a, uint32_t b)
+{
+	uint32_t r;
+	__asm__("shadd16 %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+/**
+ * @brief   Duplicate mono frames into stereo frames.
+ * @remarks output may be the same buffer as input, frames are processed backward.
+ * @param   input: mono frames
+ * @param   output: buffer for 2 * frames samples
+ * @param   frames: number of frames
+ */
+static inline void pcm_upmix_mono_stereo(const int16_t *input, int16_t *output, uint32_t frames)
+{
+	uint32_t n = frames;
+
+#if defined(PCM_KERNEL_NEON)
+	while (n >= 8) {
+		n -= 8;
+		int16x8x2_t v;
+		v.val[0] = vld1q_s16(input + n);
+		v.val[1] = v.val[0];
+		vst2q_s16(output + 2 * n, v);
+	}
+#elif defined(PCM_KERNEL_DSP)
+	if (n & 1) {
+		n--;
+		output[2 * n] = input[n];
+		output[2 * n + 1] = input[n];
+	}
+	while (n >= 2) {
+		n -= 2;
+		uint32_t v = pcm_load_pair(input + n);
+		pcm_store_pair(output + 2 * n, pcm_pkhbt(v, v));
+		pcm_store_pair(output + 2 * n + 2, pcm_pkhtb(v, v));
+	}
+#endif
+
+	while (n > 0) {
+		n--;
+		output[2 * n] = input[n];
+		output[2 * n + 1] = input[n];
+	}
+}
+
+/**
+ * @brief   Average stereo frames into mono frames, (L + R) >> 1.
+ * @remarks output may be the same buffer as input.
+ * @param   input: stereo frames
+ * @param   output: buffer for frames samples
+ * @param   frames: number of frames
+ */
+static inline void pcm_downmix_stereo_mono(const int16_t *input, int16_t *output, uint32_t frames)
+{
+	uint32_t i = 0;
+
+#if defined(PCM_KERNEL_NEON)
+	for (; i + 8 <= frames; i += 8) {
+		int16x8x2_t v = vld2q_s16(input + 2 * i);
+		vst1q_s16(output + i, vhaddq_s16(v.val[0], v.val[1]));
+	}
+#elif defined(PCM_KERNEL_DSP)
+	for (; i + 2 <= frames; i += 2) {
+		uint32_t f0 = pcm_load_pair(input + 2 * i);
+		uint32_t f1 = pcm_load_pair(input + 2 * i + 2);
+		pcm_store_pair(output + i, pcm_shadd16(pcm_pkhbt(f0, f1), pcm_pkhtb(f1, f0)));
+	}
+#endif
+
+	for (; i < frames; i++) {
+		output[i] = (int16_t)(((int32_t)input[2 * i] + input[2 * i + 1]) >> 1);
+	}
+}
+
+/**
+ * @brief   Linear interpolation with Q15 weights.
+ * @remarks Output frame i is interpolated between input frames whole and whole + 1,
+ *          where whole.frac is fp_index + i * step in 16.16 fixed point.
+ *          The input must hold the frame after the last whole index.
+ * @param   input: interleaved input frames
+ * @param   output: buffer for frames_out frames
+ * @param   frames_out: number of frames to generate
+ * @param   channels: number of channels, 1 or 2
+ * @param   fp_index: 16.16 index of the first output frame in input
+ * @param   step: 16.16 distance between output frames in input
+ * @return  16.16 index following the last output frame.
+ */
+static inline uint32_t pcm_interp_q15(const int16_t *input, int16_t *output, uint32_t frames_out, uint32_t channels, uint32_t fp_index, uint32_t step)
+{
+	uint32_t i = 0;
+	uint32_t whole;
+	int32_t w;
+	uint32_t c;
+
+#if defined(PCM_KERNEL_NEON)
+	if (channels == 1) {
+		for (; i + 4 <= frames_out; i += 4) {
+			uint32_t x0 = fp_index;
+			uint32_t x1 = x0 + step;
+			uint32_t x2 = x1 + step;
+			uint32_t x3 = x2 + step;
+			int16x4_t a = vdup_n_s16(0);
+			int16x4_t b = vdup_n_s16(0);
+			int32x4_t wv = { (int32_t)((x0 & 0xffff) >> 1), (int32_t)((x1 & 0xffff) >> 1),
+							 (int32_t)((x2 & 0xffff) >> 1), (int32_t)((x3 & 0xffff) >> 1) };
+			a = vld1_lane_s16(input + (x0 >> PCM_FRACBITS), a, 0);
+			b = vld1_lane_s16(input + (x0 >> PCM_FRACBITS) + 1, b, 0);
+			a = vld1_lane_s16(input + (x1 >> PCM_FRACBITS), a, 1);
+			b = vld1_lane_s16(input + (x1 >> PCM_FRACBITS) + 1, b, 1);
+			a = vld1_lane_s16(input + (x2 >> PCM_FRACBITS), a, 2);
+			b = vld1_lane_s16(input + (x2 >> PCM_FRACBITS) + 1, b, 2);
+			a = vld1_lane_s16(input + (x3 >> PCM_FRACBITS), a, 3);
+			b = vld1_lane_s16(input + (x3 >> PCM_FRACBITS) + 1, b, 3);
+			int32x4_t d = vmulq_s32(vsubl_s16(b, a), wv);
+			vst1_s16(output + i, vmovn_s32(vaddw_s16(vshrq_n_s32(d, 15), a)));
+			fp_index = x3 + step;
+		}
+	} else if (channels == 2) {
+		for (; i + 2 <= frames_out; i += 2) {
+			uint32_t x0 = fp_index;
+			uint32_t x1 = x0 + step;
+			int32_t w0 = (int32_t)((x0 & 0xffff) >> 1);
+			int32_t w1 = (int32_t)((x1 & 0xffff) >> 1);
+			int32x4_t wv = { w0, w0, w1, w1 };
+			// Stereo frames are 32-bit aligned in the resampler buffer
+			int32x2_t a = vdup_n_s32(0);
+			int32x2_t b = vdup_n_s32(0);
+			a = vld1_lane_s32((const int32_t *)(input + 2 * (x0 >> PCM_FRACBITS)), a, 0);
+			b = vld1_lane_s32((const int32_t *)(input + 2 * (x0 >> PCM_FRACBITS) + 2), b, 0);
+			a = vld1_lane_s32((const int32_t *)(input + 2 * (x1 >> PCM_FRACBITS)), a, 1);
+			b = vld1_lane_s32((const int32_t *)(input + 2 * (x1 >> PCM_FRACBITS) + 2), b, 1);
+			int16x4_t a16 = vreinterpret_s16_s32(a);
+			int16x4_t b16 = vreinterpret_s16_s32(b);
+			int32x4_t d = vmulq_s32(vsubl_s16(b16, a16), wv);
+			vst1_s16(output + 2 * i, vmovn_s32(vaddw_s16(vshrq_n_s32(d, 15), a16)));
+			fp_index = x1 + step;
+		}
+	}
+#elif defined(PCM_KERNEL_DSP)
+	// s1 + (((s2 - s1) * w) >> 15) == (s1 * (32768 - w) + s2 * w) >> 15, one SMUAD per sample.
+	// 32768 - w doesn't fit in a halfword when w is 0, the output is s1 then.
+	if (channels == 1) {
+		for (; i < frames_out; i++, fp_index += step) {
+			whole = fp_index >> PCM_FRACBITS;
+			w = (int32_t)((fp_index & 0xffff) >> 1);
+			if (w == 0) {
+				output[i] = input[whole];
+			} else {
+				uint32_t weights = pcm_pkhbt((uint32_t)(PCM_Q15_ONE - w), (uint32_t)w);
+				output[i] = (int16_t)(pcm_smuad(pcm_load_pair(input + whole), weights) >> 15);
+			}
+		}
+	} else if (channels == 2) {
+		for (; i < frames_out; i++, fp_index += step) {
+			whole = fp_index >> PCM_FRACBITS;
+			w = (int32_t)((fp_index & 0xffff) >> 1);
+			if (w == 0) {
+				pcm_store_pair(output + 2 * i, pcm_load_pair(input + 2 * whole));
+			} else {
+				uint32_t weights = pcm_pkhbt((uint32_t)(PCM_Q15_ONE - w), (uint32_t)w);
+				uint32_t f1 = pcm_load_pair(input + 2 * whole);
+				uint32_t f2 = pcm_load_pair(input + 2 * whole + 2);
+				output[2 * i] = (int16_t)(pcm_smuad(pcm_pkhbt(f1, f2), weights) >> 15);
+				output[2 * i + 1] = (int16_t)(pcm_smuad(pcm_pkhtb(f2, f1), weights) >> 15);
+			}
+		}
+	}
+#endif
+
+	// |s2 - s1| < 2^16 and w < 2^15, the products below fit in 32 bits
+	if (channels == 1) {
+		for (; i < frames_out; i++, fp_index += step) {
+			whole = fp_index >> PCM_FRACBITS;
+			w = (int32_t)((fp_index & 0xffff) >> 1);
+			output[i] = (int16_t)(input[whole] + (((input[whole + 1] - input[whole]) * w) >> 15));
+		}
+	} else if (channels == 2) {
+		for (; i < frames_out; i++, fp_index += step) {
+			const int16_t *s = input + 2 * (fp_index >> PCM_FRACBITS);
+			w = (int32_t)((fp_index & 0xffff) >> 1);
+			output[2 * i] = (int16_t)(s[0] + (((s[2] - s[0]) * w) >> 15));
+			output[2 * i + 1] = (int16_t)(s[1] + (((s[3] - s[1]) * w) >> 15));
+		}
+	}
+
+	for (; i < frames_out; i++, fp_index += step) {
+		whole = fp_index >> PCM_FRACBITS;
+		w = (int32_t)((fp_index & 0xffff) >> 1);
+		const int16_t *s1 = input + whole * channels;
+		const int16_t *s2 = s1 + channels;
+		for (c = 0; c < channels; c++) {
+			output[i * channels + c] = (int16_t)(s1[c] + (((s2[c] - s1[c]) * w) >> 15));
+		}
+	}
+
+	return fp_index;
+}
+
+/**
+ * @brief   FIR filter in place with Q14 coefficients, saturated to 16 bits.
+ * @remarks buf[i] = sum(buf[i + k * stride] * coeff[k]) >> 14, for k in [0, taps).
+ *          Each output only depends on samples at or after it, so the filter runs
+ *          forward in place. The buffer must hold (taps - 1) * stride samples
+ *          after the last output.
+ * @param   buf: interleaved samples
+ * @param   samples: number of samples to filter
+ * @param   coeff: Q14 coefficients
+ * @param   taps: number of coefficients
+ * @param   stride: distance between samples of a channel, i.e. the number of channels
+ */
+static inline void pcm_fir_q14(int16_t *buf, uint32_t samples, const int16_t *coeff, uint32_t taps, uint32_t stride)
+{
+	uint32_t i = 0;
+	uint32_t k;
+	int32_t sum;
+
+#if defined(PCM_KERNEL_NEON)
+	for (; i + 4 <= samples; i += 4) {
+		int32x4_t acc = vdupq_n_s32(1 << 13);
+		for (k = 0; k < taps; k++) {
+			acc = vmlal_n_s16(acc, vld1_s16(buf + i + k * stride), coeff[k]);
+		}
+		vst1_s16(buf + i, vqshrn_n_s32(acc, 14));
+	}
+#elif defined(PCM_KERNEL_DSP)
+	if (stride == 1) {
+		for (; i < samples; i++) {
+			sum = 1 << 13;
+			for (k = 0; k + 2 <= taps; k += 2) {
+				sum = pcm_smlad(pcm_load_pair(buf + i + k), pcm_pkhbt((uint16_t)coeff[k], (uint16_t)coeff[k + 1]), sum);
+			}
+			if (k < taps) {
+				sum += buf[i + k] * coeff[k];
+			}
+			buf[i] = pcm_clip16(sum >> 14);
+		}
+	} else if (stride == 2) {
+		// Left and right of a frame at once
+		for (; i + 2 <= samples; i += 2) {
+			int32_t sum_l = 1 << 13;
+			int32_t sum_r = 1 << 13;
+			for (k = 0; k + 2 <= taps; k += 2) {
+				uint32_t c = pcm_pkhbt((uint16_t)coeff[k], (uint16_t)coeff[k + 1]);
+				uint32_t f0 = pcm_load_pair(buf + i + 2 * k);
+				uint32_t f1 = pcm_load_pair(buf + i + 2 * k + 2);
+				sum_l = pcm_smlad(pcm_pkhbt(f0, f1), c, sum_l);
+				sum_r = pcm_smlad(pcm_pkhtb(f1, f0), c, sum_r);
+			}
+			if (k < taps) {
+				sum_l += buf[i + 2 * k] * coeff[k];
+				sum_r += buf[i + 2 * k + 1] * coeff[k];
+			}
+			buf[i] = pcm_clip16(sum_l >> 14);
+			buf[i + 1] = pcm_clip16(sum_r >> 14);
+		}
+	}
+#endif
+
+	for (; i < samples; i++) {
+		sum = 1 << 13;
+		for (k = 0; k < taps; k++) {
+			sum += buf[i + k * stride] * coeff[k];
+		}
+		buf[i] = pcm_clip16(sum >> 14);
+	}
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif /* __cplusplus */
+
+#endif /* PCM_KERNELS_H */
@@ -38,6 +38,15 @@
  */
 static void _incr(rb_p rbp, volatile size_t *p_idx, size_t len);
 
+/**
+ * @brief  Calculate data bytes between the given read and write index.
+ *
+ * @param  rbp: Pointer to the ring-buffer
+ * @param  rd_idx: snapshot of the read index
+ * @param  wr_idx: snapshot of the write index
+ */
+static size_t _used(rb_p rbp, size_t rd_idx, size_t wr_idx);
+
 bool rb_init(rb_p rbp, size_t size)
 {
 	RETURN_VAL_IF_FAIL(rbp != NULL, false);
@@ -64,18 +73,8 @@ size_t rb_used(rb_p rbp)
 {
 	RETURN_VAL_IF_FAIL(rbp != NULL, SIZE_ZERO);
 
-	if (IS_EMPTY(rbp)) {
-		return SIZE_ZERO;
-	}
-
-	size_t wr_idx = (rbp->wr_idx & IDX_MASK);
-	size_t rd_idx = (rbp->rd_idx & IDX_MASK);
-
-	if (wr_idx > rd_idx) {
-		return (wr_idx - rd_idx);
-	}
-
-	return (rbp->depth - (rd_idx - wr_idx));
+	// Take a snapshot of both indexes, the other side may update its own at any time.
+	return _used(rbp, rbp->rd_idx, rbp->wr_idx);
 }
 
 size_t rb_avail(rb_p rbp)
@@ -91,6 +90,8 @@ size_t rb_write(rb_p rbp, const void *ptr, size_t len)
 
 	size_t avail = rb_avail(rbp);
 	len = MINIMUM(len, avail);
+	// Space must be released by the reader before we overwrite it.
+	RB_MEMORY_BARRIER();
 
 	size_t wr_idx = (rbp->wr_idx & IDX_MASK);
 	size_t len_part = rbp->depth - wr_idx;
@@ -105,6 +106,8 @@ size_t rb_write(rb_p rbp, const void *ptr, size_t len)
 		memcpy((void *)((uint8_t *)rbp->buf + wr_idx), ptr, len);
 	}
 
+	// Data must be visible before the reader sees the new write index.
+	RB_MEMORY_BARRIER();
 	_incr(rbp, &rbp->wr_idx, len);
 	return len;
 }
@@ -115,6 +118,8 @@ size_t rb_read(rb_p rbp, void *ptr, size_t len)
 
 	// Reuse rb_read_ext() with offset: 0
 	len = rb_read_ext(rbp, ptr, len, 0);
+	// Data must be read out before the writer sees the new read index.
+	RB_MEMORY_BARRIER();
 	_incr(rbp, &rbp->rd_idx, len);
 	return len;
 }
@@ -128,6 +133,8 @@ size_t rb_read_ext(rb_p rbp, void *ptr, size_t len, size_t offset)
 
 	len = MINIMUM(len, (used - offset));
 	RETURN_VAL_IF_FAIL((len != SIZE_ZERO), SIZE_ZERO);
+	// Data written before the write index was updated must be visible from here.
+	RB_MEMORY_BARRIER();
 
 	if (ptr != NULL) {
 		// Increase temp rd_idx, to read data at the given offset.
@@ -165,6 +172,93 @@ bool rb_reset(rb_p rbp)
 	return true;
 }
 
+void *rb_acquire_write(rb_p rbp, size_t *len)
+{
+	RETURN_VAL_IF_FAIL(rbp != NULL, NULL);
+	RETURN_VAL_IF_FAIL(len != NULL, NULL);
+
+	size_t avail = rb_avail(rbp);
+	size_t wr_idx = (rbp->wr_idx & IDX_MASK);
+
+	// Only the part before the wrap-around point is contiguous.
+	*len = MINIMUM(*len, MINIMUM(avail, rbp->depth - wr_idx));
+	RETURN_VAL_IF_FAIL((*len != SIZE_ZERO), NULL);
+
+	// Space must be released by the reader before the caller overwrites it.
+	RB_MEMORY_BARRIER();
+	return (void *)((uint8_t *)rbp->buf + wr_idx);
+}
+
+size_t rb_commit_write(rb_p rbp, size_t len)
+{
+	RETURN_VAL_IF_FAIL(rbp != NULL, SIZE_ZERO);
+
+	len = MINIMUM(len, rb_avail(rbp));
+
+	// Data must be visible before the reader sees the new write index.
+	RB_MEMORY_BARRIER();
+	_incr(rbp, &rbp->wr_idx, len);
+	return len;
+}
+
+void *rb_peek_read(rb_p rbp, size_t *len)
+{
+	return rb_peek_read_ext(rbp, len, 0);
+}
+
+void *rb_peek_read_ext(rb_p rbp, size_t *len, size_t offset)
+{
+	RETURN_VAL_IF_FAIL(rbp != NULL, NULL);
+	RETURN_VAL_IF_FAIL(len != NULL, NULL);
+
+	size_t used = rb_used(rbp);
+	if (offset >= used) {
+		*len = SIZE_ZERO;
+		return NULL;
+	}
+
+	// Increase temp rd_idx, to peek data at the given offset.
+	size_t rd_idx = rbp->rd_idx;
+	_incr(rbp, &rd_idx, offset);
+	rd_idx = (rd_idx & IDX_MASK);
+
+	// Only the part before the wrap-around point is contiguous.
+	*len = MINIMUM(*len, MINIMUM(used - offset, rbp->depth - rd_idx));
+	RETURN_VAL_IF_FAIL((*len != SIZE_ZERO), NULL);
+
+	// Data written before the write index was updated must be visible from here.
+	RB_MEMORY_BARRIER();
+	return (void *)((uint8_t *)rbp->buf + rd_idx);
+}
+
+size_t rb_consume_read(rb_p rbp, size_t len)
+{
+	RETURN_VAL_IF_FAIL(rbp != NULL, SIZE_ZERO);
+
+	len = MINIMUM(len, rb_used(rbp));
+
+	// Data must be read out before the writer sees the new read index.
+	RB_MEMORY_BARRIER();
+	_incr(rbp, &rbp->rd_idx, len);
+	return len;
+}
+
+static size_t _used(rb_p rbp, size_t rd_idx, size_t wr_idx)
+{
+	if (rd_idx == wr_idx) {
+		return SIZE_ZERO;
+	}
+
+	size_t wr = (wr_idx & IDX_MASK);
+	size_t rd = (rd_idx & IDX_MASK);
+
+	if (wr > rd) {
+		return (wr - rd);
+	}
+
+	return (rbp->depth - (rd - wr));
+}
+
 static void _incr(rb_p rbp, volatile size_t *p_idx, size_t len)
 {
 	size_t idx = *p_idx & IDX_MASK;
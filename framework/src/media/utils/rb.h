@@ -30,6 +30,12 @@ extern "C" {
 #define IDX_MASK (SIZE_MAX>>1)
 #define MSB_MASK (~IDX_MASK)    /* also the maximum value of the buffer depth */
 
+/* Ordering of buffer data against the read/write index. Each index is owned by
+ * one side only, so a single producer and a single consumer can access the
+ * ring-buffer at the same time without any lock.
+ */
+#define RB_MEMORY_BARRIER() __sync_synchronize()
+
 /* ring buffer structure */
 struct rb_s {
 	void *buf;                  /* pointer to the buffer allocated   */
@@ -109,6 +115,55 @@ size_t rb_read_ext(rb_p rbp, void *ptr, size_t len, size_t offset);
  */
 bool rb_reset(rb_p rbp);
 
+/**
+ * @brief  Reserve contiguous free space at the write index for zero-copy writing.
+ *         Data is not visible to the reader until rb_commit_write() is called.
+ *         Only one producer may hold a reservation at a time.
+ * @param  rbp: Pointer to the ring-buffer object
+ * @param  len: [in] requested length, [out] length actually reserved, which may
+ *              be less than requested because of the wrap-around point.
+ * @return pointer to the reserved space, NULL if there is no space.
+ */
+void *rb_acquire_write(rb_p rbp, size_t *len);
+
+/**
+ * @brief  Publish data written into the space returned by rb_acquire_write().
+ * @param  rbp: Pointer to the ring-buffer object
+ * @param  len: length of the data to be published
+ * @return size of data published, range[0, len]
+ */
+size_t rb_commit_write(rb_p rbp, size_t len);
+
+/**
+ * @brief  Get contiguous data at the read index for zero-copy reading.
+ *         Data stays in the buffer until rb_consume_read() is called.
+ *         Only one consumer may hold a span at a time.
+ * @param  rbp: Pointer to the ring-buffer object
+ * @param  len: [in] requested length, [out] length actually available, which may
+ *              be less than requested because of the wrap-around point.
+ * @return pointer to the data, NULL if the buffer is empty.
+ */
+void *rb_peek_read(rb_p rbp, size_t *len);
+
+/**
+ * @brief  Get contiguous data at an offset from the read index for zero-copy reading,
+ *         rd_idx will not be increased.
+ * @param  rbp   : Pointer to the ring-buffer object
+ * @param  len   : [in] requested length, [out] length actually available, which may
+ *                 be less than requested because of the wrap-around point.
+ * @param  offset: offset from rd_idx started to peek.
+ * @return pointer to the data, NULL if there is no data at the offset.
+ */
+void *rb_peek_read_ext(rb_p rbp, size_t *len, size_t offset);
+
+/**
+ * @brief  Release data returned by rb_peek_read(), the space can be reused by writer.
+ * @param  rbp: Pointer to the ring-buffer object
+ * @param  len: length of the data to be released
+ * @return size of data released, range[0, len]
+ */
+size_t rb_consume_read(rb_p rbp, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
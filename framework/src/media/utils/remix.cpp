@@ -21,6 +21,7 @@
 #include <media/MediaTypes.h>
 #include "internal_defs.h"
 #include "remix.h"
+#include "pcm_kernels.h"
 
 using namespace media;
 
@@ -87,7 +88,7 @@ using namespace media;
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
-#define MIX_COEFF   7071 / 1000 // 0.7071, DONOT (7071 / 1000)
+#define MIX_COEFF_Q15   23170 // 0.7071 in Q15
 
 /****************************************************************************
  * Private Declarations
@@ -143,15 +144,9 @@ uint32_t ch2layout(uint32_t nb_chs)
 }
 
 // Clip an integer value (32 bits) to a signed short type value(16 bits)
-static int16_t clip(int32_t x)
+static inline int16_t clip(int32_t x)
 {
-	if (x < INT16_MIN) {
-		return INT16_MIN;
-	} else if (x > INT16_MAX) {
-		return INT16_MAX;
-	}
-
-	return x;
+	return pcm_clip16(x);
 }
 
 /****************************************************************************
@@ -194,37 +189,15 @@ int32_t rechannel(uint32_t in_layout, uint32_t out_layout, const int16_t *input,
 	int16_t *out_end = &output[out_samples];
 	int16_t *out_fl = &output[0];
 	int16_t *out_fr = &output[1];
-	int16_t *out_fc;
 
 	switch (in_layout) {
 	case CH_LAYOUT_MONO: { // out_layout: CH_LAYOUT_STEREO
-		// Maybe input == output, upmix backward.
-		in_fc = &input[out_frames * in_ch - 1];
-		out_fl = &output[out_samples - 2];
-		out_fr = &output[out_samples - 1];
-
-		while (output <= out_fl) {
-			*out_fr = *in_fc;
-			*out_fl = *in_fc;
-
-			out_fr -= out_ch;
-			out_fl -= out_ch;
-			in_fc -= in_ch;
-		}
+		// Maybe input == output, upmixed backward.
+		pcm_upmix_mono_stereo(input, output, out_frames);
 	} break;
 
 	case CH_LAYOUT_STEREO: { // out_layout: CH_LAYOUT_MONO
-		in_fl = &input[0];
-		in_fr = &input[1];
-		out_fc = &output[0];
-
-		while (out_fc < out_end) {
-			*out_fc = ((int32_t)*in_fl + *in_fr) / 2;
-
-			out_fc += out_ch;
-			in_fl += in_ch;
-			in_fr += in_ch;
-		}
+		pcm_downmix_stereo_mono(input, output, out_frames);
 	} break;
 
 	// Below cases process: multi -> stereo
@@ -298,8 +271,8 @@ int32_t rechannel(uint32_t in_layout, uint32_t out_layout, const int16_t *input,
 		}
 
 		while (out_fl < out_end) {
-			*out_fl = clip(*in_fl + ((int32_t)*in_fc + *in_bl) * MIX_COEFF);
-			*out_fr = clip(*in_fr + ((int32_t)*in_fc + *in_br) * MIX_COEFF);
+			*out_fl = clip(*in_fl + ((((int32_t)*in_fc + *in_bl) * MIX_COEFF_Q15) >> 15));
+			*out_fr = clip(*in_fr + ((((int32_t)*in_fc + *in_br) * MIX_COEFF_Q15) >> 15));
 
 			out_fl += out_ch;
 			out_fr += out_ch;
@@ -0,0 +1,110 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * lib/libc/symtab/symtab_findhashedbyname.c
+ *
+ * Lookup in the symbol tables generated by "mksymtab -p".
+ *
+ * The entries of such a table are placed at build time by a minimal perfect
+ * hash of their name.  Entry 0 has an empty name and its value points to the
+ * hash parameters: the number of buckets followed by the seed of each
+ * bucket.  The bucket of a name is given by its hash with seed 0, and the
+ * entry by its hash with the seed of the bucket.  Entries excluded by their
+ * build condition are left in place with an empty name.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <debug.h>
+#include <assert.h>
+
+#include <tinyara/symtab.h>
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: symtab_hashname
+ *
+ * Description:
+ *   FNV-1a hash of the name with a final mix.  This must be the same as the
+ *   hash of tools/mksymtab.c.
+ *
+ ****************************************************************************/
+
+static uint32_t symtab_hashname(FAR const char *name, uint32_t seed)
+{
+	uint32_t hash = 0x811c9dc5 ^ seed;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: symtab_findhashedbyname
+ *
+ * Description:
+ *   Find the symbol in the symbol table with the matching name.
+ *   This version assumes that the table was generated with a perfect hash
+ *   by "mksymtab -p" and, hence, a single name is compared.  Tables without
+ *   the hash parameters are searched linearly like symtab_findbyname().
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if an entry with the matching
+ *   name is found; NULL is returned if the entry is not found.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *symtab_findhashedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms)
+{
+	FAR const uint16_t *seeds;
+	FAR const struct symtab_s *symbol;
+	uint32_t bucket;
+
+	DEBUGASSERT(symtab != NULL && name != NULL);
+
+	if (nsyms < 2 || symtab[0].sym_name[0] != '\0') {
+		return symtab_findbyname(symtab, name, nsyms);
+	}
+
+	seeds = (FAR const uint16_t *)symtab[0].sym_value;
+	bucket = symtab_hashname(name, 0) % seeds[0];
+	symbol = &symtab[1 + symtab_hashname(name, seeds[1 + bucket]) % (nsyms - 1)];
+
+	return strcmp(name, symbol->sym_name) == 0 ? symbol : NULL;
+}
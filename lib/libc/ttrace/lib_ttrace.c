@@ -25,6 +25,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
+#include <sys/time.h>
 #include <tinyara/clock.h>
 #include <tinyara/ttrace.h>
 #include <tinyara/sched.h>
@@ -154,7 +155,7 @@ static int create_packet_sched(struct trace_packet *packet, struct tcb_s *prev,
 		packet->msg.sched_msg.prev_prio = prev->sched_priority;
 		packet->msg.sched_msg.prev_state = prev->task_state;
 	} else {
-		memcpy(packet->msg.sched_msg.prev_comm, "Idle Task", TTRACE_COMM_BYTES);
+		strncpy(packet->msg.sched_msg.prev_comm, "Idle Task", TTRACE_COMM_BYTES);
 		packet->msg.sched_msg.prev_pid = 0;
 		packet->msg.sched_msg.prev_prio = 0;
 		packet->msg.sched_msg.prev_state = 3;
@@ -165,7 +166,7 @@ static int create_packet_sched(struct trace_packet *packet, struct tcb_s *prev,
 		packet->msg.sched_msg.next_pid = next->pid;
 		packet->msg.sched_msg.next_prio = next->sched_priority;
 	} else {
-		memcpy(packet->msg.sched_msg.next_comm, "Idle Task", TTRACE_COMM_BYTES);
+		strncpy(packet->msg.sched_msg.next_comm, "Idle Task", TTRACE_COMM_BYTES);
 		packet->msg.sched_msg.next_pid = 0;
 		packet->msg.sched_msg.next_prio = 0;
 	}
@@ -0,0 +1,242 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <tinyara/ttrace.h>
+#include <tinyara/sched.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The kernel writes its records straight into the rings, applications of
+ * the protected build write them to the T-trace device.
+ */
+
+#if !defined(CONFIG_BUILD_PROTECTED) || defined(__KERNEL__)
+#define TTRACE_BIN_DIRECT
+#define TTRACE_BIN_TAGGED(tag)     (g_ttrace_binring[0].tags & (tag))
+#else
+#define TTRACE_BIN_TAGGED(tag)     (is_fd_available() >= 0 && is_tag_available(tag))
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifndef TTRACE_BIN_DIRECT
+static int g_ttrace_fd = -1;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifndef TTRACE_BIN_DIRECT
+static int is_fd_available(void)
+{
+	if (g_ttrace_fd < 0) {
+		g_ttrace_fd = open(CONFIG_TTRACE_DEVPATH, O_WRONLY);
+	}
+
+	return g_ttrace_fd;
+}
+
+static bool is_tag_available(int tag)
+{
+	return (ioctl(g_ttrace_fd, TTRACE_FUNC_TAG, tag) & tag) != 0;
+}
+#endif
+
+static int send_record(int tag, struct ttrace_binrec_s *rec)
+{
+#ifdef TTRACE_BIN_DIRECT
+	return ttrace_bin_write(tag, rec);
+#else
+	if (write(g_ttrace_fd, rec, rec->nslots * TTRACE_BIN_SLOT) < 0) {
+		return TTRACE_INVALID;
+	}
+
+	return TTRACE_VALID;
+#endif
+}
+
+static int send_record_arg(int tag, uint8_t type, uint32_t arg)
+{
+	struct ttrace_binrec_s rec;
+
+	if (!TTRACE_BIN_TAGGED(tag)) {
+		return TTRACE_INVALID;
+	}
+
+	rec.type = type;
+	rec.nslots = TTRACE_BIN_HDRSLOTS;
+	rec.pid = getpid();
+	rec.arg = arg;
+
+	return send_record(tag, &rec);
+}
+
+static int send_record_name(int tag, uint8_t type, uint32_t arg, const char *name)
+{
+	struct ttrace_binmsg_s msg;
+	size_t len = strnlen(name, TTRACE_MSG_BYTES - 1);
+
+	memset(msg.name, 0, TTRACE_MSG_BYTES);
+	memcpy(msg.name, name, len);
+	msg.rec.type = type;
+	msg.rec.nslots = TTRACE_BIN_HDRSLOTS + TTRACE_BIN_NAMESLOTS(len);
+	msg.rec.pid = getpid();
+	msg.rec.arg = arg;
+
+	return send_record(tag, &msg.rec);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int trace_sched(struct tcb_s *prev_tcb, struct tcb_s *next_tcb)
+{
+	struct {
+		struct ttrace_binrec_s rec;
+		struct ttrace_binsched_s sched;
+	} msg;
+	uint16_t prev_pid = 0;
+	uint16_t next_pid = 0;
+
+	if (!TTRACE_BIN_TAGGED(TTRACE_TAG_TASK)) {
+		return TTRACE_INVALID;
+	}
+
+	/* The idle task stands for a missing tcb, as in trace packets */
+
+	msg.sched.prev_prio = 0;
+	msg.sched.prev_state = 3;
+	msg.sched.next_prio = 0;
+	if (prev_tcb != NULL) {
+		prev_pid = prev_tcb->pid;
+		msg.sched.prev_prio = prev_tcb->sched_priority;
+		msg.sched.prev_state = prev_tcb->task_state;
+	}
+
+	if (next_tcb != NULL) {
+		next_pid = next_tcb->pid;
+		msg.sched.next_prio = next_tcb->sched_priority;
+	}
+
+	msg.rec.type = TTRACE_BIN_SCHED;
+	msg.rec.nslots = TTRACE_BIN_HDRSLOTS + 1;
+	msg.rec.pid = getpid();
+	msg.rec.arg = (uint32_t)prev_pid << 16 | next_pid;
+
+	return send_record(TTRACE_TAG_TASK, &msg.rec);
+}
+
+/****************************************************************************
+ * Name: trace_begin
+ *
+ * Description:
+ *   Writes a record with the name of the event, formatted only when it has
+ *   a conversion.
+ *
+ ****************************************************************************/
+
+int trace_begin(int tag, char *str, ...)
+{
+	char name[TTRACE_MSG_BYTES];
+	va_list ap;
+
+	if (!TTRACE_BIN_TAGGED(tag)) {
+		return TTRACE_INVALID;
+	}
+
+	if (strchr(str, '%') == NULL) {
+		return send_record_name(tag, TTRACE_BIN_BEGIN, tag, str);
+	}
+
+	va_start(ap, str);
+	vsnprintf(name, TTRACE_MSG_BYTES, str, ap);
+	va_end(ap);
+
+	return send_record_name(tag, TTRACE_BIN_BEGIN, tag, name);
+}
+
+int trace_begin_uid(int tag, int8_t uniqueid)
+{
+	return send_record_arg(tag, TTRACE_BIN_BEGIN_UID, (uint8_t)uniqueid);
+}
+
+int trace_end(int tag)
+{
+	return send_record_arg(tag, TTRACE_BIN_END, tag);
+}
+
+int trace_end_uid(int tag)
+{
+	return trace_end(tag);
+}
+
+int trace_counter(int tag, const char *name, int32_t value)
+{
+	if (!TTRACE_BIN_TAGGED(tag)) {
+		return TTRACE_INVALID;
+	}
+
+	return send_record_name(tag, TTRACE_BIN_COUNTER, (uint32_t)value, name);
+}
+
+int trace_async_begin(int tag, const char *name, uint32_t id)
+{
+	if (!TTRACE_BIN_TAGGED(tag)) {
+		return TTRACE_INVALID;
+	}
+
+	return send_record_name(tag, TTRACE_BIN_ASYNC_BEGIN, id, name);
+}
+
+int trace_async_end(int tag, const char *name, uint32_t id)
+{
+	if (!TTRACE_BIN_TAGGED(tag)) {
+		return TTRACE_INVALID;
+	}
+
+	return send_record_name(tag, TTRACE_BIN_ASYNC_END, id, name);
+}
+
+#if defined(CONFIG_TTRACE_BINARY_IRQ) && defined(TTRACE_BIN_DIRECT)
+int trace_irq_enter(int irq)
+{
+	return send_record_arg(TTRACE_TAG_IRQ, TTRACE_BIN_IRQ_ENTER, irq);
+}
+
+int trace_irq_exit(int irq)
+{
+	return send_record_arg(TTRACE_TAG_IRQ, TTRACE_BIN_IRQ_EXIT, irq);
+}
+#endif
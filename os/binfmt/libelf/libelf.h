@@ -64,6 +64,32 @@
 #include <tinyara/arch.h>
 #include <tinyara/binfmt/elf.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The statistics of the binding are kept for /proc/elf */
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_ELF)
+#define ELF_HAVE_STATS 1
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef ELF_HAVE_STATS
+/* Statistics of elf_bind() */
+
+struct elf_bind_stats_s {
+	unsigned int binds;                     /* Modules bound */
+	unsigned int relocs;                    /* Relocations applied */
+	unsigned int lookups;                   /* Symbols looked up in the export table */
+	unsigned int reads;                     /* Reads of relocation entries */
+	unsigned long usecs;                    /* Time spent binding, at the tick resolution */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -179,6 +205,22 @@ void elf_readsymtab(FAR struct elf_loadinfo_s *loadinfo);
 
 int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index, FAR Elf32_Sym *sym);
 
+/****************************************************************************
+ * Name: elf_savesym
+ *
+ * Description:
+ *   Save the value of the symbol at the specified index in the symbol table
+ *   read into memory, so that it is not resolved again by elf_symvalue().
+ *
+ * Input Parameters:
+ *   loadinfo - Load state information
+ *   index    - Symbol table index
+ *   sym      - The symbol table entry with its value
+ *
+ ****************************************************************************/
+
+void elf_savesym(FAR struct elf_loadinfo_s *loadinfo, int index, FAR const Elf32_Sym *sym);
+
 /****************************************************************************
  * Name: elf_symvalue
  *
@@ -287,6 +329,22 @@ int elf_loadctors(FAR struct elf_loadinfo_s *loadinfo);
 int elf_loaddtors(FAR struct elf_loadinfo_s *loadinfo);
 #endif
 
+#ifdef ELF_HAVE_STATS
+/****************************************************************************
+ * Name: elf_bind_getstats
+ *
+ * Description:
+ *   Get the statistics of elf_bind() since boot and for the module bound
+ *   last.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void elf_bind_getstats(FAR struct elf_bind_stats_s *total, FAR struct elf_bind_stats_s *last);
+#endif
+
 /****************************************************************************
  * Name: elf_addrenv_alloc
  *
@@ -375,17 +433,35 @@ void elf_addrenv_free(FAR struct elf_loadinfo_s *loadinfo);
 /* Cut-off ratio for number of blocks for caching */
 #define CUTOFF_RATIO_CACHE_BLOCKS 0.1f
 
+/* Lists of the segmented LRU of cached blocks.  A block is cached in the
+ * probation list and moves to the protected list when it is read again, so
+ * that blocks read once, like sections copied to RAM, don't evict the
+ * blocks read all along the load, like the symbol and string tables.
+ */
+#define ELF_CACHE_PROBATION 0
+#define ELF_CACHE_PROTECTED 1
+#define ELF_CACHE_NLISTS    2
+
 /* Struct for output buffers to cache uncompressed blocks */
 struct block_cache_s {
 	unsigned char *out_buffer;              /* Buffer that is going to hold uncompressed data */
 	int block_number;                       /* Block number in compressed file for the cached block */
-	unsigned int no_requests_for_block;     /* Number of requests for current block that is cached */
+	uint8_t list;                           /* List the block is cached in, ELF_CACHE_PROBATION or PROTECTED */
 	unsigned int index_block_cache;         /* Index of block cache in the array */
 	struct block_cache_s *next;             /* Pointer to next element in doubly linked list */
 	struct block_cache_s *prev;             /* Pointer to previous element in doubly linked list */
 };
 typedef struct block_cache_s block_cache_t;
 
+/* Statistics of the block cache, for the binary loaded last */
+struct elf_cache_stats_s {
+	unsigned int hits;                      /* Blocks found in the cache */
+	unsigned int misses;                    /* Blocks read on request */
+	unsigned int prefetches;                /* Blocks read ahead */
+	unsigned int prefetch_hits;             /* Blocks requested after being read ahead */
+	unsigned int prefetch_late;             /* Of these, blocks still being read ahead */
+};
+
 /****************************************************************************
  * Name: elf_cache_uninit
  *
@@ -422,6 +498,17 @@ int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compressio
  *   Negative value on failure
  ****************************************************************************/
 int elf_cache_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset);
+
+/****************************************************************************
+ * Name: elf_cache_getstats
+ *
+ * Description:
+ *   Get the statistics of the block cache since elf_cache_init
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+void elf_cache_getstats(FAR struct elf_cache_stats_s *stats);
 #endif
 
 #endif							/* __BINFMT_LIBELF_LIBELF_H */
@@ -189,6 +189,7 @@ int elf_addrenv_alloc(FAR struct elf_loadinfo_s *loadinfo, size_t textsize, size
 	loadinfo->binp->heapstart = loadinfo->dataalloc + loadinfo->datasize;
 #else
 	loadinfo->textalloc = (uintptr_t)kumm_malloc(textsize + datasize);
+	loadinfo->dataalloc = loadinfo->textalloc + textsize;
 #endif
 	if (!loadinfo->textalloc) {
 		berr("ERROR: Failed to allocate text section (size = %u)\n", textsize);
@@ -63,6 +63,7 @@
 #include <debug.h>
 
 #include <tinyara/elf.h>
+#include <tinyara/clock.h>
 #include <tinyara/binfmt/elf.h>
 #include <tinyara/binfmt/symtab.h>
 #include <tinyara/kmalloc.h>
@@ -87,6 +88,10 @@
 #define elf_dumpbuffer(m, b, n)
 #endif
 
+#ifndef MIN
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -95,69 +100,44 @@
  * Private Data
  ****************************************************************************/
 
-/****************************************************************************
- * Private Functions
- ****************************************************************************/
+#ifdef ELF_HAVE_STATS
+static struct elf_bind_stats_s g_bindstats;
+static struct elf_bind_stats_s g_lastbindstats;
+#endif
 
 /****************************************************************************
- * Name: elf_readreltab
- *
- * Description:
- *   Read the relocation table into memory.
- *
+ * Private Functions
  ****************************************************************************/
-static inline void elf_readreltab(FAR struct elf_loadinfo_s *loadinfo, FAR const Elf32_Shdr *relsec)
-{
-	loadinfo->reltab = (uintptr_t)kmm_malloc(relsec->sh_size);
-
-	if (!loadinfo->reltab) {
-		berr("ERROR: Failed to allocate space for relocation table. Size = %u\n", relsec->sh_size);
-		return;
-	}
-
-	if (elf_read(loadinfo, (FAR uint8_t *)loadinfo->reltab, relsec->sh_size, relsec->sh_offset) < 0) {
-		berr("ERROR: Failed to read relocation table into memory\n");
-	}
-}
-
 
 /****************************************************************************
- * Name: elf_readrel
+ * Name: elf_readrels
  *
  * Description:
- *   Read the ELF32_Rel structure into memory.
+ *   Read 'count' ELF32_Rel structures from the index 'index' into memory.
  *
  ****************************************************************************/
 
-static inline int elf_readrel(FAR struct elf_loadinfo_s *loadinfo, FAR const Elf32_Shdr *relsec, int index, FAR Elf32_Rel *rel)
+static inline int elf_readrels(FAR struct elf_loadinfo_s *loadinfo, FAR const Elf32_Shdr *relsec, int index, int count, FAR Elf32_Rel *rels)
 {
 	off_t offset;
 
-	/* Verify that the symbol table index lies within symbol table */
+	/* Verify that the entries lie within the relocation table */
 
-	if (index < 0 || index > (relsec->sh_size / sizeof(Elf32_Rel))) {
-		berr("Bad relocation symbol index: %d\n", index);
+	if (index < 0 || count < 1 || index + count > relsec->sh_size / sizeof(Elf32_Rel)) {
+		berr("Bad relocation index: %d count: %d\n", index, count);
 		return -EINVAL;
 	}
 
-	if (loadinfo->reltab) {
-		/* Get the file offset to the symbol table entry */
-
-		offset = sizeof(Elf32_Rel) * index;
+	/* Get the file offset to the first entry */
 
-		/* And, finally, read the symbol table entry into memory */
+	offset = relsec->sh_offset + sizeof(Elf32_Rel) * index;
 
-		memcpy(rel, loadinfo->reltab + offset, sizeof(Elf32_Rel));
-		return OK;
-	} else {
-		/* Get the file offset to the symbol table entry */
+	/* And, finally, read the entries into memory */
 
-		offset = relsec->sh_offset + sizeof(Elf32_Rel) * index;
-
-		/* And, finally, read the symbol table entry into memory */
-
-		return elf_read(loadinfo, (FAR uint8_t *)rel, sizeof(Elf32_Rel), offset);
-	}
+#ifdef ELF_HAVE_STATS
+	g_bindstats.reads++;
+#endif
+	return elf_read(loadinfo, (FAR uint8_t *)rels, sizeof(Elf32_Rel) * count, offset);
 }
 
 /****************************************************************************
@@ -176,33 +156,49 @@ static int elf_relocate(FAR struct elf_loadinfo_s *loadinfo, int relidx, FAR con
 {
 	FAR Elf32_Shdr *relsec = &loadinfo->shdr[relidx];
 	FAR Elf32_Shdr *dstsec = &loadinfo->shdr[relsec->sh_info];
+	FAR Elf32_Rel *rels;
+	Elf32_Rel onerel;
 	Elf32_Rel rel;
 	Elf32_Sym sym;
 	FAR Elf32_Sym *psym;
 	uintptr_t addr;
+	int nrels = relsec->sh_size / sizeof(Elf32_Rel);
+	int nbuffered;
 	int symidx;
 	int ret = OK;
 	int i;
 
-	/* Read the relocation table into memory */
-	elf_readreltab(loadinfo, relsec);
+	/* Allocate the buffer the relocation entries are read into, one at a
+	 * time if there is not enough memory.
+	 */
+
+	nbuffered = MIN(nrels, CONFIG_ELF_RELOCATION_BUFFERCOUNT);
+	rels = nbuffered > 1 ? (FAR Elf32_Rel *)kmm_malloc(sizeof(Elf32_Rel) * nbuffered) : NULL;
+	if (!rels) {
+		nbuffered = 1;
+		rels = &onerel;
+	}
 
 	/* Examine each relocation in the section.  'relsec' is the section
 	 * containing the relations.  'dstsec' is the section containing the data
 	 * to be relocated.
 	 */
 
-	for (i = 0; i < relsec->sh_size / sizeof(Elf32_Rel); i++) {
+	for (i = 0; i < nrels; i++) {
 		psym = &sym;
 
-		/* Read the relocation entry into memory */
+		/* Read the next relocation entries into memory */
 
-		ret = elf_readrel(loadinfo, relsec, i, &rel);
-		if (ret < 0) {
-			berr("Section %d reloc %d: Failed to read relocation entry: %d\n", relidx, i, ret);
-			goto ret_err;
+		if (i % nbuffered == 0) {
+			ret = elf_readrels(loadinfo, relsec, i, MIN(nrels - i, nbuffered), rels);
+			if (ret < 0) {
+				berr("Section %d reloc %d: Failed to read relocation entries: %d\n", relidx, i, ret);
+				goto ret_err;
+			}
 		}
 
+		rel = rels[i % nbuffered];
+
 		/* Get the symbol table index for the relocation.  This is contained
 		 * in a bit-field within the r_info element.
 		 */
@@ -219,6 +215,12 @@ static int elf_relocate(FAR struct elf_loadinfo_s *loadinfo, int relidx, FAR con
 
 		/* Get the value of the symbol (in sym.st_value) */
 
+#ifdef ELF_HAVE_STATS
+		if (sym.st_shndx == SHN_UNDEF) {
+			g_bindstats.lookups++;
+		}
+#endif
+
 		ret = elf_symvalue(loadinfo, &sym, exports, nexports);
 		if (ret < 0) {
 			/* The special error -ESRCH is returned only in one condition:  The
@@ -238,12 +240,17 @@ static int elf_relocate(FAR struct elf_loadinfo_s *loadinfo, int relidx, FAR con
 				berr("Section %d reloc %d: Failed to get value of symbol[%d]: %d\n", relidx, i, symidx, ret);
 				goto ret_err;
 			}
+		} else if (sym.st_shndx != SHN_ABS) {
+			/* Save the value, the next relocations against it use it as is */
+
+			elf_savesym(loadinfo, symidx, &sym);
 		}
 
 		/* Calculate the relocation address. */
 
 		if (rel.r_offset > dstsec->sh_size - sizeof(uint32_t)) {
 			berr("Section %d reloc %d: Relocation address out of range, offset %d size %d\n", relidx, i, rel.r_offset, dstsec->sh_size);
+			ret = -EINVAL;
 			goto ret_err;
 		}
 
@@ -256,10 +263,17 @@ static int elf_relocate(FAR struct elf_loadinfo_s *loadinfo, int relidx, FAR con
 			berr("ERROR: Section %d reloc %d: Relocation failed: %d\n", relidx, i, ret);
 			goto ret_err;
 		}
+
+#ifdef ELF_HAVE_STATS
+		g_bindstats.relocs++;
+#endif
 	}
 
 ret_err:
-	kmm_free(loadinfo->reltab);
+	if (rels != &onerel) {
+		kmm_free(rels);
+	}
+
 	return ret;
 }
 
@@ -290,6 +304,10 @@ int elf_bind(FAR struct elf_loadinfo_s *loadinfo, FAR const struct symtab_s *exp
 {
 #ifdef CONFIG_ARCH_ADDRENV
 	int status;
+#endif
+#ifdef ELF_HAVE_STATS
+	struct elf_bind_stats_s start = g_bindstats;
+	clock_t ticks = clock_systimer();
 #endif
 	int ret;
 	int i;
@@ -392,5 +410,37 @@ int elf_bind(FAR struct elf_loadinfo_s *loadinfo, FAR const struct symtab_s *exp
 
 ret_err:
 	kmm_free(loadinfo->symtab);
+
+#ifdef ELF_HAVE_STATS
+	g_bindstats.binds++;
+	g_bindstats.usecs += TICK2USEC(clock_systimer() - ticks);
+
+	g_lastbindstats.binds = 1;
+	g_lastbindstats.relocs = g_bindstats.relocs - start.relocs;
+	g_lastbindstats.lookups = g_bindstats.lookups - start.lookups;
+	g_lastbindstats.reads = g_bindstats.reads - start.reads;
+	g_lastbindstats.usecs = g_bindstats.usecs - start.usecs;
+#endif
+
 	return ret;
 }
+
+#ifdef ELF_HAVE_STATS
+/****************************************************************************
+ * Name: elf_bind_getstats
+ *
+ * Description:
+ *   Get the statistics of elf_bind() since boot and for the module bound
+ *   last.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void elf_bind_getstats(FAR struct elf_bind_stats_s *total, FAR struct elf_bind_stats_s *last)
+{
+	*total = g_bindstats;
+	*last = g_lastbindstats;
+}
+#endif
@@ -27,13 +27,66 @@
 #include <string.h>
 #include <debug.h>
 #include <errno.h>
+#include <assert.h>
 
 #include <tinyara/fs/fs.h>
+#include <tinyara/kmalloc.h>
 #include "libelf.h"
 
 #ifdef CONFIG_COMPRESSED_BINARY
 #include <tinyara/binfmt/compression/compress_read.h>
 #endif
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+#include <semaphore.h>
+#include <tinyara/wqueue.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Memory budget of the cached blocks, 0 to use the number of blocks */
+#ifndef CONFIG_ELF_CACHE_SIZE
+#define CONFIG_ELF_CACHE_SIZE 0
+#endif
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+/* States of the block read ahead */
+#define ELF_READAHEAD_IDLE   0		/* No block read ahead */
+#define ELF_READAHEAD_QUEUED 1		/* Block to read by the worker */
+#define ELF_READAHEAD_BUSY   2		/* Block being read by the worker */
+#define ELF_READAHEAD_DONE   3		/* Block read, result in 'result' */
+
+/* Number of sequential reads followed at the same time, like the reads of
+ * the relocations, interleaved with the reads of their symbols
+ */
+#define ELF_READAHEAD_NSTREAMS 4
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+/* The block following a block read on request is read ahead by the low
+ * priority work queue, into an entry which isn't in the lists and with
+ * buffers of its own, while the loader uses the block read on request.
+ * The worker holds 'sem' while it reads the block, a loader requesting the
+ * block waits for it on 'sem', and its priority is inherited by the worker.
+ */
+struct elf_readahead_s {
+	struct work_s work;
+	sem_t sem;						/* Held while the state or the block is updated */
+	volatile uint8_t state;			/* ELF_READAHEAD_* */
+	int block_number;				/* Block read ahead */
+	int result;						/* Bytes read or negated errno, when done */
+	int filfd;						/* File and header size of the binary */
+	uint16_t binary_header_size;
+	block_cache_t *entry;			/* Entry which the block is read into */
+	struct s_buffer bufs;			/* Read and decompression buffers of the worker */
+};
+#endif
+
 /****************************************************************************
  * Private Declarations
  ****************************************************************************/
@@ -53,16 +106,32 @@ static unsigned int number_of_blocks;
 /* Pointer to block_cache_t list to be used for holding ELF blocks */
 static block_cache_t *blockcache;
 
-/* Pointers for maintaining doubly linked list of blockcache */
-static block_cache_t *head;		/* Pointer to least priority block for caching */
-static block_cache_t *tail;		/* Pointer to highest priority block for caching */
-static block_cache_t *most_accessed;	/* Pointer to most accessed block for quick access */
+/* Index in blockcache of each block of the file, -1 if it isn't cached */
+static int16_t *block_map;
 
-/* Number of requests for the most accessed block in blockcache list */
-static unsigned int max_accessed_count;
+/* Lists of cached blocks, least recently used at head, most recently at tail */
+static block_cache_t *head[ELF_CACHE_NLISTS];
+static block_cache_t *tail[ELF_CACHE_NLISTS];
+static unsigned int list_count[ELF_CACHE_NLISTS];
+
+/* Maximum number of blocks in the protected list */
+static unsigned int max_protected;
 
 /* Compression Type of a file */
 static unsigned int elf_compress_type;
+
+/* Statistics of the cache */
+static struct elf_cache_stats_s cache_stats;
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+static struct elf_readahead_s readahead;
+static bool readahead_initialized;
+
+/* End offsets of the last sequential reads, and the next one to replace */
+static off_t stream_end[ELF_READAHEAD_NSTREAMS];
+static unsigned int stream_next;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -84,10 +153,29 @@ static void elf_cache_blocks_to_read(int *first_block, int *last_block, int *no_
 	blocksize = cache_blocks_size;
 
 	*first_block = offset / blocksize;
-	*last_block = (offset + readsize) / blocksize;
+	*last_block = (offset + readsize - 1) / blocksize;
 	*no_blocks = *last_block - *first_block + 1;
 }
 
+/****************************************************************************
+ * Name: elf_cache_block_size
+ *
+ * Description:
+ *   Size of 'block_number' block, the last block of the file being smaller
+ *   than the others if the file isn't aligned to the block size
+ *
+ * Returned Value:
+ *   Size of the block in bytes
+ ****************************************************************************/
+static size_t elf_cache_block_size(int block_number)
+{
+	if (block_number == number_of_blocks - 1) {
+		return file_len - block_number * cache_blocks_size;
+	}
+
+	return cache_blocks_size;
+}
+
 /****************************************************************************
  * Name: elf_cache_lseek_block
  *
@@ -160,11 +248,7 @@ static off_t elf_cache_read_block(int filfd, uint16_t binary_header_size, FAR ui
 	}
 
 	/* Last unaligned blocks to be read with its actual size and not with blocksize;*/
-	if (block_number == number_of_blocks - 1) {
-		readsize = file_len % cache_blocks_size;
-	} else {
-		readsize = cache_blocks_size;
-	}
+	readsize = elf_cache_block_size(block_number);
 
 	if (elf_compress_type == COMPRESS_TYPE_NONE) {
 		/* Read actual data to 'block_number's buf */
@@ -194,170 +278,371 @@ static off_t elf_cache_read_block(int filfd, uint16_t binary_header_size, FAR ui
 }
 
 /****************************************************************************
- * Name: elf_cache_update_blockcache_list
+ * Name: elf_cache_detach
  *
  * Description:
- *   Update blockcache list based on whether 'block_number' block in
- *   blockwise-elf binary is already cached or not. Also, maintain
- *   head, tail and most_accessed pointers.
- *   tail = most recently cached block (highest priority block for keeping
- *          cached)
- *   head = oldest cached block (lowest priority for keeping it cached).
- *          If a new block needs to be cached, cache to this blockcache element.
- *   most_accessed = pointer to most accessed block in blockcache list.
- *          Needed for easy access to most accessed block from comp. binary.
+ *   Remove 'ptr' from the list it is cached in
  *
  * Returned Value:
- *   Index in blockcache list where 'block_number' from elf
- *   binary is cached state. Return Negative value on failure.
+ *   None
  ****************************************************************************/
-static unsigned int elf_cache_update_blockcache_list(int block_number, int filfd, uint16_t binary_header_size)
+static void elf_cache_detach(block_cache_t *ptr)
 {
-	unsigned int blockcache_index;		/* Which blockcache element has needed ELF data for read */
-	block_cache_t *ptr;					/* Pointer to element in blockcache list which will be updated */
-	block_cache_t *temp;				/* Used when updating blockcache list */
-	bool flag_for_caching;				/* 1 = Block needs to be cached, 0 = Block already cached */
-	bool update_most_accessed;			/* 1 = Most accessed block is being removed from blockcache.
-										 *     Need to update most accessed pointer from scratch */
-	int size;
+	int list = ptr->list;
 
-	binfo("filfd: %d block_number: %d\n", filfd, block_number);
+	if (ptr->prev) {
+		ptr->prev->next = ptr->next;
+	} else {
+		head[list] = ptr->next;
+	}
 
-	/* Initialize flags */
-	flag_for_caching = true;
-	update_most_accessed = false;
-
-	/* First check is with block_number at most_accessed pointer */
-	if (most_accessed->block_number == block_number) {
-		flag_for_caching = false;
-		blockcache_index = most_accessed->index_block_cache;
-	}
-
-	/* Start checking for if block is cached from the tail */
-	if (flag_for_caching == true) {
-		ptr = tail;
-		while (ptr != NULL) {
-			if (ptr->block_number == block_number) {
-				flag_for_caching = false;
-				blockcache_index = ptr->index_block_cache;
-				break;
-			} else {
-				ptr = ptr->prev;
-			}
-		}
+	if (ptr->next) {
+		ptr->next->prev = ptr->prev;
+	} else {
+		tail[list] = ptr->prev;
 	}
 
-	/* If block_number block from elf binary needs to be cached */
-	if (flag_for_caching == true) {
+	ptr->next = NULL;
+	ptr->prev = NULL;
+	list_count[list]--;
+}
 
-		/* If most_accessed == head, need to update most_accessed */
-		if (head == most_accessed)
-			update_most_accessed = true;
+/****************************************************************************
+ * Name: elf_cache_attach
+ *
+ * Description:
+ *   Add 'ptr' at the tail, most recently used end, of 'list'
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_attach(block_cache_t *ptr, int list)
+{
+	ptr->list = list;
+	ptr->next = NULL;
+	ptr->prev = tail[list];
 
-		/* Detach head, Reassign head to head->next */
-		ptr = head;
-		head = ptr->next;
-		head->prev = ptr->prev;
+	if (tail[list]) {
+		tail[list]->next = ptr;
+	} else {
+		head[list] = ptr;
+	}
 
-		/* Read elf 'block_number' block into respective 'out_buffer' */
-		size = elf_cache_read_block(filfd, binary_header_size, ptr->out_buffer, block_number);
-		if (size < 0) {
-			berr("Read for block %d failed\n", block_number);
-			return ERROR;
-		}
+	tail[list] = ptr;
+	list_count[list]++;
+}
+
+/****************************************************************************
+ * Name: elf_cache_evict
+ *
+ * Description:
+ *   Detach the least recently used block of the probation list, or of the
+ *   protected list if the probation list is empty, to cache another block
+ *
+ * Returned Value:
+ *   The detached entry
+ ****************************************************************************/
+static block_cache_t *elf_cache_evict(void)
+{
+	block_cache_t *ptr;
+
+	ptr = head[ELF_CACHE_PROBATION];
+	if (!ptr) {
+		ptr = head[ELF_CACHE_PROTECTED];
+	}
+
+	DEBUGASSERT(ptr != NULL);
+	elf_cache_detach(ptr);
+
+	if (ptr->block_number >= 0) {
+		block_map[ptr->block_number] = -1;
+		ptr->block_number = -1;
+	}
+
+	return ptr;
+}
+
+/****************************************************************************
+ * Name: elf_cache_insert
+ *
+ * Description:
+ *   Cache 'block_number' block, read into 'ptr', in the probation list
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_insert(block_cache_t *ptr, int block_number)
+{
+	ptr->block_number = block_number;
+	block_map[block_number] = ptr->index_block_cache;
+	elf_cache_attach(ptr, ELF_CACHE_PROBATION);
+}
+
+/****************************************************************************
+ * Name: elf_cache_touch
+ *
+ * Description:
+ *   Update the lists for a cached block which is read again.  A block of the
+ *   probation list moves to the protected list, the least recently used
+ *   block of which moves back to the probation list if it is full.
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_touch(block_cache_t *ptr)
+{
+	block_cache_t *demoted;
+
+	if (ptr->list == ELF_CACHE_PROTECTED && ptr == tail[ELF_CACHE_PROTECTED]) {
+		return;
+	}
+
+	elf_cache_detach(ptr);
+	elf_cache_attach(ptr, ELF_CACHE_PROTECTED);
+
+	if (list_count[ELF_CACHE_PROTECTED] > max_protected) {
+		demoted = head[ELF_CACHE_PROTECTED];
+		elf_cache_detach(demoted);
+		elf_cache_attach(demoted, ELF_CACHE_PROBATION);
+	}
+}
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+/****************************************************************************
+ * Name: elf_cache_readahead_worker
+ *
+ * Description:
+ *   Read the block queued by elf_cache_readahead into the entry of the read
+ *   ahead, on the low priority work queue
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_readahead_worker(FAR void *arg)
+{
+	int block_number;
+
+	while (sem_wait(&readahead.sem) != 0) {
+		ASSERT(get_errno() == EINTR);
+	}
+
+	/* The block may have been read on request in the meantime */
+	if (readahead.state == ELF_READAHEAD_QUEUED) {
+		readahead.state = ELF_READAHEAD_BUSY;
+		block_number = readahead.block_number;
+
+		readahead.result = compress_read_buffers(readahead.filfd, readahead.binary_header_size, readahead.entry->out_buffer, elf_cache_block_size(block_number), block_number * cache_blocks_size, &readahead.bufs);
+		readahead.state = ELF_READAHEAD_DONE;
+	}
+
+	sem_post(&readahead.sem);
+}
+
+/****************************************************************************
+ * Name: elf_cache_readahead_take
+ *
+ * Description:
+ *   Take the block read ahead, if any, waiting for the worker to be done with
+ *   it.  A block which is queued but not being read yet is dropped, it is
+ *   faster to read it on request than to wait for the low priority worker.
+ *   'readahead.sem' is held on return.
+ *
+ * Returned Value:
+ *   The block number of the entry of the read ahead, -1 if it has no block
+ ****************************************************************************/
+static int elf_cache_readahead_take(void)
+{
+	while (sem_wait(&readahead.sem) != 0) {
+		ASSERT(get_errno() == EINTR);
+	}
 
-		/* Update block_number, Number of requests */
-		ptr->block_number = block_number;
-		ptr->no_requests_for_block = 1;
+	if (readahead.state == ELF_READAHEAD_QUEUED) {
+		work_cancel(LPWORK, &readahead.work);
+		readahead.state = ELF_READAHEAD_IDLE;
+	}
 
-		/* Updating most_accessed pointer */
-		if (ptr->no_requests_for_block >= max_accessed_count) {
-			max_accessed_count = ptr->no_requests_for_block;
-			most_accessed = ptr;
+	if (readahead.state == ELF_READAHEAD_DONE) {
+		readahead.state = ELF_READAHEAD_IDLE;
+		if (readahead.result == elf_cache_block_size(readahead.block_number)) {
+			return readahead.block_number;
 		}
 
-		/* Always attach ptr at tail */
-		temp = tail;
-		temp->next = ptr;
-		ptr->prev = temp;
-		ptr->next = NULL;
-		tail = ptr;
-
-		/* Update most_accessed from scratch, if needed */
-		if (update_most_accessed == true) {
-			max_accessed_count = 0;
-			temp = tail;
-			while (temp != NULL) {
-				if (temp->no_requests_for_block > max_accessed_count) {
-					max_accessed_count = temp->no_requests_for_block;
-					most_accessed = temp;
-				}
-				temp = temp->prev;
-			}
+		berr("Read ahead of block %d failed: %d\n", readahead.block_number, readahead.result);
+	}
+
+	return -1;
+}
+
+/****************************************************************************
+ * Name: elf_cache_readahead_reap
+ *
+ * Description:
+ *   Cache the block read ahead in the probation list, and take the entry of
+ *   an evicted block for the next read ahead
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_readahead_reap(int block_number)
+{
+	block_cache_t *ptr;
+
+	ptr = readahead.entry;
+	readahead.entry = elf_cache_evict();
+	elf_cache_insert(ptr, block_number);
+}
+
+/****************************************************************************
+ * Name: elf_cache_readahead
+ *
+ * Description:
+ *   Queue the read ahead of 'block_number' block, unless it is cached or
+ *   the worker is busy with another block
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+static void elf_cache_readahead(int filfd, uint16_t binary_header_size, int block_number)
+{
+	int done;
+
+	if (!readahead.entry || block_number >= number_of_blocks || block_map[block_number] >= 0) {
+		return;
+	}
+
+	if (readahead.state != ELF_READAHEAD_IDLE) {
+		if (readahead.block_number == block_number || readahead.state != ELF_READAHEAD_DONE) {
+			return;
 		}
+	}
 
-		/* Update blockcache_index into which block is cached */
-		blockcache_index = ptr->index_block_cache;
+	done = elf_cache_readahead_take();
+	if (done >= 0) {
+		elf_cache_readahead_reap(done);
+	}
 
-	} else { /* If block is already cached */
+	readahead.block_number = block_number;
+	readahead.filfd = filfd;
+	readahead.binary_header_size = binary_header_size;
+	readahead.state = ELF_READAHEAD_QUEUED;
+	sem_post(&readahead.sem);
 
-		/* If block is cached at head location */
-		if (head == &blockcache[blockcache_index]) {
-			/* Detach head, Reassign head to head->next */
-			ptr = head;
-			head = ptr->next;
-			head->prev = ptr->prev;
+	if (work_queue(LPWORK, &readahead.work, elf_cache_readahead_worker, NULL, 0) < 0) {
+		readahead.state = ELF_READAHEAD_IDLE;
+		return;
+	}
 
-			ptr->no_requests_for_block += 1;
+	cache_stats.prefetches++;
+}
 
-			/* Update most_accessed pointer */
-			if (ptr->no_requests_for_block >= max_accessed_count) {
-				max_accessed_count = ptr->no_requests_for_block;
-				most_accessed = ptr;
-			}
+/****************************************************************************
+ * Name: elf_cache_sequential
+ *
+ * Description:
+ *   Find whether the read at 'offset' continues one of the last reads, and
+ *   record its end
+ *
+ * Returned Value:
+ *   true if the read is sequential
+ ****************************************************************************/
+static bool elf_cache_sequential(off_t offset, size_t readsize)
+{
+	int i;
 
-			/* Always attach ptr at tail */
-			temp = tail;
-			temp->next = ptr;
-			ptr->prev = temp;
-			ptr->next = NULL;
-			tail = ptr;
-
-		} else if (tail == &blockcache[blockcache_index]) { /* Block is cached at tail location */
-			blockcache[blockcache_index].no_requests_for_block += 1;
-
-			/* Update most_accessed pointer */
-			ptr = tail;
-			if (ptr->no_requests_for_block >= max_accessed_count) {
-				max_accessed_count = ptr->no_requests_for_block;
-				most_accessed = ptr;
-			}
-		} else { /* Block is cached at some other index in blockcache list */
+	for (i = 0; i < ELF_READAHEAD_NSTREAMS; i++) {
+		if (stream_end[i] == offset) {
+			stream_end[i] = offset + readsize;
+			return true;
+		}
+	}
 
-			/* Detach blockcache element at blockcache_index */
-			ptr = &blockcache[blockcache_index];
-			ptr->prev->next = ptr->next;
-			ptr->next->prev = ptr->prev;
+	stream_end[stream_next] = offset + readsize;
+	stream_next = (stream_next + 1) % ELF_READAHEAD_NSTREAMS;
+	return false;
+}
+#endif
 
-			/* Update Number of requests for block */
-			ptr->no_requests_for_block += 1;
+/****************************************************************************
+ * Name: elf_cache_update_blockcache_list
+ *
+ * Description:
+ *   Update blockcache list based on whether 'block_number' block in
+ *   blockwise-elf binary is already cached or not.  A cached block is found
+ *   through block_map, a block which isn't cached is taken from the read
+ *   ahead if it has it, or read in place of the least recently used block
+ *   of the probation list.  The next block is read ahead if 'readahead' is
+ *   set, while this one is read and used.
+ *
+ * Returned Value:
+ *   Index in blockcache list where 'block_number' from elf
+ *   binary is cached state. Return Negative value on failure.
+ ****************************************************************************/
+static unsigned int elf_cache_update_blockcache_list(int block_number, int filfd, uint16_t binary_header_size, bool readahead_next)
+{
+	block_cache_t *ptr;					/* Pointer to element in blockcache list which will be updated */
+	int size;
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	int done;							/* Block taken from the read ahead */
+#endif
 
-			/* Update most accessed pointer */
-			if (ptr->no_requests_for_block >= max_accessed_count) {
-				max_accessed_count = ptr->no_requests_for_block;
-				most_accessed = ptr;
-			}
+	binfo("filfd: %d block_number: %d\n", filfd, block_number);
+
+	/* Block already cached */
+	if (block_map[block_number] >= 0) {
+		ptr = &blockcache[block_map[block_number]];
+		elf_cache_touch(ptr);
+		cache_stats.hits++;
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+		if (readahead_next) {
+			elf_cache_readahead(filfd, binary_header_size, block_number + 1);
+		}
+#endif
+		return ptr->index_block_cache;
+	}
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	/* Block read ahead, or being read ahead */
+	if (readahead.entry && readahead.state != ELF_READAHEAD_IDLE && readahead.block_number == block_number) {
+		if (readahead.state == ELF_READAHEAD_BUSY) {
+			cache_stats.prefetch_late++;
+		}
+
+		done = elf_cache_readahead_take();
+		sem_post(&readahead.sem);
 
-			/* Always attach ptr at tail */
-			temp = tail;
-			temp->next = ptr;
-			ptr->prev = temp;
-			ptr->next = NULL;
-			tail = ptr;
+		if (done == block_number) {
+			cache_stats.prefetch_hits++;
+			ptr = readahead.entry;
+			elf_cache_readahead_reap(block_number);
+			if (readahead_next) {
+				elf_cache_readahead(filfd, binary_header_size, block_number + 1);
+			}
+			return ptr->index_block_cache;
 		}
 	}
+#endif
+
+	cache_stats.misses++;
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	/* Read the next block while this one is read and used */
+	if (readahead_next) {
+		elf_cache_readahead(filfd, binary_header_size, block_number + 1);
+	}
+#endif
 
-	return blockcache_index;
+	/* Read elf 'block_number' block into the 'out_buffer' of the evicted block */
+	ptr = elf_cache_evict();
+	size = elf_cache_read_block(filfd, binary_header_size, ptr->out_buffer, block_number);
+	if (size < 0) {
+		berr("Read for block %d failed\n", block_number);
+		elf_cache_attach(ptr, ELF_CACHE_PROBATION);
+		return ERROR;
+	}
+
+	elf_cache_insert(ptr, block_number);
+
+	return ptr->index_block_cache;
 }
 
 /****************************************************************************
@@ -384,18 +669,23 @@ int elf_cache_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer,
 	int buffer_pos;			/* Position in buffer to start writing from */
 	int blocksize;			/* Blocksize used by the binary */
 	unsigned int blockcache_index;	/* Which blockcache element has needed ELF data for read */
+	bool sequential = false;	/* Read continuing a previous read */
 
 	binfo("filfd: %d readsize: %d offset: %d\n", filfd, readsize, offset);
 
 	/* Setting first block, end block and number of blocks to read */
 	blocksize = cache_blocks_size;
 	elf_cache_blocks_to_read(&first_block, &last_block, &no_blocks, offset, readsize);
-	if (first_block < 0 || no_blocks < 0) {
+	if (first_block < 0 || no_blocks < 0 || last_block >= number_of_blocks) {
 		berr("Incorrect first_block, no_blocks info\n");
 		buffer_pos = ERROR;
 		goto error_cache_read;
 	}
 
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	sequential = elf_cache_sequential(offset, readsize);
+#endif
+
 	block_number = first_block;
 	buffer_pos = 0;
 	/* Actual Offset in ELF file is same as Offset passed to this function */
@@ -404,9 +694,12 @@ int elf_cache_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer,
 	/* Reading from first_block to last_block. Then writing to buffer. */
 	for (; block_number < first_block + no_blocks; block_number++) {
 
-		/* Update blockcache list and get data into one of the blockcache elements */
-		blockcache_index = elf_cache_update_blockcache_list(block_number, filfd, binary_header_size);
-		if (blockcache_index >= number_blocks_caching) {
+		/*
+		 * Update blockcache list and get data into one of the blockcache elements, the last one
+		 * being the entry of the read ahead
+		 */
+		blockcache_index = elf_cache_update_blockcache_list(block_number, filfd, binary_header_size, sequential || block_number < last_block);
+		if (blockcache_index > number_blocks_caching) {
 			buffer_pos = ERROR;
 			goto error_cache_read;
 		}
@@ -444,6 +737,20 @@ error_cache_read:
 	return buffer_pos;
 }
 
+/****************************************************************************
+ * Name: elf_cache_getstats
+ *
+ * Description:
+ *   Get the statistics of the block cache since elf_cache_init
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+void elf_cache_getstats(FAR struct elf_cache_stats_s *stats)
+{
+	*stats = cache_stats;
+}
+
 /****************************************************************************
  * Name: elf_cache_init
  *
@@ -457,6 +764,7 @@ error_cache_read:
 int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compression_type)
 {
 	int ret = OK;
+	int i;
 
 	binfo("filfd: %d offset: %d filelen: %d compression_type: %d\n", filfd, offset, filelen, compression_type);
 
@@ -466,9 +774,17 @@ int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compressio
 	file_len = filelen;
 	number_of_blocks = file_len / cache_blocks_size;
 	elf_compress_type = compression_type;
-
-	/* Set number of blocks to use for caching */
-	if (CONFIG_ELF_CACHE_BLOCKS_COUNT > (CUTOFF_RATIO_CACHE_BLOCKS) * (number_of_blocks)) {
+	memset(&cache_stats, 0, sizeof(cache_stats));
+
+	/* Set number of blocks to use for caching, the blocks fitting in the
+	 * memory budget if one is set
+	 */
+	if (CONFIG_ELF_CACHE_SIZE > 0) {
+		number_blocks_caching = CONFIG_ELF_CACHE_SIZE / cache_blocks_size;
+		if (number_blocks_caching > number_of_blocks) {
+			number_blocks_caching = number_of_blocks;
+		}
+	} else if (CONFIG_ELF_CACHE_BLOCKS_COUNT > (CUTOFF_RATIO_CACHE_BLOCKS) * (number_of_blocks)) {
 		number_blocks_caching = (CUTOFF_RATIO_CACHE_BLOCKS) * (number_of_blocks);
 	}
 
@@ -483,18 +799,49 @@ int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compressio
 		number_blocks_caching = 2;
 	}
 
-	/* Initialize max_accesed_count to 0 */
-	max_accessed_count = 0;
+	/* Up to 2/3 of the blocks are protected from blocks read once */
+	max_protected = number_blocks_caching * 2 / 3;
+
+	for (i = 0; i < ELF_CACHE_NLISTS; i++) {
+		head[i] = NULL;
+		tail[i] = NULL;
+		list_count[i] = 0;
+	}
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	if (!readahead_initialized) {
+		sem_init(&readahead.sem, 0, 1);
+		readahead_initialized = true;
+	}
 
-	blockcache = (block_cache_t *)kmm_malloc(number_blocks_caching * sizeof(block_cache_t));
+	readahead.state = ELF_READAHEAD_IDLE;
+	readahead.entry = NULL;
+	for (i = 0; i < ELF_READAHEAD_NSTREAMS; i++) {
+		stream_end[i] = -1;
+	}
+#endif
+
+	/* One more entry is allocated for the block read ahead */
+	blockcache = (block_cache_t *)kmm_zalloc((number_blocks_caching + 1) * sizeof(block_cache_t));
 	if (!blockcache) {
 		berr("Failed kmm_malloc for blockcache\n");
 		elf_cache_uninit();
 		return -ENOMEM;
 	}
 
+	block_map = (int16_t *)kmm_malloc(number_of_blocks * sizeof(int16_t));
+	if (!block_map) {
+		berr("Failed kmm_malloc for block_map\n");
+		elf_cache_uninit();
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < number_of_blocks; i++) {
+		block_map[i] = -1;
+	}
+
 	/* Initialize blockcache list */
-	for (int i = 0; i < number_blocks_caching; i++) {
+	for (i = 0; i < number_blocks_caching; i++) {
 		blockcache[i].out_buffer = (unsigned char *)kmm_malloc(cache_blocks_size);
 
 		if (!blockcache[i].out_buffer) {
@@ -504,19 +851,27 @@ int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compressio
 		}
 
 		blockcache[i].block_number = -1;
-		blockcache[i].no_requests_for_block = 0;
 		blockcache[i].index_block_cache = i;
-		blockcache[i].next = &blockcache[(i + 1) % number_blocks_caching];
-		blockcache[i].prev = &blockcache[(i - 1) % number_blocks_caching];
+		elf_cache_attach(&blockcache[i], ELF_CACHE_PROBATION);
 	}
 
-	/* Assign head, tail and most_accessed pointers */
-	head = &blockcache[0];
-	tail = &blockcache[number_blocks_caching - 1];
-	most_accessed = tail;
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	/* Read ahead of the blocks of compressed binaries only, a read ahead of an
+	 * uncompressed binary would move the file position under the loader.  It
+	 * isn't set up if memory is short, the cache works without it.
+	 */
+	if (elf_compress_type == CONFIG_COMPRESSION_TYPE && number_of_blocks > number_blocks_caching) {
+		blockcache[i].out_buffer = (unsigned char *)kmm_malloc(cache_blocks_size);
+		blockcache[i].block_number = -1;
+		blockcache[i].index_block_cache = i;
 
-	head->prev = NULL;
-	tail->next = NULL;
+		if (blockcache[i].out_buffer && compress_init_buffers(&readahead.bufs) == OK) {
+			readahead.entry = &blockcache[i];
+		} else {
+			bwarn("No memory for read ahead of blocks\n");
+		}
+	}
+#endif
 
 	return ret;
 }
@@ -532,15 +887,32 @@ int elf_cache_init(int filfd, uint16_t offset, off_t filelen, uint8_t compressio
  ****************************************************************************/
 void elf_cache_uninit(void)
 {
-	for (int i = 0; i < number_blocks_caching; i++) {
-		if (blockcache[i].out_buffer) {
-			kmm_free(blockcache[i].out_buffer);
-			blockcache[i].out_buffer = NULL;
-		}
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	/* Wait for the worker to be done with the block it is reading */
+	if (readahead.entry) {
+		elf_cache_readahead_take();
+		readahead.entry = NULL;
+		sem_post(&readahead.sem);
+		compress_uninit_buffers(&readahead.bufs);
 	}
+#endif
+
+	binfo("blocks: %u hits: %u misses: %u prefetches: %u prefetch hits: %u (%u late)\n", number_of_blocks, cache_stats.hits, cache_stats.misses, cache_stats.prefetches, cache_stats.prefetch_hits, cache_stats.prefetch_late);
 
 	if (blockcache) {
+		for (int i = 0; i <= number_blocks_caching; i++) {
+			if (blockcache[i].out_buffer) {
+				kmm_free(blockcache[i].out_buffer);
+				blockcache[i].out_buffer = NULL;
+			}
+		}
+
 		kmm_free(blockcache);
 		blockcache = NULL;
 	}
+
+	if (block_map) {
+		kmm_free(block_map);
+		block_map = NULL;
+	}
 }
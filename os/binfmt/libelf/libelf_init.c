@@ -57,6 +57,7 @@
 #include <tinyara/config.h>
 
 #include <sys/stat.h>
+#include <sys/ioctl.h>
 
 #include <stdint.h>
 #include <string.h>
@@ -65,6 +66,7 @@
 #include <errno.h>
 
 #include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
 #include <tinyara/binfmt/elf.h>
 
 #ifdef CONFIG_COMPRESSED_BINARY
@@ -142,6 +144,43 @@ static inline int elf_filelen(FAR struct elf_loadinfo_s *loadinfo, FAR const cha
 	return OK;
 }
 
+#ifdef CONFIG_ELF_XIP
+/****************************************************************************
+ * Name: elf_xipbase
+ *
+ * Description:
+ *  Get the address the ELF file is mapped at, from the file system for a
+ *  file or from the MTD driver for a partition.  The ELF header is checked
+ *  at that address, the file is read instead if it doesn't match.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void elf_xipbase(FAR struct elf_loadinfo_s *loadinfo)
+{
+	FAR void *base = NULL;
+
+	loadinfo->xipbase = 0;
+
+	if (ioctl(loadinfo->filfd, FIOC_MMAP, (unsigned long)((uintptr_t)&base)) < 0 || base == NULL) {
+		if (ioctl(loadinfo->filfd, BIOC_XIPBASE, (unsigned long)((uintptr_t)&base)) < 0 || base == NULL) {
+			return;
+		}
+	}
+
+	base = (FAR uint8_t *)base + loadinfo->offset;
+	if (memcmp(base, &loadinfo->ehdr, sizeof(Elf32_Ehdr)) != 0) {
+		bwarn("ELF header not found at XIP base %p\n", base);
+		return;
+	}
+
+	binfo("ELF file mapped at %p\n", base);
+	loadinfo->xipbase = (uintptr_t)base;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -230,5 +269,13 @@ int elf_init(FAR const char *filename, FAR struct elf_loadinfo_s *loadinfo)
 		return ret;
 	}
 
+#ifdef CONFIG_ELF_XIP
+	/* Only uncompressed files can be used in place */
+
+	if (loadinfo->compression_type == COMPRESS_TYPE_NONE) {
+		elf_xipbase(loadinfo);
+	}
+#endif
+
 	return OK;
 }
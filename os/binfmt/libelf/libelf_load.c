@@ -96,6 +96,66 @@
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
+#ifdef CONFIG_ELF_XIP
+/****************************************************************************
+ * Name: elf_xipsection
+ *
+ * Description:
+ *   Check whether the section can be used in place in the mapped file: it
+ *   is allocated, read-only and has data in the file, no relocation applies
+ *   to it, its address in the file is aligned, and it isn't the first
+ *   section of the text, which holds the entry point.
+ *
+ * Returned Value:
+ *   true if the section is used in place
+ *
+ ****************************************************************************/
+
+static bool elf_xipsection(FAR struct elf_loadinfo_s *loadinfo, int index)
+{
+	FAR Elf32_Shdr *shdr = &loadinfo->shdr[index];
+	uintptr_t addr = loadinfo->xipbase + shdr->sh_offset;
+	bool first = true;
+	int i;
+
+	if (loadinfo->xipbase == 0 || (shdr->sh_flags & (SHF_ALLOC | SHF_WRITE)) != SHF_ALLOC || shdr->sh_type == SHT_NOBITS) {
+		return false;
+	}
+
+	if (shdr->sh_addralign > 1 && (addr & (shdr->sh_addralign - 1)) != 0) {
+		return false;
+	}
+
+	for (i = 0; i < loadinfo->ehdr.e_shnum; i++) {
+		FAR Elf32_Shdr *other = &loadinfo->shdr[i];
+
+		/* Relocation sections apply to the section sh_info */
+
+		if ((other->sh_type == SHT_REL || other->sh_type == SHT_RELA) && other->sh_info == index && other->sh_size > 0) {
+			return false;
+		}
+
+		/* The first section of the text is at textalloc */
+
+#ifdef CONFIG_OPTIMIZE_APP_RELOAD_TIME
+		if (i < index && (other->sh_flags & (SHF_ALLOC | SHF_WRITE | SHF_EXECINSTR)) == (SHF_ALLOC | SHF_EXECINSTR)) {
+#else
+		if (i < index && (other->sh_flags & (SHF_ALLOC | SHF_WRITE)) == SHF_ALLOC) {
+#endif
+			first = false;
+		}
+	}
+
+#ifdef CONFIG_OPTIMIZE_APP_RELOAD_TIME
+	if ((shdr->sh_flags & SHF_EXECINSTR) == 0) {
+		first = false;
+	}
+#endif
+
+	return !first;
+}
+#endif
+
 /****************************************************************************
  * Name: elf_elfsize
  *
@@ -130,6 +190,14 @@ static void elf_elfsize(struct elf_loadinfo_s *loadinfo)
 		 */
 
 		if ((shdr->sh_flags & SHF_ALLOC) != 0) {
+#ifdef CONFIG_ELF_XIP
+			/* Sections used in place take no memory */
+
+			if (elf_xipsection(loadinfo, i)) {
+				continue;
+			}
+#endif
+
 			/* SHF_WRITE indicates that the section address space is write-
 			 * able
 			 */
@@ -205,6 +273,16 @@ static inline int elf_loadfile(FAR struct elf_loadinfo_s *loadinfo)
 			continue;
 		}
 
+#ifdef CONFIG_ELF_XIP
+		/* Use the section in place in the mapped file */
+
+		if (elf_xipsection(loadinfo, i)) {
+			binfo("%d. %08lx->%08lx (XIP)\n", i, (unsigned long)shdr->sh_addr, (unsigned long)(loadinfo->xipbase + shdr->sh_offset));
+			shdr->sh_addr = loadinfo->xipbase + shdr->sh_offset;
+			continue;
+		}
+#endif
+
 		/* SHF_WRITE indicates that the section address space is write-
 		 * able
 		 */
@@ -0,0 +1,324 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * os/binfmt/libelf/libelf_procfs.c
+ *
+ * /proc/elf: statistics of the relocation of the ELF binaries, since boot
+ * and for the binary loaded last, and of the block cache for that binary.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/procfs.h>
+
+#include "libelf.h"
+
+#ifdef ELF_HAVE_STATS
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+/* Determines the size of an intermediate buffer that must be large enough
+ * to handle the longest line generated by this logic.
+ */
+
+#define ELF_LINELEN 64
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one open "file" */
+
+struct elf_file_s {
+	struct procfs_file_s base;	/* Base open file structure */
+	struct elf_bind_stats_s total;	/* Statistics since boot, at open */
+	struct elf_bind_stats_s last;	/* Statistics of the last binary, at open */
+#ifdef CONFIG_ELF_CACHE_READ
+	struct elf_cache_stats_s cache;	/* Statistics of the block cache, at open */
+#endif
+	char line[ELF_LINELEN];		/* Pre-allocated buffer for formatted lines */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int elf_procfs_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode);
+static int elf_procfs_close(FAR struct file *filep);
+static ssize_t elf_procfs_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+
+static int elf_procfs_dup(FAR const struct file *oldp, FAR struct file *newp);
+
+static int elf_procfs_stat(FAR const char *relpath, FAR struct stat *buf);
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* See fs_procfs.c -- this structure is explicitly externed there. */
+
+const struct procfs_operations elf_procfsoperations = {
+	elf_procfs_open,			/* open */
+	elf_procfs_close,			/* close */
+	elf_procfs_read,			/* read */
+	NULL,						/* write */
+
+	elf_procfs_dup,				/* dup */
+
+	NULL,						/* opendir */
+	NULL,						/* closedir */
+	NULL,						/* readdir */
+	NULL,						/* rewinddir */
+
+	elf_procfs_stat				/* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: elf_procfs_open
+ ****************************************************************************/
+
+static int elf_procfs_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode)
+{
+	FAR struct elf_file_s *attr;
+
+	fvdbg("Open '%s'\n", relpath);
+
+	/* PROCFS is read-only.  Any attempt to open with any kind of write
+	 * access is not permitted.
+	 */
+
+	if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0) {
+		fdbg("ERROR: Only O_RDONLY supported\n");
+		return -EACCES;
+	}
+
+	/* "elf" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "elf") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* Allocate a container to hold the file attributes */
+
+	attr = (FAR struct elf_file_s *)kmm_zalloc(sizeof(struct elf_file_s));
+	if (!attr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* Take the statistics now, so that all the reads of the file agree */
+
+	elf_bind_getstats(&attr->total, &attr->last);
+#ifdef CONFIG_ELF_CACHE_READ
+	elf_cache_getstats(&attr->cache);
+#endif
+
+	/* Save the attributes as the open-specific state in filep->f_priv */
+
+	filep->f_priv = (FAR void *)attr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: elf_procfs_close
+ ****************************************************************************/
+
+static int elf_procfs_close(FAR struct file *filep)
+{
+	FAR struct elf_file_s *attr;
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct elf_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Release the file attributes structure */
+
+	kmm_free(attr);
+	filep->f_priv = NULL;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: elf_procfs_read
+ ****************************************************************************/
+
+static ssize_t elf_procfs_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct elf_file_s *attr;
+	size_t remaining;
+	size_t linesize;
+	size_t copysize;
+	size_t totalsize;
+	off_t offset;
+	int nlines;
+	int i;
+
+	fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct elf_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	offset = filep->f_pos;
+	remaining = buflen;
+	totalsize = 0;
+
+#ifdef CONFIG_ELF_CACHE_READ
+	nlines = 8;
+#else
+	nlines = 6;
+#endif
+
+	for (i = 0; i < nlines && totalsize < buflen; i++) {
+		switch (i) {
+		case 0:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10s %10s\n", "", "total", "last");
+			break;
+		case 1:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10u %10u\n", "binds", attr->total.binds, attr->last.binds);
+			break;
+		case 2:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10u %10u\n", "relocations", attr->total.relocs, attr->last.relocs);
+			break;
+		case 3:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10u %10u\n", "lookups", attr->total.lookups, attr->last.lookups);
+			break;
+		case 4:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10u %10u\n", "reads", attr->total.reads, attr->last.reads);
+			break;
+		case 5:
+			linesize = snprintf(attr->line, ELF_LINELEN, "%-12s %10lu %10lu\n", "time (us)", attr->total.usecs, attr->last.usecs);
+			break;
+#ifdef CONFIG_ELF_CACHE_READ
+		case 6:
+			linesize = snprintf(attr->line, ELF_LINELEN, "cache hits %u misses %u\n", attr->cache.hits, attr->cache.misses);
+			break;
+		case 7:
+			linesize = snprintf(attr->line, ELF_LINELEN, "cache prefetches %u hits %u late %u\n", attr->cache.prefetches, attr->cache.prefetch_hits, attr->cache.prefetch_late);
+			break;
+#endif
+		default:
+			linesize = 0;
+			break;
+		}
+
+		copysize = procfs_memcpy(attr->line, linesize, buffer, remaining, &offset);
+		totalsize += copysize;
+		buffer += copysize;
+		remaining -= copysize;
+	}
+
+	if (totalsize > 0) {
+		filep->f_pos += totalsize;
+	}
+
+	return totalsize;
+}
+
+/****************************************************************************
+ * Name: elf_procfs_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int elf_procfs_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+	FAR struct elf_file_s *oldattr;
+	FAR struct elf_file_s *newattr;
+
+	fvdbg("Dup %p->%p\n", oldp, newp);
+
+	/* Recover our private data from the old struct file instance */
+
+	oldattr = (FAR struct elf_file_s *)oldp->f_priv;
+	DEBUGASSERT(oldattr);
+
+	/* Allocate a new container to hold the task and attribute selection */
+
+	newattr = (FAR struct elf_file_s *)kmm_malloc(sizeof(struct elf_file_s));
+	if (!newattr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* The copy the file attributes from the old attributes to the new */
+
+	memcpy(newattr, oldattr, sizeof(struct elf_file_s));
+
+	/* Save the new attributes in the new file structure */
+
+	newp->f_priv = (FAR void *)newattr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: elf_procfs_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int elf_procfs_stat(FAR const char *relpath, FAR struct stat *buf)
+{
+	/* "elf" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "elf") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* "elf" is the name for a read-only file */
+
+	buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+	buf->st_size = 0;
+	buf->st_blksize = 0;
+	buf->st_blocks = 0;
+	return OK;
+}
+
+#endif							/* ELF_HAVE_STATS */
@@ -70,6 +70,10 @@
 #include <tinyara/binfmt/compression/compress_read.h>
 #endif
 
+#ifdef CONFIG_ELF_CACHE_READ
+#include "libelf.h"
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -172,7 +176,10 @@ int elf_read(FAR struct elf_loadinfo_s *loadinfo, FAR uint8_t *buffer, size_t re
 #ifdef CONFIG_COMPRESSED_BINARY
 			if (loadinfo->compression_type == CONFIG_COMPRESSION_TYPE) {
 				/* Read readsize bytes from offset from uncompressed file into unser buffer */
-#if defined(CONFIG_ELF_CACHE_READ)
+#if defined(CONFIG_ELF_CACHE_READAHEAD)
+				/* Read through the cache, which decompresses the next block while one is copied */
+				nbytes = elf_cache_read(loadinfo->filfd, loadinfo->offset, buffer, readsize, offset - loadinfo->offset);
+#elif defined(CONFIG_ELF_CACHE_READ)
 				/* Cache only if readsize request <= cache block size */
 				if (readsize <= CONFIG_ELF_CACHE_BLOCK_SIZE) {
 					nbytes = elf_cache_read(loadinfo->filfd, loadinfo->offset, buffer, readsize, offset - loadinfo->offset);
@@ -184,6 +191,7 @@ int elf_read(FAR struct elf_loadinfo_s *loadinfo, FAR uint8_t *buffer, size_t re
 #endif
 			} else {
 				berr("No support for decompression of compression format %d of this binary\n", loadinfo->compression_type);
+				return ERROR;
 			}
 #else
 			berr("No support for reading compressed binaries\n");
@@ -225,7 +225,7 @@ void elf_readsymtab(FAR struct elf_loadinfo_s *loadinfo)
 		return;
 	}
 
-	if (elf_read(loadinfo, loadinfo->symtab, symtab->sh_size, symtab->sh_offset) < 0) {
+	if (elf_read(loadinfo, (FAR uint8_t *)loadinfo->symtab, symtab->sh_size, symtab->sh_offset) < 0) {
 		berr("ERROR: Failed to load symbol table into memory\n");
 	}
 }
@@ -266,7 +266,7 @@ int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index, FAR Elf32_Sym *s
 
 		/* And, finally, read the symbol table entry into memory */
 
-		memcpy(sym, loadinfo->symtab + offset, sizeof(Elf32_Sym));
+		memcpy(sym, (FAR const void *)(loadinfo->symtab + offset), sizeof(Elf32_Sym));
 		return OK;
 	} else {
 
@@ -280,6 +280,36 @@ int elf_readsym(FAR struct elf_loadinfo_s *loadinfo, int index, FAR Elf32_Sym *s
 	}
 }
 
+/****************************************************************************
+ * Name: elf_savesym
+ *
+ * Description:
+ *   Save the value of the symbol at the specified index, as returned by
+ *   elf_symvalue(), in the symbol table read into memory.  The entry is
+ *   saved as an absolute symbol so that the next relocations against the
+ *   same symbol neither read its name nor look it up again.
+ *
+ * Input Parameters:
+ *   loadinfo - Load state information
+ *   index    - Symbol table index
+ *   sym      - The symbol table entry with its value
+ *
+ ****************************************************************************/
+
+void elf_savesym(FAR struct elf_loadinfo_s *loadinfo, int index, FAR const Elf32_Sym *sym)
+{
+	FAR Elf32_Shdr *symtab = &loadinfo->shdr[loadinfo->symtabidx];
+	FAR Elf32_Sym *entry;
+
+	if (!loadinfo->symtab || index < 0 || index >= (symtab->sh_size / sizeof(Elf32_Sym))) {
+		return;
+	}
+
+	entry = (FAR Elf32_Sym *)(loadinfo->symtab + sizeof(Elf32_Sym) * index);
+	entry->st_value = sym->st_value;
+	entry->st_shndx = SHN_ABS;
+}
+
 /****************************************************************************
  * Name: elf_symvalue
  *
@@ -341,8 +371,10 @@ int elf_symvalue(FAR struct elf_loadinfo_s *loadinfo, FAR Elf32_Sym *sym, FAR co
 
 		/* Check if the base code exports a symbol of this name */
 
-#ifdef CONFIG_SYMTAB_ORDEREDBYNAME
+#if defined(CONFIG_SYMTAB_ORDEREDBYNAME)
 		symbol = symtab_findorderedbyname(exports, (FAR char *)loadinfo->iobuffer, nexports);
+#elif defined(CONFIG_SYMTAB_PERFECTHASH)
+		symbol = symtab_findhashedbyname(exports, (FAR char *)loadinfo->iobuffer, nexports);
 #else
 		symbol = symtab_findbyname(exports, (FAR char *)loadinfo->iobuffer, nexports);
 #endif
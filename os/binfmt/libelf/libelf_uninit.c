@@ -103,6 +103,11 @@ int elf_uninit(struct elf_loadinfo_s *loadinfo)
 
 	elf_freebuffers(loadinfo);
 
+#if defined(CONFIG_ELF_CACHE_READ)
+	/* Release the cache first, a block may still be read ahead */
+	elf_cache_uninit();
+#endif
+
 	/* Free buffers used for decompression */
 	if (loadinfo->compression_type > COMPRESS_TYPE_NONE) {
 #ifdef CONFIG_COMPRESSED_BINARY
@@ -112,9 +117,6 @@ int elf_uninit(struct elf_loadinfo_s *loadinfo)
 		return ERROR;
 #endif
 	}
-#if defined(CONFIG_ELF_CACHE_READ)
-	elf_cache_uninit();
-#endif
 
 	/* Close the ELF file */
 
@@ -27,6 +27,9 @@
 #include <string.h>
 #include <debug.h>
 #include <errno.h>
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+#include <semaphore.h>
+#endif
 
 #include <tinyara/fs/fs.h>
 #include <tinyara/binfmt/compression/compress_read.h>
@@ -44,6 +47,11 @@
 static struct s_header *compression_header;
 static struct s_buffer buffers;
 
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+/* Serializes the seek and read of a block, blocks are read ahead by a worker */
+static sem_t file_sem;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -261,15 +269,27 @@ static off_t compress_read_block(int filfd, uint16_t binary_header_size, FAR uin
 		return readsize;
 	}
 
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	while (sem_wait(&file_sem) != 0) {
+		ASSERT(get_errno() == EINTR);
+	}
+#endif
+
 	/* Seek to location of 'block_number' block in compressed file */
 	rpos = compress_lseek_block(filfd, binary_header_size, block_number);
 	if (rpos < 0) {
 		bcmpdbg("Failed to seek to offset of block number %d\n", block_number);
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+		sem_post(&file_sem);
+#endif
 		return rpos;
 	}
 
 	/* Read 'block_number' block into buf */
 	nbytes = read(filfd, buf, readsize);
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	sem_post(&file_sem);
+#endif
 	if (nbytes != readsize) {
 		bcmpdbg("Read for compressed block %d failed\n", block_number);
 		return ERROR;
@@ -279,19 +299,17 @@ static off_t compress_read_block(int filfd, uint16_t binary_header_size, FAR uin
 }
 
 /****************************************************************************
- * Name: compress_read
+ * Name: compress_read_buffers
  *
  * Description:
- *   Read bytes from the compressed file using 'offset' and 'readsize' info
- *   provided for uncompressed file.  The data is read into 'buffer'. Offset
- *   value here is offset from start of uncompressed binary (excluding binary
- *   header).
+ *   Same as compress_read(), with the read and decompression buffers of the
+ *   caller, so that another thread can decompress blocks at the same time.
  *
  * Returned Value:
  *   Number of bytes read into buffer on Success
  *   Negative value on failure
  ****************************************************************************/
-int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset)
+int compress_read_buffers(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset, FAR struct s_buffer *bufs)
 {
 	int first_block;
 	int last_block;
@@ -327,7 +345,7 @@ int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, s
 	/* Reading and decompressing blocks from first_block to last_block. Then writing to buffer. */
 	for (; index < first_block + no_blocks; index++) {
 		/* Read compressed 'index' block into read_buffer */
-		size = compress_read_block(filfd, binary_header_size, buffers.read_buffer, index);
+		size = compress_read_block(filfd, binary_header_size, bufs->read_buffer, index);
 		if (size < 0) {
 			bcmpdbg("Read for compressed block %d failed\n", index);
 			buffer_index = size;
@@ -335,7 +353,7 @@ int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, s
 		}
 
 		/* Decompress block in read_buffer to out_buffer */
-		ret = compress_decompress_block(buffers.out_buffer, &writesize, buffers.read_buffer, &size, index);
+		ret = compress_decompress_block(bufs->out_buffer, &writesize, bufs->read_buffer, &size, index);
 		if (ret == ERROR) {
 			bcmpdbg("Failed to decompress %d block of this binary\n", index);
 			buffer_index = ret;
@@ -349,7 +367,7 @@ int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, s
 			 * Otherwise, write from start_offset to end_offset into buffer.
 			 */
 			block_size_to_write = ((index + 1) * blocksize - 1 > actual_offset + readsize - 1 ? readsize : (index + 1) * blocksize - actual_offset);
-			memcpy(&buffer[buffer_index], &buffers.out_buffer[actual_offset - (index * blocksize)], block_size_to_write);
+			memcpy(&buffer[buffer_index], &bufs->out_buffer[actual_offset - (index * blocksize)], block_size_to_write);
 			buffer_index += block_size_to_write;
 		} else if (index == last_block) {
 			/*
@@ -358,7 +376,7 @@ int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, s
 			 * Write from start_offset to end_offset from this block into buffer.
 			 */
 			block_size_to_write = actual_offset + readsize - (index * blocksize);
-			memcpy(&buffer[buffer_index], &buffers.out_buffer[0], block_size_to_write);
+			memcpy(&buffer[buffer_index], &bufs->out_buffer[0], block_size_to_write);
 			buffer_index += block_size_to_write;
 		} else {
 			/*
@@ -366,7 +384,7 @@ int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, s
 			 * So, write entire block into buffer.
 			 */
 			block_size_to_write = blocksize;
-			memcpy(&buffer[buffer_index], &buffers.out_buffer[0], block_size_to_write);
+			memcpy(&buffer[buffer_index], &bufs->out_buffer[0], block_size_to_write);
 			buffer_index += block_size_to_write;
 		}
 	}
@@ -375,6 +393,84 @@ error_compress_read:
 	return buffer_index;
 }
 
+/****************************************************************************
+ * Name: compress_read
+ *
+ * Description:
+ *   Read bytes from the compressed file using 'offset' and 'readsize' info
+ *   provided for uncompressed file.  The data is read into 'buffer'. Offset
+ *   value here is offset from start of uncompressed binary (excluding binary
+ *   header).
+ *
+ * Returned Value:
+ *   Number of bytes read into buffer on Success
+ *   Negative value on failure
+ ****************************************************************************/
+int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset)
+{
+	return compress_read_buffers(filfd, binary_header_size, buffer, readsize, offset, &buffers);
+}
+
+/****************************************************************************
+ * Name: compress_init_buffers
+ *
+ * Description:
+ *   Allocate the read and decompression buffers for the blocks of the file
+ *   initialized by compress_init
+ *
+ * Returned value:
+ *   OK (0) on Success
+ *   -ENOMEM on Failure
+ ****************************************************************************/
+int compress_init_buffers(FAR struct s_buffer *bufs)
+{
+	bufs->read_buffer = NULL;
+	bufs->out_buffer = NULL;
+
+#if CONFIG_COMPRESSION_TYPE == LZMA
+	/* Allocating memory for read and out buffer to be used for LZMA decompression */
+	if (compression_header->compression_format == COMPRESSION_TYPE_LZMA) {
+		bufs->read_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize + 5);
+		bufs->out_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
+	}
+#elif CONFIG_COMPRESSION_TYPE == MINIZ
+	/* Allocating memory for read and out buffer to be used for Miniz decompression */
+	if (compression_header->compression_format == COMPRESSION_TYPE_MINIZ) {
+		bufs->read_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
+		bufs->out_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
+	}
+#endif
+
+	if (!bufs->read_buffer || !bufs->out_buffer) {
+		bcmpdbg("Failed kmm_malloc for decompression buffers\n");
+		compress_uninit_buffers(bufs);
+		return -ENOMEM;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: compress_uninit_buffers
+ *
+ * Description:
+ *   Release buffers allocated by compress_init_buffers
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+void compress_uninit_buffers(FAR struct s_buffer *bufs)
+{
+	if (bufs->read_buffer) {
+		kmm_free(bufs->read_buffer);
+		bufs->read_buffer = NULL;
+	}
+	if (bufs->out_buffer) {
+		kmm_free(bufs->out_buffer);
+		bufs->out_buffer = NULL;
+	}
+}
+
 /****************************************************************************
  * Name: compress_init
  *
@@ -399,20 +495,13 @@ int compress_init(int filfd, uint16_t offset, off_t *filelen)
 	/* Assign file length as that of uncompressed file */
 	*filelen = compression_header->binary_size;
 
-#if CONFIG_COMPRESSION_TYPE == LZMA
-	/* Allocating memory for read and out buffer to be used for LZMA decompression */
-	if (compression_header->compression_format == COMPRESSION_TYPE_LZMA) {
-		buffers.read_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize + 5);
-		buffers.out_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
-	}
-#elif CONFIG_COMPRESSION_TYPE == MINIZ
-	/* Allocating memory for read and out buffer to be used for Miniz decompression */
-	if (compression_header->compression_format == COMPRESSION_TYPE_MINIZ) {
-		buffers.read_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
-		buffers.out_buffer = (unsigned char *)kmm_malloc(compression_header->blocksize);
-	}
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	sem_init(&file_sem, 0, 1);
 #endif
 
+	/* Allocating memory for read and out buffer to be used for decompression */
+	ret = compress_init_buffers(&buffers);
+
 error_compress_init:
 	return ret;
 }
@@ -428,18 +517,11 @@ error_compress_init:
  ****************************************************************************/
 void compress_uninit(void)
 {
-#if CONFIG_COMPRESSION_TYPE == LZMA || CONFIG_COMPRESSION_TYPE == MINIZ
 	/* Freeing memory allocated to read_buffer and out_buffer for file decompression */
-	if (compression_header->compression_format == COMPRESSION_TYPE_LZMA || compression_header->compression_format == COMPRESSION_TYPE_MINIZ) {
-		if (buffers.read_buffer) {
-			kmm_free(buffers.read_buffer);
-			buffers.read_buffer = NULL;
-		}
-		if (buffers.out_buffer) {
-			kmm_free(buffers.out_buffer);
-			buffers.out_buffer = NULL;
-		}
-	}
+	compress_uninit_buffers(&buffers);
+
+#ifdef CONFIG_ELF_CACHE_READAHEAD
+	sem_destroy(&file_sem);
 #endif
 
 	kmm_free(compression_header);
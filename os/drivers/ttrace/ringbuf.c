@@ -20,6 +20,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <tinyara/config.h>
+
+#include <string.h>
 #include <tinyara/ringbuf.h>
 
 inline void printBuf(char *buf, struct ringbuf *rbp)
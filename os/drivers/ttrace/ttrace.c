@@ -41,9 +41,12 @@
 #include <tinyara/fs/fs.h>
 #include <tinyara/arch.h>
 #include <tinyara/ringbuf.h>
+#include <tinyara/ttrace.h>
 
 #include <arch/irq.h>
 
+#include "ttrace_binary.h"
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -98,6 +101,10 @@ static const struct file_operations g_ttracefops = {
 	ttrace_ioctl  /* ioctl */
 };
 
+#ifdef CONFIG_TTRACE_BINARY
+/* The rings of the binary records are in ttrace_binary.c */
+static bool g_overwrite;
+#else
 /* This is the pre-allocated buffer used for the T-trace */
 static struct ringbuf g_ringbuf = {
 	{0,},
@@ -106,6 +113,7 @@ static struct ringbuf g_ringbuf = {
 	0,
 	0
 };
+#endif
 
 static uint32_t g_state = TTRACE_STATE_IDLE;
 static uint32_t g_selected_tag = 0;
@@ -118,7 +126,11 @@ static uint32_t g_selected_tag = 0;
 static struct ttrace_dev_s g_sysdev = {
 	0,                        /* ttrace_head */
 	CONFIG_TTRACE_BUFSIZE,    /* ttrace_bufsize */
+#ifdef CONFIG_TTRACE_BINARY
+	NULL                      /* ttrace_packets_buffer */
+#else
 	g_ringbuf.buffer          /* ttrace_packets_buffer */
+#endif
 };
 
 /****************************************************************************
@@ -139,6 +151,11 @@ static ssize_t ttrace_read(FAR struct file *filep, FAR char *buffer, size_t len)
 	}
 
 	DEBUGASSERT(priv);
+#ifdef CONFIG_TTRACE_BINARY
+	len = ttrace_bin_read(buffer, len, filep->f_pos);
+	filep->f_pos += len;
+	return (ssize_t)len;
+#else
 	sched_lock();
 
 	ttdbg("buffer: %p, ringbuf: %p\r\n", buffer, g_ringbuf.buffer);
@@ -150,6 +167,7 @@ static ssize_t ttrace_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
 	sched_unlock();
 	return (ssize_t)len;
+#endif
 }
 
 /****************************************************************************
@@ -160,12 +178,33 @@ static ssize_t ttrace_write(FAR struct file *filep, FAR const char *buffer, size
 {
 	struct inode *inode = filep->f_inode;
 	struct ttrace_dev_s *priv = inode->i_private;
+#ifdef CONFIG_TTRACE_BINARY
+	struct ttrace_binmsg_s msg;
+#endif
 
 	if (TTRACE_STATE_RUNNING != g_state) {
 		return TTRACE_INVALID;
 	}
 
 	DEBUGASSERT(priv);
+#ifdef CONFIG_TTRACE_BINARY
+	/* Records of the trace points out of the kernel, which checked their tag */
+
+	if (len < sizeof(msg.rec) || len > sizeof(msg)) {
+		return TTRACE_INVALID;
+	}
+
+	memcpy(&msg, buffer, len);
+	if (msg.rec.nslots * TTRACE_BIN_SLOT != len) {
+		return TTRACE_INVALID;
+	}
+
+	if (ttrace_bin_write(TTRACE_TAG_ALL, &msg.rec) != TTRACE_VALID) {
+		return TTRACE_INVALID;
+	}
+
+	return (ssize_t)len;
+#else
 	sched_lock();
 
 	ringbuf_write(buffer, len, &g_ringbuf);
@@ -173,6 +212,7 @@ static ssize_t ttrace_write(FAR struct file *filep, FAR const char *buffer, size
 
 	sched_unlock();
 	return (ssize_t)len;
+#endif
 }
 
 /****************************************************************************
@@ -192,23 +232,38 @@ static int ttrace_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 	case TTRACE_START:
 		g_state = TTRACE_STATE_RUNNING;
 		priv->ttrace_head = 0;
+#ifdef CONFIG_TTRACE_BINARY
+		ttrace_bin_start(g_selected_tag, g_overwrite);
+#endif
 		break;
 	case TTRACE_OVERWRITE:
+#ifdef CONFIG_TTRACE_BINARY
+		g_overwrite = (arg != 0);
+#else
 		g_ringbuf.is_overwritable = arg;
+#endif
 		break;
 	case TTRACE_FINISH:
+#ifdef CONFIG_TTRACE_BINARY
+		ttrace_bin_finish();
+#endif
 		g_selected_tag = 0;
 		g_state = TTRACE_STATE_IDLE;
 		break;
 	case TTRACE_INFO:
-		ttdbg("Available tags: apps libs lock ipc task\r\n");
+		ttdbg("Available tags: apps libs lock ipc task irq\r\n");
 		ttdbg("State: %d\r\n", g_state);
 		ttdbg("Selected tags: %d\r\n", g_selected_tag);
+#ifdef CONFIG_TTRACE_BINARY
+		ttrace_bin_info();
+		ttdbg("Buffer is_overwritable: %d\r\n", g_overwrite);
+#else
 		ttdbg("Buffer index: %d\r\n", g_ringbuf.index);
 		ttdbg("Real Buffer size: %d\r\n", g_ringbuf.bufsize);
 		ttdbg("Given buffer size: %d\r\n", CONFIG_TTRACE_BUFSIZE);
 		ttdbg("Buffer is_overwritten: %d\r\n", g_ringbuf.is_overwritten);
 		ttdbg("Buffer is_overwritable: %d\r\n", g_ringbuf.is_overwritable);
+#endif
 		break;
 	case TTRACE_SELECTED_TAG:
 		g_selected_tag |= arg;
@@ -217,14 +272,20 @@ static int ttrace_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 		ret = g_selected_tag;
 		break;
 	case TTRACE_SET_BUFSIZE:
+#ifndef CONFIG_TTRACE_BINARY
 		g_ringbuf.bufsize = CONFIG_TTRACE_BUFSIZE - (CONFIG_TTRACE_BUFSIZE % arg);
+#endif
 		break;
 	case TTRACE_USED_BUFSIZE:
+#ifdef CONFIG_TTRACE_BINARY
+		ret = ttrace_bin_size();
+#else
 		if (g_ringbuf.is_overwritten == 0) {
 			ret = priv->ttrace_head;
 		} else {
 			ret = CONFIG_TTRACE_BUFSIZE;
 		}
+#endif
 		ttdbg("used bufsize: %d\r\n", ret);
 		break;
 	case TTRACE_BUFFER:
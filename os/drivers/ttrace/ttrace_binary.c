@@ -0,0 +1,247 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Binary records of T-trace.
+ *
+ * The trace points of the kernel write their records straight into the
+ * ring of the current CPU, without the T-trace device. A record is
+ * reserved by a compare and swap of the position of the ring, filled and
+ * then committed by writing its position in its first word, so that
+ * writers never disable interrupts and may run in interrupt handlers.
+ * Records don't wrap around the ring: a pad record fills its end.
+ *
+ * The rings are read as they are, when tracing is finished. The position
+ * counts the slots since the start, so that a record is valid when the
+ * position in its header is the one of its slot: records of the previous
+ * laps, or which were not committed, are not.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <debug.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/sched.h>
+#include <tinyara/ttrace.h>
+
+#include "ttrace_binary.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TTRACE_BIN_CPU              0
+
+#define TTRACE_BIN_REC(ring, pos) \
+	((FAR struct ttrace_binrec_s *)&(ring)->slots[(pos) % TTRACE_BIN_RINGSLOTS])
+
+#ifdef CONFIG_CLOCK_MONOTONIC
+#define TTRACE_BIN_CLOCK            CLOCK_MONOTONIC
+#else
+#define TTRACE_BIN_CLOCK            CLOCK_REALTIME
+#endif
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+struct ttrace_binring_s g_ttrace_binring[TTRACE_BIN_NCPUS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline uint32_t ttrace_bin_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(TTRACE_BIN_CLOCK, &ts);
+	return (uint32_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/* Names the tasks in the trace, the records only have their pid */
+
+static void ttrace_bin_taskname(FAR struct tcb_s *tcb, FAR void *arg)
+{
+#if CONFIG_TASK_NAME_SIZE > 0
+	struct ttrace_binmsg_s msg;
+	size_t len = strnlen(tcb->name, TTRACE_MSG_BYTES - 1);
+
+	memset(msg.name, 0, TTRACE_MSG_BYTES);
+	memcpy(msg.name, tcb->name, len);
+	msg.rec.type = TTRACE_BIN_TASKNAME;
+	msg.rec.nslots = TTRACE_BIN_HDRSLOTS + TTRACE_BIN_NAMESLOTS(len);
+	msg.rec.pid = tcb->pid;
+	msg.rec.arg = 0;
+	ttrace_bin_write(TTRACE_TAG_ALL, &msg.rec);
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ttrace_bin_write
+ *
+ * Description:
+ *   Writes a record in the ring of the current CPU if its tag is selected.
+ *   The type, the size, the pid and the argument of the record, and its
+ *   payload, are given by the caller. Its position and timestamp are set.
+ *
+ ****************************************************************************/
+
+int ttrace_bin_write(int tag, FAR const struct ttrace_binrec_s *rec)
+{
+	FAR struct ttrace_binring_s *ring = &g_ttrace_binring[TTRACE_BIN_CPU];
+	FAR struct ttrace_binrec_s *dst;
+	uint32_t nslots = rec->nslots;
+	uint32_t ts;
+	uint32_t pos;
+	uint32_t pad;
+	uint32_t next;
+
+	if (!(ring->tags & tag)) {
+		return TTRACE_INVALID;
+	}
+
+	DEBUGASSERT(nslots >= TTRACE_BIN_HDRSLOTS && nslots <= TTRACE_BIN_MAXSLOTS);
+	ts = ttrace_bin_usec();
+
+	pos = __atomic_load_n(&ring->pos, __ATOMIC_RELAXED);
+	do {
+		pad = TTRACE_BIN_RINGSLOTS - pos % TTRACE_BIN_RINGSLOTS;
+		if (pad >= nslots) {
+			pad = 0;
+		}
+
+		next = pos + pad + nslots;
+		if (!ring->overwrite && next > TTRACE_BIN_RINGSLOTS) {
+			__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return TTRACE_INVALID;
+		}
+	} while (!__atomic_compare_exchange_n(&ring->pos, &pos, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	/* Only the first slot of a pad record is written */
+
+	if (pad) {
+		dst = TTRACE_BIN_REC(ring, pos);
+		dst->type = TTRACE_BIN_PAD;
+		dst->nslots = pad;
+		__atomic_store_n(&dst->pos, pos, __ATOMIC_RELEASE);
+		pos += pad;
+	}
+
+	dst = TTRACE_BIN_REC(ring, pos);
+	memcpy(&dst->type, &rec->type, nslots * TTRACE_BIN_SLOT - sizeof(rec->pos));
+	dst->ts = ts;
+	__atomic_store_n(&dst->pos, pos, __ATOMIC_RELEASE);
+	return TTRACE_VALID;
+}
+
+/****************************************************************************
+ * Name: ttrace_bin_start
+ *
+ * Description:
+ *   Empties the rings and starts tracing the given tags.
+ *
+ ****************************************************************************/
+
+void ttrace_bin_start(uint32_t tags, bool overwrite)
+{
+	FAR struct ttrace_binring_s *ring;
+	int cpu;
+
+	for (cpu = 0; cpu < TTRACE_BIN_NCPUS; cpu++) {
+		ring = &g_ttrace_binring[cpu];
+		ring->tags = 0;
+		ring->magic = TTRACE_BIN_MAGIC;
+		ring->cpu = cpu;
+		ring->overwrite = overwrite;
+		ring->nslots = TTRACE_BIN_RINGSLOTS;
+		ring->pos = 0;
+		ring->dropped = 0;
+		__atomic_store_n(&ring->tags, tags, __ATOMIC_RELEASE);
+	}
+
+	sched_foreach(ttrace_bin_taskname, NULL);
+}
+
+/****************************************************************************
+ * Name: ttrace_bin_finish
+ *
+ * Description:
+ *   Names the tasks created since the start, then stops tracing.
+ *
+ ****************************************************************************/
+
+void ttrace_bin_finish(void)
+{
+	int cpu;
+
+	sched_foreach(ttrace_bin_taskname, NULL);
+	for (cpu = 0; cpu < TTRACE_BIN_NCPUS; cpu++) {
+		__atomic_store_n(&g_ttrace_binring[cpu].tags, 0, __ATOMIC_RELEASE);
+	}
+}
+
+void ttrace_bin_info(void)
+{
+	int cpu;
+
+	for (cpu = 0; cpu < TTRACE_BIN_NCPUS; cpu++) {
+		ttdbg("CPU %d: %u slots of %d bytes\r\n", cpu, TTRACE_BIN_RINGSLOTS, TTRACE_BIN_SLOT);
+		ttdbg("CPU %d: position %u, dropped %u\r\n", cpu, g_ttrace_binring[cpu].pos, g_ttrace_binring[cpu].dropped);
+	}
+}
+
+size_t ttrace_bin_size(void)
+{
+	return sizeof(g_ttrace_binring);
+}
+
+/****************************************************************************
+ * Name: ttrace_bin_read
+ *
+ * Description:
+ *   Copies the rings, as they are in memory, from the given offset.
+ *
+ ****************************************************************************/
+
+ssize_t ttrace_bin_read(FAR char *buffer, size_t len, off_t offset)
+{
+	if (offset >= sizeof(g_ttrace_binring)) {
+		return 0;
+	}
+
+	if (len > sizeof(g_ttrace_binring) - offset) {
+		len = sizeof(g_ttrace_binring) - offset;
+	}
+
+	memcpy(buffer, (FAR char *)g_ttrace_binring + offset, len);
+	return (ssize_t)len;
+}
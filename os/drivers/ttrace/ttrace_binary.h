@@ -0,0 +1,45 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __DRIVERS_TTRACE_TTRACE_BINARY_H
+#define __DRIVERS_TTRACE_TTRACE_BINARY_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_TTRACE_BINARY
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+void ttrace_bin_start(uint32_t tags, bool overwrite);
+void ttrace_bin_finish(void);
+void ttrace_bin_info(void);
+size_t ttrace_bin_size(void);
+ssize_t ttrace_bin_read(FAR char *buffer, size_t len, off_t offset);
+
+#endif /* CONFIG_TTRACE_BINARY */
+#endif /* __DRIVERS_TTRACE_TTRACE_BINARY_H */
@@ -357,6 +357,13 @@ struct smart_struct_s {
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	FAR uint8_t *erasecounts;	/* Number of erases for each erase block */
 #endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	uint16_t cpblock;			/* First erase block of the checkpoint areas */
+	uint16_t cpnblocks;			/* Number of erase blocks of a checkpoint area */
+	uint32_t cpseq;				/* Sequence number of the newest checkpoint */
+	uint8_t cparea;				/* Area holding the newest checkpoint */
+	bool cpvalid;				/* The newest checkpoint matches the sector map */
+#endif
 #ifdef CONFIG_MTD_SMART_ALLOC_DEBUG
 	size_t bytesalloc;
 	struct smart_alloc_s
@@ -439,6 +446,41 @@ typedef uint32_t crc_t;
 
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+#if defined(CONFIG_MTD_SMART_MINIMIZE_RAM) || defined(CONFIG_MTD_SMART_PACK_COUNTS)
+#error "The sector map checkpoint needs the full sector map and counts"
+#endif
+
+#define SMART_CP_SIG                "SMCP"
+#define SMART_CP_VERSION            1
+#define SMART_CP_NAREAS             2
+#define SMART_CP_DATALEN(d)         ((d)->totalsectors * sizeof(uint16_t) + ((d)->neraseblocks << 1))
+
+/* Checkpoint of the sector map, written at the start of one of the areas
+ * reserved at the end of the device.  The header is followed by the sector
+ * map and the release and free counts of the erase blocks, as they are in
+ * RAM (see SMART_CP_DATALEN).  The CRC covers everything after it.  The stale byte is left erased
+ * when the checkpoint is written, and programmed before the first change to
+ * the device after it.
+ */
+
+struct smart_checkpoint_s {
+	uint8_t sig[4];				/* "SMCP" */
+	uint8_t stale;				/* Erased while the checkpoint matches the device */
+	uint8_t version;			/* SMART_CP_VERSION */
+	uint8_t reserved[2];
+	uint32_t crc;				/* CRC-32 from seq to the end of the data */
+	uint32_t seq;				/* Incremented on each checkpoint */
+	uint16_t sectorsize;
+	uint16_t totalsectors;
+	uint16_t neraseblocks;
+	uint16_t freesectors;
+	uint16_t releasesectors;
+	uint8_t formatversion;
+	uint8_t namesize;
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -470,6 +512,11 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev, uint16_t
 static int smart_relocate_sector(FAR struct smart_struct_s *dev, uint16_t oldsector, uint16_t newsector);
 static int smart_validate_crc(FAR struct smart_struct_s *dev);
 static crc_t smart_calc_sector_crc(FAR struct smart_struct_s *dev);
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_load(FAR struct smart_struct_s *dev);
+static int smart_checkpoint_write(FAR struct smart_struct_s *dev);
+static int smart_checkpoint_invalidate(FAR struct smart_struct_s *dev, uint8_t area);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -581,8 +628,20 @@ static int smart_open(FAR struct inode *inode)
 
 static int smart_close(FAR struct inode *inode)
 {
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	FAR struct smart_struct_s *dev;
+#endif
+
 	fvdbg("Entry\n");
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	/* Keep the sector map, so that the next boot doesn't scan the device. */
+
+	dev = (FAR struct smart_struct_s *)inode->i_private;
+	return smart_checkpoint_write(dev);
+#else
 	return OK;
+#endif
 }
 
 /****************************************************************************
@@ -862,6 +921,13 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 
 	/* I think maybe we need to lock on a mutex here. */
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	ret = smart_checkpoint_invalidate(dev, dev->cparea);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
 	/* Get the aligned block.  Here is is assumed: (1) The number of R/W blocks
 	 * per erase block is a power of 2, and (2) the erase begins with that same
 	 * alignment.
@@ -1819,6 +1885,20 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 	}
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	/* After a clean shutdown, the sector map is loaded from the checkpoint
+	 * instead of reading the header of every sector.
+	 */
+
+	if (smart_checkpoint_load(dev) == OK) {
+		fdbg("SMART sector map loaded from checkpoint %u\n", dev->cpseq);
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+		smart_read_wearstatus(dev);
+#endif
+		return OK;
+	}
+#endif
+
 	dev->formatstatus = SMART_FMT_STAT_NOFMT;
 	dev->freesectors = dev->availSectPerBlk * dev->geo.neraseblocks;
 	dev->releasesectors = 0;
@@ -2333,6 +2413,273 @@ err_out:
 	return ret;
 }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+/****************************************************************************
+ * Name: smart_checkpoint_reserve
+ *
+ * Description:  Reserve the checkpoint areas at the end of the device, large
+ *               enough for the sector map with the configured sector size.
+ *               The SMART volume only uses the erase blocks before them.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_reserve(FAR struct smart_struct_s *dev)
+{
+	uint32_t nsectors;
+	uint32_t cpsize;
+
+	nsectors = dev->geo.neraseblocks * (dev->geo.erasesize / CONFIG_MTD_SMART_SECTOR_SIZE);
+	if (nsectors > 65536) {
+		nsectors = 65536;
+	}
+
+	cpsize = sizeof(struct smart_checkpoint_s) + nsectors * sizeof(uint16_t) + (dev->geo.neraseblocks << 1);
+	dev->cpnblocks = (cpsize + dev->geo.erasesize - 1) / dev->geo.erasesize;
+
+	if (dev->geo.neraseblocks <= SMART_CP_NAREAS * dev->cpnblocks) {
+		fdbg("Device too small for the sector map checkpoint\n");
+		return -EINVAL;
+	}
+
+	dev->geo.neraseblocks -= SMART_CP_NAREAS * dev->cpnblocks;
+	dev->cpblock = dev->geo.neraseblocks;
+	dev->cpseq = 0;
+	dev->cparea = SMART_CP_NAREAS - 1;
+	dev->cpvalid = false;
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_address
+ *
+ * Description:  Byte address of a checkpoint area on the MTD device.
+ *
+ ****************************************************************************/
+
+static inline uint32_t smart_checkpoint_address(FAR struct smart_struct_s *dev, uint8_t area)
+{
+	return (dev->cpblock + area * dev->cpnblocks) * dev->geo.erasesize;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_crc
+ *
+ * Description:  CRC of the checkpoint, from the sequence number to the end
+ *               of the sector map and counts in RAM.
+ *
+ ****************************************************************************/
+
+static uint32_t smart_checkpoint_crc(FAR struct smart_struct_s *dev, FAR struct smart_checkpoint_s *cp)
+{
+	uint32_t crc;
+
+	crc = crc32part((FAR const uint8_t *)&cp->seq, sizeof(*cp) - offsetof(struct smart_checkpoint_s, seq), 0);
+	return crc32part((FAR const uint8_t *)dev->sMap, SMART_CP_DATALEN(dev), crc);
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_load
+ *
+ * Description:  Load the sector map and the sector counts from the newest
+ *               checkpoint, if it still matches the device.  Otherwise, the
+ *               checkpoints left are marked stale, as the device is going to
+ *               be scanned and they may no longer match.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_load(FAR struct smart_struct_s *dev)
+{
+	struct smart_checkpoint_s cp;
+	uint8_t validmask = 0;
+	uint8_t area;
+	int newest = -1;
+	int ret;
+
+	for (area = 0; area < SMART_CP_NAREAS; area++) {
+		ret = MTD_READ(dev->mtd, smart_checkpoint_address(dev, area), sizeof(cp), (FAR uint8_t *)&cp);
+		if (ret != sizeof(cp) || memcmp(cp.sig, SMART_CP_SIG, 4) != 0) {
+			continue;
+		}
+
+		/* New checkpoints must be newer than any on the device */
+
+		if (cp.seq > dev->cpseq) {
+			dev->cpseq = cp.seq;
+			dev->cparea = area;
+		}
+
+		if (cp.stale != CONFIG_SMARTFS_ERASEDSTATE) {
+			continue;
+		}
+
+		validmask |= 1 << area;
+		if (cp.version == SMART_CP_VERSION && cp.sectorsize == dev->sectorsize &&
+				cp.totalsectors == dev->totalsectors && cp.neraseblocks == dev->neraseblocks &&
+				(newest < 0 || cp.seq == dev->cpseq)) {
+			newest = area;
+		}
+	}
+
+	if (newest >= 0) {
+		ret = MTD_READ(dev->mtd, smart_checkpoint_address(dev, newest), sizeof(cp), (FAR uint8_t *)&cp);
+		if (ret == sizeof(cp)) {
+			ret = MTD_READ(dev->mtd, smart_checkpoint_address(dev, newest) + sizeof(cp), SMART_CP_DATALEN(dev), (FAR uint8_t *)dev->sMap);
+		}
+
+		if (ret >= 0 && smart_checkpoint_crc(dev, &cp) == cp.crc) {
+			dev->freesectors = cp.freesectors;
+			dev->releasesectors = cp.releasesectors;
+			dev->formatversion = cp.formatversion;
+			dev->namesize = cp.namesize;
+			dev->formatstatus = SMART_FMT_STAT_FORMATTED;
+			dev->cparea = newest;
+			dev->cpvalid = true;
+			return OK;
+		}
+
+		fdbg("Invalid checkpoint %u, scanning the device\n", cp.seq);
+	}
+
+	for (area = 0; area < SMART_CP_NAREAS; area++) {
+		if (validmask & (1 << area)) {
+			dev->cpvalid = true;
+			smart_checkpoint_invalidate(dev, area);
+		}
+	}
+
+	return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_write
+ *
+ * Description:  Write the sector map and the sector counts to the area not
+ *               holding the newest checkpoint, if they changed since.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_write(FAR struct smart_struct_s *dev)
+{
+	struct smart_checkpoint_s cp;
+	FAR const uint8_t *data;
+	size_t datalen;
+	size_t total;
+	size_t pos;
+	size_t len;
+	uint32_t mtdblock;
+	uint8_t area;
+	int ret;
+
+	if (dev->cpvalid || dev->formatstatus != SMART_FMT_STAT_FORMATTED) {
+		return OK;
+	}
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+	/* Sectors allocated but not written yet are only known in RAM */
+
+	if (dev->allocsector != NULL) {
+		return OK;
+	}
+#endif
+
+	/* A volume formatted with smaller sectors may not fit the areas */
+
+	datalen = SMART_CP_DATALEN(dev);
+	total = sizeof(cp) + datalen;
+	if (total > dev->cpnblocks * dev->geo.erasesize) {
+		return OK;
+	}
+
+	area = (dev->cparea + 1) % SMART_CP_NAREAS;
+	ret = MTD_ERASE(dev->mtd, dev->cpblock + area * dev->cpnblocks, dev->cpnblocks);
+	if (ret < 0) {
+		fdbg("Error %d erasing checkpoint area %d\n", -ret, area);
+		return ret;
+	}
+
+	memset(&cp, 0, sizeof(cp));
+	memcpy(cp.sig, SMART_CP_SIG, 4);
+	cp.stale = CONFIG_SMARTFS_ERASEDSTATE;
+	cp.version = SMART_CP_VERSION;
+	cp.seq = dev->cpseq + 1;
+	cp.sectorsize = dev->sectorsize;
+	cp.totalsectors = dev->totalsectors;
+	cp.neraseblocks = dev->neraseblocks;
+	cp.freesectors = dev->freesectors;
+	cp.releasesectors = dev->releasesectors;
+	cp.formatversion = dev->formatversion;
+	cp.namesize = dev->namesize;
+	cp.crc = smart_checkpoint_crc(dev, &cp);
+
+	/* Write the header and the data a sector at a time */
+
+	data = (FAR const uint8_t *)dev->sMap;
+	mtdblock = smart_checkpoint_address(dev, area) / dev->geo.blocksize;
+
+	for (pos = 0; pos < total; pos += dev->sectorsize) {
+		memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->sectorsize);
+
+		if (pos == 0) {
+			memcpy(dev->rwbuffer, &cp, sizeof(cp));
+			len = dev->sectorsize - sizeof(cp);
+			if (len > datalen) {
+				len = datalen;
+			}
+			memcpy(&dev->rwbuffer[sizeof(cp)], data, len);
+		} else {
+			len = total - pos;
+			if (len > dev->sectorsize) {
+				len = dev->sectorsize;
+			}
+			memcpy(dev->rwbuffer, &data[pos - sizeof(cp)], len);
+		}
+
+		ret = MTD_BWRITE(dev->mtd, mtdblock, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+		if (ret != dev->mtdBlksPerSector) {
+			fdbg("Error %d writing checkpoint area %d\n", ret, area);
+			return ret < 0 ? ret : -EIO;
+		}
+
+		mtdblock += dev->mtdBlksPerSector;
+	}
+
+	dev->cpseq = cp.seq;
+	dev->cparea = area;
+	dev->cpvalid = true;
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_invalidate
+ *
+ * Description:  Mark the checkpoint of the area stale.  This must be done
+ *               before changing anything on the device after the newest
+ *               checkpoint was loaded or written.
+ *
+ ****************************************************************************/
+
+static int smart_checkpoint_invalidate(FAR struct smart_struct_s *dev, uint8_t area)
+{
+	uint8_t stale = (uint8_t)~CONFIG_SMARTFS_ERASEDSTATE;
+	int ret;
+
+	if (!dev->cpvalid) {
+		return OK;
+	}
+
+	ret = smart_bytewrite(dev, smart_checkpoint_address(dev, area) + offsetof(struct smart_checkpoint_s, stale), 1, &stale);
+	if (ret < 0) {
+		fdbg("Error %d invalidating checkpoint area %d\n", -ret, area);
+		return ret;
+	}
+
+	dev->cpvalid = false;
+	return OK;
+}
+#endif							/* CONFIG_MTD_SMART_CHECKPOINT */
+
 /****************************************************************************
  * Name: smart_getformat
  *
@@ -5228,6 +5575,17 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 	dev = (FAR struct smart_struct_s *)inode->i_private;
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	/* The checkpoint of the sector map must be stale before the first change */
+
+	if (cmd == BIOC_LLFORMAT || cmd == BIOC_ALLOCSECT || cmd == BIOC_FREESECT || cmd == BIOC_WRITESECT) {
+		ret = smart_checkpoint_invalidate(dev, dev->cparea);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+#endif
+
 	/* Process the ioctl's we care about first, pass any we don't respond
 	 * to directly to the underlying MTD device.
 	 */
@@ -5312,6 +5670,17 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 		goto ok_out;
 #endif							/* CONFIG_FS_WRITABLE */
 
+	case BIOC_FLUSH:
+
+		/* Checkpoint the sector map, so that the next mount needs no scan. */
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+		ret = smart_checkpoint_write(dev);
+#else
+		ret = OK;
+#endif
+		goto ok_out;
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 	case BIOC_GETPROCFSD:
 
@@ -5472,6 +5841,12 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 #endif
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
 		dev->allocsector = NULL;
+#endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+		ret = smart_checkpoint_reserve(dev);
+		if (ret != OK) {
+			goto errout;
+		}
 #endif
 		dev->sectorsize = 0;
 		ret = smart_setsectorsize(dev, CONFIG_MTD_SMART_SECTOR_SIZE);
@@ -5655,6 +6030,13 @@ int smart_recoversectors(FAR struct inode *inode, char *validsectors, int *nobso
 
 	totalsectors = dev->totalsectors;
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	ret = smart_checkpoint_invalidate(dev, dev->cparea);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
 	/* Mark the reserved sectors as valid. */
 	for (logicalsector = 0; logicalsector < dev->reservedsector; logicalsector++) {
 		smart_validatesector(inode, logicalsector, validsectors);
@@ -66,6 +66,9 @@
 
 #include <tinyara/fs/mtd.h>
 #include <tinyara/fs/smart.h>
+#ifdef CONFIG_SCHED_LPWORK
+#include <tinyara/wqueue.h>
+#endif
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -223,6 +226,13 @@
 #define SMARTFS_BFLAG_DIRTY       0x01	/* Set if data changed in the sector */
 #define SMARTFS_BFLAG_NEWALLOC    0x02	/* Set if sector not written since alloc */
 
+/* Buffered data is also flushed after a delay by the work queue */
+
+#if defined(CONFIG_SMARTFS_WRITEBACK) && defined(CONFIG_SCHED_LPWORK) && \
+	CONFIG_SMARTFS_WRITEBACK_DELAY > 0
+#define SMARTFS_WRITEBACK_DELAYED
+#endif
+
 #define SMARTFS_ERASEDSTATE_16BIT (uint16_t)((CONFIG_SMARTFS_ERASEDSTATE << 8) | \
 								  CONFIG_SMARTFS_ERASEDSTATE)
 
@@ -232,6 +242,20 @@
 #define UINT8_TO_UINT16(UINT8_ARRAY)                    ((uint16_t)(((uint16_t)UINT8_ARRAY[1] << 8) & 0xFF00) | UINT8_ARRAY[0])
 #define SMARTFS_NEXTSECTOR(h)   (UINT8_TO_UINT16(h->nextsector))
 #define SMARTFS_USED(h)                 (UINT8_TO_UINT16(h->used))
+
+#ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
+#define ENTRY_VALID(e) ((smartfs_rdle16(&(e)->flags) & SMARTFS_DIRENT_EMPTY) != \
+						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_EMPTY)) && \
+						((smartfs_rdle16(&(e)->flags) & SMARTFS_DIRENT_ACTIVE) == \
+						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_ACTIVE))
+
+#else
+#define ENTRY_VALID(e) (((e)->flags & SMARTFS_DIRENT_EMPTY) != \
+						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_EMPTY)) && \
+						(((e)->flags & SMARTFS_DIRENT_ACTIVE) == \
+						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_ACTIVE))
+
+#endif
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
 #define CONFIG_SMARTFS_USE_SECTOR_BUFFER
 #endif
@@ -344,6 +368,12 @@ struct smartfs_ofile_s {
 #ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
 	uint8_t *buffer;			/* Sector buffer to reduce writes */
 	uint8_t bflags;				/* Buffer flags */
+#endif
+#ifdef CONFIG_SMARTFS_WRITEBACK
+	struct smartfs_ofile_s *wbnext;	/* Next file with buffered data */
+	uint8_t *wbuffer;			/* Image of currsector with the data appended
+								 * but not written yet, NULL if none */
+	uint16_t wbstart;			/* Offset of the first byte not written */
 #endif
 	int16_t crefs;				/* Reference count */
 	mode_t oflags;				/* Open mode */
@@ -359,6 +389,33 @@ struct smartfs_ofile_s {
 								 * causes the sector to change. */
 };
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+/* One slot of a directory index: where an entry whose name has the hash is
+ * stored.  Slots are open addressed, empty ones have the sector
+ * SMARTFS_DIRINDEX_EMPTY and the ones of removed entries the sector
+ * SMARTFS_DIRINDEX_REMOVED.
+ */
+
+struct smartfs_dirindex_slot_s {
+	uint16_t hash;				/* Hash of the entry name */
+	uint16_t sector;			/* Directory sector holding the entry */
+	uint16_t offset;			/* Offset of the entry in the sector */
+};
+
+/* The index of all entries of one directory, kept in RAM.  The indexes of
+ * a mountpoint are kept in a list, most recently used first.
+ */
+
+struct smartfs_dirindex_s {
+	struct smartfs_dirindex_s *next;	/* Next less recently used index */
+	uint16_t dirsector;			/* First sector of the directory */
+	uint16_t nentries;			/* Number of entries in the index */
+	uint16_t nused;				/* Number of slots not empty */
+	uint16_t nslots;			/* Number of slots, a power of 2 */
+	struct smartfs_dirindex_slot_s *slots;
+};
+#endif
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a smartfs filesystem.
@@ -383,6 +440,19 @@ struct smartfs_mountpt_s {
 	struct journal_transaction_manager_s *journal;
 #endif
 	uint8_t fs_rootsector;		/* Root directory sector num */
+#ifdef CONFIG_SMARTFS_DIRINDEX
+	struct smartfs_dirindex_s *fs_dirindex;	/* Directory indexes, MRU first */
+	uint8_t fs_ndirindex;		/* Number of directory indexes */
+#endif
+#ifdef CONFIG_SMARTFS_WRITEBACK
+	struct smartfs_ofile_s *fs_wbhead;	/* Files with buffered data, oldest first */
+	uint8_t fs_nwbfiles;		/* Number of files with buffered data */
+#ifdef SMARTFS_WRITEBACK_DELAYED
+	struct work_s fs_wbwork;	/* Flushes the buffered data after a delay */
+	volatile bool fs_wbqueued;	/* The worker is queued or running */
+	sem_t fs_wbsem;				/* Posted when the worker is done */
+#endif
+#endif
 };
 
 #ifdef CONFIG_SMARTFS_JOURNALING
@@ -545,6 +615,14 @@ struct fs_dirent_s;
 struct statfs;
 struct stat;
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+int smartfs_dirindex_lookup(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name, uint16_t probe, uint16_t *sector);
+void smartfs_dirindex_add(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name, uint16_t sector, uint16_t offset);
+void smartfs_dirindex_remove(struct smartfs_mountpt_s *fs, uint16_t sector, uint16_t offset);
+void smartfs_dirindex_drop(struct smartfs_mountpt_s *fs, uint16_t dirsector);
+void smartfs_dirindex_clear(struct smartfs_mountpt_s *fs);
+#endif
+
 #ifdef CONFIG_SMARTFS_JOURNALING
 int smartfs_journal_init(struct smartfs_mountpt_s *fs);
 int smartfs_create_journalentry(struct smartfs_mountpt_s *fs, enum logging_transaction_type_e type, uint16_t curr_sector, uint16_t offset, uint16_t datalen, uint16_t genericdata, uint8_t needsync, const uint8_t *data, uint16_t *t_sector, uint16_t *t_offset);
@@ -0,0 +1,429 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * fs/smartfs/smartfs_dirindex.c
+ *
+ * Hashed index of the entries of directories, kept in RAM.
+ *
+ * Finding an entry in a directory otherwise reads the sectors of the
+ * directory one after the other until the name is found, and all of them
+ * when it is not.  The index of a directory is built by reading all its
+ * sectors once, at the first lookup in it, and then tells in which sector
+ * an entry is, or that there is no entry of that name, without reading the
+ * device.  Entries created, deleted and renamed afterwards update it, so
+ * the index stays complete.  As it is only in RAM, nothing changes on the
+ * device and the journal replay at mount happens before any index exists.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/kmalloc.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
+
+#include "smartfs.h"
+
+#ifdef CONFIG_SMARTFS_DIRINDEX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Sectors 0 and 0xFFFF never hold directory entries */
+
+#define SMARTFS_DIRINDEX_EMPTY      0xFFFF
+#define SMARTFS_DIRINDEX_REMOVED    0x0000
+
+#define SMARTFS_DIRINDEX_MINSLOTS   16
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_dirindex_hash
+ *
+ * Description: FNV-1a hash of a name, as far as it is stored in an entry.
+ *
+ ****************************************************************************/
+
+static uint16_t smartfs_dirindex_hash(struct smartfs_mountpt_s *fs, const char *name)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < fs->fs_llformat.namesize && name[i] != '\0'; i++) {
+		hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+	}
+
+	return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_find
+ *
+ * Description: Find the index of a directory and make it the most recently
+ *              used one.
+ *
+ ****************************************************************************/
+
+static struct smartfs_dirindex_s *smartfs_dirindex_find(struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+	struct smartfs_dirindex_s *prev = NULL;
+	struct smartfs_dirindex_s *idx;
+
+	for (idx = fs->fs_dirindex; idx != NULL; prev = idx, idx = idx->next) {
+		if (idx->dirsector == dirsector) {
+			if (prev != NULL) {
+				prev->next = idx->next;
+				idx->next = fs->fs_dirindex;
+				fs->fs_dirindex = idx;
+			}
+
+			return idx;
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_free
+ ****************************************************************************/
+
+static void smartfs_dirindex_free(struct smartfs_mountpt_s *fs, struct smartfs_dirindex_s *idx)
+{
+	struct smartfs_dirindex_s **pprev;
+
+	for (pprev = &fs->fs_dirindex; *pprev != NULL; pprev = &(*pprev)->next) {
+		if (*pprev == idx) {
+			*pprev = idx->next;
+			fs->fs_ndirindex--;
+			break;
+		}
+	}
+
+	kmm_free(idx->slots);
+	kmm_free(idx);
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_resize
+ *
+ * Description: Rehash the index into a new array of slots, which also
+ *              drops the slots of removed entries.
+ *
+ ****************************************************************************/
+
+static int smartfs_dirindex_resize(struct smartfs_dirindex_s *idx, uint16_t nslots)
+{
+	struct smartfs_dirindex_slot_s *slots;
+	uint16_t i;
+	uint16_t j;
+
+	slots = (struct smartfs_dirindex_slot_s *)kmm_malloc(nslots * sizeof(struct smartfs_dirindex_slot_s));
+	if (slots == NULL) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nslots; i++) {
+		slots[i].sector = SMARTFS_DIRINDEX_EMPTY;
+	}
+
+	for (i = 0; i < idx->nslots; i++) {
+		if (idx->slots[i].sector == SMARTFS_DIRINDEX_EMPTY || idx->slots[i].sector == SMARTFS_DIRINDEX_REMOVED) {
+			continue;
+		}
+
+		j = idx->slots[i].hash & (nslots - 1);
+		while (slots[j].sector != SMARTFS_DIRINDEX_EMPTY) {
+			j = (j + 1) & (nslots - 1);
+		}
+
+		slots[j] = idx->slots[i];
+	}
+
+	kmm_free(idx->slots);
+	idx->slots = slots;
+	idx->nslots = nslots;
+	idx->nused = idx->nentries;
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_insert
+ *
+ * Description: Add an entry to an index, growing it to keep it at most
+ *              three quarters full.
+ *
+ ****************************************************************************/
+
+static int smartfs_dirindex_insert(struct smartfs_dirindex_s *idx, uint16_t hash, uint16_t sector, uint16_t offset)
+{
+	uint32_t nslots;
+	uint16_t i;
+	int ret;
+
+	if ((idx->nused + 1) * 4 > idx->nslots * 3) {
+		nslots = SMARTFS_DIRINDEX_MINSLOTS;
+		while (nslots < (idx->nentries + 1) * 2) {
+			nslots <<= 1;
+		}
+
+		if (nslots > 32768) {
+			return -ENOMEM;
+		}
+
+		ret = smartfs_dirindex_resize(idx, nslots);
+		if (ret != OK) {
+			return ret;
+		}
+	}
+
+	i = hash & (idx->nslots - 1);
+	while (idx->slots[i].sector != SMARTFS_DIRINDEX_EMPTY && idx->slots[i].sector != SMARTFS_DIRINDEX_REMOVED) {
+		i = (i + 1) & (idx->nslots - 1);
+	}
+
+	if (idx->slots[i].sector == SMARTFS_DIRINDEX_EMPTY) {
+		idx->nused++;
+	}
+
+	idx->slots[i].hash = hash;
+	idx->slots[i].sector = sector;
+	idx->slots[i].offset = offset;
+	idx->nentries++;
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_build
+ *
+ * Description: Read all sectors of a directory and index its entries.  The
+ *              least recently used index is dropped if there are already
+ *              CONFIG_SMARTFS_DIRINDEX_NDIRS of them.
+ *
+ ****************************************************************************/
+
+static int smartfs_dirindex_build(struct smartfs_mountpt_s *fs, uint16_t dirsector, struct smartfs_dirindex_s **result)
+{
+	struct smartfs_dirindex_s *idx;
+	struct smartfs_dirindex_s *lru;
+	struct smartfs_chain_header_s *header;
+	struct smartfs_entry_header_s *entry;
+	struct smart_read_write_s readwrite;
+	uint16_t entrysize;
+	uint16_t offset;
+	uint16_t sector;
+	int ret;
+
+	idx = (struct smartfs_dirindex_s *)kmm_zalloc(sizeof(struct smartfs_dirindex_s));
+	if (idx == NULL) {
+		return -ENOMEM;
+	}
+
+	idx->dirsector = dirsector;
+	entrysize = sizeof(struct smartfs_entry_header_s) + fs->fs_llformat.namesize;
+	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+
+	sector = dirsector;
+	while (sector != SMARTFS_ERASEDSTATE_16BIT) {
+		readwrite.logsector = sector;
+		readwrite.offset = 0;
+		readwrite.count = fs->fs_llformat.availbytes;
+		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			goto errout;
+		}
+
+		for (offset = sizeof(struct smartfs_chain_header_s); offset + entrysize <= readwrite.count; offset += entrysize) {
+			entry = (struct smartfs_entry_header_s *)&fs->fs_rwbuffer[offset];
+			if (ENTRY_VALID(entry)) {
+				ret = smartfs_dirindex_insert(idx, smartfs_dirindex_hash(fs, entry->name), sector, offset);
+				if (ret != OK) {
+					goto errout;
+				}
+			}
+		}
+
+		sector = SMARTFS_NEXTSECTOR(header);
+	}
+
+	/* Make room and add it as the most recently used index */
+
+	if (fs->fs_ndirindex >= CONFIG_SMARTFS_DIRINDEX_NDIRS) {
+		for (lru = fs->fs_dirindex; lru->next != NULL; lru = lru->next) ;
+		smartfs_dirindex_free(fs, lru);
+	}
+
+	idx->next = fs->fs_dirindex;
+	fs->fs_dirindex = idx;
+	fs->fs_ndirindex++;
+
+	fvdbg("Indexed %d entries of directory %d\n", idx->nentries, dirsector);
+	*result = idx;
+	return OK;
+
+errout:
+	kmm_free(idx->slots);
+	kmm_free(idx);
+	return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_dirindex_lookup
+ *
+ * Description: Find the directory sector which may hold the entry of the
+ *              name, building the index of the directory if needed.  The
+ *              caller must verify the name of the entry in that sector, as
+ *              different names may have the same hash.  If it isn't there,
+ *              the caller looks up the name again with probe incremented,
+ *              to get the sector of the next entry of the same hash.
+ *
+ * Returned Value:
+ *   OK with the sector, -ENOENT if the directory has no entry of the name
+ *   (or no more than probe entries of its hash), or another negated errno
+ *   if the directory couldn't be indexed.
+ *
+ ****************************************************************************/
+
+int smartfs_dirindex_lookup(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name, uint16_t probe, uint16_t *sector)
+{
+	struct smartfs_dirindex_s *idx;
+	uint16_t hash;
+	uint16_t i;
+	int ret;
+
+	idx = smartfs_dirindex_find(fs, dirsector);
+	if (idx == NULL) {
+		ret = smartfs_dirindex_build(fs, dirsector, &idx);
+		if (ret != OK) {
+			return ret;
+		}
+	}
+
+	if (idx->nslots == 0) {
+		return -ENOENT;
+	}
+
+	hash = smartfs_dirindex_hash(fs, name);
+	for (i = hash & (idx->nslots - 1); idx->slots[i].sector != SMARTFS_DIRINDEX_EMPTY; i = (i + 1) & (idx->nslots - 1)) {
+		if (idx->slots[i].sector != SMARTFS_DIRINDEX_REMOVED && idx->slots[i].hash == hash && probe-- == 0) {
+			*sector = idx->slots[i].sector;
+			return OK;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_add
+ *
+ * Description: Add an entry created in a directory to its index, if it has
+ *              one.  The index is dropped if it can't grow.
+ *
+ ****************************************************************************/
+
+void smartfs_dirindex_add(struct smartfs_mountpt_s *fs, uint16_t dirsector, const char *name, uint16_t sector, uint16_t offset)
+{
+	struct smartfs_dirindex_s *idx;
+
+	idx = smartfs_dirindex_find(fs, dirsector);
+	if (idx != NULL && smartfs_dirindex_insert(idx, smartfs_dirindex_hash(fs, name), sector, offset) != OK) {
+		smartfs_dirindex_free(fs, idx);
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_remove
+ *
+ * Description: Remove the entry at the sector and offset from the index
+ *              holding it, if any.
+ *
+ ****************************************************************************/
+
+void smartfs_dirindex_remove(struct smartfs_mountpt_s *fs, uint16_t sector, uint16_t offset)
+{
+	struct smartfs_dirindex_s *idx;
+	uint16_t i;
+
+	for (idx = fs->fs_dirindex; idx != NULL; idx = idx->next) {
+		for (i = 0; i < idx->nslots; i++) {
+			if (idx->slots[i].sector == sector && idx->slots[i].offset == offset) {
+				idx->slots[i].sector = SMARTFS_DIRINDEX_REMOVED;
+				idx->nentries--;
+				return;
+			}
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_drop
+ *
+ * Description: Drop the index of a directory.  This must be done when the
+ *              directory is deleted, as its sector may be reused.
+ *
+ ****************************************************************************/
+
+void smartfs_dirindex_drop(struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+	struct smartfs_dirindex_s *idx;
+
+	for (idx = fs->fs_dirindex; idx != NULL; idx = idx->next) {
+		if (idx->dirsector == dirsector) {
+			smartfs_dirindex_free(fs, idx);
+			return;
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: smartfs_dirindex_clear
+ *
+ * Description: Drop all indexes of the mountpoint.
+ *
+ ****************************************************************************/
+
+void smartfs_dirindex_clear(struct smartfs_mountpt_s *fs)
+{
+	while (fs->fs_dirindex != NULL) {
+		smartfs_dirindex_free(fs, fs->fs_dirindex);
+	}
+}
+
+#endif							/* CONFIG_SMARTFS_DIRINDEX */
@@ -75,6 +75,9 @@
 #include <tinyara/fs/ioctl.h>
 #include <tinyara/fs/mtd.h>
 #include <tinyara/fs/smart.h>
+#ifdef CONFIG_SCHED_LPWORK
+#include <tinyara/clock.h>
+#endif
 
 #include "smartfs.h"
 
@@ -117,6 +120,12 @@ static void smartfs_stat_common(FAR struct smartfs_mountpt_s *fs, FAR struct sma
 static int smartfs_stat(struct inode *mountpt, const char *relpath, struct stat *buf);
 
 static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, off_t offset, int whence);
+static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+#ifdef CONFIG_SMARTFS_WRITEBACK
+static void smartfs_writeback_discard(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+static int smartfs_writeback_flush(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, bool sync);
+static int smartfs_writeback_append(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, const uint8_t *data, uint16_t count);
+#endif
 
 /****************************************************************************
  * Private Variables
@@ -320,6 +329,9 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 	sf->curroffset = sizeof(struct smartfs_chain_header_s);
 	sf->currsector = sf->entry.firstsector;
 	sf->byteswritten = 0;
+#ifdef CONFIG_SMARTFS_WRITEBACK
+	sf->wbuffer = NULL;
+#endif
 
 	/* Test if we opened for APPEND mode.  If we did, then seek to the
 	 * end of the file.
@@ -383,6 +395,7 @@ static int smartfs_close(FAR struct file *filep)
 	struct smartfs_ofile_s *sf;
 	struct smartfs_ofile_s *nextfile;
 	struct smartfs_ofile_s *prevfile;
+	int ret;
 
 	/* Sanity checks */
 
@@ -394,14 +407,16 @@ static int smartfs_close(FAR struct file *filep)
 	fs = inode->i_private;
 	sf = filep->f_priv;
 
-	/* Sync the file */
-
-	smartfs_sync(filep);
-
 	/* Take the semaphore */
 
 	smartfs_semtake(fs);
 
+	/* Sync the file.  The block device state is left to fsync() and to
+	 * the unmount.
+	 */
+
+	ret = smartfs_sync_internal(fs, sf);
+
 	/* Check if we are the last one with a reference to the file and
 	 * only close if we are. */
 
@@ -452,13 +467,20 @@ static int smartfs_close(FAR struct file *filep)
 		kmm_free(sf->buffer);
 	}
 #endif
+#ifdef CONFIG_SMARTFS_WRITEBACK
+	/* The data which could not be written is lost, as the error tells */
+
+	if (sf->wbuffer != NULL) {
+		smartfs_writeback_discard(fs, sf);
+	}
+#endif
 
 	kmm_free(sf);
 	filep->f_priv = NULL;
 
 okout:
 	smartfs_semgive(fs);
-	return OK;
+	return ret;
 }
 
 /****************************************************************************
@@ -580,6 +602,215 @@ errout_with_semaphore:
 	return ret;
 }
 
+#ifdef CONFIG_SMARTFS_WRITEBACK
+/****************************************************************************
+ * Name: smartfs_writeback_discard
+ *
+ * Description: Release the buffer of the file and remove the file from the
+ *   list of files with buffered data.  The data not flushed is lost.
+ *
+ ****************************************************************************/
+
+static void smartfs_writeback_discard(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf)
+{
+	struct smartfs_ofile_s **prev;
+
+	for (prev = &fs->fs_wbhead; *prev != NULL; prev = &(*prev)->wbnext) {
+		if (*prev == sf) {
+			*prev = sf->wbnext;
+			fs->fs_nwbfiles--;
+			break;
+		}
+	}
+
+	kmm_free(sf->wbuffer);
+	sf->wbuffer = NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_writeback_flush
+ *
+ * Description: Write the data buffered for the file in a single sector
+ *   write and journal transaction, and release the buffer.  On error the
+ *   data stays buffered, to be written again by the next flush.  When
+ *   syncing, the used bytes of the sector are written along with the data.
+ *   Otherwise only the data is written, which can be programmed without
+ *   relocating the sector, and the used bytes are left to the next sync
+ *   like after a direct write.
+ *
+ ****************************************************************************/
+
+static int smartfs_writeback_flush(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, bool sync)
+{
+	struct smart_read_write_s readwrite;
+	struct smartfs_chain_header_s *header;
+	uint16_t used;
+	int ret = OK;
+#ifdef CONFIG_SMARTFS_JOURNALING
+	int retj;
+	uint16_t t_sector, t_offset;
+#endif
+
+	if (sf->wbuffer == NULL) {
+		return OK;
+	}
+
+	if (sf->wbstart < sf->curroffset) {
+		fvdbg("Flushing %d bytes of sector %d\n", sf->curroffset - sf->wbstart, sf->currsector);
+
+		/* The data of the sector ends with the data buffered */
+
+		used = sf->curroffset - sizeof(struct smartfs_chain_header_s);
+		readwrite.logsector = sf->currsector;
+		readwrite.offset = sf->wbstart;
+		if (sync) {
+			header = (struct smartfs_chain_header_s *)sf->wbuffer;
+			header->used[0] = (uint8_t)(used & 0x00FF);
+			header->used[1] = (uint8_t)(used >> 8);
+			readwrite.offset = offsetof(struct smartfs_chain_header_s, used);
+		}
+		readwrite.count = sf->curroffset - readwrite.offset;
+		readwrite.buffer = &sf->wbuffer[readwrite.offset];
+
+		/* The transaction is the one of an append of all the data, whose
+		 * replay also writes the used bytes.
+		 */
+
+#ifdef CONFIG_SMARTFS_JOURNALING
+		ret = smartfs_create_journalentry(fs, T_WRITE, sf->currsector, sf->wbstart, sf->curroffset - sf->wbstart, used, 1, &sf->wbuffer[sf->wbstart], &t_sector, &t_offset);
+		if (ret != OK) {
+			fdbg("Journal entry creation failed.\n");
+			return ret;
+		}
+#endif
+		ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+#ifdef CONFIG_SMARTFS_JOURNALING
+		if (sync) {
+			retj = smartfs_finish_journalentry(fs, sf->currsector, t_sector, t_offset, T_SYNC);
+			if (retj != OK) {
+				fdbg("Error finishing transaction\n");
+				return retj;
+			}
+		}
+#endif
+		if (ret < 0) {
+			fdbg("Error %d writing sector %d data\n", ret, sf->currsector);
+			return ret;
+		}
+
+		if (sync) {
+			sf->byteswritten = 0;
+		}
+	}
+
+	smartfs_writeback_discard(fs, sf);
+	return OK;
+}
+
+#ifdef SMARTFS_WRITEBACK_DELAYED
+/****************************************************************************
+ * Name: smartfs_writeback_worker
+ *
+ * Description: Flush the data buffered by all files, from the work queue.
+ *   The data of a file which can't be written stays buffered, and the error
+ *   is reported by the sync of that file at the latest.  The unmount waits
+ *   for fs_wbsem while the worker is queued or running.
+ *
+ ****************************************************************************/
+
+static void smartfs_writeback_worker(FAR void *arg)
+{
+	struct smartfs_mountpt_s *fs = (struct smartfs_mountpt_s *)arg;
+	struct smartfs_ofile_s *sf;
+	struct smartfs_ofile_s *next;
+	int ret;
+
+	smartfs_semtake(fs);
+	for (sf = fs->fs_wbhead; sf != NULL; sf = next) {
+		next = sf->wbnext;
+		ret = smartfs_writeback_flush(fs, sf, false);
+		if (ret < 0) {
+			fdbg("Error %d flushing sector %d, data kept\n", ret, sf->currsector);
+		}
+	}
+
+	fs->fs_wbqueued = false;
+	sem_post(&fs->fs_wbsem);
+	smartfs_semgive(fs);
+}
+#endif
+
+/****************************************************************************
+ * Name: smartfs_writeback_append
+ *
+ * Description: Buffer data appended to the file at the current offset of
+ *   the current sector.  The first data buffered for the sector takes a
+ *   buffer, flushing the data of the oldest file if all buffers are used.
+ *   If that data can't be written, it stays buffered for its own file and
+ *   the data of this file is written directly.
+ *
+ * Returned Value:
+ *   OK if the data was buffered, a negated errno if it must be written
+ *   directly.
+ *
+ ****************************************************************************/
+
+static int smartfs_writeback_append(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, const uint8_t *data, uint16_t count)
+{
+	struct smart_read_write_s readwrite;
+	struct smartfs_ofile_s **prev;
+	int ret;
+
+	if (sf->wbuffer == NULL) {
+		if (fs->fs_nwbfiles >= CONFIG_SMARTFS_WRITEBACK_NFILES) {
+			ret = smartfs_writeback_flush(fs, fs->fs_wbhead, false);
+			if (ret < 0) {
+				fdbg("Error %d flushing sector %d, data kept\n", ret, fs->fs_wbhead->currsector);
+				return ret;
+			}
+		}
+
+		sf->wbuffer = (uint8_t *)kmm_malloc(fs->fs_llformat.availbytes);
+		if (sf->wbuffer == NULL) {
+			return -ENOMEM;
+		}
+
+		/* Start from the header and data already in the sector */
+
+		readwrite.logsector = sf->currsector;
+		readwrite.offset = 0;
+		readwrite.count = sf->curroffset;
+		readwrite.buffer = sf->wbuffer;
+		ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			fdbg("Error %d reading sector %d data\n", ret, sf->currsector);
+			kmm_free(sf->wbuffer);
+			sf->wbuffer = NULL;
+			return ret;
+		}
+
+		memset(&sf->wbuffer[sf->curroffset], CONFIG_SMARTFS_ERASEDSTATE, fs->fs_llformat.availbytes - sf->curroffset);
+		sf->wbstart = sf->curroffset;
+
+		/* Append the file to the list of files with buffered data */
+
+		for (prev = &fs->fs_wbhead; *prev != NULL; prev = &(*prev)->wbnext) ;
+		sf->wbnext = NULL;
+		*prev = sf;
+		fs->fs_nwbfiles++;
+
+#ifdef SMARTFS_WRITEBACK_DELAYED
+		if (!fs->fs_wbqueued && work_queue(LPWORK, &fs->fs_wbwork, smartfs_writeback_worker, fs, MSEC2TICK(CONFIG_SMARTFS_WRITEBACK_DELAY)) == OK) {
+			fs->fs_wbqueued = true;
+		}
+#endif
+	}
+
+	memcpy(&sf->wbuffer[sf->curroffset], data, count);
+	return OK;
+}
+#endif							/* CONFIG_SMARTFS_WRITEBACK */
+
 /****************************************************************************
  * Name: smartfs_sync_internal
  *
@@ -641,6 +872,14 @@ static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_of
 		sf->bflags = 0;
 	}
 #else							/* CONFIG_SMARTFS_USE_SECTOR_BUFFER */
+#ifdef CONFIG_SMARTFS_WRITEBACK
+	/* Write the buffered data, which records the used bytes too */
+
+	ret = smartfs_writeback_flush(fs, sf, true);
+	if (ret < 0) {
+		goto errout;
+	}
+#endif
 
 	/* Test if we have written bytes to the current sector that
 	 * need to be recorded in the chain header's used bytes field. */
@@ -882,21 +1121,25 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 			readwrite.count = buflen;
 		}
 
-		/* Perform the write */
+		/* Perform the write, unless the data can be buffered */
 
+#ifdef CONFIG_SMARTFS_WRITEBACK
+		if (readwrite.count > 0 && smartfs_writeback_append(fs, sf, readwrite.buffer, readwrite.count) != OK) {
+#else
 		if (readwrite.count > 0) {
+#endif
 #ifdef CONFIG_SMARTFS_JOURNALING
 			ret = smartfs_create_journalentry(fs, T_WRITE, readwrite.logsector, readwrite.offset, readwrite.count, sf->curroffset + readwrite.count - sizeof(struct smartfs_chain_header_s), 1, readwrite.buffer, &t_sector, &t_offset);
 			if (ret != OK) {
 				fdbg("Journal entry creation failed.\n");
-				goto errout_with_semaphore;
+				goto errout_with_count;
 			}
 #endif
 
 			ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
 			if (ret < 0) {
 				fdbg("Error %d writing sector %d data\n", ret, sf->currsector);
-				goto errout_with_semaphore;
+				goto errout_with_count;
 			}
 		}
 #endif							/* CONFIG_SMARTFS_USE_SECTOR_BUFFER */
@@ -919,7 +1162,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 			ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
 			if (ret < 0) {
 				fdbg("Error %d allocating new sector\n", ret);
-				goto errout_with_semaphore;
+				goto errout_with_count;
 			}
 
 			/* Copy the new sector to the old one and chain it */
@@ -931,7 +1174,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 			ret = smartfs_sync_internal(fs, sf);
 			if (ret != OK) {
-				goto errout_with_semaphore;
+				goto errout_with_count;
 			}
 
 			/* Record the new sector in our tracking variables and
@@ -957,7 +1200,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 			ret = smartfs_sync_internal(fs, sf);
 			if (ret != OK) {
-				goto errout_with_semaphore;
+				goto errout_with_count;
 			}
 
 			/* Allocate a new sector if needed */
@@ -968,7 +1211,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 				ret = FS_IOCTL(fs, BIOC_ALLOCSECT, 0xFFFF);
 				if (ret < 0) {
 					fdbg("Error %d allocating new sector\n", ret);
-					goto errout_with_semaphore;
+					goto errout_with_count;
 				}
 
 				/* Copy the new sector to the old one and chain it */
@@ -985,7 +1228,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 												  readwrite.offset, readwrite.count, 0, 0, readwrite.buffer, &t_sector, &t_offset);
 				if (ret != OK) {
 					fdbg("Journal entry creation failed.\n");
-					goto errout_with_semaphore;
+					goto errout_with_count;
 				}
 #endif
 				ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
@@ -994,12 +1237,12 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 				if (retj != OK) {
 					fdbg("Error finishing transaction\n");
 					ret = retj;
-					goto errout_with_semaphore;
+					goto errout_with_count;
 				}
 #endif
 				if (ret < 0) {
 					fdbg("Error %d writing next sector\n", ret);
-					goto errout_with_semaphore;
+					goto errout_with_count;
 				}
 
 				/* Record the new sector in our tracking variables and
@@ -1021,6 +1264,15 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 
 	ret = byteswritten;
 
+errout_with_count:
+	/* Data taken before an error is reported as a short write.  It is
+	 * synced again by the next write or sync.
+	 */
+
+	if (byteswritten > 0) {
+		ret = byteswritten;
+	}
+
 errout_with_semaphore:
 	smartfs_semgive(fs);
 	return ret;
@@ -1055,9 +1307,14 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 	/* Test if we need to sync the file */
 
 	if (sf->byteswritten > 0) {
-		/* Perform a sync */
+		/* Perform a sync.  The position is kept if it fails, as data may
+		 * still be buffered for the current sector.
+		 */
 
-		smartfs_sync_internal(fs, sf);
+		ret = smartfs_sync_internal(fs, sf);
+		if (ret < 0) {
+			return ret;
+		}
 	}
 
 	/* Calculate the file position to seek to based on current position */
@@ -1252,6 +1509,15 @@ static int smartfs_sync(FAR struct file *filep)
 
 	ret = smartfs_sync_internal(fs, sf);
 
+	/* Let the block device persist its own state, like the sector map */
+
+	if (ret == OK) {
+		ret = FS_IOCTL(fs, BIOC_FLUSH, 0);
+		if (ret == -ENOSYS || ret == -ENOTTY) {
+			ret = OK;
+		}
+	}
+
 	smartfs_semgive(fs);
 	return ret;
 }
@@ -1566,6 +1832,9 @@ static int smartfs_bind(FAR struct inode *blkdriver, const void *data, void **ha
 
 	fs->fs_blkdriver = blkdriver;	/* Save the block driver reference */
 	fs->fs_head = NULL;
+#ifdef SMARTFS_WRITEBACK_DELAYED
+	sem_init(&fs->fs_wbsem, 0, 0);
+#endif
 
 	/* Now perform the mount.  */
 
@@ -1596,6 +1865,9 @@ static int smartfs_bind(FAR struct inode *blkdriver, const void *data, void **ha
 
 error_with_semaphore:
 	smartfs_semgive(fs);
+#ifdef SMARTFS_WRITEBACK_DELAYED
+	sem_destroy(&fs->fs_wbsem);
+#endif
 	kmm_free(fs);
 	return ret;
 }
@@ -1627,6 +1899,25 @@ static int smartfs_unbind(void *handle, FAR struct inode **blkdriver)
 		smartfs_semgive(fs);
 		return -EBUSY;
 	}
+#ifdef SMARTFS_WRITEBACK_DELAYED
+	/* All files were closed, so nothing is buffered anymore and no file
+	 * can be opened while the inode semaphore is held.  The worker takes
+	 * the semaphore, so it is cancelled, or waited for if it already runs,
+	 * without holding it.
+	 */
+
+	smartfs_semgive(fs);
+	if (work_cancel(LPWORK, &fs->fs_wbwork) == OK) {
+		fs->fs_wbqueued = false;
+	}
+
+	while (fs->fs_wbqueued) {
+		sem_wait(&fs->fs_wbsem);
+	}
+
+	smartfs_semtake(fs);
+	sem_destroy(&fs->fs_wbsem);
+#endif
 	/* Unmount ... close the block driver */
 	ret = smartfs_unmount(fs);
 #ifdef CONFIG_SMARTFS_JOURNALING
@@ -2129,6 +2420,13 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath, const char *ne
 		readwrite.count = sizeof(uint16_t);
 		readwrite.buffer = (uint8_t *)tmp_pntr;
 		ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+#ifdef CONFIG_SMARTFS_DIRINDEX
+		if (ret < 0) {
+			smartfs_dirindex_drop(fs, oldparentdirsector);
+		} else {
+			smartfs_dirindex_remove(fs, oldentry.dsector, oldentry.doffset);
+		}
+#endif
 #ifdef CONFIG_SMARTFS_JOURNALING
 		retj = smartfs_finish_journalentry(fs, 0, t_sector, t_offset, T_RENAME);
 		if (retj != OK) {
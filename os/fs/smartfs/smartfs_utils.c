@@ -66,6 +66,7 @@
 #include <errno.h>
 #include <debug.h>
 #include <queue.h>
+#include <crc8.h>
 
 #include <tinyara/kmalloc.h>
 #include <tinyara/fs/fs.h>
@@ -111,18 +112,11 @@ extern size_t smart_sect_header_size;
 #define CHUNK_SIZE                              (CONFIG_MTD_SMART_SECTOR_SIZE / (USED_ARRAY_SIZE * (1 << 3)))
 #endif
 
-#ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
-#define ENTRY_VALID(e) ((smartfs_rdle16(&(e)->flags) & SMARTFS_DIRENT_EMPTY) != \
-						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_EMPTY)) && \
-						((smartfs_rdle16(&(e)->flags) & SMARTFS_DIRENT_ACTIVE) == \
-						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_ACTIVE))
-
-#else
-#define ENTRY_VALID(e) (((e)->flags & SMARTFS_DIRENT_EMPTY) != \
-						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_EMPTY)) && \
-						(((e)->flags & SMARTFS_DIRENT_ACTIVE) == \
-						(SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_ACTIVE))
+#ifdef CONFIG_SMARTFS_DIRINDEX
+/* How smartfs_finddirentry() searches a directory */
 
+#define SMARTFS_DIRINDEX_NONE     0	/* All sectors, there is no index */
+#define SMARTFS_DIRINDEX_HINT     1	/* Only the sectors given by the index */
 #endif
 
 #ifdef CONFIG_SMARTFS_SECTOR_RECOVERY
@@ -647,6 +641,10 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 	int found = FALSE;
 #endif
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+	smartfs_dirindex_clear(fs);
+#endif
+
 #if defined(CONFIG_SMARTFS_MULTI_ROOT_DIRS) || \
 	(defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS))
 	/* Start at the head of the mounts and search for our entry.  Also
@@ -783,6 +781,10 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
 	int used_value;
 #endif
+#ifdef CONFIG_SMARTFS_DIRINDEX
+	uint8_t indexed;
+	uint16_t probe;
+#endif
 
 	/* Initialize directory level zero as the root sector */
 
@@ -859,6 +861,23 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 
 			offset = 0xFFFF;
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+			/* The index tells the sectors holding entries of the same hash
+			 * as the name, or that there is no such entry.  Without an
+			 * index, all sectors are searched.
+			 */
+
+			indexed = SMARTFS_DIRINDEX_NONE;
+			probe = 0;
+			ret = smartfs_dirindex_lookup(fs, dirstack[depth], fs->fs_workbuffer, probe, &dirsector);
+			if (ret == OK) {
+				indexed = SMARTFS_DIRINDEX_HINT;
+			} else if (ret == -ENOENT) {
+				dirsector = SMARTFS_ERASEDSTATE_16BIT;
+				readwrite.count = 0;
+			}
+#endif
+
 #if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
 			while (dirsector != 0xFFFF)
 #else
@@ -1036,6 +1055,19 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *d
 				if (offset < readwrite.count) {
 					break;
 				}
+#ifdef CONFIG_SMARTFS_DIRINDEX
+
+				/* The sector only had another name of the same hash.  Read
+				 * the sector of the next entry of that hash, if any.
+				 */
+
+				if (indexed == SMARTFS_DIRINDEX_HINT) {
+					ret = smartfs_dirindex_lookup(fs, dirstack[depth], fs->fs_workbuffer, ++probe, &dirsector);
+					if (ret != OK) {
+						dirsector = SMARTFS_ERASEDSTATE_16BIT;
+					}
+				}
+#endif
 			}
 
 			/* If we found a dir entry, then continue searching */
@@ -1280,9 +1312,16 @@ int smartfs_createentry(struct smartfs_mountpt_s *fs, uint16_t parentdirsector,
 	ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
 	if (ret < 0) {
 		fdbg("failed to write new entry to parent directory psector : %d\n", psector);
+#ifdef CONFIG_SMARTFS_DIRINDEX
+		smartfs_dirindex_drop(fs, parentdirsector);
+#endif
 		goto errout;
 	}
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+	smartfs_dirindex_add(fs, parentdirsector, filename, psector, offset);
+#endif
+
 	/* Now fill in the entry */
 
 	direntry->firstsector = nextsector;
@@ -1415,6 +1454,13 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs, struct smartfs_entry_s *en
 		goto errout;
 	}
 
+#ifdef CONFIG_SMARTFS_DIRINDEX
+	/* The sector of a deleted directory may be reused by any new entry */
+
+	smartfs_dirindex_remove(fs, entry->dsector, entry->doffset);
+	smartfs_dirindex_drop(fs, entry->firstsector);
+#endif
+
 	/* Test if any entries in this sector are being used */
 
 	if ((entry->dsector != fs->fs_rootsector) && (entry->dsector != entry->dfirst)) {
@@ -2599,6 +2645,11 @@ static int smartfs_redo_rename(struct smartfs_mountpt_s *fs)
 		if (ret != OK) {
 			fdbg("Inactive old entry failed... offset : %d\n", req.offset);
 		}
+#ifdef CONFIG_SMARTFS_DIRINDEX
+		else {
+			smartfs_dirindex_remove(fs, req.logsector, oldoffset);
+		}
+#endif
 	} else {
 		ret = OK;
 	}
@@ -80,6 +80,43 @@ int compress_init(int filfd, uint16_t offset, off_t *filelen);
  ****************************************************************************/
 int compress_read(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset);
 
+/****************************************************************************
+ * Name: compress_read_buffers
+ *
+ * Description:
+ *   Same as compress_read(), with the read and decompression buffers of the
+ *   caller, so that another thread can decompress blocks at the same time.
+ *
+ * Returned Value:
+ *   Number of bytes read into buffer on Success
+ *   Negative value on failure
+ ****************************************************************************/
+int compress_read_buffers(int filfd, uint16_t binary_header_size, FAR uint8_t *buffer, size_t readsize, off_t offset, FAR struct s_buffer *bufs);
+
+/****************************************************************************
+ * Name: compress_init_buffers
+ *
+ * Description:
+ *   Allocate the read and decompression buffers for the blocks of the file
+ *   initialized by compress_init
+ *
+ * Returned value:
+ *   OK (0) on Success
+ *   -ENOMEM on Failure
+ ****************************************************************************/
+int compress_init_buffers(FAR struct s_buffer *bufs);
+
+/****************************************************************************
+ * Name: compress_uninit_buffers
+ *
+ * Description:
+ *   Release buffers allocated by compress_init_buffers
+ *
+ * Returned Value:
+ *   None
+ ****************************************************************************/
+void compress_uninit_buffers(FAR struct s_buffer *bufs);
+
 /****************************************************************************
  * Name: get_compression_header
  *
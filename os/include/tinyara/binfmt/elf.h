@@ -172,8 +172,10 @@ struct elf_loadinfo_s {
 	int filfd;					/* Descriptor for the file being loaded */
 	uint16_t offset;             /* elf offset when binary header is included */
 	uint8_t compression_type;		/* Binary Compression type */
+#ifdef CONFIG_ELF_XIP
+	uintptr_t xipbase;			/* Address of the mapped ELF file, 0 if not mapped */
+#endif
 	uintptr_t symtab;			/* Copy of symbol table */
-	uintptr_t reltab;			/* Copy of relocation table */
 };
 
 /****************************************************************************
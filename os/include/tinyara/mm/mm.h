@@ -191,6 +191,26 @@
 #define MM_MAX_CHUNK     (1 << MM_MAX_SHIFT)
 #define MM_NNODES        (MM_MAX_SHIFT - MM_MIN_SHIFT + 1)
 
+#ifdef CONFIG_MM_TLSF
+/* With the TLSF backend, free chunks are kept in segregated lists indexed
+ * by two levels.  The first level splits sizes by powers of two and the
+ * second level splits each power of two range into MM_TLSF_SLI equal
+ * ranges.  Chunks smaller than MM_TLSF_SMALL are all in the first level 0,
+ * one list per MM_MIN_CHUNK.  A bitmap per level makes finding a list of
+ * large enough chunks O(1).
+ */
+
+#define MM_TLSF_SLI_SHIFT 4
+#define MM_TLSF_SLI       (1 << MM_TLSF_SLI_SHIFT)
+#define MM_TLSF_FLI_SHIFT (MM_TLSF_SLI_SHIFT + MM_MIN_SHIFT)
+#define MM_TLSF_SMALL     (1 << MM_TLSF_FLI_SHIFT)
+#ifdef CONFIG_MM_SMALL
+#define MM_TLSF_FLI       (16 - MM_TLSF_FLI_SHIFT + 1)
+#else
+#define MM_TLSF_FLI       (32 - MM_TLSF_FLI_SHIFT + 1)
+#endif
+#endif
+
 #define MM_GRAN_MASK     (MM_MIN_CHUNK-1)
 #define MM_ALIGN_UP(a)   (((a) + MM_GRAN_MASK) & ~MM_GRAN_MASK)
 #define MM_ALIGN_DOWN(a) ((a) & ~MM_GRAN_MASK)
@@ -340,6 +360,56 @@ struct mm_freenode_s {
 #define CHECK_FREENODE_SIZE \
 	DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+#ifdef CONFIG_MM_SLAB
+/* Allocations up to MM_SLAB_MAXSIZE bytes are carved out of slab pages,
+ * which are ordinary allocated chunks holding chunks of one size class.
+ * Each task caches a few free chunks per class in its own magazine, so
+ * most small allocations and frees don't take the heap semaphore.
+ *
+ * A slab chunk has an allocnode header like any other chunk, but its size
+ * has MM_SLAB_BIT set (sizes of other chunks are multiples of MM_MIN_CHUNK)
+ * and its 'preceding' is the offset from the node of its slab page.
+ */
+
+#define MM_SLAB_BIT       1
+#define MM_SLAB_MAXSIZE   256
+#define MM_SLAB_NCLASSES  8
+#define MM_IS_SLAB(n)     ((((struct mm_allocnode_s *)(n))->size & MM_SLAB_BIT) != 0)
+
+struct mm_slab_page_s;
+
+/* Pages and free chunks of one size class, protected by the heap semaphore */
+
+struct mm_slab_class_s {
+	FAR struct mm_slab_page_s *partial;	/* Pages with free chunks */
+	uint16_t npages;			/* Number of pages of this class */
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	uint32_t nrefill;			/* Magazine misses */
+	uint32_t nflush;			/* Magazine overflows */
+#endif
+};
+
+/* Free chunks of one size class cached by a task */
+
+struct mm_slab_magazine_s {
+	FAR struct mm_allocnode_s *head;	/* Singly linked through the chunk data */
+	uint16_t count;
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	uint32_t nalloc;			/* Allocations served by the magazine */
+#endif
+};
+
+/* Magazines of a task, only touched by the owner.  A task takes over the
+ * cache of its PIDHASH with the heap semaphore held, and caches of exited
+ * tasks are flushed when the heap runs short.
+ */
+
+struct mm_slab_cache_s {
+	pid_t owner;
+	struct mm_slab_magazine_s mag[MM_SLAB_NCLASSES];
+};
+#endif
+
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 struct heapinfo_tcb_info_s {
 	int pid;
@@ -396,12 +466,29 @@ struct mm_heap_s {
 	int mm_nregions;
 #endif
 
+#ifdef CONFIG_MM_TLSF
+	/* Free nodes are kept in doubly linked lists per size range.  A bit
+	 * is set in the bitmaps for each non-empty list.
+	 */
+
+	uint32_t mm_fl_bitmap;
+	uint32_t mm_sl_bitmap[MM_TLSF_FLI];
+	FAR struct mm_freenode_s *mm_freelist[MM_TLSF_FLI][MM_TLSF_SLI];
+#else
 	/* All free nodes are maintained in a doubly linked list.  This
 	 * array provides some hooks into the list at various points to
 	 * speed searches for free nodes.
 	 */
 
 	struct mm_freenode_s mm_nodelist[MM_NNODES + 1];
+#endif
+
+#ifdef CONFIG_MM_SLAB
+	/* Size classes of small allocations and task caches indexed by PIDHASH */
+
+	struct mm_slab_class_s mm_slab[MM_SLAB_NCLASSES];
+	struct mm_slab_cache_s mm_slab_cache[CONFIG_MAX_TASKS];
+#endif
 };
 
 /****************************************************************************
@@ -674,13 +761,35 @@ struct mm_heap_s *kmm_get_heap(void);
 
 void mm_shrinkchunk(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node, size_t size);
 
-/* Functions contained in mm_addfreechunk.c *********************************/
+/* Functions contained in mm_addfreechunk.c or mm_tlsf.c ********************/
 
 void mm_addfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
 
+#ifdef CONFIG_MM_TLSF
+/* Functions contained in mm_tlsf.c *****************************************/
+
+void mm_tlsf_initialize(FAR struct mm_heap_s *heap);
+void mm_tlsf_removechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
+FAR struct mm_freenode_s *mm_tlsf_findchunk(FAR struct mm_heap_s *heap, size_t size);
+#else
 /* Functions contained in mm_size2ndx.c.c ***********************************/
 
 int mm_size2ndx(size_t size);
+#endif
+
+#ifdef CONFIG_MM_SLAB
+/* Functions contained in mm_slab.c *****************************************/
+
+void mm_slab_initialize(FAR struct mm_heap_s *heap);
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+FAR void *mm_slab_malloc(FAR struct mm_heap_s *heap, size_t size, mmaddress_t caller_retaddr);
+void mm_slab_heapinfo(FAR struct mm_heap_s *heap);
+#else
+FAR void *mm_slab_malloc(FAR struct mm_heap_s *heap, size_t size);
+#endif
+void mm_slab_free(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node);
+int mm_slab_reclaim(FAR struct mm_heap_s *heap);
+#endif
 
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 /* Functions contained in kmm_mallinfo.c . Used to display memory allocation details */
@@ -129,6 +129,23 @@ FAR const struct symtab_s *symtab_findbyname(FAR const struct symtab_s *symtab,
 
 FAR const struct symtab_s *symtab_findorderedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms);
 
+/****************************************************************************
+ * Name: symtab_findhashedbyname
+ *
+ * Description:
+ *   Find the symbol in the symbol table with the matching name.
+ *   This version assumes that the table was generated with a perfect hash
+ *   of the symbol names by "mksymtab -p" and, hence, access time is
+ *   constant.  Other tables are searched like with symtab_findbyname().
+ *
+ * Returned Value:
+ *   A reference to the symbol table entry if an entry with the matching
+ *   name is found; NULL is returned if the entry is not found.
+ *
+ ****************************************************************************/
+
+FAR const struct symtab_s *symtab_findhashedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms);
+
 /****************************************************************************
  * Name: symtab_findbyvalue
  *
@@ -75,6 +75,37 @@
 #define TTRACE_TAG_LOCK            (1 << 2)
 #define TTRACE_TAG_TASK            (1 << 3)
 #define TTRACE_TAG_IPC             (1 << 4)
+#define TTRACE_TAG_IRQ             (1 << 5)
+
+#ifdef CONFIG_TTRACE_BINARY
+/* Binary records of CONFIG_TTRACE_BINARY: a header and its payload, in
+ * slots of TTRACE_BIN_SLOT bytes. Names are truncated to TTRACE_MSG_BYTES.
+ */
+#define TTRACE_BIN_MAGIC           0x42525454	/* "TTRB" */
+#define TTRACE_BIN_SLOT            8
+#define TTRACE_BIN_HDRSLOTS        2
+#define TTRACE_BIN_MAXSLOTS        (TTRACE_BIN_HDRSLOTS + TTRACE_MSG_BYTES / TTRACE_BIN_SLOT)
+#define TTRACE_BIN_NAMESLOTS(len)  (((len) + TTRACE_BIN_SLOT) / TTRACE_BIN_SLOT)
+
+/* One ring per CPU, the buffer is shared between them */
+#define TTRACE_BIN_NCPUS           1
+#define TTRACE_BIN_RINGSLOTS       (CONFIG_TTRACE_BUFSIZE / TTRACE_BIN_SLOT / TTRACE_BIN_NCPUS)
+
+#define TTRACE_BIN_PAD             0	/* fills the end of the ring */
+#define TTRACE_BIN_BEGIN           1	/* arg: tag, payload: name */
+#define TTRACE_BIN_BEGIN_UID       2	/* arg: unique id */
+#define TTRACE_BIN_END             3	/* arg: tag */
+#define TTRACE_BIN_SCHED           4	/* arg: prev pid << 16 | next pid, payload: struct ttrace_binsched_s */
+#define TTRACE_BIN_COUNTER         5	/* arg: value, payload: name */
+#define TTRACE_BIN_ASYNC_BEGIN     6	/* arg: id, payload: name */
+#define TTRACE_BIN_ASYNC_END       7	/* arg: id, payload: name */
+#define TTRACE_BIN_IRQ_ENTER       8	/* arg: irq */
+#define TTRACE_BIN_IRQ_EXIT        9	/* arg: irq */
+#define TTRACE_BIN_TASKNAME        10	/* pid: task, payload: name */
+#define TTRACE_BIN_NTYPES          11
+#endif
+
+struct tcb_s;
 
 /****************************************************************************
  * Public Variables
@@ -103,6 +134,41 @@ struct trace_packet {        // total 44 byte(message), 12byte(uid)
 	union trace_message msg;   // 32B
 };
 
+#ifdef CONFIG_TTRACE_BINARY
+struct ttrace_binrec_s {     // total 16B, followed by the payload
+	uint32_t pos;              // 4B, slot of the record since the start, written last
+	uint8_t type;              // 1B, TTRACE_BIN_xxx
+	uint8_t nslots;            // 1B, size with the payload in slots
+	int16_t pid;               // 2B
+	uint32_t ts;               // 4B, microseconds
+	uint32_t arg;              // 4B
+};
+
+struct ttrace_binsched_s {   // total 8B
+	uint8_t prev_prio;         // 1B
+	uint8_t prev_state;        // 1B
+	uint8_t next_prio;         // 1B
+	uint8_t pad[5];            // 5B
+};
+
+struct ttrace_binmsg_s {     // a record and its name, up to 48B
+	struct ttrace_binrec_s rec;
+	char name[TTRACE_MSG_BYTES];
+};
+
+/* The ring is read as it is in memory, through the T-trace device or GDB */
+struct ttrace_binring_s {    // total 24B, followed by the slots
+	uint32_t magic;            // 4B, TTRACE_BIN_MAGIC
+	uint16_t cpu;              // 2B
+	uint16_t overwrite;        // 2B, the oldest records are overwritten when full
+	uint32_t nslots;           // 4B, TTRACE_BIN_RINGSLOTS
+	uint32_t pos;              // 4B, next slot to reserve since the start
+	uint32_t dropped;          // 4B, records dropped when full
+	uint32_t tags;             // 4B, selected tags, none when finished
+	uint64_t slots[TTRACE_BIN_RINGSLOTS];
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -162,18 +228,93 @@ int trace_end_uid(int tag);
  * @since TizenRT v1.1
  */
 int trace_sched(struct tcb_s *prev, struct tcb_s *next);
+
+#ifdef CONFIG_TTRACE_BINARY
+/**
+ * @ingroup TTRACE_LIBC
+ * @brief writes a trace log with the value of a counter
+ * @details @b #include <tinyara/ttrace.h>
+ * @param[in] tag number for tag
+ * @param[in] name name of the counter
+ * @param[in] value value of the counter
+ * @return On success, TTRACE_VALID is returned. On failure, TTRACE_INVALID is returned.
+ * @since TizenRT v3.0
+ */
+int trace_counter(int tag, const char *name, int32_t value);
+
+/**
+ * @ingroup TTRACE_LIBC
+ * @brief writes a trace log to indicate that an asynchronous event has begun
+ * @details @b #include <tinyara/ttrace.h>
+ *   The event may end in another task, with the same name and id.
+ * @param[in] tag number for tag
+ * @param[in] name name of the event
+ * @param[in] id id for distinguishing events of the same name
+ * @return On success, TTRACE_VALID is returned. On failure, TTRACE_INVALID is returned.
+ * @since TizenRT v3.0
+ */
+int trace_async_begin(int tag, const char *name, uint32_t id);
+
+/**
+ * @ingroup TTRACE_LIBC
+ * @brief writes a trace log to indicate that an asynchronous event has ended
+ * @details @b #include <tinyara/ttrace.h>
+ * @param[in] tag number for tag
+ * @param[in] name name of the event
+ * @param[in] id id given to trace_async_begin()
+ * @return On success, TTRACE_VALID is returned. On failure, TTRACE_INVALID is returned.
+ * @since TizenRT v3.0
+ */
+int trace_async_end(int tag, const char *name, uint32_t id);
+
+#ifdef CONFIG_TTRACE_BINARY_IRQ
+/**
+ * @cond
+ * @internal
+ */
+int trace_irq_enter(int irq);
+int trace_irq_exit(int irq);
+/**
+ * @endcond
+ */
+#endif
+
+/**
+ * @cond
+ * @internal
+ */
+/* The rings of the kernel, and the writer of their records */
+extern struct ttrace_binring_s g_ttrace_binring[TTRACE_BIN_NCPUS];
+
+int ttrace_bin_write(int tag, FAR const struct ttrace_binrec_s *rec);
+/**
+ * @endcond
+ */
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
 #else
 #define trace_begin(a, b, ...)
 #define trace_begin_uid(a, b)
 #define trace_end(a)
 #define trace_end_uid(a)
 #define trace_sched(a, b)
+#endif /* CONFIG_TTRACE */
 
-#if defined(__cplusplus)
-}
+#ifndef CONFIG_TTRACE_BINARY
+#define trace_counter(a, b, c)
+#define trace_async_begin(a, b, c)
+#define trace_async_end(a, b, c)
+#endif
+
+#ifndef CONFIG_TTRACE_BINARY_IRQ
+#define trace_irq_enter(a)
+#define trace_irq_exit(a)
 #endif
 
-#endif /* CONFIG_TTRACE */
 #endif /* __INCLUDE_TINYARA_TTRACE_INTERNAL_H */
 /**
  * @}
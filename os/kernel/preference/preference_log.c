@@ -0,0 +1,889 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * Log-structured key storage
+ *
+ * All keys are stored as records appended to a single log file instead of
+ * one file per key.  A record is a header, the key path relative to
+ * PREF_PATH and the value.  Writing a key appends a PUT record, removing
+ * it a DEL record and removing a directory one DELDIR record for all of its
+ * keys, so the filesystem only ever grows one file.
+ *
+ * A hash index in RAM maps each live key to the offset of its last record.
+ * It is rebuilt by scanning the log on first use.  The scan stops at the
+ * first record with a bad checksum, which is where a power loss tore the
+ * last write, and the log is then compacted so that nothing is appended
+ * after broken data.
+ *
+ * Records are collected in a RAM buffer and written with one write and
+ * fsync, either at once or after CONFIG_PREFERENCE_LOG_COMMIT_DELAY from
+ * the work queue, which commits the writes of that period together.
+ *
+ * When more than half of the log is taken by overwritten or removed keys,
+ * the live records are copied to a new log which replaces the old one.
+ * The new log is complete and synced before the old one is unlinked, and
+ * a new log left without old log by a power loss is renamed on recovery.
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+#include <tinyara/config.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <debug.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <semaphore.h>
+#include <crc32.h>
+#include <sys/stat.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/kmalloc.h>
+#include <tinyara/preference.h>
+#ifdef CONFIG_SCHED_WORKQUEUE
+#include <tinyara/wqueue.h>
+#endif
+
+#include "preference.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+#define PREF_LOG_PATH          PREF_PATH"/pref.log"
+#define PREF_LOG_TMPPATH       PREF_PATH"/pref.log.tmp"
+
+#define PREF_LOG_MAGIC         0x50
+#define PREF_LOG_OP_PUT        1
+#define PREF_LOG_OP_DEL        2
+#define PREF_LOG_OP_DELDIR     3
+#define PREF_LOG_KEYMAX        256
+
+#define PREF_LOG_NBUCKETS      CONFIG_PREFERENCE_LOG_NBUCKETS
+#define PREF_LOG_BUFSIZE       CONFIG_PREFERENCE_LOG_BUFSIZE
+#define PREF_LOG_COMPACT_SIZE  CONFIG_PREFERENCE_LOG_COMPACT_SIZE
+
+#ifndef CONFIG_PREFERENCE_LOG_COMMIT_DELAY
+#define CONFIG_PREFERENCE_LOG_COMMIT_DELAY 0
+#endif
+
+#ifdef CONFIG_SCHED_WORKQUEUE
+#ifdef CONFIG_SCHED_LPWORK
+#define PREF_LOG_WORK          LPWORK
+#else
+#define PREF_LOG_WORK          HPWORK
+#endif
+#endif
+
+#define PREF_LOG_RECLEN(keylen, len) (sizeof(struct pref_log_rec_s) + (keylen) + (len))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+/* Header of a record, followed by the key without NUL and the value */
+struct pref_log_rec_s {
+	uint32_t crc;				/* CRC32 of the rest of the record */
+	uint8_t magic;
+	uint8_t op;
+	uint16_t keylen;
+	value_attr_t attr;			/* Same attributes as a key file */
+};
+
+struct pref_log_entry_s {
+	struct pref_log_entry_s *flink;
+	uint32_t hash;
+	uint32_t offset;			/* Offset of the last PUT record of the key */
+	uint32_t reclen;
+	uint16_t keylen;
+	char key[1];
+};
+
+struct pref_log_s {
+	sem_t sem;
+	bool initialized;
+	struct file filep;
+	uint32_t flushed;			/* Size of the log in the file */
+	uint32_t buflen;			/* Size of the records not written yet */
+	uint32_t live;				/* Size of the records of the live keys */
+	uint8_t *buf;
+	struct pref_log_entry_s *bucket[PREF_LOG_NBUCKETS];
+#ifdef PREF_LOG_WORK
+	struct work_s work;
+#endif
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+static struct pref_log_s g_pref_log = {
+	.sem = SEM_INITIALIZER(1),
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+static uint32_t pref_log_hash(const char *key, int keylen)
+{
+	uint32_t hash = 2166136261u;
+
+	while (keylen-- > 0) {
+		hash = (hash ^ (uint8_t)*key++) * 16777619u;
+	}
+
+	return hash;
+}
+
+static const char *pref_log_key(const char *path)
+{
+	if (strncmp(path, PREF_PATH"/", sizeof(PREF_PATH)) != 0) {
+		return NULL;
+	}
+
+	return path + sizeof(PREF_PATH);
+}
+
+static struct pref_log_entry_s *pref_log_find(const char *key, int keylen, struct pref_log_entry_s ***link)
+{
+	struct pref_log_entry_s **prev;
+	struct pref_log_entry_s *entry;
+	uint32_t hash;
+
+	hash = pref_log_hash(key, keylen);
+	prev = &g_pref_log.bucket[hash % PREF_LOG_NBUCKETS];
+	for (entry = *prev; entry; prev = &entry->flink, entry = entry->flink) {
+		if (entry->hash == hash && entry->keylen == keylen && !memcmp(entry->key, key, keylen)) {
+			break;
+		}
+	}
+
+	if (link) {
+		*link = prev;
+	}
+
+	return entry;
+}
+
+static bool pref_log_below(const struct pref_log_entry_s *entry, const char *dir, int dirlen)
+{
+	return entry->keylen > dirlen && entry->key[dirlen] == '/' && !memcmp(entry->key, dir, dirlen);
+}
+
+static void pref_log_clear(void)
+{
+	struct pref_log_entry_s *entry;
+	int ndx;
+
+	for (ndx = 0; ndx < PREF_LOG_NBUCKETS; ndx++) {
+		while ((entry = g_pref_log.bucket[ndx]) != NULL) {
+			g_pref_log.bucket[ndx] = entry->flink;
+			kmm_free(entry);
+		}
+	}
+	g_pref_log.live = 0;
+}
+
+/* Drop the state in RAM, the next access recovers it from the log */
+
+static void pref_log_reset(void)
+{
+	file_close(&g_pref_log.filep);
+	pref_log_clear();
+	g_pref_log.buflen = 0;
+	g_pref_log.initialized = false;
+}
+
+/* Index the record at offset, which replaces or removes the key, or removes
+ * the keys below the directory.  A new key takes the spare entry if one is
+ * given.
+ */
+
+static int pref_log_index(const struct pref_log_rec_s *rec, const char *key, uint32_t offset, struct pref_log_entry_s **spare)
+{
+	struct pref_log_entry_s **link;
+	struct pref_log_entry_s *entry;
+	int ndx;
+
+	if (rec->op == PREF_LOG_OP_DELDIR) {
+		for (ndx = 0; ndx < PREF_LOG_NBUCKETS; ndx++) {
+			link = &g_pref_log.bucket[ndx];
+			while ((entry = *link) != NULL) {
+				if (pref_log_below(entry, key, rec->keylen)) {
+					g_pref_log.live -= entry->reclen;
+					*link = entry->flink;
+					kmm_free(entry);
+				} else {
+					link = &entry->flink;
+				}
+			}
+		}
+		return OK;
+	}
+
+	entry = pref_log_find(key, rec->keylen, &link);
+	if (entry) {
+		g_pref_log.live -= entry->reclen;
+		if (rec->op == PREF_LOG_OP_DEL) {
+			*link = entry->flink;
+			kmm_free(entry);
+			return OK;
+		}
+	} else {
+		if (rec->op == PREF_LOG_OP_DEL) {
+			return OK;
+		}
+
+		if (spare && *spare) {
+			entry = *spare;
+			*spare = NULL;
+		} else {
+			entry = (struct pref_log_entry_s *)kmm_malloc(sizeof(struct pref_log_entry_s) + rec->keylen);
+			if (entry == NULL) {
+				return PREFERENCE_OUT_OF_MEMORY;
+			}
+		}
+		entry->hash = pref_log_hash(key, rec->keylen);
+		entry->keylen = rec->keylen;
+		memcpy(entry->key, key, rec->keylen);
+		entry->key[rec->keylen] = '\0';
+		entry->flink = *link;
+		*link = entry;
+	}
+
+	entry->offset = offset;
+	entry->reclen = PREF_LOG_RECLEN(rec->keylen, rec->attr.len);
+	g_pref_log.live += entry->reclen;
+
+	return OK;
+}
+
+static int pref_log_read(uint32_t offset, void *buf, size_t len)
+{
+	ssize_t nread;
+
+	/* Records are written whole, so a record is either in the buffer or in the file */
+
+	if (offset >= g_pref_log.flushed) {
+		memcpy(buf, g_pref_log.buf + (offset - g_pref_log.flushed), len);
+		return OK;
+	}
+
+	nread = file_pread(&g_pref_log.filep, buf, len, offset);
+	if (nread != len) {
+		prefdbg("Failed to read log at %u, %d\n", offset, (int)nread);
+		return PREFERENCE_IO_ERROR;
+	}
+
+	return OK;
+}
+
+static int pref_log_write(const void *buf, size_t len)
+{
+	ssize_t nwritten;
+
+	nwritten = file_pwrite(&g_pref_log.filep, buf, len, g_pref_log.flushed);
+	if (nwritten != len) {
+		prefdbg("Failed to write log at %u, %d\n", g_pref_log.flushed, (int)nwritten);
+		return PREFERENCE_IO_ERROR;
+	}
+	g_pref_log.flushed += len;
+
+	return OK;
+}
+
+static int pref_log_commit(void)
+{
+	int ret;
+
+	if (g_pref_log.buflen == 0) {
+		return OK;
+	}
+
+	ret = pref_log_write(g_pref_log.buf, g_pref_log.buflen);
+	if (ret == OK && file_fsync(&g_pref_log.filep) < 0) {
+		ret = PREFERENCE_IO_ERROR;
+	}
+	if (ret != OK) {
+		/* The records not committed are lost, as after a power loss */
+		pref_log_reset();
+		return ret;
+	}
+
+	prefvdbg("Committed %u bytes, log size %u\n", g_pref_log.buflen, g_pref_log.flushed);
+	g_pref_log.buflen = 0;
+
+	return OK;
+}
+
+static bool pref_log_needs_compaction(void)
+{
+	uint32_t size = g_pref_log.flushed + g_pref_log.buflen;
+
+	return size >= PREF_LOG_COMPACT_SIZE && size - g_pref_log.live > g_pref_log.live;
+}
+
+/* Copy the records of the live keys to a new log which replaces the old one */
+
+static int pref_log_compact(void)
+{
+	struct pref_log_entry_s *entry;
+	struct file tmp;
+	uint8_t *rec = NULL;
+	uint32_t reclen = 0;
+	uint32_t offset;
+	ssize_t nwritten;
+	int ndx;
+	int ret;
+
+	ret = pref_log_commit();
+	if (ret != OK) {
+		return ret;
+	}
+
+	prefvdbg("Compacting log: size %u, live %u\n", g_pref_log.flushed, g_pref_log.live);
+
+	ret = file_open(&tmp, PREF_LOG_TMPPATH, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (ret < 0) {
+		prefdbg("Failed to open %s, %d\n", PREF_LOG_TMPPATH, ret);
+		return PREFERENCE_IO_ERROR;
+	}
+
+	for (ndx = 0; ndx < PREF_LOG_NBUCKETS && ret == OK; ndx++) {
+		for (entry = g_pref_log.bucket[ndx]; entry; entry = entry->flink) {
+			if (entry->reclen > reclen) {
+				kmm_free(rec);
+				reclen = entry->reclen;
+				rec = (uint8_t *)kmm_malloc(reclen);
+				if (rec == NULL) {
+					ret = PREFERENCE_OUT_OF_MEMORY;
+					break;
+				}
+			}
+
+			ret = pref_log_read(entry->offset, rec, entry->reclen);
+			if (ret != OK) {
+				break;
+			}
+
+			nwritten = file_write(&tmp, rec, entry->reclen);
+			if (nwritten != entry->reclen) {
+				ret = PREFERENCE_IO_ERROR;
+				break;
+			}
+		}
+	}
+	kmm_free(rec);
+
+	if (ret == OK && file_fsync(&tmp) < 0) {
+		ret = PREFERENCE_IO_ERROR;
+	}
+	file_close(&tmp);
+
+	if (ret != OK) {
+		prefdbg("Failed to write new log, %d\n", ret);
+		unlink(PREF_LOG_TMPPATH);
+		return ret;
+	}
+
+	/* The new log is complete, replace the old one */
+
+	file_close(&g_pref_log.filep);
+	if (unlink(PREF_LOG_PATH) < 0 || rename(PREF_LOG_TMPPATH, PREF_LOG_PATH) < 0 || file_open(&g_pref_log.filep, PREF_LOG_PATH, O_RDWR) < 0) {
+		/* Recovery finds whichever log is left on the next access */
+		prefdbg("Failed to replace log, %d\n", errno);
+		pref_log_reset();
+		return PREFERENCE_IO_ERROR;
+	}
+
+	/* Records were copied in index order */
+
+	offset = 0;
+	for (ndx = 0; ndx < PREF_LOG_NBUCKETS; ndx++) {
+		for (entry = g_pref_log.bucket[ndx]; entry; entry = entry->flink) {
+			entry->offset = offset;
+			offset += entry->reclen;
+		}
+	}
+	g_pref_log.flushed = offset;
+
+	prefvdbg("Compacted log size %u\n", offset);
+
+	return OK;
+}
+
+#ifdef PREF_LOG_WORK
+static void pref_log_worker(FAR void *arg)
+{
+	while (sem_wait(&g_pref_log.sem) != OK) {
+		ASSERT(get_errno() == EINTR);
+	}
+
+	if (g_pref_log.initialized && pref_log_commit() == OK && pref_log_needs_compaction()) {
+		pref_log_compact();
+	}
+
+	sem_post(&g_pref_log.sem);
+}
+#endif
+
+/* Start the commit of the appended records, and the compaction if needed */
+
+static int pref_log_sync(void)
+{
+	int ret;
+
+#ifdef PREF_LOG_WORK
+	if (CONFIG_PREFERENCE_LOG_COMMIT_DELAY > 0 || pref_log_needs_compaction()) {
+		if (work_available(&g_pref_log.work)) {
+			work_queue(PREF_LOG_WORK, &g_pref_log.work, pref_log_worker, NULL, MSEC2TICK(CONFIG_PREFERENCE_LOG_COMMIT_DELAY));
+		}
+		if (CONFIG_PREFERENCE_LOG_COMMIT_DELAY > 0) {
+			return OK;
+		}
+	}
+
+	/* The worker compacts the log in the background */
+	return pref_log_commit();
+#else
+	ret = pref_log_commit();
+	if (ret == OK && pref_log_needs_compaction()) {
+		ret = pref_log_compact();
+	}
+
+	return ret;
+#endif
+}
+
+static int pref_log_append(struct pref_log_rec_s *rec, const char *key, const void *value, uint32_t *offset)
+{
+	uint32_t reclen;
+	uint32_t crc;
+	int ret;
+
+	reclen = PREF_LOG_RECLEN(rec->keylen, rec->attr.len);
+
+	rec->magic = PREF_LOG_MAGIC;
+	crc = crc32((uint8_t *)&rec->magic, sizeof(struct pref_log_rec_s) - sizeof(uint32_t));
+	crc = crc32part((uint8_t *)key, rec->keylen, crc);
+	rec->crc = crc32part((uint8_t *)value, rec->attr.len, crc);
+
+	if (g_pref_log.buflen + reclen > PREF_LOG_BUFSIZE) {
+		ret = pref_log_commit();
+		if (ret != OK) {
+			return ret;
+		}
+	}
+
+	if (reclen > PREF_LOG_BUFSIZE) {
+		/* Too large for the buffer, write it through */
+		*offset = g_pref_log.flushed;
+		ret = pref_log_write(rec, sizeof(struct pref_log_rec_s));
+		if (ret == OK) {
+			ret = pref_log_write(key, rec->keylen);
+		}
+		if (ret == OK && rec->attr.len > 0) {
+			ret = pref_log_write(value, rec->attr.len);
+		}
+		if (ret == OK && file_fsync(&g_pref_log.filep) < 0) {
+			ret = PREFERENCE_IO_ERROR;
+		}
+		if (ret != OK) {
+			pref_log_reset();
+		}
+		return ret;
+	}
+
+	*offset = g_pref_log.flushed + g_pref_log.buflen;
+	memcpy(g_pref_log.buf + g_pref_log.buflen, rec, sizeof(struct pref_log_rec_s));
+	memcpy(g_pref_log.buf + g_pref_log.buflen + sizeof(struct pref_log_rec_s), key, rec->keylen);
+	if (rec->attr.len > 0) {
+		memcpy(g_pref_log.buf + g_pref_log.buflen + sizeof(struct pref_log_rec_s) + rec->keylen, value, rec->attr.len);
+	}
+	g_pref_log.buflen += reclen;
+
+	return OK;
+}
+
+/* Rebuild the index from the log, stopping at the first broken record */
+
+static int pref_log_recover(void)
+{
+	struct pref_log_rec_s rec;
+	struct stat st;
+	uint8_t *data = NULL;
+	uint32_t datalen = 0;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t crc;
+	off_t end;
+	int ret;
+
+	/* A new log without the old one was complete before the old one was removed */
+
+	if (stat(PREF_LOG_PATH, &st) < 0) {
+		if (stat(PREF_LOG_TMPPATH, &st) == OK) {
+			prefdbg("Restoring log from %s\n", PREF_LOG_TMPPATH);
+			rename(PREF_LOG_TMPPATH, PREF_LOG_PATH);
+		}
+	} else {
+		unlink(PREF_LOG_TMPPATH);
+	}
+
+	ret = file_open(&g_pref_log.filep, PREF_LOG_PATH, O_RDWR | O_CREAT, 0666);
+	if (ret < 0) {
+		prefdbg("Failed to open %s, %d\n", PREF_LOG_PATH, ret);
+		return PREFERENCE_IO_ERROR;
+	}
+
+	end = file_seek(&g_pref_log.filep, 0, SEEK_END);
+	if (end < 0) {
+		ret = PREFERENCE_IO_ERROR;
+		goto errout_with_close;
+	}
+	size = (uint32_t)end;
+
+	g_pref_log.flushed = size;
+	g_pref_log.buflen = 0;
+
+	for (offset = 0; offset + sizeof(struct pref_log_rec_s) <= size; offset += PREF_LOG_RECLEN(rec.keylen, rec.attr.len)) {
+		if (file_pread(&g_pref_log.filep, &rec, sizeof(struct pref_log_rec_s), offset) != sizeof(struct pref_log_rec_s)) {
+			break;
+		}
+
+		if (rec.magic != PREF_LOG_MAGIC || (rec.op != PREF_LOG_OP_PUT && rec.op != PREF_LOG_OP_DEL && rec.op != PREF_LOG_OP_DELDIR) || rec.keylen == 0 || rec.keylen > PREF_LOG_KEYMAX || rec.attr.len < 0 || PREF_LOG_RECLEN(rec.keylen, rec.attr.len) > size - offset) {
+			break;
+		}
+
+		if (rec.keylen + rec.attr.len > datalen) {
+			kmm_free(data);
+			datalen = rec.keylen + rec.attr.len;
+			data = (uint8_t *)kmm_malloc(datalen);
+			if (data == NULL) {
+				ret = PREFERENCE_OUT_OF_MEMORY;
+				goto errout_with_clear;
+			}
+		}
+
+		if (file_pread(&g_pref_log.filep, data, rec.keylen + rec.attr.len, offset + sizeof(struct pref_log_rec_s)) != rec.keylen + rec.attr.len) {
+			break;
+		}
+
+		crc = crc32((uint8_t *)&rec.magic, sizeof(struct pref_log_rec_s) - sizeof(uint32_t));
+		if (crc32part(data, rec.keylen + rec.attr.len, crc) != rec.crc) {
+			break;
+		}
+
+		ret = pref_log_index(&rec, (const char *)data, offset, NULL);
+		if (ret != OK) {
+			goto errout_with_clear;
+		}
+	}
+	kmm_free(data);
+	data = NULL;
+
+	prefvdbg("Recovered log: size %u, valid %u, live %u\n", size, offset, g_pref_log.live);
+
+	if (offset < size) {
+		/* Don't append after the torn record, rewrite the valid ones */
+		prefdbg("Broken record at %u of %u in log\n", offset, size);
+		g_pref_log.flushed = offset;
+		ret = pref_log_compact();
+		if (ret != OK) {
+			goto errout_with_clear;
+		}
+	}
+
+	return OK;
+
+errout_with_clear:
+	kmm_free(data);
+errout_with_close:
+	pref_log_reset();
+	return ret;
+}
+
+static int pref_log_enter(void)
+{
+	int ret;
+
+	while (sem_wait(&g_pref_log.sem) != OK) {
+		ASSERT(get_errno() == EINTR);
+	}
+
+	if (g_pref_log.initialized) {
+		return OK;
+	}
+
+	if (g_pref_log.buf == NULL) {
+		g_pref_log.buf = (uint8_t *)kmm_malloc(PREF_LOG_BUFSIZE);
+		if (g_pref_log.buf == NULL) {
+			sem_post(&g_pref_log.sem);
+			return PREFERENCE_OUT_OF_MEMORY;
+		}
+	}
+
+	ret = pref_log_recover();
+	if (ret != OK) {
+		sem_post(&g_pref_log.sem);
+		return ret;
+	}
+	g_pref_log.initialized = true;
+
+	return OK;
+}
+
+static void pref_log_leave(void)
+{
+	sem_post(&g_pref_log.sem);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+int preference_log_write(const char *path, preference_data_t *data)
+{
+	struct pref_log_rec_s rec;
+	struct pref_log_entry_s *spare = NULL;
+	const char *key;
+	uint32_t offset;
+	uint32_t crc_value;
+	int keylen;
+	int ret;
+
+	key = pref_log_key(path);
+	if (key == NULL || data->attr.len < 0 || (data->attr.len > 0 && data->value == NULL)) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+	keylen = strlen(key);
+	if (keylen == 0 || keylen > PREF_LOG_KEYMAX) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+
+	/* Calculate checksum of attributes, type, len and value as for a key file */
+	crc_value = crc32((uint8_t *)&data->attr.type, sizeof(value_attr_t) - sizeof(uint32_t));
+	data->attr.crc = crc32part((uint8_t *)data->value, data->attr.len, crc_value);
+
+	ret = pref_log_enter();
+	if (ret != OK) {
+		return ret;
+	}
+
+	/* A new key must be indexable before its record is in the log */
+	if (pref_log_find(key, keylen, NULL) == NULL) {
+		spare = (struct pref_log_entry_s *)kmm_malloc(sizeof(struct pref_log_entry_s) + keylen);
+		if (spare == NULL) {
+			pref_log_leave();
+			return PREFERENCE_OUT_OF_MEMORY;
+		}
+	}
+
+	rec.op = PREF_LOG_OP_PUT;
+	rec.keylen = keylen;
+	rec.attr = data->attr;
+	ret = pref_log_append(&rec, key, data->value, &offset);
+	if (ret == OK) {
+		pref_log_index(&rec, key, offset, &spare);
+		ret = pref_log_sync();
+	}
+	kmm_free(spare);
+
+	prefvdbg("Write Key : %s, len = %d, ret = %d\n", key, data->attr.len, ret);
+	pref_log_leave();
+
+	return ret;
+}
+
+int preference_log_read(const char *path, preference_data_t *data)
+{
+	struct pref_log_rec_s rec;
+	struct pref_log_entry_s *entry;
+	const char *key;
+	uint32_t crc;
+	int ret;
+
+	key = pref_log_key(path);
+	if (key == NULL) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+
+	ret = pref_log_enter();
+	if (ret != OK) {
+		return ret;
+	}
+
+	entry = pref_log_find(key, strlen(key), NULL);
+	if (entry == NULL) {
+		ret = PREFERENCE_KEY_NOT_EXIST;
+		goto errout;
+	}
+
+	ret = pref_log_read(entry->offset, &rec, sizeof(struct pref_log_rec_s));
+	if (ret != OK) {
+		goto errout;
+	}
+
+	if (rec.attr.type != data->attr.type) {
+		prefdbg("Invalid type. request type:%d, read type:%d\n", data->attr.type, rec.attr.type);
+		ret = PREFERENCE_INVALID_PARAMETER;
+		goto errout;
+	}
+
+	data->attr.len = rec.attr.len;
+	data->value = PREFERENCE_ALLOC(rec.attr.len);
+	if (data->value == NULL) {
+		ret = PREFERENCE_OUT_OF_MEMORY;
+		goto errout;
+	}
+
+	ret = pref_log_read(entry->offset + sizeof(struct pref_log_rec_s) + entry->keylen, data->value, rec.attr.len);
+	if (ret != OK) {
+		goto errout_with_free;
+	}
+
+	/* The key in the index is the one of the record */
+	crc = crc32((uint8_t *)&rec.magic, sizeof(struct pref_log_rec_s) - sizeof(uint32_t));
+	crc = crc32part((uint8_t *)entry->key, entry->keylen, crc);
+	crc = crc32part((uint8_t *)data->value, rec.attr.len, crc);
+	if (crc != rec.crc) {
+		prefdbg("Invalid checksum, read crc : %u, calculated crc : %u\n", rec.crc, crc);
+		ret = PREFERENCE_INVALID_DATA;
+		goto errout_with_free;
+	}
+
+	pref_log_leave();
+	prefvdbg("Read key Success!\n");
+
+	return OK;
+errout_with_free:
+	PREFERENCE_FREE(data->value);
+errout:
+	pref_log_leave();
+
+	return ret;
+}
+
+int preference_log_check(const char *path, bool *existing)
+{
+	const char *key;
+	int ret;
+
+	key = pref_log_key(path);
+	if (key == NULL) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+
+	ret = pref_log_enter();
+	if (ret != OK) {
+		return ret;
+	}
+
+	*existing = pref_log_find(key, strlen(key), NULL) != NULL;
+	pref_log_leave();
+
+	return OK;
+}
+
+int preference_log_remove(const char *path)
+{
+	struct pref_log_rec_s rec;
+	const char *key;
+	uint32_t offset;
+	int ret;
+
+	key = pref_log_key(path);
+	if (key == NULL) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+
+	ret = pref_log_enter();
+	if (ret != OK) {
+		return ret;
+	}
+
+	if (pref_log_find(key, strlen(key), NULL) == NULL) {
+		prefdbg("key is not exist : %s\n", key);
+		ret = PREFERENCE_KEY_NOT_EXIST;
+		goto errout;
+	}
+
+	rec.op = PREF_LOG_OP_DEL;
+	rec.keylen = strlen(key);
+	memset(&rec.attr, 0, sizeof(value_attr_t));
+	ret = pref_log_append(&rec, key, NULL, &offset);
+	if (ret == OK) {
+		pref_log_index(&rec, key, offset, NULL);
+		ret = pref_log_sync();
+	}
+
+errout:
+	pref_log_leave();
+
+	return ret;
+}
+
+int preference_log_remove_all(const char *path)
+{
+	struct pref_log_rec_s rec;
+	struct pref_log_entry_s *entry;
+	const char *dir;
+	uint32_t offset;
+	int dirlen;
+	int ndx;
+	int ret;
+
+	dir = pref_log_key(path);
+	if (dir == NULL) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+	dirlen = strlen(dir);
+	if (dirlen == 0 || dirlen > PREF_LOG_KEYMAX) {
+		return PREFERENCE_INVALID_PARAMETER;
+	}
+
+	ret = pref_log_enter();
+	if (ret != OK) {
+		return ret;
+	}
+
+	/* No key below the directory is an empty directory, removed with OK */
+	entry = NULL;
+	for (ndx = 0; ndx < PREF_LOG_NBUCKETS && entry == NULL; ndx++) {
+		entry = g_pref_log.bucket[ndx];
+		while (entry && !pref_log_below(entry, dir, dirlen)) {
+			entry = entry->flink;
+		}
+	}
+
+	if (entry) {
+		/* One record removes all the keys, a power loss keeps all or none */
+		rec.op = PREF_LOG_OP_DELDIR;
+		rec.keylen = dirlen;
+		memset(&rec.attr, 0, sizeof(value_attr_t));
+		ret = pref_log_append(&rec, dir, NULL, &offset);
+		if (ret == OK) {
+			prefvdbg("Remove keys below : %s\n", dir);
+			pref_log_index(&rec, dir, offset, NULL);
+			ret = pref_log_sync();
+		}
+	}
+
+	pref_log_leave();
+
+	return ret;
+}
@@ -25,9 +25,12 @@
 #include <crc32.h>
 #include <tinyara/preference.h>
 
+#include "preference.h"
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
+#ifndef CONFIG_PREFERENCE_LOG
 static int preference_read_fs_key(char *path, preference_data_t *data)
 {
 	int fd;
@@ -95,6 +98,7 @@ errout:
 
 	return ret;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -123,5 +127,12 @@ int preference_read_key(preference_data_t *data)
 		}
 	}
 
+#ifdef CONFIG_PREFERENCE_LOG
+	ret = preference_log_read(path, data);
+	PREFERENCE_FREE(path);
+
+	return ret;
+#else
 	return preference_read_fs_key(path, data);
+#endif
 }
@@ -31,10 +31,12 @@
 
 #include "sched/sched.h"
 #endif
+#include "preference.h"
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
+#ifndef CONFIG_PREFERENCE_LOG
 static int preference_remove_fs_key(char *path)
 {
 	int ret;
@@ -62,6 +64,7 @@ static int preference_remove_fs_key(char *path)
 
 	return ret;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -90,16 +93,25 @@ int preference_remove_key(int type, const char *key)
 		}
 	}
 
+#ifdef CONFIG_PREFERENCE_LOG
+	ret = preference_log_remove(path);
+	PREFERENCE_FREE(path);
+
+	return ret;
+#else
 	return preference_remove_fs_key(path);
+#endif
 }
 
 int preference_remove_all_key(int type, const char *path)
 {
 	int ret;
-	DIR *dir;
 	char *dir_path;
+#ifndef CONFIG_PREFERENCE_LOG
+	DIR *dir;
 	char *key_path;
 	struct dirent *entry;
+#endif
 #if CONFIG_APP_BINARY_SEPARATION
 	pid_t pid;
 	struct tcb_s *tcb;
@@ -138,6 +150,13 @@ int preference_remove_all_key(int type, const char *path)
 
 	prefvdbg("preference dir path = %s\n", dir_path);
 
+#ifdef CONFIG_PREFERENCE_LOG
+	/* Remove the keys of the directory from the log */
+	ret = preference_log_remove_all(dir_path);
+	PREFERENCE_FREE(dir_path);
+
+	return ret;
+#else
 	dir = (DIR *)opendir(dir_path);
 	if (!dir) {
 		prefdbg("Failed to open dir %s, %d\n", dir_path, errno);
@@ -190,4 +209,5 @@ errout_with_free:
 	PREFERENCE_FREE(dir_path);
 
 	return ret;
+#endif
 }
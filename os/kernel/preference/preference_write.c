@@ -32,10 +32,12 @@
 #ifdef CONFIG_APP_BINARY_SEPARATION
 #include "sched/sched.h"
 #endif
+#include "preference.h"
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
+#ifndef CONFIG_PREFERENCE_LOG
 #ifdef CONFIG_APP_BINARY_SEPARATION
 static int preference_private_setup(void)
 {
@@ -153,6 +155,7 @@ errout_with_close:
 
 	return PREFERENCE_IO_ERROR;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -168,7 +171,7 @@ int preference_write_key(preference_data_t *data)
 	}
 
 	if (data->type == PRIVATE_PREFERENCE) {
-#ifdef CONFIG_APP_BINARY_SEPARATION
+#if defined(CONFIG_APP_BINARY_SEPARATION) && !defined(CONFIG_PREFERENCE_LOG)
 		ret = preference_private_setup();
 		if (ret < 0) {
 			prefdbg("Failed to set up preference\n");
@@ -181,11 +184,13 @@ int preference_write_key(preference_data_t *data)
 			return ret;
 		}
 	} else {
+#ifndef CONFIG_PREFERENCE_LOG
 		ret = preference_shared_setup(data->key);
 		if (ret < 0) {
 			prefdbg("Failed to set up preference\n");
 			return ret;
 		}
+#endif
 		ret = PREFERENCE_ASPRINTF(&path, "%s/%s", PREF_SHARED_PATH, data->key);
 		if (ret < 0) {
 			prefdbg("Failed to allocate path\n");
@@ -194,7 +199,13 @@ int preference_write_key(preference_data_t *data)
 	}
 	prefvdbg("Preference key path = %s\n", path);
 
+#ifdef CONFIG_PREFERENCE_LOG
+	/* Append the key to the log instead of writing a file for it */
+	ret = preference_log_write(path, data);
+	PREFERENCE_FREE(path);
+#else
 	ret = preference_write_fs_key(path, data);
+#endif
 #if !defined(CONFIG_DISABLE_MQUEUE) && !defined(CONFIG_DISABLE_SIGNAL)
 	if (ret == OK) {
 		/* Execute callback if registered cb is existing */
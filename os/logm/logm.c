@@ -37,6 +37,7 @@ int g_logm_tail;
 int g_logm_dropmsg_count;
 int g_logm_overflow_offset = -1;
 
+#ifndef CONFIG_LOGM_BINARY
 static void logm_putc(FAR struct lib_outstream_s *this, int ch)
 {
 	if ((g_logm_tail + this->nput + 1) % logm_bufsize != g_logm_head) {
@@ -52,10 +53,16 @@ static void logm_outstream(FAR struct lib_outstream_s *outstream)
 #endif
 	outstream->nput = 0;
 }
+#endif
 
 #ifdef CONFIG_ARCH_LOWPUTC
 static void logm_flush(struct lib_outstream_s *stream)
 {
+#ifdef CONFIG_LOGM_BINARY
+	if (LOGM_STATUS(LOGM_READY)) {
+		logm_bin_flush(stream);
+	}
+#else
 	sched_lock();
 
 	while (g_logm_head != g_logm_tail) {
@@ -67,23 +74,34 @@ static void logm_flush(struct lib_outstream_s *stream)
 		LOGM_STATUS_CLEAR(LOGM_BUFFER_OVERFLOW);
 	}
 
+	sched_unlock();
+#endif
+
 	/* Reset nput in stream for next stream */
 	stream->nput = 0;
-
-	sched_unlock();
 }
 #endif
 
 /* logm_internal hook for syslog & printfs */
 int logm_internal(int flag, int indx, int priority, const char *fmt, va_list ap)
 {
-	irqstate_t flags;
 	int ret = 0;
+#if !defined(CONFIG_LOGM_BINARY) || defined(CONFIG_ARCH_LOWPUTC)
 	struct lib_outstream_s strm;
+#endif
+#ifndef CONFIG_LOGM_BINARY
+	irqstate_t flags;
 #ifdef CONFIG_LOGM_TIMESTAMP
 	struct timespec ts;
 #endif
+#endif
 
+#ifdef CONFIG_LOGM_BINARY
+	/* Text records go to the binary rings, which share the logm buffer */
+	if (flag == LOGM_NORMAL && !up_interrupt_context() && (ret = logm_bin_text(priority, fmt, ap)) >= 0) {
+		/* Formatted in a text record */
+	} else
+#else
 	if (LOGM_STATUS(LOGM_READY) && !LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ) \
 		&& flag == LOGM_NORMAL && !up_interrupt_context()) {
 
@@ -114,7 +132,9 @@ int logm_internal(int flag, int indx, int priority, const char *fmt, va_list ap)
 			g_logm_overflow_offset = g_logm_tail;
 		}
 		irqrestore(flags);
-	} else {
+	} else
+#endif
+	{
 		/* Low Output: Sytem is not yet completely ready or this is called from interrupt handler */
 #ifdef CONFIG_ARCH_LOWPUTC
 		lib_lowoutstream(&strm);
@@ -134,6 +154,24 @@ int logm(int flag, int indx, int priority, const char *fmt, ...)
 
 	/* LOGIC for initial test here */
 
+#ifdef CONFIG_LOGM_BINARY
+	/* The format of logm() callers is a constant string, it is kept in
+	 * the record and formatted later. Records are written without
+	 * disabling interrupts, so interrupt handlers use them too.
+	 */
+#ifndef CONFIG_LOGM_BINARY_LOWPUT
+	if (flag == LOGM_NORMAL)
+#endif
+	{
+		va_start(ap, fmt);
+		ret = logm_bin_record(priority, fmt, ap);
+		va_end(ap);
+		if (ret >= 0) {
+			return ret;
+		}
+	}
+#endif
+
 	va_start(ap, fmt);
 	ret = logm_internal(flag, indx, priority, fmt, ap);
 	va_end(ap);
@@ -20,6 +20,7 @@
 
 #include <tinyara/config.h>
 #include <stdint.h>
+#include <stdarg.h>
 
 /****************************************************************************
  * Preprocessor Definitions
@@ -51,12 +52,84 @@
 #define LOGM_STATUS_SET(a) (logm_status |= (a))
 #define LOGM_STATUS_CLEAR(a) (logm_status &= ~(a))
 
+#ifdef CONFIG_LOGM_BINARY
+#ifdef CONFIG_LOGM_BINARY_STRMAX
+#define LOGM_BIN_STRMAX CONFIG_LOGM_BINARY_STRMAX
+#else
+#define LOGM_BIN_STRMAX (64)
+#endif
+
+/* Maximum size of the arguments of a binary record, packed on the stack */
+
+#define LOGM_BIN_ARGMAX ((LOGM_BIN_STRMAX + 64 + 3) & ~3)
+
+/* Rings of the binary mode: errors and warnings, then other messages */
+
+#ifdef CONFIG_LOGM_BINARY_URGENT_PERCENT
+#define LOGM_BIN_URGENT_PERCENT CONFIG_LOGM_BINARY_URGENT_PERCENT
+#else
+#define LOGM_BIN_URGENT_PERCENT (50)
+#endif
+
+/* How long a resize waits for the users of the rings */
+
+#define LOGM_BIN_QUIESCE_MSEC 1000
+
+#define LOGM_BIN_URGENT 0
+#define LOGM_BIN_NORMAL 1
+#define LOGM_BIN_NRINGS 2
+
+#define LOGM_BIN_RING(priority) ((priority) <= LOGM_WRN ? LOGM_BIN_URGENT : LOGM_BIN_NORMAL)
+
+/* Flags of a binary record */
+
+#define LOGM_BINREC_COMMIT BIT(0)	/* Record is complete */
+#define LOGM_BINREC_PAD BIT(1)	/* Unused end of the ring, skipped */
+#define LOGM_BINREC_TEXT BIT(2)	/* Formatted text instead of arguments */
+#define LOGM_BINREC_TRUNC BIT(3)	/* Arguments didn't fit */
+#define LOGM_BINREC_STRREF(n) BIT(4 + (n))	/* n-th string is an address */
+#define LOGM_BINREC_NSTRREFS 4
+
+/* Strings of the read-only sections live as long as the records */
+
+#ifdef CONFIG_LOGM_BINARY_ROSTR
+extern uint32_t _stext;
+extern uint32_t _etext;
+#define LOGM_BIN_ROSTR(str) ((uintptr_t)(str) >= (uintptr_t)&_stext && (uintptr_t)(str) < (uintptr_t)&_etext)
+#endif
+#endif
+
 /****************************************************************************
  * Private Declarations
  ****************************************************************************/
 
 /* Structure for a single debug message */
 
+#ifdef CONFIG_LOGM_BINARY
+/* Header of a binary record. It is followed by the arguments, each one
+ * 4 bytes aligned, "%s" strings being copied with their terminating NUL,
+ * or by the formatted text if LOGM_BINREC_TEXT is set. The flags are
+ * written last, when the record is committed.
+ */
+
+struct logm_binrec_s {
+	uint16_t size;				/* Record size, a multiple of 4 */
+	uint8_t priority;
+	uint8_t flags;				/* LOGM_BINREC_xxx */
+	uint32_t seq;				/* Orders the records of the rings */
+	uint32_t msec;				/* Timestamp */
+	const char *fmt;			/* Format string */
+};
+
+struct logm_binring_s {
+	uint8_t *buf;
+	uint32_t size;
+	uint32_t head;				/* Next record to print */
+	uint32_t tail;				/* Next free byte, reserved with CAS */
+	uint32_t dropped;			/* Records dropped since last flush */
+};
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 #define EXTERN extern "C"
@@ -74,12 +147,24 @@ EXTERN int logm_bufsize;
 EXTERN uint8_t logm_status;
 EXTERN volatile int new_logm_bufsize;
 EXTERN volatile int logm_print_interval;
+#ifdef CONFIG_LOGM_BINARY
+EXTERN struct logm_binring_s g_logm_binring[LOGM_BIN_NRINGS];
+#endif
 
 /************************************************************************************
  * Private Function Prototypes
  ************************************************************************************/
 int logm_task(int argc, char *argv[]);
 void logm_register_tashcmds(void);
+#ifdef CONFIG_LOGM_BINARY
+struct lib_outstream_s;
+void logm_bin_init(char *buf, int bufsize);
+int logm_bin_record(int priority, const char *fmt, va_list ap);
+int logm_bin_text(int priority, const char *fmt, va_list ap);
+void logm_bin_flush(struct lib_outstream_s *stream);
+int logm_bin_quiesce(void);
+void logm_bin_resume(void);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
@@ -0,0 +1,651 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Binary deferred-formatting mode of logm.
+ *
+ * Callers of logm() write a record with the address of the format string,
+ * a timestamp and the raw arguments in a ring selected by the priority.
+ * A record is reserved by a compare and swap of the tail of the ring,
+ * filled and then committed by setting LOGM_BINREC_COMMIT in its first
+ * word, so that writers never disable interrupts and may run in interrupt
+ * handlers. Tasks lock the scheduler from the reservation to the commit:
+ * a task deleted in between would leave a record the consumer waits for
+ * forever. The rings are read by a single consumer, logm task or a
+ * low-level message, which formats the committed records in sequence order
+ * and zeroes them: the bytes beyond the tail of a ring are always zero.
+ */
+
+#include <tinyara/config.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <sched.h>
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <tinyara/logm.h>
+#include <tinyara/streams.h>
+#include "logm.h"
+
+#define LOGM_BIN_ALIGN(n) (((n) + 3) & ~3)
+#define LOGM_BIN_HDRSIZE LOGM_BIN_ALIGN(sizeof(struct logm_binrec_s))
+#define LOGM_BIN_RECMAX 0xfffc
+
+/* Kind of the argument of a format specification */
+
+enum logm_binarg_e {
+	LOGM_BINARG_NONE,
+	LOGM_BINARG_INT,
+	LOGM_BINARG_LONG,
+	LOGM_BINARG_LLONG,
+	LOGM_BINARG_PTR,
+	LOGM_BINARG_DOUBLE,
+	LOGM_BINARG_STR
+};
+
+struct logm_binring_s g_logm_binring[LOGM_BIN_NRINGS];
+
+static uint32_t g_logm_binseq;
+static int g_logm_binwriters;	/* Writers between logm_bin_enter() and logm_bin_leave() */
+static int g_logm_bindraining;	/* A consumer owns the rings */
+
+/* Parses a format specification, fmt pointing after the '%', the way
+ * lib_vsprintf() does: every character but a conversion or a length is a
+ * qualifier and each '*' takes an int argument. Returns the end of the
+ * specification.
+ */
+
+static const char *logm_bin_spec(const char *fmt, int *type, int *nstars)
+{
+	int length = 0;
+
+	*nstars = 0;
+	*type = LOGM_BINARG_NONE;
+
+	for (;; fmt++) {
+		switch (*fmt) {
+		case '\0':
+			return fmt;
+		case '*':
+			(*nstars)++;
+			continue;
+		case 's':
+			*type = LOGM_BINARG_STR;
+			return fmt + 1;
+		case 'c':
+			*type = LOGM_BINARG_INT;
+			return fmt + 1;
+		case '%':
+			return fmt + 1;
+		case 'L':
+			length = 2;
+			fmt++;
+			break;
+		case 'l':
+			length = 1;
+			fmt++;
+			if (*fmt == 'l') {
+				length = 2;
+				fmt++;
+			}
+			break;
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'p': case 'o': case 'b':
+		case 'e': case 'E': case 'f': case 'g': case 'G':
+			break;
+		default:
+			continue;
+		}
+		break;
+	}
+
+	switch (*fmt) {
+	case '\0':
+		return fmt;
+	case 'p':
+		*type = LOGM_BINARG_PTR;
+		break;
+	case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b':
+		*type = length == 2 ? LOGM_BINARG_LLONG : length == 1 ? LOGM_BINARG_LONG : LOGM_BINARG_INT;
+		break;
+	case 'e': case 'E': case 'f': case 'g': case 'G':
+		*type = LOGM_BINARG_DOUBLE;
+		break;
+	default:
+		break;
+	}
+
+	return fmt + 1;
+}
+
+/* Appends an argument if it fits */
+
+static bool logm_bin_put(uint8_t *args, int *len, const void *value, int size)
+{
+	if (*len + LOGM_BIN_ALIGN(size) > LOGM_BIN_ARGMAX) {
+		return false;
+	}
+	memcpy(args + *len, value, size);
+	*len += LOGM_BIN_ALIGN(size);
+	return true;
+}
+
+/* Copies the arguments of fmt to args and returns their size. The first
+ * string arguments found in the read-only sections are kept by address.
+ */
+
+static int logm_bin_pack(uint8_t *args, const char *fmt, va_list ap, uint8_t *flags)
+{
+	int len = 0;
+	int type;
+	int nstars;
+	int nstrs = 0;
+	bool fit = true;
+
+	while (fit && (fmt = strchr(fmt, '%')) != NULL) {
+		fmt = logm_bin_spec(fmt + 1, &type, &nstars);
+		while (nstars-- > 0 && fit) {
+			int star = va_arg(ap, int);
+			fit = logm_bin_put(args, &len, &star, sizeof(star));
+		}
+		if (!fit) {
+			break;
+		}
+
+		switch (type) {
+		case LOGM_BINARG_INT: {
+			int value = va_arg(ap, int);
+			fit = logm_bin_put(args, &len, &value, sizeof(value));
+			break;
+		}
+		case LOGM_BINARG_LONG: {
+			long value = va_arg(ap, long);
+			fit = logm_bin_put(args, &len, &value, sizeof(value));
+			break;
+		}
+		case LOGM_BINARG_LLONG: {
+			long long value = va_arg(ap, long long);
+			fit = logm_bin_put(args, &len, &value, sizeof(value));
+			break;
+		}
+		case LOGM_BINARG_PTR: {
+			void *value = va_arg(ap, void *);
+			fit = logm_bin_put(args, &len, &value, sizeof(value));
+			break;
+		}
+		case LOGM_BINARG_DOUBLE: {
+			double value = va_arg(ap, double);
+			fit = logm_bin_put(args, &len, &value, sizeof(value));
+			break;
+		}
+		case LOGM_BINARG_STR: {
+			const char *str = va_arg(ap, const char *);
+			int size;
+
+			if (str == NULL) {
+				str = "(null)";
+			}
+
+#ifdef CONFIG_LOGM_BINARY_ROSTR
+			if (nstrs < LOGM_BINREC_NSTRREFS && LOGM_BIN_ROSTR(str)) {
+				fit = logm_bin_put(args, &len, &str, sizeof(str));
+				*flags |= LOGM_BINREC_STRREF(nstrs++);
+				break;
+			}
+#endif
+			nstrs++;
+
+			/* Strings are truncated to what is left, with the NUL */
+
+			size = strnlen(str, LOGM_BIN_STRMAX);
+			if (size + 1 > LOGM_BIN_ARGMAX - len) {
+				size = LOGM_BIN_ARGMAX - len - 1;
+			}
+			if (size < 0) {
+				fit = false;
+				break;
+			}
+			memcpy(args + len, str, size);
+			args[len + size] = '\0';
+			len += LOGM_BIN_ALIGN(size + 1);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	if (!fit) {
+		*flags |= LOGM_BINREC_TRUNC;
+	}
+
+	return len;
+}
+
+static int logm_bin_enter(void)
+{
+	if (!up_interrupt_context()) {
+		sched_lock();
+	}
+	__atomic_add_fetch(&g_logm_binwriters, 1, __ATOMIC_SEQ_CST);
+	if (!LOGM_STATUS(LOGM_READY) || LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ)) {
+		__atomic_sub_fetch(&g_logm_binwriters, 1, __ATOMIC_SEQ_CST);
+		if (!up_interrupt_context()) {
+			sched_unlock();
+		}
+		return ERROR;
+	}
+	return OK;
+}
+
+static void logm_bin_leave(void)
+{
+	__atomic_sub_fetch(&g_logm_binwriters, 1, __ATOMIC_RELEASE);
+	if (!up_interrupt_context()) {
+		sched_unlock();
+	}
+}
+
+/* Reserves size bytes in ring. If they don't fit before the end of the
+ * ring, the end is filled by a pad record and the record starts at 0. One
+ * word is always left free so that a full ring is told from an empty one.
+ */
+
+static struct logm_binrec_s *logm_bin_reserve(struct logm_binring_s *ring, uint32_t size, int priority)
+{
+	struct logm_binrec_s *rec;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t used;
+	uint32_t pad;
+	uint32_t next;
+
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	do {
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		pad = tail + size > ring->size ? ring->size - tail : 0;
+		used = tail >= head ? tail - head : ring->size - head + tail;
+		if (used + pad + size + 4 > ring->size) {
+			__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+		next = (tail + pad + size) % ring->size;
+	} while (!__atomic_compare_exchange_n(&ring->tail, &tail, next, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	if (pad) {
+		rec = (struct logm_binrec_s *)(ring->buf + tail);
+		__atomic_store_n(&rec->flags, LOGM_BINREC_PAD | LOGM_BINREC_COMMIT, __ATOMIC_RELEASE);
+		tail = 0;
+	}
+
+	rec = (struct logm_binrec_s *)(ring->buf + tail);
+	rec->size = size;
+	rec->priority = priority;
+	rec->seq = __atomic_fetch_add(&g_logm_binseq, 1, __ATOMIC_RELAXED);
+	rec->msec = TICK2MSEC(clock_systimer());
+	return rec;
+}
+
+static void logm_bin_commit(struct logm_binrec_s *rec, uint8_t flags)
+{
+	__atomic_store_n(&rec->flags, flags | LOGM_BINREC_COMMIT, __ATOMIC_RELEASE);
+}
+
+/* Returns the oldest record of ring if it is committed, skipping pads */
+
+static struct logm_binrec_s *logm_bin_peek(struct logm_binring_s *ring)
+{
+	struct logm_binrec_s *rec;
+	uint8_t flags;
+
+	while (ring->head != __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+		rec = (struct logm_binrec_s *)(ring->buf + ring->head);
+		flags = __atomic_load_n(&rec->flags, __ATOMIC_ACQUIRE);
+		if (!(flags & LOGM_BINREC_COMMIT)) {
+			return NULL;
+		}
+		if (!(flags & LOGM_BINREC_PAD)) {
+			return rec;
+		}
+		/* Only the first word of a pad record is written */
+		*(uint32_t *)rec = 0;
+		__atomic_store_n(&ring->head, 0, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+static void logm_bin_consume(struct logm_binring_s *ring, struct logm_binrec_s *rec)
+{
+	uint32_t size = rec->size;
+
+	memset(rec, 0, size);
+	__atomic_store_n(&ring->head, (ring->head + size) % ring->size, __ATOMIC_RELEASE);
+}
+
+static bool logm_bin_get(const uint8_t **arg, const uint8_t *end, void *value, int size)
+{
+	if (*arg + LOGM_BIN_ALIGN(size) > end) {
+		return false;
+	}
+	memcpy(value, *arg, size);
+	*arg += LOGM_BIN_ALIGN(size);
+	return true;
+}
+
+/* Formats a binary record: the literal parts of the format are put as they
+ * are and each specification is given to lib_sprintf() with its arguments.
+ */
+
+#define LOGM_BIN_STARMAX 2
+
+#define LOGM_BIN_SPRINTF(stream, spec, nstars, stars, value) \
+	((nstars) == 0 ? lib_sprintf(stream, spec, value) : \
+	 (nstars) == 1 ? lib_sprintf(stream, spec, (stars)[0], value) : \
+	 lib_sprintf(stream, spec, (stars)[0], (stars)[1], value))
+
+#define LOGM_BIN_FORMAT(stream, spec, nstars, stars, type, arg, end) \
+	do { \
+		type value; \
+		if (!logm_bin_get(&(arg), end, &value, sizeof(value))) { \
+			goto truncated; \
+		} \
+		LOGM_BIN_SPRINTF(stream, spec, nstars, stars, value); \
+	} while (0)
+
+static void logm_bin_format(struct lib_outstream_s *stream, const struct logm_binrec_s *rec)
+{
+	const uint8_t *arg = (const uint8_t *)rec + LOGM_BIN_HDRSIZE;
+	const uint8_t *end = (const uint8_t *)rec + rec->size;
+	const char *fmt = rec->fmt;
+	const char *spec;
+	const char *str;
+	char buf[32];
+	int stars[LOGM_BIN_STARMAX];
+	int type;
+	int nstars;
+	int nstrs = 0;
+	int len;
+	int i;
+
+	while (*fmt) {
+		if (*fmt != '%') {
+			stream->put(stream, *fmt++);
+			continue;
+		}
+
+		spec = fmt++;
+		fmt = logm_bin_spec(fmt, &type, &nstars);
+		len = fmt - spec;
+		if (len >= sizeof(buf) || nstars > LOGM_BIN_STARMAX) {
+			goto truncated;
+		}
+		memcpy(buf, spec, len);
+		buf[len] = '\0';
+
+		for (i = 0; i < nstars; i++) {
+			if (!logm_bin_get(&arg, end, &stars[i], sizeof(int))) {
+				goto truncated;
+			}
+		}
+
+		switch (type) {
+		case LOGM_BINARG_INT:
+			LOGM_BIN_FORMAT(stream, buf, nstars, stars, int, arg, end);
+			break;
+		case LOGM_BINARG_LONG:
+			LOGM_BIN_FORMAT(stream, buf, nstars, stars, long, arg, end);
+			break;
+		case LOGM_BINARG_LLONG:
+			LOGM_BIN_FORMAT(stream, buf, nstars, stars, long long, arg, end);
+			break;
+		case LOGM_BINARG_PTR:
+			LOGM_BIN_FORMAT(stream, buf, nstars, stars, void *, arg, end);
+			break;
+		case LOGM_BINARG_DOUBLE:
+			LOGM_BIN_FORMAT(stream, buf, nstars, stars, double, arg, end);
+			break;
+		case LOGM_BINARG_STR:
+			if (nstrs < LOGM_BINREC_NSTRREFS && (rec->flags & LOGM_BINREC_STRREF(nstrs))) {
+				if (!logm_bin_get(&arg, end, &str, sizeof(str))) {
+					goto truncated;
+				}
+			} else {
+				str = (const char *)arg;
+				len = strnlen(str, end - arg);
+				if (len == end - arg) {
+					goto truncated;
+				}
+				arg += LOGM_BIN_ALIGN(len + 1);
+			}
+			nstrs++;
+			LOGM_BIN_SPRINTF(stream, buf, nstars, stars, str);
+			break;
+		default:
+			/* "%%" or an unknown conversion */
+			LOGM_BIN_SPRINTF(stream, buf, nstars, stars, 0);
+			break;
+		}
+	}
+	return;
+
+truncated:
+	lib_sprintf(stream, "...\n");
+}
+
+static void logm_bin_print(struct lib_outstream_s *stream, const struct logm_binrec_s *rec)
+{
+	const char *text;
+
+#ifdef CONFIG_LOGM_BINARY_RAW
+	if (!(rec->flags & LOGM_BINREC_TEXT)) {
+		const uint8_t *byte = (const uint8_t *)rec;
+		int i;
+
+		lib_sprintf(stream, "#LOGM:");
+		for (i = 0; i < rec->size; i++) {
+			lib_sprintf(stream, "%02x", byte[i]);
+		}
+		stream->put(stream, '\n');
+		return;
+	}
+#endif
+
+#ifdef CONFIG_LOGM_TIMESTAMP
+	lib_sprintf(stream, "[%4d.%4d] ", rec->msec / 1000, (rec->msec % 1000) * 10);
+#endif
+
+	if (rec->flags & LOGM_BINREC_TEXT) {
+		for (text = (const char *)rec + LOGM_BIN_HDRSIZE; *text; text++) {
+			stream->put(stream, *text);
+		}
+	} else {
+		logm_bin_format(stream, rec);
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Splits the logm buffer into the rings: LOGM_BIN_URGENT_PERCENT of it for
+ * errors and warnings, the rest for other messages.
+ */
+
+void logm_bin_init(char *buf, int bufsize)
+{
+	uint32_t urgent = ((int64_t)bufsize * LOGM_BIN_URGENT_PERCENT / 100) & ~3;
+
+	memset(g_logm_binring, 0, sizeof(g_logm_binring));
+	memset(buf, 0, bufsize);
+
+	g_logm_binring[LOGM_BIN_URGENT].buf = (uint8_t *)buf;
+	g_logm_binring[LOGM_BIN_URGENT].size = urgent;
+	g_logm_binring[LOGM_BIN_NORMAL].buf = (uint8_t *)buf + urgent;
+	g_logm_binring[LOGM_BIN_NORMAL].size = (bufsize - urgent) & ~3;
+}
+
+/* Writes a binary record of fmt and its arguments. Returns the size of the
+ * record, or ERROR if logm is not ready. A record which doesn't fit in its
+ * ring is dropped and counted. The arguments are packed on the stack first
+ * so that the format is parsed once, before the record is reserved.
+ */
+
+int logm_bin_record(int priority, const char *fmt, va_list ap)
+{
+	struct logm_binring_s *ring = &g_logm_binring[LOGM_BIN_RING(priority)];
+	struct logm_binrec_s *rec;
+	uint32_t args[LOGM_BIN_ARGMAX / 4];
+	uint8_t flags = 0;
+	int len;
+
+	len = logm_bin_pack((uint8_t *)args, fmt, ap, &flags);
+
+	if (logm_bin_enter() != OK) {
+		return ERROR;
+	}
+
+	rec = logm_bin_reserve(ring, LOGM_BIN_HDRSIZE + len, priority);
+	if (rec == NULL) {
+		logm_bin_leave();
+		return 0;
+	}
+
+	rec->fmt = fmt;
+	memcpy((uint8_t *)rec + LOGM_BIN_HDRSIZE, args, len);
+	logm_bin_commit(rec, flags);
+
+	logm_bin_leave();
+	return LOGM_BIN_HDRSIZE + len;
+}
+
+/* Writes a record of the text formatted at once, for printf and syslog
+ * whose format may not live as long as the record. Returns the length of
+ * the text, or ERROR if logm is not ready.
+ */
+
+int logm_bin_text(int priority, const char *fmt, va_list ap)
+{
+	struct logm_binring_s *ring = &g_logm_binring[LOGM_BIN_RING(priority)];
+	struct logm_binrec_s *rec;
+	struct lib_outstream_s nullstrm;
+	struct lib_memoutstream_s memstrm;
+	va_list ap2;
+	int len;
+
+	if (logm_bin_enter() != OK) {
+		return ERROR;
+	}
+
+	lib_nulloutstream(&nullstrm);
+	va_copy(ap2, ap);
+	(void)lib_vsprintf(&nullstrm, fmt, ap2);
+	va_end(ap2);
+
+	len = nullstrm.nput;
+	if (LOGM_BIN_HDRSIZE + len + 1 > LOGM_BIN_RECMAX) {
+		len = LOGM_BIN_RECMAX - LOGM_BIN_HDRSIZE - 1;
+	}
+
+	rec = logm_bin_reserve(ring, LOGM_BIN_HDRSIZE + LOGM_BIN_ALIGN(len + 1), priority);
+	if (rec == NULL) {
+		logm_bin_leave();
+		return 0;
+	}
+
+	rec->fmt = NULL;
+	lib_memoutstream(&memstrm, (char *)rec + LOGM_BIN_HDRSIZE, len + 1);
+	(void)lib_vsprintf(&memstrm.public, fmt, ap);
+	logm_bin_commit(rec, LOGM_BINREC_TEXT);
+
+	logm_bin_leave();
+	return len;
+}
+
+/* Prints the committed records of all rings in sequence order. Nothing is
+ * done if another consumer is printing them.
+ */
+
+void logm_bin_flush(struct lib_outstream_s *stream)
+{
+	struct logm_binrec_s *rec;
+	struct logm_binrec_s *oldest;
+	int oldest_ring = 0;
+	uint32_t dropped;
+	int i;
+
+	if (__atomic_exchange_n(&g_logm_bindraining, 1, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	for (;;) {
+		oldest = NULL;
+		for (i = 0; i < LOGM_BIN_NRINGS; i++) {
+			rec = logm_bin_peek(&g_logm_binring[i]);
+			if (rec && (oldest == NULL || (int32_t)(rec->seq - oldest->seq) < 0)) {
+				oldest = rec;
+				oldest_ring = i;
+			}
+		}
+		if (oldest == NULL) {
+			break;
+		}
+		logm_bin_print(stream, oldest);
+		logm_bin_consume(&g_logm_binring[oldest_ring], oldest);
+	}
+
+	for (i = 0; i < LOGM_BIN_NRINGS; i++) {
+		dropped = __atomic_exchange_n(&g_logm_binring[i].dropped, 0, __ATOMIC_RELAXED);
+		if (dropped) {
+			lib_sprintf(stream, "\n[LOGM BUFFER OVERFLOW] %d messages are dropped\n", dropped);
+		}
+	}
+
+	__atomic_store_n(&g_logm_bindraining, 0, __ATOMIC_RELEASE);
+}
+
+/* Waits until no one uses the rings, LOGM_BUFFER_RESIZE_REQ being set so
+ * that new writers give up. Returns OK with the rings to be released by
+ * logm_bin_resume(), or ERROR if they are still used after
+ * LOGM_BIN_QUIESCE_MSEC.
+ */
+
+int logm_bin_quiesce(void)
+{
+	int msec = 0;
+
+	while (__atomic_exchange_n(&g_logm_bindraining, 1, __ATOMIC_ACQUIRE)) {
+		if (msec++ >= LOGM_BIN_QUIESCE_MSEC) {
+			return ERROR;
+		}
+		usleep(1000);
+	}
+	while (__atomic_load_n(&g_logm_binwriters, __ATOMIC_SEQ_CST)) {
+		if (msec++ >= LOGM_BIN_QUIESCE_MSEC) {
+			logm_bin_resume();
+			return ERROR;
+		}
+		usleep(1000);
+	}
+	return OK;
+}
+
+void logm_bin_resume(void)
+{
+	__atomic_store_n(&g_logm_bindraining, 0, __ATOMIC_RELEASE);
+}
@@ -22,6 +22,9 @@
 #include <sys/types.h>
 #include <arch/irq.h>
 #include <tinyara/logm.h>
+#ifdef CONFIG_LOGM_BINARY
+#include <tinyara/streams.h>
+#endif
 #include <tinyara/config.h>
 #include "logm.h"
 #ifdef CONFIG_LOGM_TEST
@@ -50,6 +53,10 @@ static int logm_change_bufsize(int buflen)
 	g_logm_rsvbuf = new_g_logm_rsvbuf;
 	memset(g_logm_rsvbuf, 0, buflen);
 
+#ifdef CONFIG_LOGM_BINARY
+	logm_bin_init(g_logm_rsvbuf, buflen);
+#endif
+
 	/* Reinitialize all  */
 	g_logm_head = 0;
 	g_logm_tail = 0;
@@ -65,9 +72,17 @@ static int logm_change_bufsize(int buflen)
 int logm_task(int argc, char *argv[])
 {
 	irqstate_t flags;
+#ifdef CONFIG_LOGM_BINARY
+	struct lib_stdoutstream_s strm;
+
+	lib_stdoutstream(&strm, stdout);
+#endif
 
 	g_logm_rsvbuf = (char *)malloc(logm_bufsize);
 	memset(g_logm_rsvbuf, 0, logm_bufsize);
+#ifdef CONFIG_LOGM_BINARY
+	logm_bin_init(g_logm_rsvbuf, logm_bufsize);
+#endif
 
 	/* Now logm is ready */
 	LOGM_STATUS_SET(LOGM_READY);
@@ -77,6 +92,9 @@ int logm_task(int argc, char *argv[])
 #endif
 
 	while (1) {
+#ifdef CONFIG_LOGM_BINARY
+		logm_bin_flush(&strm.public);
+#endif
 		while (g_logm_head != g_logm_tail) {
 			fputc(g_logm_rsvbuf[g_logm_head], stdout);
 			g_logm_head = (g_logm_head + 1) % logm_bufsize;
@@ -90,11 +108,22 @@ int logm_task(int argc, char *argv[])
 		}
 
 		if (LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ)) {
+#ifdef CONFIG_LOGM_BINARY
+			/* Binary records are written without disabling interrupts */
+			if (logm_bin_quiesce() != OK) {
+				fprintf(stdout, "\n[LOGM] Failed to change buffer size\n");
+				LOGM_STATUS_CLEAR(LOGM_BUFFER_RESIZE_REQ);
+				continue;
+			}
+#endif
 			flags = irqsave();
 			if (logm_change_bufsize(new_logm_bufsize) != OK) {
 				fprintf(stdout, "\n[LOGM] Failed to change buffer size\n");
 			}
 			irqrestore(flags);
+#ifdef CONFIG_LOGM_BINARY
+			logm_bin_resume();
+#endif
 		}
 		usleep(logm_print_interval);
 	}
@@ -113,6 +113,13 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 		return;
 	}
 
+#ifdef CONFIG_MM_SLAB
+	if (MM_IS_SLAB((char *)mem - SIZEOF_MM_ALLOCNODE)) {
+		mm_slab_free(heap, (FAR struct mm_allocnode_s *)((char *)mem - SIZEOF_MM_ALLOCNODE));
+		return;
+	}
+#endif
+
 	/* We need to hold the MM semaphore while we muck with the
 	 * nodelist.
 	 */
@@ -165,7 +172,7 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 		 * but there may not be a successor node.
 		 */
 
-		REMOVE_NODE_FROM_LIST(next);
+		REMOVE_NODE_FROM_LIST(heap, next);
 
 		/* Then merge the two chunks */
 
@@ -184,7 +191,7 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 		 * not be a successor node.
 		 */
 
-		REMOVE_NODE_FROM_LIST(prev);
+		REMOVE_NODE_FROM_LIST(heap, prev);
 
 		/* Then merge the two chunks */
 
@@ -116,8 +116,14 @@ void heapinfo_parse(FAR struct mm_heap_s *heap, int mode, pid_t pid)
 
 #ifdef CONFIG_DEBUG_CHECK_FRAGMENTATION
 	int ndx;
+#ifdef CONFIG_MM_TLSF
+	int sl;
+	int nodelist_cnt[MM_TLSF_FLI] = {0, };
+	size_t nodelist_size[MM_TLSF_FLI] = {0, };
+#else
 	int nodelist_cnt[MM_NNODES] = {0, };
 	size_t nodelist_size[MM_NNODES] = {0, };
+#endif
 	FAR struct mm_freenode_s *fnode;
 #endif
 
@@ -245,11 +251,31 @@ void heapinfo_parse(FAR struct mm_heap_s *heap, int mode, pid_t pid)
 	printf("(**) Only Idle task has a separate stack region,\n");
 	printf("  rest are all allocated on the heap region.\n");
 
+#ifdef CONFIG_MM_SLAB
+	mm_slab_heapinfo(heap);
+#endif
+
 #ifdef CONFIG_DEBUG_CHECK_FRAGMENTATION
 	printf("\nAvailable fragmented memory segments in heap memory\n");
 
 	mm_takesemaphore(heap);
 
+#ifdef CONFIG_MM_TLSF
+	for (ndx = 0; ndx < MM_TLSF_FLI; ++ndx) {
+		for (sl = 0; sl < MM_TLSF_SLI; ++sl) {
+			for (fnode = heap->mm_freelist[ndx][sl]; fnode; fnode = fnode->flink) {
+				++nodelist_cnt[ndx];
+				nodelist_size[ndx] += fnode->size;
+			}
+		}
+	}
+
+	mm_givesemaphore(heap);
+
+	for (ndx = 0; ndx < MM_TLSF_FLI; ++ndx) {
+		printf("Freelist[%d] ranging [%u, %u] : num %d, size %u [Bytes]\n", ndx, (ndx > 0 ? (1 << (ndx + MM_TLSF_FLI_SHIFT - 1)) : 0), (1 << (ndx + MM_TLSF_FLI_SHIFT)) - 1, nodelist_cnt[ndx], nodelist_size[ndx]);
+	}
+#else
 	for (ndx = 0; ndx < MM_NNODES; ++ndx) {
 		for (fnode = heap->mm_nodelist[ndx].flink; fnode && fnode->size; fnode = fnode->flink) {
 			++nodelist_cnt[ndx];
@@ -262,6 +288,7 @@ void heapinfo_parse(FAR struct mm_heap_s *heap, int mode, pid_t pid)
 	for (ndx = 0; ndx < MM_NNODES; ++ndx) {
 		printf("Nodelist[%d] ranging [%u, %u] : num %d, size %u [Bytes]\n", ndx, ((ndx > 0 ? (1 << (ndx + MM_MIN_SHIFT)) : 0) + 1), 1 << (ndx + MM_MIN_SHIFT + 1), nodelist_cnt[ndx], nodelist_size[ndx]);
 	}
+#endif
 #endif
 
 	if (mode != HEAPINFO_SIMPLE) {
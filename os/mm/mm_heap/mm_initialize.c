@@ -220,7 +220,11 @@ void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heaps
 
 	/* Initialize the node array */
 
+#ifdef CONFIG_MM_TLSF
+	mm_tlsf_initialize(heap);
+#else
 	memset(heap->mm_nodelist, 0, sizeof(struct mm_freenode_s) * (MM_NNODES + 1));
+#endif
 
 	/* Initialize the malloc semaphore to one (to support one-at-
 	 * a-time access to private data sets).
@@ -228,6 +232,10 @@ void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heaps
 
 	mm_seminitialize(heap);
 
+#ifdef CONFIG_MM_SLAB
+	mm_slab_initialize(heap);
+#endif
+
 	/* Add the initial region of memory to the heap */
 
 	mm_addregion(heap, heapstart, heapsize);
@@ -111,7 +111,9 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 {
 	FAR struct mm_freenode_s *node;
 	void *ret = NULL;
+#ifndef CONFIG_MM_TLSF
 	int ndx;
+#endif
 
 	/* Handle bad sizes */
 
@@ -126,6 +128,24 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 		return NULL;
 	}
 
+#ifdef CONFIG_MM_SLAB
+	/* Small requests are served by the slab front-end, falling back to the
+	 * nodelist if no slab page can be allocated.
+	 */
+
+	if (size <= MM_SLAB_MAXSIZE) {
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+		ret = mm_slab_malloc(heap, size, caller_retaddr);
+#else
+		ret = mm_slab_malloc(heap, size);
+#endif
+		if (ret) {
+			mvdbg("Allocated %p, size %u from slab\n", ret, size);
+			return ret;
+		}
+	}
+#endif
+
 	/* Adjust the size to account for (1) the size of the allocated node and
 	 * (2) to make sure that it is an even multiple of our granule size.
 	 */
@@ -136,6 +156,13 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
 	mm_takesemaphore(heap);
 
+#ifdef CONFIG_MM_TLSF
+	/* Get the first chunk of the smallest non-empty list of chunks large
+	 * enough, without walking any list.
+	 */
+
+	node = mm_tlsf_findchunk(heap, size);
+#else
 	/* Get the location in the node list to start the search
 	 * by converting the request size into a nodelist index.
 	 */
@@ -159,13 +186,14 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 	if (!(node && node->size == size)) {
 		node = prev;
 	}
+#endif
 
 	/* If we found a node with non-zero size, then this is one to use. Since
 	 * the list is ordered, we know that is must be best fitting chunk
 	 * available.
 	 */
 
-	if (node->size) {
+	if (node && node->size) {
 		FAR struct mm_freenode_s *remainder;
 		FAR struct mm_freenode_s *next;
 		size_t remaining;
@@ -174,7 +202,7 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 		 * a successor node.
 		 */
 
-		REMOVE_NODE_FROM_LIST(node);
+		REMOVE_NODE_FROM_LIST(heap, node);
 
 		/* Check if we have to split the free node into one of the allocated
 		 * size and another smaller freenode.  In some cases, the remaining
@@ -224,6 +252,20 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
 	mm_givesemaphore(heap);
 
+#ifdef CONFIG_MM_SLAB
+	/* Chunks cached by exited tasks may hold slab pages, retry after giving
+	 * them back.  The retry doesn't recurse as there is nothing to reclaim.
+	 */
+
+	if (!ret && mm_slab_reclaim(heap) > 0) {
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+		return mm_malloc(heap, size - SIZEOF_MM_ALLOCNODE, caller_retaddr);
+#else
+		return mm_malloc(heap, size - SIZEOF_MM_ALLOCNODE);
+#endif
+	}
+#endif
+
 	/* If CONFIG_DEBUG_MM is defined, then output the result of the allocation
 	 * to the SYSLOG.
 	 */
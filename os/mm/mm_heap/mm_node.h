@@ -29,7 +29,14 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define REMOVE_NODE_FROM_LIST(node)				\
+/* Remove a free node from the free list of the heap.  The size of the node
+ * must not be changed while it is in the list.
+ */
+
+#ifdef CONFIG_MM_TLSF
+#define REMOVE_NODE_FROM_LIST(heap, node) mm_tlsf_removechunk(heap, node)
+#else
+#define REMOVE_NODE_FROM_LIST(heap, node)			\
 	do {							\
 		DEBUGASSERT((node)->blink);			\
 		(node)->blink->flink = (node)->flink;		\
@@ -37,6 +44,7 @@
 			(node)->flink->blink = (node)->blink;	\
 		}						\
 	} while (0)
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -146,6 +146,28 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 
 	oldnode = (FAR struct mm_allocnode_s *)((FAR char *)oldmem - SIZEOF_MM_ALLOCNODE);
 
+#ifdef CONFIG_MM_SLAB
+	/* A slab chunk can't be resized, keep it if the new size still fits */
+
+	if (MM_IS_SLAB(oldnode)) {
+		oldsize = (oldnode->size & ~MM_SLAB_BIT) - SIZEOF_MM_ALLOCNODE;
+		if (size <= oldsize) {
+			return oldmem;
+		}
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+		newmem = mm_malloc(heap, size, caller_retaddr);
+#else
+		newmem = mm_malloc(heap, size);
+#endif
+		if (newmem) {
+			memcpy(newmem, oldmem, oldsize);
+			mm_free(heap, oldmem);
+		}
+		return newmem;
+	}
+#endif
+
 	/* We need to hold the MM semaphore while we muck with the nodelist. */
 
 	mm_takesemaphore(heap);
@@ -267,7 +289,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 			 * there may not be a successor node.
 			 */
 
-			REMOVE_NODE_FROM_LIST(prev);
+			REMOVE_NODE_FROM_LIST(heap, prev);
 
 			/* Extend the node into the previous free chunk */
 			/* Did we consume the entire preceding chunk? */
@@ -321,7 +343,7 @@ FAR void *mm_realloc(FAR struct mm_heap_s *heap, FAR void *oldmem, size_t size)
 			 * may not be a successor node.
 			 */
 
-			REMOVE_NODE_FROM_LIST(next);
+			REMOVE_NODE_FROM_LIST(heap, next);
 
 			/* Extend the node into the next chunk */
 			/* Did we consume the entire preceding chunk? */
@@ -0,0 +1,609 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_slab.c
+ *
+ * Size class front-end of the heap for small allocations.
+ *
+ * Each size class owns slab pages, which are allocated from the heap like
+ * any other chunk and split into equal sized slab chunks.  Free slab chunks
+ * are kept in the pages, protected by the heap semaphore, and in per-task
+ * magazines.  Magazines of a task are in the cache indexed by the PIDHASH
+ * of the task and only the owner touches them, so allocating from and
+ * freeing into them is lock-free.  The heap semaphore is taken only to move
+ * a batch of chunks between the pages and a magazine which is empty or
+ * full, and when a task takes over a cache.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sched.h>
+#include <unistd.h>
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+#include <stdio.h>
+#endif
+
+#include <tinyara/sched.h>
+#include <tinyara/mm/mm.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_MM_SLAB_PAGESIZE
+#define CONFIG_MM_SLAB_PAGESIZE 1024
+#endif
+
+#ifndef CONFIG_MM_SLAB_MAGAZINE
+#define CONFIG_MM_SLAB_MAGAZINE 8
+#endif
+
+/* Chunks moved between the pages and a magazine at once */
+
+#if CONFIG_MM_SLAB_MAGAZINE > 1
+#define MM_SLAB_BATCH      (CONFIG_MM_SLAB_MAGAZINE / 2)
+#else
+#define MM_SLAB_BATCH      1
+#endif
+
+/* Largest slab chunk, header included, and the least chunks in a page */
+
+#define MM_SLAB_MAXCHUNK   272
+#define MM_SLAB_MINCHUNKS  4
+
+/* Offset of the first chunk from the node of a page.  Chunk sizes are
+ * multiples of 16, so slab allocations get the alignment of the heap.
+ */
+
+#define MM_SLAB_FIRST      MM_ALIGN_UP(SIZEOF_MM_ALLOCNODE + sizeof(struct mm_slab_page_s))
+
+/* A free chunk is linked through its data */
+
+#define MM_SLAB_NEXT(n)    (*(FAR struct mm_allocnode_s **)((FAR char *)(n) + SIZEOF_MM_ALLOCNODE))
+
+#define MM_SLAB_CHUNKSIZE(n) ((size_t)((n)->size & ~MM_SLAB_BIT))
+
+#define MM_SLAB_NO_OWNER   (-1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Header at the start of the data of a slab page */
+
+struct mm_slab_page_s {
+	FAR struct mm_slab_page_s *flink;	/* Partial list of the class */
+	FAR struct mm_slab_page_s *blink;
+	FAR struct mm_allocnode_s *free;	/* Free chunks in the page */
+	uint16_t nchunks;			/* Number of chunks in the page */
+	uint16_t inuse;				/* Chunks allocated or in magazines */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Chunk size of each class, header included */
+
+static const uint16_t g_slab_chunksize[MM_SLAB_NCLASSES] = {
+	32, 48, 64, 96, 128, 176, 224, 272
+};
+
+/* Class of a chunk, indexed by its size in 16 byte units rounded up */
+
+static const uint8_t g_slab_class[(MM_SLAB_MAXCHUNK >> 4) + 1] = {
+	0, 0, 0, 1, 2, 3, 3, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 7
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static inline FAR struct mm_slab_page_s *mm_slab_page(FAR struct mm_allocnode_s *node)
+{
+	return (FAR struct mm_slab_page_s *)((FAR char *)node - (node->preceding & ~MM_ALLOC_BIT) + SIZEOF_MM_ALLOCNODE);
+}
+
+/****************************************************************************
+ * Name: mm_slab_magazine
+ *
+ * Description:
+ *   Get the magazine of the calling task.  The cache of the PIDHASH may be
+ *   left by an exited task, then the caller takes it over with the chunks
+ *   in it.  Live tasks never share a PIDHASH.
+ *
+ ****************************************************************************/
+
+static inline FAR struct mm_slab_magazine_s *mm_slab_magazine(FAR struct mm_heap_s *heap, int ndx)
+{
+	pid_t pid = getpid();
+	FAR struct mm_slab_cache_s *cache = &heap->mm_slab_cache[PIDHASH(pid)];
+
+	if (cache->owner != pid) {
+		mm_takesemaphore(heap);
+		cache->owner = pid;
+		mm_givesemaphore(heap);
+	}
+
+	return &cache->mag[ndx];
+}
+
+static size_t mm_slab_nchunks(int ndx)
+{
+	size_t nchunks = (CONFIG_MM_SLAB_PAGESIZE - MM_SLAB_FIRST) / g_slab_chunksize[ndx];
+
+	return nchunks < MM_SLAB_MINCHUNKS ? MM_SLAB_MINCHUNKS : nchunks;
+}
+
+static void mm_slab_link(FAR struct mm_slab_class_s *slab, FAR struct mm_slab_page_s *page)
+{
+	page->blink = NULL;
+	page->flink = slab->partial;
+	if (slab->partial) {
+		slab->partial->blink = page;
+	}
+	slab->partial = page;
+}
+
+static void mm_slab_unlink(FAR struct mm_slab_class_s *slab, FAR struct mm_slab_page_s *page)
+{
+	if (page->blink) {
+		page->blink->flink = page->flink;
+	} else {
+		slab->partial = page->flink;
+	}
+	if (page->flink) {
+		page->flink->blink = page->blink;
+	}
+}
+
+/****************************************************************************
+ * Name: mm_slab_newpage
+ *
+ * Description:
+ *   Allocate a page for the class from the heap and split it into chunks.
+ *   The caller holds the heap semaphore.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+static FAR struct mm_slab_page_s *mm_slab_newpage(FAR struct mm_heap_s *heap, int ndx, mmaddress_t caller_retaddr)
+#else
+static FAR struct mm_slab_page_s *mm_slab_newpage(FAR struct mm_heap_s *heap, int ndx)
+#endif
+{
+	FAR struct mm_slab_page_s *page;
+	FAR struct mm_allocnode_s *node;
+	FAR char *base;
+	size_t chunksize = g_slab_chunksize[ndx];
+	size_t nchunks = mm_slab_nchunks(ndx);
+	size_t i;
+
+	/* The page is larger than MM_SLAB_MAXSIZE, so it comes from the nodelist */
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	page = (FAR struct mm_slab_page_s *)mm_malloc(heap, MM_SLAB_FIRST + nchunks * chunksize - SIZEOF_MM_ALLOCNODE, caller_retaddr);
+#else
+	page = (FAR struct mm_slab_page_s *)mm_malloc(heap, MM_SLAB_FIRST + nchunks * chunksize - SIZEOF_MM_ALLOCNODE);
+#endif
+	if (!page) {
+		return NULL;
+	}
+
+	base = (FAR char *)page - SIZEOF_MM_ALLOCNODE;
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	/* Tasks are charged for their chunks, not for the pages */
+
+	heapinfo_subtract_size(heap, ((FAR struct mm_allocnode_s *)base)->pid, ((FAR struct mm_allocnode_s *)base)->size);
+#endif
+	page->free = NULL;
+	page->nchunks = nchunks;
+	page->inuse = 0;
+
+	/* Link the chunks in address order */
+
+	for (i = nchunks; i > 0; i--) {
+		node = (FAR struct mm_allocnode_s *)(base + MM_SLAB_FIRST + (i - 1) * chunksize);
+		node->size = chunksize | MM_SLAB_BIT;
+		node->preceding = (FAR char *)node - base;
+		MM_SLAB_NEXT(node) = page->free;
+		page->free = node;
+	}
+
+	mm_slab_link(&heap->mm_slab[ndx], page);
+	heap->mm_slab[ndx].npages++;
+
+	mvdbg("Slab page %p, %u chunks of %u\n", page, nchunks, chunksize);
+	return page;
+}
+
+/****************************************************************************
+ * Name: mm_slab_recharge
+ *
+ * Description:
+ *   Charge a page back to the task which allocated it, as mm_free()
+ *   uncharges it.  The peak of the task is left as it is.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+static void mm_slab_recharge(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	pid_t hash_pid = PIDHASH(node->pid);
+
+	if (heap->alloc_list[hash_pid].pid == node->pid) {
+		heap->alloc_list[hash_pid].curr_alloc_size += node->size;
+		heap->alloc_list[hash_pid].num_alloc_free++;
+	}
+}
+#endif
+
+/****************************************************************************
+ * Name: mm_slab_release
+ *
+ * Description:
+ *   Return a free chunk to its page.  A page with no chunk out is given
+ *   back to the heap unless it's the only partial page of the class.
+ *   The caller holds the heap semaphore.
+ *
+ ****************************************************************************/
+
+static void mm_slab_release(FAR struct mm_heap_s *heap, int ndx, FAR struct mm_allocnode_s *node)
+{
+	FAR struct mm_slab_class_s *slab = &heap->mm_slab[ndx];
+	FAR struct mm_slab_page_s *page = mm_slab_page(node);
+
+	DEBUGASSERT(page->inuse > 0);
+
+	if (!page->free) {
+		mm_slab_link(slab, page);
+	}
+	MM_SLAB_NEXT(node) = page->free;
+	page->free = node;
+
+	if (--page->inuse == 0 && (slab->partial != page || page->flink)) {
+		mm_slab_unlink(slab, page);
+		slab->npages--;
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+		mm_slab_recharge(heap, (FAR struct mm_allocnode_s *)((FAR char *)page - SIZEOF_MM_ALLOCNODE));
+#endif
+		mm_free(heap, page);
+	}
+}
+
+/****************************************************************************
+ * Name: mm_slab_refill
+ *
+ * Description:
+ *   Move a batch of free chunks from the pages into an empty magazine.
+ *   Returns the number of chunks moved, 0 if the heap is out of memory.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+static int mm_slab_refill(FAR struct mm_heap_s *heap, int ndx, FAR struct mm_slab_magazine_s *mag, mmaddress_t caller_retaddr)
+#else
+static int mm_slab_refill(FAR struct mm_heap_s *heap, int ndx, FAR struct mm_slab_magazine_s *mag)
+#endif
+{
+	FAR struct mm_slab_class_s *slab = &heap->mm_slab[ndx];
+	FAR struct mm_slab_page_s *page;
+	FAR struct mm_allocnode_s *node;
+	int count = 0;
+
+	mm_takesemaphore(heap);
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	slab->nrefill++;
+#endif
+
+	while (count < MM_SLAB_BATCH) {
+		page = slab->partial;
+		if (!page && mm_slab_reclaim(heap) > 0) {
+			page = slab->partial;
+		}
+		if (!page) {
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+			page = mm_slab_newpage(heap, ndx, caller_retaddr);
+#else
+			page = mm_slab_newpage(heap, ndx);
+#endif
+			if (!page) {
+				break;
+			}
+		}
+
+		node = page->free;
+		page->free = MM_SLAB_NEXT(node);
+		page->inuse++;
+		if (!page->free) {
+			mm_slab_unlink(slab, page);
+		}
+
+		MM_SLAB_NEXT(node) = mag->head;
+		mag->head = node;
+		mag->count++;
+		count++;
+	}
+
+	mm_givesemaphore(heap);
+	return count;
+}
+
+/****************************************************************************
+ * Name: mm_slab_flush
+ *
+ * Description:
+ *   Move free chunks from a magazine back to their pages.
+ *
+ ****************************************************************************/
+
+static void mm_slab_flush(FAR struct mm_heap_s *heap, int ndx, FAR struct mm_slab_magazine_s *mag, int nchunks)
+{
+	FAR struct mm_allocnode_s *node;
+	int count;
+
+	mm_takesemaphore(heap);
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	heap->mm_slab[ndx].nflush++;
+#endif
+
+	for (count = 0; count < nchunks && mag->head; count++) {
+		node = mag->head;
+		mag->head = MM_SLAB_NEXT(node);
+		mag->count--;
+		mm_slab_release(heap, ndx, node);
+	}
+
+	mm_givesemaphore(heap);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_slab_initialize
+ *
+ * Description:
+ *   Initialize the size classes and magazines of the heap.
+ *
+ ****************************************************************************/
+
+void mm_slab_initialize(FAR struct mm_heap_s *heap)
+{
+	int i;
+
+	/* A free chunk links to the next one right after its header */
+
+	DEBUGASSERT(g_slab_chunksize[0] >= SIZEOF_MM_ALLOCNODE + sizeof(FAR struct mm_allocnode_s *));
+
+	memset(heap->mm_slab, 0, sizeof(heap->mm_slab));
+	memset(heap->mm_slab_cache, 0, sizeof(heap->mm_slab_cache));
+	for (i = 0; i < CONFIG_MAX_TASKS; i++) {
+		heap->mm_slab_cache[i].owner = MM_SLAB_NO_OWNER;
+	}
+}
+
+/****************************************************************************
+ * Name: mm_slab_malloc
+ *
+ * Description:
+ *   Allocate a chunk for a request of at most MM_SLAB_MAXSIZE bytes from
+ *   the magazine of the calling task.  Returns NULL if no slab page can be
+ *   allocated, then the caller falls back to the nodelist.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+FAR void *mm_slab_malloc(FAR struct mm_heap_s *heap, size_t size, mmaddress_t caller_retaddr)
+#else
+FAR void *mm_slab_malloc(FAR struct mm_heap_s *heap, size_t size)
+#endif
+{
+	FAR struct mm_slab_magazine_s *mag;
+	FAR struct mm_allocnode_s *node;
+	size_t chunksize = size + SIZEOF_MM_ALLOCNODE;
+	int ndx;
+
+	if (chunksize > MM_SLAB_MAXCHUNK) {
+		return NULL;
+	}
+
+	ndx = g_slab_class[(chunksize + 15) >> 4];
+	mag = mm_slab_magazine(heap, ndx);
+
+	if (!mag->head) {
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+		if (mm_slab_refill(heap, ndx, mag, caller_retaddr) == 0) {
+#else
+		if (mm_slab_refill(heap, ndx, mag) == 0) {
+#endif
+			return NULL;
+		}
+	}
+
+	node = mag->head;
+	mag->head = MM_SLAB_NEXT(node);
+	mag->count--;
+
+	node->preceding |= MM_ALLOC_BIT;
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	/* Counters of the task may be updated by other tasks freeing its chunks */
+
+	mm_takesemaphore(heap);
+	heapinfo_update_node(node, caller_retaddr);
+	heapinfo_add_size(heap, node->pid, MM_SLAB_CHUNKSIZE(node));
+	mm_givesemaphore(heap);
+	mag->nalloc++;
+#endif
+
+	return (FAR char *)node + SIZEOF_MM_ALLOCNODE;
+}
+
+/****************************************************************************
+ * Name: mm_slab_free
+ *
+ * Description:
+ *   Put a slab chunk into the magazine of the calling task.  If the
+ *   magazine is full, half of it goes back to the pages first.
+ *
+ ****************************************************************************/
+
+void mm_slab_free(FAR struct mm_heap_s *heap, FAR struct mm_allocnode_s *node)
+{
+	FAR struct mm_slab_magazine_s *mag;
+	int ndx;
+
+	DEBUGASSERT(MM_SLAB_CHUNKSIZE(node) <= MM_SLAB_MAXCHUNK);
+
+#ifdef CONFIG_DEBUG_DOUBLE_FREE
+	if ((node->preceding & MM_ALLOC_BIT) != MM_ALLOC_BIT) {
+		dbg("Attempt for double freeing a pointer or releasing an unallocated pointer\n");
+		PANIC();
+	}
+#endif
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+	mm_takesemaphore(heap);
+	heapinfo_subtract_size(heap, node->pid, MM_SLAB_CHUNKSIZE(node));
+	mm_givesemaphore(heap);
+#endif
+
+	node->preceding &= ~MM_ALLOC_BIT;
+
+	ndx = g_slab_class[MM_SLAB_CHUNKSIZE(node) >> 4];
+	mag = mm_slab_magazine(heap, ndx);
+
+	if (mag->count >= CONFIG_MM_SLAB_MAGAZINE) {
+		mm_slab_flush(heap, ndx, mag, MM_SLAB_BATCH);
+	}
+
+	MM_SLAB_NEXT(node) = mag->head;
+	mag->head = node;
+	mag->count++;
+}
+
+/****************************************************************************
+ * Name: mm_slab_reclaim
+ *
+ * Description:
+ *   Flush the caches left by exited tasks, so that slab pages held only by
+ *   their chunks are given back to the heap.  A new task with the same
+ *   PIDHASH takes over a cache with the heap semaphore held, so it can't
+ *   touch a cache while it's flushed.  Returns the number of caches flushed.
+ *
+ ****************************************************************************/
+
+int mm_slab_reclaim(FAR struct mm_heap_s *heap)
+{
+	FAR struct mm_slab_cache_s *cache;
+	struct sched_param param;
+	pid_t pid = getpid();
+	int nflushed = 0;
+	int ndx;
+	int i;
+
+	mm_takesemaphore(heap);
+
+	for (i = 0; i < CONFIG_MAX_TASKS; i++) {
+		cache = &heap->mm_slab_cache[i];
+		if (cache->owner == MM_SLAB_NO_OWNER || cache->owner == pid || sched_getparam(cache->owner, &param) == OK) {
+			continue;
+		}
+
+		for (ndx = 0; ndx < MM_SLAB_NCLASSES; ndx++) {
+			if (cache->mag[ndx].head) {
+				mm_slab_flush(heap, ndx, &cache->mag[ndx], CONFIG_MM_SLAB_MAGAZINE);
+			}
+		}
+		cache->owner = MM_SLAB_NO_OWNER;
+		nflushed++;
+	}
+
+	mm_givesemaphore(heap);
+	return nflushed;
+}
+
+/****************************************************************************
+ * Name: mm_slab_heapinfo
+ *
+ * Description:
+ *   Print usage of the slab pages per size class.  Counters of magazines
+ *   are read without locking, so they are a snapshot at best.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_DEBUG_MM_HEAPINFO
+void mm_slab_heapinfo(FAR struct mm_heap_s *heap)
+{
+	FAR struct mm_slab_class_s *slab;
+	FAR struct mm_slab_page_s *page;
+	uint32_t nalloc;
+	unsigned int total;
+	unsigned int nfree;
+	unsigned int cached;
+	unsigned int pagebytes = 0;
+	unsigned int usedbytes = 0;
+	int ndx;
+	int i;
+
+	printf("\n< Slab >\n");
+	printf(" Chunk | Pages | Chunks |  Free  | Cached | Allocs   | Refills  | Flushes\n");
+	printf("-------|-------|--------|--------|--------|----------|----------|---------\n");
+
+	for (ndx = 0; ndx < MM_SLAB_NCLASSES; ndx++) {
+		slab = &heap->mm_slab[ndx];
+
+		nalloc = 0;
+		cached = 0;
+		for (i = 0; i < CONFIG_MAX_TASKS; i++) {
+			nalloc += heap->mm_slab_cache[i].mag[ndx].nalloc;
+			cached += heap->mm_slab_cache[i].mag[ndx].count;
+		}
+
+		mm_takesemaphore(heap);
+		total = slab->npages * mm_slab_nchunks(ndx);
+		nfree = 0;
+		for (page = slab->partial; page; page = page->flink) {
+			nfree += page->nchunks - page->inuse;
+		}
+		mm_givesemaphore(heap);
+
+		pagebytes += MM_SLAB_FIRST * slab->npages + total * g_slab_chunksize[ndx];
+		usedbytes += (total - nfree - cached) * g_slab_chunksize[ndx];
+
+		printf(" %5u | %5u | %6u | %6u | %6u | %8u | %8u | %8u\n", g_slab_chunksize[ndx], slab->npages,
+			total, nfree, cached, nalloc, slab->nrefill, slab->nflush);
+	}
+
+	printf("  - Slab pages / Allocated chunks : %u / %u (%d%%)\n", pagebytes, usedbytes,
+		pagebytes ? (int)((uint64_t)usedbytes * 100 / pagebytes) : 0);
+	printf("** Free chunks are in pages, Cached ones in magazines of tasks.\n");
+	printf("   Allocs - Refills is the number of allocations without locking the heap.\n");
+}
+#endif
@@ -0,0 +1,216 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_tlsf.c
+ *
+ * Free lists of the two-level segregated fit (TLSF) backend.
+ *
+ * Chunks keep the same layout as with the best-fit backend, so splitting
+ * and merging of neighbor chunks is shared.  Only the way free chunks are
+ * kept differs: instead of a few ordered lists which are walked to insert
+ * or find a chunk, each free chunk goes at the head of the list of its
+ * size range, and a large enough chunk is found with two bitmap searches.
+ * All of them take constant time, independent of the heap fragmentation.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <tinyara/mm/mm.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Index of the most and least significant bit set of a non-zero word */
+
+#define MM_TLSF_FLS(x)  (31 - __builtin_clz((uint32_t)(x)))
+#define MM_TLSF_FFS(x)  (__builtin_ctz((uint32_t)(x)))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_tlsf_mapping
+ *
+ * Description:
+ *   Get the indexes of the list holding chunks of the size.
+ *
+ ****************************************************************************/
+
+static inline void mm_tlsf_mapping(size_t size, FAR int *fl, FAR int *sl)
+{
+	int msb;
+
+	DEBUGASSERT(size <= UINT32_MAX);
+
+	if (size < MM_TLSF_SMALL) {
+		*fl = 0;
+		*sl = size >> MM_MIN_SHIFT;
+	} else {
+		msb = MM_TLSF_FLS(size);
+		*fl = msb - MM_TLSF_FLI_SHIFT + 1;
+		*sl = (size >> (msb - MM_TLSF_SLI_SHIFT)) - MM_TLSF_SLI;
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_tlsf_initialize
+ *
+ * Description:
+ *   Empty all free lists of the heap.
+ *
+ ****************************************************************************/
+
+void mm_tlsf_initialize(FAR struct mm_heap_s *heap)
+{
+	heap->mm_fl_bitmap = 0;
+	memset(heap->mm_sl_bitmap, 0, sizeof(heap->mm_sl_bitmap));
+	memset(heap->mm_freelist, 0, sizeof(heap->mm_freelist));
+}
+
+/****************************************************************************
+ * Name: mm_addfreechunk
+ *
+ * Description:
+ *   Add a free chunk to the head of the list of its size.  It is assumed
+ *   that the caller holds the mm semaphore
+ *
+ ****************************************************************************/
+
+void mm_addfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	FAR struct mm_freenode_s *head;
+	int fl;
+	int sl;
+
+	mm_tlsf_mapping(node->size, &fl, &sl);
+
+	head = heap->mm_freelist[fl][sl];
+	node->blink = NULL;
+	node->flink = head;
+	if (head) {
+		head->blink = node;
+	}
+	heap->mm_freelist[fl][sl] = node;
+
+	heap->mm_fl_bitmap |= 1 << fl;
+	heap->mm_sl_bitmap[fl] |= 1 << sl;
+}
+
+/****************************************************************************
+ * Name: mm_tlsf_removechunk
+ *
+ * Description:
+ *   Remove a free chunk from its list.  It is assumed that the caller holds
+ *   the mm semaphore
+ *
+ ****************************************************************************/
+
+void mm_tlsf_removechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	int fl;
+	int sl;
+
+	mm_tlsf_mapping(node->size, &fl, &sl);
+
+	if (node->blink) {
+		node->blink->flink = node->flink;
+	} else {
+		DEBUGASSERT(heap->mm_freelist[fl][sl] == node);
+		heap->mm_freelist[fl][sl] = node->flink;
+	}
+
+	if (node->flink) {
+		node->flink->blink = node->blink;
+	}
+
+	if (!heap->mm_freelist[fl][sl]) {
+		heap->mm_sl_bitmap[fl] &= ~(1 << sl);
+		if (!heap->mm_sl_bitmap[fl]) {
+			heap->mm_fl_bitmap &= ~(1 << fl);
+		}
+	}
+}
+
+/****************************************************************************
+ * Name: mm_tlsf_findchunk
+ *
+ * Description:
+ *   Find a free chunk of at least the size, which includes the size of the
+ *   allocnode.  The size is rounded up to the next list, so that any chunk
+ *   of the list found is large enough.  The chunk stays in the list.
+ *   It is assumed that the caller holds the mm semaphore
+ *
+ * Return Value:
+ *   The free chunk, NULL if there is no chunk large enough.
+ *
+ ****************************************************************************/
+
+FAR struct mm_freenode_s *mm_tlsf_findchunk(FAR struct mm_heap_s *heap, size_t size)
+{
+	FAR struct mm_freenode_s *node;
+	uint32_t fl_map;
+	uint32_t sl_map;
+	size_t rounded = size;
+	int fl;
+	int sl;
+
+	if (size >= MM_TLSF_SMALL) {
+		rounded += (1 << (MM_TLSF_FLS(size) - MM_TLSF_SLI_SHIFT)) - 1;
+	}
+
+	mm_tlsf_mapping(rounded, &fl, &sl);
+
+	if (fl < MM_TLSF_FLI) {
+		sl_map = heap->mm_sl_bitmap[fl] & (~0U << sl);
+		if (!sl_map) {
+			fl_map = fl + 1 < MM_TLSF_FLI ? heap->mm_fl_bitmap & (~0U << (fl + 1)) : 0;
+			if (fl_map) {
+				fl = MM_TLSF_FFS(fl_map);
+				sl_map = heap->mm_sl_bitmap[fl];
+			}
+		}
+
+		if (sl_map) {
+			return heap->mm_freelist[fl][MM_TLSF_FFS(sl_map)];
+		}
+	}
+
+	/* There is no larger list, but the first chunk of the list of the size
+	 * itself may still be large enough.
+	 */
+
+	mm_tlsf_mapping(size, &fl, &sl);
+	node = heap->mm_freelist[fl][sl];
+
+	return node && node->size >= size ? node : NULL;
+}
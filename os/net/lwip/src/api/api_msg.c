@@ -358,6 +358,9 @@ static err_t sent_tcp(void *arg, struct tcp_pcb *pcb, u16_t len)
 	LWIP_ASSERT("conn != NULL", (conn != NULL));
 
 	if (conn) {
+#if LWIP_SOCKET_ZEROCOPY
+		API_EVENT(conn, NETCONN_EVT_SENT, len);
+#endif							/* LWIP_SOCKET_ZEROCOPY */
 		if (conn->state == NETCONN_WRITE) {
 			lwip_netconn_do_writemore(conn WRITE_DELAYED);
 		} else if (conn->state == NETCONN_CLOSE) {
@@ -413,6 +416,10 @@ static void err_tcp(void *arg, err_t err)
 	   They will get an error if they actually try to read or write. */
 	API_EVENT(conn, NETCONN_EVT_RCVPLUS, 0);
 	API_EVENT(conn, NETCONN_EVT_SENDPLUS, 0);
+#if LWIP_SOCKET_ZEROCOPY
+	/* The segments were freed with the pcb */
+	API_EVENT(conn, NETCONN_EVT_SENT, 0);
+#endif							/* LWIP_SOCKET_ZEROCOPY */
 
 	/* pass NULL-message to recvmbox to wake up pending recv */
 	if (sys_mbox_valid(&conn->recvmbox)) {
@@ -93,6 +93,9 @@
 #include "lwip/udp.h"
 #include "lwip/priv/tcpip_priv.h"
 #include "lwip/ip_addr.h"
+#if LWIP_SOCKET_ZEROCOPY
+#include "lwip/priv/tcp_priv.h"
+#endif
 
 #if LWIP_CHECKSUM_ON_COPY
 #include "lwip/inet_chksum.h"
@@ -342,6 +345,34 @@ static void lwip_setsockopt_callback(void *arg);
 static u8_t lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *optlen);
 static u8_t lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_t optlen);
 
+#if LWIP_SOCKET_ZEROCOPY
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "LWIP_SOCKET_ZEROCOPY needs LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+
+/** Data sent by lwip_send_ref(), referenced by the stack */
+struct lwip_sock_ref {
+	/** UDP and RAW: the pbuf referencing the data, must be first */
+	struct pbuf_custom pc;
+	/** TCP: data sent next on the same socket */
+	struct lwip_sock_ref *next;
+	/** TCP: sequence number following the data */
+	u32_t seqno;
+	lwip_sent_fn sent;
+	void *arg;
+};
+
+/** Argument of lwip_sock_ref_call() */
+struct lwip_sock_ref_call_data {
+	struct tcpip_api_call_data call;
+	struct lwip_sock *sock;
+	u8_t abort;
+};
+
+static void lwip_sock_ref_acked(struct lwip_sock *sock, struct tcp_pcb *pcb);
+static void lwip_sock_ref_close(struct lwip_sock *sock);
+#endif							/* LWIP_SOCKET_ZEROCOPY */
+
 #if LWIP_IPV4 && LWIP_IPV6
 void sockaddr_to_ipaddr_port(const struct sockaddr *sockaddr, ip_addr_t *ipaddr, u16_t *port)
 {
@@ -474,6 +505,12 @@ int alloc_socket(struct netconn *newconn, int accepted)
 			sockets[i].sendevent = (NETCONNTYPE_GROUP(newconn->type) == NETCONN_TCP ? (accepted != 0) : 1);
 			sockets[i].errevent = 0;
 			sockets[i].err = 0;
+#if LWIP_SOCKET_ZEROCOPY
+			sockets[i].refs = NULL;
+			sockets[i].lastref = NULL;
+			sockets[i].refwrites = 0;
+			sockets[i].refshut = 0;
+#endif
 			return i + LWIP_SOCKET_OFFSET;
 		}
 		SYS_ARCH_UNPROTECT(lev);
@@ -688,6 +725,12 @@ int lwip_sock_close(struct lwip_sock *sock)
 		LWIP_ASSERT("sock->lastdata == NULL", sock->lastdata == NULL);
 	}
 
+#if LWIP_SOCKET_ZEROCOPY
+	if ((sock->conn != NULL) && (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP)) {
+		lwip_sock_ref_close(sock);
+	}
+#endif							/* LWIP_SOCKET_ZEROCOPY */
+
 	err = netconn_delete(sock->conn);
 	if (err != ERR_OK) {
 		sock_set_errno(sock, err_to_errno(err));
@@ -1083,15 +1126,26 @@ int lwip_sendmsg(int s, const struct msghdr *msg, int flags)
 		} else {
 			/* flatten the IO vectors */
 			size_t offset = 0;
+#if LWIP_CHECKSUM_ON_COPY
+			/* checksum each IO vector while copying it and aggregate the sums,
+			   a vector copied at an odd offset has its bytes swapped */
+			u32_t acc = 0;
+			u16_t chksum;
 			for (i = 0; i < msg->msg_iovlen; i++) {
-				MEMCPY(&((u8_t *) chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+				chksum = LWIP_CHKSUM_COPY(&((u8_t *) chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, (u16_t) msg->msg_iov[i].iov_len);
+				if (offset & 1) {
+					chksum = SWAP_BYTES_IN_WORD(chksum);
+				}
+				acc += chksum;
 				offset += msg->msg_iov[i].iov_len;
 			}
-#if LWIP_CHECKSUM_ON_COPY
-			{
-				/* This can be improved by using LWIP_CHKSUM_COPY() and aggregating the checksum for each IO vector */
-				u16_t chksum = ~inet_chksum_pbuf(chain_buf->p);
-				netbuf_set_chksum(chain_buf, chksum);
+			acc = FOLD_U32T(acc);
+			acc = FOLD_U32T(acc);
+			netbuf_set_chksum(chain_buf, (u16_t) acc);
+#else							/* LWIP_CHECKSUM_ON_COPY */
+			for (i = 0; i < msg->msg_iovlen; i++) {
+				MEMCPY(&((u8_t *) chain_buf->p->payload)[offset], msg->msg_iov[i].iov_base, msg->msg_iov[i].iov_len);
+				offset += msg->msg_iov[i].iov_len;
 			}
 #endif							/* LWIP_CHECKSUM_ON_COPY */
 			err = ERR_OK;
@@ -1301,6 +1355,324 @@ int lwip_writev(int s, const struct iovec *iov, int iovcnt)
 	return lwip_sendmsg(s, &msg, 0);
 }
 
+#if LWIP_SOCKET_ZEROCOPY
+/**
+ * Receive the next pbuf chain of a socket without copying it. The caller owns
+ * the chain and hands it back with pbuf_free(). TCP data left by a previous
+ * lwip_recv() is returned first. MSG_PEEK is not supported.
+ *
+ * @return the length of the chain, 0 at the end of a TCP stream, or -1
+ */
+int lwip_recv_pbuf(int s, struct pbuf **p, int flags)
+{
+	struct lwip_sock *sock;
+	void *buf = NULL;
+	struct pbuf *q;
+	struct pbuf *next;
+	u16_t off;
+	err_t err;
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_pbuf(%d, %p, 0x%x)\n", s, p, flags));
+	sock = get_socket(s);
+	if (!sock) {
+		return -1;
+	}
+
+	if ((p == NULL) || (flags & MSG_PEEK)) {
+		sock_set_errno(sock, EINVAL);
+		return -1;
+	}
+	*p = NULL;
+
+	if (sock->lastdata) {
+		buf = sock->lastdata;
+	} else {
+		if (((flags & MSG_DONTWAIT) || netconn_is_nonblocking(sock->conn)) && (sock->rcvevent <= 0)) {
+			LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_recv_pbuf(%d): returning EWOULDBLOCK\n", s));
+			set_errno(EWOULDBLOCK);
+			return -1;
+		}
+
+		if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+			err = netconn_recv_tcp_pbuf(sock->conn, (struct pbuf **)&buf);
+		} else {
+			err = netconn_recv(sock->conn, (struct netbuf **)&buf);
+		}
+
+		if (err != ERR_OK) {
+			sock_set_errno(sock, err_to_errno(err));
+			if (err == ERR_CLSD) {
+				/* peer ended */
+				sock->conn->last_err = ERR_OK;
+				return 0;
+			}
+			return -1;
+		}
+	}
+
+	if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) == NETCONN_TCP) {
+		/* drop what lwip_recv() already copied */
+		q = (struct pbuf *)buf;
+		off = sock->lastoffset;
+		while (off >= q->len) {
+			off -= q->len;
+			next = q->next;
+			q->next = NULL;
+			pbuf_free(q);
+			q = next;
+		}
+		pbuf_header(q, -(s16_t)off);
+	} else {
+		q = ((struct netbuf *)buf)->p;
+		((struct netbuf *)buf)->p = NULL;
+		netbuf_delete((struct netbuf *)buf);
+	}
+	sock->lastdata = NULL;
+	sock->lastoffset = 0;
+
+	*p = q;
+	sock_set_errno(sock, 0);
+	return q->tot_len;
+}
+
+/** Free function of the pbufs referencing the data of lwip_send_ref() */
+static void lwip_sock_ref_free(struct pbuf *p)
+{
+	struct lwip_sock_ref *ref = (struct lwip_sock_ref *)p;
+
+	ref->sent(ref->arg);
+	mem_free(ref);
+}
+
+/**
+ * Call the sent functions of the TCP data acknowledged by pcb, or of all the
+ * data if pcb is NULL since the segments were freed with it. The netconn
+ * also drops a pcb which lingers after a shutdown, which lwip_sock_ref_close()
+ * lets happen only once no data is left.
+ */
+static void lwip_sock_ref_acked(struct lwip_sock *sock, struct tcp_pcb *pcb)
+{
+	struct lwip_sock_ref *ref;
+	struct lwip_sock_ref *acked;
+	struct lwip_sock_ref *last = NULL;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	/* unlink the acknowledged data, oldest first */
+	SYS_ARCH_PROTECT(lev);
+	acked = sock->refs;
+	while ((sock->refs != NULL) && ((pcb == NULL) || TCP_SEQ_GEQ(pcb->lastack, sock->refs->seqno))) {
+		last = sock->refs;
+		sock->refs = last->next;
+	}
+	if (last == NULL) {
+		acked = NULL;
+	} else {
+		last->next = NULL;
+	}
+	if (sock->refs == NULL) {
+		sock->lastref = NULL;
+	}
+	SYS_ARCH_UNPROTECT(lev);
+
+	while (acked != NULL) {
+		ref = acked;
+		acked = acked->next;
+		ref->sent(ref->arg);
+		mem_free(ref);
+	}
+}
+
+/** Queue TCP data just written until it is acknowledged */
+static void lwip_sock_ref_add(struct lwip_sock *sock, struct lwip_sock_ref *ref)
+{
+	struct tcp_pcb *pcb;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	ref->next = NULL;
+
+	/* sent_tcp() and err_tcp() take the same protection to call
+	   lwip_sock_ref_acked(), so either ref is queued before they do or they
+	   have already updated lastack or the pcb */
+	SYS_ARCH_PROTECT(lev);
+	pcb = sock->conn->pcb.tcp;
+	if (pcb != NULL) {
+		ref->seqno = pcb->snd_lbb;
+		if (!TCP_SEQ_GEQ(pcb->lastack, ref->seqno)) {
+			if (sock->lastref != NULL) {
+				sock->lastref->next = ref;
+			} else {
+				sock->refs = ref;
+			}
+			sock->lastref = ref;
+			SYS_ARCH_UNPROTECT(lev);
+			return;
+		}
+	}
+	SYS_ARCH_UNPROTECT(lev);
+
+	/* already acknowledged, or the connection is gone with its segments */
+	ref->sent(ref->arg);
+	mem_free(ref);
+}
+
+/** Check the acknowledged data, or reset the connection, in tcpip_thread */
+static err_t lwip_sock_ref_call(struct tcpip_api_call_data *call)
+{
+	struct lwip_sock_ref_call_data *data = (struct lwip_sock_ref_call_data *)call;
+	struct tcp_pcb *pcb = data->sock->conn->pcb.tcp;
+
+	if (data->abort && (pcb != NULL)) {
+		/* err_tcp() releases the data as the segments are freed */
+		tcp_abort(pcb);
+	} else {
+		lwip_sock_ref_acked(data->sock, pcb);
+	}
+
+	return ERR_OK;
+}
+
+/**
+ * Wait before closing a TCP socket, or shutting down its TX side, until the
+ * data sent by lwip_send_ref() is acknowledged: the netconn lets go of the
+ * pcb then, which would keep referencing the data. lwip_send_ref() fails
+ * from now on, and the calls writing data are waited for. The connection is
+ * reset if it takes longer than LWIP_TCP_CLOSE_TIMEOUT_MS_DEFAULT.
+ */
+static void lwip_sock_ref_close(struct lwip_sock *sock)
+{
+	struct lwip_sock_ref_call_data data;
+	u32_t time_started = sys_now();
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	SYS_ARCH_PROTECT(lev);
+	sock->refshut = 1;
+	SYS_ARCH_UNPROTECT(lev);
+
+	data.sock = sock;
+	data.abort = 0;
+	while ((sock->refs != NULL) || (sock->refwrites > 0)) {
+		/* sent_tcp() isn't called anymore after a shutdown of the TX side */
+		if ((s32_t)(sys_now() - time_started) >= LWIP_TCP_CLOSE_TIMEOUT_MS_DEFAULT) {
+			data.abort = 1;
+		}
+		tcpip_api_call(lwip_sock_ref_call, &data.call);
+		if ((sock->refs != NULL) || (sock->refwrites > 0)) {
+			sys_msleep(TCP_TMR_INTERVAL);
+		}
+	}
+}
+
+#if LWIP_UDP || LWIP_RAW
+/** lwip_send_ref() of a UDP or RAW socket: the data is sent in a custom pbuf */
+static int lwip_send_ref_dgram(struct lwip_sock *sock, struct lwip_sock_ref *ref, const void *data, size_t size)
+{
+	struct netbuf buf;
+	struct pbuf *p;
+	err_t err;
+
+	if (size > 0xFFFF) {
+		ref->sent(ref->arg);
+		mem_free(ref);
+		sock_set_errno(sock, EMSGSIZE);
+		return -1;
+	}
+
+	p = pbuf_alloced_custom(PBUF_RAW, (u16_t)size, PBUF_REF, &ref->pc, LWIP_CONST_CAST(void *, data), (u16_t)size);
+	ref->pc.custom_free_function = lwip_sock_ref_free;
+
+	/* to the remote address of the netconn */
+	buf.p = buf.ptr = p;
+#if LWIP_CHECKSUM_ON_COPY
+	buf.flags = 0;
+#endif							/* LWIP_CHECKSUM_ON_COPY */
+	ip_addr_set_zero(&buf.addr);
+	netbuf_fromport(&buf) = 0;
+
+	err = netconn_send(sock->conn, &buf);
+
+	/* the sent function is called here, unless a driver keeps a reference */
+	pbuf_free(p);
+
+	sock_set_errno(sock, err_to_errno(err));
+	return (err == ERR_OK ? (int)size : -1);
+}
+#endif							/* LWIP_UDP || LWIP_RAW */
+
+/**
+ * Send data without copying it. The data must be left untouched until sent
+ * is called with arg, from tcpip_thread or from the driver that releases the
+ * data: for TCP, once the data written is acknowledged, for UDP and RAW once
+ * the datagram is transmitted. sent is called exactly once for each call,
+ * including when it fails. UDP and RAW sockets must be connected.
+ *
+ * @return the number of bytes written, or -1
+ */
+int lwip_send_ref(int s, const void *data, size_t size, int flags, lwip_sent_fn sent, void *arg)
+{
+	struct lwip_sock *sock;
+	struct lwip_sock_ref *ref;
+	err_t err;
+	u8_t write_flags;
+	size_t written;
+	SYS_ARCH_DECL_PROTECT(lev);
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d, data=%p, size=%" SZT_F ", flags=0x%x)\n", s, data, size, flags));
+
+	LWIP_ERROR("lwip_send_ref: invalid sent function", (sent != NULL), set_errno(EINVAL); return -1;);
+
+	sock = get_socket(s);
+	if (!sock) {
+		sent(arg);
+		return -1;
+	}
+
+	ref = (struct lwip_sock_ref *)mem_malloc(sizeof(struct lwip_sock_ref));
+	if (ref == NULL) {
+		sent(arg);
+		sock_set_errno(sock, ENOMEM);
+		return -1;
+	}
+	ref->sent = sent;
+	ref->arg = arg;
+
+	if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+#if (LWIP_UDP || LWIP_RAW)
+		return lwip_send_ref_dgram(sock, ref, data, size);
+#else							/* (LWIP_UDP || LWIP_RAW) */
+		lwip_sock_ref_free(&ref->pc.pbuf);
+		sock_set_errno(sock, err_to_errno(ERR_ARG));
+		return -1;
+#endif							/* (LWIP_UDP || LWIP_RAW) */
+	}
+
+	/* no data is written once lwip_sock_ref_close() waits for it */
+	SYS_ARCH_PROTECT(lev);
+	if (sock->refshut) {
+		SYS_ARCH_UNPROTECT(lev);
+		sent(arg);
+		mem_free(ref);
+		sock_set_errno(sock, err_to_errno(ERR_CONN));
+		return -1;
+	}
+	sock->refwrites++;
+	SYS_ARCH_UNPROTECT(lev);
+
+	/* the segments reference the data until they are acknowledged */
+	write_flags = NETCONN_NOCOPY | ((flags & MSG_MORE) ? NETCONN_MORE : 0) | ((flags & MSG_DONTWAIT) ? NETCONN_DONTBLOCK : 0);
+	written = 0;
+	err = netconn_write_partly(sock->conn, data, size, write_flags, &written);
+	lwip_sock_ref_add(sock, ref);
+
+	SYS_ARCH_PROTECT(lev);
+	sock->refwrites--;
+	SYS_ARCH_UNPROTECT(lev);
+
+	LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_send_ref(%d) err=%d written=%" SZT_F "\n", s, err, written));
+	sock_set_errno(sock, err_to_errno(err));
+	return (err == ERR_OK ? (int)written : -1);
+}
+#endif							/* LWIP_SOCKET_ZEROCOPY */
+
 #if LWIP_SELECT
 
 /**
@@ -1826,6 +2198,13 @@ static void event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len
 		return;
 	}
 
+#if LWIP_SOCKET_ZEROCOPY
+	if (evt == NETCONN_EVT_SENT) {
+		lwip_sock_ref_acked(sock, conn->pcb.tcp);
+		return;
+	}
+#endif							/* LWIP_SOCKET_ZEROCOPY */
+
 	SYS_ARCH_PROTECT(lev);
 	/* Set event as required */
 	switch (evt) {
@@ -1960,6 +2339,13 @@ int lwip_shutdown(int s, int how)
 		sock_set_errno(sock, EINVAL);
 		return -1;
 	}
+
+#if LWIP_SOCKET_ZEROCOPY
+	if (shut_tx) {
+		lwip_sock_ref_close(sock);
+	}
+#endif							/* LWIP_SOCKET_ZEROCOPY */
+
 	err = netconn_shutdown(sock->conn, shut_rx, shut_tx);
 
 	sock_set_errno(sock, err_to_errno(err));
@@ -91,6 +91,65 @@ sys_mutex_t lock_tcpip_core;
 #define TCPIP_MBOX_FETCH(mbox, msg) sys_mbox_fetch(mbox, msg)
 #endif							/* LWIP_TIMERS */
 
+/**
+ * Handle a message posted to tcpip_thread, with the core locked
+ *
+ * @param msg the message
+ */
+static void tcpip_thread_handle_msg(struct tcpip_msg *msg)
+{
+	switch (msg->type) {
+#if !LWIP_TCPIP_CORE_LOCKING
+	case TCPIP_MSG_API:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API message %p\n", (void *)msg));
+		msg->msg.api_msg.function(msg->msg.api_msg.msg);
+		break;
+	case TCPIP_MSG_API_CALL:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API CALL message %p\n", (void *)msg));
+		msg->msg.api_call.arg->err = msg->msg.api_call.function(msg->msg.api_call.arg);
+		sys_sem_signal(msg->msg.api_call.sem);
+		break;
+#endif							/* !LWIP_TCPIP_CORE_LOCKING */
+
+#if !LWIP_TCPIP_CORE_LOCKING_INPUT
+	case TCPIP_MSG_INPKT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET %p\n", (void *)msg));
+		msg->msg.inp.input_fn(msg->msg.inp.p, msg->msg.inp.netif);
+		memp_free(MEMP_TCPIP_MSG_INPKT, msg);
+		break;
+#endif							/* !LWIP_TCPIP_CORE_LOCKING_INPUT */
+
+#if LWIP_TCPIP_TIMEOUT			// && LWIP_TIMERS
+	case TCPIP_MSG_TIMEOUT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: TIMEOUT %p\n", (void *)msg));
+		sys_timeout(msg->msg.tmo.msecs, msg->msg.tmo.h, msg->msg.tmo.arg);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+	case TCPIP_MSG_UNTIMEOUT:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: UNTIMEOUT %p\n", (void *)msg));
+		sys_untimeout(msg->msg.tmo.h, msg->msg.tmo.arg);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+#endif							/* LWIP_TCPIP_TIMEOUT && LWIP_TIMERS */
+
+	case TCPIP_MSG_CALLBACK:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK %p\n", (void *)msg));
+		msg->msg.cb.function(msg->msg.cb.ctx);
+		memp_free(MEMP_TCPIP_MSG_API, msg);
+		break;
+
+	case TCPIP_MSG_CALLBACK_STATIC:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK_STATIC %p\n", (void *)msg));
+		msg->msg.cb.function(msg->msg.cb.ctx);
+		break;
+
+	default:
+		LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: %d\n", msg->type));
+		LWIP_ASSERT("tcpip_thread: invalid message", 0);
+		break;
+	}
+}
+
 /**
  * The main lwIP thread. This thread has exclusive access to lwIP core functions
  * (unless access to them is not locked). Other threads communicate with this
@@ -99,11 +158,17 @@ sys_mutex_t lock_tcpip_core;
  * It also starts all the timers to make sure they are running in the right
  * thread context.
  *
+ * Up to TCPIP_MBOX_BATCH messages are handled per wakeup: those posted
+ * meanwhile are fetched without waiting and with the core still locked.
+ *
  * @param arg unused argument
  */
 static void tcpip_thread(void *arg)
 {
 	struct tcpip_msg *msg = NULL;
+#if TCPIP_MBOX_BATCH > 1
+	int batch;
+#endif
 	LWIP_UNUSED_ARG(arg);
 
 	if (tcpip_init_done != NULL) {
@@ -125,56 +190,23 @@ static void tcpip_thread(void *arg)
 			continue;
 		}
 
-		switch (msg->type) {
-#if !LWIP_TCPIP_CORE_LOCKING
-		case TCPIP_MSG_API:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API message %p\n", (void *)msg));
-			msg->msg.api_msg.function(msg->msg.api_msg.msg);
-			break;
-		case TCPIP_MSG_API_CALL:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: API CALL message %p\n", (void *)msg));
-			msg->msg.api_call.arg->err = msg->msg.api_call.function(msg->msg.api_call.arg);
-			sys_sem_signal(msg->msg.api_call.sem);
-			break;
-#endif							/* !LWIP_TCPIP_CORE_LOCKING */
-
-#if !LWIP_TCPIP_CORE_LOCKING_INPUT
-		case TCPIP_MSG_INPKT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: PACKET %p\n", (void *)msg));
-			msg->msg.inp.input_fn(msg->msg.inp.p, msg->msg.inp.netif);
-			memp_free(MEMP_TCPIP_MSG_INPKT, msg);
-			break;
-#endif							/* !LWIP_TCPIP_CORE_LOCKING_INPUT */
-
-#if LWIP_TCPIP_TIMEOUT			// && LWIP_TIMERS
-		case TCPIP_MSG_TIMEOUT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: TIMEOUT %p\n", (void *)msg));
-			sys_timeout(msg->msg.tmo.msecs, msg->msg.tmo.h, msg->msg.tmo.arg);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-		case TCPIP_MSG_UNTIMEOUT:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: UNTIMEOUT %p\n", (void *)msg));
-			sys_untimeout(msg->msg.tmo.h, msg->msg.tmo.arg);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-#endif							/* LWIP_TCPIP_TIMEOUT && LWIP_TIMERS */
-
-		case TCPIP_MSG_CALLBACK:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK %p\n", (void *)msg));
-			msg->msg.cb.function(msg->msg.cb.ctx);
-			memp_free(MEMP_TCPIP_MSG_API, msg);
-			break;
-
-		case TCPIP_MSG_CALLBACK_STATIC:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: CALLBACK_STATIC %p\n", (void *)msg));
-			msg->msg.cb.function(msg->msg.cb.ctx);
-			break;
-
-		default:
-			LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: %d\n", msg->type));
-			LWIP_ASSERT("tcpip_thread: invalid message", 0);
-			break;
+		tcpip_thread_handle_msg(msg);
+
+#if TCPIP_MBOX_BATCH > 1
+		/* handle the messages posted meanwhile before checking the timeouts */
+		for (batch = 1; batch < TCPIP_MBOX_BATCH; batch++) {
+			if (sys_arch_mbox_tryfetch(&mbox, (void **)&msg) == SYS_MBOX_EMPTY) {
+				break;
+			}
+			if (msg == NULL) {
+				LWIP_DEBUGF(TCPIP_DEBUG, ("tcpip_thread: invalid message: NULL\n"));
+				LWIP_ASSERT("tcpip_thread: invalid message", 0);
+				continue;
+			}
+			LWIP_TCPIP_THREAD_ALIVE();
+			tcpip_thread_handle_msg(msg);
 		}
+#endif							/* TCPIP_MBOX_BATCH > 1 */
 	}
 }
 
@@ -27,7 +27,7 @@
  * \#define LWIP_CHKSUM your_checksum_routine
  *
  * Or you can select from the implementations below by defining
- * LWIP_CHKSUM_ALGORITHM to 1, 2 or 3.
+ * LWIP_CHKSUM_ALGORITHM to 1, 2, 3 or 4.
  */
 
 /*
@@ -68,6 +68,7 @@
 #include "lwip/def.h"
 #include "lwip/ip_addr.h"
 
+#include <stdint.h>
 #include <string.h>
 
 #ifndef LWIP_CHKSUM
@@ -269,6 +270,104 @@ u16_t lwip_standard_chksum(const void *dataptr, int len)
 }
 #endif
 
+#if (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2)
+/*
+ * Sum of 32-bit words for the versions #4.
+ *
+ * The words are added up in a 64-bit accumulator, which doesn't overflow for
+ * any pbuf, and folded to 16 bits at the end.  The result is the same as the
+ * sum of halfwords with end-around carries since 2^16 = 1 modulo 0xffff.
+ */
+typedef uint64_t chksum_acc_t;
+
+#define CHKSUM_ADD4(acc, w0, w1, w2, w3) \
+	do { \
+		acc += (w0); \
+		acc += (w1); \
+		acc += (w2); \
+		acc += (w3); \
+	} while (0)
+
+#define CHKSUM_ADD1(acc, w) (acc += (w))
+
+#define CHKSUM_FOLD(acc) ((u32_t)((acc) & 0xffff) + (u32_t)(((acc) >> 16) & 0xffff) + \
+						  (u32_t)(((acc) >> 32) & 0xffff) + (u32_t)((acc) >> 48))
+#endif							/* (LWIP_CHKSUM_ALGORITHM == 4) || (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
+
+#if (LWIP_CHKSUM_ALGORITHM == 4)	/* Alternative version #4 */
+/**
+ * Word at a time checksum: the head bytes are summed until the data is
+ * aligned to 32 bits, then the data is summed 16 bytes per iteration as
+ * 32-bit words, and the tail bytes are summed at the end.
+ *
+ * @param dataptr points to start of data to be summed at any boundary
+ * @param len length of data to be summed
+ * @return host order (!) lwip checksum (non-inverted Internet sum)
+ */
+u16_t lwip_standard_chksum(const void *dataptr, int len)
+{
+	const u8_t *pb = (const u8_t *)dataptr;
+	const u32_t *pl;
+	chksum_acc_t acc = 0;
+	u16_t t = 0;
+	u32_t sum = 0;
+	/* starts at odd byte address? */
+	int odd = ((mem_ptr_t) pb & 1);
+
+	if (odd && len > 0) {
+		((u8_t *)&t)[1] = *pb++;
+		len--;
+	}
+
+	if (((mem_ptr_t) pb & 2) && len > 1) {
+		sum += *(const u16_t *)(const void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	pl = (const u32_t *)(const void *)pb;
+
+	while (len > 15) {
+		CHKSUM_ADD4(acc, pl[0], pl[1], pl[2], pl[3]);
+		pl += 4;
+		len -= 16;
+	}
+
+	while (len > 3) {
+		CHKSUM_ADD1(acc, *pl++);
+		len -= 4;
+	}
+
+	sum += CHKSUM_FOLD(acc);
+
+	pb = (const u8_t *)pl;
+
+	/* 16-bit aligned word remaining? */
+	if (len > 1) {
+		sum += *(const u16_t *)(const void *)pb;
+		pb += 2;
+		len -= 2;
+	}
+
+	/* dangling tail byte remaining? */
+	if (len > 0) {
+		((u8_t *)&t)[0] = *pb;
+	}
+
+	sum += t;
+
+	/* Fold 32-bit sum to 16 bits */
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t) sum;
+}
+#endif
+
 /** Parts of the pseudo checksum which are common to IPv4 and IPv6 */
 static u16_t inet_cksum_pseudo_base(struct pbuf *p, u8_t proto, u16_t proto_len, u32_t acc)
 {
@@ -601,3 +700,90 @@ u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
 	return LWIP_CHKSUM(dst, len);
 }
 #endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 1) */
+
+#if (LWIP_CHKSUM_COPY_ALGORITHM == 2)	/* Version #2 */
+/** Copy and checksum in a single pass: the data is loaded once, 32 bits at
+ * a time once the source is aligned, and each word is stored and summed.
+ * The destination may have any alignment.
+ */
+u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	const u8_t *ps = (const u8_t *)src;
+	u8_t *pd = (u8_t *)dst;
+	chksum_acc_t acc = 0;
+	u32_t w0, w1, w2, w3;
+	u16_t h;
+	u16_t t = 0;
+	u32_t sum = 0;
+	int n = len;
+	/* starts at odd byte address? */
+	int odd = ((mem_ptr_t) ps & 1);
+
+	if (odd && n > 0) {
+		((u8_t *)&t)[1] = *pd++ = *ps++;
+		n--;
+	}
+
+	if (((mem_ptr_t) ps & 2) && n > 1) {
+		h = *(const u16_t *)(const void *)ps;
+		MEMCPY(pd, &h, 2);
+		sum += h;
+		ps += 2;
+		pd += 2;
+		n -= 2;
+	}
+
+	while (n > 15) {
+		w0 = ((const u32_t *)(const void *)ps)[0];
+		w1 = ((const u32_t *)(const void *)ps)[1];
+		w2 = ((const u32_t *)(const void *)ps)[2];
+		w3 = ((const u32_t *)(const void *)ps)[3];
+		MEMCPY(pd, &w0, 4);
+		MEMCPY(pd + 4, &w1, 4);
+		MEMCPY(pd + 8, &w2, 4);
+		MEMCPY(pd + 12, &w3, 4);
+		CHKSUM_ADD4(acc, w0, w1, w2, w3);
+		ps += 16;
+		pd += 16;
+		n -= 16;
+	}
+
+	while (n > 3) {
+		w0 = *(const u32_t *)(const void *)ps;
+		MEMCPY(pd, &w0, 4);
+		CHKSUM_ADD1(acc, w0);
+		ps += 4;
+		pd += 4;
+		n -= 4;
+	}
+
+	sum += CHKSUM_FOLD(acc);
+
+	/* 16-bit aligned word remaining? */
+	if (n > 1) {
+		h = *(const u16_t *)(const void *)ps;
+		MEMCPY(pd, &h, 2);
+		sum += h;
+		ps += 2;
+		pd += 2;
+		n -= 2;
+	}
+
+	/* dangling tail byte remaining? */
+	if (n > 0) {
+		((u8_t *)&t)[0] = *pd = *ps;
+	}
+
+	sum += t;
+
+	/* Fold 32-bit sum to 16 bits */
+	sum = FOLD_U32T(sum);
+	sum = FOLD_U32T(sum);
+
+	if (odd) {
+		sum = SWAP_BYTES_IN_WORD(sum);
+	}
+
+	return (u16_t) sum;
+}
+#endif							/* (LWIP_CHKSUM_COPY_ALGORITHM == 2) */
@@ -681,6 +681,11 @@
 #define SO_REUSE_RXTOALL	CONFIG_NET_SO_REUSE_RXTOALL
 #endif
 
+#ifdef CONFIG_NET_SOCKET_ZEROCOPY
+#define LWIP_SOCKET_ZEROCOPY	CONFIG_NET_SOCKET_ZEROCOPY
+#define LWIP_SUPPORT_CUSTOM_PBUF	1
+#endif
+
 /* ---------- Socket options ---------- */
 
 /* ---------- SLIP options ---------- */
@@ -773,6 +778,10 @@
 #define LWIP_TCPIP_CORE_LOCKING_INPUT CONFIG_NET_TCPIP_CORE_LOCKING_INPUT
 #endif
 
+#ifdef CONFIG_NET_TCPIP_MBOX_BATCH
+#define TCPIP_MBOX_BATCH	CONFIG_NET_TCPIP_MBOX_BATCH
+#endif
+
 #ifdef CONFIG_NET_TCPIP_THREAD_NAME
 #define TCPIP_THREAD_NAME	CONFIG_NET_TCPIP_THREAD_NAME
 #endif
@@ -787,6 +796,8 @@
 
 #ifdef CONFIG_NET_COMPAT_MUTEX
 #define LWIP_COMPAT_MUTEX	CONFIG_NET_COMPAT_MUTEX
+#else
+#define LWIP_COMPAT_MUTEX	0
 #endif
 
 #ifdef CONFIG_NET_SYS_LIGHTWEIGHT_PROT
@@ -1174,4 +1185,13 @@
 #define LWIP_NETIF_TX_SINGLE_PBUF             1
 #endif
 
+#ifdef CONFIG_NET_LWIP_CHKSUM_WORD
+#define LWIP_CHKSUM_ALGORITHM                 4
+#endif
+
+#ifdef CONFIG_NET_LWIP_CHECKSUM_ON_COPY
+#define LWIP_CHECKSUM_ON_COPY                 1
+#define LWIP_CHKSUM_COPY_ALGORITHM            2
+#endif
+
 #endif							/* __LWIP_LWIPOPTS_H__ */
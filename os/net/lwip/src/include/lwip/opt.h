@@ -1553,6 +1553,16 @@
 #define TCPIP_MBOX_SIZE                 0
 #endif
 
+/**
+ * TCPIP_MBOX_BATCH: The maximum number of messages tcpip_thread handles per
+ * wakeup. The messages posted while it handles the first one are fetched
+ * without waiting and without releasing the core lock, and the timeouts are
+ * checked between two batches. 1 handles one message per wakeup.
+ */
+#ifndef TCPIP_MBOX_BATCH
+#define TCPIP_MBOX_BATCH                1
+#endif
+
 /**
  * Define this to something that triggers a watchdog. This is called from
  * tcpip_thread after processing a message.
@@ -1804,6 +1814,15 @@
 #define LWIP_SO_LINGER                  0
 #endif
 
+/**
+ * LWIP_SOCKET_ZEROCOPY==1: Enable lwip_recv_pbuf() and lwip_send_ref(), which
+ * hand the received pbufs to the application and send from the buffers of the
+ * application without copying the data. Requires LWIP_SUPPORT_CUSTOM_PBUF.
+ */
+#ifndef LWIP_SOCKET_ZEROCOPY
+#define LWIP_SOCKET_ZEROCOPY            0
+#endif
+
 /**
  * If LWIP_SO_RCVBUF is used, this is the default value for recv_bufsize.
  */
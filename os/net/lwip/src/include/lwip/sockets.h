@@ -493,6 +493,16 @@ struct lwip_sock {
 	u8_t err;
 	/** counter of how many threads are waiting for this socket using select */
 	SELWAIT_T select_waiting;
+#if LWIP_SOCKET_ZEROCOPY
+	/** TCP data sent by lwip_send_ref() and not acknowledged yet, oldest first */
+	struct lwip_sock_ref *refs;
+	/** last entry of refs */
+	struct lwip_sock_ref *lastref;
+	/** number of lwip_send_ref() calls writing TCP data */
+	u8_t refwrites;
+	/** set once the TX side is shut down, lwip_send_ref() fails then */
+	u8_t refshut;
+#endif							/* LWIP_SOCKET_ZEROCOPY */
 };
 
 #define lwip_socket_init()		/* Compatibility define, no init needed. */
@@ -526,6 +536,16 @@ int lwip_ioctl(int s, long cmd, void *argp);
 int lwip_fcntl(int s, int cmd, int val);
 
 int lwip_poll(int fd, struct pollfd *fds, bool setup);
+
+#if LWIP_SOCKET_ZEROCOPY
+struct pbuf;
+
+/** Called by lwip_send_ref() when the stack doesn't reference the data anymore */
+typedef void (*lwip_sent_fn)(void *arg);
+
+int lwip_recv_pbuf(int s, struct pbuf **p, int flags);
+int lwip_send_ref(int s, const void *dataptr, size_t size, int flags, lwip_sent_fn sent, void *arg);
+#endif							/* LWIP_SOCKET_ZEROCOPY */
 #ifdef __cplusplus
 }
 #endif
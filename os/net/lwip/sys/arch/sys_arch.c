@@ -573,10 +573,13 @@ void sys_init(void)
 /*-----------------------------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------------*/
 #if LWIP_COMPAT_MUTEX == 0
-/* Create a new mutex*/
+/* Create a new mutex, priority inheriting: the core lock of
+ * LWIP_TCPIP_CORE_LOCKING is held by application tasks of any priority
+ */
 err_t sys_mutex_new(sys_mutex_t *mutex)
 {
 	int status = 0;
+	pthread_mutexattr_t attr;
 
 	if (NULL == mutex) {
 		mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
@@ -587,7 +590,12 @@ err_t sys_mutex_new(sys_mutex_t *mutex)
 #endif							/* SYS_STATS */
 		return ERR_MEM;
 	}
-	status = pthread_mutex_init(mutex, NULL);
+	pthread_mutexattr_init(&attr);
+#ifdef CONFIG_PRIORITY_INHERITANCE
+	pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+#endif
+	status = pthread_mutex_init(mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
 	if (status) {
 		return ERR_MEM;
 	}
@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include "test_chksum.h"
+
+#include <string.h>
+
+#include "lwip/inet_chksum.h"
+#include "lwip/pbuf.h"
+
+#define BUFSIZE 300
+
+static u8_t src[BUFSIZE + 8];
+static u8_t dst[BUFSIZE + 8];
+
+/* Setups/teardown functions */
+
+static void chksum_setup(void)
+{
+	u32_t seed = 1;
+	int i;
+
+	for (i = 0; i < (int)sizeof(src); i++) {
+		seed = seed * 1103515245 + 12345;
+		src[i] = (u8_t)(seed >> 16);
+	}
+	/* make carries likely */
+	memset(&src[100], 0xff, 64);
+}
+
+static void chksum_teardown(void)
+{
+}
+
+/** RFC 1071 sum of big endian halfwords, in host order */
+static u16_t ref_chksum(const u8_t *data, int len)
+{
+	u32_t sum = 0;
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		sum += (u32_t)(data[i] << 8 | data[i + 1]);
+	}
+	if (i < len) {
+		sum += (u32_t)(data[i] << 8);
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+	return (u16_t)sum;
+}
+
+/* Test functions */
+
+/** Compare inet_chksum with the reference for all alignments and lengths */
+START_TEST(test_chksum_alignments)
+{
+	int off;
+	int len;
+	LWIP_UNUSED_ARG(_i);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len <= BUFSIZE; len++) {
+			fail_unless(lwip_ntohs((u16_t)~inet_chksum(&src[off], len)) == ref_chksum(&src[off], len));
+		}
+	}
+}
+
+END_TEST
+/** LWIP_CHKSUM_COPY must copy the data and return the checksum of the copy */
+START_TEST(test_chksum_copy)
+{
+#if LWIP_CHECKSUM_ON_COPY
+	int soff;
+	int doff;
+	int len;
+	u16_t chksum;
+	LWIP_UNUSED_ARG(_i);
+
+	for (soff = 0; soff < 4; soff++) {
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 0; len <= BUFSIZE; len += 7) {
+				memset(dst, 0, sizeof(dst));
+				chksum = LWIP_CHKSUM_COPY(&dst[doff], &src[soff], (u16_t)len);
+				fail_unless(memcmp(&dst[doff], &src[soff], len) == 0);
+				fail_unless(dst[doff + len] == 0);
+				fail_unless(chksum == (u16_t)~inet_chksum(&dst[doff], len));
+			}
+		}
+	}
+#else
+	LWIP_UNUSED_ARG(_i);
+#endif
+}
+
+END_TEST
+/** inet_chksum_pbuf over a chain split at odd and even offsets */
+START_TEST(test_chksum_pbuf_chain)
+{
+	struct pbuf *p1;
+	struct pbuf *p2;
+	u16_t split;
+	LWIP_UNUSED_ARG(_i);
+
+	for (split = 1; split < 40; split++) {
+		p1 = pbuf_alloc(PBUF_RAW, split, PBUF_RAM);
+		p2 = pbuf_alloc(PBUF_RAW, BUFSIZE - split, PBUF_RAM);
+		fail_unless(p1 != NULL && p2 != NULL);
+		pbuf_cat(p1, p2);
+		fail_unless(pbuf_take(p1, src, BUFSIZE) == ERR_OK);
+		fail_unless(lwip_ntohs((u16_t)~inet_chksum_pbuf(p1)) == ref_chksum(src, BUFSIZE));
+		pbuf_free(p1);
+	}
+}
+
+END_TEST
+/** Create the suite including all tests for this module */
+Suite *chksum_suite(void)
+{
+	TFun tests[] = {
+		test_chksum_alignments,
+		test_chksum_copy,
+		test_chksum_pbuf_chain
+	};
+	return create_suite("CHKSUM", tests, sizeof(tests) / sizeof(TFun), chksum_setup, chksum_teardown);
+}
@@ -55,6 +55,7 @@
  ****************************************************************************/
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -68,7 +69,13 @@
  ****************************************************************************/
 
 #define MAX_HEADER_FILES 500
+#define MAX_SYMBOLS      8192
 #define SYMTAB_NAME      "g_symtab"
+#define SEEDS_NAME       "g_symtab_seeds"
+
+/* Average number of symbols per bucket of the perfect hash */
+
+#define PHASH_LOAD       3
 
 /****************************************************************************
  * Private Types
@@ -81,17 +88,30 @@
 static const char *g_hdrfiles[MAX_HEADER_FILES];
 static int nhdrfiles;
 
+/* Symbols of the perfect hash, with their build condition */
+
+static char *g_names[MAX_SYMBOLS];
+static char *g_conds[MAX_SYMBOLS];
+static int nsymbols;
+
+/* Seed of each bucket and symbol of each slot of the perfect hash */
+
+static uint16_t g_seeds[MAX_SYMBOLS];
+static int g_slots[MAX_SYMBOLS];
+static int nbuckets;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
 static void show_usage(const char *progname)
 {
-	fprintf(stderr, "USAGE: %s <cvs-file> <symtab-file>\n\n", progname);
+	fprintf(stderr, "USAGE: %s [-d] [-p] <cvs-file> <symtab-file>\n\n", progname);
 	fprintf(stderr, "Where:\n\n");
 	fprintf(stderr, "  <cvs-file>   : The path to the input CSV file\n");
 	fprintf(stderr, "  <symtab-file>: The path to the output symbol table file\n");
 	fprintf(stderr, "  -d           : Enable debug output\n");
+	fprintf(stderr, "  -p           : Place the symbols by a perfect hash of their names\n");
 	exit(EXIT_FAILURE);
 }
 
@@ -122,6 +142,197 @@ static void add_hdrfile(const char *hdrfile)
 	}
 }
 
+/* FNV-1a hash of the name with a final mix.  This must be the same as the
+ * hash of lib/libc/symtab/symtab_findhashedbyname.c
+ */
+
+static uint32_t hash_name(const char *name, uint32_t seed)
+{
+	uint32_t hash = 0x811c9dc5 ^ seed;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 0x01000193;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+static void add_symbol(const char *name, const char *cond)
+{
+	int i;
+
+	if (nsymbols >= MAX_SYMBOLS) {
+		fprintf(stderr, "ERROR:  Too many symbols.  Increase MAX_SYMBOLS\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < nsymbols; i++) {
+		if (strcmp(g_names[i], name) == 0) {
+			fprintf(stderr, "ERROR:  Duplicate symbol %s\n", name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	g_names[nsymbols] = strdup(name);
+	g_conds[nsymbols] = strdup(cond ? cond : "");
+	nsymbols++;
+}
+
+/* Hash and displace: the symbols are spread in buckets by their hash with
+ * seed 0.  Starting with the largest bucket, a seed is searched for each
+ * bucket which places all of its symbols in free slots.
+ */
+
+static bool place_bucket(const int *members, int nmembers, uint16_t seed, int *slots)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < nmembers; i++) {
+		slots[i] = hash_name(g_names[members[i]], seed) % nsymbols;
+		if (g_slots[slots[i]] >= 0) {
+			return false;
+		}
+
+		for (j = 0; j < i; j++) {
+			if (slots[j] == slots[i]) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool build_phash(void)
+{
+	static int bucket_of[MAX_SYMBOLS];
+	static int first[MAX_SYMBOLS + 1];
+	static int members[MAX_SYMBOLS];
+	static int slots[MAX_SYMBOLS];
+	static int order[MAX_SYMBOLS];
+	int nmembers;
+	int size;
+	int seed;
+	int b;
+	int i;
+	int n;
+
+	/* Sort the symbols by bucket */
+
+	memset(first, 0, sizeof(first));
+	for (i = 0; i < nsymbols; i++) {
+		bucket_of[i] = hash_name(g_names[i], 0) % nbuckets;
+		first[bucket_of[i] + 1]++;
+		g_slots[i] = -1;
+	}
+
+	for (b = 0; b < nbuckets; b++) {
+		first[b + 1] += first[b];
+	}
+
+	for (i = 0; i < nsymbols; i++) {
+		members[first[bucket_of[i]]++] = i;
+	}
+
+	for (b = nbuckets; b > 0; b--) {
+		first[b] = first[b - 1];
+	}
+
+	first[0] = 0;
+
+	/* Then order the buckets from the largest one */
+
+	n = 0;
+	for (size = nsymbols; size > 0; size--) {
+		for (b = 0; b < nbuckets; b++) {
+			if (first[b + 1] - first[b] == size) {
+				order[n++] = b;
+			}
+		}
+
+		if (n == nbuckets) {
+			break;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		b = order[i];
+		nmembers = first[b + 1] - first[b];
+
+		for (seed = 1; seed <= UINT16_MAX; seed++) {
+			if (place_bucket(&members[first[b]], nmembers, seed, slots)) {
+				break;
+			}
+		}
+
+		if (seed > UINT16_MAX) {
+			return false;
+		}
+
+		g_seeds[b] = seed;
+		for (size = 0; size < nmembers; size++) {
+			g_slots[slots[size]] = members[first[b] + size];
+		}
+	}
+
+	return true;
+}
+
+static void output_phash(FILE *outstream)
+{
+	int i;
+
+	/* More buckets make the seeds easier to find */
+
+	for (nbuckets = (nsymbols + PHASH_LOAD - 1) / PHASH_LOAD; !build_phash(); nbuckets++) {
+		memset(g_seeds, 0, sizeof(g_seeds));
+		if (nbuckets >= nsymbols) {
+			fprintf(stderr, "ERROR:  No perfect hash found\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* The number of buckets and their seeds, referenced by the first entry */
+
+	fprintf(outstream, "\nstatic const uint16_t %s[] =\n", SEEDS_NAME);
+	fprintf(outstream, "{\n  %d", nbuckets);
+	for (i = 0; i < nbuckets; i++) {
+		fprintf(outstream, ",%s%d", i % 16 == 0 ? "\n  " : " ", g_seeds[i]);
+	}
+
+	fprintf(outstream, "\n};\n");
+
+	/* Symbols excluded by their condition keep their slot with no name */
+
+	fprintf(outstream, "\nstruct symtab_s %s[] =\n", SYMTAB_NAME);
+	fprintf(outstream, "{\n");
+	fprintf(outstream, "  { \"\", (FAR const void *)%s },\n", SEEDS_NAME);
+
+	for (i = 0; i < nsymbols; i++) {
+		const char *name = g_names[g_slots[i]];
+		const char *cond = g_conds[g_slots[i]];
+
+		if (strlen(cond) > 0) {
+			fprintf(outstream, "#if %s\n", cond);
+			fprintf(outstream, "  { \"%s\", (FAR const void *)%s },\n", name, name);
+			fprintf(outstream, "#else\n");
+			fprintf(outstream, "  { \"\", (FAR const void *)0 },\n");
+			fprintf(outstream, "#endif\n");
+		} else {
+			fprintf(outstream, "  { \"%s\", (FAR const void *)%s },\n", name, name);
+		}
+	}
+
+	fprintf(outstream, "};\n\n");
+	fprintf(outstream, "#define NSYMBOLS (sizeof(%s) / sizeof (struct symtab_s))\n", SYMTAB_NAME);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -134,6 +345,7 @@ int main(int argc, char **argv, char **envp)
 	char *finalterm;
 	char *ptr;
 	bool cond;
+	bool phash;
 	FILE *instream;
 	FILE *outstream;
 	int ch;
@@ -142,13 +354,18 @@ int main(int argc, char **argv, char **envp)
 	/* Parse command line options */
 
 	set_debug(false);
+	phash = false;
 
-	while ((ch = getopt(argc, argv, ":d")) > 0) {
+	while ((ch = getopt(argc, argv, ":dp")) > 0) {
 		switch (ch) {
 		case 'd':
 			set_debug(true);
 			break;
 
+		case 'p':
+			phash = true;
+			break;
+
 		case '?':
 			fprintf(stderr, "Unrecognized option: %c\n", optopt);
 			show_usage(argv[0]);
@@ -214,6 +431,12 @@ int main(int argc, char **argv, char **envp)
 		/* Add the header file to the list of header files we need to include */
 
 		add_hdrfile(get_parm(HEADER_INDEX));
+
+		/* Keep the symbols to place them by their hash */
+
+		if (phash) {
+			add_symbol(get_parm(NAME_INDEX), get_parm(COND_INDEX));
+		}
 	}
 
 	/* Back to the beginning */
@@ -228,9 +451,24 @@ int main(int argc, char **argv, char **envp)
 
 	/* Output all of the require header files */
 
+	if (phash)
+		fprintf(outstream, "#include <stdint.h>\n");
+
 	for (i = 0; i < nhdrfiles; i++)
 		fprintf(outstream, "#include <%s>\n", g_hdrfiles[i]);
 
+	if (phash) {
+		if (nsymbols == 0) {
+			fprintf(stderr, "ERROR:  No symbols in %s\n", csvpath);
+			exit(EXIT_FAILURE);
+		}
+
+		output_phash(outstream);
+		fclose(instream);
+		fclose(outstream);
+		return EXIT_SUCCESS;
+	}
+
 	/* Now the symbol table itself */
 
 	fprintf(outstream, "\nstruct symtab_s %s[] =\n", SYMTAB_NAME);
@@ -0,0 +1,259 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Scan and select throughput of arastorage built for the host.  The same
+ * source is linked with the tuple by tuple processing and with the batch
+ * processing of CONFIG_ARASTORAGE_BATCH_SELECT.
+ *
+ * A relation of 10000 tuples is created in bench_db/ of the current
+ * directory.  Then a full scan and a selection with a WHERE clause are
+ * run, and all values of the result are read through the cursor.  The
+ * query and the walk through the cursor are timed separately, and the
+ * result is checked against the values inserted.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <arastorage/arastorage.h>
+
+#ifdef CONFIG_ARASTORAGE_BATCH_SELECT
+#define PROCESSING "batch"
+#else
+#define PROCESSING "row"
+#endif
+
+#define RELATION    "bench"
+#define NTUPLES     10000
+#define NRUNS       5
+#define QUERY_LEN   128
+
+/* Predicate of the selection, and the same in C to check the result */
+
+#define SELECT_WHERE "value > 5000 AND date < 300"
+#define SELECTED(date, value) ((value) > 5000 && (date) < 300)
+
+struct bench_result_s {
+	const char *name;
+	double query_ms;
+	double fetch_ms;
+	long rows;
+	long sum;
+};
+
+static uint32_t g_seed = 1;
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int exec(const char *fmt, ...)
+{
+	char query[QUERY_LEN];
+	va_list ap;
+	db_result_t res;
+
+	va_start(ap, fmt);
+	vsnprintf(query, sizeof(query), fmt, ap);
+	va_end(ap);
+
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		fprintf(stderr, "%s failed: %d\n", query, res);
+		return ERROR;
+	}
+	return OK;
+}
+
+/* Insert the tuples, and get the expected results of both queries */
+
+static int populate(struct bench_result_s *scan, struct bench_result_s *select)
+{
+	long date;
+	long value;
+	int i;
+
+	if (exec("CREATE RELATION %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE id DOMAIN int IN %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE date DOMAIN long IN %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE value DOMAIN long IN %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE name DOMAIN string(16) IN %s;", RELATION) != OK) {
+		return ERROR;
+	}
+
+	for (i = 0; i < NTUPLES; i++) {
+		date = (i * 7919L) % 1000;
+		value = rnd() % 10000;
+		if (exec("INSERT (%d, %ld, %ld, 'item%011d') INTO %s;", i, date, value, i, RELATION) != OK) {
+			return ERROR;
+		}
+
+		scan->rows++;
+		scan->sum += i + date + value;
+		if (SELECTED(date, value)) {
+			select->rows++;
+			select->sum += i + date + value;
+		}
+	}
+
+	return OK;
+}
+
+/* Run the query and read all values of the result through the cursor */
+
+static int run(const char *query, int ncolumns, struct bench_result_s *result, int first)
+{
+	db_cursor_t *cursor;
+	double t0;
+	double t1;
+	double t2;
+	long rows = 0;
+	long sum = 0;
+	int count;
+	int i;
+
+	t0 = now_ms();
+	cursor = db_query((char *)query);
+	t1 = now_ms();
+	if (cursor == NULL) {
+		fprintf(stderr, "%s failed\n", query);
+		return ERROR;
+	}
+
+	count = cursor_get_count(cursor);
+	if (count > 0 && DB_SUCCESS(cursor_move_first(cursor))) {
+		for (i = 0; i < count; i++) {
+			sum += cursor_get_int_value(cursor, 0);
+			sum += cursor_get_long_value(cursor, 1);
+			sum += cursor_get_long_value(cursor, 2);
+			if (ncolumns == 4 && cursor_get_string_value(cursor, 3) == NULL) {
+				break;
+			}
+			rows++;
+			if (i + 1 < count && DB_ERROR(cursor_move_next(cursor))) {
+				break;
+			}
+		}
+	}
+	t2 = now_ms();
+	db_cursor_free(cursor);
+
+	if (rows != result->rows || sum != result->sum) {
+		fprintf(stderr, "%s: got %ld rows sum %ld, expected %ld rows sum %ld\n", result->name, rows, sum, result->rows, result->sum);
+		return ERROR;
+	}
+
+	if (first || t1 - t0 < result->query_ms) {
+		result->query_ms = t1 - t0;
+	}
+	if (first || t2 - t1 < result->fetch_ms) {
+		result->fetch_ms = t2 - t1;
+	}
+
+	return OK;
+}
+
+/* Start from an empty database directory */
+
+static void clean_db(void)
+{
+	char path[64];
+	struct dirent *entry;
+	DIR *dir;
+
+	dir = opendir(CONFIG_MOUNT_POINT);
+	if (dir == NULL) {
+		mkdir(CONFIG_MOUNT_POINT, 0755);
+		return;
+	}
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			snprintf(path, sizeof(path), "%s%s", CONFIG_MOUNT_POINT, entry->d_name);
+			unlink(path);
+		}
+	}
+	closedir(dir);
+}
+
+static void report(struct bench_result_s *result)
+{
+	double total = result->query_ms + result->fetch_ms;
+
+	printf("  %-6s %5ld rows  query %8.2f ms  cursor %8.2f ms  %9.0f tuples/s\n",
+		   result->name, result->rows, result->query_ms, result->fetch_ms, NTUPLES * 1000.0 / total);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_result_s scan = { "scan" };
+	struct bench_result_s select = { "select" };
+	char query[QUERY_LEN];
+	int i;
+
+	clean_db();
+
+	if (db_init() != DB_OK) {
+		fprintf(stderr, "db_init failed\n");
+		return 1;
+	}
+
+	if (populate(&scan, &select) != OK) {
+		return 1;
+	}
+
+	printf("%s: %d tuples, %d runs\n", PROCESSING, NTUPLES, NRUNS);
+
+	for (i = 0; i < NRUNS; i++) {
+		if (run("SELECT id, date, value, name FROM " RELATION ";", 4, &scan, i == 0) != OK) {
+			return 1;
+		}
+
+		snprintf(query, sizeof(query), "SELECT id, date, value FROM %s WHERE %s;", RELATION, SELECT_WHERE);
+		if (run(query, 3, &select, i == 0) != OK) {
+			return 1;
+		}
+	}
+
+	report(&scan);
+	report(&select);
+
+	db_deinit();
+	clean_db();
+	return 0;
+}
@@ -0,0 +1,243 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * B+tree index creation of arastorage built for the host.  The same source
+ * is linked with the key by key insertion and with the bulk load of
+ * CONFIG_ARASTORAGE_INDEX_BULK_LOAD and the log of CONFIG_ARASTORAGE_INDEX_WAL.
+ *
+ * A relation of random keys is created in bench_db/ of the current
+ * directory, then an index is created over it and timed.  More tuples are
+ * inserted through the index, and the range queries which use it are
+ * checked against the keys inserted, before and after the database is
+ * closed and opened again.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <arastorage/arastorage.h>
+
+#ifdef CONFIG_ARASTORAGE_INDEX_BULK_LOAD
+#define LOADING "bulk"
+#else
+#define LOADING "insert"
+#endif
+
+#define RELATION    "bench"
+#define NTUPLES     20000
+#define NINSERTS    1000
+/* Keys of the int domain are 16-bit */
+#define NKEYS       30000
+#define NRANGES     8
+#define QUERY_LEN   128
+
+static uint32_t g_seed = 1;
+static int *g_keys;
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int exec(const char *fmt, ...)
+{
+	char query[QUERY_LEN];
+	va_list ap;
+	db_result_t res;
+
+	va_start(ap, fmt);
+	vsnprintf(query, sizeof(query), fmt, ap);
+	va_end(ap);
+
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		fprintf(stderr, "%s failed: %d\n", query, res);
+		return ERROR;
+	}
+	return OK;
+}
+
+static int insert(int first, int count)
+{
+	int i;
+
+	for (i = first; i < first + count; i++) {
+		g_keys[i] = rnd() % NKEYS;
+		if (exec("INSERT (%d, %d) INTO %s;", g_keys[i], i, RELATION) != OK) {
+			return ERROR;
+		}
+	}
+	return OK;
+}
+
+/* Check the number of tuples and the sum of their ids of range queries */
+
+static int check(int ntuples)
+{
+	char query[QUERY_LEN];
+	db_cursor_t *cursor;
+	long expected;
+	long sum;
+	int rows;
+	int min;
+	int max;
+	int i;
+	int j;
+
+	for (i = 0; i < NRANGES; i++) {
+		min = i * (NKEYS / NRANGES);
+		max = min + (i + 1) * 100;
+		expected = 0;
+		for (j = 0; j < ntuples; j++) {
+			if (g_keys[j] >= min && g_keys[j] <= max) {
+				expected += j + 1;
+			}
+		}
+
+		snprintf(query, sizeof(query), "SELECT key, seq FROM %s WHERE key >= %d AND key <= %d;", RELATION, min, max);
+		cursor = db_query(query);
+		if (cursor == NULL) {
+			fprintf(stderr, "%s failed\n", query);
+			return ERROR;
+		}
+
+		sum = 0;
+		rows = cursor_get_count(cursor);
+		if (rows > 0 && DB_SUCCESS(cursor_move_first(cursor))) {
+			for (j = 0; j < rows; j++) {
+				sum += cursor_get_long_value(cursor, 1) + 1;
+				if (j + 1 < rows && DB_ERROR(cursor_move_next(cursor))) {
+					break;
+				}
+			}
+		}
+		db_cursor_free(cursor);
+
+		if (sum != expected) {
+			fprintf(stderr, "keys %d to %d: got %d rows sum %ld, expected sum %ld\n", min, max, rows, sum, expected);
+			return ERROR;
+		}
+	}
+	return OK;
+}
+
+/* Start from an empty database directory */
+
+static void clean_db(void)
+{
+	char path[64];
+	struct dirent *entry;
+	DIR *dir;
+
+	dir = opendir(CONFIG_MOUNT_POINT);
+	if (dir == NULL) {
+		mkdir(CONFIG_MOUNT_POINT, 0755);
+		return;
+	}
+
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			snprintf(path, sizeof(path), "%s%s", CONFIG_MOUNT_POINT, entry->d_name);
+			unlink(path);
+		}
+	}
+	closedir(dir);
+}
+
+int main(int argc, char **argv)
+{
+	int ntuples = argc > 1 ? atoi(argv[1]) : NTUPLES;
+	double t0;
+	double create_ms;
+	double insert_ms;
+
+	if (ntuples <= 0 || ntuples + NINSERTS > CONFIG_DB_TUPLES_LIMIT) {
+		fprintf(stderr, "usage: %s [tuples, up to %d]\n", argv[0], CONFIG_DB_TUPLES_LIMIT - NINSERTS);
+		return 1;
+	}
+
+	g_keys = malloc((ntuples + NINSERTS) * sizeof(int));
+	if (g_keys == NULL) {
+		return 1;
+	}
+
+	clean_db();
+
+	if (db_init() != DB_OK) {
+		fprintf(stderr, "db_init failed\n");
+		return 1;
+	}
+
+	if (exec("CREATE RELATION %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE key DOMAIN int IN %s;", RELATION) != OK ||
+		exec("CREATE ATTRIBUTE seq DOMAIN long IN %s;", RELATION) != OK ||
+		insert(0, ntuples) != OK) {
+		return 1;
+	}
+
+	t0 = now_ms();
+	if (exec("CREATE INDEX %s.key TYPE bplustree;", RELATION) != OK) {
+		return 1;
+	}
+	create_ms = now_ms() - t0;
+
+	t0 = now_ms();
+	if (insert(ntuples, NINSERTS) != OK) {
+		return 1;
+	}
+	insert_ms = now_ms() - t0;
+
+	if (check(ntuples + NINSERTS) != OK) {
+		return 1;
+	}
+
+	/* The index is loaded again from its files */
+
+	db_deinit();
+	if (db_init() != DB_OK || check(ntuples + NINSERTS) != OK) {
+		return 1;
+	}
+
+	printf("%s: %d tuples, %d keys\n", LOADING, ntuples, NKEYS);
+	printf("  create index %10.2f ms  %9.0f keys/s\n", create_ms, ntuples * 1000.0 / create_ms);
+	printf("  insert       %10.2f ms  %9.0f tuples/s\n", insert_ms, NINSERTS * 1000.0 / insert_ms);
+
+	db_deinit();
+	clean_db();
+	free(g_keys);
+	return 0;
+}
@@ -0,0 +1,46 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/* Host build of the arastorage sources, forced into each of them with
+ * -include tinyara/config.h as the TizenRT C library headers would pull it
+ * in.  A relation of 10000 tuples fits the cursor.
+ */
+
+#ifndef __TOOLS_ARASTORAGE_BENCH_BENCH_CONFIG_H
+#define __TOOLS_ARASTORAGE_BENCH_BENCH_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <fcntl.h>
+
+#define CONFIG_ARASTORAGE 1
+#define CONFIG_NODE_LIMIT 4000
+#define CONFIG_BUCKETS_LIMIT 4000
+#define CONFIG_BRANCH_FACTOR 5
+#define CONFIG_DB_TUPLES_LIMIT 100000
+#define CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER 1
+#define CONFIG_MOUNT_POINT "bench_db/"
+
+#define DB_TUPLE_LIMIT CONFIG_DB_TUPLES_LIMIT
+
+#define O_RDOK O_RDONLY
+#define O_WROK O_WRONLY
+
+#endif
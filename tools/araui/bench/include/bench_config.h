@@ -0,0 +1,32 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/* Host build of the araui renderer, with the display of the simulator */
+
+#ifndef __TOOLS_ARAUI_BENCH_BENCH_CONFIG_H
+#define __TOOLS_ARAUI_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_UI
+#define CONFIG_UI_DISPLAY_RGB888
+#define CONFIG_UI_USE_BUILTIN_EMOJI
+
+#define CONFIG_UI_DISPLAY_WIDTH  (360)
+#define CONFIG_UI_DISPLAY_HEIGHT (360)
+
+#endif
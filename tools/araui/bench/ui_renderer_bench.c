@@ -0,0 +1,267 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Benchmark of the araui renderer built for the host.  The same source is
+ * linked with and without CONFIG_UI_RENDERER_FAST_BLIT.
+ *
+ * The builtin emoji, a full screen image and antialiased glyphs are rendered
+ * the way the image and text widgets do, into an off-screen RGB888 buffer
+ * which stands for the DAL.  For each case the pixels covered per second are
+ * reported with a checksum of the buffer.  Both builds cover the same pixels,
+ * but may sample a texel one off from each other, so the checksums can differ.
+ *
+ * Each case is run several times and keeps its fastest time.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <araui/ui_commons.h>
+#include "ui_renderer.h"
+#include "ui_asset_internal.h"
+#include "utils/emoji.h"
+#include "dal/ui_dal.h"
+
+#define WIDTH      CONFIG_UI_DISPLAY_WIDTH
+#define HEIGHT     CONFIG_UI_DISPLAY_HEIGHT
+#define NRUNS      5
+#define NEMOJI     (0x1f644 - 0x1f600 + 1)
+#define GLYPH_SIZE 24
+
+static uint8_t g_fb[WIDTH * HEIGHT * 3];
+static uint8_t g_image[WIDTH * HEIGHT * 3];
+static uint8_t g_glyph[GLYPH_SIZE * GLYPH_SIZE];
+
+/* Off-screen DAL, blending the same way as the simulator */
+
+UI_DAL void ui_dal_put_pixel_rgba8888(int32_t x, int32_t y, ui_color_t color)
+{
+	ui_color_rgba8888_t *fg;
+	uint8_t *bg;
+
+	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+		return;
+	}
+
+	fg = (ui_color_rgba8888_t *)&color;
+	bg = &g_fb[(y * WIDTH + x) * 3];
+	bg[0] = ((fg->r * fg->a) + (bg[0] * (255 - fg->a))) / 255;
+	bg[1] = ((fg->g * fg->a) + (bg[1] * (255 - fg->a))) / 255;
+	bg[2] = ((fg->b * fg->a) + (bg[2] * (255 - fg->a))) / 255;
+}
+
+UI_DAL void ui_dal_put_pixel_rgb888(int32_t x, int32_t y, ui_color_t color)
+{
+	uint8_t *bg;
+
+	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
+		return;
+	}
+
+	bg = &g_fb[(y * WIDTH + x) * 3];
+	bg[0] = color & 0xff;
+	bg[1] = (color >> 8) & 0xff;
+	bg[2] = (color >> 16) & 0xff;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t checksum(void)
+{
+	uint32_t sum = 2166136261u;
+	int i;
+
+	for (i = 0; i < (int)sizeof(g_fb); i++) {
+		sum = (sum ^ g_fb[i]) * 16777619u;
+	}
+
+	return sum;
+}
+
+/* A quad of the size of the widget, as ui_image_widget does */
+
+static void draw(ui_mat3_t *mat, float w, float h)
+{
+	ui_render_quad_uv(mat,
+		(ui_vec3_t){ 0.0f, 0.0f, 1.0f },
+		(ui_vec3_t){ 0.0f, h, 1.0f },
+		(ui_vec3_t){ w, h, 1.0f },
+		(ui_vec3_t){ w, 0.0f, 1.0f },
+		(ui_uv_t){ 0.0f, 0.0f },
+		(ui_uv_t){ 0.0f, 1.0f },
+		(ui_uv_t){ 1.0f, 1.0f },
+		(ui_uv_t){ 1.0f, 0.0f });
+}
+
+static void set_emoji(int idx)
+{
+	ui_bitmap_data_t *bitmap = emoji_get_bitmap(0x1f600 + idx);
+
+	ui_renderer_set_texture((uint8_t *)bitmap + sizeof(ui_bitmap_data_t), bitmap->width, bitmap->height, bitmap->pf);
+}
+
+/* Each case returns the number of pixels covered */
+
+static long case_emoji(float scale, int32_t deg)
+{
+	ui_mat3_t identity = ui_mat3_identity();
+	ui_mat3_t mat;
+	float size = 40.0f * scale;
+	int per_row = (int)(WIDTH / size);
+	long pixels = 0;
+	int i;
+
+	for (i = 0; i < NEMOJI; i++) {
+		set_emoji(i);
+		ui_renderer_translate(&identity, &mat, (i % per_row) * size, ((i / per_row) * size) - (int)((i / per_row) * size / HEIGHT) * HEIGHT);
+		ui_renderer_rotate(&mat, deg);
+		ui_renderer_scale(&mat, scale, scale);
+		draw(&mat, 40.0f, 40.0f);
+		pixels += (long)(size * size);
+	}
+
+	return pixels;
+}
+
+static long case_image(void)
+{
+	ui_mat3_t identity = ui_mat3_identity();
+	ui_mat3_t mat;
+
+	ui_renderer_set_texture(g_image, WIDTH, HEIGHT, UI_PIXEL_FORMAT_RGB888);
+	ui_renderer_translate(&identity, &mat, 0.0f, 0.0f);
+	draw(&mat, WIDTH, HEIGHT);
+
+	return (long)WIDTH * HEIGHT;
+}
+
+/* Lines of glyphs placed like ui_text_widget, with a fractional baseline */
+
+static long case_text(void)
+{
+	ui_mat3_t identity = ui_mat3_identity();
+	ui_mat3_t mat;
+	long pixels = 0;
+	int x;
+	int y;
+
+	ui_renderer_set_texture(g_glyph, GLYPH_SIZE, GLYPH_SIZE, UI_PIXEL_FORMAT_A8);
+	ui_renderer_set_fill_color(0xffffff);
+
+	for (y = 0; y + GLYPH_SIZE <= HEIGHT; y += GLYPH_SIZE + 4) {
+		for (x = 0; x + GLYPH_SIZE <= WIDTH; x += GLYPH_SIZE - 6) {
+			ui_renderer_translate(&identity, &mat, (float)x, y + 0.4f);
+			draw(&mat, GLYPH_SIZE, GLYPH_SIZE);
+			pixels += GLYPH_SIZE * GLYPH_SIZE;
+		}
+	}
+
+	return pixels;
+}
+
+static void make_assets(void)
+{
+	int x;
+	int y;
+	int d;
+
+	for (y = 0; y < HEIGHT; y++) {
+		for (x = 0; x < WIDTH; x++) {
+			g_image[(y * WIDTH + x) * 3 + 0] = x;
+			g_image[(y * WIDTH + x) * 3 + 1] = y;
+			g_image[(y * WIDTH + x) * 3 + 2] = x ^ y;
+		}
+	}
+
+	/* An antialiased ring, mostly transparent like a glyph */
+
+	for (y = 0; y < GLYPH_SIZE; y++) {
+		for (x = 0; x < GLYPH_SIZE; x++) {
+			d = (x - GLYPH_SIZE / 2) * (x - GLYPH_SIZE / 2) + (y - GLYPH_SIZE / 2) * (y - GLYPH_SIZE / 2);
+			d = abs(d - (GLYPH_SIZE * GLYPH_SIZE) / 9);
+			g_glyph[y * GLYPH_SIZE + x] = d < 24 ? 255 - d * 10 : 0;
+		}
+	}
+}
+
+static void run(const char *name, long (*fn)(void))
+{
+	uint64_t best = UINT64_MAX;
+	uint64_t t0;
+	uint64_t dt;
+	long pixels = 0;
+	int i;
+
+	for (i = 0; i < NRUNS; i++) {
+		memset(g_fb, 0, sizeof(g_fb));
+		t0 = now_ns();
+		pixels = fn();
+		dt = now_ns() - t0;
+		if (dt < best) {
+			best = dt;
+		}
+	}
+
+	printf("  %-12s %8ld px  %8.1f us  %7.1f Mpx/s  checksum %08x\n",
+		   name, pixels, best / 1000.0, pixels * 1000.0 / best, checksum());
+}
+
+static long emoji_1x(void)
+{
+	return case_emoji(1.0f, 0);
+}
+
+static long emoji_2x(void)
+{
+	return case_emoji(2.0f, 0);
+}
+
+static long emoji_rot(void)
+{
+	return case_emoji(1.0f, 30);
+}
+
+int main(void)
+{
+	make_assets();
+
+#ifdef CONFIG_UI_RENDERER_FAST_BLIT
+	printf("blit:\n");
+#else
+	printf("triangle:\n");
+#endif
+	run("emoji", emoji_1x);
+	run("emoji x2", emoji_2x);
+	run("emoji rot30", emoji_rot);
+	run("image", case_image);
+	run("text", case_text);
+
+	return 0;
+}
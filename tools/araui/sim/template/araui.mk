@@ -33,6 +33,7 @@ CSRCS += $(UIFW_DIR)/core/ui_quick_panel.c
 CSRCS += $(UIFW_DIR)/core/ui_commons.c
 CSRCS += $(UIFW_DIR)/assets/ui_asset.c
 CSRCS += $(UIFW_DIR)/assets/ui_font_asset.c
+CSRCS += $(UIFW_DIR)/assets/ui_glyph_cache.c
 CSRCS += $(UIFW_DIR)/assets/ui_image_asset.c
 CSRCS += $(UIFW_DIR)/widgets/ui_button_widget.c
 CSRCS += $(UIFW_DIR)/widgets/ui_paginator_widget.c
@@ -155,6 +155,24 @@ UI_DAL void ui_dal_redraw(int32_t x, int32_t y, int32_t width, int32_t height)
 	pthread_mutex_unlock(&g_mutex);
 }
 
+#if defined(CONFIG_UI_PARTIAL_UPDATE)
+UI_DAL void ui_dal_redraw_rects(const ui_rect_t *rects, int num)
+{
+	int32_t offset;
+	int idx;
+	int i;
+
+	pthread_mutex_lock(&g_mutex);
+	for (idx = 0; idx < num; idx++) {
+		for (i = 0; i < rects[idx].height; i++) {
+			offset = ((rects[idx].y + i) * CONFIG_UI_DISPLAY_WIDTH + rects[idx].x) * 3;
+			memcpy(&g_fb[FRONT_PAGE][offset], &g_fb[BACK_PAGE][offset], rects[idx].width * 3);
+		}
+	}
+	pthread_mutex_unlock(&g_mutex);
+}
+#endif
+
 UI_DAL void ui_dal_clear(void)
 {
 	memset(g_fb[BACK_PAGE], 0, FB_SIZE);
@@ -9,13 +9,16 @@
 #define CONFIG_UI_DISPLAY_RGB888
 #define CONFIG_UI_ENABLE_TOUCH
 #define CONFIG_UI_ENABLE_EMOJI
+#define CONFIG_UI_RENDERER_FAST_BLIT
+#define CONFIG_UI_GLYPH_CACHE
+#define CONFIG_UI_GLYPH_CACHE_SIZE 16384
 
 //!< Values
 #define CONFIG_UI_TOUCH_THRESHOLD     (10)
 #define CONFIG_UI_DISPLAY_WIDTH       (360)
 #define CONFIG_UI_DISPLAY_HEIGHT      (360)
 #define CONFIG_UI_STACK_SIZE          (8192)
-#define CONFIG_UI_UPDATE_MEMPOOL_SIZE (128)
+#define CONFIG_UI_REDRAW_TILE_NUM     (8)
 #define CONFIG_UI_MAXIMUM_FPS         (30)
 #define CONFIG_UI_DISPLAY_SCALE       (1)
 
@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: the assertions of TinyAra, DEBUGASSERT() is checked with
+ * CONFIG_DEBUG as on the target
+ */
+
+#ifndef __TOOLS_BENCH_ASSERT_H
+#define __TOOLS_BENCH_ASSERT_H
+
+#include <tinyara/config.h>
+#include_next <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PANIC() abort()
+#define ASSERT(x) do { if (!(x)) { fprintf(stderr, "assertion failed %s:%d\n", __FILE__, __LINE__); abort(); } } while (0)
+
+#ifdef CONFIG_DEBUG
+#define DEBUGASSERT(x) ASSERT(x)
+#else
+#define DEBUGASSERT(x)
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: debug output is disabled */
+
+#ifndef __TOOLS_BENCH_DEBUG_H
+#define __TOOLS_BENCH_DEBUG_H
+
+#include <tinyara/config.h>
+#include <assert.h>
+
+#define dbg(...)
+#define vdbg(...)
+#define lldbg(...)
+#define llvdbg(...)
+
+#define berr(...)
+#define bwarn(...)
+#define binfo(...)
+#define bcmpdbg(...)
+#define bcmpvdbg(...)
+
+#define fdbg(...)
+#define fvdbg(...)
+#define flldbg(...)
+#define fllvdbg(...)
+
+#define lwipdbg(...)
+
+#define mdbg(...)
+#define mvdbg(...)
+#define mlldbg(...)
+#define mllvdbg(...)
+
+#define meddbg(...)
+#define medvdbg(...)
+#define medwdbg(...)
+
+#define prefdbg(...)
+#define prefvdbg(...)
+
+#define ttdbg(...)
+
+#define uidbg(...)
+#define uivdbg(...)
+#define uiwdbg(...)
+
+#endif
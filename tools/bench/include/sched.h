@@ -0,0 +1,34 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: the task interfaces of TinyAra, next to the host scheduler
+ * interface.  A bench that uses them implements them.
+ */
+
+#ifndef __TOOLS_BENCH_SCHED_H
+#define __TOOLS_BENCH_SCHED_H
+
+#include_next <sched.h>
+
+typedef int (*main_t)(int argc, char *argv[]);
+
+int task_create(const char *name, int priority, int stack_size, main_t entry, char *const argv[]);
+int sched_lock(void);
+int sched_unlock(void);
+
+#endif
@@ -0,0 +1,30 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: host semaphores have no static initializer, a bench which
+ * uses SEM_INITIALIZER() initializes them with sem_init()
+ */
+
+#ifndef __TOOLS_BENCH_SEMAPHORE_H
+#define __TOOLS_BENCH_SEMAPHORE_H
+
+#include_next <semaphore.h>
+
+#define SEM_INITIALIZER(c) { }
+
+#endif
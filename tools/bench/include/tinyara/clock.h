@@ -0,0 +1,47 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: the system timer counts the milliseconds of the monotonic
+ * clock of the host
+ */
+
+#ifndef __TOOLS_BENCH_CLOCK_H
+#define __TOOLS_BENCH_CLOCK_H
+
+#include <time.h>
+
+#define MSEC_PER_SEC  1000
+#define USEC_PER_SEC  1000000
+#define NSEC_PER_SEC  1000000000
+#define USEC_PER_MSEC 1000
+#define NSEC_PER_MSEC 1000000
+#define NSEC_PER_USEC 1000
+
+#define MSEC_PER_TICK 1
+#define TICK2MSEC(tick) (tick)
+#define MSEC2TICK(msec) (msec)
+
+static inline clock_t clock_systimer(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (clock_t)ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the tools/<area>/bench programs: the options of a bench are in
+ * bench_config.h of its include directory, followed by what the headers of
+ * TinyAra provide to all of them.
+ */
+
+#ifndef __TOOLS_BENCH_CONFIG_H
+#define __TOOLS_BENCH_CONFIG_H
+
+#if __has_include(<bench_config.h>)
+#include <bench_config.h>
+#endif
+
+#define CONFIG_CPP_HAVE_VARARGS 1
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#ifndef FAR
+#define FAR
+#endif
+
+#define OK 0
+#define ERROR -1
+#define TRUE 1
+#define FALSE 0
+
+#ifndef get_errno
+#define get_errno() errno
+#define get_errno_ptr() (&errno)
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build: the kernel semaphore interfaces over the host semaphores,
+ * which have no priority inheritance.  The system timer counts
+ * milliseconds, see tinyara/clock.h.
+ */
+
+#ifndef __TOOLS_BENCH_TINYARA_SEMAPHORE_H
+#define __TOOLS_BENCH_TINYARA_SEMAPHORE_H
+
+#include <tinyara/config.h>
+#include <semaphore.h>
+#include <tinyara/clock.h>
+
+#define SEM_PRIO_NONE        0
+#define SEM_PRIO_INHERIT     1
+#define SEM_PRIO_PROTECT     2
+
+static inline int sem_setprotocol(FAR sem_t *sem, int protocol)
+{
+	return OK;
+}
+
+static inline int sem_tickwait(FAR sem_t *sem, clock_t start, uint32_t delay)
+{
+	struct timespec abstime;
+	clock_t remaining = start + delay - clock_systimer();
+
+	if (remaining < 0) {
+		remaining = 0;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &abstime);
+	abstime.tv_sec += remaining / MSEC_PER_SEC;
+	abstime.tv_nsec += (remaining % MSEC_PER_SEC) * NSEC_PER_MSEC;
+	if (abstime.tv_nsec >= NSEC_PER_SEC) {
+		abstime.tv_sec++;
+		abstime.tv_nsec -= NSEC_PER_SEC;
+	}
+
+	return sem_timedwait(sem, &abstime) == OK ? OK : -errno;
+}
+
+#endif
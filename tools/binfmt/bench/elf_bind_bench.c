@@ -0,0 +1,317 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Symbol binding of os/binfmt/libelf built for the host.
+ *
+ * A relocatable ELF module is generated in RAM, which stands for the flash
+ * the module is loaded from.  Its relocations are against a section symbol
+ * and against symbols imported from the export table generated by mksymtab,
+ * the most used symbols being referenced by most relocations like calls to
+ * a few library functions.  elf_bind() is then timed with the same table
+ * searched linearly, by binary search, or through its perfect hash.
+ *
+ * Each relocation is checked against the value of its symbol, and the
+ * number of export table lookups and of reads of the module are reported.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <debug.h>
+
+#include <tinyara/elf.h>
+#include <tinyara/binfmt/elf.h>
+#include <tinyara/binfmt/symtab.h>
+
+#if defined(CONFIG_SYMTAB_ORDEREDBYNAME)
+#define LOOKUP "ordered"
+#elif defined(CONFIG_SYMTAB_PERFECTHASH)
+#define LOOKUP "phash"
+#else
+#define LOOKUP "linear"
+#endif
+
+#define NRUNS      20
+#define NSECTIONS  5
+#define TEXT_ADDR  0x10000
+
+/* Generated by mksymtab */
+
+extern struct symtab_s g_symtab[];
+extern const int g_nsymbols;
+
+static uint8_t *g_image;
+static size_t g_imagelen;
+static uint32_t *g_expected;
+static uint32_t g_seed = 1;
+
+static unsigned long g_nlookups;
+static unsigned long g_nreads;
+static unsigned long g_nreadbytes;
+static unsigned long g_nerrors;
+
+FAR const struct symtab_s *__real_symtab_findbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms);
+FAR const struct symtab_s *__real_symtab_findorderedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms);
+FAR const struct symtab_s *__real_symtab_findhashedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms);
+
+FAR const struct symtab_s *__wrap_symtab_findbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms)
+{
+	g_nlookups++;
+	return __real_symtab_findbyname(symtab, name, nsyms);
+}
+
+FAR const struct symtab_s *__wrap_symtab_findorderedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms)
+{
+	g_nlookups++;
+	return __real_symtab_findorderedbyname(symtab, name, nsyms);
+}
+
+FAR const struct symtab_s *__wrap_symtab_findhashedbyname(FAR const struct symtab_s *symtab, FAR const char *name, int nsyms)
+{
+	g_nlookups++;
+	return __real_symtab_findhashedbyname(symtab, name, nsyms);
+}
+
+/* The module is read from RAM instead of the file system */
+
+int elf_read(FAR struct elf_loadinfo_s *loadinfo, FAR uint8_t *buffer, size_t readsize, off_t offset)
+{
+	if (offset < 0 || offset + readsize > g_imagelen) {
+		return -EINVAL;
+	}
+
+	memcpy(buffer, g_image + offset, readsize);
+	g_nreads++;
+	g_nreadbytes += readsize;
+	return OK;
+}
+
+/* Only checks the value of the symbol, the text isn't in the host memory */
+
+int up_relocate(FAR const Elf32_Rel *rel, FAR const Elf32_Sym *sym, uintptr_t addr)
+{
+	if (!sym || sym->st_value != g_expected[ELF32_R_SYM(rel->r_info)]) {
+		g_nerrors++;
+	}
+
+	return OK;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Entries of the table, skipping the hash parameters and the placeholders
+ * of the symbols excluded by their condition
+ */
+
+static int get_exports(FAR const struct symtab_s **exports)
+{
+	int nexports = 0;
+	int i;
+
+	for (i = 0; i < g_nsymbols; i++) {
+		if (g_symtab[i].sym_name[0] != '\0') {
+			exports[nexports++] = &g_symtab[i];
+		}
+	}
+
+	return nexports;
+}
+
+/* ELF header, section headers, .text, .rel.text, .symtab and .strtab */
+
+static void make_module(FAR struct elf_loadinfo_s *loadinfo, int nrelocs, int nimports)
+{
+	FAR const struct symtab_s **exports;
+	FAR Elf32_Shdr *shdr;
+	FAR Elf32_Rel *rel;
+	FAR Elf32_Sym *sym;
+	FAR char *strtab;
+	size_t strsize;
+	size_t off;
+	int nexports;
+	int nsyms = nimports + 2;
+	int i;
+	int j;
+
+	exports = malloc(g_nsymbols * sizeof(*exports));
+	nexports = get_exports(exports);
+	if (nimports > nexports) {
+		nimports = nexports;
+		nsyms = nimports + 2;
+	}
+
+	/* Import distinct symbols, in random order */
+
+	for (i = 0; i < nimports; i++) {
+		j = i + rnd() % (nexports - i);
+		FAR const struct symtab_s *tmp = exports[i];
+		exports[i] = exports[j];
+		exports[j] = tmp;
+	}
+
+	strsize = 1;
+	for (i = 0; i < nimports; i++) {
+		strsize += strlen(exports[i]->sym_name) + 1;
+	}
+
+	shdr = calloc(NSECTIONS, sizeof(Elf32_Shdr));
+	off = sizeof(Elf32_Ehdr) + NSECTIONS * sizeof(Elf32_Shdr);
+
+	shdr[1].sh_type = SHT_PROGBITS;
+	shdr[1].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+	shdr[1].sh_addr = TEXT_ADDR;
+	shdr[1].sh_offset = off;
+	shdr[1].sh_size = nrelocs * sizeof(uint32_t);
+	off += shdr[1].sh_size;
+
+	shdr[2].sh_type = SHT_REL;
+	shdr[2].sh_link = 3;
+	shdr[2].sh_info = 1;
+	shdr[2].sh_offset = off;
+	shdr[2].sh_size = nrelocs * sizeof(Elf32_Rel);
+	off += shdr[2].sh_size;
+
+	shdr[3].sh_type = SHT_SYMTAB;
+	shdr[3].sh_link = 4;
+	shdr[3].sh_info = 2;
+	shdr[3].sh_offset = off;
+	shdr[3].sh_size = nsyms * sizeof(Elf32_Sym);
+	off += shdr[3].sh_size;
+
+	shdr[4].sh_type = SHT_STRTAB;
+	shdr[4].sh_offset = off;
+	shdr[4].sh_size = strsize;
+	off += strsize;
+
+	g_imagelen = off;
+	g_image = calloc(1, g_imagelen);
+	g_expected = calloc(nsyms, sizeof(*g_expected));
+	memcpy(g_image + sizeof(Elf32_Ehdr), shdr, NSECTIONS * sizeof(Elf32_Shdr));
+
+	/* Symbol 1 is the .text section, the others are imported */
+
+	sym = (FAR Elf32_Sym *)(g_image + shdr[3].sh_offset);
+	strtab = (FAR char *)(g_image + shdr[4].sh_offset);
+
+	sym[1].st_info = ELF32_ST_INFO(0, STT_SECTION);
+	sym[1].st_shndx = 1;
+	g_expected[1] = TEXT_ADDR;
+
+	off = 1;
+	for (i = 0; i < nimports; i++) {
+		sym[i + 2].st_name = off;
+		sym[i + 2].st_info = ELF32_ST_INFO(STB_GLOBAL, STT_FUNC);
+		sym[i + 2].st_shndx = SHN_UNDEF;
+		strcpy(&strtab[off], exports[i]->sym_name);
+		off += strlen(exports[i]->sym_name) + 1;
+		g_expected[i + 2] = (uint32_t)(uintptr_t)exports[i]->sym_value;
+	}
+
+	/* One relocation in 8 is against the section, the others mostly against
+	 * the first imported symbols.
+	 */
+
+	rel = (FAR Elf32_Rel *)(g_image + shdr[2].sh_offset);
+	for (i = 0; i < nrelocs; i++) {
+		uint32_t u = rnd() % 1024;
+
+		if ((rnd() & 7) == 0) {
+			j = 1;
+		} else {
+			j = 2 + (u * u / 1024) * nimports / 1024;
+		}
+
+		rel[i].r_offset = i * sizeof(uint32_t);
+		rel[i].r_info = ELF32_R_INFO(j, 2);
+	}
+
+	memset(loadinfo, 0, sizeof(*loadinfo));
+	loadinfo->ehdr.e_type = ET_REL;
+	loadinfo->ehdr.e_shnum = NSECTIONS;
+	loadinfo->shdr = shdr;
+	loadinfo->filelen = g_imagelen;
+
+	printf(LOOKUP ": %d exports, %d relocations against %d imported symbols\n", nexports, nrelocs, nimports);
+	free(exports);
+}
+
+int main(int argc, char **argv)
+{
+	struct elf_loadinfo_s module;
+	struct elf_loadinfo_s loadinfo;
+	uint64_t best = UINT64_MAX;
+	uint64_t t0;
+	uint64_t dt;
+	int nrelocs = argc > 1 ? atoi(argv[1]) : 8000;
+	int nimports = argc > 2 ? atoi(argv[2]) : 400;
+	int ret;
+	int i;
+
+	if (nrelocs <= 0 || nimports <= 0) {
+		fprintf(stderr, "usage: %s [relocations] [imported symbols]\n", argv[0]);
+		return 1;
+	}
+
+	make_module(&module, nrelocs, nimports);
+
+	for (i = 0; i < NRUNS; i++) {
+		loadinfo = module;
+		g_nlookups = 0;
+		g_nreads = 0;
+		g_nreadbytes = 0;
+
+		t0 = now_ns();
+		ret = elf_bind(&loadinfo, g_symtab, g_nsymbols);
+		dt = now_ns() - t0;
+
+		free(loadinfo.iobuffer);
+		if (ret != OK || g_nerrors) {
+			fprintf(stderr, "elf_bind failed: %d, %lu bad relocations\n", ret, g_nerrors);
+			return 1;
+		}
+
+		if (dt < best) {
+			best = dt;
+		}
+	}
+
+	printf("  %lu lookups, %lu reads (%lu bytes), bind %.1f us\n", g_nlookups, g_nreads, g_nreadbytes, best / 1000.0);
+
+	free(module.shdr);
+	free(g_image);
+	free(g_expected);
+	return 0;
+}
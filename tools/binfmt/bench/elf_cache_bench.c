@@ -0,0 +1,414 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Block cache and read ahead of compressed binaries of os/binfmt/libelf,
+ * built for the host with os/compression and miniz.
+ *
+ * A binary laid out like an ELF module, .text and .data followed by its
+ * relocations, symbol table and string table, is compressed by blocks into
+ * a file like the binaries made by os/tools/compression.  Its load is then
+ * replayed through elf_read(): the ELF header and the section headers, the
+ * sections copied to RAM in one read each, then the relocations read one by
+ * one, each with its symbol and the name of the symbol, and some work for
+ * each relocation.  The data read is checked against the binary.
+ *
+ * The low priority work queue is a thread.  The reads of the flash take the
+ * time given on the command line, during which the thread reading waits
+ * like for a DMA transfer and the other thread can run, so that the block
+ * read ahead is decompressed while the loader reads the flash or works even
+ * on a single core.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <debug.h>
+
+#include <tinyara/binfmt/elf.h>
+#include <tinyara/binfmt/compression/compress_read.h>
+#include <tinyara/miniz/miniz.h>
+#include <tinyara/wqueue.h>
+
+#include "libelf.h"
+
+#if defined(CONFIG_ELF_CACHE_READAHEAD)
+#define CACHE "readahead"
+#elif defined(CONFIG_ELF_CACHE_READ)
+#define CACHE "cache"
+#else
+#define CACHE "nocache"
+#endif
+
+#define NRUNS       10
+#define HEADER_SIZE 48			/* Binary header of the binary manager */
+#define RELSIZE     8
+#define SYMSIZE     16
+#define NAMESIZE    24
+
+static uint8_t *g_image;
+static size_t g_imagelen;
+static uint32_t g_seed = 1;
+static unsigned long g_ndecompress;
+static unsigned long g_nerrors;
+static volatile uint32_t g_sink;
+static int g_flash_us;
+
+/* Sections of the binary */
+
+static size_t g_text;
+static size_t g_data;
+static size_t g_rel;
+static size_t g_symtab;
+static size_t g_strtab;
+static size_t g_shdrs;
+
+int __real_mz_uncompress(unsigned char *dst, mz_ulong *dstlen, const unsigned char *src, mz_ulong srclen);
+
+int __wrap_mz_uncompress(unsigned char *dst, mz_ulong *dstlen, const unsigned char *src, mz_ulong srclen)
+{
+	__sync_fetch_and_add(&g_ndecompress, 1);
+	return __real_mz_uncompress(dst, dstlen, src, srclen);
+}
+
+/* Reads of the flash, g_flash_us per KB */
+
+ssize_t __real_read(int fd, void *buf, size_t len);
+
+ssize_t __wrap_read(int fd, void *buf, size_t len)
+{
+	struct timespec ts;
+	long ns = (long)g_flash_us * 1000 * len / 1024;
+
+	if (ns > 0) {
+		ts.tv_sec = ns / 1000000000;
+		ts.tv_nsec = ns % 1000000000;
+		nanosleep(&ts, NULL);
+	}
+
+	return __real_read(fd, buf, len);
+}
+
+/* Low priority work queue: a thread running the queued work in order */
+
+static pthread_mutex_t g_wqlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_wqcond = PTHREAD_COND_INITIALIZER;
+static struct work_s *g_wqhead;
+
+int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, long delay)
+{
+	struct work_s **pp;
+
+	pthread_mutex_lock(&g_wqlock);
+	for (pp = &g_wqhead; *pp && *pp != work; pp = &(*pp)->next) {
+	}
+
+	work->worker = worker;
+	work->arg = arg;
+	if (!*pp) {
+		work->next = NULL;
+		*pp = work;
+	}
+
+	pthread_cond_signal(&g_wqcond);
+	pthread_mutex_unlock(&g_wqlock);
+	return OK;
+}
+
+int work_cancel(int qid, FAR struct work_s *work)
+{
+	struct work_s **pp;
+	int ret = -ENOENT;
+
+	pthread_mutex_lock(&g_wqlock);
+	for (pp = &g_wqhead; *pp; pp = &(*pp)->next) {
+		if (*pp == work) {
+			*pp = work->next;
+			work->worker = NULL;
+			ret = OK;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&g_wqlock);
+	return ret;
+}
+
+static void *work_thread(void *arg)
+{
+	struct work_s *work;
+	worker_t worker;
+
+	for (;;) {
+		pthread_mutex_lock(&g_wqlock);
+		while (!g_wqhead) {
+			pthread_cond_wait(&g_wqcond, &g_wqlock);
+		}
+
+		work = g_wqhead;
+		g_wqhead = work->next;
+		worker = work->worker;
+		work->worker = NULL;
+		pthread_mutex_unlock(&g_wqlock);
+
+		worker(work->arg);
+	}
+
+	return NULL;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Words of a few kinds, which compress like code and tables do */
+
+static void make_image(size_t len)
+{
+	static const uint32_t words[] = {
+		0xb5f0b083, 0x4604460d, 0xf7ff4620, 0x68236862, 0xe8bdbd70, 0x2000bf00,
+		0x46204629, 0xf1040108, 0x9b019a02, 0x00000000, 0xffffffff, 0x20004000,
+	};
+	size_t i;
+
+	g_imagelen = len & ~3;
+	g_image = malloc(g_imagelen);
+	for (i = 0; i < g_imagelen; i += 4) {
+		uint32_t word = words[rnd() % 12];
+
+		if ((rnd() & 7) == 0) {
+			word ^= rnd();
+		}
+		memcpy(&g_image[i], &word, 4);
+	}
+
+	/* .text 64%, .data 8%, .rel 18%, .symtab 6%, .strtab and headers */
+
+	g_text = 64;
+	g_data = g_text + g_imagelen * 64 / 100;
+	g_rel = g_data + g_imagelen * 8 / 100;
+	g_symtab = g_rel + g_imagelen * 18 / 100;
+	g_strtab = g_symtab + g_imagelen * 6 / 100;
+	g_shdrs = g_imagelen - 400;
+}
+
+/* Compressed binary: binary header, compression header, blocks */
+
+static int write_compressed(const char *path, int blocksize)
+{
+	struct s_header *hdr;
+	unsigned char *out;
+	mz_ulong outlen;
+	int nblocks = (g_imagelen + blocksize - 1) / blocksize;
+	int hdrsize = sizeof(struct s_header) + (nblocks + 1) * sizeof(int);
+	uint8_t binhdr[HEADER_SIZE];
+	size_t total = 0;
+	int fd;
+	int i;
+
+	fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fd < 0) {
+		return ERROR;
+	}
+
+	hdr = calloc(1, hdrsize);
+	hdr->size_header = hdrsize;
+	hdr->compression_format = COMPRESSION_TYPE_MINIZ;
+	hdr->blocksize = blocksize;
+	hdr->sections = nblocks;
+	hdr->binary_size = g_imagelen;
+
+	out = malloc(compressBound(blocksize));
+	memset(binhdr, 0, sizeof(binhdr));
+	write(fd, binhdr, sizeof(binhdr));
+	lseek(fd, HEADER_SIZE + hdrsize, SEEK_SET);
+
+	for (i = 0; i < nblocks; i++) {
+		size_t len = g_imagelen - i * blocksize < blocksize ? g_imagelen - i * blocksize : blocksize;
+
+		outlen = compressBound(blocksize);
+		mz_compress(out, &outlen, &g_image[i * blocksize], len);
+		hdr->secoff[i] = total;
+		write(fd, out, outlen);
+		total += outlen;
+	}
+
+	hdr->secoff[nblocks] = total;
+	lseek(fd, HEADER_SIZE, SEEK_SET);
+	write(fd, hdr, hdrsize);
+	close(fd);
+
+	printf(CACHE ": binary %zu KB, compressed %zu KB in %d blocks of %d bytes\n", g_imagelen >> 10, (total + hdrsize) >> 10, nblocks, blocksize);
+	free(hdr);
+	free(out);
+	return OK;
+}
+
+static void check(FAR struct elf_loadinfo_s *loadinfo, uint8_t *buf, size_t len, size_t off)
+{
+	if (elf_read(loadinfo, buf, len, off) != OK || memcmp(buf, &g_image[off], len) != 0) {
+		g_nerrors++;
+	}
+}
+
+/* Some work of the loader, like a relocation */
+
+static void work(int n)
+{
+	uint32_t h = g_sink;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		h = h * 0x01000193 ^ i;
+	}
+
+	g_sink = h;
+}
+
+static void load(FAR struct elf_loadinfo_s *loadinfo, uint8_t *buf, int nwork)
+{
+	size_t nrel = (g_symtab - g_rel) / RELSIZE;
+	size_t nsym = (g_strtab - g_symtab) / SYMSIZE;
+	size_t nnames = (g_shdrs - g_strtab) / NAMESIZE;
+	size_t i;
+
+	check(loadinfo, buf, 52, 0);
+	check(loadinfo, buf, 400, g_shdrs);
+
+	/* Sections copied to RAM */
+
+	check(loadinfo, buf, g_data - g_text, g_text);
+	check(loadinfo, buf, g_rel - g_data, g_data);
+
+	/* Relocations, each with its symbol and its name, most of the symbols
+	 * being referenced by few relocations
+	 */
+
+	for (i = 0; i < nrel; i++) {
+		uint32_t sym = (rnd() % 1024) * (rnd() % 1024) / 1024 * nsym / 1024;
+
+		check(loadinfo, buf, RELSIZE, g_rel + i * RELSIZE);
+		check(loadinfo, buf, SYMSIZE, g_symtab + sym * SYMSIZE);
+		check(loadinfo, buf, NAMESIZE, g_strtab + sym % nnames * NAMESIZE);
+		work(nwork);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct elf_loadinfo_s loadinfo;
+#ifdef CONFIG_ELF_CACHE_READ
+	struct elf_cache_stats_s stats;
+#endif
+	const char *path = "elf_cache_bench.bin";
+	pthread_t thread;
+	uint64_t best = UINT64_MAX;
+	uint64_t t0;
+	uint64_t dt;
+	unsigned long ndecompress = 0;
+	uint8_t *buf;
+	size_t len = (argc > 1 ? atoi(argv[1]) : 512) << 10;
+	int nwork = argc > 2 ? atoi(argv[2]) : 100;
+	int i;
+
+	g_flash_us = argc > 3 ? atoi(argv[3]) : 0;
+	if (len < 16384 || nwork < 0 || g_flash_us < 0) {
+		fprintf(stderr, "usage: %s [binary KB, at least 16] [work per relocation] [flash read us per KB]\n", argv[0]);
+		return 1;
+	}
+
+	make_image(len);
+	if (write_compressed(path, CONFIG_COMPRESSION_BLOCK_SIZE) != OK) {
+		fprintf(stderr, "failed to write %s\n", path);
+		return 1;
+	}
+
+	pthread_create(&thread, NULL, work_thread, NULL);
+	buf = malloc(g_imagelen);
+
+	for (i = 0; i < NRUNS; i++) {
+		memset(&loadinfo, 0, sizeof(loadinfo));
+		loadinfo.offset = HEADER_SIZE;
+		loadinfo.compression_type = COMPRESSION_TYPE_MINIZ;
+		loadinfo.filfd = open(path, O_RDONLY);
+		g_seed = 2;
+		g_ndecompress = 0;
+
+		/* Like elf_init() and elf_uninit() */
+
+		t0 = now_ns();
+		if (compress_init(loadinfo.filfd, loadinfo.offset, &loadinfo.filelen) != OK) {
+			fprintf(stderr, "compress_init failed\n");
+			return 1;
+		}
+#ifdef CONFIG_ELF_CACHE_READ
+		if (elf_cache_init(loadinfo.filfd, loadinfo.offset, loadinfo.filelen, loadinfo.compression_type) != OK) {
+			fprintf(stderr, "elf_cache_init failed\n");
+			return 1;
+		}
+#endif
+
+		load(&loadinfo, buf, nwork);
+
+#ifdef CONFIG_ELF_CACHE_READ
+		elf_cache_getstats(&stats);
+		elf_cache_uninit();
+#endif
+		compress_uninit();
+		dt = now_ns() - t0;
+		close(loadinfo.filfd);
+
+		if (g_nerrors) {
+			fprintf(stderr, "%lu bad reads\n", g_nerrors);
+			return 1;
+		}
+
+		if (dt < best) {
+			best = dt;
+			ndecompress = g_ndecompress;
+		}
+	}
+
+#ifdef CONFIG_ELF_CACHE_READ
+	printf("  hits %u misses %u prefetches %u prefetch hits %u (late %u)\n", stats.hits, stats.misses, stats.prefetches, stats.prefetch_hits, stats.prefetch_late);
+#endif
+	printf("  %lu blocks decompressed, load %.1f ms\n", ndecompress, best / 1e6);
+
+	unlink(path);
+	free(buf);
+	free(g_image);
+	return 0;
+}
@@ -0,0 +1,465 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Loading of os/binfmt/libelf built for the host, with the read-only
+ * sections copied to RAM or used in place with CONFIG_ELF_XIP.
+ *
+ * A relocatable ELF module is generated in a file: .text with literal
+ * pools, a table of pointers in .rodata, the string literals of
+ * .rodata.str1.4, .data and .bss.  The flash the file is on is stood for by
+ * a read-only mapping of it below 4 GB, whose address is returned by the
+ * FIOC_MMAP ioctl, so that the 32 bit relocations of the module are applied
+ * for real.  A write to the mapping faults.
+ *
+ * elf_init(), elf_load() and elf_bind() are timed, then each relocated word
+ * is checked, as well as the strings reached through the table.  The RAM
+ * allocated for the module, the bytes read from the file and the load time
+ * with the reads taking the given time per KB of flash are reported.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <debug.h>
+
+#include <tinyara/elf.h>
+#include <tinyara/fs/ioctl.h>
+#include <tinyara/binfmt/elf.h>
+
+#include "libelf.h"
+
+#ifdef CONFIG_ELF_XIP
+#define LOADER "inplace"
+#else
+#define LOADER "copy"
+#endif
+
+#define NRUNS      20
+#define FILENAME   "elf_xip_bench.elf"
+#define R_ARM_ABS32 2
+
+/* Sections of the module */
+
+#define SEC_TEXT     1
+#define SEC_RELTEXT  2
+#define SEC_RODATA   3
+#define SEC_RELRO    4
+#define SEC_STR      5
+#define SEC_DATA     6
+#define SEC_RELDATA  7
+#define SEC_BSS      8
+#define SEC_SYMTAB   9
+#define SEC_STRTAB   10
+#define NSECTIONS    11
+
+/* Symbol of each allocated section, from 1 */
+
+static const int g_symsec[] = { 0, SEC_TEXT, SEC_RODATA, SEC_STR, SEC_DATA, SEC_BSS };
+#define NSYMS 6
+
+static uint8_t *g_file;
+static size_t g_filelen;
+static uint8_t *g_flash;
+static uint32_t g_seed = 1;
+
+static FAR Elf32_Shdr *g_shdr;
+static uint32_t *g_stroff;
+static int g_nstrings;
+
+static unsigned long g_nreadbytes;
+static unsigned long g_nflashwrites;
+
+/* Reads of the file, counted to model the time of the flash */
+
+ssize_t __real_read(int fd, void *buf, size_t len);
+
+ssize_t __wrap_read(int fd, void *buf, size_t len)
+{
+	ssize_t ret = __real_read(fd, buf, len);
+
+	if (ret > 0) {
+		g_nreadbytes += ret;
+	}
+
+	return ret;
+}
+
+/* The file is mapped where the flash would be */
+
+int __wrap_ioctl(int fd, int req, unsigned long arg)
+{
+	if (req == FIOC_MMAP) {
+		*(FAR void **)((uintptr_t)arg) = g_flash;
+		return OK;
+	}
+
+	errno = ENOTTY;
+	return ERROR;
+}
+
+bool up_checkarch(FAR const Elf32_Ehdr *hdr)
+{
+	return true;
+}
+
+void up_coherent_dcache(uintptr_t addr, size_t len)
+{
+}
+
+/* R_ARM_ABS32: the symbol value is added to the word in place */
+
+int up_relocate(FAR const Elf32_Rel *rel, FAR const Elf32_Sym *sym, uintptr_t addr)
+{
+	if (addr >= (uintptr_t)g_flash && addr < (uintptr_t)g_flash + g_filelen) {
+		g_nflashwrites++;
+		return -EACCES;
+	}
+
+	*(FAR uint32_t *)addr += sym->st_value;
+	return OK;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static size_t alignup(size_t off)
+{
+	return (off + 3) & ~3;
+}
+
+/* Symbol of the section, and the offset of a random target in it */
+
+static int rnd_target(uint32_t *addend)
+{
+	uint32_t r = rnd() % 8;
+
+	if (r < 4) {
+		*addend = g_stroff[rnd() % g_nstrings];
+		return 3;
+	} else if (r < 5) {
+		*addend = (rnd() % (g_shdr[SEC_TEXT].sh_size / 4)) * 4;
+		return 1;
+	} else if (r < 6) {
+		*addend = (rnd() % (g_shdr[SEC_DATA].sh_size / 4)) * 4;
+		return 4;
+	} else {
+		*addend = (rnd() % (g_shdr[SEC_BSS].sh_size / 4)) * 4;
+		return 5;
+	}
+}
+
+/* Relocations of one word in every stride bytes of the section */
+
+static void make_relocs(int relsec, int sec, int stride)
+{
+	FAR Elf32_Rel *rel = (FAR Elf32_Rel *)(g_file + g_shdr[relsec].sh_offset);
+	int nrels = g_shdr[sec].sh_size / stride;
+	uint32_t addend;
+	int i;
+
+	for (i = 0; i < nrels; i++) {
+		int sym = rnd_target(&addend);
+
+		rel[i].r_offset = i * stride + (rnd() % (stride / 4)) * 4;
+		rel[i].r_info = ELF32_R_INFO(sym, R_ARM_ABS32);
+		memcpy(g_file + g_shdr[sec].sh_offset + rel[i].r_offset, &addend, 4);
+	}
+}
+
+static void make_section(int index, uint32_t type, uint32_t flags, size_t size, size_t *off)
+{
+	g_shdr[index].sh_type = type;
+	g_shdr[index].sh_flags = flags;
+	g_shdr[index].sh_addralign = 4;
+	g_shdr[index].sh_offset = type == SHT_NOBITS ? 0 : *off;
+	g_shdr[index].sh_size = size;
+
+	if (type != SHT_NOBITS) {
+		*off = alignup(*off + size);
+	}
+}
+
+/* Text and data get a relocation every 32 and 16 bytes, the table of
+ * pointers one per word, and the strings none.
+ */
+
+static void make_module(size_t textkb, size_t strkb)
+{
+	FAR Elf32_Ehdr *ehdr;
+	FAR Elf32_Sym *sym;
+	FAR char *str;
+	size_t strsize = strkb << 10;
+	size_t tablesize;
+	size_t off;
+	int fd;
+	int i;
+
+	/* Strings of 8 to 71 characters */
+
+	g_stroff = malloc((strsize / 8) * sizeof(*g_stroff));
+	g_nstrings = 0;
+	for (off = 0; off + 80 < strsize; g_nstrings++) {
+		g_stroff[g_nstrings] = off;
+		off = alignup(off + 8 + rnd() % 64 + 1);
+	}
+
+	tablesize = g_nstrings * 4;
+
+	g_shdr = calloc(NSECTIONS, sizeof(Elf32_Shdr));
+	off = sizeof(Elf32_Ehdr);
+	make_section(SEC_TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, textkb << 10, &off);
+	make_section(SEC_RELTEXT, SHT_REL, 0, (g_shdr[SEC_TEXT].sh_size / 32) * sizeof(Elf32_Rel), &off);
+	make_section(SEC_RODATA, SHT_PROGBITS, SHF_ALLOC, tablesize, &off);
+	make_section(SEC_RELRO, SHT_REL, 0, g_nstrings * sizeof(Elf32_Rel), &off);
+	make_section(SEC_STR, SHT_PROGBITS, SHF_ALLOC, strsize, &off);
+	make_section(SEC_DATA, SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, textkb << 6, &off);
+	make_section(SEC_RELDATA, SHT_REL, 0, (g_shdr[SEC_DATA].sh_size / 16) * sizeof(Elf32_Rel), &off);
+	make_section(SEC_BSS, SHT_NOBITS, SHF_ALLOC | SHF_WRITE, textkb << 7, &off);
+	make_section(SEC_SYMTAB, SHT_SYMTAB, 0, NSYMS * sizeof(Elf32_Sym), &off);
+	make_section(SEC_STRTAB, SHT_STRTAB, 0, 1, &off);
+
+	g_shdr[SEC_RELTEXT].sh_link = SEC_SYMTAB;
+	g_shdr[SEC_RELTEXT].sh_info = SEC_TEXT;
+	g_shdr[SEC_RELRO].sh_link = SEC_SYMTAB;
+	g_shdr[SEC_RELRO].sh_info = SEC_RODATA;
+	g_shdr[SEC_RELDATA].sh_link = SEC_SYMTAB;
+	g_shdr[SEC_RELDATA].sh_info = SEC_DATA;
+	g_shdr[SEC_SYMTAB].sh_link = SEC_STRTAB;
+	g_shdr[SEC_SYMTAB].sh_info = NSYMS;
+
+	g_filelen = off + NSECTIONS * sizeof(Elf32_Shdr);
+	g_file = calloc(1, g_filelen);
+
+	ehdr = (FAR Elf32_Ehdr *)g_file;
+	memcpy(ehdr->e_ident, "\177ELF", 4);
+	ehdr->e_ident[EI_CLASS] = ELFCLASS32;
+	ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+	ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+	ehdr->e_type = ET_REL;
+	ehdr->e_machine = EM_ARM;
+	ehdr->e_version = EV_CURRENT;
+	ehdr->e_ehsize = sizeof(Elf32_Ehdr);
+	ehdr->e_shoff = off;
+	ehdr->e_shentsize = sizeof(Elf32_Shdr);
+	ehdr->e_shnum = NSECTIONS;
+	memcpy(g_file + off, g_shdr, NSECTIONS * sizeof(Elf32_Shdr));
+
+	/* Instructions, strings and data are random bytes */
+
+	for (i = SEC_TEXT; i <= SEC_DATA; i++) {
+		if (g_shdr[i].sh_type == SHT_PROGBITS) {
+			for (off = 0; off < g_shdr[i].sh_size; off++) {
+				g_file[g_shdr[i].sh_offset + off] = 'a' + rnd() % 26;
+			}
+		}
+	}
+
+	str = (FAR char *)(g_file + g_shdr[SEC_STR].sh_offset);
+	for (i = 0; i < g_nstrings; i++) {
+		size_t end = i + 1 < g_nstrings ? g_stroff[i + 1] : strsize;
+
+		str[g_stroff[i] + 8 + rnd() % (end - g_stroff[i] - 8)] = '\0';
+	}
+
+	sym = (FAR Elf32_Sym *)(g_file + g_shdr[SEC_SYMTAB].sh_offset);
+	for (i = 1; i < NSYMS; i++) {
+		sym[i].st_info = ELF32_ST_INFO(STB_LOCAL, STT_SECTION);
+		sym[i].st_shndx = g_symsec[i];
+	}
+
+	make_relocs(SEC_RELTEXT, SEC_TEXT, 32);
+	make_relocs(SEC_RELDATA, SEC_DATA, 16);
+
+	/* Entry i of the table points to string i */
+
+	for (i = 0; i < g_nstrings; i++) {
+		FAR Elf32_Rel *rel = (FAR Elf32_Rel *)(g_file + g_shdr[SEC_RELRO].sh_offset);
+
+		rel[i].r_offset = i * 4;
+		rel[i].r_info = ELF32_R_INFO(3, R_ARM_ABS32);
+		memcpy(g_file + g_shdr[SEC_RODATA].sh_offset + i * 4, &g_stroff[i], 4);
+	}
+
+	fd = open(FILENAME, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || write(fd, g_file, g_filelen) != (ssize_t)g_filelen) {
+		fprintf(stderr, "failed to write %s\n", FILENAME);
+		exit(1);
+	}
+
+	close(fd);
+
+	/* The flash, below 4 GB so that its addresses fit the relocations */
+
+	g_flash = mmap(NULL, g_filelen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	if (g_flash == MAP_FAILED) {
+		fprintf(stderr, "failed to map the flash\n");
+		exit(1);
+	}
+
+	memcpy(g_flash, g_file, g_filelen);
+	mprotect(g_flash, g_filelen, PROT_READ);
+
+	printf(LOADER ": %zu KB text, %zu KB pointer table, %zu KB strings, %zu KB data, %zu KB bss\n",
+		   textkb, tablesize >> 10, strkb, (size_t)g_shdr[SEC_DATA].sh_size >> 10, (size_t)g_shdr[SEC_BSS].sh_size >> 10);
+}
+
+/* Each relocated word holds the address of its target */
+
+static int check_relocs(FAR struct elf_loadinfo_s *loadinfo, int relsec)
+{
+	FAR const Elf32_Rel *rel = (FAR const Elf32_Rel *)(g_file + g_shdr[relsec].sh_offset);
+	FAR const Elf32_Shdr *dst = &loadinfo->shdr[g_shdr[relsec].sh_info];
+	int nrels = g_shdr[relsec].sh_size / sizeof(Elf32_Rel);
+	int nerrors = 0;
+	int i;
+
+	for (i = 0; i < nrels; i++) {
+		int sec = g_symsec[ELF32_R_SYM(rel[i].r_info)];
+		uint32_t addend;
+		uint32_t value;
+
+		memcpy(&addend, g_file + g_shdr[g_shdr[relsec].sh_info].sh_offset + rel[i].r_offset, 4);
+		memcpy(&value, (FAR uint8_t *)(uintptr_t)dst->sh_addr + rel[i].r_offset, 4);
+		if (value != loadinfo->shdr[sec].sh_addr + addend) {
+			nerrors++;
+		}
+	}
+
+	return nerrors;
+}
+
+static int check_module(FAR struct elf_loadinfo_s *loadinfo)
+{
+	FAR const uint32_t *table = (FAR const uint32_t *)(uintptr_t)loadinfo->shdr[SEC_RODATA].sh_addr;
+	FAR const char *str = (FAR const char *)(g_file + g_shdr[SEC_STR].sh_offset);
+	int nerrors;
+	int i;
+
+	nerrors = check_relocs(loadinfo, SEC_RELTEXT) + check_relocs(loadinfo, SEC_RELRO) + check_relocs(loadinfo, SEC_RELDATA);
+
+	for (i = 0; i < g_nstrings; i++) {
+		if (strcmp((FAR const char *)(uintptr_t)table[i], str + g_stroff[i]) != 0) {
+			nerrors++;
+		}
+	}
+
+	for (i = 0; i < g_shdr[SEC_BSS].sh_size; i++) {
+		if (((FAR const uint8_t *)(uintptr_t)loadinfo->shdr[SEC_BSS].sh_addr)[i] != 0) {
+			nerrors++;
+			break;
+		}
+	}
+
+	return nerrors;
+}
+
+int main(int argc, char **argv)
+{
+	struct elf_loadinfo_s loadinfo;
+	uint64_t best = UINT64_MAX;
+	uint64_t t0;
+	uint64_t dt;
+	size_t textkb = argc > 1 ? atoi(argv[1]) : 64;
+	size_t strkb = argc > 2 ? atoi(argv[2]) : 32;
+	int flash_us = argc > 3 ? atoi(argv[3]) : 20;
+	size_t ramsize = 0;
+	int nerrors;
+	int ret;
+	int i;
+
+	if (textkb == 0 || strkb == 0 || flash_us < 0) {
+		fprintf(stderr, "usage: %s [text KB] [strings KB] [flash read us per KB]\n", argv[0]);
+		return 1;
+	}
+
+	/* The heap in the data segment, below 4 GB too */
+
+	mallopt(M_MMAP_MAX, 0);
+
+	make_module(textkb, strkb);
+
+	for (i = 0; i < NRUNS; i++) {
+		memset(&loadinfo, 0, sizeof(loadinfo));
+		g_nreadbytes = 0;
+
+		t0 = now_ns();
+		ret = elf_init(FILENAME, &loadinfo);
+		if (ret == OK) {
+			ret = elf_load(&loadinfo);
+		}
+		if (ret == OK) {
+			ret = elf_bind(&loadinfo, NULL, 0);
+		}
+		dt = now_ns() - t0;
+
+		if (ret != OK || g_nflashwrites) {
+			fprintf(stderr, "load failed: %d, %lu writes to the flash\n", ret, g_nflashwrites);
+			return 1;
+		}
+
+		if ((loadinfo.textalloc + loadinfo.textsize + loadinfo.datasize) >> 32) {
+			fprintf(stderr, "module allocated above 4 GB\n");
+			return 1;
+		}
+
+		nerrors = check_module(&loadinfo);
+		if (nerrors) {
+			fprintf(stderr, "%d bad relocations or strings\n", nerrors);
+			return 1;
+		}
+
+		ramsize = loadinfo.textsize + loadinfo.datasize;
+		elf_unload(&loadinfo);
+		elf_uninit(&loadinfo);
+
+		if (dt < best) {
+			best = dt;
+		}
+	}
+
+	printf("  RAM %zu bytes, read %lu bytes, load %.1f us, with the flash %.1f us\n", ramsize, g_nreadbytes, best / 1000.0,
+		   best / 1000.0 + (double)g_nreadbytes * flash_us / 1024);
+
+	unlink(FILENAME);
+	free(g_stroff);
+	free(g_shdr);
+	free(g_file);
+	munmap(g_flash, g_filelen);
+	return 0;
+}
@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the ELF symbol binding of os/binfmt/libelf */
+
+#ifndef __TOOLS_BINFMT_BENCH_BENCH_CONFIG_H
+#define __TOOLS_BINFMT_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_DEBUG 1
+#define CONFIG_BINFMT_ENABLE 1
+#define CONFIG_ELF 1
+#define CONFIG_LIBC_SYMTAB 1
+#define CONFIG_LIBC_ARCH_ELF 1
+#define CONFIG_ELF_BUFFERSIZE 32
+#define CONFIG_ELF_BUFFERINCR 32
+#define CONFIG_ELF_RELOCATION_BUFFERCOUNT 256
+
+#endif
@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the libelf sources: the commands used by the ELF loader */
+
+#ifndef __TOOLS_BINFMT_BENCH_FS_IOCTL_H
+#define __TOOLS_BINFMT_BENCH_FS_IOCTL_H
+
+#define FIOC_MMAP    0x0101
+#define BIOC_XIPBASE 0x0201
+
+#endif
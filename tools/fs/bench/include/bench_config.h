@@ -0,0 +1,39 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of SmartFS and the SMART MTD driver over a RAM MTD device */
+
+#ifndef __TOOLS_FS_BENCH_BENCH_CONFIG_H
+#define __TOOLS_FS_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_FS_WRITABLE 1
+#define CONFIG_FS_SMARTFS 1
+#define CONFIG_MTD 1
+#define CONFIG_MTD_SMART 1
+#define CONFIG_MTD_SMART_SECTOR_SIZE 1024
+#define CONFIG_MTD_SMART_WEAR_LEVEL 1
+#define CONFIG_MTD_SMART_CHECKPOINT 1
+#define CONFIG_SMARTFS_ERASEDSTATE 0xff
+#define CONFIG_SMARTFS_MAXNAMLEN 32
+#define CONFIG_SMARTFS_ALIGNED_ACCESS 1
+#define CONFIG_SMARTFS_DIRINDEX_NDIRS 4
+#define CONFIG_RAMMTD 1
+#define CONFIG_RAMMTD_BLOCKSIZE 512
+#define CONFIG_RAMMTD_ERASESIZE 4096
+
+#endif
@@ -0,0 +1,275 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Mount time of the SMART MTD driver built for the host, over RAM MTD
+ * devices of several sizes.
+ *
+ * The device is formatted, half of its sectors are written and a
+ * part of them rewritten, then the sector map is checkpointed with
+ * BIOC_FLUSH.  The flash image is then mounted again by smart_initialize(),
+ * first as after a clean shutdown, where the map is loaded from the
+ * checkpoint, then after one more write, as after an unclean shutdown,
+ * where every sector header is scanned.  Both mounts are checked to find
+ * the same sectors with the same contents.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <debug.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
+#include <tinyara/fs/mtd.h>
+#include <tinyara/fs/smart.h>
+
+#define NRUNS     5
+#define DATA_SIZE 64
+
+static FAR const struct block_operations *g_bops;
+static FAR void *g_priv;
+static uint16_t *g_sectors;
+static int g_nsectors;
+
+int register_blockdriver(FAR const char *path, FAR const struct block_operations *bops, mode_t mode, FAR void *priv)
+{
+	g_bops = bops;
+	g_priv = priv;
+	return OK;
+}
+
+static int smart_ioctl(int cmd, unsigned long arg)
+{
+	struct inode inode;
+
+	memset(&inode, 0, sizeof(inode));
+	inode.i_private = g_priv;
+	return g_bops->ioctl(&inode, cmd, arg);
+}
+
+static void fill_data(uint8_t *data, uint16_t logsector, int gen)
+{
+	int i;
+
+	for (i = 0; i < DATA_SIZE; i++) {
+		data[i] = logsector * 7 + i + gen;
+	}
+}
+
+static int write_sector(uint16_t logsector, int gen)
+{
+	struct smart_read_write_s req;
+	uint8_t data[DATA_SIZE];
+
+	fill_data(data, logsector, gen);
+	req.logsector = logsector;
+	req.offset = 0;
+	req.count = DATA_SIZE;
+	req.buffer = data;
+	return smart_ioctl(BIOC_WRITESECT, (unsigned long)&req);
+}
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Mount the flash image as at boot and return the time it took */
+
+static int mount_image(uint8_t *flash, const uint8_t *image, size_t size, uint64_t *elapsed)
+{
+	FAR struct mtd_dev_s *mtd;
+	uint64_t t0;
+	int ret;
+
+	/* rammtd_initialize() erases the memory, so the image is put back */
+
+	mtd = rammtd_initialize(flash, size);
+	if (!mtd) {
+		return -ENOMEM;
+	}
+	memcpy(flash, image, size);
+
+	t0 = now_us();
+	ret = smart_initialize(0, mtd, NULL);
+	*elapsed = now_us() - t0;
+
+	return ret;
+}
+
+/* All sectors written must read back with the data of their generation,
+ * the one of the first sector is given.
+ */
+
+static int check_volume(int gen0, uint16_t nfree)
+{
+	struct smart_format_s fmt;
+	struct smart_read_write_s req;
+	uint8_t expect[DATA_SIZE];
+	uint8_t data[DATA_SIZE];
+	int i;
+
+	if (smart_ioctl(BIOC_GETFORMAT, (unsigned long)&fmt) != OK || !(fmt.flags & SMART_FMT_ISFORMATTED)) {
+		fprintf(stderr, "volume not formatted after mount\n");
+		return ERROR;
+	}
+
+	if (fmt.nfreesectors != nfree) {
+		fprintf(stderr, "%u free sectors after mount, expected %u\n", fmt.nfreesectors, nfree);
+		return ERROR;
+	}
+
+	for (i = 0; i < g_nsectors; i++) {
+		req.logsector = g_sectors[i];
+		req.offset = 0;
+		req.count = DATA_SIZE;
+		req.buffer = data;
+		if (smart_ioctl(BIOC_READSECT, (unsigned long)&req) != DATA_SIZE) {
+			fprintf(stderr, "sector %u unreadable after mount\n", g_sectors[i]);
+			return ERROR;
+		}
+
+		fill_data(expect, g_sectors[i], i == 0 ? gen0 : (i & 3) == 0);
+		if (memcmp(data, expect, DATA_SIZE) != 0) {
+			fprintf(stderr, "sector %u corrupted after mount\n", g_sectors[i]);
+			return ERROR;
+		}
+	}
+
+	return OK;
+}
+
+static int run(size_t size)
+{
+	FAR struct mtd_dev_s *mtd;
+	struct smart_format_s fmt;
+	uint8_t *flash;
+	uint8_t *clean;
+	uint8_t *unclean;
+	uint64_t tclean = UINT64_MAX;
+	uint64_t tscan = UINT64_MAX;
+	uint64_t elapsed;
+	uint16_t nfree;
+	int ret;
+	int i;
+
+	flash = malloc(size);
+	clean = malloc(size);
+	unclean = malloc(size);
+	if (!flash || !clean || !unclean) {
+		return -ENOMEM;
+	}
+
+	/* Format and fill the volume */
+
+	mtd = rammtd_initialize(flash, size);
+	if (!mtd || smart_initialize(0, mtd, NULL) != OK || smart_ioctl(BIOC_LLFORMAT, 0) != OK ||
+		smart_ioctl(BIOC_GETFORMAT, (unsigned long)&fmt) != OK) {
+		fprintf(stderr, "format of %zu MB failed\n", size >> 20);
+		return ERROR;
+	}
+
+	g_nsectors = fmt.nfreesectors / 2;
+	g_sectors = malloc(g_nsectors * sizeof(*g_sectors));
+	for (i = 0; i < g_nsectors; i++) {
+		ret = smart_ioctl(BIOC_ALLOCSECT, (unsigned long)-1);
+		if (ret < 0 || write_sector(ret, 0) != OK) {
+			fprintf(stderr, "write of sector %d failed: %d\n", i, ret);
+			return ERROR;
+		}
+		g_sectors[i] = ret;
+	}
+
+	/* Rewrite a quarter of them, which leaves released sectors behind */
+
+	for (i = 0; i < g_nsectors; i += 4) {
+		if (write_sector(g_sectors[i], 1) != OK) {
+			fprintf(stderr, "rewrite of sector %u failed\n", g_sectors[i]);
+			return ERROR;
+		}
+	}
+
+	if (smart_ioctl(BIOC_FLUSH, 0) != OK) {
+		fprintf(stderr, "checkpoint failed\n");
+		return ERROR;
+	}
+	smart_ioctl(BIOC_GETFORMAT, (unsigned long)&fmt);
+	nfree = fmt.nfreesectors;
+	memcpy(clean, flash, size);
+
+	for (i = 0; i < NRUNS; i++) {
+		if (mount_image(flash, clean, size, &elapsed) != OK || check_volume(1, nfree) != OK) {
+			fprintf(stderr, "clean mount of %zu MB failed\n", size >> 20);
+			return ERROR;
+		}
+		if (elapsed < tclean) {
+			tclean = elapsed;
+		}
+	}
+
+	/* One more write after the checkpoint makes it stale */
+
+	if (write_sector(g_sectors[0], 2) != OK) {
+		return ERROR;
+	}
+	smart_ioctl(BIOC_GETFORMAT, (unsigned long)&fmt);
+	nfree = fmt.nfreesectors;
+	memcpy(unclean, flash, size);
+
+	for (i = 0; i < NRUNS; i++) {
+		if (mount_image(flash, unclean, size, &elapsed) != OK || check_volume(2, nfree) != OK) {
+			fprintf(stderr, "unclean mount of %zu MB failed\n", size >> 20);
+			return ERROR;
+		}
+		if (elapsed < tscan) {
+			tscan = elapsed;
+		}
+	}
+
+	printf("%3zu MB, %5d sectors: checkpoint %7llu us, full scan %7llu us\n", size >> 20, g_nsectors,
+		   (unsigned long long)tclean, (unsigned long long)tscan);
+
+	free(g_sectors);
+	free(flash);
+	free(clean);
+	free(unclean);
+	return OK;
+}
+
+int main(int argc, char **argv)
+{
+	static const int sizes[] = { 4, 16, 64 };
+	int i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (run((size_t)sizes[i] << 20) != OK) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,520 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Cost of small appends to SmartFS files built for the host, over a RAM MTD
+ * device, with journaling.
+ *
+ * A log file gets 64 byte appends with an fsync() every 16 of them, then
+ * 4 and 8 files get 64 byte appends in turn, the second case with more
+ * files than write-back buffers.  The time per append and the number
+ * of flash blocks programmed and erased per append are reported.  The same
+ * source is linked with and without CONFIG_SMARTFS_WRITEBACK.  The content
+ * of all files is read back and checked.
+ *
+ * Then power failures are simulated at many points of the log workload: the
+ * flash image is copied before a block is programmed, and mounted again,
+ * which replays the journal.  The log must hold a prefix of the data
+ * written, at least up to the last fsync() completed.
+ *
+ * Last, 8 files are appended in turn while one write of a file sector in
+ * FAIL_EVERY fails.
+ * What a failed or short append or fsync() didn't write is written again,
+ * and the content of all files must be complete: no data may be dropped by
+ * a failed flush.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <semaphore.h>
+#include <debug.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
+#include <tinyara/fs/mtd.h>
+#include <tinyara/fs/smart.h>
+
+#include "smartfs.h"
+
+#ifdef CONFIG_SMARTFS_WRITEBACK
+#define WRITES "writeback"
+#else
+#define WRITES "direct"
+#endif
+
+#define FLASH_SIZE  (4 << 20)
+#define APPEND_SIZE 64
+#define SYNC_EVERY  16
+#define NAPPENDS    4096
+#define MAXFILES    8
+#define NCUTS       64
+#define FAIL_EVERY  37
+#define NRETRIES    8
+
+extern const struct mountpt_operations smartfs_operations;
+
+static struct inode *g_blkdriver;
+static struct block_operations g_bops;
+static struct mtd_dev_s g_mtdops;
+static unsigned long g_nprograms;
+static unsigned long g_nerases;
+
+/* Power failure simulation: the image is copied before the program number
+ * g_cutat, when g_synced bytes of the log were synced.
+ */
+
+static uint8_t *g_flash;
+static uint8_t *g_cutimage;
+static unsigned long g_cutat;
+static size_t g_synced;
+static size_t g_cutsynced;
+
+/* Write error simulation: one write of a sector past the journal in
+ * g_failevery fails before anything is written, if not zero.  The journal
+ * itself doesn't recover from write errors.
+ */
+
+static int (*g_ioctl)(FAR struct inode *inode, int cmd, unsigned long arg);
+static unsigned long g_failevery;
+static unsigned long g_nwrites;
+static unsigned long g_nfailed;
+
+static int fail_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
+{
+	FAR struct smart_read_write_s *req = (FAR struct smart_read_write_s *)arg;
+
+	if (cmd == BIOC_WRITESECT && g_failevery && req->logsector >= SMARTFS_LOGGING_SECTOR + 2 * CONFIG_SMARTFS_NLOGGING_SECTORS && ++g_nwrites % g_failevery == 0) {
+		g_nfailed++;
+		return -EIO;
+	}
+
+	return g_ioctl(inode, cmd, arg);
+}
+
+int register_blockdriver(FAR const char *path, FAR const struct block_operations *bops, mode_t mode, FAR void *priv)
+{
+	g_bops = *bops;
+	g_ioctl = bops->ioctl;
+	g_bops.ioctl = fail_ioctl;
+
+	g_blkdriver = calloc(1, sizeof(struct inode) + strlen(path));
+	g_blkdriver->u.i_bops = &g_bops;
+	g_blkdriver->i_private = priv;
+	return OK;
+}
+
+/* Count the blocks programmed and erased through the MTD device */
+
+static ssize_t count_bwrite(FAR struct mtd_dev_s *dev, off_t startblock, size_t nblocks, FAR const uint8_t *buffer)
+{
+	if (g_cutimage && g_nprograms <= g_cutat && g_cutat < g_nprograms + nblocks) {
+		memcpy(g_cutimage, g_flash, FLASH_SIZE);
+		g_cutsynced = g_synced;
+	}
+
+	g_nprograms += nblocks;
+	return g_mtdops.bwrite(dev, startblock, nblocks, buffer);
+}
+
+static int count_erase(FAR struct mtd_dev_s *dev, off_t startblock, size_t nblocks)
+{
+	g_nerases += nblocks;
+	return g_mtdops.erase(dev, startblock, nblocks);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Content of the byte at the position of a file */
+
+static uint8_t pattern(int file, size_t pos)
+{
+	return (uint8_t)(pos * 7 + pos / 251 + file * 13);
+}
+
+static void fill(uint8_t *buf, int file, size_t pos)
+{
+	int i;
+
+	for (i = 0; i < APPEND_SIZE; i++) {
+		buf[i] = pattern(file, pos + i);
+	}
+}
+
+/* Bind a SmartFS volume to the flash image, formatting it first if asked */
+
+static void *mount(uint8_t *flash, int minor, bool format)
+{
+	struct smart_read_write_s req;
+	struct smartfs_mountpt_s fs;
+	uint8_t type = SMARTFS_SECTOR_TYPE_DIR;
+	FAR struct mtd_dev_s *mtd;
+	uint8_t *image = NULL;
+	void *handle;
+
+	/* rammtd_initialize() erases the memory, so an image is put back */
+
+	if (!format) {
+		image = malloc(FLASH_SIZE);
+		if (!image) {
+			return NULL;
+		}
+		memcpy(image, flash, FLASH_SIZE);
+	}
+
+	mtd = rammtd_initialize(flash, FLASH_SIZE);
+	if (!mtd) {
+		return NULL;
+	}
+
+	if (image) {
+		memcpy(flash, image, FLASH_SIZE);
+		free(image);
+	}
+
+	g_mtdops = *mtd;
+	mtd->bwrite = count_bwrite;
+	mtd->erase = count_erase;
+	if (smart_initialize(minor, mtd, NULL) != OK) {
+		return NULL;
+	}
+
+	if (format) {
+		fs.fs_blkdriver = g_blkdriver;
+		if (FS_IOCTL(&fs, BIOC_LLFORMAT, 0) != OK || FS_IOCTL(&fs, BIOC_ALLOCSECT, SMARTFS_ROOT_DIR_SECTOR) != SMARTFS_ROOT_DIR_SECTOR) {
+			return NULL;
+		}
+
+		req.logsector = SMARTFS_ROOT_DIR_SECTOR;
+		req.offset = 0;
+		req.count = 1;
+		req.buffer = &type;
+		if (FS_IOCTL(&fs, BIOC_WRITESECT, (unsigned long)&req) != OK) {
+			return NULL;
+		}
+	}
+
+	if (smartfs_operations.bind(g_blkdriver, NULL, &handle) != OK) {
+		return NULL;
+	}
+
+	return handle;
+}
+
+static int open_file(struct inode *mnt, struct file *filep, const char *name, int oflags)
+{
+	memset(filep, 0, sizeof(*filep));
+	filep->f_inode = mnt;
+	return smartfs_operations.open(filep, name, oflags, 0666);
+}
+
+/* Read the whole file back, returning its size or a negated errno if the
+ * content is not the one written.
+ */
+
+static ssize_t check_file(struct inode *mnt, const char *name, int file)
+{
+	struct file filep;
+	uint8_t buf[256];
+	size_t pos = 0;
+	ssize_t n;
+	int i;
+
+	if (open_file(mnt, &filep, name, O_RDONLY) != OK) {
+		return -ENOENT;
+	}
+
+	while ((n = smartfs_operations.read(&filep, (char *)buf, sizeof(buf))) > 0) {
+		for (i = 0; i < n; i++, pos++) {
+			if (buf[i] != pattern(file, pos)) {
+				fprintf(stderr, "%s: byte %zu is %02x instead of %02x\n", name, pos, buf[i], pattern(file, pos));
+				smartfs_operations.close(&filep);
+				return -EIO;
+			}
+		}
+	}
+
+	smartfs_operations.close(&filep);
+	return n < 0 ? n : (ssize_t)pos;
+}
+
+static void report(const char *name, uint64_t ns, unsigned long programs, unsigned long erases, int nappends)
+{
+	printf("%-9s %-7s %5d x %d B: %6.2f us, %5.2f programs, %5.3f erases per append, %6.0f KB/s\n", WRITES, name, nappends, APPEND_SIZE,
+		   ns / 1000.0 / nappends, (double)programs / nappends, (double)erases / nappends, nappends * APPEND_SIZE / (ns / 1e9) / 1024);
+}
+
+/* One log file, synced regularly */
+
+static int run_log(struct inode *mnt, int verbose)
+{
+	struct file filep;
+	uint8_t buf[APPEND_SIZE];
+	unsigned long programs;
+	unsigned long erases;
+	uint64_t ns = 0;
+	uint64_t t0;
+	int i;
+
+	g_synced = 0;
+	if (open_file(mnt, &filep, "log", O_WRONLY | O_CREAT | O_APPEND) != OK) {
+		return ERROR;
+	}
+
+	programs = g_nprograms;
+	erases = g_nerases;
+	for (i = 0; i < NAPPENDS; i++) {
+		fill(buf, 0, i * APPEND_SIZE);
+		t0 = now_ns();
+		if (smartfs_operations.write(&filep, (char *)buf, APPEND_SIZE) != APPEND_SIZE) {
+			return ERROR;
+		}
+		if ((i + 1) % SYNC_EVERY == 0) {
+			if (smartfs_operations.sync(&filep) != OK) {
+				return ERROR;
+			}
+			g_synced = (i + 1) * APPEND_SIZE;
+		}
+		ns += now_ns() - t0;
+	}
+
+	smartfs_operations.close(&filep);
+	if (verbose) {
+		report("log", ns, g_nprograms - programs, g_nerases - erases, NAPPENDS);
+	}
+
+	return check_file(mnt, "log", 0) == NAPPENDS * APPEND_SIZE ? OK : ERROR;
+}
+
+/* Several files appended in turn, without sync */
+
+static int run_files(struct inode *mnt, int nfiles)
+{
+	struct file filep[MAXFILES];
+	char name[16];
+	uint8_t buf[APPEND_SIZE];
+	unsigned long programs;
+	unsigned long erases;
+	uint64_t ns = 0;
+	uint64_t t0;
+	int i;
+	int f;
+
+	for (f = 0; f < nfiles; f++) {
+		snprintf(name, sizeof(name), "file%d", f);
+		if (open_file(mnt, &filep[f], name, O_WRONLY | O_CREAT | O_TRUNC) != OK) {
+			return ERROR;
+		}
+	}
+
+	programs = g_nprograms;
+	erases = g_nerases;
+	for (i = 0; i < NAPPENDS / nfiles; i++) {
+		for (f = 0; f < nfiles; f++) {
+			fill(buf, f + 1, i * APPEND_SIZE);
+			t0 = now_ns();
+			if (smartfs_operations.write(&filep[f], (char *)buf, APPEND_SIZE) != APPEND_SIZE) {
+				return ERROR;
+			}
+			ns += now_ns() - t0;
+		}
+	}
+
+	t0 = now_ns();
+	for (f = 0; f < nfiles; f++) {
+		smartfs_operations.close(&filep[f]);
+	}
+	ns += now_ns() - t0;
+
+	snprintf(name, sizeof(name), "%d files", nfiles);
+	report(name, ns, g_nprograms - programs, g_nerases - erases, NAPPENDS);
+
+	for (f = 0; f < nfiles; f++) {
+		snprintf(name, sizeof(name), "file%d", f);
+		if (check_file(mnt, name, f + 1) != NAPPENDS / nfiles * APPEND_SIZE) {
+			return ERROR;
+		}
+	}
+
+	return OK;
+}
+
+/* Several files appended in turn while sector writes fail now and then.  Each
+ * failed operation is done again, as an application would.
+ */
+
+static int run_errors(struct inode *mnt)
+{
+	struct file filep[MAXFILES];
+	char name[16];
+	uint8_t buf[APPEND_SIZE];
+	int retries;
+	int done;
+	int ret;
+	int i;
+	int f;
+
+	for (f = 0; f < MAXFILES; f++) {
+		snprintf(name, sizeof(name), "file%d", f);
+		if (open_file(mnt, &filep[f], name, O_WRONLY | O_CREAT | O_TRUNC) != OK) {
+			return ERROR;
+		}
+	}
+
+	g_nwrites = 0;
+	g_nfailed = 0;
+	g_failevery = FAIL_EVERY;
+	for (i = 0; i < NAPPENDS / MAXFILES; i++) {
+		for (f = 0; f < MAXFILES; f++) {
+			fill(buf, f + 1, i * APPEND_SIZE);
+			retries = 0;
+			for (done = 0; done < APPEND_SIZE; done += ret > 0 ? ret : 0) {
+				ret = smartfs_operations.write(&filep[f], (char *)&buf[done], APPEND_SIZE - done);
+				if (ret <= 0 && ++retries > NRETRIES) {
+					fprintf(stderr, "append %d to file%d: %d\n", i, f, ret);
+					return ERROR;
+				}
+			}
+		}
+	}
+
+	for (f = 0; f < MAXFILES; f++) {
+		retries = 0;
+		while ((ret = smartfs_operations.sync(&filep[f])) != OK) {
+			if (++retries > NRETRIES) {
+				fprintf(stderr, "sync of file%d: %d\n", f, ret);
+				return ERROR;
+			}
+		}
+	}
+
+	g_failevery = 0;
+	for (f = 0; f < MAXFILES; f++) {
+		smartfs_operations.close(&filep[f]);
+	}
+
+	for (f = 0; f < MAXFILES; f++) {
+		snprintf(name, sizeof(name), "file%d", f);
+		if (check_file(mnt, name, f + 1) != NAPPENDS / MAXFILES * APPEND_SIZE) {
+			return ERROR;
+		}
+	}
+
+	printf("%-9s %lu failed sector writes: no data lost\n", WRITES, g_nfailed);
+	return OK;
+}
+
+/* Cut the power at several points of the log workload and check what is
+ * found after the journal replay.
+ */
+
+static int run_cuts(void)
+{
+	struct inode mnt;
+	unsigned long total;
+	ssize_t size;
+	int cut;
+
+	memset(&mnt, 0, sizeof(mnt));
+	g_cutimage = malloc(FLASH_SIZE);
+	if (!g_cutimage) {
+		return ERROR;
+	}
+
+	/* Count the programs of the workload, from the same initial state */
+
+	g_cutat = ULONG_MAX;
+	mnt.i_private = mount(g_flash, 1, true);
+	if (!mnt.i_private) {
+		return ERROR;
+	}
+	total = g_nprograms;
+	if (run_log(&mnt, 0) != OK) {
+		return ERROR;
+	}
+	total = g_nprograms - total;
+
+	for (cut = 0; cut < NCUTS; cut++) {
+		mnt.i_private = mount(g_flash, 1, true);
+		if (!mnt.i_private) {
+			return ERROR;
+		}
+
+		g_nprograms = 0;
+		g_cutat = total * cut / NCUTS + cut % 7;
+		if (run_log(&mnt, 0) != OK) {
+			return ERROR;
+		}
+
+		mnt.i_private = mount(g_cutimage, 2, false);
+		if (!mnt.i_private) {
+			fprintf(stderr, "mount after a power failure at program %lu failed\n", g_cutat);
+			return ERROR;
+		}
+
+		size = check_file(&mnt, "log", 0);
+		if (size == -ENOENT && g_cutsynced == 0) {
+			continue;
+		}
+		if (size < (ssize_t)g_cutsynced) {
+			fprintf(stderr, "power failure at program %lu: log of %zd bytes, %zu were synced\n", g_cutat, size, g_cutsynced);
+			return ERROR;
+		}
+	}
+
+	printf("%-9s %d power failures: log intact up to the last sync\n", WRITES, NCUTS);
+	free(g_cutimage);
+	g_cutimage = NULL;
+	return OK;
+}
+
+int main(int argc, char **argv)
+{
+	struct inode mnt;
+
+	g_flash = malloc(FLASH_SIZE);
+	if (!g_flash) {
+		return 1;
+	}
+
+	memset(&mnt, 0, sizeof(mnt));
+	mnt.i_private = mount(g_flash, 0, true);
+	if (!mnt.i_private) {
+		fprintf(stderr, "mount failed\n");
+		return 1;
+	}
+
+	if (run_log(&mnt, 1) != OK || run_files(&mnt, 4) != OK || run_files(&mnt, 8) != OK || run_errors(&mnt) != OK || run_cuts() != OK) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,279 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Directory lookup cost of SmartFS built for the host, over a RAM MTD
+ * device.
+ *
+ * Directories of several sizes are filled with files, then the files are
+ * looked up with smartfs_finddirentry() in a random order, as well as as
+ * many names which don't exist.  The mean time and number of sectors read
+ * per lookup are reported.  The same source is linked with and without
+ * CONFIG_SMARTFS_DIRINDEX.  Every lookup result is checked, also after a
+ * part of the files were deleted.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <semaphore.h>
+#include <debug.h>
+
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/ioctl.h>
+#include <tinyara/fs/mtd.h>
+#include <tinyara/fs/smart.h>
+#include <tinyara/kmalloc.h>
+
+#include "smartfs.h"
+
+#ifdef CONFIG_SMARTFS_DIRINDEX
+#define LOOKUP "dirindex"
+#else
+#define LOOKUP "linear"
+#endif
+
+#define FLASH_SIZE (8 << 20)
+#define NRUNS      5
+
+static struct inode *g_blkdriver;
+static struct block_operations g_bops;
+static int (*g_smart_ioctl)(FAR struct inode *inode, int cmd, unsigned long arg);
+static unsigned long g_nreads;
+static uint32_t g_seed = 1;
+
+/* Count the sectors read through the block driver */
+
+static int count_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
+{
+	if (cmd == BIOC_READSECT) {
+		g_nreads++;
+	}
+
+	return g_smart_ioctl(inode, cmd, arg);
+}
+
+int register_blockdriver(FAR const char *path, FAR const struct block_operations *bops, mode_t mode, FAR void *priv)
+{
+	g_bops = *bops;
+	g_smart_ioctl = bops->ioctl;
+	g_bops.ioctl = count_ioctl;
+
+	g_blkdriver = calloc(1, sizeof(struct inode) + strlen(path));
+	g_blkdriver->u.i_bops = &g_bops;
+	g_blkdriver->i_private = priv;
+	return OK;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Format the device and write an empty root directory, like mksmartfs */
+
+static int format(struct smartfs_mountpt_s *fs, uint8_t *flash)
+{
+	struct smart_read_write_s req;
+	uint8_t type = SMARTFS_SECTOR_TYPE_DIR;
+	FAR struct mtd_dev_s *mtd;
+
+	mtd = rammtd_initialize(flash, FLASH_SIZE);
+	if (!mtd || smart_initialize(0, mtd, NULL) != OK) {
+		return ERROR;
+	}
+
+	fs->fs_blkdriver = g_blkdriver;
+	if (FS_IOCTL(fs, BIOC_LLFORMAT, 0) != OK || FS_IOCTL(fs, BIOC_ALLOCSECT, SMARTFS_ROOT_DIR_SECTOR) != SMARTFS_ROOT_DIR_SECTOR) {
+		return ERROR;
+	}
+
+	req.logsector = SMARTFS_ROOT_DIR_SECTOR;
+	req.offset = 0;
+	req.count = 1;
+	req.buffer = &type;
+	return FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&req);
+}
+
+static int lookup(struct smartfs_mountpt_s *fs, const char *path, int expect)
+{
+	struct smartfs_entry_s entry;
+	const char *filename;
+	uint16_t parent;
+	int ret;
+
+	entry.name = NULL;
+	ret = smartfs_finddirentry(fs, &entry, path, &parent, &filename);
+	kmm_free(entry.name);
+	if (ret != expect) {
+		fprintf(stderr, "lookup of %s returned %d instead of %d\n", path, ret, expect);
+		return ERROR;
+	}
+
+	return OK;
+}
+
+static int run(struct smartfs_mountpt_s *fs, int nfiles)
+{
+	struct smartfs_entry_s dir;
+	struct smartfs_entry_s entry;
+	const char *filename;
+	uint16_t parent;
+	char path[40];
+	uint64_t thit = UINT64_MAX;
+	uint64_t tmiss = UINT64_MAX;
+	uint64_t t0;
+	unsigned long nhit = 0;
+	unsigned long nmiss = 0;
+	int run;
+	int i;
+
+	/* Create the directory and its files */
+
+	memset(&dir, 0, sizeof(dir));
+	snprintf(path, sizeof(path), "dir%d", nfiles);
+	if (smartfs_createentry(fs, fs->fs_rootsector, path, SMARTFS_DIRENT_TYPE_DIR, 0777, &dir, 0xFFFF, NULL) != OK) {
+		return ERROR;
+	}
+	kmm_free(dir.name);
+
+	for (i = 0; i < nfiles; i++) {
+		memset(&entry, 0, sizeof(entry));
+		snprintf(path, sizeof(path), "file%04d", i);
+		if (smartfs_createentry(fs, dir.firstsector, path, SMARTFS_DIRENT_TYPE_FILE, 0666, &entry, 0xFFFF, NULL) != OK) {
+			return ERROR;
+		}
+		kmm_free(entry.name);
+	}
+
+	/* Look up all files and as many names that don't exist, in a random
+	 * order.  Each lookup keeps its fastest run.
+	 */
+
+	for (run = 0; run < NRUNS; run++) {
+		uint64_t hit = 0;
+		uint64_t miss = 0;
+
+		g_seed = 1;
+		g_nreads = 0;
+		for (i = 0; i < nfiles; i++) {
+			snprintf(path, sizeof(path), "dir%d/file%04d", nfiles, rnd() % nfiles);
+			t0 = now_ns();
+			if (lookup(fs, path, OK) != OK) {
+				return ERROR;
+			}
+			hit += now_ns() - t0;
+		}
+		nhit = g_nreads;
+
+		g_nreads = 0;
+		for (i = 0; i < nfiles; i++) {
+			snprintf(path, sizeof(path), "dir%d/none%04d", nfiles, rnd() % nfiles);
+			t0 = now_ns();
+			if (lookup(fs, path, -ENOENT) != OK) {
+				return ERROR;
+			}
+			miss += now_ns() - t0;
+		}
+		nmiss = g_nreads;
+
+		thit = hit < thit ? hit : thit;
+		tmiss = miss < tmiss ? miss : tmiss;
+	}
+
+	printf("%-8s %5d entries: hit %7.1f us %6.1f reads, miss %7.1f us %6.1f reads\n", LOOKUP, nfiles,
+		   thit / 1000.0 / nfiles, (double)nhit / nfiles, tmiss / 1000.0 / nfiles, (double)nmiss / nfiles);
+
+	/* Delete every third file, then create some again: the lookups must
+	 * follow.
+	 */
+
+	for (i = 0; i < nfiles; i += 3) {
+		snprintf(path, sizeof(path), "dir%d/file%04d", nfiles, i);
+		entry.name = NULL;
+		if (smartfs_finddirentry(fs, &entry, path, &parent, &filename) != OK || smartfs_deleteentry(fs, &entry) != OK) {
+			fprintf(stderr, "delete of %s failed\n", path);
+			return ERROR;
+		}
+		kmm_free(entry.name);
+	}
+
+	for (i = 0; i < nfiles; i += 6) {
+		memset(&entry, 0, sizeof(entry));
+		snprintf(path, sizeof(path), "file%04d", i);
+		if (smartfs_createentry(fs, dir.firstsector, path, SMARTFS_DIRENT_TYPE_FILE, 0666, &entry, 0xFFFF, NULL) != OK) {
+			return ERROR;
+		}
+		kmm_free(entry.name);
+	}
+
+	for (i = 0; i < nfiles; i++) {
+		snprintf(path, sizeof(path), "dir%d/file%04d", nfiles, i);
+		if (lookup(fs, path, i % 3 == 0 && i % 6 != 0 ? -ENOENT : OK) != OK) {
+			return ERROR;
+		}
+	}
+
+	return OK;
+}
+
+int main(int argc, char **argv)
+{
+	static const int sizes[] = { 16, 64, 256, 1024 };
+	struct smartfs_mountpt_s *fs;
+	uint8_t *flash;
+	sem_t sem;
+	int i;
+
+	flash = malloc(FLASH_SIZE);
+	fs = calloc(1, sizeof(*fs));
+	if (!flash || !fs || format(fs, flash) != OK) {
+		fprintf(stderr, "format failed\n");
+		return 1;
+	}
+
+	sem_init(&sem, 0, 1);
+	fs->fs_sem = &sem;
+	if (smartfs_mount(fs, true) != OK) {
+		fprintf(stderr, "mount failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (run(fs, sizes[i]) != OK) {
+			return 1;
+		}
+	}
+
+	smartfs_unmount(fs);
+	return 0;
+}
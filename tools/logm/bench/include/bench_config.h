@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/* Host build of logm: the binary mode options are selected by the Makefile */
+
+#ifndef __TOOLS_LOGM_BENCH_BENCH_CONFIG_H
+#define __TOOLS_LOGM_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_DEBUG 1
+#define CONFIG_LOGM 1
+#define CONFIG_LOGM_BUFFER_SIZE 10240
+
+#define CONFIG_STDIO_BUFFER_SIZE 0
+#define CONFIG_NFILE_STREAMS 0
+#define CONFIG_LIBC_FLOATINGPOINT 1
+#define CONFIG_LIBC_FLOATPRECISION 6
+#define CONFIG_LIBC_FIXEDPRECISION 6
+
+#endif
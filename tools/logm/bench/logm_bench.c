@@ -0,0 +1,529 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host benchmark of logm: cost of a dbg() message at the call site and
+ * number of messages held by the logm buffer, in the text mode and in the
+ * binary mode. The binary mode is first checked against lib_sprintf(),
+ * then with concurrent writers.
+ */
+
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <tinyara/logm.h>
+#include <tinyara/streams.h>
+#include "logm.h"
+
+#define NMSGS 2000000
+#define NTHREADS 4
+#define NTHREADMSGS 200000
+
+/* Globals of logm_process.c and logm_set.c */
+
+uint8_t logm_status;
+int logm_bufsize = LOGM_BUFFER_SIZE;
+char *g_logm_rsvbuf;
+volatile int logm_print_interval = LOGM_PRINT_INTERVAL * 1000;
+volatile int new_logm_bufsize;
+
+/* Host threads are not deleted in the middle of a record, the scheduler
+ * lock is only counted to check that writers release it.
+ */
+
+static __thread int g_lockcount;
+
+int sched_lock(void)
+{
+	g_lockcount++;
+	return 0;
+}
+
+int sched_unlock(void)
+{
+	g_lockcount--;
+	return 0;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* What dbg() expands to, with a message of the average length of those of
+ * os/, which have one argument or none.
+ */
+
+#define bench_dbg(format, ...) \
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%s: " format, __FUNCTION__, ##__VA_ARGS__)
+
+static void bench_message(int i)
+{
+	bench_dbg("getaddrinfo() returned the error code %d\n", -i);
+}
+
+#ifdef CONFIG_LOGM_BINARY
+
+/* A text record, through logm_internal() as printf does */
+
+static int printf_logm(const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, fmt);
+	ret = logm_internal(LOGM_NORMAL, LOGM_UNKNOWN, LOGM_DEF_PRIORITY, fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+#ifndef CONFIG_LOGM_BINARY_RAW
+static char g_out[4096];
+static struct lib_memoutstream_s g_outstrm;
+
+static void out_reset(void)
+{
+	lib_memoutstream(&g_outstrm, g_out, sizeof(g_out));
+}
+
+static int g_nerrors;
+
+static void check_output(const char *what, const char *expected)
+{
+	if (strcmp(g_out, expected) != 0) {
+		printf("FAIL %s\n  expected \"%s\"\n  got      \"%s\"\n", what, expected, g_out);
+		g_nerrors++;
+	}
+}
+
+/* A record of fmt must print what lib_sprintf() prints */
+
+static void check(const char *fmt, ...)
+{
+	char expected[1024];
+	struct lib_memoutstream_s strm;
+	va_list ap;
+
+	lib_memoutstream(&strm, expected, sizeof(expected));
+	va_start(ap, fmt);
+	lib_vsprintf(&strm.public, fmt, ap);
+	va_end(ap);
+
+	va_start(ap, fmt);
+	logm_bin_record(LOGM_ERR, fmt, ap);
+	va_end(ap);
+
+	out_reset();
+	logm_bin_flush(&g_outstrm.public);
+	check_output(fmt, expected);
+}
+
+static void verify(void)
+{
+	char longstr[LOGM_BIN_STRMAX * 2];
+	char expected[256];
+	int i;
+
+	check("%s: x=%d y=%d\n", __FUNCTION__, 1, -2);
+	check("%08x %X %o %u %c %%\n", 0xbeef, 0xcafe, 8, UINT_MAX, 'z');
+	check("%-10s|%10s|%s\n", "left", "right", NULL);
+	check("%*d|%-*d|%.*s|\n", 6, 42, 6, 42, 3, "abcdef");
+	check("%ld %lu %lx\n", LONG_MIN, ULONG_MAX, 0x12345678L);
+	check("%lld %llu %Lx\n", LLONG_MIN, ULLONG_MAX, 0x123456789abcdefLL);
+	check("%p %p\n", (void *)check, NULL);
+	check("%f %.3f %e %g\n", 3.5, -1.0 / 3, 12345.678, 0.25);
+	check("%zu %hd %hhx\n", 7, 8, 9);
+	check("no argument\n");
+
+	/* Strings are truncated to LOGM_BIN_STRMAX */
+
+	memset(longstr, 'a', sizeof(longstr) - 1);
+	longstr[sizeof(longstr) - 1] = '\0';
+	snprintf(expected, sizeof(expected), "[%.*s]\n", LOGM_BIN_STRMAX, longstr);
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "[%s]\n", longstr);
+	out_reset();
+	logm_bin_flush(&g_outstrm.public);
+	check_output("long string", expected);
+
+	/* Arguments beyond LOGM_BIN_ARGMAX are replaced by "..." */
+
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%s %s %s %s %d\n", longstr, longstr, longstr, longstr, 1);
+	out_reset();
+	logm_bin_flush(&g_outstrm.public);
+	if (strlen(g_out) < 4 || strcmp(g_out + strlen(g_out) - 4, "...\n") != 0) {
+		check_output("too many arguments", "... ...\n");
+	}
+
+	/* Records of both rings and text records are printed in order */
+
+	logm(LOGM_NORMAL, 0, LOGM_DBG, "1 %d\n", 1);
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "2 %d\n", 2);
+	printf_logm("3 %s\n", "text");
+	logm(LOGM_NORMAL, 0, LOGM_WRN, "4 %d\n", 4);
+	logm(LOGM_NORMAL, 0, LOGM_INF, "5 %d\n", 5);
+	out_reset();
+	logm_bin_flush(&g_outstrm.public);
+	check_output("order", "1 1\n2 2\n3 text\n4 4\n5 5\n");
+
+	/* A flood of debug messages doesn't drop errors */
+
+	for (i = 0; i < 10000; i++) {
+		logm(LOGM_NORMAL, 0, LOGM_DBG, "debug %d\n", i);
+	}
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "error %d\n", i);
+	out_reset();
+	logm_bin_flush(&g_outstrm.public);
+	if (strstr(g_out, "error 10000\n") == NULL || strstr(g_out, "messages are dropped") == NULL) {
+		check_output("flood", "... error 10000 ... messages are dropped ...");
+	}
+
+	/* Every ring offset is used by records wrapping around */
+
+	for (i = 0; i < 5000; i++) {
+		char expect[LOGM_BIN_STRMAX + 16];
+		const char *str = longstr + sizeof(longstr) - 1 - i % 50;
+
+		snprintf(expect, sizeof(expect), "%s %d\n", str, i);
+		logm(LOGM_NORMAL, 0, i % 2 ? LOGM_ERR : LOGM_DBG, "%s %d\n", str, i);
+		out_reset();
+		logm_bin_flush(&g_outstrm.public);
+		check_output("wrap", expect);
+	}
+
+	printf("%s\n", g_nerrors ? "FAILED" : "verified");
+	if (g_nerrors) {
+		exit(1);
+	}
+}
+
+/* Concurrent writers: every message is printed once and in order for its
+ * writer, or counted as dropped.
+ */
+
+struct stress_stream_s {
+	struct lib_outstream_s public;
+	char line[64];
+	int len;
+	int next[NTHREADS];
+	long received;
+	long dropped;
+};
+
+static void stress_putc(struct lib_outstream_s *this, int ch)
+{
+	struct stress_stream_s *strm = (struct stress_stream_s *)this;
+	int thread;
+	int n;
+
+	if (ch != '\n') {
+		if (strm->len < sizeof(strm->line) - 1) {
+			strm->line[strm->len++] = ch;
+		}
+		return;
+	}
+	strm->line[strm->len] = '\0';
+	strm->len = 0;
+
+	if (sscanf(strm->line, "[LOGM BUFFER OVERFLOW] %d", &n) == 1) {
+		strm->dropped += n;
+	} else if (sscanf(strm->line, "thread %d message %d", &thread, &n) == 2) {
+		if (thread < 0 || thread >= NTHREADS || n < strm->next[thread]) {
+			printf("FAIL stress: \"%s\" after message %d\n", strm->line, strm->next[thread] - 1);
+			exit(1);
+		}
+		strm->next[thread] = n + 1;
+		strm->received++;
+	} else if (strm->line[0]) {
+		printf("FAIL stress: \"%s\"\n", strm->line);
+		exit(1);
+	}
+}
+
+static volatile int g_nwriters;
+
+static void *stress_writer(void *arg)
+{
+	int thread = (intptr_t)arg;
+	int i;
+
+	for (i = 0; i < NTHREADMSGS; i++) {
+		logm(LOGM_NORMAL, 0, thread % 2 ? LOGM_ERR : LOGM_DBG, "thread %d message %d %s\n", thread, i, "payload");
+		if (i % 64 == 0) {
+			sched_yield();
+		}
+	}
+	if (g_lockcount != 0) {
+		printf("FAIL stress: scheduler locked %d times by thread %d\n", g_lockcount, thread);
+		exit(1);
+	}
+	__atomic_sub_fetch(&g_nwriters, 1, __ATOMIC_SEQ_CST);
+	return NULL;
+}
+
+static void stress(void)
+{
+	struct stress_stream_s strm;
+	pthread_t threads[NTHREADS];
+	int i;
+
+	memset(&strm, 0, sizeof(strm));
+	strm.public.put = stress_putc;
+
+	g_nwriters = NTHREADS;
+	for (i = 0; i < NTHREADS; i++) {
+		pthread_create(&threads[i], NULL, stress_writer, (void *)(intptr_t)i);
+	}
+	while (__atomic_load_n(&g_nwriters, __ATOMIC_SEQ_CST)) {
+		logm_bin_flush(&strm.public);
+		sched_yield();
+	}
+	for (i = 0; i < NTHREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	logm_bin_flush(&strm.public);
+
+	if (strm.received + strm.dropped != (long)NTHREADS * NTHREADMSGS) {
+		printf("FAIL stress: %ld received, %ld dropped\n", strm.received, strm.dropped);
+		exit(1);
+	}
+	printf("%d writers: %ld messages printed, %ld dropped\n", NTHREADS, strm.received, strm.dropped);
+}
+
+/* A resize must give up after LOGM_BIN_QUIESCE_MSEC if the rings are still
+ * used, here by a consumer stuck in its output.
+ */
+
+static volatile int g_stall;
+
+static void stall_putc(struct lib_outstream_s *this, int ch)
+{
+	if (g_stall == 1) {
+		g_stall = 2;
+		while (g_stall) {
+			usleep(1000);
+		}
+	}
+}
+
+static void *stall_consumer(void *arg)
+{
+	struct lib_outstream_s strm;
+
+	lib_nulloutstream(&strm);
+	strm.put = stall_putc;
+	logm_bin_flush(&strm);
+	return NULL;
+}
+
+static void quiesce(void)
+{
+	pthread_t thread;
+	uint64_t start;
+	uint64_t msec;
+
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "stuck\n");
+	g_stall = 1;
+	pthread_create(&thread, NULL, stall_consumer, NULL);
+	while (g_stall != 2) {
+		sched_yield();
+	}
+
+	LOGM_STATUS_SET(LOGM_BUFFER_RESIZE_REQ);
+	start = now_ns();
+	if (logm_bin_quiesce() != ERROR) {
+		printf("FAIL quiesce: the rings are used by a consumer\n");
+		exit(1);
+	}
+	msec = (now_ns() - start) / 1000000;
+
+	g_stall = 0;
+	pthread_join(thread, NULL);
+	if (logm_bin_quiesce() != OK) {
+		printf("FAIL quiesce: the rings are not used anymore\n");
+		exit(1);
+	}
+	logm_bin_resume();
+	LOGM_STATUS_CLEAR(LOGM_BUFFER_RESIZE_REQ);
+	printf("resize given up after %d ms with a stuck consumer\n", (int)msec);
+}
+
+#else
+/* Raw records of the samples of tools/logm/logm_decode.py, or what they
+ * print with --expect.
+ */
+
+static void raw_samples(void)
+{
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%s: x=%d y=%d\n", __FUNCTION__, 1, -2);
+	logm(LOGM_NORMAL, 0, LOGM_DBG, "%08x %X %o %u %c %%\n", 0xbeef, 0xcafe, 8, UINT_MAX, 'z');
+	logm(LOGM_NORMAL, 0, LOGM_WRN, "%-10s|%10s|\n", "left", "right");
+	logm(LOGM_NORMAL, 0, LOGM_INF, "%*d|%-*d|%.*s|\n", 6, 42, 6, 42, 3, "abcdef");
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%ld %lu %lx\n", LONG_MIN, ULONG_MAX, 0x12345678L);
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%lld %llu %llx\n", LLONG_MIN, ULLONG_MAX, 0x123456789abcdefLL);
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%f %.3f %e\n", 3.5, -1.0 / 3, 12345.678);
+	logm(LOGM_NORMAL, 0, LOGM_ERR, "%zu %hd\n", 7, 8);
+	printf_logm("text %s\n", "record");
+}
+
+static void raw(int expect)
+{
+	struct lib_stdoutstream_s strm;
+
+	if (expect) {
+		printf("%s: x=%d y=%d\n", "raw_samples", 1, -2);
+		printf("%08x %X %o %u %c %%\n", 0xbeef, 0xcafe, 8, UINT_MAX, 'z');
+		printf("%-10s|%10s|\n", "left", "right");
+		printf("%*d|%-*d|%.*s|\n", 6, 42, 6, 42, 3, "abcdef");
+		printf("%ld %lu %lx\n", LONG_MIN, ULONG_MAX, 0x12345678L);
+		printf("%lld %llu %llx\n", LLONG_MIN, ULLONG_MAX, 0x123456789abcdefLL);
+		printf("%f %.3f %e\n", 3.5, -1.0 / 3, 12345.678);
+		printf("%zu %hd\n", (size_t)7, 8);
+		printf("text %s\n", "record");
+		return;
+	}
+
+	raw_samples();
+	lib_stdoutstream(&strm, stdout);
+	logm_bin_flush(&strm.public);
+	fflush(stdout);
+}
+#endif
+#endif							/* CONFIG_LOGM_BINARY */
+
+/* Empties the buffer like logm task, to a null stream */
+
+static void discard(void)
+{
+	struct lib_outstream_s strm;
+
+	lib_nulloutstream(&strm);
+#ifdef CONFIG_LOGM_BINARY
+	logm_bin_flush(&strm);
+#else
+	while (g_logm_head != g_logm_tail) {
+		strm.put(&strm, g_logm_rsvbuf[g_logm_head]);
+		g_logm_head = (g_logm_head + 1) % logm_bufsize;
+	}
+	g_logm_overflow_offset = -1;
+	LOGM_STATUS_CLEAR(LOGM_BUFFER_OVERFLOW);
+#endif
+}
+
+static int overflowed(void)
+{
+#ifdef CONFIG_LOGM_BINARY
+	int i;
+
+	for (i = 0; i < LOGM_BIN_NRINGS; i++) {
+		if (g_logm_binring[i].dropped) {
+			return 1;
+		}
+	}
+	return 0;
+#else
+	return LOGM_STATUS(LOGM_BUFFER_OVERFLOW);
+#endif
+}
+
+/* Number of messages held by the buffer, the ring of errors in the binary
+ * mode.
+ */
+
+static int capacity(int *size)
+{
+	int n;
+
+#ifdef CONFIG_LOGM_BINARY
+	*size = g_logm_binring[LOGM_BIN_RING(LOGM_ERR)].size;
+#else
+	*size = logm_bufsize;
+#endif
+	discard();
+	for (n = 0; !overflowed(); n++) {
+		bench_message(n);
+	}
+	discard();
+	return n - 1;
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t start;
+	uint64_t write_ns = 0;
+	uint64_t flush_ns = 0;
+	int batch;
+	int size;
+	int n;
+	int i;
+
+	g_logm_rsvbuf = malloc(logm_bufsize);
+	memset(g_logm_rsvbuf, 0, logm_bufsize);
+#ifdef CONFIG_LOGM_BINARY
+	logm_bin_init(g_logm_rsvbuf, logm_bufsize);
+#endif
+	LOGM_STATUS_SET(LOGM_READY);
+
+#ifdef CONFIG_LOGM_BINARY_RAW
+	if (argc > 1 && strcmp(argv[1], "--raw") == 0) {
+		raw(0);
+		return 0;
+	}
+	if (argc > 1 && strcmp(argv[1], "--expect") == 0) {
+		raw(1);
+		return 0;
+	}
+#elif defined(CONFIG_LOGM_BINARY)
+	verify();
+	stress();
+	quiesce();
+#endif
+
+	/* The messages fitting in the buffer are written, then flushed */
+
+	batch = capacity(&size);
+	for (n = 0; n < NMSGS; n += batch) {
+		start = now_ns();
+		for (i = 0; i < batch; i++) {
+			bench_message(i);
+		}
+		write_ns += now_ns() - start;
+
+		start = now_ns();
+		discard();
+		flush_ns += now_ns() - start;
+	}
+
+#ifdef CONFIG_LOGM_BINARY
+	printf("binary mode: ");
+#else
+	printf("text mode: ");
+#endif
+	printf("%d messages in %d bytes (%.1f bytes each), %.1f ns per message at the call site, %.1f ns in logm task\n",
+		   batch, size, (double)size / batch, (double)write_ns / n, (double)flush_ns / n);
+	return 0;
+}
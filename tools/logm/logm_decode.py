@@ -0,0 +1,230 @@
+#!/usr/bin/env python
+###########################################################################
+#
+# Copyright 2020 Samsung Electronics All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific
+# language governing permissions and limitations under the License.
+#
+###########################################################################
+# File : logm_decode.py
+# Description:
+# Formats the raw records printed by logm with CONFIG_LOGM_BINARY_RAW.
+# The format strings, and the constant string arguments, are read in the
+# ELF image of the binary, other lines of the log are printed as they are.
+#
+# Usage: logm_decode.py [-t] ELF [LOG]
+#   -t   prepend the timestamp of the records, as CONFIG_LOGM_TIMESTAMP
+
+from __future__ import print_function
+import struct
+import sys
+
+RAW_PREFIX = '#LOGM:'
+
+# Flags of a record, see os/logm/logm.h
+BINREC_TRUNC = 1 << 3
+BINREC_NSTRREFS = 4
+
+
+def BINREC_STRREF(n):
+	return 1 << (4 + n)
+
+
+def align4(n):
+	return (n + 3) & ~3
+
+
+class Elf(object):
+	def __init__(self, path):
+		with open(path, 'rb') as f:
+			self.data = f.read()
+		if self.data[:4] != b'\x7fELF':
+			raise ValueError('%s is not an ELF file' % path)
+		self.is64 = self.data[4:5] == b'\x02'
+		self.endian = '<' if self.data[5:6] == b'\x01' else '>'
+		self.ptrsize = 8 if self.is64 else 4
+		if self.is64:
+			shoff, = struct.unpack_from(self.endian + 'Q', self.data, 0x28)
+			shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x3a)
+		else:
+			shoff, = struct.unpack_from(self.endian + 'I', self.data, 0x20)
+			shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x2e)
+
+		# Sections loaded from the file: (address, offset, size)
+		self.sections = []
+		for i in range(shnum):
+			sh = shoff + i * shentsize
+			if self.is64:
+				_, sh_type, flags, addr, offset, size = struct.unpack_from(self.endian + 'IIQQQQ', self.data, sh)
+			else:
+				_, sh_type, flags, addr, offset, size = struct.unpack_from(self.endian + 'IIIIII', self.data, sh)
+			# SHF_ALLOC, not SHT_NOBITS
+			if flags & 0x2 and sh_type != 8 and size:
+				self.sections.append((addr, offset, size))
+
+	def string(self, addr):
+		for start, offset, size in self.sections:
+			if start <= addr < start + size:
+				pos = offset + addr - start
+				end = self.data.find(b'\0', pos, offset + size)
+				if end < 0:
+					end = offset + size
+				return self.data[pos:end].decode('utf-8', 'replace')
+		return '<0x%x>' % addr
+
+
+class Record(object):
+	def __init__(self, elf, raw):
+		self.elf = elf
+		self.raw = raw
+		e = elf.endian
+		self.size, self.priority, self.flags, self.seq, self.msec = struct.unpack_from(e + 'HBBII', raw, 0)
+		if elf.is64:
+			self.fmt, = struct.unpack_from(e + 'Q', raw, 16)
+			self.pos = 24
+		else:
+			self.fmt, = struct.unpack_from(e + 'I', raw, 12)
+			self.pos = 16
+		self.nstrs = 0
+
+	def get(self, code, size):
+		if self.pos + size > len(self.raw):
+			raise IndexError
+		value, = struct.unpack_from(self.elf.endian + code, self.raw, self.pos)
+		self.pos += align4(size)
+		return value
+
+	def integer(self, size, signed):
+		codes = {4: 'i', 8: 'q'}
+		code = codes[size] if signed else codes[size].upper()
+		return self.get(code, size)
+
+	def string(self):
+		n = self.nstrs
+		self.nstrs += 1
+		if n < BINREC_NSTRREFS and self.flags & BINREC_STRREF(n):
+			return self.elf.string(self.integer(self.elf.ptrsize, False))
+		end = self.raw.find(b'\0', self.pos)
+		if end < 0:
+			raise IndexError
+		value = self.raw[self.pos:end].decode('utf-8', 'replace')
+		self.pos += align4(end - self.pos + 1)
+		return value
+
+
+def parse_spec(fmt, i):
+	"""Parses the specification at fmt[i], after the '%', the way
+	lib_vsprintf() does. Returns its end, qualifiers, length and conversion.
+	"""
+	qualifiers = ''
+	while i < len(fmt) and fmt[i] not in 'diuxXpobeEfgGlLsc%':
+		qualifiers += fmt[i]
+		i += 1
+	length = 0
+	if i < len(fmt) and fmt[i] == 'L':
+		length = 2
+		i += 1
+	elif i < len(fmt) and fmt[i] == 'l':
+		length = 1
+		i += 1
+		if i < len(fmt) and fmt[i] == 'l':
+			length = 2
+			i += 1
+	conv = fmt[i] if i < len(fmt) else ''
+	return i + 1, qualifiers, length, conv
+
+
+def format_record(elf, rec):
+	fmt = elf.string(rec.fmt)
+	longsize = elf.ptrsize
+	out = ''
+	i = 0
+	try:
+		while i < len(fmt):
+			c = fmt[i]
+			if c != '%':
+				out += c
+				i += 1
+				continue
+			i, qualifiers, length, conv = parse_spec(fmt, i + 1)
+
+			# Only the flags, the width and the precision are kept
+			spec = ''
+			for q in qualifiers:
+				if q == '*':
+					spec += str(rec.integer(4, True))
+				elif q in '-+ #0.123456789':
+					spec += q
+
+			if conv == '%':
+				out += '%'
+			elif conv == 's':
+				out += ('%' + spec + 's') % rec.string()
+			elif conv == 'c':
+				out += ('%' + spec + 'c') % chr(rec.integer(4, True) & 0xff)
+			elif conv in 'diuxXob' and conv:
+				size = 8 if length == 2 else longsize if length == 1 else 4
+				value = rec.integer(size, conv in 'di')
+				if conv in 'di':
+					out += ('%' + spec + 'd') % value
+				elif conv == 'u':
+					out += ('%' + spec + 'd') % value
+				elif conv == 'b':
+					out += ('%' + spec + 's') % format(value, 'b')
+				else:
+					out += ('%' + spec + conv) % value
+			elif conv == 'p':
+				out += ('%' + spec + 'x') % rec.integer(elf.ptrsize, False)
+			elif conv and conv in 'eEfgG':
+				out += ('%' + spec + conv) % rec.get('d', 8)
+	except IndexError:
+		out += '...\n'
+	return out
+
+
+def decode(elf, log, timestamp):
+	for line in log:
+		if not line.startswith(RAW_PREFIX):
+			sys.stdout.write(line)
+			continue
+		try:
+			raw = bytearray.fromhex(line[len(RAW_PREFIX):].strip())
+			rec = Record(elf, bytes(raw))
+		except (ValueError, struct.error):
+			sys.stdout.write(line)
+			continue
+		if timestamp:
+			sys.stdout.write('[%4d.%4d] ' % (rec.msec // 1000, (rec.msec % 1000) * 10))
+		sys.stdout.write(format_record(elf, rec))
+
+
+def main(argv):
+	timestamp = False
+	if argv and argv[0] == '-t':
+		timestamp = True
+		argv = argv[1:]
+	if len(argv) not in (1, 2):
+		print('usage: logm_decode.py [-t] ELF [LOG]', file=sys.stderr)
+		return 1
+
+	elf = Elf(argv[0])
+	if len(argv) == 2:
+		with open(argv[1]) as log:
+			decode(elf, log, timestamp)
+	else:
+		decode(elf, sys.stdin, timestamp)
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,193 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+#include "audio/resample/samplerate.h"
+
+extern "C" {
+src_handle_t legacy_src_init(int size);
+int legacy_src_destroy(src_handle_t handle);
+int legacy_src_simple(src_handle_t handle, src_data_t *data);
+}
+
+// Same as CONFIG_AUDIO_RESAMPLER_BUFSIZE default
+#define BENCH_SRC_BUFSIZE   4096
+#define BENCH_CHUNK_FRAMES  512
+// The former resampler could write a few frames past out_buf_length
+#define BENCH_OUT_SLACK     8
+
+struct src_impl {
+	const char *name;
+	src_handle_t (*init)(int);
+	int (*destroy)(src_handle_t);
+	int (*simple)(src_handle_t, src_data_t *);
+};
+
+static const src_impl g_legacy = { "legacy", legacy_src_init, legacy_src_destroy, legacy_src_simple };
+static const src_impl g_kernel = { "kernel", src_init, src_destroy, src_simple };
+
+struct bench_case {
+	int in_rate;
+	int in_ch;
+	int out_rate;
+	int out_ch;
+};
+
+static const bench_case g_cases[] = {
+	{ 16000, 2, 48000, 2 },
+	{ 16000, 1, 48000, 2 },
+	{ 44100, 2, 48000, 2 },
+	{ 48000, 2, 44100, 2 },
+	{ 48000, 2, 16000, 2 },
+	{ 48000, 2, 16000, 1 },
+	{ 44100, 2, 16000, 2 },
+	{ 48000, 1, 48000, 2 },
+	{ 48000, 2, 48000, 1 },
+};
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Two tones and a little noise, near full scale to exercise clipping
+static void make_input(std::vector<int16_t> &buf, int frames, int rate, int ch)
+{
+	buf.resize((size_t)frames * ch);
+	uint32_t seed = 12345;
+	for (int i = 0; i < frames; i++) {
+		for (int c = 0; c < ch; c++) {
+			seed = seed * 1103515245 + 12345;
+			double t = (double)i / rate;
+			double v = 0.6 * sin(2 * M_PI * (440.0 + 110.0 * c) * t) + 0.35 * sin(2 * M_PI * 3000.0 * t);
+			v = v * 32767.0 + (int)((seed >> 16) & 0xff) - 128;
+			if (v > 32767.0) {
+				v = 32767.0;
+			} else if (v < -32768.0) {
+				v = -32768.0;
+			}
+			buf[(size_t)i * ch + c] = (int16_t)v;
+		}
+	}
+}
+
+// Stream the input through the resampler in chunks as the audio manager does
+static int run_src(const src_impl &impl, const bench_case &bc, const std::vector<int16_t> &in, std::vector<int16_t> &out)
+{
+	int in_frames = (int)(in.size() / bc.in_ch);
+	int16_t chunk[(BENCH_CHUNK_FRAMES + BENCH_OUT_SLACK) * 2];
+	src_handle_t handle = impl.init(BENCH_SRC_BUFSIZE);
+	if (handle == NULL) {
+		return -1;
+	}
+
+	out.clear();
+	int pos = 0;
+	int idle = 0;
+	while (pos < in_frames && idle < 4) {
+		src_data_t data;
+		memset(&data, 0, sizeof(data));
+		data.data_in = &in[(size_t)pos * bc.in_ch];
+		data.input_frames = in_frames - pos;
+		data.origin_sample_rate = bc.in_rate;
+		data.origin_sample_width = SAMPLE_WIDTH_16BITS;
+		data.origin_channel_num = bc.in_ch;
+		data.data_out = chunk;
+		data.out_buf_length = BENCH_CHUNK_FRAMES * bc.out_ch * sizeof(int16_t);
+		data.desired_sample_rate = bc.out_rate;
+		data.desired_sample_width = SAMPLE_WIDTH_16BITS;
+		data.desired_channel_num = bc.out_ch;
+		if (impl.simple(handle, &data) != 0) {
+			impl.destroy(handle);
+			return -1;
+		}
+		pos += data.input_frames_used;
+		idle = (data.input_frames_used == 0 && data.output_frames_gen == 0) ? idle + 1 : 0;
+		out.insert(out.end(), chunk, chunk + (size_t)data.output_frames_gen * bc.out_ch);
+	}
+
+	impl.destroy(handle);
+	return 0;
+}
+
+static double bench_fps(const src_impl &impl, const bench_case &bc, const std::vector<int16_t> &in, std::vector<int16_t> &out, int loops)
+{
+	double best = 0;
+	for (int i = 0; i < loops; i++) {
+		double t0 = now_sec();
+		if (run_src(impl, bc, in, out) < 0) {
+			return -1;
+		}
+		double t = now_sec() - t0;
+		if (i == 0 || t < best) {
+			best = t;
+		}
+	}
+	return (double)(in.size() / bc.in_ch) / best;
+}
+
+int main(int argc, char *argv[])
+{
+	int seconds = (argc > 1) ? atoi(argv[1]) : 10;
+	int loops = (argc > 2) ? atoi(argv[2]) : 5;
+	if (seconds <= 0 || loops <= 0) {
+		printf("usage: %s [seconds of audio] [loops]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%-22s %14s %14s %8s %8s %10s %10s\n", "conversion", "legacy fps", "kernel fps", "speedup",
+		   "max err", "rms err", "frames");
+
+	for (size_t k = 0; k < sizeof(g_cases) / sizeof(g_cases[0]); k++) {
+		const bench_case &bc = g_cases[k];
+		std::vector<int16_t> in, out_legacy, out_kernel;
+		make_input(in, seconds * bc.in_rate, bc.in_rate, bc.in_ch);
+
+		double fps_legacy = bench_fps(g_legacy, bc, in, out_legacy, loops);
+		double fps_kernel = bench_fps(g_kernel, bc, in, out_kernel, loops);
+		if (fps_legacy < 0 || fps_kernel < 0) {
+			printf("%d/%d -> %d/%d: conversion failed\n", bc.in_rate, bc.in_ch, bc.out_rate, bc.out_ch);
+			return 1;
+		}
+
+		// Output error of the kernels against the former implementation, in LSB
+		size_t n = out_legacy.size() < out_kernel.size() ? out_legacy.size() : out_kernel.size();
+		int max_err = 0;
+		double sq = 0;
+		for (size_t i = 0; i < n; i++) {
+			int d = abs((int)out_legacy[i] - (int)out_kernel[i]);
+			max_err = d > max_err ? d : max_err;
+			sq += (double)d * d;
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "%d/%d -> %d/%d", bc.in_rate, bc.in_ch, bc.out_rate, bc.out_ch);
+		printf("%-22s %14.0f %14.0f %7.2fx %8d %10.3f %4zu/%-5zu\n", name, fps_legacy, fps_kernel, fps_kernel / fps_legacy,
+			   max_err, n ? sqrt(sq / n) : 0.0, out_legacy.size() / bc.out_ch, out_kernel.size() / bc.out_ch);
+	}
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "audio/resample/samplerate.h"
+
+// Same as CONFIG_AUDIO_RESAMPLER_BUFSIZE default
+#define TEST_SRC_BUFSIZE    4096
+#define TEST_OUT_FRAMES     4096
+#define TEST_IN_FRAMES      20000
+
+struct test_case {
+	int in_rate;
+	int in_ch;
+	int out_rate;
+	int out_ch;
+};
+
+// Every converting function: upsampling, inverse ratio 1.*, 2.* with and 2.0/3.0 without fraction
+static const test_case g_cases[] = {
+	{ 16000, 2, 48000, 2 },
+	{ 16000, 1, 44100, 1 },
+	{ 48000, 2, 44100, 2 },
+	{ 44100, 2, 32000, 1 },
+	{ 44100, 2, 16000, 2 },
+	{ 44100, 1, 16000, 1 },
+	{ 48000, 2, 22050, 2 },
+	{ 48000, 2, 16000, 2 },
+	{ 44100, 1, 22050, 1 },
+};
+
+// Sizes of the input chunks given to src_simple(), in frames, 0 is all the input left
+static const int g_chunks[] = { 0, 37, 1, 7, 113, 1021 };
+
+static void make_input(std::vector<int16_t> &buf, int frames, int ch)
+{
+	uint32_t seed = 1;
+	buf.resize((size_t)frames * ch);
+	for (size_t i = 0; i < buf.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = (int16_t)(seed >> 16);
+	}
+}
+
+// Convert the whole input, giving src_simple() at most chunk frames per call
+static int run_src(const test_case &tc, const std::vector<int16_t> &in, int chunk, std::vector<int16_t> &out)
+{
+	int in_frames = (int)(in.size() / tc.in_ch);
+	std::vector<int16_t> buf((size_t)TEST_OUT_FRAMES * tc.out_ch);
+	src_handle_t handle = src_init(TEST_SRC_BUFSIZE);
+	if (handle == NULL) {
+		return -1;
+	}
+
+	out.clear();
+	int pos = 0;
+	int idle = 0;
+	while (idle < 4) {
+		src_data_t data;
+		memset(&data, 0, sizeof(data));
+		data.data_in = &in[(size_t)pos * tc.in_ch];
+		data.input_frames = in_frames - pos;
+		if (chunk > 0 && data.input_frames > chunk) {
+			data.input_frames = chunk;
+		}
+		data.origin_sample_rate = tc.in_rate;
+		data.origin_sample_width = SAMPLE_WIDTH_16BITS;
+		data.origin_channel_num = tc.in_ch;
+		data.data_out = &buf[0];
+		data.out_buf_length = (int)(buf.size() * sizeof(int16_t));
+		data.desired_sample_rate = tc.out_rate;
+		data.desired_sample_width = SAMPLE_WIDTH_16BITS;
+		data.desired_channel_num = tc.out_ch;
+		if (src_simple(handle, &data) != 0) {
+			src_destroy(handle);
+			return -1;
+		}
+		pos += data.input_frames_used;
+		idle = (data.input_frames_used == 0 && data.output_frames_gen == 0) ? idle + 1 : 0;
+		out.insert(out.end(), buf.begin(), buf.begin() + (size_t)data.output_frames_gen * tc.out_ch);
+	}
+
+	src_destroy(handle);
+	return pos == in_frames ? 0 : -1;
+}
+
+int main(void)
+{
+	int failed = 0;
+
+	for (size_t k = 0; k < sizeof(g_cases) / sizeof(g_cases[0]); k++) {
+		const test_case &tc = g_cases[k];
+		std::vector<int16_t> in, ref, out;
+		make_input(in, TEST_IN_FRAMES, tc.in_ch);
+
+		for (size_t j = 0; j < sizeof(g_chunks) / sizeof(g_chunks[0]); j++) {
+			if (run_src(tc, in, g_chunks[j], j == 0 ? ref : out) < 0) {
+				printf("%d/%d -> %d/%d in chunks of %d frames: conversion failed\n", tc.in_rate, tc.in_ch, tc.out_rate, tc.out_ch, g_chunks[j]);
+				failed++;
+				continue;
+			}
+			if (j == 0) {
+				continue;
+			}
+
+			// The output of any chunking must be the same as the output of the whole input
+			size_t n = ref.size() < out.size() ? ref.size() : out.size();
+			size_t i = 0;
+			while (i < n && ref[i] == out[i]) {
+				i++;
+			}
+			if (i < n || ref.size() != out.size()) {
+				printf("%d/%d -> %d/%d in chunks of %d frames: %zu/%zu output frames, differs at frame %zu\n", tc.in_rate, tc.in_ch, tc.out_rate, tc.out_ch,
+					   g_chunks[j], out.size() / tc.out_ch, ref.size() / tc.out_ch, i / tc.out_ch);
+				failed++;
+			}
+		}
+	}
+
+	if (failed) {
+		printf("%d conversions differ\n", failed);
+		return 1;
+	}
+
+	printf("%zu conversions in %zu chunkings: same output\n", sizeof(g_cases) / sizeof(g_cases[0]), sizeof(g_chunks) / sizeof(g_chunks[0]) - 1);
+	return 0;
+}
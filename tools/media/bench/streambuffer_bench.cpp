@@ -0,0 +1,193 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Host benchmark of media::stream::StreamBuffer.
+ * One producer thread and one consumer thread pass data through the stream
+ * buffer, the same way InputHandler and PlayerWorker do. It compares:
+ *   - mutex : default mode, read()/write() take the stream buffer mutex
+ *   - spsc  : lock-free single producer/consumer mode with read()/write()
+ *   - span  : lock-free mode with acquireWrite/commitWrite, peekRead/consumeRead
+ * and reports throughput in MB/s and the latency to wake up a blocked reader.
+ *
+ * Usage: streambuffer_bench [total MB] [chunk bytes] [buffer bytes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <thread>
+
+#include "StreamBuffer.h"
+#include "StreamBufferReader.h"
+#include "StreamBufferWriter.h"
+
+using namespace media::stream;
+
+enum bench_mode_e {
+	BENCH_MUTEX,
+	BENCH_SPSC,
+	BENCH_SPAN,
+};
+
+static const char *g_mode_name[] = { "mutex", "spsc", "span" };
+
+#define LATENCY_ROUNDS 2000
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static std::shared_ptr<StreamBuffer> create_buffer(enum bench_mode_e mode, size_t bufsize)
+{
+	return StreamBuffer::Builder()
+			.setBufferSize(bufsize)
+			.setThreshold(bufsize)
+			.setSingleProducerConsumer(mode != BENCH_MUTEX)
+			.build();
+}
+
+static void produce(StreamBufferWriter &writer, enum bench_mode_e mode, size_t total, size_t chunk)
+{
+	unsigned char *src = new unsigned char[chunk];
+
+	size_t done = 0;
+	while (done < total) {
+		size_t len = (total - done < chunk) ? (total - done) : chunk;
+		if (mode == BENCH_SPAN) {
+			unsigned char *dst = writer.acquireWrite(len);
+			if (!dst) {
+				break;
+			}
+			// Stands for a decoder producing PCM in place
+			memset(dst, 0x5a, len);
+			writer.commitWrite(len);
+		} else {
+			// Decoder output is produced into a temporary buffer, then copied
+			memset(src, 0x5a, len);
+			len = writer.write(src, len);
+		}
+		done += len;
+	}
+
+	writer.setEndOfStream();
+	delete[] src;
+}
+
+static size_t consume(StreamBufferReader &reader, enum bench_mode_e mode, size_t chunk)
+{
+	unsigned char *dst = new unsigned char[chunk];
+	size_t total = 0;
+	uint32_t sum = 0;
+
+	while (true) {
+		size_t len = chunk;
+		if (mode == BENCH_SPAN) {
+			unsigned char *src = reader.peekRead(len);
+			if (!src) {
+				break;
+			}
+			// Stands for an output device consuming data in place
+			sum += src[0] + src[len - 1];
+			reader.consumeRead(len);
+		} else {
+			len = reader.read(dst, len);
+			if (len == 0) {
+				break;
+			}
+			sum += dst[0] + dst[len - 1];
+		}
+		total += len;
+	}
+
+	delete[] dst;
+	return sum ? total : 0;
+}
+
+static void bench_throughput(enum bench_mode_e mode, size_t total, size_t chunk, size_t bufsize)
+{
+	auto stream = create_buffer(mode, bufsize);
+	StreamBufferReader reader(stream);
+	StreamBufferWriter writer(stream);
+	size_t received = 0;
+
+	uint64_t start = now_ns();
+	std::thread producer(produce, std::ref(writer), mode, total, chunk);
+	received = consume(reader, mode, chunk);
+	producer.join();
+	uint64_t elapsed = now_ns() - start;
+
+	printf("%-6s throughput : %8.1f MB/s (%zu bytes)\n", g_mode_name[mode],
+		   (double)received / (1024.0 * 1024.0) / ((double)elapsed / 1e9), received);
+}
+
+static void bench_latency(enum bench_mode_e mode, size_t bufsize)
+{
+	auto stream = create_buffer(mode, bufsize);
+	StreamBufferReader reader(stream);
+	StreamBufferWriter writer(stream);
+
+	std::thread producer([&writer]() {
+		for (int i = 0; i < LATENCY_ROUNDS; i++) {
+			// Give the reader time to block on the empty buffer
+			struct timespec ts = { 0, 50000 };
+			nanosleep(&ts, NULL);
+			uint64_t stamp = now_ns();
+			writer.write((unsigned char *)&stamp, sizeof(stamp));
+		}
+		writer.setEndOfStream();
+	});
+
+	uint64_t sum = 0;
+	uint64_t max = 0;
+	int count = 0;
+	uint64_t stamp;
+	while (reader.read((unsigned char *)&stamp, sizeof(stamp)) == sizeof(stamp)) {
+		uint64_t latency = now_ns() - stamp;
+		sum += latency;
+		if (latency > max) {
+			max = latency;
+		}
+		count++;
+	}
+	producer.join();
+
+	printf("%-6s wakeup     : avg %6.2f us, max %8.2f us (%d rounds)\n", g_mode_name[mode],
+		   count ? (double)sum / count / 1000.0 : 0.0, (double)max / 1000.0, count);
+}
+
+int main(int argc, char *argv[])
+{
+	size_t total = (argc > 1 ? atoi(argv[1]) : 256) * 1024 * 1024;
+	size_t chunk = argc > 2 ? atoi(argv[2]) : 512;
+	size_t bufsize = argc > 3 ? atoi(argv[3]) : 4096;
+
+	printf("StreamBuffer benchmark: %zu MB, chunk %zu bytes, buffer %zu bytes\n", total >> 20, chunk, bufsize);
+	for (int mode = BENCH_MUTEX; mode <= BENCH_SPAN; mode++) {
+		bench_throughput((enum bench_mode_e)mode, total, chunk, bufsize);
+	}
+	for (int mode = BENCH_MUTEX; mode <= BENCH_SPSC; mode++) {
+		bench_latency((enum bench_mode_e)mode, bufsize);
+	}
+
+	return 0;
+}
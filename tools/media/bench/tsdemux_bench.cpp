@@ -0,0 +1,386 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "demux/mpeg2ts/TSDemuxer.h"
+
+using namespace media;
+
+#define TS_PACKET_SIZE      188
+#define PID_PMT             0x100
+#define PID_AUDIO           0x101
+#define PID_NULL            0x1fff
+#define STREAM_TYPE_AAC     0x0f
+#define PTS_CLOCK_HZ        90000
+// AAC frame of 1024 samples at 48kHz
+#define FRAME_TICKS         (1024 * PTS_CLOCK_HZ / 48000)
+#define FRAMES_PER_PES      2
+#define PSI_INTERVAL_MS     100
+// Same as the size of output buffer InputHandler usually pulls with
+#define BENCH_PULL_SIZE     4096
+
+struct pes_info {
+	uint32_t msec;
+	size_t position;
+};
+
+struct ts_stream {
+	std::vector<uint8_t> data;
+	// audio PES packets with PTS, empty for a recorded file
+	std::vector<pes_info> pes;
+	uint32_t duration;
+	size_t es_bytes;
+	uint32_t es_sum;
+};
+
+static double now_sec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t crc32_mpeg(const uint8_t *data, size_t len)
+{
+	uint32_t crc = 0xffffffff;
+	while (len--) {
+		crc ^= (uint32_t)*data++ << 24;
+		for (int i = 0; i < 8; i++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+// Simple sum over elementary stream bytes to check data is delivered in order
+static uint32_t es_checksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		sum = sum * 31 + data[i];
+	}
+	return sum;
+}
+
+static void put_header(uint8_t *p, uint16_t pid, bool pusi, int afc, uint8_t cc)
+{
+	p[0] = 0x47;
+	p[1] = (pusi ? 0x40 : 0) | (pid >> 8);
+	p[2] = pid & 0xff;
+	p[3] = (afc << 4) | (cc & 0xf);
+}
+
+static void put_section(ts_stream &ts, uint16_t pid, uint8_t &cc, const uint8_t *section, size_t len)
+{
+	uint8_t pkt[TS_PACKET_SIZE];
+	memset(pkt, 0xff, sizeof(pkt));
+	put_header(pkt, pid, true, 1, cc++);
+	pkt[4] = 0; // pointer field
+	memcpy(pkt + 5, section, len);
+	ts.data.insert(ts.data.end(), pkt, pkt + TS_PACKET_SIZE);
+}
+
+static void put_psi(ts_stream &ts, uint8_t &cc_pat, uint8_t &cc_pmt)
+{
+	uint8_t pat[] = { 0x00, 0xb0, 13, 0x00, 0x01, 0xc1, 0x00, 0x00,
+					  0x00, 0x01, 0xe0 | (PID_PMT >> 8), PID_PMT & 0xff, 0, 0, 0, 0 };
+	uint32_t crc = crc32_mpeg(pat, sizeof(pat) - 4);
+	pat[12] = crc >> 24; pat[13] = crc >> 16; pat[14] = crc >> 8; pat[15] = crc;
+	put_section(ts, 0, cc_pat, pat, sizeof(pat));
+
+	uint8_t pmt[] = { 0x02, 0xb0, 18, 0x00, 0x01, 0xc1, 0x00, 0x00,
+					  0xe0 | (PID_AUDIO >> 8), PID_AUDIO & 0xff, 0xf0, 0x00,
+					  STREAM_TYPE_AAC, 0xe0 | (PID_AUDIO >> 8), PID_AUDIO & 0xff, 0xf0, 0x00, 0, 0, 0, 0 };
+	crc = crc32_mpeg(pmt, sizeof(pmt) - 4);
+	pmt[17] = crc >> 24; pmt[18] = crc >> 16; pmt[19] = crc >> 8; pmt[20] = crc;
+	put_section(ts, PID_PMT, cc_pmt, pmt, sizeof(pmt));
+}
+
+// Audio PES split into TS packets, the first one carries PCR
+static void put_pes(ts_stream &ts, uint8_t &cc, uint64_t pts, const std::vector<uint8_t> &es)
+{
+	std::vector<uint8_t> pes;
+	size_t length = 3 + 5 + es.size();
+	uint8_t head[] = { 0x00, 0x00, 0x01, 0xc0, (uint8_t)(length >> 8), (uint8_t)length, 0x80, 0x80, 5,
+					   (uint8_t)(0x21 | ((pts >> 29) & 0x0e)), (uint8_t)(pts >> 22), (uint8_t)(0x01 | ((pts >> 14) & 0xfe)),
+					   (uint8_t)(pts >> 7), (uint8_t)(0x01 | ((pts << 1) & 0xfe)) };
+	pes.insert(pes.end(), head, head + sizeof(head));
+	pes.insert(pes.end(), es.begin(), es.end());
+
+	ts.pes.push_back({ (uint32_t)(pts * 1000 / PTS_CLOCK_HZ), ts.data.size() });
+
+	size_t pos = 0;
+	bool first = true;
+	while (pos < pes.size()) {
+		uint8_t pkt[TS_PACKET_SIZE];
+		size_t af = first ? 8 : 0; // adaptation field with PCR
+		size_t room = TS_PACKET_SIZE - 4 - af;
+		size_t len = pes.size() - pos;
+		if (len < room) {
+			// stuff the last packet with adaptation field
+			af = TS_PACKET_SIZE - 4 - len;
+		} else {
+			len = room;
+		}
+		put_header(pkt, PID_AUDIO, first, af ? 3 : 1, cc++);
+		if (af) {
+			pkt[4] = af - 1;
+			if (af > 1) {
+				memset(pkt + 5, 0xff, af - 1);
+				pkt[5] = 0;
+			}
+			if (first && af >= 8) {
+				uint64_t pcr = pts;
+				pkt[5] = 0x10;
+				pkt[6] = pcr >> 25; pkt[7] = pcr >> 17; pkt[8] = pcr >> 9; pkt[9] = pcr >> 1;
+				pkt[10] = ((pcr & 1) << 7) | 0x7e; pkt[11] = 0;
+			}
+		}
+		memcpy(pkt + 4 + af, &pes[pos], len);
+		ts.data.insert(ts.data.end(), pkt, pkt + TS_PACKET_SIZE);
+		pos += len;
+		first = false;
+	}
+}
+
+// AAC-like audio at about 128kbps with PSI and some null packets in between
+static void make_stream(ts_stream &ts, int seconds)
+{
+	uint8_t cc_pat = 0, cc_pmt = 0, cc_audio = 0, cc_null = 0;
+	uint32_t seed = 12345;
+	uint64_t pts = PTS_CLOCK_HZ; // start at 1s like usual encoders
+	uint64_t end = pts + (uint64_t)seconds * PTS_CLOCK_HZ;
+	uint64_t next_psi = pts;
+
+	ts.es_bytes = 0;
+	ts.es_sum = 0;
+	while (pts < end) {
+		if (pts >= next_psi) {
+			put_psi(ts, cc_pat, cc_pmt);
+			next_psi += PSI_INTERVAL_MS * PTS_CLOCK_HZ / 1000;
+		}
+
+		std::vector<uint8_t> es;
+		for (int f = 0; f < FRAMES_PER_PES; f++) {
+			seed = seed * 1103515245 + 12345;
+			size_t frame = 300 + ((seed >> 16) % 80);
+			for (size_t i = 0; i < frame; i++) {
+				seed = seed * 1103515245 + 12345;
+				es.push_back((uint8_t)(seed >> 16));
+			}
+		}
+		ts.es_bytes += es.size();
+		ts.es_sum = es_checksum(ts.es_sum, es.data(), es.size());
+		put_pes(ts, cc_audio, pts, es);
+		pts += FRAMES_PER_PES * FRAME_TICKS;
+
+		seed = seed * 1103515245 + 12345;
+		if (((seed >> 16) & 7) == 0) {
+			uint8_t pkt[TS_PACKET_SIZE];
+			memset(pkt, 0xff, sizeof(pkt));
+			put_header(pkt, PID_NULL, false, 1, cc_null++);
+			ts.data.insert(ts.data.end(), pkt, pkt + TS_PACKET_SIZE);
+		}
+	}
+
+	// PTS in the index is relative to the first one
+	for (auto &p : ts.pes) {
+		p.msec -= 1000;
+	}
+	ts.duration = (uint32_t)seconds * 1000;
+}
+
+static bool load_file(ts_stream &ts, const char *path)
+{
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return false;
+	}
+	uint8_t buf[4096];
+	size_t len;
+	while ((len = fread(buf, 1, sizeof(buf), fp)) > 0) {
+		ts.data.insert(ts.data.end(), buf, buf + len);
+	}
+	fclose(fp);
+	ts.duration = 0;
+	ts.es_bytes = 0;
+	ts.es_sum = 0;
+	return true;
+}
+
+// Push and pull as InputHandler does, from the given position to the end of stream
+static bool demux(std::shared_ptr<TSDemuxer> demuxer, const ts_stream &ts, size_t position, size_t *es_bytes, uint32_t *es_sum, size_t max_es = SIZE_MAX)
+{
+	static uint8_t out[BENCH_PULL_SIZE];
+
+	*es_bytes = 0;
+	*es_sum = 0;
+	while (position < ts.data.size() && *es_bytes < max_es) {
+		size_t len = demuxer->getAvailSpace();
+		if (len > ts.data.size() - position) {
+			len = ts.data.size() - position;
+		}
+		ssize_t pushed = demuxer->pushData((uint8_t *)&ts.data[position], len);
+		if (pushed <= 0) {
+			return false;
+		}
+		position += pushed;
+
+		ssize_t pulled;
+		while ((pulled = demuxer->pullData(out, sizeof(out))) > 0) {
+			*es_bytes += pulled;
+			*es_sum = es_checksum(*es_sum, out, pulled);
+		}
+		if (pulled != DEMUXER_ERROR_WANT_DATA) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Data pushed for preparing stays in demuxer, position is where pushing continues
+static std::shared_ptr<TSDemuxer> create_demuxer(const ts_stream &ts, size_t *position)
+{
+	auto demuxer = TSDemuxer::create();
+	if (!demuxer) {
+		return nullptr;
+	}
+
+	*position = 0;
+	while (!demuxer->isReady() && *position < ts.data.size()) {
+		size_t len = demuxer->getAvailSpace() / 4;
+		if (len > ts.data.size() - *position) {
+			len = ts.data.size() - *position;
+		}
+		if (demuxer->pushData((uint8_t *)&ts.data[*position], len) <= 0) {
+			break;
+		}
+		*position += len;
+		int ret = demuxer->prepare();
+		if (ret < 0 && ret != DEMUXER_ERROR_WANT_DATA) {
+			return nullptr;
+		}
+	}
+
+	return demuxer->isReady() ? demuxer : nullptr;
+}
+
+// Seek after the whole stream was indexed, and check where playback restarts
+static void check_seek(std::shared_ptr<TSDemuxer> demuxer, const ts_stream &ts)
+{
+	uint32_t max_early = 0;
+	uint32_t max_late = 0;
+	int count = 0;
+
+	for (uint32_t msec = 0; msec < ts.duration; msec += 997) {
+		off_t offset;
+		if (demuxer->getSeekOffset(msec, &offset) != DEMUXER_ERROR_NONE || offset % TS_PACKET_SIZE != 0) {
+			printf("seek to %u ms failed\n", msec);
+			return;
+		}
+
+		// First PES packet at or after the offset is played first
+		size_t i = 0;
+		while (i < ts.pes.size() && ts.pes[i].position < (size_t)offset) {
+			i++;
+		}
+		if (i == ts.pes.size()) {
+			printf("seek to %u ms is beyond the stream, offset %lld\n", msec, (long long)offset);
+			return;
+		}
+		uint32_t at = ts.pes[i].msec;
+		if (at <= msec) {
+			max_early = (msec - at > max_early) ? msec - at : max_early;
+		} else {
+			max_late = (at - msec > max_late) ? at - msec : max_late;
+		}
+
+		// Restart demuxing there and check the elementary stream comes out
+		size_t es_bytes;
+		uint32_t es_sum;
+		demuxer->flush(offset);
+		if (!demux(demuxer, ts, (size_t)offset, &es_bytes, &es_sum, 1) || es_bytes == 0) {
+			printf("demux after seek to %u ms failed\n", msec);
+			return;
+		}
+		count++;
+	}
+
+	printf("seek: %d positions, restarts at most %u ms before and %u ms after the target\n", count, max_early, max_late);
+}
+
+int main(int argc, char *argv[])
+{
+	ts_stream ts;
+	int loops = (argc > 2) ? atoi(argv[2]) : 5;
+
+	if (argc > 1 && strcmp(argv[1], "-") != 0) {
+		if (!load_file(ts, argv[1])) {
+			printf("can't read %s\n", argv[1]);
+			return 1;
+		}
+	} else {
+		make_stream(ts, 600);
+	}
+
+	if (loops <= 0 || ts.data.size() < TS_PACKET_SIZE) {
+		printf("usage: %s [recorded .ts file, or - to generate 10 minutes of audio] [loops]\n", argv[0]);
+		return 1;
+	}
+
+	double best = 0;
+	size_t es_bytes = 0;
+	uint32_t es_sum = 0;
+	std::shared_ptr<TSDemuxer> demuxer;
+	for (int i = 0; i < loops; i++) {
+		size_t position;
+		demuxer = create_demuxer(ts, &position);
+		if (!demuxer) {
+			printf("prepare failed, no PAT/PMT with audio stream\n");
+			return 1;
+		}
+		double t0 = now_sec();
+		if (!demux(demuxer, ts, position, &es_bytes, &es_sum)) {
+			printf("demux failed\n");
+			return 1;
+		}
+		double t = now_sec() - t0;
+		if (i == 0 || t < best) {
+			best = t;
+		}
+	}
+
+	printf("input: %zu bytes, audio ES: %zu bytes\n", ts.data.size(), es_bytes);
+	printf("demux: %.1f Mbit/s of transport stream\n", ts.data.size() * 8 / best / 1e6);
+
+	if (!ts.pes.empty()) {
+		if (es_bytes != ts.es_bytes || es_sum != ts.es_sum) {
+			printf("ES mismatch: expected %zu bytes, checksum %08x, got %08x\n", ts.es_bytes, ts.es_sum, es_sum);
+			return 1;
+		}
+		check_seek(demuxer, ts);
+	}
+
+	return 0;
+}
@@ -0,0 +1,273 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Stress test of os/mm/mm_heap built for the host.  The same source is
+ * linked with the best-fit free lists and with the TLSF free lists.
+ *
+ * The heap is first fragmented with allocations of random sizes of which
+ * a random half is freed.  Then random mallocs and frees are timed one by
+ * one, and the mean, percentiles and maximum latency are reported, as well
+ * as the number of free chunks the allocator had to manage.
+ *
+ * The same sequence is run several times and each operation keeps its
+ * fastest time, so that interrupts and preemption of the host don't show
+ * up as the worst case of the allocator.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_TLSF
+#define ALLOCATOR "tlsf"
+#else
+#define ALLOCATOR "bestfit"
+#endif
+
+#define HEAP_SIZE (8 << 20)
+#define NSLOTS    16384
+#define NRUNS     5
+
+static struct mm_heap_s g_heap;
+static char g_mem[HEAP_SIZE] __attribute__((aligned(16)));
+static void *g_slot[NSLOTS];
+static uint32_t g_seed = 1;
+
+struct mm_heap_s *mm_get_heap(void *address)
+{
+	return &g_heap;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+/* Mostly small requests with a tail of large ones, like a running system */
+
+static size_t rnd_size(void)
+{
+	uint32_t r = rnd();
+
+	if ((r & 15) != 0) {
+		return 8 + (r >> 4) % 248;
+	}
+	if ((r & 255) != 0) {
+		return 256 + (r >> 8) % 3840;
+	}
+	return 4096 + (r >> 8) % 28672;
+}
+
+/* A cycle counter where available, as clock_gettime() costs more than a
+ * malloc on some hosts.
+ */
+
+static inline uint64_t now_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	uint32_t lo;
+	uint32_t hi;
+
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+	uint64_t val;
+
+	__asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(val));
+	return val;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, uint32_t *lat, int n)
+{
+	uint64_t sum = 0;
+	int i;
+
+	if (n == 0) {
+		return;
+	}
+
+	qsort(lat, n, sizeof(*lat), cmp_u32);
+	for (i = 0; i < n; i++) {
+		sum += lat[i];
+	}
+
+	printf("  %-6s %8d ops  mean %6.0f  p50 %6u  p99 %6u  p99.9 %6u  max %7u ticks\n",
+		   name, n, (double)sum / n, lat[n / 2], lat[(int)(n * 0.99)], lat[(int)(n * 0.999)], lat[n - 1]);
+}
+
+static int count_freechunks(void)
+{
+	struct mm_allocnode_s *node;
+	int count = 0;
+
+	for (node = g_heap.mm_heapstart[0]; node < g_heap.mm_heapend[0]; node = (struct mm_allocnode_s *)((char *)node + node->size)) {
+		if ((node->preceding & MM_ALLOC_BIT) == 0) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* Run the sequence of the seed, keeping the fastest time of each op */
+
+static int run(uint32_t *lat, uint8_t *isfree, int nops, int nslots, int first)
+{
+	uint64_t t0;
+	uint32_t dt;
+	int nfail = 0;
+	int i;
+
+	g_seed = 1;
+	memset(g_slot, 0, sizeof(g_slot));
+	mm_initialize(&g_heap, g_mem, HEAP_SIZE);
+
+	/* Fragment the heap: fill the slots and free a random half of them */
+
+	for (i = 0; i < nslots; i++) {
+		g_slot[i] = mm_malloc(&g_heap, rnd_size());
+	}
+	for (i = 0; i < nslots; i++) {
+		if (rnd() & 1) {
+			mm_free(&g_heap, g_slot[i]);
+			g_slot[i] = NULL;
+		}
+	}
+
+	if (first) {
+		printf("%s: heap %d KB, %d slots, %d free chunks after fragmentation\n", ALLOCATOR, HEAP_SIZE >> 10, nslots, count_freechunks());
+	}
+
+	for (i = 0; i < nops; i++) {
+		int idx = rnd() % nslots;
+
+		if (g_slot[idx]) {
+			t0 = now_ticks();
+			mm_free(&g_heap, g_slot[idx]);
+			dt = now_ticks() - t0;
+			g_slot[idx] = NULL;
+			isfree[i] = 1;
+		} else {
+			size_t size = rnd_size();
+
+			t0 = now_ticks();
+			g_slot[idx] = mm_malloc(&g_heap, size);
+			dt = now_ticks() - t0;
+			if (!g_slot[idx]) {
+				nfail++;
+			} else {
+				memset(g_slot[idx], idx, size < 64 ? size : 64);
+			}
+			isfree[i] = 0;
+		}
+
+		if (first || dt < lat[i]) {
+			lat[i] = dt;
+		}
+	}
+
+	if (first) {
+		printf("  %d free chunks at the end, %d failed mallocs\n", count_freechunks(), nfail);
+	}
+
+	for (i = 0; i < nslots; i++) {
+		if (g_slot[i]) {
+			mm_free(&g_heap, g_slot[i]);
+		}
+	}
+
+	/* Everything freed must be merged back into a single chunk */
+
+	if (count_freechunks() != 1) {
+		fprintf(stderr, "heap not merged back: %d free chunks\n", count_freechunks());
+		return ERROR;
+	}
+
+	return OK;
+}
+
+int main(int argc, char **argv)
+{
+	int nops = argc > 1 ? atoi(argv[1]) : 1000000;
+	int nslots = argc > 2 ? atoi(argv[2]) : 8192;
+	uint32_t *lat;
+	uint32_t *mlat;
+	uint32_t *flat;
+	uint8_t *isfree;
+	int nmalloc = 0;
+	int nfree = 0;
+	int i;
+
+	if (nops <= 0 || nslots <= 0 || nslots > NSLOTS) {
+		fprintf(stderr, "usage: %s [ops] [live slots, up to %d]\n", argv[0], NSLOTS);
+		return 1;
+	}
+
+	lat = malloc(nops * sizeof(*lat));
+	mlat = malloc(nops * sizeof(*mlat));
+	flat = malloc(nops * sizeof(*flat));
+	isfree = malloc(nops);
+	if (!lat || !mlat || !flat || !isfree) {
+		return 1;
+	}
+
+	for (i = 0; i < NRUNS; i++) {
+		if (run(lat, isfree, nops, nslots, i == 0) != OK) {
+			return 1;
+		}
+	}
+
+	for (i = 0; i < nops; i++) {
+		if (isfree[i]) {
+			flat[nfree++] = lat[i];
+		} else {
+			mlat[nmalloc++] = lat[i];
+		}
+	}
+
+	report("malloc", mlat, nmalloc);
+	report("free", flat, nfree);
+
+	free(lat);
+	free(mlat);
+	free(flat);
+	free(isfree);
+	return 0;
+}
@@ -0,0 +1,123 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * apps/examples/memory_fragmentation_test and heap_performance_test built
+ * for the host, with their malloc() and free() going to os/mm/mm_heap.
+ * The same source is linked with and without the slab front-end.
+ *
+ * After the fragmentation test, the free chunks and the largest of them are
+ * printed, as heapinfo would.  The performance test runs without its sleeps.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_SLAB
+#define ALLOCATOR "slab"
+#else
+#define ALLOCATOR "bestfit"
+#endif
+
+#define HEAP_SIZE (2 << 20)
+
+static struct mm_heap_s g_heap;
+static char g_mem[HEAP_SIZE] __attribute__((aligned(16)));
+
+struct mm_heap_s *mm_get_heap(void *address)
+{
+	return &g_heap;
+}
+
+/* getpid() of the target reads the running task, it's a system call here */
+
+static pid_t g_pid;
+
+pid_t bench_getpid(void)
+{
+	return g_pid;
+}
+
+static int bench_task_create(const char *name, int priority, int stack_size, int (*entry)(int argc, char *argv[]), char *argv[])
+{
+	return 0;
+}
+
+static unsigned int bench_sleep(unsigned int seconds)
+{
+	return 0;
+}
+
+/* The examples, with the heap under test and without tasks nor sleeps */
+
+#define malloc(size) mm_malloc(&g_heap, size)
+#define free(mem) mm_free(&g_heap, mem)
+#define task_create bench_task_create
+#define sleep bench_sleep
+
+#include "../../../apps/examples/memory_fragmentation_test/memory_fragmentation_test.c"
+#include "../../../apps/examples/heap_performance_test/heap_performance_test.c"
+
+#undef malloc
+#undef free
+
+static void heap_stats(void)
+{
+	struct mm_allocnode_s *node;
+	size_t used = 0;
+	size_t largest = 0;
+	int nfree = 0;
+
+	for (node = g_heap.mm_heapstart[0]; node < g_heap.mm_heapend[0]; node = (struct mm_allocnode_s *)((char *)node + node->size)) {
+		if ((node->preceding & MM_ALLOC_BIT) != 0) {
+			used += node->size;
+		} else {
+			nfree++;
+			if (node->size > largest) {
+				largest = node->size;
+			}
+		}
+	}
+
+	printf("%s: %u bytes used, %d free chunks, largest %u bytes\n", ALLOCATOR, (unsigned)used, nfree, (unsigned)largest);
+}
+
+int main(int argc, char **argv)
+{
+	char *frag_argv[] = { "memfrag", "memfrag", "5", "5", "100", NULL };
+	char *perf_argv[] = { "heaptest", "heaptest", "1", "1000", NULL };
+
+	g_pid = getpid();
+
+	mm_initialize(&g_heap, g_mem, HEAP_SIZE);
+	memory_fragmentation_test(5, frag_argv);
+	heap_stats();
+
+	mm_initialize(&g_heap, g_mem, HEAP_SIZE);
+	heap_performance_test(4, perf_argv);
+	return 0;
+}
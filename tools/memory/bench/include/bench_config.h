@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the heap sources: a single heap of one region */
+
+#ifndef __TOOLS_MEMORY_BENCH_BENCH_CONFIG_H
+#define __TOOLS_MEMORY_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_DEBUG 1
+#define CONFIG_MAX_TASKS 32
+#define CONFIG_MM_REGIONS 1
+#define CONFIG_MM_REGION_NUM 1
+#define CONFIG_MM_NHEAPS 1
+#define CONFIG_HAVE_LONG_LONG 1
+
+#endif
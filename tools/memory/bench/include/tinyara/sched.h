@@ -0,0 +1,28 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __TOOLS_MEMORY_BENCH_SCHED_H
+#define __TOOLS_MEMORY_BENCH_SCHED_H
+
+#include <sched.h>
+#include <unistd.h>
+
+#define MAX_PID_MASK (CONFIG_MAX_TASKS - 1)
+#define PIDHASH(pid) ((pid) & MAX_PID_MASK)
+
+#endif
@@ -0,0 +1,186 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Internet checksum of os/net/lwip/src/core/inet_chksum.c built for the host.
+ *
+ * inet_chksum() and LWIP_CHKSUM_COPY are first checked against a plain
+ * RFC 1071 sum for every alignment and every length up to a full frame,
+ * then the bytes summed per cycle are measured for the segment sizes of a
+ * small packet, of the minimum IPv4 MTU and of an Ethernet MSS, aligned and
+ * at an odd address.  The copy is measured against a memcpy() followed by
+ * the checksum of the copy, which is what LWIP_CHKSUM_COPY version #1 does.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lwip/opt.h"
+#include "lwip/def.h"
+#include "lwip/inet_chksum.h"
+
+#define NRUNS      50
+#define NITERS     2000
+#define MAXLEN     1514
+
+static uint8_t g_src[MAXLEN + 16] __attribute__((aligned(16)));
+static uint8_t g_dst[MAXLEN + 16] __attribute__((aligned(16)));
+static volatile uint16_t g_sink;
+
+/* A cycle counter where available, like tools/memory/bench */
+
+static inline uint64_t now_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	uint32_t lo;
+	uint32_t hi;
+
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(__aarch64__)
+	uint64_t val;
+
+	__asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(val));
+	return val;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/* RFC 1071 sum of big endian halfwords, in host order */
+
+static uint16_t ref_chksum(const uint8_t *data, int len)
+{
+	uint32_t sum = 0;
+	int i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		sum += (uint32_t)(data[i] << 8 | data[i + 1]);
+	}
+	if (i < len) {
+		sum += (uint32_t)(data[i] << 8);
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+	return (uint16_t)sum;
+}
+
+static int verify(void)
+{
+	uint16_t sum;
+	int soff;
+	int doff;
+	int len;
+
+	for (soff = 0; soff < 8; soff++) {
+		for (len = 0; len <= MAXLEN; len++) {
+			if (lwip_ntohs((u16_t)~inet_chksum(&g_src[soff], len)) != ref_chksum(&g_src[soff], len)) {
+				fprintf(stderr, "inet_chksum mismatch at offset %d length %d\n", soff, len);
+				return -1;
+			}
+		}
+	}
+
+	for (soff = 0; soff < 4; soff++) {
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 0; len <= MAXLEN; len += 3) {
+				memset(g_dst, 0, sizeof(g_dst));
+				sum = LWIP_CHKSUM_COPY(&g_dst[doff], &g_src[soff], len);
+				if (memcmp(&g_dst[doff], &g_src[soff], len) != 0 || g_dst[doff + len] != 0 ||
+					lwip_ntohs(sum) != ref_chksum(&g_src[soff], len)) {
+					fprintf(stderr, "LWIP_CHKSUM_COPY mismatch at offsets %d/%d length %d\n", soff, doff, len);
+					return -1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Best bytes per cycle (or per ns) of NRUNS runs of NITERS iterations */
+
+static double bench(int op, int off, int len)
+{
+	uint64_t best = UINT64_MAX;
+	uint64_t t0;
+	uint64_t dt;
+	int i;
+	int j;
+
+	for (i = 0; i < NRUNS; i++) {
+		t0 = now_ticks();
+		for (j = 0; j < NITERS; j++) {
+			switch (op) {
+			case 0:
+				g_sink = (u16_t)~inet_chksum(&g_src[off], len);
+				break;
+			case 1:
+				memcpy(&g_dst[off], &g_src[off], len);
+				g_sink = (u16_t)~inet_chksum(&g_dst[off], len);
+				break;
+			default:
+				g_sink = LWIP_CHKSUM_COPY(&g_dst[off], &g_src[off], len);
+				break;
+			}
+			__asm__ __volatile__("" ::: "memory");
+		}
+		dt = now_ticks() - t0;
+		if (dt < best) {
+			best = dt;
+		}
+	}
+
+	return (double)len * NITERS / best;
+}
+
+int main(int argc, char **argv)
+{
+	static const int lens[] = { 64, 576, 1460 };
+	uint32_t seed = 1;
+	unsigned int i;
+	int off;
+
+	for (i = 0; i < sizeof(g_src); i++) {
+		seed = seed * 1103515245 + 12345;
+		g_src[i] = (uint8_t)(seed >> 16);
+	}
+	/* runs of 0xff make the end-around carries likely */
+	memset(&g_src[200], 0xff, 300);
+
+	if (verify() < 0) {
+		return 1;
+	}
+
+	printf("LWIP_CHKSUM_ALGORITHM %d, LWIP_CHKSUM_COPY_ALGORITHM %d: verified\n", LWIP_CHKSUM_ALGORITHM, LWIP_CHKSUM_COPY_ALGORITHM);
+	printf("  bytes/cycle %6s %6s %10s %14s %12s\n", "length", "align", "chksum", "memcpy+chksum", "chksum_copy");
+	for (i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+		for (off = 0; off < 2; off++) {
+			printf("  %11s %6d %6s %10.2f %14.2f %12.2f\n", "", lens[i], off ? "odd" : "word", bench(0, off, lens[i]), bench(1, off, lens[i]), bench(2, off, lens[i]));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the lwIP socket layer: IPv4 TCP and UDP sockets on the
+ * loopback interface, with the zero-copy socket API.  The Makefile defines
+ * CONFIG_NET_TCPIP_CORE_LOCKING and CONFIG_NET_TCPIP_MBOX_BATCH.
+ */
+
+#ifndef __TOOLS_NET_BENCH_SOCKET_BENCH_CONFIG_H
+#define __TOOLS_NET_BENCH_SOCKET_BENCH_CONFIG_H
+
+#define CONFIG_DEBUG 1
+#define CONFIG_NET_LWIP 1
+#define CONFIG_NET_IPv4 1
+#define CONFIG_NET_TCP 1
+#define CONFIG_NET_UDP 1
+#define CONFIG_NET_SOCKET 1
+#define CONFIG_NET_SOCKET_ZEROCOPY 1
+#define CONFIG_NET_LOOPBACK_INTERFACE 1
+
+#define CONFIG_DISABLE_POLL 1
+#ifndef CONFIG_NET_TCPIP_CORE_LOCKING
+#define CONFIG_NET_COMPAT_MUTEX 1
+#endif
+#define CONFIG_NET_MEM_LIBC_MALLOC 1
+
+#define CONFIG_NET_LWIP_CHKSUM_WORD 1
+#define CONFIG_NET_LWIP_CHECKSUM_ON_COPY 1
+
+#define CONFIG_NET_MEM_SIZE (512 * 1024)
+#define CONFIG_NET_MEM_ALIGNMENT 8
+#define CONFIG_NET_PBUF_POOL_SIZE 64
+#define CONFIG_NET_MEMP_NUM_TCP_SEG 256
+#define CONFIG_NET_MEMP_NUM_PBUF 256
+#define CONFIG_NET_TCP_MSS 1460
+#define CONFIG_NET_TCP_SND_BUF (32 * 1460)
+#define CONFIG_NET_TCP_SND_QUEUELEN 128
+#define CONFIG_NET_TCP_WND (32 * 1460)
+#define CONFIG_NET_TCPIP_MBOX_SIZE 64
+#define CONFIG_NET_DEFAULT_TCP_RECVMBOX_SIZE 64
+#define CONFIG_NET_DEFAULT_UDP_RECVMBOX_SIZE 64
+#define CONFIG_NET_DEFAULT_ACCEPTMBOX_SIZE 4
+#define CONFIG_NET_MEMP_NUM_NETCONN 8
+#define CONFIG_NBSDSOCKET_DESCRIPTORS 8
+#define CONFIG_NFILE_DESCRIPTORS 8
+#define CONFIG_NSOCKET_DESCRIPTORS 8
+
+#endif
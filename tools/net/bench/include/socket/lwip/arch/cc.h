@@ -0,0 +1,41 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the lwIP sockets: the types and the declarations that the
+ * headers of TinyAra provide and the host doesn't, on top of the cc.h of the
+ * checksum build
+ */
+
+#ifndef __TOOLS_NET_BENCH_SOCKET_CC_H
+#define __TOOLS_NET_BENCH_SOCKET_CC_H
+
+#include_next <lwip/arch/cc.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <unistd.h>
+
+/* errno is set by the socket functions */
+
+#define ERRNO
+
+typedef unsigned int socklen_t;
+typedef uint16_t sa_family_t;
+
+#endif
@@ -0,0 +1,616 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Socket layer of lwIP built for the host: sockets.c, api_msg.c and the core
+ * with their tcpip_thread, on the loopback interface.
+ *
+ * lwip_recv_pbuf() and lwip_send_ref() are first checked against the copy
+ * path.  A TCP stream written in chunks of random sizes must be received
+ * unchanged, while lwip_recv() and lwip_recv_pbuf() are mixed on the same
+ * socket, and the sent function must be called once per lwip_send_ref()
+ * by the time the socket is closed.  Then the same for UDP datagrams.
+ *
+ * Then a TCP stream is timed from a sending thread to a receiving thread,
+ * copied or not on each side, for the throughput and the CPU time of the
+ * process per MB, the best of NRUNS runs.  Last, the round trip time of a
+ * MSGSIZE byte message echoed by another thread.
+ *
+ * The Makefile builds it with and without LWIP_TCPIP_CORE_LOCKING, and with
+ * one or several messages handled per wakeup of tcpip_thread.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tinyara/kthread.h>
+
+#include "lwip/opt.h"
+#include "lwip/sockets.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcpip.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+
+#define NRUNS      5
+#define CHUNK      8192
+#define PERIOD     251
+#define NVERIFY    (1024 * 1024)
+#define NDATAGRAMS 200
+#define MSGSIZE    64
+#define NROUNDS    5000
+#define SHUTREF    (16 * 1024)
+#define SHUTDELAY  200000
+
+struct stream {
+	int listener;
+	int zerocopy;
+	int check;
+	size_t total;
+	size_t received;
+	unsigned long errors;
+	/* when the last byte was received */
+	uint64_t end;
+	uint64_t end_cpu;
+};
+
+/* The stream repeats the first PERIOD bytes, the data of any offset can be
+ * sent from data[offset % PERIOD]
+ */
+
+static uint8_t g_data[PERIOD + CHUNK];
+static uint32_t g_seed = 1;
+static u16_t g_port = 5000;
+
+static unsigned long g_nsent;
+static unsigned long g_ncalls;
+
+/* The tasks of os/net/lwip/sys/arch/sys_arch.c are host threads, and the
+ * scheduler lock that protects the lwIP pools is a recursive mutex
+ */
+
+struct netif *g_netdevices;
+
+static pthread_mutex_t g_schedlock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static void *task_start(void *arg)
+{
+	main_t entry = *(main_t *)arg;
+
+	free(arg);
+	entry(0, NULL);
+	return NULL;
+}
+
+int task_create(const char *name, int priority, int stack_size, main_t entry, char *const argv[])
+{
+	main_t *arg = malloc(sizeof(main_t));
+	pthread_t thread;
+
+	if (arg == NULL) {
+		errno = ENOMEM;
+		return ERROR;
+	}
+
+	*arg = entry;
+	if (pthread_create(&thread, NULL, task_start, arg) != 0) {
+		free(arg);
+		errno = EAGAIN;
+		return ERROR;
+	}
+
+	pthread_detach(thread);
+	return 1;
+}
+
+int kernel_thread(FAR const char *name, int priority, int stack_size, main_t entry, FAR char *const argv[])
+{
+	return task_create(name, priority, stack_size, entry, argv);
+}
+
+int sched_lock(void)
+{
+	pthread_mutex_lock(&g_schedlock);
+	return OK;
+}
+
+int sched_unlock(void)
+{
+	pthread_mutex_unlock(&g_schedlock);
+	return OK;
+}
+
+static uint32_t rnd(void)
+{
+	g_seed = g_seed * 1103515245 + 12345;
+	return g_seed >> 8;
+}
+
+static uint64_t now_ns(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fail(const char *what)
+{
+	fprintf(stderr, "%s failed: errno %d\n", what, errno);
+	exit(1);
+}
+
+static void sent(void *arg)
+{
+	__atomic_add_fetch(&g_nsent, 1, __ATOMIC_RELAXED);
+}
+
+static void tcpip_ready(void *arg)
+{
+	sem_post((sem_t *)arg);
+}
+
+static void set_addr(struct sockaddr_in *addr, u16_t port)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_port = lwip_htons(port);
+	addr->sin_addr.s_addr = lwip_htonl(0x7f000001);
+}
+
+static int open_socket(int type, u16_t port, int listener)
+{
+	struct sockaddr_in addr;
+	int s;
+
+	set_addr(&addr, port);
+	s = lwip_socket(AF_INET, type, 0);
+	if (s < 0) {
+		fail("socket");
+	}
+
+	if (listener) {
+		if (lwip_bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0 || (type == SOCK_STREAM && lwip_listen(s, 1) < 0)) {
+			fail("bind");
+		}
+	} else if (lwip_connect(s, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		fail("connect");
+	}
+
+	return s;
+}
+
+static void check_data(struct stream *st, const uint8_t *data, int len)
+{
+	int i;
+
+	if (st->check) {
+		for (i = 0; i < len; i++) {
+			st->errors += data[i] != g_data[(st->received + i) % PERIOD];
+		}
+	}
+
+	st->received += len;
+	if (st->received == st->total) {
+		st->end = now_ns(CLOCK_MONOTONIC);
+		st->end_cpu = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+	}
+}
+
+/* Receives until the end of the stream.  When checking it, the zero-copy
+ * receiver also calls lwip_recv() for part of the data, so that
+ * lwip_recv_pbuf() starts after what was copied.
+ */
+
+static void *receiver(void *arg)
+{
+	struct stream *st = arg;
+	uint8_t *buf = malloc(CHUNK);
+	struct pbuf *p;
+	struct pbuf *q;
+	int s;
+	int n;
+
+	s = lwip_accept(st->listener, NULL, NULL);
+	if (s < 0) {
+		fail("accept");
+	}
+
+	for (;;) {
+		if (st->check && (!st->zerocopy || (rnd() & 1))) {
+			n = lwip_recv(s, buf, 1 + rnd() % CHUNK, 0);
+			if (n > 0) {
+				check_data(st, buf, n);
+			}
+		} else if (st->zerocopy) {
+			n = lwip_recv_pbuf(s, &p, 0);
+			if (n > 0) {
+				for (q = p; q != NULL; q = q->next) {
+					check_data(st, q->payload, q->len);
+				}
+				pbuf_free(p);
+			}
+		} else {
+			n = lwip_recv(s, buf, CHUNK, 0);
+			if (n > 0) {
+				check_data(st, buf, n);
+			}
+		}
+
+		if (n == 0) {
+			break;
+		} else if (n < 0) {
+			fail("recv");
+		}
+	}
+
+	lwip_close(s);
+	free(buf);
+	return NULL;
+}
+
+/* Sends total bytes in chunks of CHUNK bytes, or of random sizes if check */
+
+static void send_stream(int s, size_t total, int zerocopy, int check)
+{
+	size_t offset = 0;
+	size_t len;
+	int n;
+
+	while (offset < total) {
+		len = check ? 1 + rnd() % CHUNK : CHUNK;
+		if (len > total - offset) {
+			len = total - offset;
+		}
+
+		if (zerocopy) {
+			n = lwip_send_ref(s, &g_data[offset % PERIOD], len, 0, sent, NULL);
+			g_ncalls++;
+		} else {
+			n = lwip_send(s, &g_data[offset % PERIOD], len, 0);
+		}
+
+		if (n <= 0) {
+			fail("send");
+		}
+
+		offset += n;
+	}
+}
+
+/* Returns the wall time until the last byte is received, and the CPU time in
+ * cpu.  The close of the sender isn't counted: with lwip_send_ref() it waits
+ * for the acknowledgement of the last segment, which the receiver may delay.
+ */
+
+static uint64_t run_tcp(int send_zerocopy, int recv_zerocopy, size_t total, int check, uint64_t *cpu)
+{
+	struct stream st;
+	pthread_t thread;
+	uint64_t t0;
+	uint64_t c0;
+	int s;
+
+	memset(&st, 0, sizeof(st));
+	st.listener = open_socket(SOCK_STREAM, ++g_port, 1);
+	st.zerocopy = recv_zerocopy;
+	st.check = check;
+	st.total = total;
+	g_nsent = 0;
+	g_ncalls = 0;
+
+	t0 = now_ns(CLOCK_MONOTONIC);
+	c0 = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+
+	pthread_create(&thread, NULL, receiver, &st);
+	s = open_socket(SOCK_STREAM, g_port, 0);
+	send_stream(s, total, send_zerocopy, check);
+
+	/* waits until the data sent without copy is acknowledged */
+	lwip_close(s);
+	pthread_join(thread, NULL);
+
+	lwip_close(st.listener);
+
+	if (st.received != total || st.errors || g_nsent != g_ncalls) {
+		fprintf(stderr, "tcp: received %zu of %zu bytes, %lu errors, %lu of %lu sent calls\n", st.received, total, st.errors, g_nsent, g_ncalls);
+		exit(1);
+	}
+
+	*cpu = st.end_cpu - c0;
+	return st.end - t0;
+}
+
+static void verify_udp(void)
+{
+	struct stream st;
+	struct pbuf *p;
+	struct pbuf *q;
+	size_t len;
+	int rx;
+	int tx;
+	int n;
+	int i;
+
+	memset(&st, 0, sizeof(st));
+	st.check = 1;
+	g_nsent = 0;
+
+	rx = open_socket(SOCK_DGRAM, ++g_port, 1);
+	tx = open_socket(SOCK_DGRAM, g_port, 0);
+
+	for (i = 0; i < NDATAGRAMS; i++) {
+		len = 1 + rnd() % 1400;
+		if (lwip_send_ref(tx, &g_data[st.received % PERIOD], len, 0, sent, NULL) != len) {
+			fail("udp send");
+		}
+
+		/* the datagram is copied by the loopback interface */
+		if (g_nsent != i + 1) {
+			fprintf(stderr, "udp: %lu sent calls after %d datagrams\n", g_nsent, i + 1);
+			exit(1);
+		}
+
+		n = lwip_recv_pbuf(rx, &p, 0);
+		if (n != len) {
+			fprintf(stderr, "udp: received %d of %zu bytes\n", n, len);
+			exit(1);
+		}
+
+		for (q = p; q != NULL; q = q->next) {
+			check_data(&st, q->payload, q->len);
+		}
+		pbuf_free(p);
+	}
+
+	lwip_close(tx);
+	lwip_close(rx);
+
+	if (st.errors) {
+		fprintf(stderr, "udp: %lu errors\n", st.errors);
+		exit(1);
+	}
+}
+
+/* The sent function of verify_shutdown() overwrites the data, which the
+ * stack must not read anymore
+ */
+
+static void poison(void *arg)
+{
+	memset(arg, 0xee, SHUTREF);
+	__atomic_add_fetch(&g_nsent, 1, __ATOMIC_RELAXED);
+}
+
+static void *late_receiver(void *arg)
+{
+	usleep(SHUTDELAY);
+	return receiver(arg);
+}
+
+/* Shuts a connection down while data of lwip_send_ref() is queued, behind
+ * a window the receiver closed by not reading, then closes it: the data
+ * must still reach the receiver intact.
+ */
+
+static void verify_shutdown(void)
+{
+	uint8_t *buf = malloc(SHUTREF);
+	struct timespec timeout;
+	struct stream st;
+	pthread_t thread;
+	int s;
+	int n;
+	int i;
+
+	memset(&st, 0, sizeof(st));
+	st.listener = open_socket(SOCK_STREAM, ++g_port, 1);
+	st.check = 1;
+	g_nsent = 0;
+
+	s = open_socket(SOCK_STREAM, g_port, 0);
+	send_stream(s, TCP_WND, 0, 0);
+	usleep(SHUTDELAY / 4);
+
+	for (i = 0; i < SHUTREF; i++) {
+		buf[i] = g_data[(TCP_WND + i) % PERIOD];
+	}
+	n = lwip_send_ref(s, buf, SHUTREF, MSG_DONTWAIT, poison, buf);
+	if (n <= 0) {
+		fail("send_ref");
+	}
+	st.total = TCP_WND + n;
+
+	pthread_create(&thread, NULL, late_receiver, &st);
+	if (lwip_shutdown(s, SHUT_RDWR) < 0) {
+		fail("shutdown");
+	}
+	lwip_close(s);
+
+	/* the receiver waits forever for data the stack doesn't send anymore */
+	clock_gettime(CLOCK_REALTIME, &timeout);
+	timeout.tv_sec += 10;
+	if (pthread_timedjoin_np(thread, NULL, &timeout) != 0) {
+		fprintf(stderr, "shutdown: received %zu of %zu bytes, %lu errors, %lu sent calls\n", st.received, st.total, st.errors, g_nsent);
+		exit(1);
+	}
+	lwip_close(st.listener);
+	free(buf);
+
+	if (st.received != st.total || st.errors || g_nsent != 1) {
+		fprintf(stderr, "shutdown: received %zu of %zu bytes, %lu errors, %lu sent calls\n", st.received, st.total, st.errors, g_nsent);
+		exit(1);
+	}
+}
+
+/* Receives exactly len bytes */
+
+static void recv_all(int s, uint8_t *buf, int len)
+{
+	int n;
+
+	while (len > 0) {
+		n = lwip_recv(s, buf, len, 0);
+		if (n <= 0) {
+			fail("recv");
+		}
+		buf += n;
+		len -= n;
+	}
+}
+
+static void *echo(void *arg)
+{
+	uint8_t buf[MSGSIZE];
+	int one = 1;
+	int i;
+	int s;
+
+	s = lwip_accept(*(int *)arg, NULL, NULL);
+	if (s < 0) {
+		fail("accept");
+	}
+	lwip_setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	for (i = 0; i < NROUNDS; i++) {
+		recv_all(s, buf, MSGSIZE);
+		if (lwip_send(s, buf, MSGSIZE, 0) != MSGSIZE) {
+			fail("send");
+		}
+	}
+
+	lwip_close(s);
+	return NULL;
+}
+
+/* Returns the mean round trip time of NROUNDS messages */
+
+static uint64_t run_latency(void)
+{
+	uint8_t buf[MSGSIZE];
+	pthread_t thread;
+	uint64_t t0;
+	int listener;
+	int one = 1;
+	int i;
+	int s;
+
+	listener = open_socket(SOCK_STREAM, ++g_port, 1);
+	pthread_create(&thread, NULL, echo, &listener);
+	s = open_socket(SOCK_STREAM, g_port, 0);
+	lwip_setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	t0 = now_ns(CLOCK_MONOTONIC);
+	for (i = 0; i < NROUNDS; i++) {
+		if (lwip_send(s, &g_data[i % PERIOD], MSGSIZE, 0) != MSGSIZE) {
+			fail("send");
+		}
+		recv_all(s, buf, MSGSIZE);
+		if (memcmp(buf, &g_data[i % PERIOD], MSGSIZE) != 0) {
+			fprintf(stderr, "echo: message %d differs\n", i);
+			exit(1);
+		}
+	}
+	t0 = now_ns(CLOCK_MONOTONIC) - t0;
+
+	pthread_join(thread, NULL);
+	lwip_close(s);
+	lwip_close(listener);
+
+	return t0 / NROUNDS;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *const modes[] = { "copy", "zero-copy" };
+	size_t total = (argc > 1 ? atoi(argv[1]) : 64) * 1024 * 1024;
+	uint64_t best;
+	uint64_t best_cpu;
+	uint64_t dt;
+	uint64_t cpu;
+	sem_t ready;
+	int send_zerocopy;
+	int recv_zerocopy;
+	int i;
+
+	if (total == 0) {
+		fprintf(stderr, "usage: %s [MB]\n", argv[0]);
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(g_data); i++) {
+		g_data[i] = i < PERIOD ? rnd() : g_data[i - PERIOD];
+	}
+
+	/* tcpip_init() of TinyAra leaves lwip_init() to the network manager */
+	lwip_init();
+	sem_init(&ready, 0, 0);
+	tcpip_init(tcpip_ready, &ready);
+	sem_wait(&ready);
+
+	for (send_zerocopy = 0; send_zerocopy < 2; send_zerocopy++) {
+		for (recv_zerocopy = 0; recv_zerocopy < 2; recv_zerocopy++) {
+			run_tcp(send_zerocopy, recv_zerocopy, NVERIFY, 1, &cpu);
+		}
+	}
+	verify_udp();
+	verify_shutdown();
+
+	printf("LWIP_TCPIP_CORE_LOCKING %d, TCPIP_MBOX_BATCH %d\n", LWIP_TCPIP_CORE_LOCKING, TCPIP_MBOX_BATCH);
+	printf("TCP over loopback, %zu MB in %d byte writes: verified\n", total >> 20, CHUNK);
+	printf("  send       recv            MB/s   CPU us/MB\n");
+
+	for (send_zerocopy = 0; send_zerocopy < 2; send_zerocopy++) {
+		for (recv_zerocopy = 0; recv_zerocopy < 2; recv_zerocopy++) {
+			best = UINT64_MAX;
+			best_cpu = UINT64_MAX;
+			for (i = 0; i < NRUNS; i++) {
+				dt = run_tcp(send_zerocopy, recv_zerocopy, total, 0, &cpu);
+				if (dt < best) {
+					best = dt;
+				}
+				if (cpu < best_cpu) {
+					best_cpu = cpu;
+				}
+			}
+
+			printf("  %-10s %-10s %9.1f %11.1f\n", modes[send_zerocopy], modes[recv_zerocopy], (double)total * 1000 / best, best_cpu / 1000.0 / (total >> 20));
+		}
+	}
+
+	best = UINT64_MAX;
+	for (i = 0; i < NRUNS; i++) {
+		dt = run_latency();
+		if (dt < best) {
+			best = dt;
+		}
+	}
+	printf("TCP round trip of %d bytes: %.1f us\n", MSGSIZE, best / 1000.0);
+
+	return 0;
+}
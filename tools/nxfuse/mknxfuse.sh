@@ -41,6 +41,7 @@ mkdir -p $SMARTFS_TMPDIR
 
 ln -sf $SMARTFSDIR/smartfs.h $SMARTFS_TMPDIR/smartfs.h
 ln -sf $SMARTFSDIR/smartfs_utils.c $SMARTFS_TMPDIR/smartfs_utils.c
+ln -sf $SMARTFSDIR/smartfs_dirindex.c $SMARTFS_TMPDIR/smartfs_dirindex.c
 ln -sf $SMARTFSDIR/smartfs_smart.c $SMARTFS_TMPDIR/smartfs_smart.c
 ln -sf $SMARTFSDIR/../driver/mtd/smart.c $SMARTFS_TMPDIR/smart.c
 
@@ -0,0 +1,65 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host build of the preference log: the file calls of the kernel and the
+ * calls by path go to pref_log_fs.c, which keeps the files in a host
+ * directory and cuts the writes off as a power loss would.
+ */
+
+#ifndef __TOOLS_PREFERENCE_BENCH_FS_H
+#define __TOOLS_PREFERENCE_BENCH_FS_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+struct file {
+	int f_fd;
+};
+
+int file_open(FAR struct file *filep, FAR const char *path, int oflags, ...);
+int file_close(FAR struct file *filep);
+ssize_t file_write(FAR struct file *filep, FAR const void *buf, size_t nbytes);
+ssize_t file_pread(FAR struct file *filep, FAR void *buf, size_t nbytes, off_t offset);
+ssize_t file_pwrite(FAR struct file *filep, FAR const void *buf, size_t nbytes, off_t offset);
+off_t file_seek(FAR struct file *filep, off_t offset, int whence);
+int file_fsync(FAR struct file *filep);
+
+int bench_unlink(FAR const char *path);
+int bench_rename(FAR const char *oldpath, FAR const char *newpath);
+int bench_stat(FAR const char *path, FAR struct stat *buf);
+
+#define unlink(p)     bench_unlink(p)
+#define rename(o, n)  bench_rename(o, n)
+#define stat(p, b)    bench_stat(p, b)
+
+/* Control of the host files by the test: the power is cut once budget bytes
+ * were written, a rename or an unlink taking one.  A negative budget never
+ * cuts it.  An image holds the log files as they are on the flash.
+ */
+
+struct bench_fs_image;
+
+void bench_fs_init(FAR const char *root);
+void bench_fs_power(long budget);
+unsigned long bench_fs_used(void);
+unsigned long bench_fs_renames(void);
+FAR struct bench_fs_image *bench_fs_save(void);
+void bench_fs_load(FAR const struct bench_fs_image *image);
+void bench_fs_free(FAR struct bench_fs_image *image);
+
+#endif
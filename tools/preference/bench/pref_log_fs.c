@@ -0,0 +1,294 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * The file calls of the preference log on a host directory, which stands
+ * for PREF_PATH.  Writes stop at the budget given to bench_fs_power(), the
+ * end of the last one is lost and every call fails until the next budget,
+ * as after a power loss.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <debug.h>
+
+#include <tinyara/preference.h>
+#include <tinyara/fs/fs.h>
+
+#undef unlink
+#undef rename
+#undef stat
+
+#define NFILES 2
+
+struct bench_fs_image {
+	bool exists[NFILES];
+	size_t size[NFILES];
+	char *data[NFILES];
+};
+
+/* The files of the log, relative to PREF_PATH */
+
+static const char *g_files[NFILES] = { "/pref.log", "/pref.log.tmp" };
+
+static char g_root[256];
+static long g_budget = -1;
+static bool g_down;
+static unsigned long g_used;
+static unsigned long g_renames;
+
+static const char *host_path(const char *path, char *buf, size_t len)
+{
+	if (strncmp(path, PREF_PATH, strlen(PREF_PATH)) != 0) {
+		fprintf(stderr, "unexpected path %s\n", path);
+		abort();
+	}
+	snprintf(buf, len, "%s%s", g_root, path + strlen(PREF_PATH));
+
+	return buf;
+}
+
+/* Take len bytes of the budget, return how many may be written */
+
+static size_t consume(size_t len)
+{
+	if (g_down) {
+		return 0;
+	}
+	if (g_budget >= 0 && (long)len > g_budget) {
+		len = g_budget;
+		g_down = true;
+	}
+	if (g_budget >= 0) {
+		g_budget -= len;
+	}
+	g_used += len;
+
+	return len;
+}
+
+void bench_fs_init(const char *root)
+{
+	snprintf(g_root, sizeof(g_root), "%s", root);
+}
+
+void bench_fs_power(long budget)
+{
+	g_budget = budget;
+	g_down = false;
+}
+
+unsigned long bench_fs_used(void)
+{
+	return g_used;
+}
+
+unsigned long bench_fs_renames(void)
+{
+	return g_renames;
+}
+
+struct bench_fs_image *bench_fs_save(void)
+{
+	struct bench_fs_image *image;
+	char buf[300];
+	FILE *f;
+	int i;
+
+	image = calloc(1, sizeof(struct bench_fs_image));
+	for (i = 0; i < NFILES; i++) {
+		snprintf(buf, sizeof(buf), "%s%s", g_root, g_files[i]);
+		f = fopen(buf, "rb");
+		if (f == NULL) {
+			continue;
+		}
+		fseek(f, 0, SEEK_END);
+		image->exists[i] = true;
+		image->size[i] = ftell(f);
+		image->data[i] = malloc(image->size[i] + 1);
+		fseek(f, 0, SEEK_SET);
+		if (fread(image->data[i], 1, image->size[i], f) != image->size[i]) {
+			abort();
+		}
+		fclose(f);
+	}
+
+	return image;
+}
+
+void bench_fs_load(const struct bench_fs_image *image)
+{
+	char buf[300];
+	FILE *f;
+	int i;
+
+	for (i = 0; i < NFILES; i++) {
+		snprintf(buf, sizeof(buf), "%s%s", g_root, g_files[i]);
+		unlink(buf);
+		if (!image->exists[i]) {
+			continue;
+		}
+		f = fopen(buf, "wb");
+		if (f == NULL || fwrite(image->data[i], 1, image->size[i], f) != image->size[i]) {
+			abort();
+		}
+		fclose(f);
+	}
+}
+
+void bench_fs_free(struct bench_fs_image *image)
+{
+	int i;
+
+	if (image == NULL) {
+		return;
+	}
+	for (i = 0; i < NFILES; i++) {
+		free(image->data[i]);
+	}
+	free(image);
+}
+
+int file_open(struct file *filep, const char *path, int oflags, ...)
+{
+	char buf[300];
+	mode_t mode = 0;
+	va_list ap;
+
+	if (g_down) {
+		return -EIO;
+	}
+
+	if (oflags & O_CREAT) {
+		va_start(ap, oflags);
+		mode = va_arg(ap, int);
+		va_end(ap);
+	}
+
+	filep->f_fd = open(host_path(path, buf, sizeof(buf)), oflags, mode);
+	if (filep->f_fd < 0) {
+		return -errno;
+	}
+
+	return OK;
+}
+
+int file_close(struct file *filep)
+{
+	if (filep->f_fd >= 0) {
+		close(filep->f_fd);
+		filep->f_fd = -1;
+	}
+
+	return OK;
+}
+
+ssize_t file_write(struct file *filep, const void *buf, size_t nbytes)
+{
+	size_t len = consume(nbytes);
+	ssize_t nwritten;
+
+	nwritten = len > 0 ? write(filep->f_fd, buf, len) : 0;
+	if (len < nbytes) {
+		return -EIO;
+	}
+
+	return nwritten;
+}
+
+ssize_t file_pread(struct file *filep, void *buf, size_t nbytes, off_t offset)
+{
+	if (g_down) {
+		return -EIO;
+	}
+
+	return pread(filep->f_fd, buf, nbytes, offset);
+}
+
+ssize_t file_pwrite(struct file *filep, const void *buf, size_t nbytes, off_t offset)
+{
+	size_t len = consume(nbytes);
+	ssize_t nwritten;
+
+	nwritten = len > 0 ? pwrite(filep->f_fd, buf, len, offset) : 0;
+	if (len < nbytes) {
+		return -EIO;
+	}
+
+	return nwritten;
+}
+
+off_t file_seek(struct file *filep, off_t offset, int whence)
+{
+	if (g_down) {
+		return -EIO;
+	}
+
+	return lseek(filep->f_fd, offset, whence);
+}
+
+int file_fsync(struct file *filep)
+{
+	return g_down ? -EIO : OK;
+}
+
+int bench_unlink(const char *path)
+{
+	char buf[300];
+
+	if (consume(1) == 0) {
+		errno = EIO;
+		return ERROR;
+	}
+
+	return unlink(host_path(path, buf, sizeof(buf)));
+}
+
+int bench_rename(const char *oldpath, const char *newpath)
+{
+	char oldbuf[300];
+	char newbuf[300];
+
+	if (consume(1) == 0) {
+		errno = EIO;
+		return ERROR;
+	}
+	g_renames++;
+
+	return rename(host_path(oldpath, oldbuf, sizeof(oldbuf)), host_path(newpath, newbuf, sizeof(newbuf)));
+}
+
+int bench_stat(const char *path, struct stat *buf)
+{
+	char pathbuf[300];
+
+	if (g_down) {
+		errno = EIO;
+		return ERROR;
+	}
+
+	return stat(host_path(path, pathbuf, sizeof(pathbuf)), buf);
+}
@@ -0,0 +1,344 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/*
+ * Host test of the log-structured key storage of os/kernel/preference.
+ * Random writes and removes of keys in three directories are checked
+ * against a model of the keys, with reboots which recover the index from
+ * the log.  Then the power is cut at every point of the writes of single
+ * operations, compactions included, and again in some of the recoveries:
+ * the keys must be those before or after the operation.
+ */
+
+#include "../../../os/kernel/preference/preference_log.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define NKEYS        48
+#define NDIRS        4
+#define VALUE_MAX    400			/* Larger than the write buffer */
+#define NRANDOM      20000
+#define NTORN        200
+#define MAX_CUTS     200
+
+enum op_kind_e {
+	OP_WRITE,
+	OP_REMOVE,
+	OP_REMOVE_ALL,
+};
+
+struct model_key_s {
+	bool exists;
+	int type;
+	int len;
+	uint8_t value[VALUE_MAX];
+};
+
+struct op_s {
+	enum op_kind_e kind;
+	int key;
+	int dir;
+	int type;
+	int len;
+	uint8_t value[VALUE_MAX];
+};
+
+/* The last directory never has keys */
+
+static const char *g_dirs[NDIRS] = {
+	PREF_PRIVATE_PATH,
+	PREF_SHARED_PATH"/a",
+	PREF_SHARED_PATH"/b",
+	PREF_SHARED_PATH"/c",
+};
+
+static struct model_key_s g_model[NKEYS];
+
+static void key_path(int key, char *buf, size_t len)
+{
+	snprintf(buf, len, "%s/key%d", g_dirs[key % (NDIRS - 1)], key);
+}
+
+static void gen_op(struct op_s *op)
+{
+	int r = rand() % 100;
+	int i;
+
+	op->key = rand() % NKEYS;
+	op->dir = rand() % NDIRS;
+	if (r < 70) {
+		op->kind = OP_WRITE;
+		op->type = rand() % 4;
+		op->len = rand() % 8 == 0 ? rand() % VALUE_MAX : rand() % 32;
+		for (i = 0; i < op->len; i++) {
+			op->value[i] = rand();
+		}
+	} else if (r < 98) {
+		op->kind = OP_REMOVE;
+	} else {
+		op->kind = OP_REMOVE_ALL;
+	}
+}
+
+static void apply_op(struct model_key_s *model, const struct op_s *op)
+{
+	int key;
+
+	switch (op->kind) {
+	case OP_WRITE:
+		model[op->key].exists = true;
+		model[op->key].type = op->type;
+		model[op->key].len = op->len;
+		memcpy(model[op->key].value, op->value, op->len);
+		break;
+	case OP_REMOVE:
+		model[op->key].exists = false;
+		break;
+	case OP_REMOVE_ALL:
+		for (key = 0; key < NKEYS; key++) {
+			if (key % (NDIRS - 1) == op->dir) {
+				model[key].exists = false;
+			}
+		}
+		break;
+	}
+}
+
+static int run_op(const struct op_s *op)
+{
+	preference_data_t data;
+	char path[64];
+
+	switch (op->kind) {
+	case OP_WRITE:
+		key_path(op->key, path, sizeof(path));
+		data.attr.type = op->type;
+		data.attr.len = op->len;
+		data.value = (void *)op->value;
+		return preference_log_write(path, &data);
+	case OP_REMOVE:
+		key_path(op->key, path, sizeof(path));
+		return preference_log_remove(path);
+	case OP_REMOVE_ALL:
+		return preference_log_remove_all(g_dirs[op->dir]);
+	}
+
+	return ERROR;
+}
+
+/* What the operation returns when nothing fails */
+
+static int expected_ret(const struct model_key_s *model, const struct op_s *op)
+{
+	if (op->kind == OP_REMOVE && !model[op->key].exists) {
+		return PREFERENCE_KEY_NOT_EXIST;
+	}
+
+	return OK;
+}
+
+static bool matches(const struct model_key_s *model)
+{
+	preference_data_t data;
+	bool existing;
+	char path[64];
+	int key;
+	int ret;
+
+	for (key = 0; key < NKEYS; key++) {
+		key_path(key, path, sizeof(path));
+		if (preference_log_check(path, &existing) != OK || existing != model[key].exists) {
+			return false;
+		}
+
+		data.attr.type = model[key].exists ? model[key].type : 0;
+		data.value = NULL;
+		ret = preference_log_read(path, &data);
+		if (!model[key].exists) {
+			if (ret != PREFERENCE_KEY_NOT_EXIST) {
+				return false;
+			}
+			continue;
+		}
+		if (ret != OK) {
+			return false;
+		}
+		ret = data.attr.len == model[key].len && !memcmp(data.value, model[key].value, data.attr.len);
+		free(data.value);
+		if (!ret) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Drop the state in RAM and power the files again */
+
+static void reboot(long budget)
+{
+	if (g_pref_log.initialized) {
+		pref_log_reset();
+	}
+	bench_fs_power(budget);
+}
+
+static void fail(const char *what, int n)
+{
+	printf("FAILED: %s %d\n", what, n);
+	exit(1);
+}
+
+static void test_random(void)
+{
+	struct op_s op;
+	int reboots = 0;
+	int ret;
+	int i;
+
+	for (i = 0; i < NRANDOM; i++) {
+		gen_op(&op);
+		ret = run_op(&op);
+		if (ret != expected_ret(g_model, &op)) {
+			fail("unexpected result of operation", i);
+		}
+		apply_op(g_model, &op);
+
+		if (i % 250 == 249) {
+			reboot(-1);
+			reboots++;
+		}
+		if (i % 50 == 49 && !matches(g_model)) {
+			fail("keys differ after operation", i);
+		}
+	}
+
+	printf("random: %d operations, %d reboots, %lu compactions\n", NRANDOM, reboots, bench_fs_renames());
+}
+
+static void test_torn(void)
+{
+	struct model_key_s before[NKEYS];
+	struct bench_fs_image *image_before = NULL;
+	struct bench_fs_image *image_after;
+	struct op_s op;
+	unsigned long renames;
+	unsigned long cost;
+	unsigned long cut;
+	unsigned long step;
+	unsigned long phase;
+	unsigned long cuts = 0;
+	bool compacted;
+	int compacting = 0;
+	int trial;
+	int nops;
+	int i;
+
+	for (trial = 0; trial < NTORN; trial++) {
+		/* The operation cut is the last of a few, or every other time the
+		 * first which compacts the log.
+		 */
+
+		nops = rand() % 30 + 1;
+		for (i = 0;; i++) {
+			bench_fs_free(image_before);
+			image_before = bench_fs_save();
+			memcpy(before, g_model, sizeof(before));
+
+			gen_op(&op);
+			cost = bench_fs_used();
+			renames = bench_fs_renames();
+			if (run_op(&op) != expected_ret(g_model, &op)) {
+				fail("unexpected result of operation", trial);
+			}
+			cost = bench_fs_used() - cost;
+			compacted = bench_fs_renames() != renames;
+			apply_op(g_model, &op);
+
+			if (trial % 2 ? compacted : i + 1 == nops) {
+				break;
+			}
+		}
+		compacting += compacted;
+		image_after = bench_fs_save();
+
+		/* Every point of short operations, and the unlink and rename at the
+		 * end of a compaction
+		 */
+
+		step = cost / MAX_CUTS + 1;
+		phase = rand() % step;
+		for (cut = 0; cut < cost; cut++) {
+			if (cut % step != phase && cut + 4 < cost) {
+				continue;
+			}
+
+			bench_fs_load(image_before);
+			reboot(cut);
+			run_op(&op);
+
+			/* The recovery can be cut too, when it rewrites a torn log */
+			if (rand() % 4 == 0) {
+				bool existing;
+
+				reboot(rand() % 2048);
+				preference_log_check(PREF_PRIVATE_PATH"/key0", &existing);
+			}
+
+			reboot(-1);
+			if (!matches(before) && !matches(g_model)) {
+				fail("keys torn in operation", trial);
+			}
+			cuts++;
+		}
+
+		bench_fs_load(image_after);
+		reboot(-1);
+		bench_fs_free(image_after);
+	}
+	bench_fs_free(image_before);
+
+	printf("torn: %d operations cut at %lu points, %d of them compacting\n", NTORN, cuts, compacting);
+}
+
+int main(int argc, char *argv[])
+{
+	char root[] = "/tmp/pref_log_test.XXXXXX";
+	struct bench_fs_image *empty;
+
+	if (mkdtemp(root) == NULL) {
+		perror("mkdtemp");
+		return 1;
+	}
+	bench_fs_init(root);
+	sem_init(&g_pref_log.sem, 0, 1);
+	srand(argc > 1 ? atoi(argv[1]) : 1);
+	empty = bench_fs_save();
+
+	test_random();
+	test_torn();
+
+	reboot(-1);
+	bench_fs_load(empty);
+	bench_fs_free(empty);
+	rmdir(root);
+	printf("verified\n");
+
+	return 0;
+}
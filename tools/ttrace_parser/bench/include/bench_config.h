@@ -0,0 +1,32 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/* Host build of T-trace: the binary records are selected by the Makefile */
+
+#ifndef __TOOLS_TTRACE_BENCH_BENCH_CONFIG_H
+#define __TOOLS_TTRACE_BENCH_BENCH_CONFIG_H
+
+#define CONFIG_DEBUG 1
+#define CONFIG_TTRACE 1
+#define CONFIG_TTRACE_BUFSIZE 13200
+#define CONFIG_TTRACE_DEVPATH "/dev/ttrace"
+#define CONFIG_TASK_NAME_SIZE 31
+#define CONFIG_CLOCK_MONOTONIC 1
+
+#endif
@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+
+/* Host build of T-trace: the fields of a TCB which are traced */
+
+#ifndef __TOOLS_TTRACE_BENCH_SCHED_H
+#define __TOOLS_TTRACE_BENCH_SCHED_H
+
+#include <tinyara/config.h>
+#include <sys/types.h>
+#include <sched.h>
+
+struct tcb_s {
+	pid_t pid;
+	uint8_t sched_priority;
+	uint8_t task_state;
+	char name[CONFIG_TASK_NAME_SIZE + 1];
+};
+
+typedef void (*sched_foreach_t)(FAR struct tcb_s *tcb, FAR void *arg);
+
+void sched_foreach(sched_foreach_t handler, FAR void *arg);
+
+#endif
@@ -0,0 +1,608 @@
+/****************************************************************************
+ *
+ * Copyright 2020 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+
+/* Host benchmark of T-trace: cost of the trace points and number of events
+ * held by the trace buffer, with trace packets written to the T-trace
+ * device and with binary records. The binary records are first checked,
+ * also with concurrent writers, and dumped for ttrace_chrome.py.
+ */
+
+#include <tinyara/config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/types.h>
+#include <tinyara/sched.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/ttrace.h>
+
+/* The Makefile renames them in the T-trace sources */
+
+#undef clock_gettime
+#undef getpid
+
+int clock_gettime(clockid_t id, struct timespec *ts);
+
+#define NEVENTS 2000000
+#define NTHREADS 4
+#define NTHREADRECS 200
+#define NROUNDS 2000
+#define BENCH_FD 3
+
+int ttrace_init(void);
+
+/* Tasks of the bench: each thread runs one of them */
+
+static struct tcb_s g_tcbs[] = {
+	{0, 0, 3, "Idle Task"},
+	{1, 200, 3, "hpwork"},
+	{2, 100, 3, "tash"},
+	{3, 125, 3, "wifi"},
+	{4, 180, 3, "lwip_tcpip"},
+};
+
+#define NTCBS (sizeof(g_tcbs) / sizeof(g_tcbs[0]))
+
+static __thread pid_t g_pid;
+static volatile int g_sched_lockcount;
+
+pid_t bench_getpid(void)
+{
+	return g_pid;
+}
+
+void sched_foreach(sched_foreach_t handler, FAR void *arg)
+{
+	int i;
+
+	for (i = 0; i < NTCBS; i++) {
+		handler(&g_tcbs[i], arg);
+	}
+}
+
+int sched_lock(void)
+{
+	g_sched_lockcount++;
+	return OK;
+}
+
+int sched_unlock(void)
+{
+	g_sched_lockcount--;
+	return OK;
+}
+
+/* The file system has the T-trace device only, a file descriptor is looked
+ * up and the operation of the driver called as write() and ioctl() do.
+ */
+
+static struct inode g_inode;
+static struct file g_file = {0, 0, &g_inode};
+
+int register_driver(FAR const char *path, FAR const struct file_operations *fops, mode_t mode, FAR void *priv)
+{
+	g_inode.i_ops = fops;
+	g_inode.i_private = priv;
+	return OK;
+}
+
+static struct file *bench_getfile(int fd)
+{
+	return fd == BENCH_FD && g_inode.i_ops != NULL ? &g_file : NULL;
+}
+
+int bench_open(const char *path, int oflags, ...)
+{
+	return strcmp(path, CONFIG_TTRACE_DEVPATH) == 0 ? BENCH_FD : -1;
+}
+
+ssize_t bench_write(int fd, const void *buf, size_t len)
+{
+	struct file *filep = bench_getfile(fd);
+
+	if (filep == NULL) {
+		return -1;
+	}
+
+	return filep->f_inode->i_ops->write(filep, buf, len);
+}
+
+int bench_ioctl(int fd, unsigned long cmd, ...)
+{
+	struct file *filep = bench_getfile(fd);
+	unsigned long arg;
+	va_list ap;
+
+	if (filep == NULL) {
+		return -1;
+	}
+
+	va_start(ap, cmd);
+	arg = va_arg(ap, unsigned long);
+	va_end(ap);
+	return filep->f_inode->i_ops->ioctl(filep, cmd, arg);
+}
+
+static int ctl(int cmd, unsigned long arg)
+{
+	return bench_ioctl(BENCH_FD, cmd, arg);
+}
+
+/* What the T-trace command sends to start and finish tracing */
+
+static void bench_start(int tags, int overwrite)
+{
+	ctl(TTRACE_SELECTED_TAG, tags);
+	ctl(TTRACE_OVERWRITE, overwrite);
+	ctl(TTRACE_SET_BUFSIZE, sizeof(struct trace_packet));
+	ctl(TTRACE_START, 0);
+}
+
+static void bench_finish(void)
+{
+	ctl(TTRACE_OVERWRITE, 0);
+	ctl(TTRACE_FINISH, 0);
+}
+
+/* The timestamps of the records of a dump count them */
+
+static int g_fake_clock;
+static uint32_t g_fake_usec;
+
+int bench_clock_gettime(clockid_t id, struct timespec *ts)
+{
+	uint32_t usec;
+
+	if (!g_fake_clock) {
+		return clock_gettime(id, ts);
+	}
+
+	usec = __atomic_fetch_add(&g_fake_usec, 1, __ATOMIC_RELAXED);
+	ts->tv_sec = usec / 1000000;
+	ts->tv_nsec = (usec % 1000000) * 1000;
+	return 0;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#ifndef CONFIG_TTRACE_BINARY
+/* Trace packets are read, as the T-trace command does, to empty the buffer */
+
+static char g_packets[CONFIG_TTRACE_BUFSIZE];
+#endif
+
+static void bench_drain(void)
+{
+#ifndef CONFIG_TTRACE_BINARY
+	g_inode.i_ops->read(&g_file, g_packets, sizeof(g_packets));
+#endif
+}
+
+#ifdef CONFIG_TTRACE_BINARY
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			exit(1); \
+		} \
+	} while (0)
+
+typedef void (*bench_handler_t)(struct ttrace_binrec_s *rec, void *arg);
+
+/* Walks the valid records of the ring as the T-trace command does */
+
+static int bench_walk(bench_handler_t handler, void *arg)
+{
+	struct ttrace_binring_s *ring = &g_ttrace_binring[0];
+	struct ttrace_binrec_s *rec;
+	uint32_t pos = 0;
+	int n = 0;
+
+	if (ring->pos > ring->nslots) {
+		pos = ring->pos - ring->nslots;
+	}
+
+	while (pos < ring->pos) {
+		rec = (struct ttrace_binrec_s *)&ring->slots[pos % ring->nslots];
+		if (rec->pos != pos || rec->type >= TTRACE_BIN_NTYPES || rec->nslots == 0 || rec->nslots > TTRACE_BIN_MAXSLOTS) {
+			pos++;
+			continue;
+		}
+
+		if (rec->type != TTRACE_BIN_PAD) {
+			if (handler) {
+				handler(rec, arg);
+			}
+			n++;
+		}
+		pos += rec->nslots;
+	}
+
+	return n;
+}
+
+/* Counters named after their value, of every length */
+
+static void counter_name(char *name, uint32_t value)
+{
+	int len = 1 + value % (TTRACE_MSG_BYTES + 8);
+	int i;
+
+	for (i = 0; i < len && i < TTRACE_MSG_BYTES - 1; i++) {
+		name[i] = 'a' + (value + i) % 26;
+	}
+	name[i] = '\0';
+}
+
+struct check_s {
+	int32_t next[NTCBS];
+	int32_t first;
+	int found;
+};
+
+static void check_counter(struct ttrace_binrec_s *rec, void *arg)
+{
+	struct check_s *check = arg;
+	char name[TTRACE_MSG_BYTES];
+
+	if (rec->type == TTRACE_BIN_TASKNAME) {
+		return;
+	}
+
+	CHECK(rec->type == TTRACE_BIN_COUNTER);
+	CHECK(rec->pid >= 0 && rec->pid < NTCBS);
+	counter_name(name, rec->arg);
+	CHECK(strcmp((char *)(rec + 1), name) == 0);
+	CHECK(rec->nslots == TTRACE_BIN_HDRSLOTS + TTRACE_BIN_NAMESLOTS(strlen(name)));
+
+	/* In order for each task */
+
+	CHECK((int32_t)rec->arg >= check->next[rec->pid]);
+	check->next[rec->pid] = rec->arg + 1;
+	if (check->found++ == 0) {
+		check->first = rec->arg;
+	}
+}
+
+static void verify(void)
+{
+	struct ttrace_binring_s *ring = &g_ttrace_binring[0];
+	struct check_s check;
+	char name[TTRACE_MSG_BYTES];
+	char image[sizeof(g_ttrace_binring)];
+	struct ttrace_binmsg_s msg;
+	size_t off;
+	ssize_t len;
+	int written;
+	int nnames;
+	int n;
+	int i;
+
+	/* The tasks are named at the start, nothing is written when finished
+	 * or for the tags which are not selected.
+	 */
+
+	g_pid = 1;
+	bench_start(TTRACE_TAG_APPS, 0);
+	nnames = bench_walk(NULL, NULL);
+	CHECK(nnames == NTCBS);
+	CHECK(trace_counter(TTRACE_TAG_IPC, "ipc", 1) == TTRACE_INVALID);
+	CHECK(trace_sched(&g_tcbs[1], &g_tcbs[2]) == TTRACE_INVALID);
+	CHECK(bench_walk(NULL, NULL) == NTCBS);
+
+	/* Without overwrite, the records which don't fit are dropped */
+
+	written = 0;
+	for (i = 0; i < 2 * TTRACE_BIN_RINGSLOTS; i++) {
+		counter_name(name, i);
+		if (trace_counter(TTRACE_TAG_APPS, name, i) == TTRACE_VALID) {
+			CHECK(written == i);
+			written++;
+		}
+	}
+	bench_finish();
+	CHECK(trace_counter(TTRACE_TAG_APPS, "finished", 0) == TTRACE_INVALID);
+	memset(&check, 0, sizeof(check));
+	n = bench_walk(check_counter, &check) - written - nnames;
+	CHECK(check.found == written);
+	CHECK(n >= 0 && n <= nnames);
+	CHECK(ring->dropped == 2 * TTRACE_BIN_RINGSLOTS - written + nnames - n);
+
+	/* With overwrite, the last records are kept whatever the pads at the
+	 * end of the ring, each lap leaves records of the previous one.
+	 */
+
+	for (written = 1; written < 4 * TTRACE_BIN_RINGSLOTS; written += 97) {
+		bench_start(TTRACE_TAG_APPS, 1);
+		for (i = 0; i < written; i++) {
+			counter_name(name, i);
+			CHECK(trace_counter(TTRACE_TAG_APPS, name, i) == TTRACE_VALID);
+		}
+		bench_finish();
+		memset(&check, 0, sizeof(check));
+		bench_walk(check_counter, &check);
+		CHECK(check.next[1] == written);
+		CHECK(check.first == written - check.found);
+		CHECK(ring->dropped == 0);
+		if ((written + 2 * NTCBS) * TTRACE_BIN_MAXSLOTS < TTRACE_BIN_RINGSLOTS) {
+			CHECK(check.found == written);
+		} else {
+			CHECK(check.found > TTRACE_BIN_RINGSLOTS / TTRACE_BIN_MAXSLOTS);
+		}
+	}
+
+	/* Records written to the device by applications are checked */
+
+	bench_start(TTRACE_TAG_APPS, 0);
+	memset(&msg, 0, sizeof(msg));
+	strcpy(msg.name, "write");
+	msg.rec.type = TTRACE_BIN_BEGIN;
+	msg.rec.nslots = TTRACE_BIN_HDRSLOTS + TTRACE_BIN_NAMESLOTS(5);
+	msg.rec.pid = 2;
+	msg.rec.arg = TTRACE_TAG_APPS;
+	CHECK(bench_write(BENCH_FD, &msg, msg.rec.nslots * TTRACE_BIN_SLOT) == msg.rec.nslots * TTRACE_BIN_SLOT);
+	CHECK(bench_write(BENCH_FD, &msg, TTRACE_BIN_SLOT) < 0);
+	CHECK(bench_write(BENCH_FD, &msg, sizeof(msg) + 8) < 0);
+	CHECK(bench_write(BENCH_FD, &msg, (msg.rec.nslots - 1) * TTRACE_BIN_SLOT) < 0);
+	CHECK(bench_walk(NULL, NULL) == nnames + 1);
+	bench_finish();
+
+	/* The rings are read as they are, from any offset */
+
+	CHECK(ctl(TTRACE_USED_BUFSIZE, 0) == sizeof(g_ttrace_binring));
+	g_file.f_pos = 0;
+	for (off = 0; off < sizeof(image); off += len) {
+		len = g_inode.i_ops->read(&g_file, image + off, 100);
+		CHECK(len > 0);
+	}
+	CHECK(g_inode.i_ops->read(&g_file, image, 100) == 0);
+	CHECK(memcmp(image, g_ttrace_binring, sizeof(image)) == 0);
+
+	printf("verified\n");
+}
+
+/* Concurrent writers, without overwrite: every record written is found */
+
+struct writer_s {
+	pthread_t thread;
+	pid_t pid;
+	int written;
+};
+
+static void *stress_thread(void *arg)
+{
+	struct writer_s *writer = arg;
+	char name[TTRACE_MSG_BYTES];
+	int i;
+
+	g_pid = writer->pid;
+	for (i = 0; i < NTHREADRECS; i++) {
+		counter_name(name, i);
+		if (trace_counter(TTRACE_TAG_APPS, name, i) == TTRACE_VALID) {
+			writer->written++;
+		}
+		if (i % 16 == 0) {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void stress(void)
+{
+	struct ttrace_binring_s *ring = &g_ttrace_binring[0];
+	struct writer_s writers[NTHREADS];
+	struct check_s check;
+	long total = 0;
+	long dropped = 0;
+	int round;
+	int i;
+
+	for (round = 0; round < NROUNDS; round++) {
+		bench_start(TTRACE_TAG_APPS, 0);
+		for (i = 0; i < NTHREADS; i++) {
+			writers[i].pid = 1 + i;
+			writers[i].written = 0;
+			pthread_create(&writers[i].thread, NULL, stress_thread, &writers[i]);
+		}
+		for (i = 0; i < NTHREADS; i++) {
+			pthread_join(writers[i].thread, NULL);
+		}
+
+		/* Records are checked before the tasks are named again */
+
+		memset(&check, 0, sizeof(check));
+		bench_walk(check_counter, &check);
+		for (i = 0; i < NTHREADS; i++) {
+			check.found -= writers[i].written;
+		}
+		CHECK(check.found == 0);
+		total += NTHREADS * NTHREADRECS;
+		dropped += ring->dropped;
+		bench_finish();
+	}
+
+	printf("%d writers: %ld records written, %ld found, %ld dropped\n", NTHREADS, total, total - dropped, dropped);
+}
+
+static int dump(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	char image[sizeof(g_ttrace_binring)];
+	ssize_t len;
+	size_t off;
+
+	if (f == NULL) {
+		return 1;
+	}
+
+	g_file.f_pos = 0;
+	for (off = 0; off < sizeof(image); off += len) {
+		len = g_inode.i_ops->read(&g_file, image + off, sizeof(image) - off);
+	}
+
+	fwrite(image, 1, sizeof(image), f);
+	fclose(f);
+	return 0;
+}
+
+/* A trace of each kind of record, with a fake clock */
+
+static int dump_events(const char *path)
+{
+	g_fake_clock = 1;
+	g_pid = 2;
+	bench_start(TTRACE_TAG_APPS | TTRACE_TAG_TASK | TTRACE_TAG_IPC | TTRACE_TAG_IRQ, 0);
+
+	trace_sched(&g_tcbs[1], &g_tcbs[2]);
+	trace_begin(TTRACE_TAG_APPS, "main");
+	trace_begin(TTRACE_TAG_IPC, "mq_send %d", 42);
+	trace_async_begin(TTRACE_TAG_APPS, "request", 7);
+	trace_end(TTRACE_TAG_IPC);
+	trace_irq_enter(30);
+	trace_counter(TTRACE_TAG_APPS, "free heap", -1024);
+	trace_irq_exit(30);
+	trace_sched(&g_tcbs[2], &g_tcbs[3]);
+	g_pid = 3;
+	trace_begin_uid(TTRACE_TAG_TASK, 5);
+	trace_async_end(TTRACE_TAG_APPS, "request", 7);
+	trace_end_uid(TTRACE_TAG_TASK);
+	trace_counter(TTRACE_TAG_APPS, "free heap", 2048);
+	trace_sched(&g_tcbs[3], &g_tcbs[2]);
+	g_pid = 2;
+	trace_end(TTRACE_TAG_APPS);
+	trace_begin(TTRACE_TAG_LOCK, "not selected");
+
+	bench_finish();
+	return dump(path);
+}
+
+/* Counters of a ring which wrapped around many times */
+
+static int dump_wrap(const char *path)
+{
+	char name[TTRACE_MSG_BYTES];
+	int i;
+
+	g_fake_clock = 1;
+	g_pid = 1;
+	bench_start(TTRACE_TAG_APPS, 1);
+	for (i = 0; i < 10000; i++) {
+		counter_name(name, i);
+		trace_counter(TTRACE_TAG_APPS, name, i);
+	}
+	bench_finish();
+	return dump(path);
+}
+
+static int bench_held(void)
+{
+	return bench_walk(NULL, NULL) - NTCBS;
+}
+#else
+static int bench_held(void)
+{
+	return ctl(TTRACE_USED_BUFSIZE, 0);
+}
+#endif
+
+/* Cost of the trace points of the kernel, while tracing the task tag */
+
+static void bench(const char *mode)
+{
+	uint64_t t0;
+	uint64_t t1;
+	uint64_t t2;
+	uint64_t t3;
+	int held;
+	int i;
+
+	g_pid = 2;
+	bench_start(TTRACE_TAG_TASK, 1);
+	t0 = now_ns();
+	for (i = 0; i < NEVENTS / 2; i++) {
+		trace_begin(TTRACE_TAG_TASK, "thread_create");
+		trace_end(TTRACE_TAG_TASK);
+	}
+	t1 = now_ns();
+	for (i = 0; i < NEVENTS; i++) {
+		trace_sched(&g_tcbs[1 + i % 3], &g_tcbs[1 + (i + 1) % 3]);
+	}
+	t2 = now_ns();
+	for (i = 0; i < NEVENTS; i++) {
+		trace_begin(TTRACE_TAG_IPC, "mq_dosend");
+	}
+	t3 = now_ns();
+	bench_finish();
+	bench_drain();
+
+	/* Events held by the buffer, without overwrite */
+
+	bench_start(TTRACE_TAG_TASK, 0);
+	for (i = 0; i < CONFIG_TTRACE_BUFSIZE; i++) {
+		trace_begin(TTRACE_TAG_TASK, "thread_create");
+		trace_end(TTRACE_TAG_TASK);
+	}
+	held = bench_held();
+	bench_finish();
+	bench_drain();
+#ifndef CONFIG_TTRACE_BINARY
+	/* The used size of the trace packets */
+
+	held = held / (2 * sizeof(struct trace_packet) - TTRACE_MSG_BYTES) * 2;
+#endif
+
+	printf("%s: %d begin/end events in %d bytes (%.1f bytes each), %.1f ns per begin/end, %.1f ns per sched, %.1f ns per untraced tag\n",
+		   mode, held, CONFIG_TTRACE_BUFSIZE, (double)CONFIG_TTRACE_BUFSIZE / held,
+		   (double)(t1 - t0) / NEVENTS, (double)(t2 - t1) / NEVENTS, (double)(t3 - t2) / NEVENTS);
+}
+
+int main(int argc, char **argv)
+{
+	ttrace_init();
+
+#ifdef CONFIG_TTRACE_BINARY
+	if (argc == 3 && strcmp(argv[1], "--dump") == 0) {
+		return dump_events(argv[2]);
+	}
+
+	if (argc == 3 && strcmp(argv[1], "--dump-wrap") == 0) {
+		return dump_wrap(argv[2]);
+	}
+
+	verify();
+	stress();
+	bench("binary records");
+#else
+	bench("trace packets");
+#endif
+	return 0;
+}
@@ -0,0 +1,233 @@
+#!/usr/bin/env python
+###########################################################################
+#
+# Copyright 2020 Samsung Electronics All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific
+# language governing permissions and limitations under the License.
+#
+###########################################################################
+# File : ttrace_chrome.py
+# Description:
+# Converts the rings of the binary records of T-trace (CONFIG_TTRACE_BINARY),
+# read from /dev/ttrace or dumped with GDB, into a Chrome trace (JSON) which
+# chrome://tracing and https://ui.perfetto.dev open.
+#
+# Usage: ttrace_chrome.py [-o OUTPUT] DUMP
+
+from __future__ import print_function
+import json
+import optparse
+import struct
+import sys
+
+# See os/include/tinyara/ttrace.h
+BIN_MAGIC = 0x42525454
+BIN_SLOT = 8
+BIN_MAXSLOTS = 6
+RING_HEADER = 24
+
+(BIN_PAD, BIN_BEGIN, BIN_BEGIN_UID, BIN_END, BIN_SCHED, BIN_COUNTER,
+ BIN_ASYNC_BEGIN, BIN_ASYNC_END, BIN_IRQ_ENTER, BIN_IRQ_EXIT,
+ BIN_TASKNAME, BIN_NTYPES) = range(12)
+
+TAGS = {1: 'apps', 2: 'libs', 4: 'lock', 8: 'task', 16: 'ipc', 32: 'irq'}
+
+# The tasks are the threads of a process, each CPU has a thread for the
+# running tasks and one for the interrupts in a second process.
+PID_CPUS = 0
+PID_TASKS = 1
+
+
+class Record:
+    def __init__(self, cpu, rtype, pid, ts, arg, payload):
+        self.cpu = cpu
+        self.type = rtype
+        self.pid = pid
+        self.ts = ts
+        self.arg = arg
+        self.payload = payload
+
+    def name(self):
+        end = self.payload.find(b'\0')
+        if end < 0:
+            end = len(self.payload)
+        return self.payload[:end].decode('utf-8', 'replace')
+
+
+class Ring:
+    def __init__(self, data, offset):
+        for endian in '<>':
+            magic, = struct.unpack_from(endian + 'I', data, offset)
+            if magic == BIN_MAGIC:
+                break
+        else:
+            raise ValueError('no T-trace ring at offset %d' % offset)
+        self.endian = endian
+        (_, self.cpu, self.overwrite, self.nslots, self.pos, self.dropped,
+         self.tags) = struct.unpack_from(endian + 'IHHIIII', data, offset)
+        self.slots = offset + RING_HEADER
+        self.size = RING_HEADER + self.nslots * BIN_SLOT
+        if offset + self.size > len(data):
+            raise ValueError('truncated T-trace ring at offset %d' % offset)
+        self.data = data
+
+    def records(self):
+        """Yields the valid records in order, the way the T-trace command
+        walks them: a record is valid when its header has the position of
+        its slot, the other slots are skipped one by one.
+        """
+        pos = max(self.pos - self.nslots, 0)
+        epoch = 0
+        last = None
+        while pos < self.pos:
+            off = self.slots + (pos % self.nslots) * BIN_SLOT
+            rpos, rtype, nslots = struct.unpack_from(self.endian + 'IBB', self.data, off)
+            if rpos != pos or rtype >= BIN_NTYPES or nslots == 0 or nslots > BIN_MAXSLOTS:
+                pos += 1
+                continue
+            if rtype != BIN_PAD:
+                pid, ts, arg = struct.unpack_from(self.endian + 'hII', self.data, off + 6)
+                # Timestamps are 32-bit microseconds
+                if last is not None and ts + (1 << 31) < last:
+                    epoch += 1 << 32
+                last = ts
+                payload = self.data[off + 16:off + nslots * BIN_SLOT]
+                yield Record(self.cpu, rtype, pid, epoch + ts, arg, payload)
+            pos += nslots
+
+
+def read_rings(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    rings = []
+    offset = 0
+    while offset + RING_HEADER <= len(data):
+        ring = Ring(data, offset)
+        rings.append(ring)
+        offset += ring.size
+    return rings
+
+
+class Converter:
+    def __init__(self):
+        self.events = []
+        self.names = {}
+        self.cpus = set()
+        self.running = {}
+
+    def event(self, ph, rec, pid, tid, **fields):
+        ev = {'ph': ph, 'ts': rec.ts, 'pid': pid, 'tid': tid}
+        ev.update(fields)
+        self.events.append(ev)
+
+    def task(self, pid):
+        return self.names.get(pid, 'pid %d' % pid)
+
+    def run(self, cpu, pid, prio, ts):
+        """Closes the slice of the task running on the CPU, if any."""
+        cur = self.running.get(cpu)
+        if cur is not None and ts > cur[2]:
+            self.events.append({'ph': 'X', 'pid': PID_CPUS, 'tid': cpu * 2,
+                                'ts': cur[2], 'dur': ts - cur[2],
+                                'name': cur[0], 'args': {'prio': cur[1]}})
+        if pid is not None:
+            self.running[cpu] = (pid, prio, ts)
+
+    def add(self, rec):
+        self.cpus.add(rec.cpu)
+        if rec.type == BIN_BEGIN:
+            self.event('B', rec, PID_TASKS, rec.pid, name=rec.name(),
+                       cat=TAGS.get(rec.arg, 'ttrace'))
+        elif rec.type == BIN_BEGIN_UID:
+            self.event('B', rec, PID_TASKS, rec.pid, name='uid %d' % rec.arg, cat='ttrace')
+        elif rec.type == BIN_END:
+            self.event('E', rec, PID_TASKS, rec.pid)
+        elif rec.type == BIN_SCHED:
+            # struct ttrace_binsched_s
+            next_prio = bytearray(rec.payload)[2]
+            self.run(rec.cpu, rec.arg & 0xffff, next_prio, rec.ts)
+        elif rec.type == BIN_COUNTER:
+            value = rec.arg - (1 << 32) if rec.arg & (1 << 31) else rec.arg
+            self.event('C', rec, PID_TASKS, rec.pid, name=rec.name(), args={rec.name(): value})
+        elif rec.type in (BIN_ASYNC_BEGIN, BIN_ASYNC_END):
+            ph = 'b' if rec.type == BIN_ASYNC_BEGIN else 'e'
+            self.event(ph, rec, PID_TASKS, rec.pid, name=rec.name(), cat='async',
+                       id='0x%x' % rec.arg)
+        elif rec.type == BIN_IRQ_ENTER:
+            self.event('B', rec, PID_CPUS, rec.cpu * 2 + 1, name='irq %d' % rec.arg, cat='irq')
+        elif rec.type == BIN_IRQ_EXIT:
+            self.event('E', rec, PID_CPUS, rec.cpu * 2 + 1)
+        elif rec.type == BIN_TASKNAME:
+            self.names[rec.pid] = rec.name()
+
+    def trace(self, end):
+        for cpu in sorted(self.running):
+            self.run(cpu, None, 0, end)
+        # The CPU slices are named after the tasks once all names are known
+        for ev in self.events:
+            if ev['ph'] == 'X':
+                ev['args']['pid'] = ev['name']
+                ev['name'] = self.task(ev['name'])
+        meta = [{'ph': 'M', 'pid': PID_CPUS, 'tid': 0, 'name': 'process_name', 'args': {'name': 'CPUs'}},
+                {'ph': 'M', 'pid': PID_TASKS, 'tid': 0, 'name': 'process_name', 'args': {'name': 'Tasks'}}]
+        for cpu in sorted(self.cpus):
+            meta.append({'ph': 'M', 'pid': PID_CPUS, 'tid': cpu * 2, 'name': 'thread_name',
+                         'args': {'name': 'CPU %d' % cpu}})
+            meta.append({'ph': 'M', 'pid': PID_CPUS, 'tid': cpu * 2 + 1, 'name': 'thread_name',
+                         'args': {'name': 'CPU %d irq' % cpu}})
+        for pid in sorted(self.names):
+            meta.append({'ph': 'M', 'pid': PID_TASKS, 'tid': pid, 'name': 'thread_name',
+                         'args': {'name': self.names[pid]}})
+        return meta + sorted(self.events, key=lambda ev: ev['ts'])
+
+
+def write_trace(out, events):
+    # One event per line
+    out.write('{"traceEvents": [\n')
+    out.write(',\n'.join(json.dumps(ev, sort_keys=True) for ev in events))
+    out.write('\n]}\n')
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [-o OUTPUT] DUMP')
+    parser.add_option('-o', dest='output', help='JSON file, standard output by default')
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.print_help()
+        return 1
+
+    rings = read_rings(args[0])
+    records = []
+    for ring in rings:
+        if ring.dropped:
+            print('CPU %d: %d records dropped, the ring was full' % (ring.cpu, ring.dropped),
+                  file=sys.stderr)
+        records.extend(ring.records())
+    # Stable: records of a CPU stay in order
+    records.sort(key=lambda rec: rec.ts)
+
+    conv = Converter()
+    for rec in records:
+        conv.add(rec)
+    events = conv.trace(records[-1].ts if records else 0)
+
+    if options.output:
+        with open(options.output, 'w') as out:
+            write_trace(out, events)
+    else:
+        write_trace(sys.stdout, events)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())